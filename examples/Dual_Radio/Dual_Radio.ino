@@ -0,0 +1,161 @@
+/*
+ * HelTec Automation(TM) two radios example
+ *
+ * Function summary:
+ *
+ * - The on board radio, driven through Radio, listens continuously on
+ *   RX_FREQUENCY;
+ *
+ * - A second SX1276 module wired to the HSPI bus sends a packet on
+ *   TX_FREQUENCY every 5 seconds. It is driven through its own SX1276_t
+ *   object with the SX1276xxx functions;
+ *
+ * - Both radios run at the same time, received packets are printed via
+ *   serial(115200). Deep sleep is not used, it would stop the second radio;
+ *
+ * - Only ESP32 + LoRa series boards can use this library, need a license
+ *   to make the code run(check you license here: http://www.heltec.cn/search/);
+ *
+ * HelTec AutoMation, Chengdu, China.
+ * 成都惠利特自动化科技有限公司
+ * https://heltec.org
+ * support@heltec.cn
+ *
+ *this project also release in GitHub:
+ *https://github.com/HelTecAutomation/ESP32_LoRaWAN
+*/
+
+#include <ESP32_LoRaWAN.h>
+#include "Arduino.h"
+#include "sx1276-board.h"
+
+#define RX_FREQUENCY                                868100000 // Hz
+#define TX_FREQUENCY                                868500000 // Hz
+
+#define TX_OUTPUT_POWER                             14        // dBm
+
+#define LORA_BANDWIDTH                              0         // [0: 125 kHz,
+                                                              //  1: 250 kHz,
+                                                              //  2: 500 kHz,
+                                                              //  3: Reserved]
+#define LORA_SPREADING_FACTOR                       7         // [SF7..SF12]
+#define LORA_CODINGRATE                             1         // [1: 4/5,
+                                                              //  2: 4/6,
+                                                              //  3: 4/7,
+                                                              //  4: 4/8]
+#define LORA_PREAMBLE_LENGTH                        8         // Same for Tx and Rx
+
+// Second radio wiring
+#define RADIO2_SCK                                  14
+#define RADIO2_MISO                                 12
+#define RADIO2_MOSI                                 13
+#define RADIO2_NSS                                  15
+#define RADIO2_RESET                                25
+#define RADIO2_DIO0                                 32
+#define RADIO2_DIO1                                 33
+
+#define TX_PERIOD                                   5000      // ms
+
+uint32_t  license[4] = {0xD5397DF0, 0x8573F814, 0x7A38C73D, 0x48E68607};
+
+static SPIClass spi2(HSPI);
+static SX1276_t radio2;
+
+static RadioEvents_t rxEvents;
+static RadioEvents_t txEvents;
+
+static uint32_t txNumber;
+static uint32_t lastTx;
+static bool txBusy;
+
+void Radio2Write( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+  spi2.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+  digitalWrite(RADIO2_NSS, LOW);
+  spi2.transfer(addr | 0x80);
+  for (uint8_t i = 0; i < size; i++)
+    spi2.transfer(buffer[i]);
+  digitalWrite(RADIO2_NSS, HIGH);
+  spi2.endTransaction();
+}
+
+void Radio2Read( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+  spi2.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+  digitalWrite(RADIO2_NSS, LOW);
+  spi2.transfer(addr & 0x7F);
+  for (uint8_t i = 0; i < size; i++)
+    buffer[i] = spi2.transfer(0);
+  digitalWrite(RADIO2_NSS, HIGH);
+  spi2.endTransaction();
+}
+
+static const SX1276Bus_t radio2Bus = { Radio2Write, Radio2Read };
+
+void OnRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
+{
+  Serial.printf("radio 1 received %u bytes, rssi %d snr %d\r\n", size, rssi, snr);
+}
+
+void OnTxDone( void )
+{
+  Serial.println("radio 2 TX done");
+  SX1276SetSleep( &radio2 );
+  txBusy = false;
+}
+
+void OnTxTimeout( void )
+{
+  Serial.println("radio 2 TX timeout");
+  SX1276SetSleep( &radio2 );
+  txBusy = false;
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+  SPI.begin(SCK,MISO,MOSI,SS);
+  Mcu.init(SS,RST_LoRa,DIO0,DIO1,license);
+
+  pinMode(RADIO2_NSS, OUTPUT);
+  digitalWrite(RADIO2_NSS, HIGH);
+  spi2.begin(RADIO2_SCK, RADIO2_MISO, RADIO2_MOSI, RADIO2_NSS);
+  if( !SX1276AddInstance( &radio2, &radio2Bus, RADIO2_RESET, RADIO2_DIO0, RADIO2_DIO1 ) )
+  {
+    Serial.println("second radio setup failed");
+    while (1);
+  }
+
+  rxEvents.RxDone = OnRxDone;
+  Radio.Init( &rxEvents );
+  Radio.SetChannel( RX_FREQUENCY );
+  Radio.SetRxConfig( MODEM_LORA, LORA_BANDWIDTH, LORA_SPREADING_FACTOR,
+                     LORA_CODINGRATE, 0, LORA_PREAMBLE_LENGTH,
+                     0, false, 0, true, 0, 0, false, true );
+  Radio.Rx( 0 );
+
+  txEvents.TxDone = OnTxDone;
+  txEvents.TxTimeout = OnTxTimeout;
+  SX1276Init( &radio2, &txEvents );
+  SX1276SetChannel( &radio2, TX_FREQUENCY );
+  SX1276SetTxConfig( &radio2, MODEM_LORA, TX_OUTPUT_POWER, 0, LORA_BANDWIDTH,
+                     LORA_SPREADING_FACTOR, LORA_CODINGRATE,
+                     LORA_PREAMBLE_LENGTH, false, true, 0, 0, false, 3000 );
+}
+
+void loop()
+{
+  char packet[32];
+
+  Radio.IrqProcess();
+  SX1276IrqProcess( &radio2 );
+
+  if( !txBusy && ( millis() - lastTx ) >= TX_PERIOD )
+  {
+    lastTx = millis();
+    txBusy = true;
+    snprintf(packet, sizeof(packet), "radio 2 #%u", ++txNumber);
+    SX1276Send( &radio2, (uint8_t *)packet, strlen(packet) );
+  }
+}
@@ -123,6 +123,8 @@ void setup()
   adcAttachPin(37);
   analogSetClockDiv(255); // 1338mS
     pinMode(Vext, OUTPUT);  
+  // No WiFi nor GPIO interrupt, the MCU can light sleep between the timer events
+  LpmSetLightSleepMode(LPM_APPLI_ID, LPM_ENABLE);
   deviceState = DEVICE_STATE_INIT;
 }
 
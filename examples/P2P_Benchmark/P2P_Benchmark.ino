@@ -0,0 +1,201 @@
+/*
+ * HelTec Automation(TM) LoRa point to point link benchmark
+ *
+ * Function summary:
+ *
+ * - Two boards, one built with ROLE_SENDER set to true, the other one with
+ *   ROLE_SENDER set to false;
+ *
+ * - The sender streams windows of frames at each rate of the P2P rate
+ *   table, SF12 to SF7 at 125 kHz then SF7 at 250 and 500 kHz;
+ *
+ * - Goodput (acknowledged application bytes per second) and packets per
+ *   second are printed for each rate via serial(115200);
+ *
+ * - Set AUTO_RATE to true to let the link pick its rate from the SNR
+ *   instead of sweeping the table;
+ *
+ * - Only ESP32 + LoRa series boards can use this library, need a license
+ *   to make the code run(check you license here: http://www.heltec.cn/search/);
+ *
+ * HelTec AutoMation, Chengdu, China.
+ * 成都惠利特自动化科技有限公司
+ * https://heltec.org
+ * support@heltec.cn
+ *
+ *this project also release in GitHub:
+ *https://github.com/HelTecAutomation/ESP32_LoRaWAN
+*/
+
+#include <ESP32_LoRaWAN.h>
+#include "Arduino.h"
+#include "p2p.h"
+
+#define ROLE_SENDER                                 true
+
+#define AUTO_RATE                                   false
+
+#define RF_FREQUENCY                                868000000 // Hz
+
+#define TX_OUTPUT_POWER                             14        // dBm
+
+#define LORA_CODINGRATE                             1         // [1: 4/5,
+                                                              //  2: 4/6,
+                                                              //  3: 4/7,
+                                                              //  4: 4/8]
+#define LORA_PREAMBLE_LENGTH                        8         // Same for Tx and Rx
+#define LORA_FIXED_PAYLOAD                          0         // 0: explicit header,
+                                                              // others: implicit header payload size
+
+#define PAYLOAD_SIZE                                64        // Bytes per frame
+#define WINDOW_SIZE                                 8         // Frames per ACK
+#define BENCH_WINDOWS                               4         // Measured windows per rate
+
+uint32_t  license[4] = {0xD5397DF0, 0x8573F814, 0x7A38C73D, 0x48E68607};
+
+static P2pParams_t p2pParams;
+static P2pEvents_t p2pEvents;
+
+static uint8_t payload[PAYLOAD_SIZE];
+static uint8_t benchRate;
+static uint8_t benchWindows;
+static bool benchWarmup;
+static bool windowPending;
+static uint32_t benchStart;
+static uint32_t benchBytes;
+static uint32_t benchFrames;
+static uint32_t benchRetransmissions;
+
+void OnWindowDone( bool success )
+{
+  windowPending = true;
+  if( !success )
+    Serial.println("window failed");
+}
+
+void OnRxData( uint8_t seq, uint8_t *buffer, uint8_t size, int16_t rssi, int8_t snr )
+{
+  if( seq % WINDOW_SIZE == 0 )
+    Serial.printf("rx seq %u size %u rssi %d snr %d rate %u\r\n", seq, size, rssi, snr, P2pGetCurrentRate());
+}
+
+void OnRateChanged( uint8_t rate )
+{
+  const P2pRate_t *entry = P2pGetRate( rate );
+
+  Serial.printf("rate %u: SF%u BW%u\r\n", rate, entry->SpreadingFactor, 125 << entry->Bandwidth);
+}
+
+void StartMeasure( void )
+{
+  P2pStatistics_t *stats = P2pGetStatistics();
+
+  benchWarmup = false;
+  benchWindows = 0;
+  benchStart = millis();
+  benchBytes = stats->BytesAcked;
+  benchFrames = stats->FramesSent - stats->Retransmissions;
+  benchRetransmissions = stats->Retransmissions;
+}
+
+void StartRate( uint8_t rate )
+{
+  // The next window moves both ends to the requested rate, it is not measured
+  benchRate = rate;
+  benchWarmup = true;
+  P2pSetRate( rate );
+}
+
+void PrintRate( void )
+{
+  P2pStatistics_t *stats = P2pGetStatistics();
+  const P2pRate_t *entry = P2pGetRate( P2pGetCurrentRate() );
+  uint32_t elapsed = millis() - benchStart;
+  uint32_t bytes = stats->BytesAcked - benchBytes;
+  uint32_t frames = ( stats->FramesSent - stats->Retransmissions ) - benchFrames;
+
+  Serial.printf("SF%u BW%u: %u bytes in %u ms, goodput %u B/s, %u.%02u packets/s, %u retransmissions\r\n",
+                entry->SpreadingFactor, 125 << entry->Bandwidth, bytes, elapsed,
+                ( bytes * 1000 ) / elapsed, ( frames * 1000 ) / elapsed, ( ( frames * 100000 ) / elapsed ) % 100,
+                stats->Retransmissions - benchRetransmissions);
+}
+
+void SendWindow( void )
+{
+  for( uint8_t i = 0; i < WINDOW_SIZE; i++ )
+  {
+    payload[0] = i;
+    P2pSend( payload, PAYLOAD_SIZE );
+  }
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+  SPI.begin(SCK,MISO,MOSI,SS);
+  Mcu.init(SS,RST_LoRa,DIO0,DIO1,license);
+
+  for( uint8_t i = 0; i < PAYLOAD_SIZE; i++ )
+    payload[i] = i;
+
+  p2pParams.Frequency = RF_FREQUENCY;
+  p2pParams.TxPower = TX_OUTPUT_POWER;
+  p2pParams.Coderate = LORA_CODINGRATE;
+  p2pParams.PreambleLen = LORA_PREAMBLE_LENGTH;
+  p2pParams.BaseRate = 0;
+  p2pParams.MaxRate = P2P_RATE_COUNT - 1;
+  p2pParams.AutoRate = AUTO_RATE;
+  p2pParams.SnrMargin = 5;
+  p2pParams.FixedPayload = LORA_FIXED_PAYLOAD;
+  p2pParams.WindowSize = WINDOW_SIZE;
+  p2pParams.MaxRetries = 8;
+  p2pParams.LinkTimeout = 30000;
+
+  p2pEvents.WindowDone = OnWindowDone;
+  p2pEvents.RxData = OnRxData;
+  p2pEvents.RateChanged = OnRateChanged;
+
+  if( !P2pInit( &p2pParams, &p2pEvents ) )
+  {
+    Serial.println("P2P init failed");
+    while (1);
+  }
+
+#if ROLE_SENDER
+#if AUTO_RATE
+  StartMeasure();
+#else
+  StartRate( 0 );
+#endif
+  windowPending = true;
+#else
+  P2pListen();
+#endif
+}
+
+void loop()
+{
+#if ROLE_SENDER
+  if( windowPending )
+  {
+    windowPending = false;
+    if( benchWarmup )
+    {
+      if( P2pGetCurrentRate() == benchRate )
+        StartMeasure();
+    }
+    else if( ++benchWindows >= BENCH_WINDOWS )
+    {
+      PrintRate();
+#if AUTO_RATE
+      StartMeasure();
+#else
+      StartRate( ( benchRate + 1 ) % P2P_RATE_COUNT );
+#endif
+    }
+    SendWindow();
+  }
+#endif
+  LoRaWAN.sleep(CLASS_C,0);
+}
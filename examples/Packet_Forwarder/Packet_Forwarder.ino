@@ -0,0 +1,155 @@
+/*
+ * HelTec Automation(TM) single channel packet forwarder example
+ *
+ * Function summary:
+ *
+ * - The board listens continuously on one channel and spreading factor and
+ *   forwards every packet to a LoRaWAN network server with the Semtech UDP
+ *   protocol (PUSH_DATA), with the receive timestamp in microseconds;
+ *
+ * - Downlinks received from the server (PULL_RESP) are sent at the time
+ *   the server asked for, so a node can join and get its RX1 downlinks
+ *   through this gateway. Only nodes using the same channel and SF are
+ *   heard;
+ *
+ * - Set the server address to the machine running
+ *   tools/pktfwd_server.py to check the gateway without a network server;
+ *
+ * - Only ESP32 + LoRa series boards can use this library, need a license
+ *   to make the code run(check you license here: http://www.heltec.cn/search/);
+ *
+ * HelTec AutoMation, Chengdu, China.
+ * 成都惠利特自动化科技有限公司
+ * https://heltec.org
+ * support@heltec.cn
+ *
+ *this project also release in GitHub:
+ *https://github.com/HelTecAutomation/ESP32_LoRaWAN
+*/
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <ESP32_LoRaWAN.h>
+#include "Arduino.h"
+#include "pktfwd.h"
+
+const char* ssid = "Your_WiFi_Name";
+const char* password = "Your_WiFi_Password";
+
+const char* serverHost = "192.168.1.10";
+const uint16_t serverPort = 1700;
+
+#define RF_FREQUENCY                                868100000 // Hz
+#define LORA_SPREADING_FACTOR                       7         // [SF7..SF12]
+#define LORA_BANDWIDTH                              0         // [0: 125 kHz,
+                                                              //  1: 250 kHz,
+                                                              //  2: 500 kHz]
+#define LORA_CODINGRATE                             1         // [1: 4/5,
+                                                              //  2: 4/6,
+                                                              //  3: 4/7,
+                                                              //  4: 4/8]
+#define LORA_PREAMBLE_LENGTH                        8
+
+uint32_t  license[4] = {0xD5397DF0, 0x8573F814, 0x7A38C73D, 0x48E68607};
+
+static WiFiUDP udpUp;
+static WiFiUDP udpDown;
+
+static PktFwdParams_t fwdParams;
+static PktFwdNetwork_t fwdNetwork;
+
+static uint8_t rxDatagram[PKTFWD_DATAGRAM_SIZE];
+static uint32_t lastPrint;
+
+bool NetworkSend( PktFwdSocket_t socket, const uint8_t *buffer, uint16_t size )
+{
+  WiFiUDP *udp = ( socket == PKTFWD_SOCKET_UP ) ? &udpUp : &udpDown;
+
+  if( WiFi.status() != WL_CONNECTED )
+    return false;
+  if( !udp->beginPacket(serverHost, serverPort) )
+    return false;
+  udp->write(buffer, size);
+  return udp->endPacket() == 1;
+}
+
+void PollSocket( WiFiUDP *udp, PktFwdSocket_t socket )
+{
+  int size = udp->parsePacket();
+
+  if( size > 0 )
+  {
+    size = udp->read(rxDatagram, sizeof(rxDatagram));
+    PktFwdOnDatagram( socket, rxDatagram, size );
+  }
+}
+
+void setup()
+{
+  uint64_t mac = ESP.getEfuseMac();
+
+  Serial.begin(115200);
+  while (!Serial);
+  SPI.begin(SCK,MISO,MOSI,SS);
+  Mcu.init(SS,RST_LoRa,DIO0,DIO1,license);
+
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED)
+  {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println(WiFi.localIP());
+  udpUp.begin(0);
+  udpDown.begin(0);
+
+  // Gateway EUI from the MAC address, FFFE inserted in the middle
+  const uint8_t *macBytes = (const uint8_t *)&mac;
+  fwdParams.GatewayEui[0] = macBytes[0];
+  fwdParams.GatewayEui[1] = macBytes[1];
+  fwdParams.GatewayEui[2] = macBytes[2];
+  fwdParams.GatewayEui[3] = 0xFF;
+  fwdParams.GatewayEui[4] = 0xFE;
+  fwdParams.GatewayEui[5] = macBytes[3];
+  fwdParams.GatewayEui[6] = macBytes[4];
+  fwdParams.GatewayEui[7] = macBytes[5];
+  Serial.print("Gateway EUI: ");
+  for (uint8_t i = 0; i < 8; i++)
+    Serial.printf("%02X", fwdParams.GatewayEui[i]);
+  Serial.println();
+
+  fwdParams.Frequency = RF_FREQUENCY;
+  fwdParams.SpreadingFactor = LORA_SPREADING_FACTOR;
+  fwdParams.Bandwidth = LORA_BANDWIDTH;
+  fwdParams.Coderate = LORA_CODINGRATE;
+  fwdParams.PreambleLen = LORA_PREAMBLE_LENGTH;
+  fwdParams.PublicNetwork = true;
+  fwdParams.KeepaliveInterval = 10000;
+  fwdParams.StatInterval = 30000;
+
+  fwdNetwork.Send = NetworkSend;
+
+  if( !PktFwdInit( &fwdParams, &fwdNetwork ) )
+  {
+    Serial.println("forwarder init failed");
+    while (1);
+  }
+}
+
+void loop()
+{
+  PollSocket( &udpUp, PKTFWD_SOCKET_UP );
+  PollSocket( &udpDown, PKTFWD_SOCKET_DOWN );
+  PktFwdProcess();
+
+  if( millis() - lastPrint >= 60000 )
+  {
+    PktFwdStatistics_t *stats = PktFwdGetStatistics();
+
+    lastPrint = millis();
+    Serial.printf("rx %u ok %u fw %u dropped %u, push %u/%u pull %u/%u, dl %u sent %u late %u\r\n",
+                  stats->RxReceived, stats->RxOk, stats->RxForwarded, stats->RxDropped,
+                  stats->PushAcked, stats->PushSent, stats->PullAcked, stats->PullSent,
+                  stats->DownlinksReceived, stats->DownlinksSent, stats->TxTooLate);
+  }
+}
@@ -0,0 +1,153 @@
+/*
+ * HelTec Automation(TM) uplink payload codec benchmark
+ *
+ * Function summary:
+ *
+ * - Codes synthetic sensor series with the HDC1080 example schema
+ *   (payload-codec.h) and decodes them back, no radio involved;
+ *
+ * - Series: indoor random walk, outdoor daily cycle and a noisy one, each
+ *   with every frame acknowledged and with 1 acknowledgement in 4 lost;
+ *
+ * - Bytes per reading against the 10 raw bytes (two floats and the battery
+ *   voltage), encode cycles and the largest decoding error are printed via
+ *   serial(115200);
+ *
+ * - Only ESP32 + LoRa series boards can use this library, need a license
+ *   to make the code run(check you license here: http://www.heltec.cn/search/);
+ *
+ * HelTec AutoMation, Chengdu, China.
+ * 成都惠利特自动化科技有限公司
+ * https://heltec.org
+ * support@heltec.cn
+ *
+ *this project also release in GitHub:
+ *https://github.com/HelTecAutomation/ESP32_LoRaWAN
+*/
+
+#include <ESP32_LoRaWAN.h>
+#include "Arduino.h"
+#include "payload-codec.h"
+
+#define BENCH_READINGS                              1000      // Readings per series
+#define RAW_SIZE                                    10        // Bytes of the raw payload
+
+#define HDC1080_FIELDS( FIELD )                  \
+  FIELD( Temperature, -40.0f, 125.0f, 0.01f )    \
+  FIELD( Humidity, 0.0f, 100.0f, 0.1f )          \
+  FIELD( Battery, 0.0f, 12500.0f, 10.0f )
+
+PAYLOAD_CODEC_DEFINE( Hdc1080, HDC1080_FIELDS )
+
+uint32_t  license[4] = {0xD5397DF0, 0x8573F814, 0x7A38C73D, 0x48E68607};
+
+typedef enum
+{
+  SERIES_INDOOR,
+  SERIES_OUTDOOR,
+  SERIES_NOISY,
+  SERIES_COUNT,
+}Series_t;
+
+static const char *seriesNames[SERIES_COUNT] = { "indoor", "outdoor", "noisy" };
+
+static PayloadCodec_t codec;
+static PayloadCodecDecoder_t decoder;
+static uint32_t seed;
+
+// Uniform noise in [-amplitude, amplitude], from a fixed LCG so that the
+// series are the same on every run
+static float Noise( float amplitude )
+{
+  seed = seed * 1664525 + 1013904223;
+  return amplitude * ( ( float )( seed >> 8 ) / 8388608.0f - 1.0f );
+}
+
+static void NextReading( Series_t series, uint32_t i, Hdc1080Sample_t *sample )
+{
+  switch( series )
+  {
+    case SERIES_INDOOR:
+      // 15 s readings of a room: slow walks, the battery draining
+      sample->Temperature += Noise( 0.02f );
+      sample->Humidity += Noise( 0.15f );
+      sample->Battery = 4100.0f - i / 50 + Noise( 8.0f );
+      break;
+    case SERIES_OUTDOOR:
+      // 15 min readings over 10 days
+      sample->Temperature = 12.0f + 8.0f * sinf( 2 * PI * i / 96 ) + Noise( 0.05f );
+      sample->Humidity = 70.0f - 20.0f * sinf( 2 * PI * i / 96 ) + Noise( 0.5f );
+      sample->Battery = 4000.0f + Noise( 8.0f );
+      break;
+    default:
+      // A sensor next to a heater switching on and off
+      sample->Temperature = 22.0f + ( ( i / 8 ) & 1 ? 4.0f : 0.0f ) + Noise( 0.5f );
+      sample->Humidity = 40.0f + Noise( 3.0f );
+      sample->Battery = 3900.0f + Noise( 40.0f );
+      break;
+  }
+}
+
+static void RunSeries( Series_t series, uint8_t lostAcks )
+{
+  Hdc1080Sample_t sample = { 21.0f, 45.0f, 4100.0f };
+  Hdc1080Sample_t decoded;
+  uint8_t frame[LORAWAN_APP_DATA_MAX_SIZE];
+  uint32_t bytes = 0;
+  uint32_t cycles = 0;
+  uint32_t start;
+  uint8_t maxSize = 0;
+  uint8_t size;
+  float error = 0.0f;
+
+  seed = series + 1;
+  codec.Fields = NULL;
+  Hdc1080Init( &codec );
+  Hdc1080DecoderInit( &decoder );
+
+  for( uint32_t i = 0; i < BENCH_READINGS; i++ )
+  {
+    NextReading( series, i, &sample );
+
+    start = ESP.getCycleCount();
+    size = Hdc1080Encode( &codec, &sample, frame, sizeof( frame ) );
+    cycles += ESP.getCycleCount() - start;
+    bytes += size;
+    maxSize = max( maxSize, size );
+
+    if( !Hdc1080Decode( &decoder, frame, size, &decoded ) )
+    {
+      Serial.printf("%s: reading %u not decoded\r\n", seriesNames[series], i);
+      return;
+    }
+    error = max( error, fabsf( decoded.Temperature - constrain( sample.Temperature, -40.0f, 125.0f ) ) );
+
+    // The lost acknowledgements keep the older reference
+    if( ( lostAcks == 0 ) || ( ( i % 4 ) != 0 ) )
+      PayloadCodecAck( &codec );
+  }
+
+  Serial.printf("%s, %s: %u.%02u bytes per reading (raw %u), max %u, %u cycles per encode, temperature error %.3f\r\n",
+                seriesNames[series], lostAcks ? "1 ack in 4 lost" : "all acked",
+                bytes / BENCH_READINGS, ( bytes * 100 / BENCH_READINGS ) % 100, RAW_SIZE, maxSize,
+                cycles / BENCH_READINGS, error);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+  SPI.begin(SCK,MISO,MOSI,SS);
+  Mcu.init(SS,RST_LoRa,DIO0,DIO1,license);
+
+  for( uint8_t series = 0; series < SERIES_COUNT; series++ )
+  {
+    RunSeries( ( Series_t )series, 0 );
+    RunSeries( ( Series_t )series, 1 );
+  }
+}
+
+void loop()
+{
+  LoRaWAN.sleep(CLASS_A,0);
+}
@@ -9,6 +9,10 @@
  *
  * - 15S data send cycle;
  *
+ * - Readings coded with payload-codec.h, against the last acknowledged one;
+ *
+ * - The HDC1080 conversions run ahead of the uplink, while the device sleeps;
+ *
  * - Informations output via serial(115200);
  *
  * - Only ESP32 + LoRa series boards can use this library, need a license
@@ -29,6 +33,7 @@
 #include "Arduino.h"
 #include "sensor/HDC1080.h"
 #include "esp32-hal-adc.h"
+#include "payload-codec.h"
 
 /*license for Heltec ESP32 LoRaWan, quary your ChipID relevant license: http://resource.heltec.cn/search */
 uint32_t  license[4] = {0xD5397DF0, 0x8573F814, 0x7A38C73D, 0x48E68607};
@@ -97,7 +102,36 @@ uint8_t debugLevel = LoRaWAN_DEBUG_LEVEL;
 /*LoraWan region, select in arduino IDE tools*/
 LoRaMacRegion_t loraWanRegion = ACTIVE_REGION;
 
+/*Uplink payload schema: name, min, max, step. The network server decodes it with
+ *tools/payload_codec.py --schema Temperature:-40:125:0.01,Humidity:0:100:0.1,Battery:0:12500:10
+ */
+#define HDC1080_FIELDS( FIELD )                  \
+  FIELD( Temperature, -40.0f, 125.0f, 0.01f )    \
+  FIELD( Humidity, 0.0f, 100.0f, 0.1f )          \
+  FIELD( Battery, 0.0f, 12500.0f, 10.0f )
+
+PAYLOAD_CODEC_DEFINE( Hdc1080, HDC1080_FIELDS )
+
+/*the reference of the delta coding survives deep sleep*/
+RTC_DATA_ATTR static PayloadCodec_t payloadCodec;
+
+static void onUplinkDelivered( void )
+{
+  PayloadCodecAck( &payloadCodec );
+}
+
 HDC1080 hdc1080;
+
+/*the HDC1080 is powered up and converting, ready by the next uplink*/
+static bool sampling = false;
+
+static void startSampling( void )
+{
+  pinMode(Vext,OUTPUT);
+  digitalWrite(Vext,LOW);
+  sampling = hdc1080.startAcquisition(HDC1080_POWER_UP_TIME);
+}
+
 static void prepareTxFrame( uint8_t port )
 {
     /*appData size is LORAWAN_APP_DATA_MAX_SIZE which is defined in "commissioning.h".
@@ -107,36 +141,28 @@ static void prepareTxFrame( uint8_t port )
   *for example, if use REGION_CN470,
   *the max value for different DR can be found in MaxPayloadOfDatarateCN470 refer to DataratesCN470 and BandwidthsCN470 in "RegionCN470.h".
   */
-    pinMode(Vext,OUTPUT);
-    digitalWrite(Vext,LOW);
+    HDC1080_Measurement measurement = { 0, 0 };
+
+    // Not started ahead after the join or a rejoin, the reading waits then
+    if (!sampling)
+      startSampling();
     uint16_t batteryVoltage = analogRead(37)*3.046;
-    hdc1080.begin(0x40);
-    float temperature = (float)(hdc1080.readTemperature());
-    float humidity = (float)(hdc1080.readHumidity());
-    hdc1080.end();
+    if (!hdc1080.readAcquisition(&measurement))
+      Serial.println("HDC1080 not read");
     digitalWrite(Vext,HIGH);
-    unsigned char *puc;
-
-    puc = (unsigned char *)(&temperature);
-    appDataSize = 10;
-    appData[0] = puc[0];
-    appData[1] = puc[1];
-    appData[2] = puc[2];
-    appData[3] = puc[3];
-
-    puc = (unsigned char *)(&humidity);
-    appData[4] = puc[0];
-    appData[5] = puc[1];
-    appData[6] = puc[2];
-    appData[7] = puc[3];
+    sampling = false;
+    Hdc1080Sample_t sample;
 
-    appData[8] = (uint8_t)(batteryVoltage>>8);
-    appData[9] = (uint8_t)batteryVoltage;
+    sample.Temperature = measurement.temperature / 100.0f;
+    sample.Humidity = measurement.humidity / 100.0f;
+    sample.Battery = batteryVoltage;
+    Hdc1080Init( &payloadCodec );
+    appDataSize = Hdc1080Encode( &payloadCodec, &sample, appData, LORAWAN_APP_DATA_MAX_SIZE );
 
     Serial.print("T=");
-    Serial.print(temperature);
+    Serial.print(sample.Temperature);
     Serial.print("C, RH=");
-    Serial.print(humidity);
+    Serial.print(sample.Humidity);
     Serial.print("%,");
     Serial.print("BatteryVoltage:");
     Serial.println(batteryVoltage);
@@ -147,12 +173,21 @@ void setup()
 {
   Serial.begin(115200);
   while (!Serial);
+  hdc1080.begin(0x40);
+  // Woken up for the next uplink: the conversions run while the radio and the MAC restart
+  if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER)
+    startSampling();
   SPI.begin(SCK,MISO,MOSI,SS);
   Mcu.init(SS,RST_LoRa,DIO0,DIO1,license);
 
   adcAttachPin(37);
   analogSetClockDiv(255); // 1338mS
 
+  lorawanCallbacks.onUplinkDelivered = onUplinkDelivered;
+  lorawanCallbacks.onSampleStart = startSampling;
+  LoRaWAN.sampleAhead(HDC1080_POWER_UP_TIME + hdc1080.acquisitionTime());
+  // No WiFi nor GPIO interrupt, the MCU can light sleep between the timer events
+  LpmSetLightSleepMode(LPM_APPLI_ID, LPM_ENABLE);
   deviceState = DEVICE_STATE_INIT;
 }
 
@@ -167,6 +202,8 @@ void loop()
 			LoRaWAN.generateDeveuiByChipID();
 #endif
       LoRaWAN.init(loraWanClass,loraWanRegion);
+      // Keep the readings in the "uplog" partition, if any, until delivered
+      LoRaWAN.enableUplinkLog();
       break;
     }
     case DEVICE_STATE_JOIN:
@@ -183,8 +220,8 @@ void loop()
     }
     case DEVICE_STATE_CYCLE:
     {
-      // Schedule next packet transmission
-      txDutyCycleTime = appTxDutyCycle + randr( -APP_TX_DUTYCYCLE_RND, APP_TX_DUTYCYCLE_RND );
+      // Schedule next packet transmission in the transmit slot of the device
+      txDutyCycleTime = LoRaWAN.slotDutyCycle( appTxDutyCycle );
       LoRaWAN.cycle(txDutyCycleTime);
       deviceState = DEVICE_STATE_SLEEP;
       break;
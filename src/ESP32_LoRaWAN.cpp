@@ -1,4 +1,5 @@
 #include <ESP32_LoRaWAN.h>
+#include "uplink-log-board.h"
 
 #ifdef REGION_EU868
 #include "region/RegionEU868.h"
@@ -38,6 +39,43 @@ TimerEvent_t TxNextPacketTimer;
  * Indicates if a new packet can be sent
  */
 static bool NextTx = true;
+
+/*!
+ * Time on air of the last uplink, sizes the transmit slots
+ */
+RTC_DATA_ATTR static TimerTime_t lastTxTimeOnAir = 0;
+
+/*!
+ * Set when the transmit slots need a new network time
+ */
+RTC_DATA_ATTR static bool deviceTimePending = false;
+
+/*!
+ * Set once the uplink log is mounted, the application data then goes through it
+ */
+static bool uplinkLogEnabled = false;
+
+/*!
+ * Set while a frame of log records waits for its acknowledgement
+ */
+static bool uplinkLogFrameSent = false;
+
+/*!
+ * Frame of log records, and the timer of the next one while draining
+ */
+static uint8_t uplinkLogFrame [UPLINK_LOG_ENTRY_HEADER_SIZE + UPLINK_LOG_MAX_DATA_SIZE];
+static TimerEvent_t UplinkLogDrainTimer;
+
+/*!
+ * Set while the frame in flight carries the data of the last send ()
+ */
+static bool uplinkDataSent = false;
+
+/*!
+ * Time the sensors are started before the next uplink [ms], and its timer
+ */
+static uint32_t sampleLeadTime = 0;
+static TimerEvent_t SampleTimer;
 enum eDeviceState deviceState;
 lorawanCallbacks_t lorawanCallbacks;
 
@@ -55,7 +93,61 @@ static bool SendFrame (void)
 
   lwan_dev_params_update ();
 
-  if (LoRaMacQueryTxPossible (appDataSize, &txInfo) != LORAMAC_STATUS_OK)
+  if (deviceTimePending)
+  {
+    MlmeReq_t mlmeReq;
+
+    mlmeReq.Type = MLME_DEVICE_TIME;
+
+    if (LoRaMacMlmeRequest (&mlmeReq) == LORAMAC_STATUS_OK)
+      deviceTimePending = false;
+  }
+
+  if (uplinkLogEnabled && (UplinkLogPending () > 0))
+  {
+    LoRaMacStatus_t status;
+    uint8_t size = 0;
+
+    //
+    //  The data is in the log, the frame packs the oldest pending records
+    //  and is confirmed to mark them delivered. When the oldest one does not
+    //  fit at this datarate, an empty frame flushes the MAC commands.
+    //
+    if (LoRaMacQueryTxPossible (0, &txInfo) == LORAMAC_STATUS_OK)
+      size = UplinkLogPack ((uint32_t) (LpmGetRtcTime () / 1000), uplinkLogFrame, txInfo.MaxPossiblePayload);
+
+    if (size > 0)
+    {
+      if (lorawanCallbacks.onConfirmedUplinkSending)
+        lorawanCallbacks.onConfirmedUplinkSending ();
+
+      mcpsReq.Type = MCPS_CONFIRMED;
+      mcpsReq.Req.Confirmed.fPort = UPLINK_LOG_FPORT;
+      mcpsReq.Req.Confirmed.fBuffer = uplinkLogFrame;
+      mcpsReq.Req.Confirmed.fBufferSize = size;
+      mcpsReq.Req.Confirmed.NbTrials = confirmedNbTrials;
+      mcpsReq.Req.Confirmed.Datarate = LORAWAN_DEFAULT_DATARATE;
+    }
+    else
+    {
+      mcpsReq.Type = MCPS_UNCONFIRMED;
+      mcpsReq.Req.Unconfirmed.fBuffer = NULL;
+      mcpsReq.Req.Unconfirmed.fBufferSize = 0;
+      mcpsReq.Req.Unconfirmed.Datarate = LORAWAN_DEFAULT_DATARATE;
+    }
+
+    status = LoRaMacMcpsRequest (&mcpsReq);
+    uplinkLogFrameSent = (status == LORAMAC_STATUS_OK) && (size > 0);
+
+    if (!uplinkLogFrameSent)
+      UplinkLogAck (false);
+
+    return (status != LORAMAC_STATUS_OK);
+  }
+
+  bool withData = (LoRaMacQueryTxPossible (appDataSize, &txInfo) == LORAMAC_STATUS_OK);
+
+  if (!withData)
   {
     // Send empty frame in order to flush MAC commands
     mcpsReq.Type = MCPS_UNCONFIRMED;
@@ -91,7 +183,10 @@ static bool SendFrame (void)
   }
 
   if (LoRaMacMcpsRequest (&mcpsReq) == LORAMAC_STATUS_OK)
+  {
+    uplinkDataSent = withData;
     return false;
+  }
 
   return true;
 }
@@ -133,17 +228,27 @@ static void OnTxNextPacketTimerEvent (void)
       mlmeReq.Req.Join.AppKey = AppKey;
       mlmeReq.Req.Join.NbTrials = 1;
 
-      if (LoRaMacMlmeRequest (&mlmeReq) == LORAMAC_STATUS_OK)
+      if (LoRaMacMlmeRequest (&mlmeReq) != LORAMAC_STATUS_OK)
+      {
+        if (lorawanCallbacks.setDeviceState)
+          lorawanCallbacks.setDeviceState (DEVICE_STATE_CYCLE);
+        else
+          deviceState = DEVICE_STATE_CYCLE;
+      }
+      else if (uplinkLogEnabled)
       {
+        //
+        //  The application still takes its reading, send () logs it
+        //
         if (lorawanCallbacks.setDeviceState)
-          lorawanCallbacks.setDeviceState (DEVICE_STATE_SLEEP);
+          lorawanCallbacks.setDeviceState (DEVICE_STATE_SEND);
         else
-          deviceState = DEVICE_STATE_SLEEP;
+          deviceState = DEVICE_STATE_SEND;
       }
       else if (lorawanCallbacks.setDeviceState)
-        lorawanCallbacks.setDeviceState (DEVICE_STATE_CYCLE);
+        lorawanCallbacks.setDeviceState (DEVICE_STATE_SLEEP);
       else
-        deviceState = DEVICE_STATE_CYCLE;
+        deviceState = DEVICE_STATE_SLEEP;
 
       if (lorawanCallbacks.onDeviceStateChange)
         lorawanCallbacks.onDeviceStateChange (deviceState, __func__, __LINE__);
@@ -151,6 +256,30 @@ static void OnTxNextPacketTimerEvent (void)
   }
 }
 
+/*!
+ * \brief Function executed on UplinkLogDrain Timeout event, sends the next
+ *        frame of log records
+ */
+static void OnUplinkLogDrainTimerEvent (void)
+{
+  TimerStop (&UplinkLogDrainTimer);
+
+  if (NextTx == true)
+    NextTx = SendFrame ();
+}
+
+/*!
+ * \brief Function executed on Sample Timeout event, starts the sensors so
+ *        that their readings are ready when the next uplink is built
+ */
+static void OnSampleTimerEvent (void)
+{
+  TimerStop (&SampleTimer);
+
+  if (lorawanCallbacks.onSampleStart)
+    lorawanCallbacks.onSampleStart ();
+}
+
 /*!
  * \brief   MCPS-Confirm event function
  *
@@ -159,6 +288,29 @@ static void OnTxNextPacketTimerEvent (void)
  */
 static void McpsConfirm (McpsConfirm_t *mcpsConfirm)
 {
+  lastTxTimeOnAir = mcpsConfirm->TxTimeOnAir;
+
+  //
+  //  Once a frame of log records gets through, drain the backlog in a burst
+  //
+  if (uplinkLogFrameSent)
+  {
+    uplinkLogFrameSent = false;
+    UplinkLogAck (mcpsConfirm->AckReceived);
+
+    if (mcpsConfirm->AckReceived && (UplinkLogPending () > 0))
+    {
+      TimerSetValue (&UplinkLogDrainTimer, APP_TX_LOG_DRAIN_DELAY);
+      TimerStart (&UplinkLogDrainTimer);
+    }
+    else if (mcpsConfirm->AckReceived && lorawanCallbacks.onUplinkDelivered)
+      lorawanCallbacks.onUplinkDelivered ();
+  }
+  else if (uplinkDataSent && mcpsConfirm->AckReceived && lorawanCallbacks.onUplinkDelivered)
+    lorawanCallbacks.onUplinkDelivered ();
+
+  uplinkDataSent = false;
+
   if (mcpsConfirm->Status == LORAMAC_EVENT_INFO_STATUS_OK)
   {
     switch (mcpsConfirm->McpsRequest)
@@ -394,8 +546,11 @@ void LoRaWanClass::init (DeviceClass_t classMode, LoRaMacRegion_t region)
   LoRaMacCallback.GetBatteryLevel = lorawanCallbacks.onGetBatteryLevel ? lorawanCallbacks.onGetBatteryLevel : BoardGetBatteryLevel;
   LoRaMacCallback.GetTemperatureLevel = lorawanCallbacks.onGetTemperatureLevel;
   LoRaMacInitialization (&LoRaMacPrimitive, &LoRaMacCallback, region);
+  LpmInit ();
   TimerStop (&TxNextPacketTimer);
   TimerInit (&TxNextPacketTimer, OnTxNextPacketTimerEvent);
+  TimerStop (&SampleTimer);
+  TimerInit (&SampleTimer, OnSampleTimerEvent);
 
   if (IsLoRaMacNetworkJoined == false)
   {
@@ -522,22 +677,164 @@ void LoRaWanClass::deviceTimeReq ()
     NextTx = true;
 }
 
+bool LoRaWanClass::getGpsTime (SysTimeGps_t *gpsTime)
+{
+  return SysTimeGetGps (gpsTime);
+}
+
+/*!
+ * \brief   Hashes the DevEUI, FNV-1a, to spread the devices over the slots
+ */
+static uint32_t devEuiHash (void)
+{
+  uint32_t hash = 2166136261UL;
+
+  for (int i = 0; i < 8; i++)
+    hash = (hash ^ DevEui [i]) * 16777619UL;
+
+  return hash;
+}
+
+/*!
+ * \brief   Returns the time to the transmit slot of the device in the next
+ *          cycle. The cycle is split in slots aligned on the GPS epoch, and the
+ *          DevEUI picks one, so that a fleet spreads over the whole cycle
+ *          whatever its power up times. Without network time, returns the
+ *          duty cycle with the APP_TX_DUTYCYCLE_RND jitter.
+ *
+ * \param   [IN] dutyCycle - Uplink period [ms]
+ *
+ * \retval  Time to the next uplink [ms]
+ */
+uint32_t LoRaWanClass::slotDutyCycle (uint32_t dutyCycle)
+{
+  SysTimeGps_t gps;
+  uint32_t width = APP_TX_SLOT_MIN_WIDTH;
+  uint32_t slots;
+  uint64_t now;
+  uint64_t slot;
+  bool synced = SysTimeGetGps (&gps);
+
+  //
+  //  Piggyback a DeviceTimeReq on the next uplink before the time error eats
+  //  the slot guards
+  //
+  if (!synced || (gps.Accuracy > APP_TX_SLOT_RESYNC_ACCURACY))
+    deviceTimePending = true;
+
+  if (!synced)
+    return dutyCycle + randr (-APP_TX_DUTYCYCLE_RND, APP_TX_DUTYCYCLE_RND);
+
+  //
+  //  The slot holds the uplink and the time error on both sides. Power of two
+  //  widths keep the slots of all the devices on the same boundaries.
+  //
+  while (width < lastTxTimeOnAir + 2 * gps.Accuracy)
+    width <<= 1;
+
+  if ((slots = dutyCycle / width) < 2)
+    return dutyCycle + randr (-APP_TX_DUTYCYCLE_RND, APP_TX_DUTYCYCLE_RND);
+
+  //
+  //  First slot of the device at least half a cycle from now, the uplink
+  //  centered in it
+  //
+  now = (uint64_t) gps.Seconds * 1000 + gps.SubSeconds;
+  slot = now / width + slots / 2 + 1;
+  slot += (devEuiHash () % slots + slots - slot % slots) % slots;
+
+  return (uint32_t) (slot * width + (width - lastTxTimeOnAir) / 2 - now);
+}
+
+/*!
+ * \brief   Mounts the uplink log on the "uplog" data partition. The data of
+ *          every send () is then appended to it, the uplinks pack the oldest
+ *          pending records and the log is drained once the network answers.
+ *
+ * \retval  [false: no partition or flash error, true: log enabled]
+ */
+bool LoRaWanClass::enableUplinkLog ()
+{
+  const UplinkLogFlash_t *flash = UplinkLogBoardGetFlash ();
+
+  uplinkLogEnabled = (flash != NULL) && UplinkLogInit (flash);
+
+  if (uplinkLogEnabled)
+    TimerInit (&UplinkLogDrainTimer, OnUplinkLogDrainTimerEvent);
+
+  return uplinkLogEnabled;
+}
+
+void LoRaWanClass::getUplinkLogStatus (UplinkLogStatus_t *status)
+{
+  UplinkLogGetStatus (status);
+}
+
 void LoRaWanClass::send (DeviceClass_t classMode)
 {
+  uplinkDataSent = false;
+
+  if (uplinkLogEnabled)
+    UplinkLogAppend (appPort, (uint32_t) (LpmGetRtcTime () / 1000), appData, appDataSize);
+
   if (NextTx == true)
     NextTx = SendFrame ();
 }
 
+/*!
+ * \brief   Calls onSampleStart the lead time before each uplink scheduled by
+ *          cycle (), e.g. the power up and conversion time of the sensors,
+ *          so that the conversions run while the device sleeps. Not called
+ *          when the device deep sleeps until the uplink: the application
+ *          restarts then, and starts the conversions itself.
+ *
+ * \param   [IN] leadTime - Lead time [ms], 0 disables it
+ */
+void LoRaWanClass::sampleAhead (uint32_t leadTime)
+{
+  sampleLeadTime = leadTime;
+}
+
 void LoRaWanClass::cycle (uint32_t dutyCycle)
 {
   TimerSetValue (&TxNextPacketTimer, dutyCycle);
   TimerStart (&TxNextPacketTimer);
+
+  if (lorawanCallbacks.onSampleStart && sampleLeadTime && (dutyCycle > sampleLeadTime))
+  {
+    TimerSetValue (&SampleTimer, dutyCycle - sampleLeadTime);
+    TimerStart (&SampleTimer);
+  }
 }
 
 void LoRaWanClass::sleep (DeviceClass_t classMode, uint8_t debugLevel)
 {
   Radio.IrqProcess ();
-  Mcu.sleep (classMode, debugLevel);
+
+  TimerEvent_t *nextTimer = (TimerListHead == &SampleTimer) ? SampleTimer.Next : TimerListHead;
+
+  //
+  //  Deep sleep restarts the application, only when a joined class A device
+  //  waits for its next uplink. The sample timer is dropped then, the
+  //  application samples as it restarts.
+  //
+  if ((classMode == CLASS_A) && IsLoRaMacNetworkJoined && (nextTimer == &TxNextPacketTimer) && !nextTimer->Next)
+    LpmSetDeepSleepMode (LPM_LIB_ID, LPM_ENABLE);
+  else
+    LpmSetDeepSleepMode (LPM_LIB_ID, LPM_DISABLE);
+
+  if ((nextTimer != TimerListHead) && (LpmGetMode () == LPM_DEEP_SLEEP_MODE))
+    TimerStop (&SampleTimer);
+
+  if (debugLevel && (LpmGetMode () == LPM_DEEP_SLEEP_MODE))
+  {
+    Serial.printf ("Deep Sleep until Next TxPacket:%d ms\r\n", (int) (nextAlarm - TimerGetTimerValue ()));
+    delay (8);
+  }
+
+  TRACE (TRACE_EVENT_SLEEP, 0, TimerGetCurrentTime ());
+  LpmEnterLowPower ();
+  TRACE (TRACE_EVENT_WAKEUP, 0, TimerGetCurrentTime ());
 }
 
 LoRaWanClass LoRaWAN;
@@ -9,8 +9,12 @@
 #include "utilities.h"
 #include "board-config.h"
 #include "LoRaMac.h"
+#include "trace.h"
 #include "Commissioning.h"
 #include "rtc-board.h"
+#include "lpm-board.h"
+#include "systime.h"
+#include "uplink-log.h"
 #include "delay.h"
 
 //
@@ -18,6 +22,19 @@
 //
 #define APP_TX_DUTYCYCLE_RND 1000
 
+//
+//  Transmit slots of slotDutyCycle: smallest width [ms], and the time
+//  accuracy [ms] above which a DeviceTimeReq goes with the next uplink
+//
+#define APP_TX_SLOT_MIN_WIDTH 128
+#define APP_TX_SLOT_RESYNC_ACCURACY 250
+
+//
+//  Delay between the frames draining the uplink log [ms], the duty cycle
+//  may hold them longer
+//
+#define APP_TX_LOG_DRAIN_DELAY 1000
+
 //
 //
 //
@@ -41,6 +58,8 @@ typedef struct lorawanCallbacks_s
   void     (*onDataReceived) (McpsIndication_t *mcpsIndication);
   void     (*onConfirmedUplinkSending) (void);
   void     (*onUnconfirmedUplinkSending) (void);
+  void     (*onUplinkDelivered) (void);
+  void     (*onSampleStart) (void);
   void     (*onMcpsIndication) (int rssi, int snr, int dataRate);
   void     (*onSysTimeUpdate) (void);
   uint8_t  (*onGetBatteryLevel) (void);
@@ -62,6 +81,11 @@ public:
   void sleep (DeviceClass_t classMode, uint8_t debugLevel);
   void generateDeveuiByChipID ();
   void deviceTimeReq ();
+  bool getGpsTime (SysTimeGps_t *gpsTime);
+  uint32_t slotDutyCycle (uint32_t dutyCycle);
+  void sampleAhead (uint32_t leadTime);
+  bool enableUplinkLog ();
+  void getUplinkLogStatus (UplinkLogStatus_t *status);
 };
 
 //
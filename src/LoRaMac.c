@@ -21,34 +21,28 @@ License: Revised BSD License, see LICENSE.TXT file include in the project
 
 Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jaeckle ( STACKFORCE )
 */
+#include <stddef.h>
 #include <sys/time.h>
+#include <math.h>
 #include "utilities.h"
 #include "LoRaMac.h"
 #include "LoRaMacCrypto.h"
 #include "LoRaMacTest.h"
 #include "LoRaMacConfirmQueue.h"
+#include "LoRaMacCtx.h"
 #include "region/Region.h"
-
-/*!
- * Maximum PHY layer payload size
- */
-#define LORAMAC_PHY_MAXPAYLOAD                      255
-
-/*!
- * Maximum MAC commands buffer size
- */
-#define LORA_MAC_COMMAND_MAX_LENGTH                 128
+#include "region/RegionCommon.h"
+#include "board-config.h"
+#include "lpm-board.h"
+#include "rtc-drift.h"
+#include "systime.h"
+#include "trace.h"
 
 /*!
  * Maximum length of the fOpts field
  */
 #define LORA_MAC_COMMAND_MAX_FOPTS_LENGTH           15
 
-/*!
- * LoRaMac region.
- */
-static LoRaMacRegion_t LoRaMacRegion;
-
 /*!
  * LoRaMac duty cycle for the back-off procedure during the first hour.
  */
@@ -65,217 +59,51 @@ static LoRaMacRegion_t LoRaMacRegion;
 #define BACKOFF_DC_24_HOURS                         10000
 
 /*!
- * Device IEEE EUI
- */
-RTC_DATA_ATTR static uint8_t *LoRaMacDevEui;
-
-/*!
- * Application IEEE EUI
- */
-RTC_DATA_ATTR static uint8_t *LoRaMacAppEui;
-
-/*!
- * AES encryption/decryption cipher application key
- */
-RTC_DATA_ATTR uint8_t *LoRaMacAppKey;
-
-/*!
- * AES encryption/decryption cipher network session key
- */
-RTC_DATA_ATTR static uint8_t LoRaMacNwkSKey[] = {
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-};
-
-/*!
- * AES encryption/decryption cipher application session key
- */
-RTC_DATA_ATTR static uint8_t LoRaMacAppSKey[] = {
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-};
-
-/*!
- * Device nonce is a random value extracted by issuing a sequence of RSSI
- * measurements
- */
-RTC_DATA_ATTR uint16_t LoRaMacDevNonce;
-
-/*!
- * Network ID ( 3 bytes )
- */
-RTC_DATA_ATTR static uint32_t LoRaMacNetID;
-
-/*!
- * Mote Address
- */
-RTC_DATA_ATTR static uint32_t LoRaMacDevAddr;
-
-/*!
- * Multicast channels linked list
- */
-RTC_DATA_ATTR static MulticastParams_t *MulticastChannels = NULL;
-
-/*!
- * Actual device class
- */
-RTC_DATA_ATTR static DeviceClass_t LoRaMacDeviceClass;
-
-/*!
- * Indicates if the node is connected to a private or public network
- */
-RTC_DATA_ATTR static bool PublicNetwork;
-
-/*!
- * Buffer containing the data to be sent or received.
- */
-RTC_DATA_ATTR static uint8_t LoRaMacBuffer[LORAMAC_PHY_MAXPAYLOAD];
-
-/*!
- * Length of packet in LoRaMacBuffer
- */
-RTC_DATA_ATTR static uint16_t LoRaMacBufferPktLen = 0;
-
-/*!
- * Length of the payload in LoRaMacBuffer
- */
-RTC_DATA_ATTR static uint8_t LoRaMacTxPayloadLen = 0;
-
-/*!
- * Buffer containing the upper layer data.
- */
-RTC_DATA_ATTR static uint8_t LoRaMacRxPayload[LORAMAC_PHY_MAXPAYLOAD];
-
-/*!
- * LoRaMAC frame counter. Each time a packet is sent the counter is incremented.
- * Only the 16 LSB bits are sent
- */
-RTC_DATA_ATTR uint32_t UpLinkCounter = 0;
-
-/*!
- * LoRaMAC frame counter. Each time a packet is received the counter is incremented.
- * Only the 16 LSB bits are received
- */
-RTC_DATA_ATTR uint32_t DownLinkCounter = 0;
-
-/*!
- * IsPacketCounterFixed enables the MIC field tests by fixing the
- * UpLinkCounter value
- */
-RTC_DATA_ATTR static bool IsUpLinkCounterFixed = false;
-
-/*!
- * Used for test purposes. Disables the opening of the reception windows.
- */
-RTC_DATA_ATTR static bool IsRxWindowsEnabled = true;
-
-/*!
- * Indicates if the MAC layer has already joined a network.
- */
-RTC_DATA_ATTR bool IsLoRaMacNetworkJoined = false;
-
-/*!
- * LoRaMac ADR control status
- */
-RTC_DATA_ATTR static bool AdrCtrlOn = false;
-
-/*!
- * Counts the number of missed ADR acknowledgements
- */
-RTC_DATA_ATTR static uint32_t AdrAckCounter = 0;
-
-/*!
- * If the node has sent a FRAME_TYPE_DATA_CONFIRMED_UP this variable indicates
- * if the nodes needs to manage the server acknowledgement.
- */
-RTC_DATA_ATTR static bool NodeAckRequested = false;
-
-/*!
- * If the server has sent a FRAME_TYPE_DATA_CONFIRMED_DOWN this variable indicates
- * if the ACK bit must be set for the next transmission
- */
-RTC_DATA_ATTR static bool SrvAckRequested = false;
-
-/*!
- * Indicates if the MAC layer wants to send MAC commands
- */
-RTC_DATA_ATTR static bool MacCommandsInNextTx = false;
-
-/*!
- * Contains the current MacCommandsBuffer index
- */
-RTC_DATA_ATTR static uint8_t MacCommandsBufferIndex = 0;
-
-/*!
- * Contains the current MacCommandsBuffer index for MAC commands to repeat
- */
-RTC_DATA_ATTR static uint8_t MacCommandsBufferToRepeatIndex = 0;
-
-/*!
- * Buffer containing the MAC layer commands
- */
-RTC_DATA_ATTR static uint8_t MacCommandsBuffer[LORA_MAC_COMMAND_MAX_LENGTH];
-
-/*!
- * Buffer containing the MAC layer commands which must be repeated
+ * Shortest retransmission spacing after RX2 the regional parameters allow,
+ * ACK_TIMEOUT - ACK_TIMEOUT_RND
  */
-RTC_DATA_ATTR static uint8_t MacCommandsBufferToRepeat[LORA_MAC_COMMAND_MAX_LENGTH];
+#define RETRY_ACK_TIMEOUT_MIN                       1000
 
 /*!
- * LoRaMac parameters
+ * Datarates, the current one included, considered for a retransmission
  */
-RTC_DATA_ATTR LoRaMacParams_t LoRaMacParams;
+#define RETRY_MAX_DR_STEPS                          4
 
 /*!
- * LoRaMac default parameters
+ * Channel draws of a retransmission to avoid the unacknowledged channels
  */
-RTC_DATA_ATTR LoRaMacParams_t LoRaMacParamsDefaults;
+#define RETRY_CHANNEL_DRAWS                         3
 
 /*!
- * Uplink messages repetitions counter
+ * Samples after which the link estimator averages become exponential
  */
-RTC_DATA_ATTR static uint8_t ChannelsNbRepCounter = 0;
+#define LINK_MIN_SAMPLES                            8
 
 /*!
- * Maximum duty cycle
- * \remark Possibility to shutdown the device.
+ * Margin lost per datarate step when extrapolating, in dB. The demodulation
+ * floors of two consecutive spreading factors are 2.5 dB apart.
  */
-RTC_DATA_ATTR static uint8_t MaxDCycle = 0;
+#define LINK_DR_STEP_MARGIN                         2.5f
 
 /*!
- * Aggregated duty cycle management
+ * Growth of the margin variance without news from the network, in dB^2 per hour
  */
-RTC_DATA_ATTR static uint16_t AggregatedDCycle;
-RTC_DATA_ATTR static TimerTime_t AggregatedLastTxDoneTime;
-RTC_DATA_ATTR static TimerTime_t AggregatedTimeOff;
+#define LINK_DRIFT_PER_HOUR                         4.0f
 
 /*!
- * Enables/Disables duty cycle management (Test only)
+ * Margin standard deviation above which the estimator asks for a LinkCheckAns, in dB
  */
-RTC_DATA_ATTR static bool DutyCycleOn;
+#define LINK_MAX_UNCERTAINTY                        3.0f
 
 /*!
- * Current channel index
+ * Minimum number of uplinks between two LinkCheckReq of the estimator
  */
-RTC_DATA_ATTR static uint8_t Channel;
+#define LINK_CHECK_MIN_UPLINKS                      8
 
 /*!
- * Current channel index
+ * Uplinks sent at the set power after a missed acknowledgement
  */
-RTC_DATA_ATTR static uint8_t LastTxChannel;
-
-/*!
- * Set to true, if the last uplink was a join request
- */
-RTC_DATA_ATTR static bool LastTxIsJoinRequest;
-
-/*!
- * Stores the time at LoRaMac initialization.
- *
- * \remark Used for the BACKOFF_DC computation.
- */
-RTC_DATA_ATTR static TimerTime_t LoRaMacInitializationTime = 0;
-
+#define POWER_HOLD_UPLINKS                          4
 
 /*!
  * LoRaMac internal states
@@ -292,125 +120,108 @@ enum eLoRaMacState {
 };
 
 /*!
- * LoRaMac internal state
- */
-RTC_DATA_ATTR uint32_t LoRaMacState = LORAMAC_IDLE;
-
-/*!
- * System time at last OnRadioTxDone
- */
-RTC_DATA_ATTR struct timeval LastTxSysTime;
-
-/*!
- * LoRaMac timer used to check the LoRaMacState (runs every second)
- */
-static TimerEvent_t MacStateCheckTimer;
-
-/*!
- * LoRaMac upper layer event functions
- */
-static LoRaMacPrimitives_t *LoRaMacPrimitives;
-
-/*!
- * LoRaMac upper layer callback functions
- */
-static LoRaMacCallback_t *LoRaMacCallbacks;
-
-/*!
- * Radio events function pointer
- */
-static RadioEvents_t RadioEvents;
-
-/*!
- * LoRaMac duty cycle delayed Tx timer
- */
-RTC_DATA_ATTR TimerEvent_t TxDelayedTimer;
-
-
-/*!
- * LoRaMac reception windows timers
- */
-RTC_DATA_ATTR TimerEvent_t RxWindowTimer1;
-RTC_DATA_ATTR TimerEvent_t RxWindowTimer2;
-
-/*!
- * LoRaMac reception windows delay
- * \remark normal frame: RxWindowXDelay = ReceiveDelayX - RADIO_WAKEUP_TIME
- *         join frame  : RxWindowXDelay = JoinAcceptDelayX - RADIO_WAKEUP_TIME
+ * Context used by the LoRaMacXxx API, kept across deep sleep
  */
-RTC_DATA_ATTR uint32_t RxWindow1Delay;
-RTC_DATA_ATTR uint32_t RxWindow2Delay;
+RTC_DATA_ATTR LoRaMacCtx_t LoRaMacDefaultCtx = {
+    .IsRxWindowsEnabled = true,
+    .AckTimeoutRetries = 1,
+    .AckTimeoutRetriesCounter = 1,
+};
 
 /*!
- * LoRaMac Rx windows configuration
+ * Join state of the default context, mirrored for Mcu.S and the sketches
  */
-RTC_DATA_ATTR RxConfigParams_t RxWindow1Config;
-RTC_DATA_ATTR RxConfigParams_t RxWindow2Config;
+RTC_DATA_ATTR bool IsLoRaMacNetworkJoined = false;
 
 /*!
- * Acknowledge timeout timer. Used for packet retransmissions.
+ * Context the MAC functions of this file work on. Bound by every API entry
+ * point, timer callback and radio event.
  */
-RTC_DATA_ATTR TimerEvent_t AckTimeoutTimer;
+static LoRaMacCtx_t *Ctx = &LoRaMacDefaultCtx;
 
 /*!
- * Number of trials to get a frame acknowledged
+ * Context that last started a radio operation, it receives the radio events
  */
-RTC_DATA_ATTR uint8_t AckTimeoutRetries = 1;
+static LoRaMacCtx_t *RadioOwner = &LoRaMacDefaultCtx;
 
 /*!
- * Number of trials to get a frame acknowledged
+ * Initialized contexts, the default one always has the first slot
  */
-RTC_DATA_ATTR uint8_t AckTimeoutRetriesCounter = 1;
+static LoRaMacCtx_t *Contexts[LORAMAC_MAX_CONTEXTS] = { &LoRaMacDefaultCtx };
 
 /*!
- * Indicates if the AckTimeout timer has expired or not
+ * Seed of the duty cycle record check
  */
-RTC_DATA_ATTR bool AckTimeoutRetry = false;
+#define LORAMAC_DC_RECORD_SEED                      0x44435243
 
 /*!
- * Last transmission time on air
+ * Band time credits and join start of a context, at the RTC time of the
+ * record. Kept in memory left alone by a reset, per context slot, so that a
+ * reset does not give back the duty cycle already spent.
  */
-RTC_DATA_ATTR TimerTime_t TxTimeOnAir = 0;
+typedef struct sLoRaMacDcRecord
+{
+    uint64_t Time;
+    uint64_t JoinStartTime;
+    int32_t TimeCredits[REGION_CTX_MAX_NB_BANDS];
+    uint32_t Region;
+    uint32_t Check;
+}LoRaMacDcRecord_t;
 
-/*!
- * Number of trials for the Join Request
- */
-RTC_DATA_ATTR uint8_t JoinRequestTrials;
+RTC_NOINIT_ATTR static LoRaMacDcRecord_t DcRecords[LORAMAC_MAX_CONTEXTS];
 
 /*!
- * Maximum number of trials for the Join Request
+ * Radio events, shared by the contexts and forwarded to RadioOwner
  */
-RTC_DATA_ATTR uint8_t MaxJoinRequestTrials;
+static RadioEvents_t RadioEvents;
 
 /*!
- * Structure to hold an MCPS indication data.
+ * Timer callbacks of a context slot
  */
-RTC_DATA_ATTR McpsIndication_t McpsIndication;
+typedef struct sLoRaMacCtxTimers
+{
+    void ( *MacStateCheck )( void );
+    void ( *TxDelayed )( void );
+    void ( *RxWindow1 )( void );
+    void ( *RxWindow2 )( void );
+    void ( *AckTimeout )( void );
+}LoRaMacCtxTimers_t;
 
 /*!
- * Structure to hold MCPS confirm data.
+ * \brief Makes a context the one the MAC, region and confirm queue work on
+ *
+ * \param [IN] ctx Context to bind
+ *
+ * \retval Previously bound context, to be bound again when done
  */
-RTC_DATA_ATTR McpsConfirm_t McpsConfirm;
+static LoRaMacCtx_t *BindContext( LoRaMacCtx_t *ctx );
 
 /*!
- * Structure to hold MLME indication data.
+ * \brief Checks if another context has a request running
+ *
+ * \param [IN] ctx Context asking for the radio
+ *
+ * \retval taken true when the request must return LORAMAC_STATUS_BUSY
  */
-RTC_DATA_ATTR MlmeIndication_t MlmeIndication;
+static bool IsRadioTaken( LoRaMacCtx_t *ctx );
 
 /*!
- * Structure to hold MLME confirm data.
+ * \brief Sets the join state of the bound context
+ *
+ * \param [IN] joined Join state
  */
-RTC_DATA_ATTR MlmeConfirm_t MlmeConfirm;
+static void SetNetworkJoined( bool joined );
 
 /*!
- * Holds the current rx window slot
+ * \brief Saves the band time credits and the join start of the context
  */
-RTC_DATA_ATTR LoRaMacRxSlot_t RxSlot;
+static void SaveDutyCycle( void );
 
 /*!
- * LoRaMac tx/rx operation state
+ * \brief Restores the band time credits and the join start of the context
+ *        saved before a reset, if any
  */
-RTC_DATA_ATTR LoRaMacFlags_t LoRaMacFlags;
+static void RestoreDutyCycle( void );
 
 /*!
  * \brief Function to be executed on Radio Tx Done event
@@ -443,6 +254,11 @@ static void OnRadioRxError( void );
  */
 static void OnRadioRxTimeout( void );
 
+/*!
+ * \brief Function executed on Radio CAD done event
+ */
+static void OnRadioCadDone( bool channelActivityDetected );
+
 
 /*!
  * \brief Function executed on Resend Frame timer event.
@@ -564,6 +380,10 @@ static bool ValidatePayloadLength( uint8_t lenN, int8_t datarate, uint8_t fOptsL
 /*!
  * \brief Decodes MAC commands in the fOpts field and in the payload
  *
+ * \remark The commands are parsed in a single pass driven by the
+ *         MacCommandsDown table. An unknown or truncated command stops the
+ *         processing before its payload is read.
+ *
  * \param [IN] payload      A pointer to the payload
  * \param [IN] macIndex     The index of the payload where the MAC commands start
  * \param [IN] commandsSize The size of the MAC commands
@@ -604,6 +424,22 @@ LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t *macHdr, LoRaMacFrameCtrl_t *fCtrl
  */
 static LoRaMacStatus_t ScheduleTx( void );
 
+/*!
+ * \brief Starts the listen before talk scan of the selected channels, the
+ *        frame is sent from \ref OnLbtDone
+ *
+ * \retval Status of the operation
+ */
+static LoRaMacStatus_t StartLbt( void );
+
+/*!
+ * \brief Function executed at the end of a listen before talk scan
+ *
+ * \param [IN] channelFree Set to true if a free channel was found
+ * \param [IN] channel     Free channel
+ */
+static void OnLbtDone( bool channelFree, uint8_t channel );
+
 /*
  * \brief Calculates the back-off time for the band of a channel.
  *
@@ -671,80 +507,459 @@ static bool IsFPortAllowed( uint8_t fPort );
  */
 static void OpenContinuousRx2Window( void );
 
-static void OnRadioTxDone( void )
-{
-    GetPhyParams_t getPhy;
-    PhyParam_t phyParam;
-    SetBandTxDoneParams_t txDone;
-    TimerTime_t curTime = TimerGetCurrentTime( );
-    gettimeofday (&LastTxSysTime, NULL);
+/*!
+ * \brief Returns the timing error used to size a RX window
+ *
+ * \param [IN] slot 0 for RX1, 1 for RX2
+ *
+ * \retval Timing error in ms
+ */
+static uint32_t RxTimingGetRxError( uint8_t slot );
 
-    if( LoRaMacDeviceClass != CLASS_C )
-    {
-        Radio.Sleep( );
-    }
-    else
-    {
-        OpenContinuousRx2Window( );
-    }
+/*!
+ * \brief Adds a preamble timing sample of the current RX window
+ *
+ * \param [IN] preambleTime Time the preamble of the received frame started
+ */
+static void RxTimingUpdate( TimerTime_t preambleTime );
 
-    // Setup timers
-    if ( IsRxWindowsEnabled == true ) {
-        TimerSetValue( &RxWindowTimer1, RxWindow1Delay );
-        TimerStart( &RxWindowTimer1 );
-        if ( LoRaMacDeviceClass != CLASS_C ) {
-            TimerSetValue( &RxWindowTimer2, RxWindow2Delay );
-            TimerStart( &RxWindowTimer2 );
-        }
-        if ( ( LoRaMacDeviceClass == CLASS_C ) || ( NodeAckRequested == true ) ) {
-            getPhy.Attribute = PHY_ACK_TIMEOUT;
-            phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-            TimerSetValue( &AckTimeoutTimer, RxWindow2Delay + phyParam.Value );
-            TimerStart( &AckTimeoutTimer );
-        }
-    } else {
-        McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_OK;
-        LoRaMacConfirmQueueSetStatusCmn( LORAMAC_EVENT_INFO_STATUS_RX2_TIMEOUT );
+/*!
+ * \brief Updates the retransmission history after a confirmed frame was sent
+ */
+static void RetryTxDone( void );
+
+/*!
+ * \brief Updates the retransmission history after an acknowledge
+ */
+static void RetryAckReceived( void );
+
+/*!
+ * \brief Updates the retransmission history after a missed acknowledge
+ */
+static void RetryAckTimeout( void );
+
+/*!
+ * \brief Returns the spacing between the end of RX2 and the retransmission
+ *
+ * \param [IN] ackTimeout Spacing drawn by the region, ACK_TIMEOUT +- ACK_TIMEOUT_RND
+ *
+ * \retval Spacing in ms
+ */
+static uint32_t RetryGetAckTimeout( uint32_t ackTimeout );
+
+/*!
+ * \brief Sets the datarate of the next retransmission
+ *
+ * \param [IN] trial Number of the transmission to prepare
+ *
+ * \retval [false: the delivery deadline cannot be met, true: ready to send]
+ */
+static bool RetryPrepare( uint8_t trial );
+
+/*!
+ * \brief Checks if a retransmission must avoid a channel
+ *
+ * \param [IN] channel Channel selected by the region
+ *
+ * \retval [false: channel usable, true: draw another channel]
+ */
+static bool RetryAvoidChannel( uint8_t channel );
+
+/*!
+ * \brief Adds the SNR of a received downlink to the link estimator
+ *
+ * \param [IN] snr Downlink SNR in dB
+ */
+static void LinkUpdateSnr( int8_t snr );
+
+/*!
+ * \brief Adds a LinkCheckAns to the link estimator
+ *
+ * \param [IN] margin     Demodulation margin of the uplink in dB
+ * \param [IN] nbGateways Number of gateways which received the uplink
+ */
+static void LinkUpdateMargin( uint8_t margin, uint8_t nbGateways );
+
+/*!
+ * \brief Estimates the uplink margin at a datarate
+ *
+ * \param [IN]  datarate Uplink datarate
+ * \param [OUT] margin   Margin in dB
+ * \param [OUT] variance Variance of the margin in dB^2
+ *
+ * \retval [false: no LinkCheckAns yet, true: estimate valid]
+ */
+static bool LinkGetMargin( int8_t datarate, float *margin, float *variance );
+
+/*!
+ * \brief Returns the uplink datarate chosen by the link estimator
+ *
+ * \param [IN] datarate    Datarate requested by the application
+ * \param [IN] payloadSize Size of the application payload
+ *
+ * \retval Datarate to use
+ */
+static int8_t LinkGetDatarate( int8_t datarate, uint16_t payloadSize );
+
+/*!
+ * \brief Adds a LinkCheckReq to the next uplink if the estimate is too uncertain
+ */
+static void LinkScheduleCheck( void );
 
-        if ( LoRaMacFlags.Value == 0 ) {
-            LoRaMacFlags.Bits.McpsReq = 1;
+/*!
+ * \brief Returns the one sided normal quantile of the estimator target error rate
+ *
+ * \retval Quantile x100
+ */
+static uint16_t LinkQuantile( void );
+
+/*!
+ * \brief Returns the TX power index steps the next uplink can go below the set power
+ *
+ * \retval Steps, 0 to send at the set power
+ */
+static int8_t PowerGetBackoff( void );
+
+/*!
+ * \brief Accounts the radio energy saved by an uplink sent below the set power
+ *
+ * \param [IN] txPower Output power of the uplink in dBm
+ */
+static void PowerTxDone( int8_t txPower );
+
+static LoRaMacCtx_t *BindContext( LoRaMacCtx_t *ctx )
+{
+    LoRaMacCtx_t *caller = Ctx;
+
+    Ctx = ctx;
+    RegionSetContext( &ctx->Region );
+    LoRaMacConfirmQueueSetContext( &ctx->ConfirmQueue );
+    return caller;
+}
+
+static bool IsRadioTaken( LoRaMacCtx_t *ctx )
+{
+    uint8_t slot;
+
+    // A context waiting out its duty cycle starts the radio from its timer,
+    // it holds the radio as much as one transmitting or receiving
+    for ( slot = 0; slot < LORAMAC_MAX_CONTEXTS; slot++ ) {
+        if ( ( Contexts[slot] != NULL ) && ( Contexts[slot] != ctx ) &&
+             ( Contexts[slot]->LoRaMacState != LORAMAC_IDLE ) ) {
+            return true;
         }
-        LoRaMacFlags.Bits.MacDone = 1;
     }
+    return false;
+}
 
-    // Verify if the last uplink was a join request
-    if ( ( LoRaMacFlags.Bits.MlmeReq == 1 ) && ( MlmeConfirm.MlmeRequest == MLME_JOIN ) ) {
-        LastTxIsJoinRequest = true;
-    } else {
-        LastTxIsJoinRequest = false;
+static void SetNetworkJoined( bool joined )
+{
+    Ctx->NetworkJoined = joined;
+    if ( Ctx == &LoRaMacDefaultCtx ) {
+        IsLoRaMacNetworkJoined = joined;
     }
-
-    // Store last Tx channel
-    LastTxChannel = Channel;
-    // Update last tx done time for the current channel
-    txDone.Channel = Channel;
-    txDone.Joined = IsLoRaMacNetworkJoined;
-    txDone.LastTxDoneTime = curTime;
-    RegionSetBandTxDone( LoRaMacRegion, &txDone );
-    // Update Aggregated last tx done time
-    AggregatedLastTxDoneTime = curTime;
-
-    if ( NodeAckRequested == false ) {
-        McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_OK;
-        ChannelsNbRepCounter++;
+    if ( joined == true ) {
+        Ctx->JoinStartTime = 0;
+        SaveDutyCycle( );
     }
 }
 
-static void PrepareRxDoneAbort( void )
+static uint32_t GetDutyCycleCheck( LoRaMacDcRecord_t *record )
 {
-    LoRaMacState |= LORAMAC_RX_ABORT;
+    uint8_t *data = ( uint8_t * )record;
+    uint32_t check = LORAMAC_DC_RECORD_SEED;
+    uint16_t i;
 
-    if ( NodeAckRequested ) {
-        OnAckTimeoutTimerEvent( );
+    // FNV-1a over the record, check excluded
+    for ( i = 0; i < offsetof( LoRaMacDcRecord_t, Check ); i++ ) {
+        check = ( check ^ data[i] ) * 16777619;
     }
+    return check;
+}
 
-    LoRaMacFlags.Bits.McpsInd = 1;
-    LoRaMacFlags.Bits.MacDone = 1;
+static LoRaMacDcRecord_t *GetDutyCycleRecord( void )
+{
+    uint8_t slot;
+
+    for ( slot = 0; slot < LORAMAC_MAX_CONTEXTS; slot++ ) {
+        if ( Contexts[slot] == Ctx ) {
+            return &DcRecords[slot];
+        }
+    }
+    return NULL;
+}
+
+static void SaveDutyCycle( void )
+{
+    LoRaMacDcRecord_t *record = GetDutyCycleRecord( );
+    uint8_t i;
+
+    if ( record == NULL ) {
+        return;
+    }
+    // Bring the credits to now, the record time
+    RegionCommonUpdateBandCredits( Ctx->Region.Bands, REGION_CTX_MAX_NB_BANDS );
+
+    record->Time = LpmGetRtcTime( );
+    record->JoinStartTime = Ctx->JoinStartTime;
+    for ( i = 0; i < REGION_CTX_MAX_NB_BANDS; i++ ) {
+        record->TimeCredits[i] = Ctx->Region.Bands[i].TimeCredits;
+    }
+    record->Region = Ctx->LoRaMacRegion;
+    record->Check = GetDutyCycleCheck( record );
+}
+
+static void RestoreDutyCycle( void )
+{
+    LoRaMacDcRecord_t *record = GetDutyCycleRecord( );
+    uint8_t i;
+
+    // A power-on restarts the RTC time, the record is then either invalid or
+    // ahead of it
+    if ( ( record == NULL ) || ( record->Check != GetDutyCycleCheck( record ) ) ||
+         ( record->Region != Ctx->LoRaMacRegion ) || ( record->Time > LpmGetRtcTime( ) ) ) {
+        return;
+    }
+    Ctx->JoinStartTime = record->JoinStartTime;
+    for ( i = 0; i < REGION_CTX_MAX_NB_BANDS; i++ ) {
+        Ctx->Region.Bands[i].TimeCredits = record->TimeCredits[i];
+        Ctx->Region.Bands[i].LastBandUpdateTime = record->Time;
+    }
+}
+
+#ifdef TIMER_EVENT_CONTEXT
+/*!
+ * The timers carry their context, one set of callbacks binds it around the
+ * MAC handler for any number of contexts.
+ */
+#define LORAMAC_CTX_TIMER_CALLBACK( handler )                                 \
+    static void handler##Ctx( void )                                          \
+    {                                                                         \
+        LoRaMacCtx_t *caller = BindContext( TimerGetContext( ) );             \
+        handler( );                                                           \
+        BindContext( caller );                                                \
+    }
+
+#if LORAMAC_MAX_CONTEXTS < 1
+#error "LORAMAC_MAX_CONTEXTS must be 1 or more"
+#endif
+
+LORAMAC_CTX_TIMER_CALLBACK( OnMacStateCheckTimerEvent )
+LORAMAC_CTX_TIMER_CALLBACK( OnTxDelayedTimerEvent )
+LORAMAC_CTX_TIMER_CALLBACK( OnRxWindow1TimerEvent )
+LORAMAC_CTX_TIMER_CALLBACK( OnRxWindow2TimerEvent )
+LORAMAC_CTX_TIMER_CALLBACK( OnAckTimeoutTimerEvent )
+
+static const LoRaMacCtxTimers_t CtxTimers[1] =
+{
+    { OnMacStateCheckTimerEventCtx, OnTxDelayedTimerEventCtx,
+      OnRxWindow1TimerEventCtx, OnRxWindow2TimerEventCtx,
+      OnAckTimeoutTimerEventCtx },
+};
+
+#define LORAMAC_CTX_TIMERS_SLOT( slot )             0
+#else
+/*!
+ * Timer callbacks take no argument, each context slot has its own set that
+ * binds its context around the MAC handler.
+ */
+#define LORAMAC_CTX_TIMER_CALLBACK( handler, slot )                           \
+    static void handler##slot( void )                                         \
+    {                                                                         \
+        LoRaMacCtx_t *caller = BindContext( Contexts[slot] );                 \
+        handler( );                                                           \
+        BindContext( caller );                                                \
+    }
+
+#define LORAMAC_CTX_TIMER_CALLBACKS( slot )                                   \
+    LORAMAC_CTX_TIMER_CALLBACK( OnMacStateCheckTimerEvent, slot )             \
+    LORAMAC_CTX_TIMER_CALLBACK( OnTxDelayedTimerEvent, slot )                 \
+    LORAMAC_CTX_TIMER_CALLBACK( OnRxWindow1TimerEvent, slot )                 \
+    LORAMAC_CTX_TIMER_CALLBACK( OnRxWindow2TimerEvent, slot )                 \
+    LORAMAC_CTX_TIMER_CALLBACK( OnAckTimeoutTimerEvent, slot )
+
+#define LORAMAC_CTX_TIMERS( slot )                                            \
+    { OnMacStateCheckTimerEvent##slot, OnTxDelayedTimerEvent##slot,           \
+      OnRxWindow1TimerEvent##slot, OnRxWindow2TimerEvent##slot,               \
+      OnAckTimeoutTimerEvent##slot }
+
+#if ( LORAMAC_MAX_CONTEXTS < 1 ) || ( LORAMAC_MAX_CONTEXTS > 4 )
+#error "LORAMAC_MAX_CONTEXTS must be 1 to 4, add timer callbacks for more"
+#endif
+
+LORAMAC_CTX_TIMER_CALLBACKS( 0 )
+#if LORAMAC_MAX_CONTEXTS > 1
+LORAMAC_CTX_TIMER_CALLBACKS( 1 )
+#endif
+#if LORAMAC_MAX_CONTEXTS > 2
+LORAMAC_CTX_TIMER_CALLBACKS( 2 )
+#endif
+#if LORAMAC_MAX_CONTEXTS > 3
+LORAMAC_CTX_TIMER_CALLBACKS( 3 )
+#endif
+
+static const LoRaMacCtxTimers_t CtxTimers[LORAMAC_MAX_CONTEXTS] =
+{
+    LORAMAC_CTX_TIMERS( 0 ),
+#if LORAMAC_MAX_CONTEXTS > 1
+    LORAMAC_CTX_TIMERS( 1 ),
+#endif
+#if LORAMAC_MAX_CONTEXTS > 2
+    LORAMAC_CTX_TIMERS( 2 ),
+#endif
+#if LORAMAC_MAX_CONTEXTS > 3
+    LORAMAC_CTX_TIMERS( 3 ),
+#endif
+};
+
+#define LORAMAC_CTX_TIMERS_SLOT( slot )             ( slot )
+#endif
+
+/*!
+ * Radio events go to the context that started the radio operation
+ */
+static void OnRadioTxDoneEvent( void )
+{
+    LoRaMacCtx_t *caller = BindContext( RadioOwner );
+    OnRadioTxDone( );
+    BindContext( caller );
+}
+
+static void OnRadioRxDoneEvent( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
+{
+    LoRaMacCtx_t *caller = BindContext( RadioOwner );
+    OnRadioRxDone( payload, size, rssi, snr );
+    BindContext( caller );
+}
+
+static void OnRadioTxTimeoutEvent( void )
+{
+    LoRaMacCtx_t *caller = BindContext( RadioOwner );
+    OnRadioTxTimeout( );
+    BindContext( caller );
+}
+
+static void OnRadioRxErrorEvent( void )
+{
+    LoRaMacCtx_t *caller = BindContext( RadioOwner );
+    OnRadioRxError( );
+    BindContext( caller );
+}
+
+static void OnRadioRxTimeoutEvent( void )
+{
+    LoRaMacCtx_t *caller = BindContext( RadioOwner );
+    OnRadioRxTimeout( );
+    BindContext( caller );
+}
+
+static void OnRadioCadDoneEvent( bool channelActivityDetected )
+{
+    LoRaMacCtx_t *caller = BindContext( RadioOwner );
+    OnRadioCadDone( channelActivityDetected );
+    BindContext( caller );
+}
+
+static void OnLbtDoneEvent( bool channelFree, uint8_t channel )
+{
+    LoRaMacCtx_t *caller = BindContext( RadioOwner );
+    OnLbtDone( channelFree, channel );
+    BindContext( caller );
+}
+
+static void OnRadioTxDone( void )
+{
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+    SetBandTxDoneParams_t txDone;
+    uint32_t ackTimeout;
+    TimerTime_t curTime = TimerGetCurrentTime( );
+    struct timeval timeOnAir = { Ctx->TxTimeOnAir / 1000, ( Ctx->TxTimeOnAir % 1000 ) * 1000 };
+    struct timeval txEndSysTime = add_timeval (Ctx->TxStartSysTime, timeOnAir);
+
+    // The TX done interrupt waits for Radio.IrqProcess, the end of the uplink
+    // is known better from its start and time on air
+    gettimeofday (&Ctx->LastTxSysTime, NULL);
+    if ( timercmp (&txEndSysTime, &Ctx->LastTxSysTime, <) ) {
+        Ctx->LastTxSysTime = txEndSysTime;
+    }
+
+    TRACE( TRACE_EVENT_MAC, TRACE_MAC_TX_DONE, Ctx->LoRaMacState );
+
+    if( Ctx->LoRaMacDeviceClass != CLASS_C )
+    {
+        Radio.Sleep( );
+    }
+    else
+    {
+        OpenContinuousRx2Window( );
+    }
+
+    // Setup timers
+    if ( Ctx->IsRxWindowsEnabled == true ) {
+        TimerSetValue( &Ctx->RxWindowTimer1, Ctx->RxWindow1Delay );
+        TimerStart( &Ctx->RxWindowTimer1 );
+        TRACE( TRACE_EVENT_TIMER_START, TRACE_TIMER_RX_WINDOW_1, Ctx->RxWindow1Delay );
+        if ( Ctx->LoRaMacDeviceClass != CLASS_C ) {
+            TimerSetValue( &Ctx->RxWindowTimer2, Ctx->RxWindow2Delay );
+            TimerStart( &Ctx->RxWindowTimer2 );
+            TRACE( TRACE_EVENT_TIMER_START, TRACE_TIMER_RX_WINDOW_2, Ctx->RxWindow2Delay );
+        }
+        if ( ( Ctx->LoRaMacDeviceClass == CLASS_C ) || ( Ctx->NodeAckRequested == true ) ) {
+            getPhy.Attribute = PHY_ACK_TIMEOUT;
+            phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+            ackTimeout = RetryGetAckTimeout( phyParam.Value );
+            TimerSetValue( &Ctx->AckTimeoutTimer, Ctx->RxWindow2Delay + ackTimeout );
+            TimerStart( &Ctx->AckTimeoutTimer );
+            TRACE( TRACE_EVENT_TIMER_START, TRACE_TIMER_ACK_TIMEOUT, Ctx->RxWindow2Delay + ackTimeout );
+        }
+    } else {
+        Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_OK;
+        LoRaMacConfirmQueueSetStatusCmn( LORAMAC_EVENT_INFO_STATUS_RX2_TIMEOUT );
+
+        if ( Ctx->LoRaMacFlags.Value == 0 ) {
+            Ctx->LoRaMacFlags.Bits.McpsReq = 1;
+        }
+        Ctx->LoRaMacFlags.Bits.MacDone = 1;
+    }
+
+    // Verify if the last uplink was a join request
+    if ( ( Ctx->LoRaMacFlags.Bits.MlmeReq == 1 ) && ( LoRaMacConfirmQueueIsCmdActive( MLME_JOIN ) == true ) ) {
+        Ctx->LastTxIsJoinRequest = true;
+    } else {
+        Ctx->LastTxIsJoinRequest = false;
+    }
+
+    // Store last Tx channel
+    Ctx->LastTxChannel = Ctx->Channel;
+    // Charge the band of the channel with the back-off of this frame
+    CalculateBackOff( Ctx->Channel );
+    txDone.Channel = Ctx->Channel;
+    txDone.Joined = Ctx->NetworkJoined;
+    txDone.LastTxDoneTime = curTime;
+    txDone.LastTxAirTime = Ctx->TxTimeOnAir;
+    RegionSetBandTxDone( Ctx->LoRaMacRegion, &txDone );
+    SaveDutyCycle( );
+    // Update Aggregated last tx done time
+    Ctx->AggregatedLastTxDoneTime = curTime;
+    RetryTxDone( );
+
+    if ( Ctx->NodeAckRequested == false ) {
+        Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_OK;
+        Ctx->ChannelsNbRepCounter++;
+    }
+}
+
+static void PrepareRxDoneAbort( void )
+{
+    Ctx->LoRaMacState |= LORAMAC_RX_ABORT;
+
+    if ( Ctx->NodeAckRequested ) {
+        OnAckTimeoutTimerEvent( );
+    }
+
+    Ctx->LoRaMacFlags.Bits.McpsInd = 1;
+    Ctx->LoRaMacFlags.Bits.MacDone = 1;
 
     // Trig OnMacCheckTimerEvent call as soon as possible
     OnMacStateCheckTimerEvent();
@@ -773,83 +988,93 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
     uint32_t downLinkCounter = 0;
 
     MulticastParams_t *curMulticastParams = NULL;
-    uint8_t *nwkSKey = LoRaMacNwkSKey;
-    uint8_t *appSKey = LoRaMacAppSKey;
+    uint8_t *nwkSKey = Ctx->LoRaMacNwkSKey;
+    uint8_t *appSKey = Ctx->LoRaMacAppSKey;
 
     uint8_t multicast = 0;
 
     bool isMicOk = false;
 
-    McpsConfirm.AckReceived = false;
-    McpsIndication.Rssi = rssi;
-    McpsIndication.Snr = snr;
-    McpsIndication.RxSlot = RxSlot;
-    McpsIndication.Port = 0;
-    McpsIndication.Multicast = 0;
-    McpsIndication.FramePending = 0;
-    McpsIndication.Buffer = NULL;
-    McpsIndication.BufferSize = 0;
-    McpsIndication.RxData = false;
-    McpsIndication.AckReceived = false;
-    McpsIndication.DownLinkCounter = 0;
-    McpsIndication.McpsIndication = MCPS_UNCONFIRMED;
-    McpsIndication.DeviceTimeAnsReceived = false;
+    // The preamble started one time on air before the RxDone event. The
+    // event is handled in the main loop after the radio interrupt, this
+    // processing latency is part of the learned offset and only its spread
+    // widens the windows.
+    RadioModems_t modem = ( Ctx->RxSlot == RX_SLOT_WIN_1 ) ? Ctx->RxWindow1Config.Modem : Ctx->RxWindow2Config.Modem;
+    TimerTime_t preambleTime = TimerGetCurrentTime( ) - Radio.TimeOnAir( modem, size );
+
+    TRACE( TRACE_EVENT_MAC, TRACE_MAC_RX_DONE, Ctx->LoRaMacState );
+
+    Ctx->McpsConfirm.AckReceived = false;
+    Ctx->McpsIndication.Rssi = rssi;
+    Ctx->McpsIndication.Snr = snr;
+    Ctx->McpsIndication.RxSlot = Ctx->RxSlot;
+    Ctx->McpsIndication.Port = 0;
+    Ctx->McpsIndication.Multicast = 0;
+    Ctx->McpsIndication.FramePending = 0;
+    Ctx->McpsIndication.Buffer = NULL;
+    Ctx->McpsIndication.BufferSize = 0;
+    Ctx->McpsIndication.RxData = false;
+    Ctx->McpsIndication.AckReceived = false;
+    Ctx->McpsIndication.DownLinkCounter = 0;
+    Ctx->McpsIndication.McpsIndication = MCPS_UNCONFIRMED;
+    Ctx->McpsIndication.DeviceTimeAnsReceived = false;
 
     Radio.Sleep ();
-    TimerStop (&RxWindowTimer2);
+    TimerStop (&Ctx->RxWindowTimer2);
 
     macHdr.Value = payload[pktHeaderLen++];
     switch ( macHdr.Bits.MType ) {
         case FRAME_TYPE_JOIN_ACCEPT:
-            if ( IsLoRaMacNetworkJoined == true ) {
-                McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
+            if ( Ctx->NetworkJoined == true ) {
+                Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
                 PrepareRxDoneAbort( );
                 return;
             }
-            LoRaMacJoinDecrypt( payload + 1, size - 1, LoRaMacAppKey, LoRaMacRxPayload + 1 );
+            LoRaMacJoinDecrypt( payload + 1, size - 1, Ctx->LoRaMacAppKey, Ctx->LoRaMacRxPayload + 1 );
 
-            LoRaMacRxPayload[0] = macHdr.Value;
+            Ctx->LoRaMacRxPayload[0] = macHdr.Value;
 
-            LoRaMacJoinComputeMic( LoRaMacRxPayload, size - LORAMAC_MFR_LEN, LoRaMacAppKey, &mic );
+            LoRaMacJoinComputeMic( Ctx->LoRaMacRxPayload, size - LORAMAC_MFR_LEN, Ctx->LoRaMacAppKey, &mic );
 
-            micRx |= ( uint32_t )LoRaMacRxPayload[size - LORAMAC_MFR_LEN];
-            micRx |= ( ( uint32_t )LoRaMacRxPayload[size - LORAMAC_MFR_LEN + 1] << 8 );
-            micRx |= ( ( uint32_t )LoRaMacRxPayload[size - LORAMAC_MFR_LEN + 2] << 16 );
-            micRx |= ( ( uint32_t )LoRaMacRxPayload[size - LORAMAC_MFR_LEN + 3] << 24 );
+            micRx |= ( uint32_t )Ctx->LoRaMacRxPayload[size - LORAMAC_MFR_LEN];
+            micRx |= ( ( uint32_t )Ctx->LoRaMacRxPayload[size - LORAMAC_MFR_LEN + 1] << 8 );
+            micRx |= ( ( uint32_t )Ctx->LoRaMacRxPayload[size - LORAMAC_MFR_LEN + 2] << 16 );
+            micRx |= ( ( uint32_t )Ctx->LoRaMacRxPayload[size - LORAMAC_MFR_LEN + 3] << 24 );
             if( LoRaMacConfirmQueueIsCmdActive( MLME_JOIN ) == true )
             {
                 if( micRx == mic ) {
-                    LoRaMacJoinComputeSKeys( LoRaMacAppKey, LoRaMacRxPayload + 1, LoRaMacDevNonce, LoRaMacNwkSKey, LoRaMacAppSKey );
+                    LoRaMacJoinComputeSKeys( Ctx->LoRaMacAppKey, Ctx->LoRaMacRxPayload + 1, Ctx->LoRaMacDevNonce, Ctx->LoRaMacNwkSKey, Ctx->LoRaMacAppSKey );
 
-                    LoRaMacNetID = ( uint32_t )LoRaMacRxPayload[4];
-                    LoRaMacNetID |= ( ( uint32_t )LoRaMacRxPayload[5] << 8 );
-                    LoRaMacNetID |= ( ( uint32_t )LoRaMacRxPayload[6] << 16 );
+                    Ctx->LoRaMacNetID = ( uint32_t )Ctx->LoRaMacRxPayload[4];
+                    Ctx->LoRaMacNetID |= ( ( uint32_t )Ctx->LoRaMacRxPayload[5] << 8 );
+                    Ctx->LoRaMacNetID |= ( ( uint32_t )Ctx->LoRaMacRxPayload[6] << 16 );
 
-                    LoRaMacDevAddr = ( uint32_t )LoRaMacRxPayload[7];
-                    LoRaMacDevAddr |= ( ( uint32_t )LoRaMacRxPayload[8] << 8 );
-                    LoRaMacDevAddr |= ( ( uint32_t )LoRaMacRxPayload[9] << 16 );
-                    LoRaMacDevAddr |= ( ( uint32_t )LoRaMacRxPayload[10] << 24 );
+                    Ctx->LoRaMacDevAddr = ( uint32_t )Ctx->LoRaMacRxPayload[7];
+                    Ctx->LoRaMacDevAddr |= ( ( uint32_t )Ctx->LoRaMacRxPayload[8] << 8 );
+                    Ctx->LoRaMacDevAddr |= ( ( uint32_t )Ctx->LoRaMacRxPayload[9] << 16 );
+                    Ctx->LoRaMacDevAddr |= ( ( uint32_t )Ctx->LoRaMacRxPayload[10] << 24 );
 
                     // DLSettings
-                    LoRaMacParams.Rx1DrOffset = ( LoRaMacRxPayload[11] >> 4 ) & 0x07;
-                    LoRaMacParams.Rx2Channel.Datarate = LoRaMacRxPayload[11] & 0x0F;
+                    Ctx->LoRaMacParams.Rx1DrOffset = ( Ctx->LoRaMacRxPayload[11] >> 4 ) & 0x07;
+                    Ctx->LoRaMacParams.Rx2Channel.Datarate = Ctx->LoRaMacRxPayload[11] & 0x0F;
 
                     // RxDelay
-                    LoRaMacParams.ReceiveDelay1 = ( LoRaMacRxPayload[12] & 0x0F );
-                    if( LoRaMacParams.ReceiveDelay1 == 0 ) {
-                        LoRaMacParams.ReceiveDelay1 = 1;
+                    Ctx->LoRaMacParams.ReceiveDelay1 = ( Ctx->LoRaMacRxPayload[12] & 0x0F );
+                    if( Ctx->LoRaMacParams.ReceiveDelay1 == 0 ) {
+                        Ctx->LoRaMacParams.ReceiveDelay1 = 1;
                     }
-                    LoRaMacParams.ReceiveDelay1 *= 1000;
-                    LoRaMacParams.ReceiveDelay2 = LoRaMacParams.ReceiveDelay1 + 1000;
+                    Ctx->LoRaMacParams.ReceiveDelay1 *= 1000;
+                    Ctx->LoRaMacParams.ReceiveDelay2 = Ctx->LoRaMacParams.ReceiveDelay1 + 1000;
                     // Apply CF list
-                    applyCFList.Payload = &LoRaMacRxPayload[13];
+                    applyCFList.Payload = &Ctx->LoRaMacRxPayload[13];
                     // Size of the regular payload is 12. Plus 1 byte MHDR and 4 bytes MIC
                     applyCFList.Size = size - 17;
 
-                    RegionApplyCFList( LoRaMacRegion, &applyCFList );
+                    RegionApplyCFList( Ctx->LoRaMacRegion, &applyCFList );
+                    RegionJoinAccepted( Ctx->LoRaMacRegion, Ctx->LastTxChannel );
 
                     LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_JOIN );
-                    IsLoRaMacNetworkJoined = true;
+                    SetNetworkJoined( true );
 
                 	//Joined save its DR using LoRaMacParams.ChannelsDatarate, if set it will be default
                 	//LoRaMacParams.ChannelsDatarate = LoRaMacParamsDefaults.ChannelsDatarate;
@@ -861,17 +1086,17 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
         case FRAME_TYPE_DATA_CONFIRMED_DOWN:
         case FRAME_TYPE_DATA_UNCONFIRMED_DOWN: {
             // Check if the received payload size is valid
-            getPhy.UplinkDwellTime = LoRaMacParams.DownlinkDwellTime;
-            getPhy.Datarate = McpsIndication.RxDatarate;
+            getPhy.UplinkDwellTime = Ctx->LoRaMacParams.DownlinkDwellTime;
+            getPhy.Datarate = Ctx->McpsIndication.RxDatarate;
             getPhy.Attribute = PHY_MAX_PAYLOAD;
 
             // Get the maximum payload length
-            if( LoRaMacParams.RepeaterSupport == true ) {
+            if( Ctx->LoRaMacParams.RepeaterSupport == true ) {
                 getPhy.Attribute = PHY_MAX_PAYLOAD_REPEATER;
             }
-            phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
+            phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
             if ( MAX( 0, ( int16_t )( ( int16_t )size - ( int16_t )LORA_MAC_FRMPAYLOAD_OVERHEAD ) ) > phyParam.Value ) {
-                McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
+                Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
                 PrepareRxDoneAbort( );
                 return;
             }
@@ -883,8 +1108,8 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
 
             fCtrl.Value = payload[pktHeaderLen++];
 
-            if ( address != LoRaMacDevAddr ) {
-                curMulticastParams = MulticastChannels;
+            if ( address != Ctx->LoRaMacDevAddr ) {
+                curMulticastParams = Ctx->MulticastChannels;
                 while ( curMulticastParams != NULL ) {
                     if ( address == curMulticastParams->Address ) {
                         multicast = 1;
@@ -897,7 +1122,7 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
                 }
                 if ( multicast == 0 ) {
                     // We are not the destination of this frame.
-                    McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_ADDRESS_FAIL;
+                    Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_ADDRESS_FAIL;
                     PrepareRxDoneAbort( );
                     return;
                 }
@@ -905,15 +1130,15 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
                         ( fCtrl.Bits.Ack == 1 ) ||
                         ( fCtrl.Bits.AdrAckReq == 1 ) ) {
                     // Wrong multicast message format. Refer to chapter 11.2.2 of the specification
-                    McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_MULTICAST_FAIL;
+                    Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_MULTICAST_FAIL;
                     PrepareRxDoneAbort( );
                     return;
                 }
             } else {
                 multicast = 0;
-                nwkSKey = LoRaMacNwkSKey;
-                appSKey = LoRaMacAppSKey;
-                downLinkCounter = DownLinkCounter;
+                nwkSKey = Ctx->LoRaMacNwkSKey;
+                appSKey = Ctx->LoRaMacAppSKey;
+                downLinkCounter = Ctx->DownLinkCounter;
             }
 
             sequenceCounter = ( uint16_t )payload[pktHeaderLen++];
@@ -946,82 +1171,104 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
 
             // Check for a the maximum allowed counter difference
             getPhy.Attribute = PHY_MAX_FCNT_GAP;
-            phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
+            phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
             if ( sequenceCounterDiff >= phyParam.Value ) {
-                McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_DOWNLINK_TOO_MANY_FRAMES_LOSS;
-                McpsIndication.DownLinkCounter = downLinkCounter;
+                Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_DOWNLINK_TOO_MANY_FRAMES_LOSS;
+                Ctx->McpsIndication.DownLinkCounter = downLinkCounter;
                 PrepareRxDoneAbort( );
                 return;
             }
 
             if ( isMicOk == true ) {
-                McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_OK;
-                McpsIndication.Multicast = multicast;
-                McpsIndication.FramePending = fCtrl.Bits.FPending;
-                McpsIndication.Buffer = NULL;
-                McpsIndication.BufferSize = 0;
-                McpsIndication.DownLinkCounter = downLinkCounter;
-                McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_OK;
+                Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_OK;
+                Ctx->McpsIndication.Multicast = multicast;
+                Ctx->McpsIndication.FramePending = fCtrl.Bits.FPending;
+                Ctx->McpsIndication.Buffer = NULL;
+                Ctx->McpsIndication.BufferSize = 0;
+                Ctx->McpsIndication.DownLinkCounter = downLinkCounter;
+                Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_OK;
+
+                Ctx->AdrAckCounter = 0;
+                Ctx->MacCommandsBufferToRepeatIndex = 0;
+
+                if ( Ctx->AdrStatus.BackoffActive == true ) {
+                    // The network answered again, close the backoff episode
+                    Ctx->AdrStatus.BackoffActive = false;
+                    Ctx->AdrStatus.EpisodeCount++;
+                    Ctx->AdrStatus.LastRecoveryTime = TimerGetElapsedTime( Ctx->AdrStatus.EpisodeStartTime );
+                    Ctx->AdrStatus.LastRecoveryAirTime = Ctx->AdrStatus.EpisodeAirTime;
+                    Ctx->AdrStatus.LastRecoveryUplinks = Ctx->AdrStatus.EpisodeUplinks;
+                    Ctx->AdrStatus.LastRecoveryBackoffSteps = Ctx->AdrStatus.EpisodeBackoffSteps;
+                }
 
-                AdrAckCounter = 0;
-                MacCommandsBufferToRepeatIndex = 0;
+                // The windows are sized in LoRa symbols, FSK downlinks are not sampled
+                if ( ( multicast == 0 ) && ( modem == MODEM_LORA ) ) {
+                    RxTimingUpdate( preambleTime );
+                }
+                LinkUpdateSnr( snr );
+                Ctx->Statistics.Downlinks[( Ctx->RxSlot == RX_SLOT_WIN_1 ) ? 0 : 1]++;
 
                 // Update 32 bits downlink counter
                 if ( multicast == 1 ) {
-                    McpsIndication.McpsIndication = MCPS_MULTICAST;
+                    Ctx->McpsIndication.McpsIndication = MCPS_MULTICAST;
 
                     if ( ( curMulticastParams->DownLinkCounter == downLinkCounter ) &&
                          ( curMulticastParams->DownLinkCounter != 0 ) ) {
-                        McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_DOWNLINK_REPEATED;
-                        McpsIndication.DownLinkCounter = downLinkCounter;
+                        Ctx->Statistics.DuplicateFrames++;
+                        Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_DOWNLINK_REPEATED;
+                        Ctx->McpsIndication.DownLinkCounter = downLinkCounter;
                         PrepareRxDoneAbort( );
                         return;
                     }
                     curMulticastParams->DownLinkCounter = downLinkCounter;
                 } else {
                     if ( macHdr.Bits.MType == FRAME_TYPE_DATA_CONFIRMED_DOWN ) {
-                        SrvAckRequested = true;
-                        McpsIndication.McpsIndication = MCPS_CONFIRMED;
+                        Ctx->SrvAckRequested = true;
+                        Ctx->McpsIndication.McpsIndication = MCPS_CONFIRMED;
 
-                        if ( ( DownLinkCounter == downLinkCounter ) &&
-                             ( DownLinkCounter != 0 ) ) {
+                        if ( ( Ctx->DownLinkCounter == downLinkCounter ) &&
+                             ( Ctx->DownLinkCounter != 0 ) ) {
                             // Duplicated confirmed downlink. Skip indication.
                             // In this case, the MAC layer shall accept the MAC commands
                             // which are included in the downlink retransmission.
                             // It should not provide the same frame to the application
                             // layer again.
-                            LoRaMacFlags.Bits.McpsIndSkip = 1;
+                            Ctx->Statistics.DuplicateFrames++;
+                            Ctx->LoRaMacFlags.Bits.McpsIndSkip = 1;
                         }
                     } else {
-                        SrvAckRequested = false;
-                        McpsIndication.McpsIndication = MCPS_UNCONFIRMED;
-
-                        if ( ( DownLinkCounter == downLinkCounter ) &&
-                             ( DownLinkCounter != 0 ) ) {
-                            McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_DOWNLINK_REPEATED;
-                            McpsIndication.DownLinkCounter = downLinkCounter;
+                        Ctx->SrvAckRequested = false;
+                        Ctx->McpsIndication.McpsIndication = MCPS_UNCONFIRMED;
+
+                        if ( ( Ctx->DownLinkCounter == downLinkCounter ) &&
+                             ( Ctx->DownLinkCounter != 0 ) ) {
+                            Ctx->Statistics.DuplicateFrames++;
+                            Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_DOWNLINK_REPEATED;
+                            Ctx->McpsIndication.DownLinkCounter = downLinkCounter;
                             PrepareRxDoneAbort( );
                             return;
                         }
                     }
-                    DownLinkCounter = downLinkCounter;
+                    Ctx->DownLinkCounter = downLinkCounter;
                 }
 
                 // This must be done before parsing the payload and the MAC commands.
                 // We need to reset the MacCommandsBufferIndex here, since we need
                 // to take retransmissions and repetitions into account. Error cases
                 // will be handled in function OnMacStateCheckTimerEvent.
-                if ( McpsConfirm.McpsRequest == MCPS_CONFIRMED ) {
+                if ( Ctx->McpsConfirm.McpsRequest == MCPS_CONFIRMED ) {
                     if ( fCtrl.Bits.Ack == 1 ) {
                         // Reset MacCommandsBufferIndex when we have received an ACK.
-                        MacCommandsBufferIndex = 0;
+                        Ctx->MacCommandsBufferIndex = 0;
                         // Update acknowledgement information
-                        McpsConfirm.AckReceived = fCtrl.Bits.Ack;
-                        McpsIndication.AckReceived = fCtrl.Bits.Ack;
+                        Ctx->McpsConfirm.AckReceived = fCtrl.Bits.Ack;
+                        Ctx->McpsIndication.AckReceived = fCtrl.Bits.Ack;
+                        Ctx->Statistics.AcksReceived[( Ctx->RxSlot == RX_SLOT_WIN_1 ) ? 0 : 1]++;
+                        RetryAckReceived( );
                     }
                 } else {
                     // Reset the variable if we have received any valid frame.
-                    MacCommandsBufferIndex = 0;
+                    Ctx->MacCommandsBufferIndex = 0;
                 }
                 port = payload[appPayloadStartIndex];
                 // Process payload and MAC commands
@@ -1029,7 +1276,7 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
                     port = payload[appPayloadStartIndex++];
                     frameLen = ( size - 4 ) - appPayloadStartIndex;
 
-                    McpsIndication.Port = port;
+                    Ctx->McpsIndication.Port = port;
                     if ( port == 0 ) {
                         // Only allow frames which do not have fOpts
                             if( ( fCtrl.Bits.FOptsLen == 0 ) && ( multicast == 0 ) ) {
@@ -1039,19 +1286,19 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
                                                    address,
                                                    DOWN_LINK,
                                                    downLinkCounter,
-                                                   LoRaMacRxPayload );
+                                                   Ctx->LoRaMacRxPayload );
                             // Decode frame payload MAC commands
-                                ProcessMacCommands( LoRaMacRxPayload, 0, frameLen, snr, McpsIndication.RxSlot );
+                                ProcessMacCommands( Ctx->LoRaMacRxPayload, 0, frameLen, snr, Ctx->McpsIndication.RxSlot );
                         } else {
-                            LoRaMacFlags.Bits.McpsIndSkip = 1;
+                            Ctx->LoRaMacFlags.Bits.McpsIndSkip = 1;
                             // This is not a valid frame. Drop it and reset the ACK bits
-                            McpsConfirm.AckReceived = false;
-                            McpsIndication.AckReceived = false;
+                            Ctx->McpsConfirm.AckReceived = false;
+                            Ctx->McpsIndication.AckReceived = false;
                         }
                     } else {
                         if( ( fCtrl.Bits.FOptsLen > 0 ) && ( multicast == 0 ) ){
                             // Decode Options field MAC commands. Omit the fPort.
-                                ProcessMacCommands( payload, 8, appPayloadStartIndex - 1, snr, McpsIndication.RxSlot );
+                                ProcessMacCommands( payload, 8, appPayloadStartIndex - 1, snr, Ctx->McpsIndication.RxSlot );
                         }
 
                         LoRaMacPayloadDecrypt( payload + appPayloadStartIndex,
@@ -1060,24 +1307,25 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
                                                address,
                                                DOWN_LINK,
                                                downLinkCounter,
-                                               LoRaMacRxPayload );
+                                               Ctx->LoRaMacRxPayload );
 
-                        McpsIndication.Buffer = LoRaMacRxPayload;
-                        McpsIndication.BufferSize = frameLen;
-                        McpsIndication.RxData = true;
+                        Ctx->McpsIndication.Buffer = Ctx->LoRaMacRxPayload;
+                        Ctx->McpsIndication.BufferSize = frameLen;
+                        Ctx->McpsIndication.RxData = true;
                     }
                 } else {
                     if ( fCtrl.Bits.FOptsLen > 0 ) {
                         // Decode Options field MAC commands
-                        ProcessMacCommands( payload, 8, appPayloadStartIndex, snr , McpsIndication.RxSlot);
+                        ProcessMacCommands( payload, 8, appPayloadStartIndex, snr , Ctx->McpsIndication.RxSlot);
                     }
                 }
 
                 // Provide always an indication, skip the callback to the user application,
                 // in case of a confirmed downlink retransmission.
-                LoRaMacFlags.Bits.McpsInd = 1;
+                Ctx->LoRaMacFlags.Bits.McpsInd = 1;
             } else {
-                McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_MIC_FAIL;
+                Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_MIC_FAIL;
+                Ctx->Statistics.MicFailures++;
 
                 PrepareRxDoneAbort( );
                 return;
@@ -1085,27 +1333,27 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
         }
         break;
         case FRAME_TYPE_PROPRIETARY: {
-            memcpy1( LoRaMacRxPayload, &payload[pktHeaderLen], size );
+            memcpy1( Ctx->LoRaMacRxPayload, &payload[pktHeaderLen], size );
 
-            McpsIndication.McpsIndication = MCPS_PROPRIETARY;
-            McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_OK;
-            McpsIndication.Buffer = LoRaMacRxPayload;
-            McpsIndication.BufferSize = size - pktHeaderLen;
+            Ctx->McpsIndication.McpsIndication = MCPS_PROPRIETARY;
+            Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_OK;
+            Ctx->McpsIndication.Buffer = Ctx->LoRaMacRxPayload;
+            Ctx->McpsIndication.BufferSize = size - pktHeaderLen;
 
-            LoRaMacFlags.Bits.McpsInd = 1;
+            Ctx->LoRaMacFlags.Bits.McpsInd = 1;
             break;
         }
         default:
-            McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
+            Ctx->McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
             PrepareRxDoneAbort( );
             break;
     }
     // Verify if we need to disable the AckTimeoutTimer
-    CheckToDisableAckTimeout( NodeAckRequested, LoRaMacDeviceClass, McpsConfirm.AckReceived,
-                                AckTimeoutRetriesCounter, AckTimeoutRetries );
-    if( AckTimeoutTimer.IsRunning == false )
+    CheckToDisableAckTimeout( Ctx->NodeAckRequested, Ctx->LoRaMacDeviceClass, Ctx->McpsConfirm.AckReceived,
+                                Ctx->AckTimeoutRetriesCounter, Ctx->AckTimeoutRetries );
+    if( Ctx->AckTimeoutTimer.IsRunning == false )
     {// Procedure is completed when the AckTimeoutTimer is not running anymore
-    	LoRaMacFlags.Bits.MacDone = 1;
+    	Ctx->LoRaMacFlags.Bits.MacDone = 1;
     	// Trig OnMacCheckTimerEvent call as soon as possible
     	OnMacStateCheckTimerEvent();
     }
@@ -1113,9 +1361,11 @@ void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
 
 static void OnRadioTxTimeout( void )
 {
+    TRACE( TRACE_EVENT_MAC, TRACE_MAC_TX_TIMEOUT, Ctx->LoRaMacState );
+    Ctx->Statistics.TxTimeouts++;
 	DIO_PRINTF("TX Timeout\r\n");
 
-    if( LoRaMacDeviceClass != CLASS_C )
+    if( Ctx->LoRaMacDeviceClass != CLASS_C )
     {
         Radio.Sleep( );
     }
@@ -1124,55 +1374,58 @@ static void OnRadioTxTimeout( void )
         OpenContinuousRx2Window( );
     }
 
-    McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_TX_TIMEOUT;
+    Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_TX_TIMEOUT;
     LoRaMacConfirmQueueSetStatusCmn( LORAMAC_EVENT_INFO_STATUS_TX_TIMEOUT );
-    LoRaMacFlags.Bits.MacDone = 1;
+    Ctx->LoRaMacFlags.Bits.MacDone = 1;
 }
 
 static void OnRadioRxError( void )
 {
     bool classBRx = false;
 
-    if( LoRaMacDeviceClass != CLASS_C )
+    TRACE( TRACE_EVENT_MAC, TRACE_MAC_RX_ERROR, Ctx->LoRaMacState );
+    Ctx->Statistics.RxErrors[( Ctx->RxSlot == RX_SLOT_WIN_1 ) ? 0 : 1]++;
+
+    if( Ctx->LoRaMacDeviceClass != CLASS_C )
     {
         Radio.Sleep( );
     }
 
     if( classBRx == false )
     {
-        if( RxSlot == RX_SLOT_WIN_1 )
+        if( Ctx->RxSlot == RX_SLOT_WIN_1 )
         {
-            if( NodeAckRequested == true )
+            if( Ctx->NodeAckRequested == true )
             {
-                McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_RX1_ERROR;
+                Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_RX1_ERROR;
             }
             LoRaMacConfirmQueueSetStatusCmn( LORAMAC_EVENT_INFO_STATUS_RX1_ERROR );
 
-            if( LoRaMacDeviceClass != CLASS_C )
+            if( Ctx->LoRaMacDeviceClass != CLASS_C )
             {
-                if( TimerGetElapsedTime( AggregatedLastTxDoneTime ) >= RxWindow2Delay )
+                if( TimerGetElapsedTime( Ctx->AggregatedLastTxDoneTime ) >= Ctx->RxWindow2Delay )
                 {
-                    TimerStop( &RxWindowTimer2 );
-                    LoRaMacFlags.Bits.MacDone = 1;
+                    TimerStop( &Ctx->RxWindowTimer2 );
+                    Ctx->LoRaMacFlags.Bits.MacDone = 1;
                 }
             }
         }
         else
         {
-            if( NodeAckRequested == true )
+            if( Ctx->NodeAckRequested == true )
             {
-                McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_RX2_ERROR;
+                Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_RX2_ERROR;
             }
             LoRaMacConfirmQueueSetStatusCmn( LORAMAC_EVENT_INFO_STATUS_RX2_ERROR );
 
-            if( LoRaMacDeviceClass != CLASS_C )
+            if( Ctx->LoRaMacDeviceClass != CLASS_C )
             {
-                LoRaMacFlags.Bits.MacDone = 1;
+                Ctx->LoRaMacFlags.Bits.MacDone = 1;
             }
         }
     }
 
-    if( LoRaMacDeviceClass == CLASS_C )
+    if( Ctx->LoRaMacDeviceClass == CLASS_C )
     {
         OpenContinuousRx2Window( );
     }
@@ -1182,120 +1435,141 @@ static void OnRadioRxTimeout( void )
 {
     bool classBRx = false;
 
-    if( LoRaMacDeviceClass != CLASS_C )
+    TRACE( TRACE_EVENT_MAC, TRACE_MAC_RX_TIMEOUT, Ctx->LoRaMacState );
+    Ctx->Statistics.RxTimeouts[( Ctx->RxSlot == RX_SLOT_WIN_1 ) ? 0 : 1]++;
+
+    if( Ctx->LoRaMacDeviceClass != CLASS_C )
     {
         Radio.Sleep( );
     }
 
+    if( ( Ctx->RxTiming.Adaptive == true ) && ( Ctx->LoRaMacDeviceClass != CLASS_C ) &&
+        ( ( Ctx->RxSlot == RX_SLOT_WIN_1 ) || ( Ctx->RxSlot == RX_SLOT_WIN_2 ) ) )
+    {
+        // An empty window stays open for its whole length, account for the saved part
+        uint32_t rxError = RxTimingGetRxError( ( Ctx->RxSlot == RX_SLOT_WIN_1 ) ? 0 : 1 );
+
+        if( rxError < Ctx->LoRaMacParams.SystemMaxRxError )
+        {
+            uint32_t saved = 2 * ( Ctx->LoRaMacParams.SystemMaxRxError - rxError );
+
+            Ctx->RxTiming.RxTimeSaved += saved;
+            Ctx->RxTiming.ChargeSaved += ( saved * BOARD_RADIO_RX_CURRENT ) / 1000;
+        }
+    }
+
     if( classBRx == false )
     {
-        if( RxSlot == RX_SLOT_WIN_1 )
+        if( Ctx->RxSlot == RX_SLOT_WIN_1 )
         {
-            if( NodeAckRequested == true )
+            if( Ctx->NodeAckRequested == true )
             {
-                McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_RX1_TIMEOUT;
+                Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_RX1_TIMEOUT;
             }
             LoRaMacConfirmQueueSetStatusCmn( LORAMAC_EVENT_INFO_STATUS_RX1_TIMEOUT );
 
-            if( LoRaMacDeviceClass != CLASS_C )
+            if( Ctx->LoRaMacDeviceClass != CLASS_C )
             {
-                if( TimerGetElapsedTime( AggregatedLastTxDoneTime ) >= RxWindow2Delay )
+                if( TimerGetElapsedTime( Ctx->AggregatedLastTxDoneTime ) >= Ctx->RxWindow2Delay )
                 {
-                    TimerStop( &RxWindowTimer2 );
-                    LoRaMacFlags.Bits.MacDone = 1;
+                    TimerStop( &Ctx->RxWindowTimer2 );
+                    Ctx->LoRaMacFlags.Bits.MacDone = 1;
                 }
             }
         }
         else
         {
-            if( NodeAckRequested == true )
+            if( Ctx->NodeAckRequested == true )
             {
-                McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_RX2_TIMEOUT;
+                Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_RX2_TIMEOUT;
             }
             LoRaMacConfirmQueueSetStatusCmn( LORAMAC_EVENT_INFO_STATUS_RX2_TIMEOUT );
 
-            if( LoRaMacDeviceClass != CLASS_C )
+            if( Ctx->LoRaMacDeviceClass != CLASS_C )
             {
-                LoRaMacFlags.Bits.MacDone = 1;
+                Ctx->LoRaMacFlags.Bits.MacDone = 1;
             }
         }
     }
 
-    if( LoRaMacDeviceClass == CLASS_C )
+    if( Ctx->LoRaMacDeviceClass == CLASS_C )
     {
         OpenContinuousRx2Window( );
     }
 }
 
+static void OnRadioCadDone( bool channelActivityDetected )
+{
+    LoRaMacLbtOnCadDone( channelActivityDetected );
+}
 
 static void OnMacStateCheckTimerEvent( void )
 {
-    GetPhyParams_t getPhy;
-    PhyParam_t phyParam;
     bool noTx = false;
 
-    TimerStop( &MacStateCheckTimer );
+    TRACE( TRACE_EVENT_TIMER_FIRE, TRACE_TIMER_MAC_STATE_CHECK, Ctx->LoRaMacState );
+    TimerStop( &Ctx->MacStateCheckTimer );
 
-    if ( LoRaMacFlags.Bits.MacDone == 1 ) {
-        if ( ( LoRaMacState & LORAMAC_RX_ABORT ) == LORAMAC_RX_ABORT ) {
-            LoRaMacState &= ~LORAMAC_RX_ABORT;
-            LoRaMacState &= ~LORAMAC_TX_RUNNING;
+    if ( Ctx->LoRaMacFlags.Bits.MacDone == 1 ) {
+        if ( ( Ctx->LoRaMacState & LORAMAC_RX_ABORT ) == LORAMAC_RX_ABORT ) {
+            Ctx->LoRaMacState &= ~LORAMAC_RX_ABORT;
+            Ctx->LoRaMacState &= ~LORAMAC_TX_RUNNING;
         }
 
-        if ( ( LoRaMacFlags.Bits.MlmeReq == 1 ) || ( ( LoRaMacFlags.Bits.McpsReq == 1 ) ) ) {
+        if ( ( Ctx->LoRaMacFlags.Bits.MlmeReq == 1 ) || ( ( Ctx->LoRaMacFlags.Bits.McpsReq == 1 ) ) ) {
             // Get a status of any request and check if we have a TX timeout
-            MlmeConfirm.Status = LoRaMacConfirmQueueGetStatusCmn( );
-            if ( ( McpsConfirm.Status == LORAMAC_EVENT_INFO_STATUS_TX_TIMEOUT ) ||
-                 ( MlmeConfirm.Status == LORAMAC_EVENT_INFO_STATUS_TX_TIMEOUT ) ) {
+            Ctx->MlmeConfirm.Status = LoRaMacConfirmQueueGetStatusCmn( );
+            if ( ( Ctx->McpsConfirm.Status == LORAMAC_EVENT_INFO_STATUS_TX_TIMEOUT ) ||
+                 ( Ctx->MlmeConfirm.Status == LORAMAC_EVENT_INFO_STATUS_TX_TIMEOUT ) ) {
                 // Stop transmit cycle due to tx timeout.
-                LoRaMacState &= ~LORAMAC_TX_RUNNING;
-                MacCommandsBufferIndex = 0;
-                McpsConfirm.NbRetries = AckTimeoutRetriesCounter;
-                McpsConfirm.AckReceived = false;
-                McpsConfirm.TxTimeOnAir = 0;
+                Ctx->LoRaMacState &= ~LORAMAC_TX_RUNNING;
+                Ctx->MacCommandsBufferIndex = 0;
+                Ctx->McpsConfirm.NbRetries = Ctx->AckTimeoutRetriesCounter;
+                Ctx->McpsConfirm.AckReceived = false;
+                Ctx->McpsConfirm.TxTimeOnAir = 0;
                 noTx = true;
             }
         }
 
-        if ( ( NodeAckRequested == false ) && ( noTx == false ) ) {
-            if ( ( LoRaMacFlags.Bits.MlmeReq == 1 ) || ( ( LoRaMacFlags.Bits.McpsReq == 1 ) ) ) {
-                if ( ( LoRaMacFlags.Bits.MlmeReq == 1 ) && ( MlmeConfirm.MlmeRequest == MLME_JOIN ) ) {
+        if ( ( Ctx->NodeAckRequested == false ) && ( noTx == false ) ) {
+            if ( ( Ctx->LoRaMacFlags.Bits.MlmeReq == 1 ) || ( ( Ctx->LoRaMacFlags.Bits.McpsReq == 1 ) ) ) {
+                if ( ( Ctx->LoRaMacFlags.Bits.MlmeReq == 1 ) && ( LoRaMacConfirmQueueIsCmdActive( MLME_JOIN ) == true ) ) {
                     // Procedure for the join request
-                    MlmeConfirm.NbRetries = JoinRequestTrials;
+                    Ctx->MlmeConfirm.NbRetries = Ctx->JoinRequestTrials;
 
                     if( LoRaMacConfirmQueueGetStatus( MLME_JOIN ) == LORAMAC_EVENT_INFO_STATUS_OK ) {
                         // Node joined successfully
-                        UpLinkCounter = 0;
-                        ChannelsNbRepCounter = 0;
-                        LoRaMacState &= ~LORAMAC_TX_RUNNING;
+                        Ctx->UpLinkCounter = 0;
+                        Ctx->ChannelsNbRepCounter = 0;
+                        Ctx->LoRaMacState &= ~LORAMAC_TX_RUNNING;
                     } else {
-                        if ( JoinRequestTrials >= MaxJoinRequestTrials ) {
-                            LoRaMacState &= ~LORAMAC_TX_RUNNING;
+                        if ( Ctx->JoinRequestTrials >= Ctx->MaxJoinRequestTrials ) {
+                            Ctx->LoRaMacState &= ~LORAMAC_TX_RUNNING;
                         } else {
-                            LoRaMacFlags.Bits.MacDone = 0;
+                            Ctx->LoRaMacFlags.Bits.MacDone = 0;
                             // Sends the same frame again
                             OnTxDelayedTimerEvent( );
                         }
                     }
                 } else {
                     // Procedure for all other frames
-                    if ( ( ChannelsNbRepCounter >= LoRaMacParams.ChannelsNbRep ) || ( LoRaMacFlags.Bits.McpsInd == 1 ) ) {
-                        if ( LoRaMacFlags.Bits.McpsInd == 0 ) {
+                    if ( ( Ctx->ChannelsNbRepCounter >= Ctx->LoRaMacParams.ChannelsNbRep ) || ( Ctx->LoRaMacFlags.Bits.McpsInd == 1 ) ) {
+                        if ( Ctx->LoRaMacFlags.Bits.McpsInd == 0 ) {
                             // Maximum repetitions without downlink. Reset MacCommandsBufferIndex. Increase ADR Ack counter.
                             // Only process the case when the MAC did not receive a downlink.
-                            MacCommandsBufferIndex = 0;
-                            AdrAckCounter++;
+                            Ctx->MacCommandsBufferIndex = 0;
+                            Ctx->AdrAckCounter++;
                         }
 
-                        ChannelsNbRepCounter = 0;
+                        Ctx->ChannelsNbRepCounter = 0;
 
-                        if ( IsUpLinkCounterFixed == false ) {
-                            UpLinkCounter++;
+                        if ( Ctx->IsUpLinkCounterFixed == false ) {
+                            Ctx->UpLinkCounter++;
                         }
 
-                        LoRaMacState &= ~LORAMAC_TX_RUNNING;
+                        Ctx->LoRaMacState &= ~LORAMAC_TX_RUNNING;
                     } else {
-                        LoRaMacFlags.Bits.MacDone = 0;
+                        Ctx->LoRaMacFlags.Bits.MacDone = 0;
                         // Sends the same frame again
                         OnTxDelayedTimerEvent( );
                     }
@@ -1303,123 +1577,142 @@ static void OnMacStateCheckTimerEvent( void )
             }
         }
 
-        if ( LoRaMacFlags.Bits.McpsInd == 1 ) {
+        if ( Ctx->LoRaMacFlags.Bits.McpsInd == 1 ) {
             // Procedure if we received a frame
-            if ( ( McpsConfirm.AckReceived == true ) || ( AckTimeoutRetriesCounter > AckTimeoutRetries ) ) {
-                AckTimeoutRetry = false;
-                NodeAckRequested = false;
-                if ( IsUpLinkCounterFixed == false ) {
-                    UpLinkCounter++;
+            if ( ( Ctx->McpsConfirm.AckReceived == true ) || ( Ctx->AckTimeoutRetriesCounter > Ctx->AckTimeoutRetries ) ) {
+                Ctx->AckTimeoutRetry = false;
+                Ctx->NodeAckRequested = false;
+                if ( Ctx->IsUpLinkCounterFixed == false ) {
+                    Ctx->UpLinkCounter++;
                 }
-                McpsConfirm.NbRetries = AckTimeoutRetriesCounter;
+                Ctx->McpsConfirm.NbRetries = Ctx->AckTimeoutRetriesCounter;
 
-                LoRaMacState &= ~LORAMAC_TX_RUNNING;
+                Ctx->LoRaMacState &= ~LORAMAC_TX_RUNNING;
             }
         }
 
-        if ( ( AckTimeoutRetry == true ) && ( ( LoRaMacState & LORAMAC_TX_DELAYED ) == 0 ) ) {
+        if ( ( Ctx->AckTimeoutRetry == true ) && ( ( Ctx->LoRaMacState & LORAMAC_TX_DELAYED ) == 0 ) ) {
             // Retransmissions procedure for confirmed uplinks
-            AckTimeoutRetry = false;
-            if ( ( AckTimeoutRetriesCounter < AckTimeoutRetries ) && ( AckTimeoutRetriesCounter <= MAX_ACK_RETRIES ) ) {
-                AckTimeoutRetriesCounter++;
-
-                if ( ( AckTimeoutRetriesCounter % 2 ) == 1 ) {
-                    getPhy.Attribute = PHY_NEXT_LOWER_TX_DR;
-                    getPhy.UplinkDwellTime = LoRaMacParams.UplinkDwellTime;
-                    getPhy.Datarate = LoRaMacParams.ChannelsDatarate;
-                    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-                    LoRaMacParams.ChannelsDatarate = phyParam.Value;
-                }
+            Ctx->AckTimeoutRetry = false;
+            if ( ( Ctx->AckTimeoutRetriesCounter < Ctx->AckTimeoutRetries ) && ( Ctx->AckTimeoutRetriesCounter <= MAX_ACK_RETRIES ) &&
+                 ( RetryPrepare( Ctx->AckTimeoutRetriesCounter + 1 ) == true ) ) {
+                Ctx->AckTimeoutRetriesCounter++;
+                Ctx->Statistics.Retransmissions++;
+
                 // Try to send the frame again
                 if ( ScheduleTx( ) == LORAMAC_STATUS_OK ) {
-                    LoRaMacFlags.Bits.MacDone = 0;
+                    Ctx->LoRaMacFlags.Bits.MacDone = 0;
                 } else {
                     // The DR is not applicable for the payload size
-                    McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_TX_DR_PAYLOAD_SIZE_ERROR;
-
-                    MacCommandsBufferIndex = 0;
-                    LoRaMacState &= ~LORAMAC_TX_RUNNING;
-                    NodeAckRequested = false;
-                    McpsConfirm.AckReceived = false;
-                    McpsConfirm.NbRetries = AckTimeoutRetriesCounter;
-                    McpsConfirm.Datarate = LoRaMacParams.ChannelsDatarate;
-                    if ( IsUpLinkCounterFixed == false ) {
-                        UpLinkCounter++;
+                    Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_TX_DR_PAYLOAD_SIZE_ERROR;
+
+                    Ctx->MacCommandsBufferIndex = 0;
+                    Ctx->LoRaMacState &= ~LORAMAC_TX_RUNNING;
+                    Ctx->NodeAckRequested = false;
+                    Ctx->McpsConfirm.AckReceived = false;
+                    Ctx->McpsConfirm.NbRetries = Ctx->AckTimeoutRetriesCounter;
+                    Ctx->McpsConfirm.Datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+                    if ( Ctx->IsUpLinkCounterFixed == false ) {
+                        Ctx->UpLinkCounter++;
                     }
                 }
             } else {
-                RegionInitDefaults( LoRaMacRegion, INIT_TYPE_RESTORE );
+                RegionInitDefaults( Ctx->LoRaMacRegion, INIT_TYPE_RESTORE );
 
-                LoRaMacState &= ~LORAMAC_TX_RUNNING;
+                Ctx->LoRaMacState &= ~LORAMAC_TX_RUNNING;
+                Ctx->Retry.Failed++;
 
-                MacCommandsBufferIndex = 0;
-                NodeAckRequested = false;
-                McpsConfirm.AckReceived = false;
-                McpsConfirm.NbRetries = AckTimeoutRetriesCounter;
-                if ( IsUpLinkCounterFixed == false ) {
-                    UpLinkCounter++;
+                Ctx->MacCommandsBufferIndex = 0;
+                Ctx->NodeAckRequested = false;
+                Ctx->McpsConfirm.AckReceived = false;
+                Ctx->McpsConfirm.NbRetries = Ctx->AckTimeoutRetriesCounter;
+                if ( Ctx->IsUpLinkCounterFixed == false ) {
+                    Ctx->UpLinkCounter++;
                 }
             }
         }
     }
 
     // Handle events
-    if( LoRaMacState == LORAMAC_IDLE )
+    if( Ctx->LoRaMacState == LORAMAC_IDLE )
     {
-        if( LoRaMacFlags.Bits.McpsReq == 1 )
+        bool uplinkDone = ( Ctx->LoRaMacFlags.Bits.McpsReq == 1 ) || ( Ctx->LoRaMacFlags.Bits.MlmeReq == 1 );
+
+        TRACE( TRACE_EVENT_MAC, TRACE_MAC_IDLE, Ctx->LoRaMacState );
+        if( Ctx->LoRaMacFlags.Bits.McpsReq == 1 )
         {
-            LoRaMacFlags.Bits.McpsReq = 0;
-            LoRaMacPrimitives->MacMcpsConfirm( &McpsConfirm );
+            Ctx->LoRaMacFlags.Bits.McpsReq = 0;
+            Ctx->Statistics.Uplinks++;
+            if( Ctx->McpsConfirm.Status == LORAMAC_EVENT_INFO_STATUS_OK )
+            {
+                // Only an acknowledge tells that the bytes were delivered
+                EnergyUplinkDone( Ctx->LoRaMacTxPayloadLen, ( Ctx->McpsConfirm.McpsRequest == MCPS_CONFIRMED ) &&
+                                                            ( Ctx->McpsConfirm.AckReceived == true ) );
+            }
+            else
+            {
+                EnergyUplinkDone( 0, false );
+            }
+            Ctx->LoRaMacPrimitives->MacMcpsConfirm( &Ctx->McpsConfirm );
         }
 
-        if( LoRaMacFlags.Bits.MlmeReq == 1 )
+        if( Ctx->LoRaMacFlags.Bits.MlmeReq == 1 )
         {
-            LoRaMacFlags.Bits.MlmeReq = 0;
-            LoRaMacConfirmQueueHandleCb( &MlmeConfirm );
+            Ctx->LoRaMacFlags.Bits.MlmeReq = 0;
+            EnergyUplinkDone( 0, false );
+            LoRaMacConfirmQueueHandleCb( &Ctx->MlmeConfirm );
             if( LoRaMacConfirmQueueGetCnt( ) > 0 )
             {
-                LoRaMacFlags.Bits.MlmeReq = 1;
+                Ctx->LoRaMacFlags.Bits.MlmeReq = 1;
             }
         }
 
         // Handle MLME indication
-        if( LoRaMacFlags.Bits.MlmeInd == 1 )
+        if( Ctx->LoRaMacFlags.Bits.MlmeInd == 1 )
         {
-            LoRaMacPrimitives->MacMlmeIndication( &MlmeIndication );
-            LoRaMacFlags.Bits.MlmeInd = 0;
+            Ctx->LoRaMacPrimitives->MacMlmeIndication( &Ctx->MlmeIndication );
+            Ctx->LoRaMacFlags.Bits.MlmeInd = 0;
         }
         // Verify if sticky MAC commands are pending or not
         if( IsStickyMacCommandPending( ) == true )
         {// Setup MLME indication
             SetMlmeScheduleUplinkIndication( );
-            LoRaMacPrimitives->MacMlmeIndication( &MlmeIndication );
-            LoRaMacFlags.Bits.MlmeInd = 0;
+            Ctx->LoRaMacPrimitives->MacMlmeIndication( &Ctx->MlmeIndication );
+            Ctx->LoRaMacFlags.Bits.MlmeInd = 0;
         }
 
         // Procedure done. Reset variables.
-        LoRaMacFlags.Bits.MacDone = 0;
+        Ctx->LoRaMacFlags.Bits.MacDone = 0;
 
+        // Learn the slow clock drift at the current temperature once the
+        // uplink, its retries and its RX windows are over: the temperature
+        // read and the ~7 ms measurement stay off the TX path
+        if( ( uplinkDone == true ) && ( Ctx->LoRaMacCallbacks != NULL ) &&
+            ( Ctx->LoRaMacCallbacks->GetTemperatureLevel != NULL ) )
+        {
+            RtcDriftUpdate( Ctx->LoRaMacCallbacks->GetTemperatureLevel( ) );
+        }
     }
     else
     {
         // Operation not finished restart timer
-        TimerSetValue( &MacStateCheckTimer, MAC_STATE_CHECK_TIMEOUT );
-        TimerStart( &MacStateCheckTimer );
+        TimerSetValue( &Ctx->MacStateCheckTimer, MAC_STATE_CHECK_TIMEOUT );
+        TimerStart( &Ctx->MacStateCheckTimer );
     }
 
     // Handle MCPS indication
-    if( LoRaMacFlags.Bits.McpsInd == 1 )
+    if( Ctx->LoRaMacFlags.Bits.McpsInd == 1 )
     {
-        LoRaMacFlags.Bits.McpsInd = 0;
-        if( LoRaMacDeviceClass == CLASS_C )
+        Ctx->LoRaMacFlags.Bits.McpsInd = 0;
+        if( Ctx->LoRaMacDeviceClass == CLASS_C )
         {// Activate RX2 window for Class C
             OpenContinuousRx2Window( );
         }
-        if( LoRaMacFlags.Bits.McpsIndSkip == 0 )
+        if( Ctx->LoRaMacFlags.Bits.McpsIndSkip == 0 )
         {
-            LoRaMacPrimitives->MacMcpsIndication( &McpsIndication );
+            Ctx->LoRaMacPrimitives->MacMcpsIndication( &Ctx->McpsIndication );
         }
-        LoRaMacFlags.Bits.McpsIndSkip = 0;
+        Ctx->LoRaMacFlags.Bits.McpsIndSkip = 0;
     }
 
 }
@@ -1430,21 +1723,22 @@ static void OnTxDelayedTimerEvent( void )
     LoRaMacFrameCtrl_t fCtrl;
     AlternateDrParams_t altDr;
 
-    TimerStop( &TxDelayedTimer );
-    LoRaMacState &= ~LORAMAC_TX_DELAYED;
+    TRACE( TRACE_EVENT_TIMER_FIRE, TRACE_TIMER_TX_DELAYED, Ctx->LoRaMacState );
+    TimerStop( &Ctx->TxDelayedTimer );
+    Ctx->LoRaMacState &= ~LORAMAC_TX_DELAYED;
 
-    if ( ( LoRaMacFlags.Bits.MlmeReq == 1 ) && ( MlmeConfirm.MlmeRequest == MLME_JOIN ) ) {
+    if ( ( Ctx->LoRaMacFlags.Bits.MlmeReq == 1 ) && ( LoRaMacConfirmQueueIsCmdActive( MLME_JOIN ) == true ) ) {
         ResetMacParameters( );
 
-        altDr.NbTrials = JoinRequestTrials + 1;
+        altDr.NbTrials = Ctx->JoinRequestTrials + 1;
 
-        LoRaMacParams.ChannelsDatarate = RegionAlternateDr( LoRaMacRegion, &altDr );
+        Ctx->LoRaMacParams.ChannelsDatarate = RegionAlternateDr( Ctx->LoRaMacRegion, &altDr );
 
         macHdr.Value = 0;
         macHdr.Bits.MType = FRAME_TYPE_JOIN_REQ;
 
         fCtrl.Value = 0;
-        fCtrl.Bits.Adr = AdrCtrlOn;
+        fCtrl.Bits.Adr = Ctx->AdrCtrlOn;
 
         /* In case of join request retransmissions, the stack must prepare
          * the frame again, because the network server keeps track of the random
@@ -1457,23 +1751,25 @@ static void OnTxDelayedTimerEvent( void )
 
 static void OnRxWindow1TimerEvent( void )
 {
-    TimerStop( &RxWindowTimer1 );
-    RxSlot = RX_SLOT_WIN_1;
-
-    RxWindow1Config.Channel = Channel;
-    RxWindow1Config.DrOffset = LoRaMacParams.Rx1DrOffset;
-    RxWindow1Config.DownlinkDwellTime = LoRaMacParams.DownlinkDwellTime;
-    RxWindow1Config.RepeaterSupport = LoRaMacParams.RepeaterSupport;
-    RxWindow1Config.RxContinuous = false;
-    RxWindow1Config.RxSlot = RxSlot;
-
-    if ( LoRaMacDeviceClass == CLASS_C ) {
+    TRACE( TRACE_EVENT_TIMER_FIRE, TRACE_TIMER_RX_WINDOW_1, Ctx->LoRaMacState );
+    TimerStop( &Ctx->RxWindowTimer1 );
+    Ctx->RxSlot = RX_SLOT_WIN_1;
+
+    Ctx->RxWindow1Config.Channel = Ctx->Channel;
+    Ctx->RxWindow1Config.DrOffset = Ctx->LoRaMacParams.Rx1DrOffset;
+    Ctx->RxWindow1Config.DownlinkDwellTime = Ctx->LoRaMacParams.DownlinkDwellTime;
+    Ctx->RxWindow1Config.RepeaterSupport = Ctx->LoRaMacParams.RepeaterSupport;
+    Ctx->RxWindow1Config.RxContinuous = false;
+    Ctx->RxWindow1Config.RxSlot = Ctx->RxSlot;
+    Ctx->RxWindow1Config.Modem = MODEM_LORA;
+
+    if ( Ctx->LoRaMacDeviceClass == CLASS_C ) {
         Radio.Standby( );
     }
 
-    RegionRxConfig( LoRaMacRegion, &RxWindow1Config, ( int8_t * )&McpsIndication.RxDatarate );
+    RegionRxConfig( Ctx->LoRaMacRegion, &Ctx->RxWindow1Config, ( int8_t * )&Ctx->McpsIndication.RxDatarate );
     //printf("w1 dr:%d\r\n",McpsIndication.RxDatarate);
-    RxWindowSetup( RxWindow1Config.RxContinuous, LoRaMacParams.MaxRxWindow );
+    RxWindowSetup( Ctx->RxWindow1Config.RxContinuous, Ctx->LoRaMacParams.MaxRxWindow );
 #if(LoraWan_RGB==1)
     RGB_ON(COLOR_RXWINDOW1,0);
 #endif
@@ -1481,24 +1777,26 @@ static void OnRxWindow1TimerEvent( void )
 
 static void OnRxWindow2TimerEvent( void )
 {
-    TimerStop( &RxWindowTimer2 );
-
-    RxWindow2Config.Channel = Channel;
-    RxWindow2Config.Frequency = LoRaMacParams.Rx2Channel.Frequency;
-    RxWindow2Config.DownlinkDwellTime = LoRaMacParams.DownlinkDwellTime;
-    RxWindow2Config.RepeaterSupport = LoRaMacParams.RepeaterSupport;
-    RxWindow2Config.RxSlot = RX_SLOT_WIN_2;
-
-    if ( LoRaMacDeviceClass != CLASS_C ) {
-        RxWindow2Config.RxContinuous = false;
+    TRACE( TRACE_EVENT_TIMER_FIRE, TRACE_TIMER_RX_WINDOW_2, Ctx->LoRaMacState );
+    TimerStop( &Ctx->RxWindowTimer2 );
+
+    Ctx->RxWindow2Config.Channel = Ctx->Channel;
+    Ctx->RxWindow2Config.Frequency = Ctx->LoRaMacParams.Rx2Channel.Frequency;
+    Ctx->RxWindow2Config.DownlinkDwellTime = Ctx->LoRaMacParams.DownlinkDwellTime;
+    Ctx->RxWindow2Config.RepeaterSupport = Ctx->LoRaMacParams.RepeaterSupport;
+    Ctx->RxWindow2Config.RxSlot = RX_SLOT_WIN_2;
+    Ctx->RxWindow2Config.Modem = MODEM_LORA;
+
+    if ( Ctx->LoRaMacDeviceClass != CLASS_C ) {
+        Ctx->RxWindow2Config.RxContinuous = false;
     } else {
-        RxWindow2Config.RxContinuous = true;
+        Ctx->RxWindow2Config.RxContinuous = true;
     }
 
-    if ( RegionRxConfig( LoRaMacRegion, &RxWindow2Config, ( int8_t * )&McpsIndication.RxDatarate ) == true ) {
+    if ( RegionRxConfig( Ctx->LoRaMacRegion, &Ctx->RxWindow2Config, ( int8_t * )&Ctx->McpsIndication.RxDatarate ) == true ) {
     	//printf("w2 dr:%d\r\n",McpsIndication.RxDatarate);
-        RxWindowSetup( RxWindow2Config.RxContinuous, LoRaMacParams.MaxRxWindow );
-        RxSlot = RX_SLOT_WIN_2;
+        RxWindowSetup( Ctx->RxWindow2Config.RxContinuous, Ctx->LoRaMacParams.MaxRxWindow );
+        Ctx->RxSlot = RX_SLOT_WIN_2;
     }
 #if(LoraWan_RGB==1)
 	RGB_ON(COLOR_RXWINDOW2,0);
@@ -1516,7 +1814,7 @@ static void CheckToDisableAckTimeout( bool nodeAckRequested, DeviceClass_t devCl
         {// FIRST CASE
             // We have performed an unconfirmed uplink in class c mode
             // and have received a downlink in RX1 or RX2.
-            TimerStop( &AckTimeoutTimer );
+            TimerStop( &Ctx->AckTimeoutTimer );
         }
     }
     else
@@ -1525,7 +1823,7 @@ static void CheckToDisableAckTimeout( bool nodeAckRequested, DeviceClass_t devCl
         {// SECOND CASE
             // We have performed a confirmed uplink and have received a
             // downlink with a valid ACK.
-            TimerStop( &AckTimeoutTimer );
+            TimerStop( &Ctx->AckTimeoutTimer );
         }
         else
         {// THIRD CASE
@@ -1535,7 +1833,7 @@ static void CheckToDisableAckTimeout( bool nodeAckRequested, DeviceClass_t devCl
                 // received a downlink with a valid ACK. In this case
                 // we need to verify if the maximum retries have been
                 // elapsed. If so, stop the timer.
-                TimerStop( &AckTimeoutTimer );
+                TimerStop( &Ctx->AckTimeoutTimer );
             }
         }
     }
@@ -1543,19 +1841,33 @@ static void CheckToDisableAckTimeout( bool nodeAckRequested, DeviceClass_t devCl
 
 static void OnAckTimeoutTimerEvent( void )
 {
-    TimerStop( &AckTimeoutTimer );
-
-    if ( NodeAckRequested == true ) {
-        AckTimeoutRetry = true;
-        LoRaMacState &= ~LORAMAC_ACK_REQ;
+    TRACE( TRACE_EVENT_TIMER_FIRE, TRACE_TIMER_ACK_TIMEOUT, Ctx->LoRaMacState );
+    TimerStop( &Ctx->AckTimeoutTimer );
+
+    if ( Ctx->NodeAckRequested == true ) {
+        Ctx->AckTimeoutRetry = true;
+        Ctx->LoRaMacState &= ~LORAMAC_ACK_REQ;
+
+        // The acknowledge may have been lost in a too narrow window, widen the
+        // learned spread, which may be 0, and start learning again after
+        // too many misses in a row
+        if ( ++Ctx->RxTiming.Misses >= RX_TIMING_MAX_MISSES ) {
+            Ctx->RxTiming.Misses = 0;
+            Ctx->RxTiming.Samples[0] = 0;
+            Ctx->RxTiming.Samples[1] = 0;
+        }
+        Ctx->RxTiming.OffsetVariance[0] = ( 2 * Ctx->RxTiming.OffsetVariance[0] ) + RX_TIMING_MISS_VARIANCE;
+        Ctx->RxTiming.OffsetVariance[1] = ( 2 * Ctx->RxTiming.OffsetVariance[1] ) + RX_TIMING_MISS_VARIANCE;
+        RetryAckTimeout( );
     }
-    if ( LoRaMacDeviceClass == CLASS_C ) {
-        LoRaMacFlags.Bits.MacDone = 1;
+    if ( Ctx->LoRaMacDeviceClass == CLASS_C ) {
+        Ctx->LoRaMacFlags.Bits.MacDone = 1;
     }
 }
 
 static void RxWindowSetup( bool rxContinuous, uint32_t maxRxWindow )
 {
+    RadioOwner = Ctx;
     if ( rxContinuous == false ) {
         Radio.Rx( maxRxWindow );
     } else {
@@ -1567,24 +1879,24 @@ static LoRaMacStatus_t SwitchClass( DeviceClass_t deviceClass )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_PARAMETER_INVALID;
 
-    switch( LoRaMacDeviceClass )
+    switch( Ctx->LoRaMacDeviceClass )
     {
         case CLASS_A:
         {
             if( deviceClass == CLASS_C )
             {
-                LoRaMacDeviceClass = deviceClass;
+                Ctx->LoRaMacDeviceClass = deviceClass;
 
                 // Set the NodeAckRequested indicator to default
-                NodeAckRequested = false;
+                Ctx->NodeAckRequested = false;
                 // Set the radio into sleep mode in case we are still in RX mode
                 Radio.Sleep( );
                 // Compute Rx2 windows parameters in case the RX2 datarate has changed
-                RegionComputeRxWindowParameters( LoRaMacRegion,
-                                                 LoRaMacParams.Rx2Channel.Datarate,
-                                                 LoRaMacParams.MinRxSymbols,
-                                                 LoRaMacParams.SystemMaxRxError,
-                                                 &RxWindow2Config );
+                RegionComputeRxWindowParameters( Ctx->LoRaMacRegion,
+                                                 Ctx->LoRaMacParams.Rx2Channel.Datarate,
+                                                 Ctx->LoRaMacParams.MinRxSymbols,
+                                                 Ctx->LoRaMacParams.SystemMaxRxError,
+                                                 &Ctx->RxWindow2Config );
                 OpenContinuousRx2Window( );
 
 
@@ -1598,7 +1910,7 @@ static LoRaMacStatus_t SwitchClass( DeviceClass_t deviceClass )
         {
             if( deviceClass == CLASS_A )
             {
-                LoRaMacDeviceClass = deviceClass;
+                Ctx->LoRaMacDeviceClass = deviceClass;
 
                 // Set the radio into sleep to setup a defined state
                 Radio.Sleep( );
@@ -1620,16 +1932,16 @@ static bool ValidatePayloadLength( uint8_t lenN, int8_t datarate, uint8_t fOptsL
     uint16_t payloadSize = 0;
 
     // Setup PHY request
-    getPhy.UplinkDwellTime = LoRaMacParams.UplinkDwellTime;
+    getPhy.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
     getPhy.Datarate = datarate;
     getPhy.Attribute = PHY_MAX_PAYLOAD;
 
     // Get the maximum payload length
-    if( LoRaMacParams.RepeaterSupport == true )
+    if( Ctx->LoRaMacParams.RepeaterSupport == true )
     {
         getPhy.Attribute = PHY_MAX_PAYLOAD_REPEATER;
     }
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
     maxN = phyParam.Value;
 
     // Calculate the resulting payload size
@@ -1644,7 +1956,7 @@ static bool ValidatePayloadLength( uint8_t lenN, int8_t datarate, uint8_t fOptsL
 
 static bool IsStickyMacCommandPending( void )
 {
-    if( MacCommandsBufferToRepeatIndex > 0 )
+    if( Ctx->MacCommandsBufferToRepeatIndex > 0 )
     {
         // Sticky MAC commands pending
         return true;
@@ -1654,415 +1966,411 @@ static bool IsStickyMacCommandPending( void )
 
 static void SetMlmeScheduleUplinkIndication( void )
 {
-    MlmeIndication.MlmeIndication = MLME_SCHEDULE_UPLINK;
-    LoRaMacFlags.Bits.MlmeInd = 1;
+    Ctx->MlmeIndication.MlmeIndication = MLME_SCHEDULE_UPLINK;
+    Ctx->LoRaMacFlags.Bits.MlmeInd = 1;
 }
 
+/*!
+ * MAC command descriptor flags
+ */
+#define MAC_CMD_STICKY                              0x01
+#define MAC_CMD_SCHEDULE_UPLINK                     0x02
+
+/*!
+ * \brief Handles a downlink MAC command
+ *
+ * \param [IN] payload Command payload, following the CID
+ * \param [IN] size    Bytes left in the command buffer after the CID, at
+ *                     least the descriptor length
+ * \param [IN] snr     The SNR value of the frame
+ *
+ * \retval Number of payload bytes consumed
+ */
+typedef uint8_t ( *MacCommandHandler_t )( uint8_t *payload, uint8_t size, uint8_t snr );
+
+/*!
+ * MAC command descriptor. The tables are indexed by CID, one per direction;
+ * a CID without descriptor is unknown.
+ */
+typedef struct sMacCommand
+{
+    /*!
+     * Known command
+     */
+    bool Valid;
+    /*!
+     * Payload length, CID excluded
+     */
+    uint8_t Length;
+    /*!
+     * MAC_CMD_STICKY: the answer is repeated until a downlink is received.
+     * MAC_CMD_SCHEDULE_UPLINK: the answer requests an uplink to be sent.
+     */
+    uint8_t Flags;
+    /*!
+     * Downlink commands handler
+     */
+    MacCommandHandler_t Handler;
+}MacCommand_t;
+
+static uint8_t OnLinkCheckAns( uint8_t *payload, uint8_t size, uint8_t snr );
+static uint8_t OnLinkAdrReq( uint8_t *payload, uint8_t size, uint8_t snr );
+static uint8_t OnDutyCycleReq( uint8_t *payload, uint8_t size, uint8_t snr );
+static uint8_t OnRxParamSetupReq( uint8_t *payload, uint8_t size, uint8_t snr );
+static uint8_t OnDevStatusReq( uint8_t *payload, uint8_t size, uint8_t snr );
+static uint8_t OnNewChannelReq( uint8_t *payload, uint8_t size, uint8_t snr );
+static uint8_t OnRxTimingSetupReq( uint8_t *payload, uint8_t size, uint8_t snr );
+static uint8_t OnTxParamSetupReq( uint8_t *payload, uint8_t size, uint8_t snr );
+static uint8_t OnDlChannelReq( uint8_t *payload, uint8_t size, uint8_t snr );
+static uint8_t OnDeviceTimeAns( uint8_t *payload, uint8_t size, uint8_t snr );
+
+/*!
+ * Highest CID known in either direction
+ */
+#define MAC_CMD_CID_MAX                             0x13
+
+/*!
+ * Commands sent by the end-device
+ */
+static const MacCommand_t MacCommandsUp[MAC_CMD_CID_MAX + 1] =
+{
+    [MOTE_MAC_LINK_CHECK_REQ]      = { true, 0, 0, NULL },
+    [MOTE_MAC_LINK_ADR_ANS]        = { true, 1, 0, NULL },
+    [MOTE_MAC_DUTY_CYCLE_ANS]      = { true, 0, 0, NULL },
+    [MOTE_MAC_RX_PARAM_SETUP_ANS]  = { true, 1, MAC_CMD_STICKY | MAC_CMD_SCHEDULE_UPLINK, NULL },
+    [MOTE_MAC_DEV_STATUS_ANS]      = { true, 2, MAC_CMD_SCHEDULE_UPLINK, NULL },
+    [MOTE_MAC_NEW_CHANNEL_ANS]     = { true, 1, 0, NULL },
+    [MOTE_MAC_RX_TIMING_SETUP_ANS] = { true, 0, MAC_CMD_STICKY | MAC_CMD_SCHEDULE_UPLINK, NULL },
+    [MOTE_MAC_TX_PARAM_SETUP_ANS]  = { true, 0, 0, NULL },
+    [MOTE_MAC_DL_CHANNEL_ANS]      = { true, 1, MAC_CMD_STICKY | MAC_CMD_SCHEDULE_UPLINK, NULL },
+    [MOTE_MAC_DEVICE_TIME_REQ]     = { true, 0, 0, NULL },
+    [MOTE_MAC_PING_SLOT_INFO_REQ]  = { true, 1, 0, NULL },
+    [MOTE_MAC_PING_SLOT_FREQ_ANS]  = { true, 1, MAC_CMD_SCHEDULE_UPLINK, NULL },
+    [MOTE_MAC_BEACON_TIMING_REQ]   = { true, 0, 0, NULL },
+    [MOTE_MAC_BEACON_FREQ_ANS]     = { true, 1, MAC_CMD_SCHEDULE_UPLINK, NULL },
+};
+
+/*!
+ * Commands sent by the network server. The class B commands are not handled
+ * and abort the processing like any unknown command.
+ */
+static const MacCommand_t MacCommandsDown[MAC_CMD_CID_MAX + 1] =
+{
+    [SRV_MAC_LINK_CHECK_ANS]       = { true, 2, 0, OnLinkCheckAns },
+    [SRV_MAC_LINK_ADR_REQ]         = { true, 4, 0, OnLinkAdrReq },
+    [SRV_MAC_DUTY_CYCLE_REQ]       = { true, 1, 0, OnDutyCycleReq },
+    [SRV_MAC_RX_PARAM_SETUP_REQ]   = { true, 4, 0, OnRxParamSetupReq },
+    [SRV_MAC_DEV_STATUS_REQ]       = { true, 0, 0, OnDevStatusReq },
+    [SRV_MAC_NEW_CHANNEL_REQ]      = { true, 5, 0, OnNewChannelReq },
+    [SRV_MAC_RX_TIMING_SETUP_REQ]  = { true, 1, 0, OnRxTimingSetupReq },
+    [SRV_MAC_TX_PARAM_SETUP_REQ]   = { true, 1, 0, OnTxParamSetupReq },
+    [SRV_MAC_DL_CHANNEL_REQ]       = { true, 4, 0, OnDlChannelReq },
+    [SRV_MAC_DEVICE_TIME_ANS]      = { true, 5, 0, OnDeviceTimeAns },
+};
+
 static LoRaMacStatus_t AddMacCommand( uint8_t cmd, uint8_t p1, uint8_t p2 )
 {
-    LoRaMacStatus_t status = LORAMAC_STATUS_BUSY;
+    const MacCommand_t *desc;
     // The maximum buffer length must take MAC commands to re-send into account.
-    uint8_t bufLen = LORA_MAC_COMMAND_MAX_LENGTH - MacCommandsBufferToRepeatIndex;
+    uint8_t bufLen = LORA_MAC_COMMAND_MAX_LENGTH - Ctx->MacCommandsBufferToRepeatIndex;
 
-    switch ( cmd ) {
-        case MOTE_MAC_LINK_CHECK_REQ:
-            if ( MacCommandsBufferIndex < bufLen ) {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // No payload for this command
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        case MOTE_MAC_LINK_ADR_ANS:
-            if ( MacCommandsBufferIndex < ( bufLen - 1 ) ) {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // Margin
-                MacCommandsBuffer[MacCommandsBufferIndex++] = p1;
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        case MOTE_MAC_DUTY_CYCLE_ANS:
-            if ( MacCommandsBufferIndex < bufLen ) {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // No payload for this answer
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        case MOTE_MAC_RX_PARAM_SETUP_ANS:
-            if ( MacCommandsBufferIndex < ( bufLen - 1 ) ) {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // Status: Datarate ACK, Channel ACK
-                MacCommandsBuffer[MacCommandsBufferIndex++] = p1;
-                // This is a sticky MAC command answer. Setup indication
-                SetMlmeScheduleUplinkIndication( );
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        case MOTE_MAC_DEV_STATUS_ANS:
-            if ( MacCommandsBufferIndex < ( bufLen - 2 ) ) {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // 1st byte Battery
-                // 2nd byte Margin
-                MacCommandsBuffer[MacCommandsBufferIndex++] = p1;
-                MacCommandsBuffer[MacCommandsBufferIndex++] = p2;
-                SetMlmeScheduleUplinkIndication( );
-                status = LORAMAC_STATUS_OK;
-#ifdef LORAMAC_CLASSB_TESTCASE
-                DBG_PRINTF("ready to send MOTE_MAC_DEV_STATUS_ANS p1=%d p2=%d\r\n",p1,p2);
-#endif
-            }
-            break;
-        case MOTE_MAC_NEW_CHANNEL_ANS:
-            if ( MacCommandsBufferIndex < ( bufLen - 1 ) ) {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // Status: Datarate range OK, Channel frequency OK
-                MacCommandsBuffer[MacCommandsBufferIndex++] = p1;
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        case MOTE_MAC_RX_TIMING_SETUP_ANS:
-            if ( MacCommandsBufferIndex < bufLen ) {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // No payload for this answer
-                // This is a sticky MAC command answer. Setup indication
-                SetMlmeScheduleUplinkIndication( );
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        case MOTE_MAC_TX_PARAM_SETUP_ANS:
-            if ( MacCommandsBufferIndex < bufLen ) {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // No payload for this answer
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        case MOTE_MAC_DL_CHANNEL_ANS:
-            if ( MacCommandsBufferIndex < bufLen ) {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // Status: Uplink frequency exists, Channel frequency OK
-                MacCommandsBuffer[MacCommandsBufferIndex++] = p1;
-                // This is a sticky MAC command answer. Setup indication
-                SetMlmeScheduleUplinkIndication( );
+    if ( ( cmd > MAC_CMD_CID_MAX ) || ( MacCommandsUp[cmd].Valid == false ) ) {
+        return LORAMAC_STATUS_SERVICE_UNKNOWN;
+    }
+    desc = &MacCommandsUp[cmd];
 
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        case MOTE_MAC_DEVICE_TIME_REQ:
-            if( MacCommandsBufferIndex < LORA_MAC_COMMAND_MAX_LENGTH )
-            {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // No payload for this answer
-               status = LORAMAC_STATUS_OK;
-#ifdef LORAMAC_CLASSB_TESTCASE
-                DBG_PRINTF("ready to send MOTE_MAC_DEVICE_TIME_REQ\r\n");
-#endif
-            }
-            break;
-        case MOTE_MAC_PING_SLOT_INFO_REQ:
-            if( MacCommandsBufferIndex < ( LORA_MAC_COMMAND_MAX_LENGTH - 1 ) )
-            {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // Status: Periodicity and Datarate
-                MacCommandsBuffer[MacCommandsBufferIndex++] = p1;
-                status = LORAMAC_STATUS_OK;
+    if ( ( Ctx->MacCommandsBufferIndex + 1 + desc->Length ) > bufLen ) {
+        return LORAMAC_STATUS_BUSY;
+    }
+
+    Ctx->MacCommandsBuffer[Ctx->MacCommandsBufferIndex++] = cmd;
+    if ( desc->Length > 0 ) {
+        Ctx->MacCommandsBuffer[Ctx->MacCommandsBufferIndex++] = p1;
+    }
+    if ( desc->Length > 1 ) {
+        Ctx->MacCommandsBuffer[Ctx->MacCommandsBufferIndex++] = p2;
+    }
 #ifdef LORAMAC_CLASSB_TESTCASE
-                DBG_PRINTF("ready to send MOTE_MAC_PING_SLOT_INFO_REQ value=%d\r\n",p1);
+    DBG_PRINTF("ready to send MAC command 0x%02X p1=%d p2=%d\r\n",cmd,p1,p2);
 #endif
-            }
-            break;
-        case MOTE_MAC_PING_SLOT_FREQ_ANS:
-            if( MacCommandsBufferIndex < LORA_MAC_COMMAND_MAX_LENGTH )
-            {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // Status: Datarate range OK, Channel frequency OK
-                MacCommandsBuffer[MacCommandsBufferIndex++] = p1;
-                SetMlmeScheduleUplinkIndication( );
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        case MOTE_MAC_BEACON_TIMING_REQ:
-            if( MacCommandsBufferIndex < LORA_MAC_COMMAND_MAX_LENGTH )
-            {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // No payload for this answer
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        case MOTE_MAC_BEACON_FREQ_ANS:
-            if( MacCommandsBufferIndex < LORA_MAC_COMMAND_MAX_LENGTH )
-            {
-                MacCommandsBuffer[MacCommandsBufferIndex++] = cmd;
-                // Status: Channel frequency OK
-                MacCommandsBuffer[MacCommandsBufferIndex++] = p1;
-                SetMlmeScheduleUplinkIndication( );
-                status = LORAMAC_STATUS_OK;
-            }
-            break;
-        default:
-            return LORAMAC_STATUS_SERVICE_UNKNOWN;
-    }
-    if ( status == LORAMAC_STATUS_OK ) {
-        MacCommandsInNextTx = true;
-        if (SrvAckRequested) {
-            SetMlmeScheduleUplinkIndication();
-        }
+
+    Ctx->MacCommandsInNextTx = true;
+    if ( ( ( desc->Flags & MAC_CMD_SCHEDULE_UPLINK ) != 0 ) || ( Ctx->SrvAckRequested == true ) ) {
+        SetMlmeScheduleUplinkIndication( );
     }
-    return status;
+    return LORAMAC_STATUS_OK;
 }
 
 static uint8_t ParseMacCommandsToRepeat( uint8_t *cmdBufIn, uint8_t length, uint8_t *cmdBufOut )
 {
     uint8_t i = 0;
     uint8_t cmdCount = 0;
+    uint8_t cmdLen;
 
     if ( ( cmdBufIn == NULL ) || ( cmdBufOut == NULL ) ) {
         return 0;
     }
 
-    for ( i = 0; i < length; i++ ) {
-        switch ( cmdBufIn[i] ) {
-            // STICKY
-            case MOTE_MAC_DL_CHANNEL_ANS:
-            case MOTE_MAC_RX_PARAM_SETUP_ANS: {
-                // 1 byte payload
-                cmdBufOut[cmdCount++] = cmdBufIn[i++];
-                cmdBufOut[cmdCount++] = cmdBufIn[i];
-                break;
-            }
-            case MOTE_MAC_RX_TIMING_SETUP_ANS: {
-                // 0 byte payload
-                cmdBufOut[cmdCount++] = cmdBufIn[i];
-                break;
-            }
-            // NON-STICKY
-            case MOTE_MAC_DEV_STATUS_ANS: {
-                // 2 bytes payload
-                i += 2;
-                break;
-            }
-            case MOTE_MAC_LINK_ADR_ANS:
-            case MOTE_MAC_NEW_CHANNEL_ANS: {
-                // 1 byte payload
-                i++;
-                break;
-            }
-            case MOTE_MAC_TX_PARAM_SETUP_ANS:
-            case MOTE_MAC_DUTY_CYCLE_ANS:
-            case MOTE_MAC_LINK_CHECK_REQ: {
-                // 0 byte payload
-                break;
-            }
-            default:
-                break;
+    while ( i < length ) {
+        if ( ( cmdBufIn[i] > MAC_CMD_CID_MAX ) || ( MacCommandsUp[cmdBufIn[i]].Valid == false ) ) {
+            // Cannot happen, the buffer is built by AddMacCommand
+            break;
         }
+        cmdLen = 1 + MacCommandsUp[cmdBufIn[i]].Length;
+        if ( ( i + cmdLen ) > length ) {
+            break;
+        }
+        if ( ( MacCommandsUp[cmdBufIn[i]].Flags & MAC_CMD_STICKY ) != 0 ) {
+            memcpy1( &cmdBufOut[cmdCount], &cmdBufIn[i], cmdLen );
+            cmdCount += cmdLen;
+        }
+        i += cmdLen;
     }
 
     return cmdCount;
 }
 
-static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t commandsSize, uint8_t snr, LoRaMacRxSlot_t rxSlot )
+static uint8_t OnLinkCheckAns( uint8_t *payload, uint8_t size, uint8_t snr )
 {
-    uint8_t status = 0;
-    while ( macIndex < commandsSize ) {
-        // Decode Frame MAC commands
-        switch ( payload[macIndex++] ) {
-            case SRV_MAC_LINK_CHECK_ANS:
-                if( LoRaMacConfirmQueueIsCmdActive( MLME_LINK_CHECK ) == true )
-                {
-                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_LINK_CHECK );
-                	MlmeConfirm.DemodMargin = payload[macIndex++];
-                	MlmeConfirm.NbGateways = payload[macIndex++];
-                }
-                break;
-            case SRV_MAC_LINK_ADR_REQ: {
-                LinkAdrReqParams_t linkAdrReq;
-                int8_t linkAdrDatarate = DR_0;
-                int8_t linkAdrTxPower = TX_POWER_0;
-                uint8_t linkAdrNbRep = 0;
-                uint8_t linkAdrNbBytesParsed = 0;
-
-                // Fill parameter structure
-                linkAdrReq.Payload = &payload[macIndex - 1];
-                linkAdrReq.PayloadSize = commandsSize - ( macIndex - 1 );
-                linkAdrReq.AdrEnabled = AdrCtrlOn;
-                linkAdrReq.UplinkDwellTime = LoRaMacParams.UplinkDwellTime;
-                linkAdrReq.CurrentDatarate = LoRaMacParams.ChannelsDatarate;
-                linkAdrReq.CurrentTxPower = LoRaMacParams.ChannelsTxPower;
-                linkAdrReq.CurrentNbRep = LoRaMacParams.ChannelsNbRep;
-                // Process the ADR requests
-                status = RegionLinkAdrReq( LoRaMacRegion, &linkAdrReq, &linkAdrDatarate,
-                                           &linkAdrTxPower, &linkAdrNbRep, &linkAdrNbBytesParsed );
-                //printf("status:%d\r\n",status);
-
-                if ( ( status & 0x07 ) == 0x07 ) {
-                    LoRaMacParams.ChannelsDatarate = linkAdrDatarate;
-                    //SaveDr();
-                    LoRaMacParams.ChannelsTxPower = linkAdrTxPower;
-                    LoRaMacParams.ChannelsNbRep = linkAdrNbRep;
-                }
+    LinkUpdateMargin( payload[0], payload[1] );
+    if( LoRaMacConfirmQueueIsCmdActive( MLME_LINK_CHECK ) == true )
+    {
+        LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_LINK_CHECK );
+        Ctx->MlmeConfirm.DemodMargin = payload[0];
+        Ctx->MlmeConfirm.NbGateways = payload[1];
+    }
+    return 2;
+}
 
-                // Add the answers to the buffer
-                for ( uint8_t i = 0; i < ( linkAdrNbBytesParsed / 5 ); i++ ) {
-                    AddMacCommand( MOTE_MAC_LINK_ADR_ANS, status, 0 );
-                }
-                // Update MAC index
-                macIndex += linkAdrNbBytesParsed - 1;
-            }
-            break;
-            case SRV_MAC_DUTY_CYCLE_REQ:
-                MaxDCycle = payload[macIndex++];
-                AggregatedDCycle = 1 << MaxDCycle;
-                AddMacCommand( MOTE_MAC_DUTY_CYCLE_ANS, 0, 0 );
-                break;
-            case SRV_MAC_RX_PARAM_SETUP_REQ: {
-                RxParamSetupReqParams_t rxParamSetupReq;
-                status = 0x07;
-
-                rxParamSetupReq.DrOffset = ( payload[macIndex] >> 4 ) & 0x07;
-                rxParamSetupReq.Datarate = payload[macIndex] & 0x0F;
-                macIndex++;
-
-                rxParamSetupReq.Frequency =  ( uint32_t )payload[macIndex++];
-                rxParamSetupReq.Frequency |= ( uint32_t )payload[macIndex++] << 8;
-                rxParamSetupReq.Frequency |= ( uint32_t )payload[macIndex++] << 16;
-                rxParamSetupReq.Frequency *= 100;
-
-                // Perform request on region
-                status = RegionRxParamSetupReq( LoRaMacRegion, &rxParamSetupReq );
-
-                if ( ( status & 0x07 ) == 0x07 ) {
-                    LoRaMacParams.Rx2Channel.Datarate = rxParamSetupReq.Datarate;
-                    LoRaMacParams.Rx2Channel.Frequency = rxParamSetupReq.Frequency;
-                    LoRaMacParams.Rx1DrOffset = rxParamSetupReq.DrOffset;
-                }
-                AddMacCommand( MOTE_MAC_RX_PARAM_SETUP_ANS, status, 0 );
-            }
-            break;
-            case SRV_MAC_DEV_STATUS_REQ: {
-                uint8_t batteryLevel = BAT_LEVEL_NO_MEASURE;
-                if ( ( LoRaMacCallbacks != NULL ) && ( LoRaMacCallbacks->GetBatteryLevel != NULL ) ) {
-                    batteryLevel = LoRaMacCallbacks->GetBatteryLevel( );
-                }
+static uint8_t OnLinkAdrReq( uint8_t *payload, uint8_t size, uint8_t snr )
+{
+    LinkAdrReqParams_t linkAdrReq;
+    int8_t linkAdrDatarate = DR_0;
+    int8_t linkAdrTxPower = TX_POWER_0;
+    uint8_t linkAdrNbRep = 0;
+    uint8_t linkAdrNbBytesParsed = 0;
+    uint8_t blockSize = 5;
+    uint8_t status;
+
+    // The region reads 5 bytes for each LinkAdrReq CID it finds, only the
+    // complete commands of the block are given to it
+    while ( ( ( blockSize + 5 ) <= ( size + 1 ) ) && ( payload[blockSize - 1] == SRV_MAC_LINK_ADR_REQ ) ) {
+        blockSize += 5;
+    }
+
+    // Fill parameter structure. The region parses the whole block of
+    // contiguous LinkAdrReq commands, CID included.
+    linkAdrReq.Payload = payload - 1;
+    linkAdrReq.PayloadSize = blockSize;
+    linkAdrReq.AdrEnabled = Ctx->AdrCtrlOn;
+    linkAdrReq.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
+    linkAdrReq.CurrentDatarate = Ctx->LoRaMacParams.ChannelsDatarate;
+    linkAdrReq.CurrentTxPower = Ctx->LoRaMacParams.ChannelsTxPower;
+    linkAdrReq.CurrentNbRep = Ctx->LoRaMacParams.ChannelsNbRep;
+    // Process the ADR requests
+    status = RegionLinkAdrReq( Ctx->LoRaMacRegion, &linkAdrReq, &linkAdrDatarate,
+                               &linkAdrTxPower, &linkAdrNbRep, &linkAdrNbBytesParsed );
+
+    if ( ( status & 0x07 ) == 0x07 ) {
+        Ctx->LoRaMacParams.ChannelsDatarate = linkAdrDatarate;
+        Ctx->LoRaMacParams.ChannelsTxPower = linkAdrTxPower;
+        Ctx->LoRaMacParams.ChannelsNbRep = linkAdrNbRep;
+        Ctx->AdrStatus.LinkAdrReqCount++;
+        Ctx->AdrStatus.LastLinkAdrReqTime = TimerGetCurrentTime( );
+    }
+
+    // Add the answers to the buffer
+    for ( uint8_t i = 0; i < ( linkAdrNbBytesParsed / 5 ); i++ ) {
+        AddMacCommand( MOTE_MAC_LINK_ADR_ANS, status, 0 );
+    }
+    if ( linkAdrNbBytesParsed < 5 ) {
+        // Never consume less than the command itself
+        return 4;
+    }
+    return linkAdrNbBytesParsed - 1;
+}
+
+static uint8_t OnDutyCycleReq( uint8_t *payload, uint8_t size, uint8_t snr )
+{
+    Ctx->MaxDCycle = payload[0] & 0x0F;
+    Ctx->AggregatedDCycle = 1 << Ctx->MaxDCycle;
+    AddMacCommand( MOTE_MAC_DUTY_CYCLE_ANS, 0, 0 );
+    return 1;
+}
+
+static uint8_t OnRxParamSetupReq( uint8_t *payload, uint8_t size, uint8_t snr )
+{
+    RxParamSetupReqParams_t rxParamSetupReq;
+    uint8_t status;
+
+    rxParamSetupReq.DrOffset = ( payload[0] >> 4 ) & 0x07;
+    rxParamSetupReq.Datarate = payload[0] & 0x0F;
+
+    rxParamSetupReq.Frequency =  ( uint32_t )payload[1];
+    rxParamSetupReq.Frequency |= ( uint32_t )payload[2] << 8;
+    rxParamSetupReq.Frequency |= ( uint32_t )payload[3] << 16;
+    rxParamSetupReq.Frequency *= 100;
+
+    // Perform request on region
+    status = RegionRxParamSetupReq( Ctx->LoRaMacRegion, &rxParamSetupReq );
+
+    if ( ( status & 0x07 ) == 0x07 ) {
+        Ctx->LoRaMacParams.Rx2Channel.Datarate = rxParamSetupReq.Datarate;
+        Ctx->LoRaMacParams.Rx2Channel.Frequency = rxParamSetupReq.Frequency;
+        Ctx->LoRaMacParams.Rx1DrOffset = rxParamSetupReq.DrOffset;
+    }
+    AddMacCommand( MOTE_MAC_RX_PARAM_SETUP_ANS, status, 0 );
+    return 4;
+}
+
+static uint8_t OnDevStatusReq( uint8_t *payload, uint8_t size, uint8_t snr )
+{
+    uint8_t batteryLevel = BAT_LEVEL_NO_MEASURE;
+    if ( ( Ctx->LoRaMacCallbacks != NULL ) && ( Ctx->LoRaMacCallbacks->GetBatteryLevel != NULL ) ) {
+        batteryLevel = Ctx->LoRaMacCallbacks->GetBatteryLevel( );
+    }
 #ifdef LORAMAC_CLASSB_TESTCASE
-                DBG_PRINTF("receive SRV_MAC_DEV_STATUS_REQ\r\n");
+    DBG_PRINTF("receive SRV_MAC_DEV_STATUS_REQ\r\n");
 #endif
-                AddMacCommand( MOTE_MAC_DEV_STATUS_ANS, batteryLevel, snr );
-                break;
-            }
-            case SRV_MAC_NEW_CHANNEL_REQ: {
-                NewChannelReqParams_t newChannelReq;
-                ChannelParams_t chParam;
-                status = 0x03;
+    AddMacCommand( MOTE_MAC_DEV_STATUS_ANS, batteryLevel, snr );
+    return 0;
+}
 
-                newChannelReq.ChannelId = payload[macIndex++];
-                newChannelReq.NewChannel = &chParam;
+static uint8_t OnNewChannelReq( uint8_t *payload, uint8_t size, uint8_t snr )
+{
+    NewChannelReqParams_t newChannelReq;
+    ChannelParams_t chParam;
+    uint8_t status;
 
-                chParam.Frequency = ( uint32_t )payload[macIndex++];
-                chParam.Frequency |= ( uint32_t )payload[macIndex++] << 8;
-                chParam.Frequency |= ( uint32_t )payload[macIndex++] << 16;
-                chParam.Frequency *= 100;
-                chParam.Rx1Frequency = 0;
-                chParam.DrRange.Value = payload[macIndex++];
+    newChannelReq.ChannelId = payload[0];
+    newChannelReq.NewChannel = &chParam;
 
-                status = RegionNewChannelReq( LoRaMacRegion, &newChannelReq );
+    chParam.Frequency = ( uint32_t )payload[1];
+    chParam.Frequency |= ( uint32_t )payload[2] << 8;
+    chParam.Frequency |= ( uint32_t )payload[3] << 16;
+    chParam.Frequency *= 100;
+    chParam.Rx1Frequency = 0;
+    chParam.DrRange.Value = payload[4];
 
-                AddMacCommand( MOTE_MAC_NEW_CHANNEL_ANS, status, 0 );
-            }
-            break;
-            case SRV_MAC_RX_TIMING_SETUP_REQ: {
-                uint8_t delay = payload[macIndex++] & 0x0F;
+    status = RegionNewChannelReq( Ctx->LoRaMacRegion, &newChannelReq );
 
-                if ( delay == 0 ) {
-                    delay++;
-                }
-                LoRaMacParams.ReceiveDelay1 = delay * 1000;
-                LoRaMacParams.ReceiveDelay2 = LoRaMacParams.ReceiveDelay1 + 1000;
-                AddMacCommand( MOTE_MAC_RX_TIMING_SETUP_ANS, 0, 0 );
-            }
-            break;
-            case SRV_MAC_TX_PARAM_SETUP_REQ: {
-                TxParamSetupReqParams_t txParamSetupReq;
-                uint8_t eirpDwellTime = payload[macIndex++];
+    AddMacCommand( MOTE_MAC_NEW_CHANNEL_ANS, status, 0 );
+    return 5;
+}
 
-                txParamSetupReq.UplinkDwellTime = 0;
-                txParamSetupReq.DownlinkDwellTime = 0;
+static uint8_t OnRxTimingSetupReq( uint8_t *payload, uint8_t size, uint8_t snr )
+{
+    uint8_t delay = payload[0] & 0x0F;
 
-                if ( ( eirpDwellTime & 0x20 ) == 0x20 ) {
-                    txParamSetupReq.DownlinkDwellTime = 1;
-                }
-                if ( ( eirpDwellTime & 0x10 ) == 0x10 ) {
-                    txParamSetupReq.UplinkDwellTime = 1;
-                }
-                txParamSetupReq.MaxEirp = eirpDwellTime & 0x0F;
-
-                // Check the status for correctness
-                if ( RegionTxParamSetupReq( LoRaMacRegion, &txParamSetupReq ) != -1 ) {
-                    // Accept command
-                    LoRaMacParams.UplinkDwellTime = txParamSetupReq.UplinkDwellTime;
-                    LoRaMacParams.DownlinkDwellTime = txParamSetupReq.DownlinkDwellTime;
-                    LoRaMacParams.MaxEirp = LoRaMacMaxEirpTable[txParamSetupReq.MaxEirp];
-                    // Add command response
-                    AddMacCommand( MOTE_MAC_TX_PARAM_SETUP_ANS, 0, 0 );
-                }
-            }
-            break;
-            case SRV_MAC_DL_CHANNEL_REQ: {
-                DlChannelReqParams_t dlChannelReq;
-                status = 0x03;
+    if ( delay == 0 ) {
+        delay++;
+    }
+    Ctx->LoRaMacParams.ReceiveDelay1 = delay * 1000;
+    Ctx->LoRaMacParams.ReceiveDelay2 = Ctx->LoRaMacParams.ReceiveDelay1 + 1000;
+    AddMacCommand( MOTE_MAC_RX_TIMING_SETUP_ANS, 0, 0 );
+    return 1;
+}
 
-                dlChannelReq.ChannelId = payload[macIndex++];
-                dlChannelReq.Rx1Frequency = ( uint32_t )payload[macIndex++];
-                dlChannelReq.Rx1Frequency |= ( uint32_t )payload[macIndex++] << 8;
-                dlChannelReq.Rx1Frequency |= ( uint32_t )payload[macIndex++] << 16;
-                dlChannelReq.Rx1Frequency *= 100;
+static uint8_t OnTxParamSetupReq( uint8_t *payload, uint8_t size, uint8_t snr )
+{
+    TxParamSetupReqParams_t txParamSetupReq;
+    uint8_t eirpDwellTime = payload[0];
 
-                status = RegionDlChannelReq( LoRaMacRegion, &dlChannelReq );
+    txParamSetupReq.UplinkDwellTime = 0;
+    txParamSetupReq.DownlinkDwellTime = 0;
 
-                AddMacCommand( MOTE_MAC_DL_CHANNEL_ANS, status, 0 );
-            }
-            break;
-            case SRV_MAC_DEVICE_TIME_ANS:
-            {
-                if( LoRaMacConfirmQueueIsCmdActive( MLME_DEVICE_TIME ) == true )
-                {
-                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_DEVICE_TIME );
-                    struct timeval gpsEpochTime = { 0 };
-                    struct timeval sysTime = { 0 };
-                    struct timeval sysTimeCurrent = { 0 };
+    if ( ( eirpDwellTime & 0x20 ) == 0x20 ) {
+        txParamSetupReq.DownlinkDwellTime = 1;
+    }
+    if ( ( eirpDwellTime & 0x10 ) == 0x10 ) {
+        txParamSetupReq.UplinkDwellTime = 1;
+    }
+    txParamSetupReq.MaxEirp = eirpDwellTime & 0x0F;
+
+    // Check the status for correctness
+    if ( RegionTxParamSetupReq( Ctx->LoRaMacRegion, &txParamSetupReq ) != -1 ) {
+        // Accept command
+        Ctx->LoRaMacParams.UplinkDwellTime = txParamSetupReq.UplinkDwellTime;
+        Ctx->LoRaMacParams.DownlinkDwellTime = txParamSetupReq.DownlinkDwellTime;
+        Ctx->LoRaMacParams.MaxEirp = LoRaMacMaxEirpTable[txParamSetupReq.MaxEirp];
+        // Add command response
+        AddMacCommand( MOTE_MAC_TX_PARAM_SETUP_ANS, 0, 0 );
+    }
+    return 1;
+}
+
+static uint8_t OnDlChannelReq( uint8_t *payload, uint8_t size, uint8_t snr )
+{
+    DlChannelReqParams_t dlChannelReq;
+    uint8_t status;
+
+    dlChannelReq.ChannelId = payload[0];
+    dlChannelReq.Rx1Frequency = ( uint32_t )payload[1];
+    dlChannelReq.Rx1Frequency |= ( uint32_t )payload[2] << 8;
+    dlChannelReq.Rx1Frequency |= ( uint32_t )payload[3] << 16;
+    dlChannelReq.Rx1Frequency *= 100;
 
-                    gpsEpochTime.tv_sec  = (typeof (gpsEpochTime.tv_sec)) payload [macIndex++];
-                    gpsEpochTime.tv_sec |= (typeof (gpsEpochTime.tv_sec)) payload [macIndex++] << 8;
-                    gpsEpochTime.tv_sec |= (typeof (gpsEpochTime.tv_sec)) payload [macIndex++] << 16;
-                    gpsEpochTime.tv_sec |= (typeof (gpsEpochTime.tv_sec)) payload [macIndex++] << 24;
-                    gpsEpochTime.tv_usec =                                payload [macIndex++];
+    status = RegionDlChannelReq( Ctx->LoRaMacRegion, &dlChannelReq );
 
-                    // Convert the fractional second received to ms
-                    // round (pow (0.5, 8.0) * 1000) = 3.90625ms per bit
-                    gpsEpochTime.tv_usec *= 3906;
+    AddMacCommand( MOTE_MAC_DL_CHANNEL_ANS, status, 0 );
+    return 4;
+}
 
-                    // Copy received GPS Epoch time into system time
-                    sysTime = gpsEpochTime;
+static uint8_t OnDeviceTimeAns( uint8_t *payload, uint8_t size, uint8_t snr )
+{
+    if( LoRaMacConfirmQueueIsCmdActive( MLME_DEVICE_TIME ) == true )
+    {
+        LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_DEVICE_TIME );
+        struct timeval gpsEpochTime = { 0 };
 
-                    // Add Unix to Gps epcoh offset. The system time is based on Unix time.
-                    sysTime.tv_sec += UNIX_GPS_EPOCH_OFFSET;
+        gpsEpochTime.tv_sec  = (typeof (gpsEpochTime.tv_sec)) payload [0];
+        gpsEpochTime.tv_sec |= (typeof (gpsEpochTime.tv_sec)) payload [1] << 8;
+        gpsEpochTime.tv_sec |= (typeof (gpsEpochTime.tv_sec)) payload [2] << 16;
+        gpsEpochTime.tv_sec |= (typeof (gpsEpochTime.tv_sec)) payload [3] << 24;
 
-                    // Compensate time difference between Tx Done time and now
-                    gettimeofday (&sysTimeCurrent, NULL);
-                    sysTime = add_timeval (sysTimeCurrent, sub_timeval (sysTime, LastTxSysTime));
+        // Convert the fractional second received, in 1/256 s, to us
+        gpsEpochTime.tv_usec = ((typeof (gpsEpochTime.tv_usec)) payload [4] * 1000000) >> 8;
 
-                    // Apply the new system time.
-                    settimeofday (&sysTime, NULL);
+        // The network time is the one of the end of the uplink
+        SysTimeSync (gpsEpochTime, Ctx->LastTxSysTime);
 #if 0
-                    // Implemented in LoRaMacClassB.c (when it's finally added)
-                    LoRaMacClassBDeviceTimeAns( );
+        // Implemented in LoRaMacClassB.c (when it's finally added)
+        LoRaMacClassBDeviceTimeAns( );
 #endif
-                    McpsIndication.DeviceTimeAnsReceived = true;
-                }
-                break;
-            }
-            default:
-                // Unknown command. ABORT MAC commands processing
-                return;
+        Ctx->McpsIndication.DeviceTimeAnsReceived = true;
+    }
+    return 5;
+}
+
+static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t commandsSize, uint8_t snr, LoRaMacRxSlot_t rxSlot )
+{
+    const MacCommand_t *desc;
+    uint8_t cid;
+    uint8_t left;
+    uint8_t parsed;
+
+    while ( macIndex < commandsSize ) {
+        // Decode Frame MAC commands
+        cid = payload[macIndex];
+        TRACE( TRACE_EVENT_MAC_CMD, cid, macIndex );
+        left = commandsSize - macIndex - 1;
+
+        // Unknown and truncated commands abort the processing before anything
+        // is read past the end of the buffer
+        if ( ( cid > MAC_CMD_CID_MAX ) || ( MacCommandsDown[cid].Valid == false ) ||
+             ( MacCommandsDown[cid].Length > left ) ) {
+            Ctx->Statistics.MacCommandsRejected++;
+            return;
         }
+        desc = &MacCommandsDown[cid];
+        macIndex++;
+
+        parsed = desc->Handler( &payload[macIndex], left, snr );
+        if ( parsed > left ) {
+            parsed = left;
+        }
+        macIndex += parsed;
+        Ctx->Statistics.MacCommands++;
     }
 }
 
@@ -2074,7 +2382,7 @@ LoRaMacStatus_t Send( LoRaMacHeader_t *macHdr, uint8_t fPort, void *fBuffer, uin
 
     fCtrl.Value = 0;
     fCtrl.Bits.FOptsLen      = 0;
-    if( LoRaMacDeviceClass == CLASS_B )
+    if( Ctx->LoRaMacDeviceClass == CLASS_B )
     {
         fCtrl.Bits.FPending      = 1;
     }
@@ -2084,7 +2392,7 @@ LoRaMacStatus_t Send( LoRaMacHeader_t *macHdr, uint8_t fPort, void *fBuffer, uin
     }
     fCtrl.Bits.Ack           = false;
     fCtrl.Bits.AdrAckReq     = false;
-    fCtrl.Bits.Adr           = AdrCtrlOn;
+    fCtrl.Bits.Adr           = Ctx->AdrCtrlOn;
 
     // Prepare the frame
     status = PrepareFrame( macHdr, &fCtrl, fPort, fBuffer, fBufferSize );
@@ -2095,9 +2403,9 @@ LoRaMacStatus_t Send( LoRaMacHeader_t *macHdr, uint8_t fPort, void *fBuffer, uin
     }
 
     // Reset confirm parameters
-    McpsConfirm.NbRetries = 0;
-    McpsConfirm.AckReceived = false;
-    McpsConfirm.UpLinkCounter = UpLinkCounter;
+    Ctx->McpsConfirm.NbRetries = 0;
+    Ctx->McpsConfirm.AckReceived = false;
+    Ctx->McpsConfirm.UpLinkCounter = Ctx->UpLinkCounter;
 
     status = ScheduleTx( );
 
@@ -2108,150 +2416,700 @@ static LoRaMacStatus_t ScheduleTx( void )
 {
     TimerTime_t dutyCycleTimeOff = 0;
     NextChanParams_t nextChan;
+    uint8_t draws;
 
     // Check if the device is off
-    if ( MaxDCycle == 255 ) {
+    if ( Ctx->MaxDCycle == 255 ) {
         return LORAMAC_STATUS_DEVICE_OFF;
     }
-    if ( MaxDCycle == 0 ) {
-        AggregatedTimeOff = 0;
+    if ( Ctx->MaxDCycle == 0 ) {
+        Ctx->AggregatedTimeOff = 0;
     }
 
-    // Update Backoff
-    CalculateBackOff( LastTxChannel );
+    // The back-off of the last frame was charged at its Tx done
+    if ( ( Ctx->NetworkJoined == false ) && ( Ctx->JoinStartTime == 0 ) ) {
+        Ctx->JoinStartTime = MAX( LpmGetRtcTime( ), 1 );
+    }
 
-    nextChan.AggrTimeOff = AggregatedTimeOff;
-    nextChan.Datarate = LoRaMacParams.ChannelsDatarate;
-    nextChan.DutyCycleEnabled = DutyCycleOn;
-    nextChan.Joined = IsLoRaMacNetworkJoined;
-    nextChan.LastAggrTx = AggregatedLastTxDoneTime;
+    nextChan.AggrTimeOff = Ctx->AggregatedTimeOff;
+    nextChan.Datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+    nextChan.DutyCycleEnabled = Ctx->DutyCycleOn;
+    nextChan.Joined = Ctx->NetworkJoined;
+    nextChan.LastAggrTx = Ctx->AggregatedLastTxDoneTime;
 
-    // Select channel
-    while ( RegionNextChannel( LoRaMacRegion, &nextChan, &Channel, &dutyCycleTimeOff, &AggregatedTimeOff ) == false ) {
+    // Select channel, the regions requiring listen before talk add the
+    // channels to probe
+    LoRaMacLbtClearCandidates( );
+    while ( RegionNextChannel( Ctx->LoRaMacRegion, &nextChan, &Ctx->Channel, &dutyCycleTimeOff, &Ctx->AggregatedTimeOff ) == false ) {
         // Set the default datarate
-        LoRaMacParams.ChannelsDatarate = LoRaMacParamsDefaults.ChannelsDatarate;
+        Ctx->LoRaMacParams.ChannelsDatarate = Ctx->LoRaMacParamsDefaults.ChannelsDatarate;
         // Update datarate in the function parameters
-        nextChan.Datarate = LoRaMacParams.ChannelsDatarate;
+        nextChan.Datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+    }
+    // A retransmission avoids the channels its previous attempts were not acknowledged on
+    for ( draws = 0; ( draws < RETRY_CHANNEL_DRAWS ) && ( dutyCycleTimeOff == 0 ) && ( RetryAvoidChannel( Ctx->Channel ) == true ); draws++ ) {
+        LoRaMacLbtClearCandidates( );
+        RegionNextChannel( Ctx->LoRaMacRegion, &nextChan, &Ctx->Channel, &dutyCycleTimeOff, &Ctx->AggregatedTimeOff );
     }
 
     // Compute Rx1 windows parameters
-    RegionComputeRxWindowParameters( LoRaMacRegion,
-                                     RegionApplyDrOffset( LoRaMacRegion, LoRaMacParams.DownlinkDwellTime, LoRaMacParams.ChannelsDatarate,
-                                                          LoRaMacParams.Rx1DrOffset ),
-                                     LoRaMacParams.MinRxSymbols,
-                                     LoRaMacParams.SystemMaxRxError,
-                                     &RxWindow1Config );
+    RegionComputeRxWindowParameters( Ctx->LoRaMacRegion,
+                                     RegionApplyDrOffset( Ctx->LoRaMacRegion, Ctx->LoRaMacParams.DownlinkDwellTime, Ctx->LoRaMacParams.ChannelsDatarate,
+                                                          Ctx->LoRaMacParams.Rx1DrOffset ),
+                                     Ctx->LoRaMacParams.MinRxSymbols,
+                                     ( Ctx->NetworkJoined == true ) ? RxTimingGetRxError( 0 ) : Ctx->LoRaMacParams.SystemMaxRxError,
+                                     &Ctx->RxWindow1Config );
     // Compute Rx2 windows parameters
-    RegionComputeRxWindowParameters( LoRaMacRegion,
-                                     LoRaMacParams.Rx2Channel.Datarate,
-                                     LoRaMacParams.MinRxSymbols,
-                                     LoRaMacParams.SystemMaxRxError,
-                                     &RxWindow2Config );
-
-    if ( IsLoRaMacNetworkJoined == false ) {
-        RxWindow1Delay = LoRaMacParams.JoinAcceptDelay1 + RxWindow1Config.WindowOffset;
-        RxWindow2Delay = LoRaMacParams.JoinAcceptDelay2 + RxWindow2Config.WindowOffset;
+    RegionComputeRxWindowParameters( Ctx->LoRaMacRegion,
+                                     Ctx->LoRaMacParams.Rx2Channel.Datarate,
+                                     Ctx->LoRaMacParams.MinRxSymbols,
+                                     ( Ctx->NetworkJoined == true ) ? RxTimingGetRxError( 1 ) : Ctx->LoRaMacParams.SystemMaxRxError,
+                                     &Ctx->RxWindow2Config );
+
+    if ( Ctx->NetworkJoined == false ) {
+        Ctx->RxWindow1Delay = Ctx->LoRaMacParams.JoinAcceptDelay1 + Ctx->RxWindow1Config.WindowOffset;
+        Ctx->RxWindow2Delay = Ctx->LoRaMacParams.JoinAcceptDelay2 + Ctx->RxWindow2Config.WindowOffset;
     } else {
-        if ( ValidatePayloadLength( LoRaMacTxPayloadLen, LoRaMacParams.ChannelsDatarate, MacCommandsBufferIndex ) == false ) {
+        if ( ValidatePayloadLength( Ctx->LoRaMacTxPayloadLen, Ctx->LoRaMacParams.ChannelsDatarate, Ctx->MacCommandsBufferIndex ) == false ) {
             return LORAMAC_STATUS_LENGTH_ERROR;
         }
-        RxWindow1Delay = LoRaMacParams.ReceiveDelay1 + RxWindow1Config.WindowOffset;
-        RxWindow2Delay = LoRaMacParams.ReceiveDelay2 + RxWindow2Config.WindowOffset;
+        Ctx->RxWindow1Delay = Ctx->LoRaMacParams.ReceiveDelay1 + Ctx->RxWindow1Config.WindowOffset;
+        Ctx->RxWindow2Delay = Ctx->LoRaMacParams.ReceiveDelay2 + Ctx->RxWindow2Config.WindowOffset;
     }
 
     // Schedule transmission of frame
     if ( dutyCycleTimeOff == 0 ) {
+        if ( ( LoRaMacLbtGetNbCandidates( ) > 0 ) || ( LoRaMacLbtIsEnabled( ) == true ) ) {
+            // Send once a free channel is found
+            return StartLbt( );
+        }
         // Try to send now
-        return SendFrameOnChannel( Channel );
+        return SendFrameOnChannel( Ctx->Channel );
     } else {
         // Send later - prepare timer
-        LoRaMacState |= LORAMAC_TX_DELAYED;
-        TimerSetValue( &TxDelayedTimer, dutyCycleTimeOff );
-        TimerStart( &TxDelayedTimer );
+        Ctx->Statistics.DutyCycleDelays++;
+        Ctx->Statistics.DutyCycleDelayTime += dutyCycleTimeOff;
+        Ctx->LoRaMacState |= LORAMAC_TX_DELAYED;
+        TimerSetValue( &Ctx->TxDelayedTimer, dutyCycleTimeOff );
+        TimerStart( &Ctx->TxDelayedTimer );
+        TRACE( TRACE_EVENT_TIMER_START, TRACE_TIMER_TX_DELAYED, dutyCycleTimeOff );
 
         return LORAMAC_STATUS_OK;
     }
 }
 
+static LoRaMacStatus_t StartLbt( void )
+{
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+    TxConfigParams_t txConfig;
+    int8_t txPower = 0;
+
+    if ( LoRaMacLbtGetNbCandidates( ) == 0 ) {
+        // The region does not require listen before talk, probe the selected channel
+        getPhy.Attribute = PHY_CHANNELS;
+        phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+        LoRaMacLbtAddCandidate( Ctx->Channel, phyParam.Channels[Ctx->Channel].Frequency );
+    }
+
+    // CAD uses the uplink modulation
+    txConfig.Channel = Ctx->Channel;
+    txConfig.Datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+    txConfig.TxPower = Ctx->LoRaMacParams.ChannelsTxPower;
+    txConfig.MaxEirp = Ctx->LoRaMacParams.MaxEirp;
+    txConfig.AntennaGain = Ctx->LoRaMacParams.AntennaGain;
+    txConfig.PktLen = Ctx->LoRaMacBufferPktLen;
+    RegionTxConfig( Ctx->LoRaMacRegion, &txConfig, &txPower, &Ctx->TxTimeOnAir );
+
+    Ctx->LoRaMacState |= LORAMAC_TX_DELAYED;
+    RadioOwner = Ctx;
+    LoRaMacLbtStart( );
+
+    return LORAMAC_STATUS_OK;
+}
+
+static void OnLbtDone( bool channelFree, uint8_t channel )
+{
+    TimerTime_t backoff;
+
+    if ( channelFree == true ) {
+        Ctx->LoRaMacState &= ~LORAMAC_TX_DELAYED;
+        Ctx->Channel = channel;
+        SendFrameOnChannel( Ctx->Channel );
+        return;
+    }
+
+    // Every candidate is busy, select a channel again after a random backoff
+    backoff = LoRaMacLbtGetBackoff( );
+    TimerSetValue( &Ctx->TxDelayedTimer, backoff );
+    TimerStart( &Ctx->TxDelayedTimer );
+    TRACE( TRACE_EVENT_TIMER_START, TRACE_TIMER_TX_DELAYED, backoff );
+
+    if ( Ctx->LoRaMacDeviceClass == CLASS_C ) {
+        OpenContinuousRx2Window( );
+    }
+}
+
 static void CalculateBackOff( uint8_t channel )
 {
     CalcBackOffParams_t calcBackOff;
 
-    calcBackOff.Joined = IsLoRaMacNetworkJoined;
-    calcBackOff.DutyCycleEnabled = DutyCycleOn;
+    calcBackOff.Joined = Ctx->NetworkJoined;
+    calcBackOff.DutyCycleEnabled = Ctx->DutyCycleOn;
     calcBackOff.Channel = channel;
-    calcBackOff.ElapsedTime = TimerGetElapsedTime( LoRaMacInitializationTime );
-    calcBackOff.TxTimeOnAir = TxTimeOnAir;
-    calcBackOff.LastTxIsJoinRequest = LastTxIsJoinRequest;
+    calcBackOff.ElapsedTime = ( Ctx->JoinStartTime != 0 ) ? ( TimerTime_t )( LpmGetRtcTime( ) - Ctx->JoinStartTime ) : 0;
+    calcBackOff.TxTimeOnAir = Ctx->TxTimeOnAir;
+    calcBackOff.LastTxIsJoinRequest = Ctx->LastTxIsJoinRequest;
 
     // Update regional back-off
-    RegionCalcBackOff( LoRaMacRegion, &calcBackOff );
+    RegionCalcBackOff( Ctx->LoRaMacRegion, &calcBackOff );
 
     // Update aggregated time-off
-    AggregatedTimeOff = TxTimeOnAir * AggregatedDCycle - TxTimeOnAir;
+    Ctx->AggregatedTimeOff = Ctx->TxTimeOnAir * Ctx->AggregatedDCycle - Ctx->TxTimeOnAir;
+}
+
+static void ResetMacParameters( void )
+{
+    SetNetworkJoined( false );
+
+    // Counters
+    Ctx->UpLinkCounter = 0;
+    Ctx->DownLinkCounter = -1;
+    Ctx->AdrAckCounter = 0;
+    memset1( ( uint8_t * )&Ctx->AdrStatus, 0, sizeof( Ctx->AdrStatus ) );
+
+    Ctx->ChannelsNbRepCounter = 0;
+
+    Ctx->AckTimeoutRetries = 1;
+    Ctx->AckTimeoutRetriesCounter = 1;
+    Ctx->AckTimeoutRetry = false;
+
+    Ctx->MaxDCycle = 0;
+    Ctx->AggregatedDCycle = 1;
+
+    Ctx->MacCommandsBufferIndex = 0;
+    Ctx->MacCommandsBufferToRepeatIndex = 0;
+
+    Ctx->IsRxWindowsEnabled = true;
+
+    Ctx->LoRaMacParams.ChannelsTxPower = Ctx->LoRaMacParamsDefaults.ChannelsTxPower;
+    Ctx->LoRaMacParams.ChannelsDatarate = Ctx->LoRaMacParamsDefaults.ChannelsDatarate;
+    Ctx->LoRaMacParams.Rx1DrOffset = Ctx->LoRaMacParamsDefaults.Rx1DrOffset;
+    memcpy(&Ctx->LoRaMacParams.Rx2Channel, &Ctx->LoRaMacParamsDefaults.Rx2Channel, sizeof(Ctx->LoRaMacParams.Rx2Channel));
+    Ctx->LoRaMacParams.UplinkDwellTime = Ctx->LoRaMacParamsDefaults.UplinkDwellTime;
+    Ctx->LoRaMacParams.DownlinkDwellTime = Ctx->LoRaMacParamsDefaults.DownlinkDwellTime;
+    Ctx->LoRaMacParams.MaxEirp = Ctx->LoRaMacParamsDefaults.MaxEirp;
+    Ctx->LoRaMacParams.AntennaGain = Ctx->LoRaMacParamsDefaults.AntennaGain;
+
+    Ctx->NodeAckRequested = false;
+    Ctx->SrvAckRequested = false;
+    Ctx->MacCommandsInNextTx = false;
+
+    // Reset Multicast downlink counters
+    MulticastParams_t *cur = Ctx->MulticastChannels;
+    while ( cur != NULL ) {
+        cur->DownLinkCounter = 0;
+        cur = cur->Next;
+    }
+
+    // Initialize channel index.
+    Ctx->Channel = 0;
+    Ctx->LastTxChannel = Ctx->Channel;
+}
+
+static bool IsFPortAllowed( uint8_t fPort )
+{
+    if( fPort > 224 )
+    {
+        return false;
+    }
+    return true;
+}
+
+static uint32_t RxTimingGetRxError( uint8_t slot )
+{
+    /* Two sided normal quantiles ( x100 ) of the supported miss rates in per mille */
+    static const uint16_t missRates[] = { 1, 5, 10, 20, 50, 100, 200 };
+    static const uint16_t quantiles[] = { 329, 281, 258, 233, 196, 164, 128 };
+    uint16_t quantile = quantiles[0];
+    float rxError;
+
+    if ( ( Ctx->RxTiming.Adaptive == false ) || ( Ctx->RxTiming.Samples[slot] < RX_TIMING_MIN_SAMPLES ) ) {
+        return Ctx->LoRaMacParams.SystemMaxRxError;
+    }
+
+    for ( uint8_t i = 0; i < sizeof( missRates ) / sizeof( missRates[0] ); i++ ) {
+        if ( Ctx->RxTiming.TargetMissRate >= missRates[i] ) {
+            quantile = quantiles[i];
+        }
+    }
+
+    // The timer resolution is 1 ms, the window is never narrower than that
+    rxError = fabsf( Ctx->RxTiming.OffsetMean[slot] ) + ( quantile * sqrtf( Ctx->RxTiming.OffsetVariance[slot] ) ) / 100.0f + 1.0f;
+    Ctx->RxTiming.RxError[slot] = MIN( ( uint32_t )ceilf( rxError ), Ctx->LoRaMacParams.MaxRxWindow / 2 );
+
+    return Ctx->RxTiming.RxError[slot];
+}
+
+static void RxTimingUpdate( TimerTime_t preambleTime )
+{
+    uint8_t slot;
+    uint32_t rxDelay;
+    float offset;
+    float delta;
+    float alpha;
+
+    if ( ( Ctx->LoRaMacDeviceClass == CLASS_C ) || ( ( Ctx->RxSlot != RX_SLOT_WIN_1 ) && ( Ctx->RxSlot != RX_SLOT_WIN_2 ) ) ) {
+        return;
+    }
+
+    slot = ( Ctx->RxSlot == RX_SLOT_WIN_1 ) ? 0 : 1;
+    rxDelay = ( slot == 0 ) ? Ctx->LoRaMacParams.ReceiveDelay1 : Ctx->LoRaMacParams.ReceiveDelay2;
+    offset = ( float )( ( int64_t )preambleTime - ( int64_t )( Ctx->AggregatedLastTxDoneTime + rxDelay ) );
+
+    // Running mean first, then an exponentially weighted mean and variance
+    Ctx->RxTiming.Misses = 0;
+    Ctx->RxTiming.Samples[slot]++;
+    alpha = ( Ctx->RxTiming.Samples[slot] < RX_TIMING_MIN_SAMPLES ) ? 1.0f / Ctx->RxTiming.Samples[slot] : 1.0f / RX_TIMING_MIN_SAMPLES;
+    delta = offset - Ctx->RxTiming.OffsetMean[slot];
+    Ctx->RxTiming.OffsetMean[slot] += alpha * delta;
+    Ctx->RxTiming.OffsetVariance[slot] = ( 1.0f - alpha ) * ( Ctx->RxTiming.OffsetVariance[slot] + alpha * delta * delta );
+
+    // Split the offset into a constant latency and a clock error growing with the delay
+    if ( ( Ctx->RxTiming.Samples[0] >= RX_TIMING_MIN_SAMPLES ) && ( Ctx->RxTiming.Samples[1] >= RX_TIMING_MIN_SAMPLES ) &&
+         ( Ctx->LoRaMacParams.ReceiveDelay2 > Ctx->LoRaMacParams.ReceiveDelay1 ) ) {
+        Ctx->RxTiming.ClockErrorPpm = ( ( Ctx->RxTiming.OffsetMean[1] - Ctx->RxTiming.OffsetMean[0] ) * 1e6f ) /
+                                 ( float )( Ctx->LoRaMacParams.ReceiveDelay2 - Ctx->LoRaMacParams.ReceiveDelay1 );
+        Ctx->RxTiming.WakeupLatency = Ctx->RxTiming.OffsetMean[0] - ( Ctx->RxTiming.ClockErrorPpm * Ctx->LoRaMacParams.ReceiveDelay1 ) / 1e6f;
+    } else {
+        Ctx->RxTiming.ClockErrorPpm = 0;
+        Ctx->RxTiming.WakeupLatency = Ctx->RxTiming.OffsetMean[slot];
+    }
+}
+
+static uint16_t RetryAckRate( int8_t datarate )
+{
+    // Acknowledged fraction in per mille, an unused datarate counts as one half
+    return ( uint16_t )( ( ( uint32_t )Ctx->Retry.Acks[datarate] * 1000 + 500 ) / ( Ctx->Retry.Attempts[datarate] + 1 ) );
+}
+
+static uint32_t RetryTimeOnAir( int8_t datarate )
+{
+    uint32_t timeOnAir = Ctx->Retry.TimeOnAir[datarate];
+    int8_t steps;
+
+    if ( timeOnAir == 0 ) {
+        // Not used yet, each lower datarate roughly doubles the time on air
+        steps = MAX( Ctx->LoRaMacParams.ChannelsDatarate - datarate, 0 );
+        timeOnAir = MAX( Ctx->TxTimeOnAir, 1 ) << MIN( steps, 8 );
+    }
+    return timeOnAir;
+}
+
+static bool RetryFitsDeadline( uint32_t timeOnAir )
+{
+    uint32_t ackDelay = Ctx->LoRaMacParams.ReceiveDelay2;
+
+    if ( Ctx->Retry.Deadline == 0 ) {
+        return true;
+    }
+    // The acknowledge is expected in the window that brought most of them
+    if ( ( Ctx->Retry.AcksRx[0] > 0 ) && ( Ctx->Retry.AcksRx[0] >= Ctx->Retry.AcksRx[1] ) ) {
+        ackDelay = Ctx->LoRaMacParams.ReceiveDelay1;
+    }
+    return ( TimerGetElapsedTime( Ctx->RetryRequestTime ) + timeOnAir + ackDelay ) <= Ctx->Retry.Deadline;
+}
+
+static void RetryTxDone( void )
+{
+    int8_t datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+
+    if ( ( Ctx->NodeAckRequested == false ) || ( datarate < 0 ) || ( datarate > 15 ) ) {
+        return;
+    }
+    if ( Ctx->Retry.Attempts[datarate] >= RETRY_HISTORY_LENGTH ) {
+        Ctx->Retry.Attempts[datarate] /= 2;
+        Ctx->Retry.Acks[datarate] /= 2;
+    }
+    Ctx->Retry.Attempts[datarate]++;
+    Ctx->Retry.TimeOnAir[datarate] = Ctx->TxTimeOnAir;
+    Ctx->Retry.AirTime += Ctx->TxTimeOnAir;
+}
+
+static void RetryAckReceived( void )
+{
+    int8_t datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+
+    if ( ( datarate >= 0 ) && ( datarate <= 15 ) && ( Ctx->Retry.Acks[datarate] < Ctx->Retry.Attempts[datarate] ) ) {
+        Ctx->Retry.Acks[datarate]++;
+    }
+    if ( ( Ctx->Retry.AcksRx[0] + Ctx->Retry.AcksRx[1] ) >= RETRY_HISTORY_LENGTH ) {
+        Ctx->Retry.AcksRx[0] /= 2;
+        Ctx->Retry.AcksRx[1] /= 2;
+    }
+    Ctx->Retry.AcksRx[( Ctx->RxSlot == RX_SLOT_WIN_1 ) ? 0 : 1]++;
+    if ( Ctx->LastTxChannel < 96 ) {
+        Ctx->Retry.FailedChannels[Ctx->LastTxChannel / 8] &= ~( 1 << ( Ctx->LastTxChannel % 8 ) );
+    }
+    Ctx->Retry.Delivered++;
+}
+
+static void RetryAckTimeout( void )
+{
+    // Never lose an acknowledgement twice to a lowered TX power
+    if ( Ctx->Power.Backoff > 0 ) {
+        Ctx->Power.Hold = POWER_HOLD_UPLINKS;
+    }
+    if ( Ctx->LastTxChannel < 96 ) {
+        Ctx->Retry.FailedChannels[Ctx->LastTxChannel / 8] |= 1 << ( Ctx->LastTxChannel % 8 );
+    }
+}
+
+static uint32_t RetryGetAckTimeout( uint32_t ackTimeout )
+{
+    uint16_t ackRate;
+
+    if ( ( Ctx->Retry.Adaptive == false ) || ( Ctx->NodeAckRequested == false ) || ( ackTimeout <= RETRY_ACK_TIMEOUT_MIN ) ) {
+        return ackTimeout;
+    }
+    // A reliable link retries early, a lossy one spreads its retries over the
+    // whole regional range to get away from the interferers
+    ackRate = RetryAckRate( Ctx->LoRaMacParams.ChannelsDatarate );
+    ackTimeout = RETRY_ACK_TIMEOUT_MIN + ( ( ackTimeout - RETRY_ACK_TIMEOUT_MIN ) * ( 1000 - ackRate ) ) / 1000;
+
+    // Close to the deadline every millisecond counts
+    if ( ( Ctx->Retry.Deadline != 0 ) && ( RetryFitsDeadline( Ctx->RxWindow2Delay + ackTimeout + Ctx->TxTimeOnAir ) == false ) ) {
+        ackTimeout = RETRY_ACK_TIMEOUT_MIN;
+    }
+    return ackTimeout;
+}
+
+static int8_t RetryBestDatarate( void )
+{
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+    int8_t datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+    int8_t best = -1;
+    uint32_t bestScore = 0;
+    uint32_t timeOnAir;
+    uint32_t score;
+    uint8_t i;
+
+    // Acknowledges per time on air, among the current datarate and the lower
+    // ones still carrying the frame
+    for ( i = 0; i < RETRY_MAX_DR_STEPS; i++ ) {
+        if ( ValidatePayloadLength( Ctx->LoRaMacTxPayloadLen, datarate, Ctx->MacCommandsBufferIndex ) == false ) {
+            break;
+        }
+        timeOnAir = RetryTimeOnAir( datarate );
+        if ( RetryFitsDeadline( timeOnAir ) == true ) {
+            score = ( ( uint32_t )RetryAckRate( datarate ) << 10 ) / MAX( timeOnAir, 1 );
+            if ( ( best < 0 ) || ( score > bestScore ) ) {
+                best = datarate;
+                bestScore = score;
+            }
+        }
+
+        getPhy.Attribute = PHY_NEXT_LOWER_TX_DR;
+        getPhy.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
+        getPhy.Datarate = datarate;
+        phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+        if ( ( int8_t )phyParam.Value == datarate ) {
+            break;
+        }
+        datarate = phyParam.Value;
+    }
+    return best;
+}
+
+static bool RetryPrepare( uint8_t trial )
+{
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+    int8_t datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+
+    if ( Ctx->Retry.Adaptive == true ) {
+        datarate = RetryBestDatarate( );
+    } else if ( ( trial % 2 ) == 1 ) {
+        getPhy.Attribute = PHY_NEXT_LOWER_TX_DR;
+        getPhy.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
+        getPhy.Datarate = datarate;
+        phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+        datarate = phyParam.Value;
+    }
+
+    if ( ( datarate < 0 ) || ( RetryFitsDeadline( RetryTimeOnAir( datarate ) ) == false ) ) {
+        Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_TX_DEADLINE;
+        Ctx->Retry.DeadlineMisses++;
+        return false;
+    }
+    Ctx->LoRaMacParams.ChannelsDatarate = datarate;
+    return true;
+}
+
+static bool RetryAvoidChannel( uint8_t channel )
+{
+    if ( ( Ctx->Retry.Adaptive == false ) || ( Ctx->NodeAckRequested == false ) ||
+         ( Ctx->AckTimeoutRetriesCounter <= 1 ) || ( channel >= 96 ) ) {
+        return false;
+    }
+    return ( Ctx->Retry.FailedChannels[channel / 8] & ( 1 << ( channel % 8 ) ) ) != 0;
+}
+
+static void LinkAverage( float *mean, float *variance, uint32_t samples, float value )
+{
+    float alpha = ( samples < LINK_MIN_SAMPLES ) ? 1.0f / samples : 1.0f / LINK_MIN_SAMPLES;
+    float delta = value - *mean;
+
+    // Running mean first, then an exponentially weighted mean and variance
+    *mean += alpha * delta;
+    if ( variance != NULL ) {
+        *variance = ( 1.0f - alpha ) * ( *variance + alpha * delta * delta );
+    }
+}
+
+static uint8_t LinkChannelIndex( uint8_t channel )
+{
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+
+    getPhy.Attribute = PHY_MAX_NB_CHANNELS;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    if ( phyParam.Value > LINK_MAX_CHANNELS ) {
+        channel /= 8;
+    }
+    return MIN( channel, LINK_MAX_CHANNELS - 1 );
+}
+
+static void LinkUpdateSnr( int8_t snr )
+{
+    uint8_t datarate = Ctx->McpsIndication.RxDatarate;
+    uint8_t index;
+
+    Ctx->Link.Samples++;
+    LinkAverage( &Ctx->Link.SnrMean, &Ctx->Link.SnrVariance, Ctx->Link.Samples, snr );
+
+    if ( datarate < 16 ) {
+        if ( Ctx->Link.DrSamples[datarate] < UINT16_MAX ) {
+            Ctx->Link.DrSamples[datarate]++;
+        }
+        LinkAverage( &Ctx->Link.DrSnrMean[datarate], &Ctx->Link.DrSnrVariance[datarate], Ctx->Link.DrSamples[datarate], snr );
+    }
+
+    // RX2 uses its own frequency, only RX1 tells about the uplink channel
+    if ( Ctx->RxSlot == RX_SLOT_WIN_1 ) {
+        index = LinkChannelIndex( Ctx->LastTxChannel );
+        if ( Ctx->Link.ChannelSamples[index] < UINT16_MAX ) {
+            Ctx->Link.ChannelSamples[index]++;
+        }
+        LinkAverage( &Ctx->Link.ChannelSnrMean[index], NULL, Ctx->Link.ChannelSamples[index], snr );
+    }
+    Ctx->Link.LastUpdate = TimerGetCurrentTime( );
+}
+
+static void LinkUpdateMargin( uint8_t margin, uint8_t nbGateways )
+{
+    int8_t datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+
+    if ( ( datarate < 0 ) || ( datarate > 15 ) ) {
+        return;
+    }
+    // Margins are kept at the set power, undo the TX power control backoff
+    margin += 2 * Ctx->Power.Backoff;
+    if ( Ctx->Link.MarginSamples[datarate] < UINT16_MAX ) {
+        Ctx->Link.MarginSamples[datarate]++;
+    }
+    LinkAverage( &Ctx->Link.MarginMean[datarate], &Ctx->Link.MarginVariance[datarate], Ctx->Link.MarginSamples[datarate], margin );
+    LinkAverage( &Ctx->Link.MarginSnr[datarate], NULL, Ctx->Link.MarginSamples[datarate], Ctx->Link.SnrMean );
+    Ctx->Link.NbGateways = nbGateways;
+    Ctx->Link.LastUpdate = TimerGetCurrentTime( );
+}
+
+static bool LinkGetMargin( int8_t datarate, float *margin, float *variance )
+{
+    int8_t known = -1;
+    uint8_t channels = 0;
+    float channelMean = 0;
+    float channelVariance = 0;
+    uint8_t i;
+
+    for ( i = 0; i < 16; i++ ) {
+        if ( ( Ctx->Link.MarginSamples[i] > 0 ) && ( ( known < 0 ) || ( abs( i - datarate ) < abs( known - datarate ) ) ) ) {
+            known = i;
+        }
+    }
+    if ( known < 0 ) {
+        return false;
+    }
+
+    // The spread between the channels is a part of the uncertainty, the
+    // region may pick any of them
+    for ( i = 0; i < LINK_MAX_CHANNELS; i++ ) {
+        if ( Ctx->Link.ChannelSamples[i] > 0 ) {
+            channels++;
+            channelMean += Ctx->Link.ChannelSnrMean[i];
+        }
+    }
+    if ( channels > 1 ) {
+        channelMean /= channels;
+        for ( i = 0; i < LINK_MAX_CHANNELS; i++ ) {
+            if ( Ctx->Link.ChannelSamples[i] > 0 ) {
+                channelVariance += ( Ctx->Link.ChannelSnrMean[i] - channelMean ) * ( Ctx->Link.ChannelSnrMean[i] - channelMean );
+            }
+        }
+        channelVariance /= channels - 1;
+    }
+
+    *margin = Ctx->Link.MarginMean[known] + ( Ctx->Link.SnrMean - Ctx->Link.MarginSnr[known] ) -
+              LINK_DR_STEP_MARGIN * ( datarate - known );
+    *variance = Ctx->Link.MarginVariance[known] + Ctx->Link.SnrVariance + channelVariance +
+                ( LINK_DRIFT_PER_HOUR * TimerGetElapsedTime( Ctx->Link.LastUpdate ) ) / 3600000.0f;
+    return true;
+}
+
+static uint16_t LinkQuantile( void )
+{
+    /* One sided normal quantiles ( x100 ) of the supported error rates in per mille */
+    static const uint16_t errorRates[] = { 1, 5, 10, 20, 50, 100, 200 };
+    static const uint16_t quantiles[] = { 309, 258, 233, 205, 164, 128, 84 };
+    uint16_t targetPer = ( Ctx->Link.TargetPer == 0 ) ? LINK_DEFAULT_TARGET_PER : Ctx->Link.TargetPer;
+    uint16_t quantile = quantiles[0];
+
+    for ( uint8_t i = 0; i < sizeof( errorRates ) / sizeof( errorRates[0] ); i++ ) {
+        if ( targetPer >= errorRates[i] ) {
+            quantile = quantiles[i];
+        }
+    }
+    return quantile;
 }
 
-static void ResetMacParameters( void )
+static int8_t LinkGetDatarate( int8_t datarate, uint16_t payloadSize )
 {
-    IsLoRaMacNetworkJoined = false;
-
-    // Counters
-    UpLinkCounter = 0;
-    DownLinkCounter = -1;
-    AdrAckCounter = 0;
-
-    ChannelsNbRepCounter = 0;
-
-    AckTimeoutRetries = 1;
-    AckTimeoutRetriesCounter = 1;
-    AckTimeoutRetry = false;
+    uint16_t quantile;
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+    VerifyParams_t verify;
+    int8_t minDatarate;
+    int8_t dr;
+    float margin;
+    float variance;
 
-    MaxDCycle = 0;
-    AggregatedDCycle = 1;
+    if ( ( Ctx->Link.Enabled == false ) || ( Ctx->AdrCtrlOn == true ) ) {
+        return datarate;
+    }
+    quantile = LinkQuantile( );
 
-    MacCommandsBufferIndex = 0;
-    MacCommandsBufferToRepeatIndex = 0;
+    getPhy.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
+    getPhy.Attribute = PHY_MIN_TX_DR;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    minDatarate = phyParam.Value;
+    getPhy.Attribute = PHY_MAX_TX_DR;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+
+    // The fastest datarate whose margin stays positive with the target
+    // probability, the most robust one if none does
+    for ( dr = phyParam.Value; dr > minDatarate; dr-- ) {
+        verify.DatarateParams.Datarate = dr;
+        verify.DatarateParams.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
+        if ( ( RegionVerify( Ctx->LoRaMacRegion, &verify, PHY_TX_DR ) == false ) ||
+             ( ValidatePayloadLength( payloadSize, dr, Ctx->MacCommandsBufferIndex ) == false ) ) {
+            continue;
+        }
+        if ( LinkGetMargin( dr, &margin, &variance ) == false ) {
+            // Nothing known about the uplink yet
+            return datarate;
+        }
+        if ( ( margin - ( quantile * sqrtf( variance ) ) / 100.0f ) >= 0 ) {
+            break;
+        }
+    }
+    Ctx->Link.Datarate = dr;
+    return dr;
+}
 
-    IsRxWindowsEnabled = true;
+static void LinkScheduleCheck( void )
+{
+    float margin;
+    float variance;
 
-    LoRaMacParams.ChannelsTxPower = LoRaMacParamsDefaults.ChannelsTxPower;
-    LoRaMacParams.ChannelsDatarate = LoRaMacParamsDefaults.ChannelsDatarate;
-    LoRaMacParams.Rx1DrOffset = LoRaMacParamsDefaults.Rx1DrOffset;
-    memcpy(&LoRaMacParams.Rx2Channel, &LoRaMacParamsDefaults.Rx2Channel, sizeof(LoRaMacParams.Rx2Channel));
-    LoRaMacParams.UplinkDwellTime = LoRaMacParamsDefaults.UplinkDwellTime;
-    LoRaMacParams.DownlinkDwellTime = LoRaMacParamsDefaults.DownlinkDwellTime;
-    LoRaMacParams.MaxEirp = LoRaMacParamsDefaults.MaxEirp;
-    LoRaMacParams.AntennaGain = LoRaMacParamsDefaults.AntennaGain;
+    if ( ( ( Ctx->Link.Enabled == false ) && ( Ctx->Power.Enabled == false ) ) ||
+         ( Ctx->AdrCtrlOn == true ) || ( Ctx->NetworkJoined == false ) ) {
+        return;
+    }
+    if ( Ctx->Link.UplinksSinceCheck < UINT16_MAX ) {
+        Ctx->Link.UplinksSinceCheck++;
+    }
+    if ( ( Ctx->Link.LinkChecks > 0 ) && ( Ctx->Link.UplinksSinceCheck < LINK_CHECK_MIN_UPLINKS ) ) {
+        return;
+    }
+    // Ask the network only when the estimate has become too uncertain
+    if ( ( LinkGetMargin( Ctx->LoRaMacParams.ChannelsDatarate, &margin, &variance ) == true ) &&
+         ( sqrtf( variance ) <= LINK_MAX_UNCERTAINTY ) ) {
+        return;
+    }
+    if ( LoRaMacConfirmQueueIsCmdActive( MLME_LINK_CHECK ) == true ) {
+        return;
+    }
+    if ( AddMacCommand( MOTE_MAC_LINK_CHECK_REQ, 0, 0 ) == LORAMAC_STATUS_OK ) {
+        Ctx->Link.LinkChecks++;
+        Ctx->Link.UplinksSinceCheck = 0;
+    }
+}
 
-    NodeAckRequested = false;
-    SrvAckRequested = false;
-    MacCommandsInNextTx = false;
+static int8_t PowerGetBackoff( void )
+{
+    uint8_t targetMargin = ( Ctx->Power.TargetMargin == 0 ) ? POWER_DEFAULT_TARGET_MARGIN : Ctx->Power.TargetMargin;
+    VerifyParams_t verify;
+    int8_t steps;
+    float margin;
+    float variance;
 
-    // Reset Multicast downlink counters
-    MulticastParams_t *cur = MulticastChannels;
-    while ( cur != NULL ) {
-        cur->DownLinkCounter = 0;
-        cur = cur->Next;
+    if ( ( Ctx->Power.Enabled == false ) || ( Ctx->AdrCtrlOn == true ) || ( Ctx->NetworkJoined == false ) ) {
+        return 0;
+    }
+    if ( Ctx->Power.Hold > 0 ) {
+        return 0;
+    }
+    if ( LinkGetMargin( Ctx->LoRaMacParams.ChannelsDatarate, &margin, &variance ) == false ) {
+        return 0;
     }
 
-    // Initialize channel index.
-    Channel = 0;
-    LastTxChannel = Channel;
+    // Spend the margin left above the target with the estimator confidence,
+    // the TX power indexes are 2 dB apart
+    margin -= ( LinkQuantile( ) * sqrtf( variance ) ) / 100.0f + targetMargin;
+    if ( margin < 2.0f ) {
+        return 0;
+    }
+    for ( steps = ( int8_t )( margin / 2.0f ); steps > 0; steps-- ) {
+        verify.TxPower = Ctx->LoRaMacParams.ChannelsTxPower + steps;
+        if ( RegionVerify( Ctx->LoRaMacRegion, &verify, PHY_TX_POWER ) == true ) {
+            break;
+        }
+    }
+    return steps;
 }
 
-static bool IsFPortAllowed( uint8_t fPort )
+static void PowerTxDone( int8_t txPower )
 {
-    if( fPort > 224 )
-    {
-        return false;
+    uint32_t setCurrent;
+
+    Ctx->Power.TxPower = txPower;
+    Ctx->Power.LastSaving = 0;
+    if ( Ctx->Power.Backoff == 0 ) {
+        return;
     }
-    return true;
+    // Charge in uA.ms times the supply in mV gives pJ
+    setCurrent = EnergyGetTxCurrent( txPower + 2 * Ctx->Power.Backoff );
+    Ctx->Power.LastSaving = ( ( uint64_t )Ctx->TxTimeOnAir * ( setCurrent - EnergyGetTxCurrent( txPower ) ) *
+                              BOARD_SUPPLY_VOLTAGE ) / 1000000;
+    Ctx->Power.SavedEnergy += Ctx->Power.LastSaving;
+    Ctx->Power.Uplinks++;
 }
 
 static void OpenContinuousRx2Window( void )
 {
     OnRxWindow2TimerEvent( );
-    RxSlot = RX_SLOT_WIN_CLASS_C;
+    Ctx->RxSlot = RX_SLOT_WIN_CLASS_C;
 }
 
 LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t *macHdr, LoRaMacFrameCtrl_t *fCtrl, uint8_t fPort, void *fBuffer,
@@ -2264,140 +3122,153 @@ LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t *macHdr, LoRaMacFrameCtrl_t *fCtrl
     const void *payload = fBuffer;
     uint8_t framePort = fPort;
 
-    LoRaMacBufferPktLen = 0;
+    Ctx->LoRaMacBufferPktLen = 0;
 
-    NodeAckRequested = false;
+    Ctx->NodeAckRequested = false;
 
     if ( fBuffer == NULL ) {
         fBufferSize = 0;
     }
 
-    LoRaMacTxPayloadLen = fBufferSize;
+    Ctx->LoRaMacTxPayloadLen = fBufferSize;
 
-    LoRaMacBuffer[pktHeaderLen++] = macHdr->Value;
+    Ctx->LoRaMacBuffer[pktHeaderLen++] = macHdr->Value;
 
     switch ( macHdr->Bits.MType ) {
         case FRAME_TYPE_JOIN_REQ:
-            LoRaMacBufferPktLen = pktHeaderLen;
+            Ctx->LoRaMacBufferPktLen = pktHeaderLen;
 
-            memcpyr( LoRaMacBuffer + LoRaMacBufferPktLen, LoRaMacAppEui, 8 );
-            LoRaMacBufferPktLen += 8;
-            memcpyr( LoRaMacBuffer + LoRaMacBufferPktLen, LoRaMacDevEui, 8 );
-            LoRaMacBufferPktLen += 8;
+            memcpyr( Ctx->LoRaMacBuffer + Ctx->LoRaMacBufferPktLen, Ctx->LoRaMacAppEui, 8 );
+            Ctx->LoRaMacBufferPktLen += 8;
+            memcpyr( Ctx->LoRaMacBuffer + Ctx->LoRaMacBufferPktLen, Ctx->LoRaMacDevEui, 8 );
+            Ctx->LoRaMacBufferPktLen += 8;
 
-            LoRaMacDevNonce = Radio.Random( );
+            Ctx->LoRaMacDevNonce = Radio.Random( );
 
-            LoRaMacBuffer[LoRaMacBufferPktLen++] = LoRaMacDevNonce & 0xFF;
-            LoRaMacBuffer[LoRaMacBufferPktLen++] = ( LoRaMacDevNonce >> 8 ) & 0xFF;
+            Ctx->LoRaMacBuffer[Ctx->LoRaMacBufferPktLen++] = Ctx->LoRaMacDevNonce & 0xFF;
+            Ctx->LoRaMacBuffer[Ctx->LoRaMacBufferPktLen++] = ( Ctx->LoRaMacDevNonce >> 8 ) & 0xFF;
 
-            LoRaMacJoinComputeMic( LoRaMacBuffer, LoRaMacBufferPktLen & 0xFF, LoRaMacAppKey, &mic );
+            LoRaMacJoinComputeMic( Ctx->LoRaMacBuffer, Ctx->LoRaMacBufferPktLen & 0xFF, Ctx->LoRaMacAppKey, &mic );
 
-            LoRaMacBuffer[LoRaMacBufferPktLen++] = mic & 0xFF;
-            LoRaMacBuffer[LoRaMacBufferPktLen++] = ( mic >> 8 ) & 0xFF;
-            LoRaMacBuffer[LoRaMacBufferPktLen++] = ( mic >> 16 ) & 0xFF;
-            LoRaMacBuffer[LoRaMacBufferPktLen++] = ( mic >> 24 ) & 0xFF;
+            Ctx->LoRaMacBuffer[Ctx->LoRaMacBufferPktLen++] = mic & 0xFF;
+            Ctx->LoRaMacBuffer[Ctx->LoRaMacBufferPktLen++] = ( mic >> 8 ) & 0xFF;
+            Ctx->LoRaMacBuffer[Ctx->LoRaMacBufferPktLen++] = ( mic >> 16 ) & 0xFF;
+            Ctx->LoRaMacBuffer[Ctx->LoRaMacBufferPktLen++] = ( mic >> 24 ) & 0xFF;
 
             break;
         case FRAME_TYPE_DATA_CONFIRMED_UP:
-            NodeAckRequested = true;
+            Ctx->NodeAckRequested = true;
         //Intentional fallthrough
         case FRAME_TYPE_DATA_UNCONFIRMED_UP:
-            if ( IsLoRaMacNetworkJoined == false ) {
+            if ( Ctx->NetworkJoined == false ) {
                 return LORAMAC_STATUS_NO_NETWORK_JOINED; // No network has been joined yet
             }
 
             // Adr next request
             adrNext.UpdateChanMask = true;
             adrNext.AdrEnabled = fCtrl->Bits.Adr;
-            adrNext.AdrAckCounter = AdrAckCounter;
-            adrNext.Datarate = LoRaMacParams.ChannelsDatarate;
-            adrNext.TxPower = LoRaMacParams.ChannelsTxPower;
-            adrNext.UplinkDwellTime = LoRaMacParams.UplinkDwellTime;
-
-            fCtrl->Bits.AdrAckReq = RegionAdrNext( LoRaMacRegion, &adrNext,
-                                                   &LoRaMacParams.ChannelsDatarate, &LoRaMacParams.ChannelsTxPower, &AdrAckCounter );
-            if ( SrvAckRequested == true ) {
-                SrvAckRequested = false;
+            adrNext.AdrAckCounter = Ctx->AdrAckCounter;
+            adrNext.Datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+            adrNext.TxPower = Ctx->LoRaMacParams.ChannelsTxPower;
+            adrNext.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
+
+            fCtrl->Bits.AdrAckReq = RegionAdrNext( Ctx->LoRaMacRegion, &adrNext,
+                                                   &Ctx->LoRaMacParams.ChannelsDatarate, &Ctx->LoRaMacParams.ChannelsTxPower, &Ctx->AdrAckCounter );
+
+            if ( ( fCtrl->Bits.AdrAckReq == 1 ) && ( Ctx->AdrStatus.BackoffActive == false ) ) {
+                Ctx->AdrStatus.BackoffActive = true;
+                Ctx->AdrStatus.EpisodeStartTime = TimerGetCurrentTime( );
+                Ctx->AdrStatus.EpisodeUplinks = 0;
+                Ctx->AdrStatus.EpisodeAirTime = 0;
+                Ctx->AdrStatus.EpisodeBackoffSteps = 0;
+            }
+            if ( ( Ctx->AdrStatus.BackoffActive == true ) &&
+                 ( ( adrNext.Datarate != Ctx->LoRaMacParams.ChannelsDatarate ) ||
+                   ( adrNext.TxPower != Ctx->LoRaMacParams.ChannelsTxPower ) ) ) {
+                Ctx->AdrStatus.EpisodeBackoffSteps++;
+            }
+            if ( Ctx->SrvAckRequested == true ) {
+                Ctx->SrvAckRequested = false;
                 fCtrl->Bits.Ack = 1;
             }
 
-            LoRaMacBuffer[pktHeaderLen++] = ( LoRaMacDevAddr ) & 0xFF;
-            LoRaMacBuffer[pktHeaderLen++] = ( LoRaMacDevAddr >> 8 ) & 0xFF;
-            LoRaMacBuffer[pktHeaderLen++] = ( LoRaMacDevAddr >> 16 ) & 0xFF;
-            LoRaMacBuffer[pktHeaderLen++] = ( LoRaMacDevAddr >> 24 ) & 0xFF;
+            Ctx->LoRaMacBuffer[pktHeaderLen++] = ( Ctx->LoRaMacDevAddr ) & 0xFF;
+            Ctx->LoRaMacBuffer[pktHeaderLen++] = ( Ctx->LoRaMacDevAddr >> 8 ) & 0xFF;
+            Ctx->LoRaMacBuffer[pktHeaderLen++] = ( Ctx->LoRaMacDevAddr >> 16 ) & 0xFF;
+            Ctx->LoRaMacBuffer[pktHeaderLen++] = ( Ctx->LoRaMacDevAddr >> 24 ) & 0xFF;
 
-            LoRaMacBuffer[pktHeaderLen++] = fCtrl->Value;
+            Ctx->LoRaMacBuffer[pktHeaderLen++] = fCtrl->Value;
 
-            LoRaMacBuffer[pktHeaderLen++] = UpLinkCounter & 0xFF;
-            LoRaMacBuffer[pktHeaderLen++] = ( UpLinkCounter >> 8 ) & 0xFF;
+            Ctx->LoRaMacBuffer[pktHeaderLen++] = Ctx->UpLinkCounter & 0xFF;
+            Ctx->LoRaMacBuffer[pktHeaderLen++] = ( Ctx->UpLinkCounter >> 8 ) & 0xFF;
 
             // Copy the MAC commands which must be re-send into the MAC command buffer
-            memcpy1( &MacCommandsBuffer[MacCommandsBufferIndex], MacCommandsBufferToRepeat, MacCommandsBufferToRepeatIndex );
-            MacCommandsBufferIndex += MacCommandsBufferToRepeatIndex;
+            memcpy1( &Ctx->MacCommandsBuffer[Ctx->MacCommandsBufferIndex], Ctx->MacCommandsBufferToRepeat, Ctx->MacCommandsBufferToRepeatIndex );
+            Ctx->MacCommandsBufferIndex += Ctx->MacCommandsBufferToRepeatIndex;
 
-            if ( ( payload != NULL ) && ( LoRaMacTxPayloadLen > 0 ) ) {
-                if ( MacCommandsInNextTx == true ) {
-                    if ( MacCommandsBufferIndex <= LORA_MAC_COMMAND_MAX_FOPTS_LENGTH ) {
-                        fCtrl->Bits.FOptsLen += MacCommandsBufferIndex;
+            if ( ( payload != NULL ) && ( Ctx->LoRaMacTxPayloadLen > 0 ) ) {
+                if ( Ctx->MacCommandsInNextTx == true ) {
+                    if ( Ctx->MacCommandsBufferIndex <= LORA_MAC_COMMAND_MAX_FOPTS_LENGTH ) {
+                        fCtrl->Bits.FOptsLen += Ctx->MacCommandsBufferIndex;
 
                         // Update FCtrl field with new value of OptionsLength
-                        LoRaMacBuffer[0x05] = fCtrl->Value;
-                        for ( i = 0; i < MacCommandsBufferIndex; i++ ) {
-                            LoRaMacBuffer[pktHeaderLen++] = MacCommandsBuffer[i];
+                        Ctx->LoRaMacBuffer[0x05] = fCtrl->Value;
+                        for ( i = 0; i < Ctx->MacCommandsBufferIndex; i++ ) {
+                            Ctx->LoRaMacBuffer[pktHeaderLen++] = Ctx->MacCommandsBuffer[i];
                         }
                     } else {
-                        LoRaMacTxPayloadLen = MacCommandsBufferIndex;
-                        payload = MacCommandsBuffer;
+                        Ctx->LoRaMacTxPayloadLen = Ctx->MacCommandsBufferIndex;
+                        payload = Ctx->MacCommandsBuffer;
                         framePort = 0;
                     }
                 }
             } else {
-                if ( ( MacCommandsBufferIndex > 0 ) && ( MacCommandsInNextTx == true ) ) {
-                    LoRaMacTxPayloadLen = MacCommandsBufferIndex;
-                    payload = MacCommandsBuffer;
+                if ( ( Ctx->MacCommandsBufferIndex > 0 ) && ( Ctx->MacCommandsInNextTx == true ) ) {
+                    Ctx->LoRaMacTxPayloadLen = Ctx->MacCommandsBufferIndex;
+                    payload = Ctx->MacCommandsBuffer;
                     framePort = 0;
                 }
             }
-            MacCommandsInNextTx = false;
+            Ctx->MacCommandsInNextTx = false;
             // Store MAC commands which must be re-send in case the device does not receive a downlink anymore
-            MacCommandsBufferToRepeatIndex = ParseMacCommandsToRepeat( MacCommandsBuffer, MacCommandsBufferIndex,
-                                                                       MacCommandsBufferToRepeat );
-            if ( MacCommandsBufferToRepeatIndex > 0 ) {
-                MacCommandsInNextTx = true;
+            Ctx->MacCommandsBufferToRepeatIndex = ParseMacCommandsToRepeat( Ctx->MacCommandsBuffer, Ctx->MacCommandsBufferIndex,
+                                                                       Ctx->MacCommandsBufferToRepeat );
+            if ( Ctx->MacCommandsBufferToRepeatIndex > 0 ) {
+                Ctx->MacCommandsInNextTx = true;
             }
 
-            if ( ( payload != NULL ) && ( LoRaMacTxPayloadLen > 0 ) ) {
-                LoRaMacBuffer[pktHeaderLen++] = framePort;
-                if ((pktHeaderLen + LoRaMacTxPayloadLen) > (LORAMAC_PHY_MAXPAYLOAD - 4))  {
-                    LoRaMacTxPayloadLen = LORAMAC_PHY_MAXPAYLOAD - 4 - pktHeaderLen;
+            if ( ( payload != NULL ) && ( Ctx->LoRaMacTxPayloadLen > 0 ) ) {
+                Ctx->LoRaMacBuffer[pktHeaderLen++] = framePort;
+                if ((pktHeaderLen + Ctx->LoRaMacTxPayloadLen) > (LORAMAC_PHY_MAXPAYLOAD - 4))  {
+                    Ctx->LoRaMacTxPayloadLen = LORAMAC_PHY_MAXPAYLOAD - 4 - pktHeaderLen;
                 }
 
                 if ( framePort == 0 ) {
                     // Reset buffer index as the mac commands are being sent on port 0
-                    MacCommandsBufferIndex = 0;
-                    LoRaMacPayloadEncrypt( (uint8_t * ) payload, LoRaMacTxPayloadLen, LoRaMacNwkSKey, LoRaMacDevAddr, UP_LINK,
-                                           UpLinkCounter, &LoRaMacBuffer[pktHeaderLen] );
+                    Ctx->MacCommandsBufferIndex = 0;
+                    LoRaMacPayloadEncrypt( (uint8_t * ) payload, Ctx->LoRaMacTxPayloadLen, Ctx->LoRaMacNwkSKey, Ctx->LoRaMacDevAddr, UP_LINK,
+                                           Ctx->UpLinkCounter, &Ctx->LoRaMacBuffer[pktHeaderLen] );
                 } else {
-                    LoRaMacPayloadEncrypt( (uint8_t * ) payload, LoRaMacTxPayloadLen, LoRaMacAppSKey, LoRaMacDevAddr, UP_LINK,
-                                           UpLinkCounter, &LoRaMacBuffer[pktHeaderLen] );
+                    LoRaMacPayloadEncrypt( (uint8_t * ) payload, Ctx->LoRaMacTxPayloadLen, Ctx->LoRaMacAppSKey, Ctx->LoRaMacDevAddr, UP_LINK,
+                                           Ctx->UpLinkCounter, &Ctx->LoRaMacBuffer[pktHeaderLen] );
                 }
             }
-            LoRaMacBufferPktLen = pktHeaderLen + LoRaMacTxPayloadLen;
+            Ctx->LoRaMacBufferPktLen = pktHeaderLen + Ctx->LoRaMacTxPayloadLen;
 
-            LoRaMacComputeMic( LoRaMacBuffer, LoRaMacBufferPktLen, LoRaMacNwkSKey, LoRaMacDevAddr, UP_LINK, UpLinkCounter, &mic );
+            LoRaMacComputeMic( Ctx->LoRaMacBuffer, Ctx->LoRaMacBufferPktLen, Ctx->LoRaMacNwkSKey, Ctx->LoRaMacDevAddr, UP_LINK, Ctx->UpLinkCounter, &mic );
 
-            LoRaMacBuffer[LoRaMacBufferPktLen + 0] = mic & 0xFF;
-            LoRaMacBuffer[LoRaMacBufferPktLen + 1] = ( mic >> 8 ) & 0xFF;
-            LoRaMacBuffer[LoRaMacBufferPktLen + 2] = ( mic >> 16 ) & 0xFF;
-            LoRaMacBuffer[LoRaMacBufferPktLen + 3] = ( mic >> 24 ) & 0xFF;
+            Ctx->LoRaMacBuffer[Ctx->LoRaMacBufferPktLen + 0] = mic & 0xFF;
+            Ctx->LoRaMacBuffer[Ctx->LoRaMacBufferPktLen + 1] = ( mic >> 8 ) & 0xFF;
+            Ctx->LoRaMacBuffer[Ctx->LoRaMacBufferPktLen + 2] = ( mic >> 16 ) & 0xFF;
+            Ctx->LoRaMacBuffer[Ctx->LoRaMacBufferPktLen + 3] = ( mic >> 24 ) & 0xFF;
 
-            LoRaMacBufferPktLen += LORAMAC_MFR_LEN;
+            Ctx->LoRaMacBufferPktLen += LORAMAC_MFR_LEN;
 
             break;
         case FRAME_TYPE_PROPRIETARY:
-            if ( ( fBuffer != NULL ) && ( LoRaMacTxPayloadLen > 0 ) ) {
-                memcpy1( LoRaMacBuffer + pktHeaderLen, ( uint8_t * ) fBuffer, LoRaMacTxPayloadLen );
-                LoRaMacBufferPktLen = pktHeaderLen + LoRaMacTxPayloadLen;
+            if ( ( fBuffer != NULL ) && ( Ctx->LoRaMacTxPayloadLen > 0 ) ) {
+                memcpy1( Ctx->LoRaMacBuffer + pktHeaderLen, ( uint8_t * ) fBuffer, Ctx->LoRaMacTxPayloadLen );
+                Ctx->LoRaMacBufferPktLen = pktHeaderLen + Ctx->LoRaMacTxPayloadLen;
             }
             break;
         default:
@@ -2408,44 +3279,56 @@ LoRaMacStatus_t PrepareFrame( LoRaMacHeader_t *macHdr, LoRaMacFrameCtrl_t *fCtrl
 }
 
 
-
-extern void calRTC();
 LoRaMacStatus_t SendFrameOnChannel( uint8_t channel )
 {
 
     TxConfigParams_t txConfig;
     int8_t txPower = 0;
 
+    // The TX power control never goes above the power set by the network
+    Ctx->Power.Backoff = PowerGetBackoff( );
+
     txConfig.Channel = channel;
-    txConfig.Datarate = LoRaMacParams.ChannelsDatarate;
-    txConfig.TxPower = LoRaMacParams.ChannelsTxPower;
-    txConfig.MaxEirp = LoRaMacParams.MaxEirp;
-    txConfig.AntennaGain = LoRaMacParams.AntennaGain;
-    txConfig.PktLen = LoRaMacBufferPktLen;
+    txConfig.Datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+    txConfig.TxPower = Ctx->LoRaMacParams.ChannelsTxPower + Ctx->Power.Backoff;
+    txConfig.MaxEirp = Ctx->LoRaMacParams.MaxEirp;
+    txConfig.AntennaGain = Ctx->LoRaMacParams.AntennaGain;
+    txConfig.PktLen = Ctx->LoRaMacBufferPktLen;
 
-    RegionTxConfig( LoRaMacRegion, &txConfig, &txPower, &TxTimeOnAir );
+    RegionTxConfig( Ctx->LoRaMacRegion, &txConfig, &txPower, &Ctx->TxTimeOnAir );
+    PowerTxDone( txPower );
 
     LoRaMacConfirmQueueSetStatusCmn( LORAMAC_EVENT_INFO_STATUS_ERROR );
-    McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
-    McpsConfirm.Datarate = LoRaMacParams.ChannelsDatarate;
-    McpsConfirm.TxPower = txPower;
-    McpsConfirm.Channel = channel;
+    Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
+    Ctx->McpsConfirm.Datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+    Ctx->McpsConfirm.TxPower = txPower;
+    Ctx->McpsConfirm.Channel = channel;
 
     // Store the time on air
-    McpsConfirm.TxTimeOnAir = TxTimeOnAir;
-    MlmeConfirm.TxTimeOnAir = TxTimeOnAir;
-//    calRTC();
-    // Starts the MAC layer status check timer
-    TimerSetValue( &MacStateCheckTimer, MAC_STATE_CHECK_TIMEOUT );
-    TimerStart( &MacStateCheckTimer );
+    Ctx->McpsConfirm.TxTimeOnAir = Ctx->TxTimeOnAir;
+    Ctx->MlmeConfirm.TxTimeOnAir = Ctx->TxTimeOnAir;
 
-    if ( IsLoRaMacNetworkJoined == false ) {
-        JoinRequestTrials++;
+    // Starts the MAC layer status check timer
+    TimerSetValue( &Ctx->MacStateCheckTimer, MAC_STATE_CHECK_TIMEOUT );
+    TimerStart( &Ctx->MacStateCheckTimer );
+    TRACE( TRACE_EVENT_MAC, TRACE_MAC_SEND, Ctx->LoRaMacState );
+
+    Ctx->Statistics.TxFrames++;
+    Ctx->Statistics.AirTime += Ctx->TxTimeOnAir;
+    if ( Ctx->NetworkJoined == false ) {
+        Ctx->JoinRequestTrials++;
+        Ctx->Statistics.JoinRequests++;
+    } else if ( Ctx->AdrStatus.BackoffActive == true ) {
+        Ctx->AdrStatus.EpisodeUplinks++;
+        Ctx->AdrStatus.EpisodeAirTime += Ctx->TxTimeOnAir;
     }
+    EnergyUplinkStart( );
     // Send now
-    Radio.Send( LoRaMacBuffer, LoRaMacBufferPktLen );
+    RadioOwner = Ctx;
+    gettimeofday (&Ctx->TxStartSysTime, NULL);
+    Radio.Send( Ctx->LoRaMacBuffer, Ctx->LoRaMacBufferPktLen );
 
-    LoRaMacState |= LORAMAC_TX_RUNNING;
+    Ctx->LoRaMacState |= LORAMAC_TX_RUNNING;
 
     return LORAMAC_STATUS_OK;
 }
@@ -2454,39 +3337,41 @@ LoRaMacStatus_t SetTxContinuousWave( uint16_t timeout )
 {
     ContinuousWaveParams_t continuousWave;
 
-    continuousWave.Channel = Channel;
-    continuousWave.Datarate = LoRaMacParams.ChannelsDatarate;
-    continuousWave.TxPower = LoRaMacParams.ChannelsTxPower;
-    continuousWave.MaxEirp = LoRaMacParams.MaxEirp;
-    continuousWave.AntennaGain = LoRaMacParams.AntennaGain;
+    continuousWave.Channel = Ctx->Channel;
+    continuousWave.Datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+    continuousWave.TxPower = Ctx->LoRaMacParams.ChannelsTxPower;
+    continuousWave.MaxEirp = Ctx->LoRaMacParams.MaxEirp;
+    continuousWave.AntennaGain = Ctx->LoRaMacParams.AntennaGain;
     continuousWave.Timeout = timeout;
 
-    RegionSetContinuousWave( LoRaMacRegion, &continuousWave );
+    RadioOwner = Ctx;
+    RegionSetContinuousWave( Ctx->LoRaMacRegion, &continuousWave );
 
     // Starts the MAC layer status check timer
-    TimerSetValue( &MacStateCheckTimer, MAC_STATE_CHECK_TIMEOUT );
-    TimerStart( &MacStateCheckTimer );
+    TimerSetValue( &Ctx->MacStateCheckTimer, MAC_STATE_CHECK_TIMEOUT );
+    TimerStart( &Ctx->MacStateCheckTimer );
 
-    LoRaMacState |= LORAMAC_TX_RUNNING;
+    Ctx->LoRaMacState |= LORAMAC_TX_RUNNING;
 
     return LORAMAC_STATUS_OK;
 }
 
 LoRaMacStatus_t SetTxContinuousWave1( uint16_t timeout, uint32_t frequency, uint8_t power )
 {
+    RadioOwner = Ctx;
     Radio.SetTxContinuousWave( frequency, power, timeout );
 
     // Starts the MAC layer status check timer
-    TimerSetValue( &MacStateCheckTimer, MAC_STATE_CHECK_TIMEOUT );
-    TimerStart( &MacStateCheckTimer );
+    TimerSetValue( &Ctx->MacStateCheckTimer, MAC_STATE_CHECK_TIMEOUT );
+    TimerStart( &Ctx->MacStateCheckTimer );
 
-    LoRaMacState |= LORAMAC_TX_RUNNING;
+    Ctx->LoRaMacState |= LORAMAC_TX_RUNNING;
 
     return LORAMAC_STATUS_OK;
 }
 
-LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t *primitives, LoRaMacCallback_t *callbacks,
-                                       LoRaMacRegion_t region )
+static LoRaMacStatus_t Initialization( const LoRaMacCtxTimers_t *timers, LoRaMacPrimitives_t *primitives,
+                                       LoRaMacCallback_t *callbacks, LoRaMacRegion_t region )
 {
     GetPhyParams_t getPhy;
     PhyParam_t phyParam;
@@ -2509,143 +3394,157 @@ LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t *primitives, LoRaMacC
     // Confirm queue reset
     LoRaMacConfirmQueueInit( primitives );
 
-    LoRaMacPrimitives = primitives;
-    LoRaMacCallbacks = callbacks;
-    LoRaMacRegion = region;
+    Ctx->LoRaMacPrimitives = primitives;
+    Ctx->LoRaMacCallbacks = callbacks;
+    Ctx->LoRaMacRegion = region;
 
-    if(IsLoRaMacNetworkJoined==false){
-    LoRaMacFlags.Value = 0;
+    if(Ctx->NetworkJoined==false){
+    Ctx->LoRaMacFlags.Value = 0;
 
-    LoRaMacDeviceClass = CLASS_A;
-    LoRaMacState = LORAMAC_IDLE;
+    Ctx->LoRaMacDeviceClass = CLASS_A;
+    Ctx->LoRaMacState = LORAMAC_IDLE;
 
-    JoinRequestTrials = 0;
-    MaxJoinRequestTrials = 1;
+    Ctx->JoinRequestTrials = 0;
+    Ctx->MaxJoinRequestTrials = 1;
 
     // Reset duty cycle times
-    AggregatedLastTxDoneTime = 0;
-    AggregatedTimeOff = 0;
+    Ctx->AggregatedLastTxDoneTime = 0;
+    Ctx->AggregatedTimeOff = 0;
 
     // Reset to defaults
     getPhy.Attribute = PHY_DUTY_CYCLE;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    DutyCycleOn = ( bool ) phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->DutyCycleOn = ( bool ) phyParam.Value;
 
     getPhy.Attribute = PHY_DEF_TX_POWER;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.ChannelsTxPower = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.ChannelsTxPower = phyParam.Value;
 
     getPhy.Attribute = PHY_DEF_TX_DR;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.ChannelsDatarate = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.ChannelsDatarate = phyParam.Value;
 
     getPhy.Attribute = PHY_MAX_RX_WINDOW;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.MaxRxWindow = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.MaxRxWindow = phyParam.Value;
 
     getPhy.Attribute = PHY_RECEIVE_DELAY1;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.ReceiveDelay1 = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.ReceiveDelay1 = phyParam.Value;
 
     getPhy.Attribute = PHY_RECEIVE_DELAY2;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.ReceiveDelay2 = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.ReceiveDelay2 = phyParam.Value;
 
     getPhy.Attribute = PHY_JOIN_ACCEPT_DELAY1;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.JoinAcceptDelay1 = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.JoinAcceptDelay1 = phyParam.Value;
 
     getPhy.Attribute = PHY_JOIN_ACCEPT_DELAY2;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.JoinAcceptDelay2 = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.JoinAcceptDelay2 = phyParam.Value;
 
     getPhy.Attribute = PHY_DEF_DR1_OFFSET;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.Rx1DrOffset = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.Rx1DrOffset = phyParam.Value;
 
     getPhy.Attribute = PHY_DEF_RX2_FREQUENCY;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.Rx2Channel.Frequency = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.Rx2Channel.Frequency = phyParam.Value;
 
     getPhy.Attribute = PHY_DEF_RX2_DR;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.Rx2Channel.Datarate = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.Rx2Channel.Datarate = phyParam.Value;
 
     getPhy.Attribute = PHY_DEF_UPLINK_DWELL_TIME;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.UplinkDwellTime = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.UplinkDwellTime = phyParam.Value;
 
     getPhy.Attribute = PHY_DEF_DOWNLINK_DWELL_TIME;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.DownlinkDwellTime = phyParam.Value;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.DownlinkDwellTime = phyParam.Value;
 
     getPhy.Attribute = PHY_DEF_MAX_EIRP;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.MaxEirp = phyParam.fValue;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.MaxEirp = phyParam.fValue;
 
     getPhy.Attribute = PHY_DEF_ANTENNA_GAIN;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
-    LoRaMacParamsDefaults.AntennaGain = phyParam.fValue;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
+    Ctx->LoRaMacParamsDefaults.AntennaGain = phyParam.fValue;
 
-    RegionInitDefaults( LoRaMacRegion, INIT_TYPE_INIT );
+    RegionInitDefaults( Ctx->LoRaMacRegion, INIT_TYPE_INIT );
+    RestoreDutyCycle( );
 
     // Init parameters which are not set in function ResetMacParameters
-    LoRaMacParams.RepeaterSupport = false;
-    LoRaMacParamsDefaults.ChannelsNbRep = 1;
-    LoRaMacParamsDefaults.SystemMaxRxError = 10;
-    LoRaMacParamsDefaults.MinRxSymbols = 6;
-
-    LoRaMacParams.SystemMaxRxError = LoRaMacParamsDefaults.SystemMaxRxError;
-    LoRaMacParams.MinRxSymbols = LoRaMacParamsDefaults.MinRxSymbols;
-    LoRaMacParams.MaxRxWindow = LoRaMacParamsDefaults.MaxRxWindow;
-    LoRaMacParams.ReceiveDelay1 = LoRaMacParamsDefaults.ReceiveDelay1;
-    LoRaMacParams.ReceiveDelay2 = LoRaMacParamsDefaults.ReceiveDelay2;
-    LoRaMacParams.JoinAcceptDelay1 = LoRaMacParamsDefaults.JoinAcceptDelay1;
-    LoRaMacParams.JoinAcceptDelay2 = LoRaMacParamsDefaults.JoinAcceptDelay2;
-    LoRaMacParams.ChannelsNbRep = LoRaMacParamsDefaults.ChannelsNbRep;
+    Ctx->LoRaMacParams.RepeaterSupport = false;
+    Ctx->LoRaMacParamsDefaults.ChannelsNbRep = 1;
+    Ctx->LoRaMacParamsDefaults.SystemMaxRxError = 10;
+    Ctx->LoRaMacParamsDefaults.MinRxSymbols = 6;
+
+    Ctx->LoRaMacParams.SystemMaxRxError = Ctx->LoRaMacParamsDefaults.SystemMaxRxError;
+    Ctx->LoRaMacParams.MinRxSymbols = Ctx->LoRaMacParamsDefaults.MinRxSymbols;
+
+    memset1( ( uint8_t * )&Ctx->RxTiming, 0, sizeof( Ctx->RxTiming ) );
+    Ctx->RxTiming.TargetMissRate = RX_TIMING_DEFAULT_TARGET_MISS;
+
+    Ctx->LoRaMacParams.MaxRxWindow = Ctx->LoRaMacParamsDefaults.MaxRxWindow;
+    Ctx->LoRaMacParams.ReceiveDelay1 = Ctx->LoRaMacParamsDefaults.ReceiveDelay1;
+    Ctx->LoRaMacParams.ReceiveDelay2 = Ctx->LoRaMacParamsDefaults.ReceiveDelay2;
+    Ctx->LoRaMacParams.JoinAcceptDelay1 = Ctx->LoRaMacParamsDefaults.JoinAcceptDelay1;
+    Ctx->LoRaMacParams.JoinAcceptDelay2 = Ctx->LoRaMacParamsDefaults.JoinAcceptDelay2;
+    Ctx->LoRaMacParams.ChannelsNbRep = Ctx->LoRaMacParamsDefaults.ChannelsNbRep;
 
       ResetMacParameters( );
     }
 
     // Initialize timers
-    TimerInit( &MacStateCheckTimer, OnMacStateCheckTimerEvent );
-    TimerSetValue( &MacStateCheckTimer, MAC_STATE_CHECK_TIMEOUT );
-
-    TimerInit( &TxDelayedTimer, OnTxDelayedTimerEvent );
-    TimerInit( &RxWindowTimer1, OnRxWindow1TimerEvent );
-    TimerInit( &RxWindowTimer2, OnRxWindow2TimerEvent );
-    TimerInit( &AckTimeoutTimer, OnAckTimeoutTimerEvent );
+    TimerInit( &Ctx->MacStateCheckTimer, timers->MacStateCheck );
+    TimerSetValue( &Ctx->MacStateCheckTimer, MAC_STATE_CHECK_TIMEOUT );
+
+    TimerInit( &Ctx->TxDelayedTimer, timers->TxDelayed );
+    TimerInit( &Ctx->RxWindowTimer1, timers->RxWindow1 );
+    TimerInit( &Ctx->RxWindowTimer2, timers->RxWindow2 );
+    TimerInit( &Ctx->AckTimeoutTimer, timers->AckTimeout );
+#ifdef TIMER_EVENT_CONTEXT
+    TimerSetContext( &Ctx->MacStateCheckTimer, Ctx );
+    TimerSetContext( &Ctx->TxDelayedTimer, Ctx );
+    TimerSetContext( &Ctx->RxWindowTimer1, Ctx );
+    TimerSetContext( &Ctx->RxWindowTimer2, Ctx );
+    TimerSetContext( &Ctx->AckTimeoutTimer, Ctx );
+#endif
+    LoRaMacLbtInit( OnLbtDoneEvent );
 
     // Store the current initialization time
-    LoRaMacInitializationTime = TimerGetCurrentTime( );
+    Ctx->LoRaMacInitializationTime = TimerGetCurrentTime( );
 
     // Initialize Radio driver
-    RadioEvents.TxDone = OnRadioTxDone;
-    RadioEvents.RxDone = OnRadioRxDone;
-    RadioEvents.RxError = OnRadioRxError;
-    RadioEvents.TxTimeout = OnRadioTxTimeout;
-    RadioEvents.RxTimeout = OnRadioRxTimeout;
+    RadioEvents.TxDone = OnRadioTxDoneEvent;
+    RadioEvents.RxDone = OnRadioRxDoneEvent;
+    RadioEvents.RxError = OnRadioRxErrorEvent;
+    RadioEvents.TxTimeout = OnRadioTxTimeoutEvent;
+    RadioEvents.RxTimeout = OnRadioRxTimeoutEvent;
+    RadioEvents.CadDone = OnRadioCadDoneEvent;
 
     Radio.Init( &RadioEvents );
 
     // Random seed initialization
     srand1( Radio.Random( ) );
 
-    PublicNetwork = true;
+    Ctx->PublicNetwork = true;
     Radio.SetPublicNetwork(true);
     Radio.Sleep( );
 
     return LORAMAC_STATUS_OK;
 }
 
-LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t *txInfo )
+static LoRaMacStatus_t QueryTxPossible( uint8_t size, LoRaMacTxInfo_t *txInfo )
 {
     AdrNextParams_t adrNext;
     GetPhyParams_t getPhy;
     PhyParam_t phyParam;
-    int8_t datarate = LoRaMacParamsDefaults.ChannelsDatarate;
-    int8_t txPower = LoRaMacParamsDefaults.ChannelsTxPower;
-    uint8_t fOptLen = MacCommandsBufferIndex + MacCommandsBufferToRepeatIndex;
+    int8_t datarate = Ctx->LoRaMacParamsDefaults.ChannelsDatarate;
+    int8_t txPower = Ctx->LoRaMacParamsDefaults.ChannelsTxPower;
+    uint8_t fOptLen = Ctx->MacCommandsBufferIndex + Ctx->MacCommandsBufferToRepeatIndex;
 
     if ( txInfo == NULL ) {
         return LORAMAC_STATUS_PARAMETER_INVALID;
@@ -2653,26 +3552,26 @@ LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t *txInfo )
 
     // Setup ADR request
     adrNext.UpdateChanMask = false;
-    adrNext.AdrEnabled = AdrCtrlOn;
-    adrNext.AdrAckCounter = AdrAckCounter;
-    adrNext.Datarate = LoRaMacParams.ChannelsDatarate;
-    adrNext.TxPower = LoRaMacParams.ChannelsTxPower;
-    adrNext.UplinkDwellTime = LoRaMacParams.UplinkDwellTime;
+    adrNext.AdrEnabled = Ctx->AdrCtrlOn;
+    adrNext.AdrAckCounter = Ctx->AdrAckCounter;
+    adrNext.Datarate = Ctx->LoRaMacParams.ChannelsDatarate;
+    adrNext.TxPower = Ctx->LoRaMacParams.ChannelsTxPower;
+    adrNext.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
 
     // We call the function for information purposes only. We don't want to
     // apply the datarate, the tx power and the ADR ack counter.
-    RegionAdrNext( LoRaMacRegion, &adrNext, &datarate, &txPower, &AdrAckCounter );
+    RegionAdrNext( Ctx->LoRaMacRegion, &adrNext, &datarate, &txPower, &Ctx->AdrAckCounter );
 
     // Setup PHY request
-    getPhy.UplinkDwellTime = LoRaMacParams.UplinkDwellTime;
+    getPhy.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
     getPhy.Datarate = datarate;
     getPhy.Attribute = PHY_MAX_PAYLOAD;
 
     // Change request in case repeater is supported
-    if( LoRaMacParams.RepeaterSupport == true ) {
+    if( Ctx->LoRaMacParams.RepeaterSupport == true ) {
         getPhy.Attribute = PHY_MAX_PAYLOAD_REPEATER;
     }
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
     txInfo->CurrentPayloadSize = phyParam.Value;
 
     // Verify if the fOpts fit into the maximum payload
@@ -2683,8 +3582,8 @@ LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t *txInfo )
         // The fOpts don't fit into the maximum payload. Omit the MAC commands to
         // ensure that another uplink is possible.
         fOptLen = 0;
-        MacCommandsBufferIndex = 0;
-        MacCommandsBufferToRepeatIndex = 0;
+        Ctx->MacCommandsBufferIndex = 0;
+        Ctx->MacCommandsBufferToRepeatIndex = 0;
     }
 
     // Verify if the fOpts and the payload fit into the maximum payload
@@ -2694,7 +3593,7 @@ LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t *txInfo )
     return LORAMAC_STATUS_OK;
 }
 
-LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t *mibGet )
+static LoRaMacStatus_t MibGetRequestConfirm( MibRequestConfirm_t *mibGet )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_OK;
     GetPhyParams_t getPhy;
@@ -2706,132 +3605,215 @@ LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t *mibGet )
 
     switch ( mibGet->Type ) {
         case MIB_DEVICE_CLASS: {
-            mibGet->Param.Class = LoRaMacDeviceClass;
+            mibGet->Param.Class = Ctx->LoRaMacDeviceClass;
             break;
         }
         case MIB_NETWORK_JOINED: {
-            mibGet->Param.IsNetworkJoined = IsLoRaMacNetworkJoined;
+            mibGet->Param.IsNetworkJoined = Ctx->NetworkJoined;
             break;
         }
         case MIB_ADR: {
-            mibGet->Param.AdrEnable = AdrCtrlOn;
+            mibGet->Param.AdrEnable = Ctx->AdrCtrlOn;
             break;
         }
         case MIB_NET_ID: {
-            mibGet->Param.NetID = LoRaMacNetID;
+            mibGet->Param.NetID = Ctx->LoRaMacNetID;
             break;
         }
         case MIB_DEV_ADDR: {
-            mibGet->Param.DevAddr = LoRaMacDevAddr;
+            mibGet->Param.DevAddr = Ctx->LoRaMacDevAddr;
             break;
         }
         case MIB_NWK_SKEY: {
-            mibGet->Param.NwkSKey = LoRaMacNwkSKey;
+            mibGet->Param.NwkSKey = Ctx->LoRaMacNwkSKey;
             break;
         }
         case MIB_APP_SKEY: {
-            mibGet->Param.AppSKey = LoRaMacAppSKey;
+            mibGet->Param.AppSKey = Ctx->LoRaMacAppSKey;
             break;
         }
         case MIB_PUBLIC_NETWORK: {
-            mibGet->Param.EnablePublicNetwork = PublicNetwork;
+            mibGet->Param.EnablePublicNetwork = Ctx->PublicNetwork;
             break;
         }
         case MIB_REPEATER_SUPPORT: {
-            mibGet->Param.EnableRepeaterSupport = LoRaMacParams.RepeaterSupport;
+            mibGet->Param.EnableRepeaterSupport = Ctx->LoRaMacParams.RepeaterSupport;
             break;
         }
         case MIB_CHANNELS: {
             getPhy.Attribute = PHY_CHANNELS;
-            phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
+            phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
 
             mibGet->Param.ChannelList = phyParam.Channels;
             break;
         }
         case MIB_RX2_CHANNEL: {
-            mibGet->Param.Rx2Channel = LoRaMacParams.Rx2Channel;
+            mibGet->Param.Rx2Channel = Ctx->LoRaMacParams.Rx2Channel;
             break;
         }
         case MIB_RX2_DEFAULT_CHANNEL: {
-            mibGet->Param.Rx2Channel = LoRaMacParamsDefaults.Rx2Channel;
+            mibGet->Param.Rx2Channel = Ctx->LoRaMacParamsDefaults.Rx2Channel;
             break;
         }
         case MIB_CHANNELS_DEFAULT_MASK: {
             getPhy.Attribute = PHY_CHANNELS_DEFAULT_MASK;
-            phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
+            phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
 
             mibGet->Param.ChannelsDefaultMask = phyParam.ChannelsMask;
             break;
         }
         case MIB_CHANNELS_MASK: {
             getPhy.Attribute = PHY_CHANNELS_MASK;
-            phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
+            phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
 
             mibGet->Param.ChannelsMask = phyParam.ChannelsMask;
             break;
         }
         case MIB_CHANNELS_NB_REP: {
-            mibGet->Param.ChannelNbRep = LoRaMacParams.ChannelsNbRep;
+            mibGet->Param.ChannelNbRep = Ctx->LoRaMacParams.ChannelsNbRep;
             break;
         }
         case MIB_MAX_RX_WINDOW_DURATION: {
-            mibGet->Param.MaxRxWindow = LoRaMacParams.MaxRxWindow;
+            mibGet->Param.MaxRxWindow = Ctx->LoRaMacParams.MaxRxWindow;
             break;
         }
         case MIB_RECEIVE_DELAY_1: {
-            mibGet->Param.ReceiveDelay1 = LoRaMacParams.ReceiveDelay1;
+            mibGet->Param.ReceiveDelay1 = Ctx->LoRaMacParams.ReceiveDelay1;
             break;
         }
         case MIB_RECEIVE_DELAY_2: {
-            mibGet->Param.ReceiveDelay2 = LoRaMacParams.ReceiveDelay2;
+            mibGet->Param.ReceiveDelay2 = Ctx->LoRaMacParams.ReceiveDelay2;
             break;
         }
         case MIB_JOIN_ACCEPT_DELAY_1: {
-            mibGet->Param.JoinAcceptDelay1 = LoRaMacParams.JoinAcceptDelay1;
+            mibGet->Param.JoinAcceptDelay1 = Ctx->LoRaMacParams.JoinAcceptDelay1;
             break;
         }
         case MIB_JOIN_ACCEPT_DELAY_2: {
-            mibGet->Param.JoinAcceptDelay2 = LoRaMacParams.JoinAcceptDelay2;
+            mibGet->Param.JoinAcceptDelay2 = Ctx->LoRaMacParams.JoinAcceptDelay2;
             break;
         }
         case MIB_CHANNELS_DEFAULT_DATARATE: {
-            mibGet->Param.ChannelsDefaultDatarate = LoRaMacParamsDefaults.ChannelsDatarate;
+            mibGet->Param.ChannelsDefaultDatarate = Ctx->LoRaMacParamsDefaults.ChannelsDatarate;
             break;
         }
         case MIB_CHANNELS_DATARATE: {
-            mibGet->Param.ChannelsDatarate = LoRaMacParams.ChannelsDatarate;
+            mibGet->Param.ChannelsDatarate = Ctx->LoRaMacParams.ChannelsDatarate;
             break;
         }
         case MIB_CHANNELS_DEFAULT_TX_POWER: {
-            mibGet->Param.ChannelsDefaultTxPower = LoRaMacParamsDefaults.ChannelsTxPower;
+            mibGet->Param.ChannelsDefaultTxPower = Ctx->LoRaMacParamsDefaults.ChannelsTxPower;
             break;
         }
         case MIB_CHANNELS_TX_POWER: {
-            mibGet->Param.ChannelsTxPower = LoRaMacParams.ChannelsTxPower;
+            mibGet->Param.ChannelsTxPower = Ctx->LoRaMacParams.ChannelsTxPower;
             break;
         }
         case MIB_UPLINK_COUNTER: {
-            mibGet->Param.UpLinkCounter = UpLinkCounter;
+            mibGet->Param.UpLinkCounter = Ctx->UpLinkCounter;
             break;
         }
         case MIB_DOWNLINK_COUNTER: {
-            mibGet->Param.DownLinkCounter = DownLinkCounter;
+            mibGet->Param.DownLinkCounter = Ctx->DownLinkCounter;
             break;
         }
         case MIB_MULTICAST_CHANNEL: {
-            mibGet->Param.MulticastList = MulticastChannels;
+            mibGet->Param.MulticastList = Ctx->MulticastChannels;
             break;
         }
         case MIB_SYSTEM_MAX_RX_ERROR: {
-            mibGet->Param.SystemMaxRxError = LoRaMacParams.SystemMaxRxError;
+            mibGet->Param.SystemMaxRxError = Ctx->LoRaMacParams.SystemMaxRxError;
             break;
         }
         case MIB_MIN_RX_SYMBOLS: {
-            mibGet->Param.MinRxSymbols = LoRaMacParams.MinRxSymbols;
+            mibGet->Param.MinRxSymbols = Ctx->LoRaMacParams.MinRxSymbols;
             break;
         }
         case MIB_ANTENNA_GAIN: {
-            mibGet->Param.AntennaGain = LoRaMacParams.AntennaGain;
+            mibGet->Param.AntennaGain = Ctx->LoRaMacParams.AntennaGain;
+            break;
+        }
+        case MIB_ADR_STATUS: {
+            Ctx->AdrStatus.AdrAckCounter = Ctx->AdrAckCounter;
+            mibGet->Param.AdrStatus = &Ctx->AdrStatus;
+            break;
+        }
+        case MIB_RX_TIMING_ADAPTIVE: {
+            mibGet->Param.RxTimingAdaptive = Ctx->RxTiming.Adaptive;
+            break;
+        }
+        case MIB_RX_TIMING_TARGET_MISS: {
+            mibGet->Param.RxTimingTargetMiss = Ctx->RxTiming.TargetMissRate;
+            break;
+        }
+        case MIB_RX_TIMING_STATUS: {
+            Ctx->RxTiming.RxError[0] = RxTimingGetRxError( 0 );
+            Ctx->RxTiming.RxError[1] = RxTimingGetRxError( 1 );
+            mibGet->Param.RxTimingStatus = &Ctx->RxTiming;
+            break;
+        }
+        case MIB_ENERGY_STATUS: {
+            mibGet->Param.EnergyStatus = EnergyGetStatus( );
+            break;
+        }
+        case MIB_MAC_STATISTICS: {
+            mibGet->Param.Statistics = &Ctx->Statistics;
+            break;
+        }
+        case MIB_LBT_ENABLE: {
+            mibGet->Param.LbtEnable = LoRaMacLbtIsEnabled( );
+            break;
+        }
+        case MIB_LBT_MODE: {
+            mibGet->Param.LbtMode = LoRaMacLbtGetMode( );
+            break;
+        }
+        case MIB_LBT_STATUS: {
+            mibGet->Param.LbtStatus = LoRaMacLbtGetStatus( );
+            break;
+        }
+        case MIB_RETRY_ADAPTIVE: {
+            mibGet->Param.RetryAdaptive = Ctx->Retry.Adaptive;
+            break;
+        }
+        case MIB_RETRY_DEADLINE: {
+            mibGet->Param.RetryDeadline = Ctx->Retry.Deadline;
+            break;
+        }
+        case MIB_RETRY_STATUS: {
+            mibGet->Param.RetryStatus = &Ctx->Retry;
+            break;
+        }
+        case MIB_LINK_ESTIMATOR: {
+            mibGet->Param.LinkEstimator = Ctx->Link.Enabled;
+            break;
+        }
+        case MIB_LINK_TARGET_PER: {
+            mibGet->Param.LinkTargetPer = ( Ctx->Link.TargetPer == 0 ) ? LINK_DEFAULT_TARGET_PER : Ctx->Link.TargetPer;
+            break;
+        }
+        case MIB_LINK_STATUS: {
+            float variance;
+
+            if ( LinkGetMargin( Ctx->LoRaMacParams.ChannelsDatarate, &Ctx->Link.Margin, &variance ) == true ) {
+                Ctx->Link.Uncertainty = sqrtf( variance );
+            } else {
+                Ctx->Link.Margin = 0;
+                Ctx->Link.Uncertainty = 0;
+            }
+            mibGet->Param.LinkStatus = &Ctx->Link;
+            break;
+        }
+        case MIB_TX_POWER_CONTROL: {
+            mibGet->Param.TxPowerControl = Ctx->Power.Enabled;
+            break;
+        }
+        case MIB_TX_POWER_TARGET_MARGIN: {
+            mibGet->Param.TxPowerTargetMargin = ( Ctx->Power.TargetMargin == 0 ) ? POWER_DEFAULT_TARGET_MARGIN : Ctx->Power.TargetMargin;
+            break;
+        }
+        case MIB_TX_POWER_STATUS: {
+            mibGet->Param.TxPowerStatus = &Ctx->Power;
             break;
         }
         default:
@@ -2842,7 +3824,7 @@ LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t *mibGet )
     return status;
 }
 
-LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
+static LoRaMacStatus_t MibSetRequestConfirm( MibRequestConfirm_t *mibSet )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_OK;
     ChanMaskSetParams_t chanMaskSet;
@@ -2851,7 +3833,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
     if ( mibSet == NULL ) {
         return LORAMAC_STATUS_PARAMETER_INVALID;
     }
-    if ( ( LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) {
+    if ( ( Ctx->LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) {
         return LORAMAC_STATUS_BUSY;
     }
 
@@ -2863,25 +3845,25 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
         }
         case MIB_NETWORK_JOINED:
         {
-            IsLoRaMacNetworkJoined = mibSet->Param.IsNetworkJoined;
+            SetNetworkJoined( mibSet->Param.IsNetworkJoined );
             break;
         }
         case MIB_ADR: {
-            AdrCtrlOn = mibSet->Param.AdrEnable;
+            Ctx->AdrCtrlOn = mibSet->Param.AdrEnable;
             break;
         }
         case MIB_NET_ID: {
-            LoRaMacNetID = mibSet->Param.NetID;
+            Ctx->LoRaMacNetID = mibSet->Param.NetID;
             break;
         }
         case MIB_DEV_ADDR: {
-            LoRaMacDevAddr = mibSet->Param.DevAddr;
+            Ctx->LoRaMacDevAddr = mibSet->Param.DevAddr;
             break;
         }
         case MIB_NWK_SKEY: {
             if ( mibSet->Param.NwkSKey != NULL ) {
-                memcpy1( LoRaMacNwkSKey, mibSet->Param.NwkSKey,
-                         sizeof( LoRaMacNwkSKey ) );
+                memcpy1( Ctx->LoRaMacNwkSKey, mibSet->Param.NwkSKey,
+                         sizeof( Ctx->LoRaMacNwkSKey ) );
             } else {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
@@ -2889,47 +3871,47 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
         }
         case MIB_APP_SKEY: {
             if ( mibSet->Param.AppSKey != NULL ) {
-                memcpy1( LoRaMacAppSKey, mibSet->Param.AppSKey,
-                         sizeof( LoRaMacAppSKey ) );
+                memcpy1( Ctx->LoRaMacAppSKey, mibSet->Param.AppSKey,
+                         sizeof( Ctx->LoRaMacAppSKey ) );
             } else {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
             break;
         }
         case MIB_PUBLIC_NETWORK: {
-            PublicNetwork = mibSet->Param.EnablePublicNetwork;
+            Ctx->PublicNetwork = mibSet->Param.EnablePublicNetwork;
             Radio.SetPublicNetwork(mibSet->Param.EnablePublicNetwork);
             break;
         }
         case MIB_REPEATER_SUPPORT: {
-             LoRaMacParams.RepeaterSupport = mibSet->Param.EnableRepeaterSupport;
+             Ctx->LoRaMacParams.RepeaterSupport = mibSet->Param.EnableRepeaterSupport;
             break;
         }
         case MIB_RX2_CHANNEL: {
             verify.DatarateParams.Datarate = mibSet->Param.Rx2Channel.Datarate;
-            verify.DatarateParams.DownlinkDwellTime = LoRaMacParams.DownlinkDwellTime;
+            verify.DatarateParams.DownlinkDwellTime = Ctx->LoRaMacParams.DownlinkDwellTime;
 
-            if ( RegionVerify( LoRaMacRegion, &verify, PHY_RX_DR ) == true ) {
-                memcpy(&LoRaMacParams.Rx2Channel, &mibSet->Param.Rx2Channel, sizeof(LoRaMacParams.Rx2Channel));
-                if ( ( LoRaMacDeviceClass == CLASS_C ) && ( IsLoRaMacNetworkJoined == true ) ) {
+            if ( RegionVerify( Ctx->LoRaMacRegion, &verify, PHY_RX_DR ) == true ) {
+                memcpy(&Ctx->LoRaMacParams.Rx2Channel, &mibSet->Param.Rx2Channel, sizeof(Ctx->LoRaMacParams.Rx2Channel));
+                if ( ( Ctx->LoRaMacDeviceClass == CLASS_C ) && ( Ctx->NetworkJoined == true ) ) {
                     // Compute Rx2 windows parameters
-                    RegionComputeRxWindowParameters( LoRaMacRegion,
-                                                     LoRaMacParams.Rx2Channel.Datarate,
-                                                     LoRaMacParams.MinRxSymbols,
-                                                     LoRaMacParams.SystemMaxRxError,
-                                                     &RxWindow2Config );
-
-                    RxWindow2Config.Channel = Channel;
-                    RxWindow2Config.Frequency = LoRaMacParams.Rx2Channel.Frequency;
-                    RxWindow2Config.DownlinkDwellTime = LoRaMacParams.DownlinkDwellTime;
-                    RxWindow2Config.RepeaterSupport = LoRaMacParams.RepeaterSupport;
-                    RxWindow2Config.RxSlot = RX_SLOT_WIN_2;
-                    RxWindow2Config.RxContinuous = true;
+                    RegionComputeRxWindowParameters( Ctx->LoRaMacRegion,
+                                                     Ctx->LoRaMacParams.Rx2Channel.Datarate,
+                                                     Ctx->LoRaMacParams.MinRxSymbols,
+                                                     Ctx->LoRaMacParams.SystemMaxRxError,
+                                                     &Ctx->RxWindow2Config );
+
+                    Ctx->RxWindow2Config.Channel = Ctx->Channel;
+                    Ctx->RxWindow2Config.Frequency = Ctx->LoRaMacParams.Rx2Channel.Frequency;
+                    Ctx->RxWindow2Config.DownlinkDwellTime = Ctx->LoRaMacParams.DownlinkDwellTime;
+                    Ctx->RxWindow2Config.RepeaterSupport = Ctx->LoRaMacParams.RepeaterSupport;
+                    Ctx->RxWindow2Config.RxSlot = RX_SLOT_WIN_2;
+                    Ctx->RxWindow2Config.RxContinuous = true;
 
                     Radio.Sleep();
-                    if ( RegionRxConfig( LoRaMacRegion, &RxWindow2Config, ( int8_t * )&McpsIndication.RxDatarate ) == true ) {
-                        RxWindowSetup( RxWindow2Config.RxContinuous, LoRaMacParams.MaxRxWindow );
-                        RxSlot = RxWindow2Config.RxSlot;
+                    if ( RegionRxConfig( Ctx->LoRaMacRegion, &Ctx->RxWindow2Config, ( int8_t * )&Ctx->McpsIndication.RxDatarate ) == true ) {
+                        RxWindowSetup( Ctx->RxWindow2Config.RxContinuous, Ctx->LoRaMacParams.MaxRxWindow );
+                        Ctx->RxSlot = Ctx->RxWindow2Config.RxSlot;
                     } else {
                         status = LORAMAC_STATUS_PARAMETER_INVALID;
                     }
@@ -2941,10 +3923,10 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
         }
         case MIB_RX2_DEFAULT_CHANNEL: {
             verify.DatarateParams.Datarate = mibSet->Param.Rx2Channel.Datarate;
-            verify.DatarateParams.DownlinkDwellTime = LoRaMacParams.DownlinkDwellTime;
+            verify.DatarateParams.DownlinkDwellTime = Ctx->LoRaMacParams.DownlinkDwellTime;
 
-            if ( RegionVerify( LoRaMacRegion, &verify, PHY_RX_DR ) == true ) {
-                LoRaMacParamsDefaults.Rx2Channel = mibSet->Param.Rx2DefaultChannel;
+            if ( RegionVerify( Ctx->LoRaMacRegion, &verify, PHY_RX_DR ) == true ) {
+                Ctx->LoRaMacParamsDefaults.Rx2Channel = mibSet->Param.Rx2DefaultChannel;
             } else {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
@@ -2954,7 +3936,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
             chanMaskSet.ChannelsMaskIn = mibSet->Param.ChannelsMask;
             chanMaskSet.ChannelsMaskType = CHANNELS_DEFAULT_MASK;
 
-            if ( RegionChanMaskSet( LoRaMacRegion, &chanMaskSet ) == false ) {
+            if ( RegionChanMaskSet( Ctx->LoRaMacRegion, &chanMaskSet ) == false ) {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
             break;
@@ -2963,7 +3945,7 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
             chanMaskSet.ChannelsMaskIn = mibSet->Param.ChannelsMask;
             chanMaskSet.ChannelsMaskType = CHANNELS_MASK;
 
-            if ( RegionChanMaskSet( LoRaMacRegion, &chanMaskSet ) == false ) {
+            if ( RegionChanMaskSet( Ctx->LoRaMacRegion, &chanMaskSet ) == false ) {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
             break;
@@ -2971,37 +3953,37 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
         case MIB_CHANNELS_NB_REP: {
             if ( ( mibSet->Param.ChannelNbRep >= 1 ) &&
                  ( mibSet->Param.ChannelNbRep <= 15 ) ) {
-                LoRaMacParams.ChannelsNbRep = mibSet->Param.ChannelNbRep;
+                Ctx->LoRaMacParams.ChannelsNbRep = mibSet->Param.ChannelNbRep;
             } else {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
             break;
         }
         case MIB_MAX_RX_WINDOW_DURATION: {
-            LoRaMacParams.MaxRxWindow = mibSet->Param.MaxRxWindow;
+            Ctx->LoRaMacParams.MaxRxWindow = mibSet->Param.MaxRxWindow;
             break;
         }
         case MIB_RECEIVE_DELAY_1: {
-            LoRaMacParams.ReceiveDelay1 = mibSet->Param.ReceiveDelay1;
+            Ctx->LoRaMacParams.ReceiveDelay1 = mibSet->Param.ReceiveDelay1;
             break;
         }
         case MIB_RECEIVE_DELAY_2: {
-            LoRaMacParams.ReceiveDelay2 = mibSet->Param.ReceiveDelay2;
+            Ctx->LoRaMacParams.ReceiveDelay2 = mibSet->Param.ReceiveDelay2;
             break;
         }
         case MIB_JOIN_ACCEPT_DELAY_1: {
-            LoRaMacParams.JoinAcceptDelay1 = mibSet->Param.JoinAcceptDelay1;
+            Ctx->LoRaMacParams.JoinAcceptDelay1 = mibSet->Param.JoinAcceptDelay1;
             break;
         }
         case MIB_JOIN_ACCEPT_DELAY_2: {
-            LoRaMacParams.JoinAcceptDelay2 = mibSet->Param.JoinAcceptDelay2;
+            Ctx->LoRaMacParams.JoinAcceptDelay2 = mibSet->Param.JoinAcceptDelay2;
             break;
         }
         case MIB_CHANNELS_DEFAULT_DATARATE: {
             verify.DatarateParams.Datarate = mibSet->Param.ChannelsDefaultDatarate;
 
-            if ( RegionVerify( LoRaMacRegion, &verify, PHY_DEF_TX_DR ) == true ) {
-                LoRaMacParamsDefaults.ChannelsDatarate = verify.DatarateParams.Datarate;
+            if ( RegionVerify( Ctx->LoRaMacRegion, &verify, PHY_DEF_TX_DR ) == true ) {
+                Ctx->LoRaMacParamsDefaults.ChannelsDatarate = verify.DatarateParams.Datarate;
             } else {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
@@ -3010,8 +3992,8 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
         case MIB_CHANNELS_DATARATE: {
             verify.DatarateParams.Datarate = mibSet->Param.ChannelsDatarate;
 
-            if ( RegionVerify( LoRaMacRegion, &verify, PHY_TX_DR ) == true ) {
-                LoRaMacParams.ChannelsDatarate = verify.DatarateParams.Datarate;
+            if ( RegionVerify( Ctx->LoRaMacRegion, &verify, PHY_TX_DR ) == true ) {
+                Ctx->LoRaMacParams.ChannelsDatarate = verify.DatarateParams.Datarate;
             } else {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
@@ -3020,8 +4002,8 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
         case MIB_CHANNELS_DEFAULT_TX_POWER: {
             verify.TxPower = mibSet->Param.ChannelsDefaultTxPower;
 
-            if ( RegionVerify( LoRaMacRegion, &verify, PHY_DEF_TX_POWER ) == true ) {
-                LoRaMacParamsDefaults.ChannelsTxPower = verify.TxPower;
+            if ( RegionVerify( Ctx->LoRaMacRegion, &verify, PHY_DEF_TX_POWER ) == true ) {
+                Ctx->LoRaMacParamsDefaults.ChannelsTxPower = verify.TxPower;
             } else {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
@@ -3030,31 +4012,31 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
         case MIB_CHANNELS_TX_POWER: {
             verify.TxPower = mibSet->Param.ChannelsTxPower;
 
-            if ( RegionVerify( LoRaMacRegion, &verify, PHY_TX_POWER ) == true ) {
-                LoRaMacParams.ChannelsTxPower = verify.TxPower;
+            if ( RegionVerify( Ctx->LoRaMacRegion, &verify, PHY_TX_POWER ) == true ) {
+                Ctx->LoRaMacParams.ChannelsTxPower = verify.TxPower;
             } else {
                 status = LORAMAC_STATUS_PARAMETER_INVALID;
             }
             break;
         }
         case MIB_UPLINK_COUNTER: {
-            UpLinkCounter = mibSet->Param.UpLinkCounter;
+            Ctx->UpLinkCounter = mibSet->Param.UpLinkCounter;
             break;
         }
         case MIB_DOWNLINK_COUNTER: {
-            DownLinkCounter = mibSet->Param.DownLinkCounter;
+            Ctx->DownLinkCounter = mibSet->Param.DownLinkCounter;
             break;
         }
         case MIB_SYSTEM_MAX_RX_ERROR: {
-            LoRaMacParams.SystemMaxRxError = LoRaMacParamsDefaults.SystemMaxRxError = mibSet->Param.SystemMaxRxError;
+            Ctx->LoRaMacParams.SystemMaxRxError = Ctx->LoRaMacParamsDefaults.SystemMaxRxError = mibSet->Param.SystemMaxRxError;
             break;
         }
         case MIB_MIN_RX_SYMBOLS: {
-            LoRaMacParams.MinRxSymbols = LoRaMacParamsDefaults.MinRxSymbols = mibSet->Param.MinRxSymbols;
+            Ctx->LoRaMacParams.MinRxSymbols = Ctx->LoRaMacParamsDefaults.MinRxSymbols = mibSet->Param.MinRxSymbols;
             break;
         }
         case MIB_ANTENNA_GAIN: {
-            LoRaMacParams.AntennaGain = mibSet->Param.AntennaGain;
+            Ctx->LoRaMacParams.AntennaGain = mibSet->Param.AntennaGain;
             break;
         }
         case MIB_MULTICAST_CHANNEL: {
@@ -3065,6 +4047,114 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
             status = LoRaMacMulticastChannelUnlink(mibSet->Param.MulticastList);
             break;
         }
+        case MIB_ADR_STATUS: {
+            memset1( ( uint8_t * )&Ctx->AdrStatus, 0, sizeof( Ctx->AdrStatus ) );
+            break;
+        }
+        case MIB_RX_TIMING_ADAPTIVE: {
+            Ctx->RxTiming.Adaptive = mibSet->Param.RxTimingAdaptive;
+            break;
+        }
+        case MIB_RX_TIMING_TARGET_MISS: {
+            if ( ( mibSet->Param.RxTimingTargetMiss > 0 ) && ( mibSet->Param.RxTimingTargetMiss < 1000 ) ) {
+                Ctx->RxTiming.TargetMissRate = mibSet->Param.RxTimingTargetMiss;
+            } else {
+                status = LORAMAC_STATUS_PARAMETER_INVALID;
+            }
+            break;
+        }
+        case MIB_RX_TIMING_STATUS: {
+            bool adaptive = Ctx->RxTiming.Adaptive;
+            uint16_t targetMissRate = Ctx->RxTiming.TargetMissRate;
+
+            memset1( ( uint8_t * )&Ctx->RxTiming, 0, sizeof( Ctx->RxTiming ) );
+            Ctx->RxTiming.Adaptive = adaptive;
+            Ctx->RxTiming.TargetMissRate = targetMissRate;
+            break;
+        }
+        case MIB_ENERGY_STATUS: {
+            EnergyReset( );
+            break;
+        }
+        case MIB_MAC_STATISTICS: {
+            memset1( ( uint8_t * )&Ctx->Statistics, 0, sizeof( Ctx->Statistics ) );
+            break;
+        }
+        case MIB_LBT_ENABLE: {
+            LoRaMacLbtEnable( mibSet->Param.LbtEnable );
+            break;
+        }
+        case MIB_LBT_MODE: {
+            if ( ( mibSet->Param.LbtMode == LBT_MODE_RSSI ) || ( mibSet->Param.LbtMode == LBT_MODE_CAD ) ) {
+                LoRaMacLbtSetMode( mibSet->Param.LbtMode );
+            } else {
+                status = LORAMAC_STATUS_PARAMETER_INVALID;
+            }
+            break;
+        }
+        case MIB_LBT_STATUS: {
+            LoRaMacLbtResetStatus( );
+            break;
+        }
+        case MIB_RETRY_ADAPTIVE: {
+            Ctx->Retry.Adaptive = mibSet->Param.RetryAdaptive;
+            break;
+        }
+        case MIB_RETRY_DEADLINE: {
+            Ctx->Retry.Deadline = mibSet->Param.RetryDeadline;
+            break;
+        }
+        case MIB_RETRY_STATUS: {
+            bool adaptive = Ctx->Retry.Adaptive;
+            uint32_t deadline = Ctx->Retry.Deadline;
+
+            memset1( ( uint8_t * )&Ctx->Retry, 0, sizeof( Ctx->Retry ) );
+            Ctx->Retry.Adaptive = adaptive;
+            Ctx->Retry.Deadline = deadline;
+            break;
+        }
+        case MIB_LINK_ESTIMATOR: {
+            Ctx->Link.Enabled = mibSet->Param.LinkEstimator;
+            break;
+        }
+        case MIB_LINK_TARGET_PER: {
+            if ( ( mibSet->Param.LinkTargetPer > 0 ) && ( mibSet->Param.LinkTargetPer < 1000 ) ) {
+                Ctx->Link.TargetPer = mibSet->Param.LinkTargetPer;
+            } else {
+                status = LORAMAC_STATUS_PARAMETER_INVALID;
+            }
+            break;
+        }
+        case MIB_LINK_STATUS: {
+            bool enabled = Ctx->Link.Enabled;
+            uint16_t targetPer = Ctx->Link.TargetPer;
+
+            memset1( ( uint8_t * )&Ctx->Link, 0, sizeof( Ctx->Link ) );
+            Ctx->Link.Enabled = enabled;
+            Ctx->Link.TargetPer = targetPer;
+            break;
+        }
+        case MIB_TX_POWER_CONTROL: {
+            Ctx->Power.Enabled = mibSet->Param.TxPowerControl;
+            break;
+        }
+        case MIB_TX_POWER_TARGET_MARGIN: {
+            if ( mibSet->Param.TxPowerTargetMargin > 0 ) {
+                Ctx->Power.TargetMargin = mibSet->Param.TxPowerTargetMargin;
+            } else {
+                status = LORAMAC_STATUS_PARAMETER_INVALID;
+            }
+            break;
+        }
+        case MIB_TX_POWER_STATUS: {
+            bool enabled = Ctx->Power.Enabled;
+            uint8_t targetMargin = Ctx->Power.TargetMargin;
+
+            memset1( ( uint8_t * )&Ctx->Power, 0, sizeof( Ctx->Power ) );
+            Ctx->Power.Enabled = enabled;
+            Ctx->Power.TargetMargin = targetMargin;
+            break;
+        }
         default:
         {
             status = LORAMAC_STATUS_SERVICE_UNKNOWN;
@@ -3075,13 +4165,13 @@ LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
     return status;
 }
 
-LoRaMacStatus_t LoRaMacChannelAdd( uint8_t id, ChannelParams_t params )
+static LoRaMacStatus_t ChannelAdd( uint8_t id, ChannelParams_t params )
 {
     ChannelAddParams_t channelAdd;
 
     // Validate if the MAC is in a correct state
-    if ( ( LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) {
-        if ( ( LoRaMacState & LORAMAC_TX_CONFIG ) != LORAMAC_TX_CONFIG ) {
+    if ( ( Ctx->LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) {
+        if ( ( Ctx->LoRaMacState & LORAMAC_TX_CONFIG ) != LORAMAC_TX_CONFIG ) {
             return LORAMAC_STATUS_BUSY;
         }
     }
@@ -3089,33 +4179,33 @@ LoRaMacStatus_t LoRaMacChannelAdd( uint8_t id, ChannelParams_t params )
     channelAdd.NewChannel = &params;
     channelAdd.ChannelId = id;
 
-    return RegionChannelAdd( LoRaMacRegion, &channelAdd );
+    return RegionChannelAdd( Ctx->LoRaMacRegion, &channelAdd );
 }
 
-LoRaMacStatus_t LoRaMacChannelRemove( uint8_t id )
+static LoRaMacStatus_t ChannelRemove( uint8_t id )
 {
     ChannelRemoveParams_t channelRemove;
 
-    if ( ( LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) {
-        if ( ( LoRaMacState & LORAMAC_TX_CONFIG ) != LORAMAC_TX_CONFIG ) {
+    if ( ( Ctx->LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) {
+        if ( ( Ctx->LoRaMacState & LORAMAC_TX_CONFIG ) != LORAMAC_TX_CONFIG ) {
             return LORAMAC_STATUS_BUSY;
         }
     }
 
     channelRemove.ChannelId = id;
 
-    if ( RegionChannelsRemove( LoRaMacRegion, &channelRemove ) == false ) {
+    if ( RegionChannelsRemove( Ctx->LoRaMacRegion, &channelRemove ) == false ) {
         return LORAMAC_STATUS_PARAMETER_INVALID;
     }
     return LORAMAC_STATUS_OK;
 }
 
-LoRaMacStatus_t LoRaMacMulticastChannelLink( MulticastParams_t *channelParam )
+static LoRaMacStatus_t MulticastChannelLink( MulticastParams_t *channelParam )
 {
     if ( channelParam == NULL ) {
         return LORAMAC_STATUS_PARAMETER_INVALID;
     }
-    if ( ( LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) {
+    if ( ( Ctx->LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) {
         return LORAMAC_STATUS_BUSY;
     }
 
@@ -3124,11 +4214,11 @@ LoRaMacStatus_t LoRaMacMulticastChannelLink( MulticastParams_t *channelParam )
     channelParam->DownLinkCounter = 0;
     channelParam->Next = NULL;
 
-    if ( MulticastChannels == NULL ) {
+    if ( Ctx->MulticastChannels == NULL ) {
         // New node is the fist element
-        MulticastChannels = channelParam;
+        Ctx->MulticastChannels = channelParam;
     } else {
-        MulticastParams_t *cur = MulticastChannels;
+        MulticastParams_t *cur = Ctx->MulticastChannels;
 
         // Search the last node in the list
         while ( cur->Next != NULL ) {
@@ -3141,21 +4231,21 @@ LoRaMacStatus_t LoRaMacMulticastChannelLink( MulticastParams_t *channelParam )
     return LORAMAC_STATUS_OK;
 }
 
-LoRaMacStatus_t LoRaMacMulticastChannelUnlink( MulticastParams_t *channelParam )
+static LoRaMacStatus_t MulticastChannelUnlink( MulticastParams_t *channelParam )
 {
     if ( channelParam == NULL ) {
         return LORAMAC_STATUS_PARAMETER_INVALID;
     }
-    if ( ( LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) {
+    if ( ( Ctx->LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) {
         return LORAMAC_STATUS_BUSY;
     }
 
-    if ( MulticastChannels != NULL ) {
-        if ( MulticastChannels == channelParam ) {
+    if ( Ctx->MulticastChannels != NULL ) {
+        if ( Ctx->MulticastChannels == channelParam ) {
             // First element
-            MulticastChannels = channelParam->Next;
+            Ctx->MulticastChannels = channelParam->Next;
         } else {
-            MulticastParams_t *cur = MulticastChannels;
+            MulticastParams_t *cur = Ctx->MulticastChannels;
 
             // Search the node in the list
             while ( cur->Next && cur->Next != channelParam ) {
@@ -3172,7 +4262,7 @@ LoRaMacStatus_t LoRaMacMulticastChannelUnlink( MulticastParams_t *channelParam )
     return LORAMAC_STATUS_OK;
 }
 
-LoRaMacStatus_t LoRaMacMlmeRequest (MlmeReq_t *mlmeRequest)
+static LoRaMacStatus_t HandleMlmeRequest( MlmeReq_t *mlmeRequest )
 {
   LoRaMacStatus_t status = LORAMAC_STATUS_SERVICE_UNKNOWN;
   LoRaMacHeader_t macHdr;
@@ -3184,7 +4274,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest (MlmeReq_t *mlmeRequest)
 
   if (mlmeRequest == NULL)
     return LORAMAC_STATUS_PARAMETER_INVALID;
-  if (LoRaMacState != LORAMAC_IDLE)
+  if (Ctx->LoRaMacState != LORAMAC_IDLE)
     return LORAMAC_STATUS_BUSY;
   if (LoRaMacConfirmQueueIsFull () == true)
     return LORAMAC_STATUS_BUSY;
@@ -3201,27 +4291,27 @@ LoRaMacStatus_t LoRaMacMlmeRequest (MlmeReq_t *mlmeRequest)
         // Verify the parameter NbTrials for the join procedure
         verify.NbJoinTrials = mlmeRequest->Req.Join.NbTrials;
 
-        if (RegionVerify (LoRaMacRegion, &verify, PHY_NB_JOIN_TRIALS) == false)
+        if (RegionVerify (Ctx->LoRaMacRegion, &verify, PHY_NB_JOIN_TRIALS) == false)
         {
           // Value not supported, get default
           getPhy.Attribute = PHY_DEF_NB_JOIN_TRIALS;
-          phyParam = RegionGetPhyParam (LoRaMacRegion, &getPhy);
+          phyParam = RegionGetPhyParam (Ctx->LoRaMacRegion, &getPhy);
           mlmeRequest->Req.Join.NbTrials = (uint8_t) phyParam.Value;
         }
 
-        LoRaMacFlags.Bits.MlmeReq = 1;
+        Ctx->LoRaMacFlags.Bits.MlmeReq = 1;
         queueElement.Request = mlmeRequest->Type;
 
-        LoRaMacDevEui = mlmeRequest->Req.Join.DevEui;
-        LoRaMacAppEui = mlmeRequest->Req.Join.AppEui;
-        LoRaMacAppKey = mlmeRequest->Req.Join.AppKey;
+        Ctx->LoRaMacDevEui = mlmeRequest->Req.Join.DevEui;
+        Ctx->LoRaMacAppEui = mlmeRequest->Req.Join.AppEui;
+        Ctx->LoRaMacAppKey = mlmeRequest->Req.Join.AppKey;
         queueElement.Status = LORAMAC_EVENT_INFO_STATUS_JOIN_FAIL;
         queueElement.RestrictCommonReadyToHandle = false;
         LoRaMacConfirmQueueAdd (&queueElement);
-        MaxJoinRequestTrials = mlmeRequest->Req.Join.NbTrials;
+        Ctx->MaxJoinRequestTrials = mlmeRequest->Req.Join.NbTrials;
 
         // Reset variable JoinRequestTrials
-        JoinRequestTrials = 0;
+        Ctx->JoinRequestTrials = 0;
 
         // Setup header information
         macHdr.Value = 0;
@@ -3229,8 +4319,8 @@ LoRaMacStatus_t LoRaMacMlmeRequest (MlmeReq_t *mlmeRequest)
 
         ResetMacParameters ();
 
-        altDr.NbTrials = JoinRequestTrials + 1;
-        LoRaMacParams.ChannelsDatarate = RegionAlternateDr (LoRaMacRegion, &altDr);
+        altDr.NbTrials = Ctx->JoinRequestTrials + 1;
+        Ctx->LoRaMacParams.ChannelsDatarate = RegionAlternateDr (Ctx->LoRaMacRegion, &altDr);
         status = Send (&macHdr, 0, NULL, 0);
       }
       break;
@@ -3238,7 +4328,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest (MlmeReq_t *mlmeRequest)
     case MLME_LINK_CHECK:
       {
         // Apply the request
-        LoRaMacFlags.Bits.MlmeReq = 1;
+        Ctx->LoRaMacFlags.Bits.MlmeReq = 1;
         queueElement.Request = mlmeRequest->Type;
         queueElement.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
         queueElement.RestrictCommonReadyToHandle = false;
@@ -3252,7 +4342,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest (MlmeReq_t *mlmeRequest)
     case MLME_TXCW:
       {
         // Apply the request
-        LoRaMacFlags.Bits.MlmeReq = 1;
+        Ctx->LoRaMacFlags.Bits.MlmeReq = 1;
         queueElement.Request = mlmeRequest->Type;
         queueElement.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
         queueElement.RestrictCommonReadyToHandle = false;
@@ -3265,7 +4355,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest (MlmeReq_t *mlmeRequest)
     case MLME_TXCW_1:
       {
         // Apply the request
-        LoRaMacFlags.Bits.MlmeReq = 1;
+        Ctx->LoRaMacFlags.Bits.MlmeReq = 1;
         queueElement.Request = mlmeRequest->Type;
         queueElement.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
         queueElement.RestrictCommonReadyToHandle = false;
@@ -3278,7 +4368,7 @@ LoRaMacStatus_t LoRaMacMlmeRequest (MlmeReq_t *mlmeRequest)
     case MLME_DEVICE_TIME:
       {
         // Apply the request
-        LoRaMacFlags.Bits.MlmeReq = 1;
+        Ctx->LoRaMacFlags.Bits.MlmeReq = 1;
         queueElement.Request = mlmeRequest->Type;
         queueElement.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
         queueElement.RestrictCommonReadyToHandle = false;
@@ -3294,18 +4384,18 @@ LoRaMacStatus_t LoRaMacMlmeRequest (MlmeReq_t *mlmeRequest)
   }
 
   if ( status != LORAMAC_STATUS_OK ) {
-    NodeAckRequested = false;
+    Ctx->NodeAckRequested = false;
     LoRaMacConfirmQueueRemoveLast( );
     if( LoRaMacConfirmQueueGetCnt( ) == 0 )
     {
-      LoRaMacFlags.Bits.MlmeReq = 0;
+      Ctx->LoRaMacFlags.Bits.MlmeReq = 0;
     }
   }
 
   return status;
 }
 
-LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t *mcpsRequest )
+static LoRaMacStatus_t HandleMcpsRequest( McpsReq_t *mcpsRequest )
 {
     GetPhyParams_t getPhy;
     PhyParam_t phyParam;
@@ -3321,22 +4411,22 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t *mcpsRequest )
     if ( mcpsRequest == NULL ) {
         return LORAMAC_STATUS_PARAMETER_INVALID;
     }
-    if ( ( ( LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) ||
-         ( ( LoRaMacState & LORAMAC_TX_DELAYED ) == LORAMAC_TX_DELAYED ) ) {
+    if ( ( ( Ctx->LoRaMacState & LORAMAC_TX_RUNNING ) == LORAMAC_TX_RUNNING ) ||
+         ( ( Ctx->LoRaMacState & LORAMAC_TX_DELAYED ) == LORAMAC_TX_DELAYED ) ) {
         return LORAMAC_STATUS_BUSY;
     }
 
     macHdr.Value = 0;
-    memset1 ( ( uint8_t * ) &McpsConfirm, 0, sizeof( McpsConfirm ) );
-    McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
+    memset1 ( ( uint8_t * ) &Ctx->McpsConfirm, 0, sizeof( Ctx->McpsConfirm ) );
+    Ctx->McpsConfirm.Status = LORAMAC_EVENT_INFO_STATUS_ERROR;
 
     // AckTimeoutRetriesCounter must be reset every time a new request (unconfirmed or confirmed) is performed.
-    AckTimeoutRetriesCounter = 1;
+    Ctx->AckTimeoutRetriesCounter = 1;
 
     switch ( mcpsRequest->Type ) {
         case MCPS_UNCONFIRMED: {
             readyToSend = true;
-            AckTimeoutRetries = 1;
+            Ctx->AckTimeoutRetries = 1;
 
             macHdr.Bits.MType = FRAME_TYPE_DATA_UNCONFIRMED_UP;
             fPort = mcpsRequest->Req.Unconfirmed.fPort;
@@ -3347,7 +4437,8 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t *mcpsRequest )
         }
         case MCPS_CONFIRMED: {
             readyToSend = true;
-            AckTimeoutRetries = mcpsRequest->Req.Confirmed.NbTrials;
+            Ctx->AckTimeoutRetries = mcpsRequest->Req.Confirmed.NbTrials;
+            Ctx->RetryRequestTime = TimerGetCurrentTime( );
 
             macHdr.Bits.MType = FRAME_TYPE_DATA_CONFIRMED_UP;
             fPort = mcpsRequest->Req.Confirmed.fPort;
@@ -3358,7 +4449,7 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t *mcpsRequest )
         }
         case MCPS_PROPRIETARY: {
             readyToSend = true;
-            AckTimeoutRetries = 1;
+            Ctx->AckTimeoutRetries = 1;
 
             macHdr.Bits.MType = FRAME_TYPE_PROPRIETARY;
             fBuffer = mcpsRequest->Req.Proprietary.fBuffer;
@@ -3378,45 +4469,213 @@ LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t *mcpsRequest )
 
     // Get the minimum possible datarate
     getPhy.Attribute = PHY_MIN_TX_DR;
-    getPhy.UplinkDwellTime = LoRaMacParams.UplinkDwellTime;
-    phyParam = RegionGetPhyParam( LoRaMacRegion, &getPhy );
+    getPhy.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
+    phyParam = RegionGetPhyParam( Ctx->LoRaMacRegion, &getPhy );
     // Apply the minimum possible datarate.
     // Some regions have limitations for the minimum datarate.
     datarate = MAX( datarate, phyParam.Value );
 
     if ( readyToSend == true ) {
-        if ( AdrCtrlOn == false ) {
+        if ( Ctx->AdrCtrlOn == false ) {
+            datarate = LinkGetDatarate( datarate, fBufferSize );
             verify.DatarateParams.Datarate = datarate;
-            verify.DatarateParams.UplinkDwellTime = LoRaMacParams.UplinkDwellTime;
+            verify.DatarateParams.UplinkDwellTime = Ctx->LoRaMacParams.UplinkDwellTime;
 
-            if ( RegionVerify( LoRaMacRegion, &verify, PHY_TX_DR ) == true ) {
-                LoRaMacParams.ChannelsDatarate = verify.DatarateParams.Datarate;
+            if ( RegionVerify( Ctx->LoRaMacRegion, &verify, PHY_TX_DR ) == true ) {
+                Ctx->LoRaMacParams.ChannelsDatarate = verify.DatarateParams.Datarate;
             } else {
                 return LORAMAC_STATUS_PARAMETER_INVALID;
             }
         }
 
+        if ( Ctx->Power.Hold > 0 ) {
+            Ctx->Power.Hold--;
+        }
+        LinkScheduleCheck( );
         status = Send( &macHdr, fPort, fBuffer, fBufferSize );
         if ( status == LORAMAC_STATUS_OK ) {
-            McpsConfirm.McpsRequest = mcpsRequest->Type;
-            LoRaMacFlags.Bits.McpsReq = 1;
+            Ctx->McpsConfirm.McpsRequest = mcpsRequest->Type;
+            Ctx->LoRaMacFlags.Bits.McpsReq = 1;
         } else {
-            NodeAckRequested = false;
+            Ctx->NodeAckRequested = false;
+        }
+    }
+
+    return status;
+}
+
+LoRaMacStatus_t LoRaMacCtxInitialization( LoRaMacCtx_t *ctx, LoRaMacPrimitives_t *primitives,
+                                          LoRaMacCallback_t *callbacks, LoRaMacRegion_t region )
+{
+    LoRaMacCtx_t *caller;
+    LoRaMacStatus_t status;
+    uint8_t slot;
+
+    if ( ctx == NULL ) {
+        return LORAMAC_STATUS_PARAMETER_INVALID;
+    }
+    for ( slot = 0; slot < LORAMAC_MAX_CONTEXTS; slot++ ) {
+        if ( ( Contexts[slot] == NULL ) || ( Contexts[slot] == ctx ) ) {
+            break;
         }
     }
+    if ( slot == LORAMAC_MAX_CONTEXTS ) {
+        return LORAMAC_STATUS_BUSY;
+    }
+    Contexts[slot] = ctx;
+
+    caller = BindContext( ctx );
+    status = Initialization( &CtxTimers[LORAMAC_CTX_TIMERS_SLOT( slot )], primitives, callbacks, region );
+    BindContext( caller );
+    return status;
+}
+
+LoRaMacStatus_t LoRaMacCtxQueryTxPossible( LoRaMacCtx_t *ctx, uint8_t size, LoRaMacTxInfo_t *txInfo )
+{
+    LoRaMacCtx_t *caller = BindContext( ctx );
+    LoRaMacStatus_t status = QueryTxPossible( size, txInfo );
+    BindContext( caller );
+    return status;
+}
+
+LoRaMacStatus_t LoRaMacCtxChannelAdd( LoRaMacCtx_t *ctx, uint8_t id, ChannelParams_t params )
+{
+    LoRaMacCtx_t *caller = BindContext( ctx );
+    LoRaMacStatus_t status = ChannelAdd( id, params );
+    BindContext( caller );
+    return status;
+}
+
+LoRaMacStatus_t LoRaMacCtxChannelRemove( LoRaMacCtx_t *ctx, uint8_t id )
+{
+    LoRaMacCtx_t *caller = BindContext( ctx );
+    LoRaMacStatus_t status = ChannelRemove( id );
+    BindContext( caller );
+    return status;
+}
+
+LoRaMacStatus_t LoRaMacCtxMulticastChannelLink( LoRaMacCtx_t *ctx, MulticastParams_t *channelParam )
+{
+    LoRaMacCtx_t *caller = BindContext( ctx );
+    LoRaMacStatus_t status = MulticastChannelLink( channelParam );
+    BindContext( caller );
+    return status;
+}
+
+LoRaMacStatus_t LoRaMacCtxMulticastChannelUnlink( LoRaMacCtx_t *ctx, MulticastParams_t *channelParam )
+{
+    LoRaMacCtx_t *caller = BindContext( ctx );
+    LoRaMacStatus_t status = MulticastChannelUnlink( channelParam );
+    BindContext( caller );
+    return status;
+}
+
+LoRaMacStatus_t LoRaMacCtxMibGetRequestConfirm( LoRaMacCtx_t *ctx, MibRequestConfirm_t *mibGet )
+{
+    LoRaMacCtx_t *caller = BindContext( ctx );
+    LoRaMacStatus_t status = MibGetRequestConfirm( mibGet );
+    BindContext( caller );
+    return status;
+}
+
+LoRaMacStatus_t LoRaMacCtxMibSetRequestConfirm( LoRaMacCtx_t *ctx, MibRequestConfirm_t *mibSet )
+{
+    LoRaMacCtx_t *caller = BindContext( ctx );
+    LoRaMacStatus_t status = MibSetRequestConfirm( mibSet );
+    BindContext( caller );
+    return status;
+}
+
+LoRaMacStatus_t LoRaMacCtxMlmeRequest( LoRaMacCtx_t *ctx, MlmeReq_t *mlmeRequest )
+{
+    LoRaMacCtx_t *caller;
+    LoRaMacStatus_t status;
+
+    if ( IsRadioTaken( ctx ) == true ) {
+        // The radio is busy with another context
+        return LORAMAC_STATUS_BUSY;
+    }
+    caller = BindContext( ctx );
+    status = HandleMlmeRequest( mlmeRequest );
+    BindContext( caller );
+    return status;
+}
 
+LoRaMacStatus_t LoRaMacCtxMcpsRequest( LoRaMacCtx_t *ctx, McpsReq_t *mcpsRequest )
+{
+    LoRaMacCtx_t *caller;
+    LoRaMacStatus_t status;
+
+    if ( IsRadioTaken( ctx ) == true ) {
+        // The radio is busy with another context
+        return LORAMAC_STATUS_BUSY;
+    }
+    caller = BindContext( ctx );
+    status = HandleMcpsRequest( mcpsRequest );
+    BindContext( caller );
     return status;
 }
 
+LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t *primitives, LoRaMacCallback_t *callbacks,
+                                       LoRaMacRegion_t region )
+{
+    return LoRaMacCtxInitialization( &LoRaMacDefaultCtx, primitives, callbacks, region );
+}
+
+LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t *txInfo )
+{
+    return LoRaMacCtxQueryTxPossible( &LoRaMacDefaultCtx, size, txInfo );
+}
+
+LoRaMacStatus_t LoRaMacChannelAdd( uint8_t id, ChannelParams_t params )
+{
+    return LoRaMacCtxChannelAdd( &LoRaMacDefaultCtx, id, params );
+}
+
+LoRaMacStatus_t LoRaMacChannelRemove( uint8_t id )
+{
+    return LoRaMacCtxChannelRemove( &LoRaMacDefaultCtx, id );
+}
+
+LoRaMacStatus_t LoRaMacMulticastChannelLink( MulticastParams_t *channelParam )
+{
+    return LoRaMacCtxMulticastChannelLink( &LoRaMacDefaultCtx, channelParam );
+}
+
+LoRaMacStatus_t LoRaMacMulticastChannelUnlink( MulticastParams_t *channelParam )
+{
+    return LoRaMacCtxMulticastChannelUnlink( &LoRaMacDefaultCtx, channelParam );
+}
+
+LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t *mibGet )
+{
+    return LoRaMacCtxMibGetRequestConfirm( &LoRaMacDefaultCtx, mibGet );
+}
+
+LoRaMacStatus_t LoRaMacMibSetRequestConfirm( MibRequestConfirm_t *mibSet )
+{
+    return LoRaMacCtxMibSetRequestConfirm( &LoRaMacDefaultCtx, mibSet );
+}
+
+LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t *mlmeRequest )
+{
+    return LoRaMacCtxMlmeRequest( &LoRaMacDefaultCtx, mlmeRequest );
+}
+
+LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t *mcpsRequest )
+{
+    return LoRaMacCtxMcpsRequest( &LoRaMacDefaultCtx, mcpsRequest );
+}
+
 void LoRaMacTestRxWindowsOn( bool enable )
 {
-    IsRxWindowsEnabled = enable;
+    LoRaMacDefaultCtx.IsRxWindowsEnabled = enable;
 }
 
 void LoRaMacTestSetMic( uint16_t txPacketCounter )
 {
-    UpLinkCounter = txPacketCounter;
-    IsUpLinkCounterFixed = true;
+    LoRaMacDefaultCtx.UpLinkCounter = txPacketCounter;
+    LoRaMacDefaultCtx.IsUpLinkCounterFixed = true;
 }
 
 void LoRaMacTestSetDutyCycleOn( bool enable )
@@ -3425,22 +4684,22 @@ void LoRaMacTestSetDutyCycleOn( bool enable )
 
     verify.DutyCycle = enable;
 
-    if ( RegionVerify( LoRaMacRegion, &verify, PHY_DUTY_CYCLE ) == true ) {
-        DutyCycleOn = enable;
+    if ( RegionVerify( LoRaMacDefaultCtx.LoRaMacRegion, &verify, PHY_DUTY_CYCLE ) == true ) {
+        LoRaMacDefaultCtx.DutyCycleOn = enable;
     }
 }
 
 void LoRaMacTestSetChannel( uint8_t channel )
 {
-    Channel = channel;
+    LoRaMacDefaultCtx.Channel = channel;
 }
 
 #if 0
 static void SetPublicNetwork( bool enable )
 {
-    PublicNetwork = enable;
+    Ctx->PublicNetwork = enable;
     Radio.SetModem( MODEM_LORA );
-    if ( PublicNetwork == true ) {
+    if ( Ctx->PublicNetwork == true ) {
         // Change LoRa modem SyncWord
         Radio.SetSyncWord( LORA_MAC_PUBLIC_SYNCWORD );
     } else {
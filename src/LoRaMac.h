@@ -55,10 +55,15 @@
 #include "timer.h"
 #include "radio.h"
 #include "debug.h"
+#include "energy.h"
+#include "LoRaMacLbt.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
+/*!
+ * Join state of the default context
+ */
 extern bool IsLoRaMacNetworkJoined;
 /*!
  * Check the Mac layer state every MAC_STATE_CHECK_TIMEOUT in ms
@@ -70,6 +75,52 @@ extern bool IsLoRaMacNetworkJoined;
  */
 #define MAX_ACK_RETRIES                             8
 
+/*!
+ * Number of timing samples of a RX window required before its size is adapted
+ */
+#define RX_TIMING_MIN_SAMPLES                       8
+
+/*!
+ * Default target probability of missing a downlink because of a too narrow
+ * RX window, in per mille
+ */
+#define RX_TIMING_DEFAULT_TARGET_MISS               10
+
+/*!
+ * Variance added to the learned RX window spread on every missed acknowledge,
+ * in ms^2
+ */
+#define RX_TIMING_MISS_VARIANCE                     4.0f
+
+/*!
+ * Acknowledges missed in a row after which the RX windows fall back to
+ * \ref MIB_SYSTEM_MAX_RX_ERROR until enough timing samples are learned again
+ */
+#define RX_TIMING_MAX_MISSES                        4
+
+/*!
+ * Confirmed frames of a datarate after which its retransmission history is
+ * halved, so that the adaptive retransmission policy follows a changing link
+ */
+#define RETRY_HISTORY_LENGTH                        32
+
+/*!
+ * Default target packet error rate of the device side datarate selection,
+ * in per mille
+ */
+#define LINK_DEFAULT_TARGET_PER                     100
+
+/*!
+ * Channels tracked by the link estimator. Channel plans larger than that are
+ * tracked per subband of 8 channels.
+ */
+#define LINK_MAX_CHANNELS                           16
+
+/*!
+ * Default link margin kept by the TX power control, in dB
+ */
+#define POWER_DEFAULT_TARGET_MARGIN                 6
+
 /*!
  * RSSI free threshold [dBm]
  */
@@ -199,6 +250,15 @@ typedef struct sBand {
      * Holds the time where the device is off
      */
     TimerTime_t TimeOff;
+    /*!
+     * Time credits, the time on air times the duty cycle the band can still
+     * spend [ms]. Negative while the band is off.
+     */
+    int32_t TimeCredits;
+    /*!
+     * RTC time of the last time credits update [ms], 0 before the first one
+     */
+    uint64_t LastBandUpdateTime;
 } Band_t;
 
 /*!
@@ -815,6 +875,11 @@ typedef enum eLoRaMacEventInfoStatus {
      * ToDo
      */
     LORAMAC_EVENT_INFO_STATUS_BEACON_NOT_FOUND,
+    /*!
+     * The confirmed uplink could not be acknowledged before its delivery
+     * deadline, see \ref MIB_RETRY_DEADLINE
+     */
+    LORAMAC_EVENT_INFO_STATUS_TX_DEADLINE,
 } LoRaMacEventInfoStatus_t;
 
 /*!
@@ -965,6 +1030,9 @@ typedef struct sMcpsReqConfirmed {
      *
      * Note, that if NbTrials is set to 1 or 2, the MAC will not decrease
      * the datarate, in case the LoRaMAC layer did not receive an acknowledgment
+     *
+     * With \ref MIB_RETRY_ADAPTIVE the datarate of each retransmission is
+     * chosen from the acknowledgement history instead of this table.
      */
     uint8_t NbTrials;
 } McpsReqConfirmed_t;
@@ -1382,6 +1450,371 @@ typedef struct sMlmeIndication
      */
     BeaconInfo_t BeaconInfo;
 }MlmeIndication_t;
+
+/*!
+ * LoRaMAC ADR convergence status
+ *
+ * A backoff episode starts with the first uplink that carries the ADRACKReq
+ * bit and ends with the next valid downlink. The figures of the last
+ * completed episode show how long the node needed to get back in touch with
+ * the network after a path loss change.
+ */
+typedef struct sLoRaMacAdrStatus {
+    /*!
+     * Uplinks sent since the last valid downlink
+     */
+    uint32_t AdrAckCounter;
+    /*!
+     * Set while a backoff episode is running
+     */
+    bool BackoffActive;
+    /*!
+     * Time the running episode started
+     */
+    TimerTime_t EpisodeStartTime;
+    /*!
+     * Uplinks sent during the running episode
+     */
+    uint16_t EpisodeUplinks;
+    /*!
+     * Accumulated time on air of the running episode in ms
+     */
+    TimerTime_t EpisodeAirTime;
+    /*!
+     * Datarate or tx power steps applied by the ADR backoff during the
+     * running episode
+     */
+    uint8_t EpisodeBackoffSteps;
+    /*!
+     * Number of completed episodes
+     */
+    uint32_t EpisodeCount;
+    /*!
+     * Duration of the last completed episode in ms
+     */
+    TimerTime_t LastRecoveryTime;
+    /*!
+     * Time on air spent during the last completed episode in ms
+     */
+    TimerTime_t LastRecoveryAirTime;
+    /*!
+     * Uplinks sent during the last completed episode
+     */
+    uint16_t LastRecoveryUplinks;
+    /*!
+     * Backoff steps applied during the last completed episode
+     */
+    uint8_t LastRecoveryBackoffSteps;
+    /*!
+     * Number of LinkAdrReq commands which were accepted
+     */
+    uint32_t LinkAdrReqCount;
+    /*!
+     * Time the last LinkAdrReq was accepted
+     */
+    TimerTime_t LastLinkAdrReqTime;
+} LoRaMacAdrStatus_t;
+
+/*!
+ * LoRaMAC RX window timing status
+ *
+ * Every downlink received in RX1 or RX2 gives a sample of the offset between
+ * the expected and the measured preamble start. Index 0 holds the RX1
+ * statistics, index 1 the RX2 statistics.
+ */
+typedef struct sLoRaMacRxTimingStatus {
+    /*!
+     * Set to true, if the RX windows are sized from the learned timing error
+     */
+    bool Adaptive;
+    /*!
+     * Target probability of missing a preamble, in per mille
+     */
+    uint16_t TargetMissRate;
+    /*!
+     * Number of timing samples
+     */
+    uint32_t Samples[2];
+    /*!
+     * Acknowledges missed in a row since the last timing sample
+     */
+    uint8_t Misses;
+    /*!
+     * Mean offset of the preamble start in ms. Positive values mean late.
+     */
+    float OffsetMean[2];
+    /*!
+     * Variance of the preamble offset in ms^2
+     */
+    float OffsetVariance[2];
+    /*!
+     * Learned clock error in ppm, derived from the RX1/RX2 offset difference
+     */
+    float ClockErrorPpm;
+    /*!
+     * Learned constant wake up latency in ms
+     */
+    float WakeupLatency;
+    /*!
+     * Timing error currently used to size the windows in ms
+     */
+    uint32_t RxError[2];
+    /*!
+     * Estimated RX time saved compared to \ref MIB_SYSTEM_MAX_RX_ERROR in ms
+     */
+    TimerTime_t RxTimeSaved;
+    /*!
+     * Estimated charge saved in uC (mA x ms)
+     */
+    uint32_t ChargeSaved;
+} LoRaMacRxTimingStatus_t;
+
+/*!
+ * LoRaMAC statistics
+ *
+ * Arrays of two entries hold the RX1 figures at index 0 and the RX2 ( and
+ * class C ) figures at index 1.
+ */
+typedef struct sLoRaMacStatistics {
+    /*!
+     * Completed uplink requests
+     */
+    uint32_t Uplinks;
+    /*!
+     * Frames sent over the air, repetitions and retransmissions included
+     */
+    uint32_t TxFrames;
+    /*!
+     * Retransmissions of confirmed uplinks, NbTrials consumed beyond the first
+     */
+    uint32_t Retransmissions;
+    /*!
+     * Join requests sent
+     */
+    uint32_t JoinRequests;
+    /*!
+     * Acknowledges received
+     */
+    uint32_t AcksReceived[2];
+    /*!
+     * Valid downlinks received
+     */
+    uint32_t Downlinks[2];
+    /*!
+     * Receive windows closed without a frame
+     */
+    uint32_t RxTimeouts[2];
+    /*!
+     * Receive errors
+     */
+    uint32_t RxErrors[2];
+    /*!
+     * Transmissions aborted by the radio timeout
+     */
+    uint32_t TxTimeouts;
+    /*!
+     * Downlinks dropped because of a MIC mismatch
+     */
+    uint32_t MicFailures;
+    /*!
+     * Downlinks with an already received frame counter
+     */
+    uint32_t DuplicateFrames;
+    /*!
+     * Downlink MAC commands processed
+     */
+    uint32_t MacCommands;
+    /*!
+     * MAC command blocks rejected at an unknown or truncated command
+     */
+    uint32_t MacCommandsRejected;
+    /*!
+     * Transmissions delayed by the duty cycle restriction
+     */
+    uint32_t DutyCycleDelays;
+    /*!
+     * Accumulated duty cycle delay in ms
+     */
+    TimerTime_t DutyCycleDelayTime;
+    /*!
+     * Accumulated time on air in ms
+     */
+    TimerTime_t AirTime;
+} LoRaMacStatistics_t;
+
+/*!
+ * LoRaMAC confirmed uplink retransmission status
+ *
+ * The arrays of 16 entries are indexed by the uplink datarate. The attempts
+ * and acknowledges of a datarate are halved when its attempts reach
+ * \ref RETRY_HISTORY_LENGTH. AcksRx holds the acknowledges received in RX1
+ * at index 0 and in RX2 at index 1.
+ */
+typedef struct sLoRaMacRetryStatus {
+    /*!
+     * Set to true, if the retransmissions are chosen from the history
+     */
+    bool Adaptive;
+    /*!
+     * Delivery deadline of the confirmed uplinks in ms from the request,
+     * 0 for none
+     */
+    uint32_t Deadline;
+    /*!
+     * Confirmed frames sent
+     */
+    uint16_t Attempts[16];
+    /*!
+     * Confirmed frames acknowledged
+     */
+    uint16_t Acks[16];
+    /*!
+     * Last time on air of a confirmed frame in ms
+     */
+    uint32_t TimeOnAir[16];
+    /*!
+     * Acknowledges received per RX window
+     */
+    uint16_t AcksRx[2];
+    /*!
+     * Channels the last confirmed frame was not acknowledged on, bit n for
+     * channel n
+     */
+    uint8_t FailedChannels[12];
+    /*!
+     * Confirmed uplinks acknowledged
+     */
+    uint32_t Delivered;
+    /*!
+     * Confirmed uplinks given up
+     */
+    uint32_t Failed;
+    /*!
+     * Confirmed uplinks given up for their deadline
+     */
+    uint32_t DeadlineMisses;
+    /*!
+     * Accumulated time on air of the confirmed frames in ms
+     */
+    TimerTime_t AirTime;
+} LoRaMacRetryStatus_t;
+
+/*!
+ * LoRaMAC link estimator status
+ *
+ * The downlink SNR figures are indexed by the downlink datarate, the margin
+ * figures, from the LinkCheckAns, by the uplink datarate. The margin at a
+ * datarate is its last LinkCheckAns margins moved by the downlink SNR change
+ * since, or extrapolated from the closest datarate with margins.
+ */
+typedef struct sLoRaMacLinkStatus {
+    /*!
+     * Set to true, if the uplink datarate is chosen by the estimator while
+     * ADR is off
+     */
+    bool Enabled;
+    /*!
+     * Target packet error rate of the chosen datarate, in per mille. 0 for
+     * \ref LINK_DEFAULT_TARGET_PER
+     */
+    uint16_t TargetPer;
+    /*!
+     * Downlink SNR samples
+     */
+    uint32_t Samples;
+    /*!
+     * Downlink SNR mean and variance in dB and dB^2
+     */
+    float SnrMean;
+    float SnrVariance;
+    /*!
+     * Downlink SNR samples, mean and variance per datarate
+     */
+    uint16_t DrSamples[16];
+    float DrSnrMean[16];
+    float DrSnrVariance[16];
+    /*!
+     * Downlink SNR samples and mean per channel received in RX1
+     */
+    uint16_t ChannelSamples[LINK_MAX_CHANNELS];
+    float ChannelSnrMean[LINK_MAX_CHANNELS];
+    /*!
+     * LinkCheckAns margin samples, mean and variance per datarate in dB and
+     * dB^2, with the downlink SNR mean they were received at. The margins are
+     * those of the set TX power, see \ref LoRaMacPowerStatus_t
+     */
+    uint16_t MarginSamples[16];
+    float MarginMean[16];
+    float MarginVariance[16];
+    float MarginSnr[16];
+    /*!
+     * Gateways of the last LinkCheckAns
+     */
+    uint8_t NbGateways;
+    /*!
+     * Time of the last downlink or LinkCheckAns
+     */
+    TimerTime_t LastUpdate;
+    /*!
+     * LinkCheckReq added by the estimator
+     */
+    uint32_t LinkChecks;
+    /*!
+     * Uplinks since the last LinkCheckReq added by the estimator
+     */
+    uint16_t UplinksSinceCheck;
+    /*!
+     * Last datarate chosen by the estimator
+     */
+    int8_t Datarate;
+    /*!
+     * Estimated margin and its standard deviation at the current datarate in
+     * dB, updated by \ref MIB_LINK_STATUS
+     */
+    float Margin;
+    float Uncertainty;
+} LoRaMacLinkStatus_t;
+
+/*!
+ * TX power control status
+ *
+ * While ADR is off the uplinks are sent below the power set by the network
+ * or the application, as far as the link estimator margin less its
+ * uncertainty stays above the target margin.
+ */
+typedef struct sLoRaMacPowerStatus {
+    /*!
+     * Set to true, if the TX power is lowered from the link margin while ADR
+     * is off
+     */
+    bool Enabled;
+    /*!
+     * Margin to keep in dB. 0 for \ref POWER_DEFAULT_TARGET_MARGIN
+     */
+    uint8_t TargetMargin;
+    /*!
+     * TX power index steps below the set power of the last uplink
+     */
+    int8_t Backoff;
+    /*!
+     * Uplinks left at the set power after a missed acknowledgement
+     */
+    uint8_t Hold;
+    /*!
+     * Output power of the last uplink in dBm
+     */
+    int8_t TxPower;
+    /*!
+     * Uplinks sent below the set power
+     */
+    uint32_t Uplinks;
+    /*!
+     * Radio energy saved by the last uplink and in total in uJ
+     */
+    uint32_t LastSaving;
+    uint64_t SavedEnergy;
+} LoRaMacPowerStatus_t;
+
 /*!
  * LoRa Mac Information Base (MIB)
  *
@@ -1431,6 +1864,24 @@ typedef struct sMlmeIndication
  * \ref MIB_MAX_BEACON_LESS_PERIOD               | YES | YES
  * \ref MIB_ANTENNA_GAIN                         | YES | YES
  * \ref MIB_DEFAULT_ANTENNA_GAIN                 | YES | YES
+ * \ref MIB_ADR_STATUS                           | YES | YES
+ * \ref MIB_RX_TIMING_ADAPTIVE                   | YES | YES
+ * \ref MIB_RX_TIMING_TARGET_MISS                | YES | YES
+ * \ref MIB_RX_TIMING_STATUS                     | YES | YES
+ * \ref MIB_ENERGY_STATUS                        | YES | YES
+ * \ref MIB_MAC_STATISTICS                       | YES | YES
+ * \ref MIB_LBT_ENABLE                           | YES | YES
+ * \ref MIB_LBT_MODE                             | YES | YES
+ * \ref MIB_LBT_STATUS                           | YES | YES
+ * \ref MIB_RETRY_ADAPTIVE                       | YES | YES
+ * \ref MIB_RETRY_DEADLINE                       | YES | YES
+ * \ref MIB_RETRY_STATUS                         | YES | YES
+ * \ref MIB_LINK_ESTIMATOR                       | YES | YES
+ * \ref MIB_LINK_TARGET_PER                      | YES | YES
+ * \ref MIB_LINK_STATUS                          | YES | YES
+ * \ref MIB_TX_POWER_CONTROL                     | YES | YES
+ * \ref MIB_TX_POWER_TARGET_MARGIN               | YES | YES
+ * \ref MIB_TX_POWER_STATUS                      | YES | YES
  * \ref MIB_FREQ_BAND                | YES | NO
  *
  * The following table provides links to the function implementations of the
@@ -1704,6 +2155,80 @@ typedef enum eMib {
      * The allowed ranges are region specific. Please refer to \ref DR_0 to \ref DR_15 for details.
      */
     MIB_PING_SLOT_DATARATE,
+    /*!
+     * ADR convergence status. Setting this MIB clears the episode history.
+     */
+    MIB_ADR_STATUS,
+    /*!
+     * Size the RX windows from the learned timing error instead of
+     * \ref MIB_SYSTEM_MAX_RX_ERROR
+     */
+    MIB_RX_TIMING_ADAPTIVE,
+    /*!
+     * Target probability of missing a downlink preamble, in per mille
+     */
+    MIB_RX_TIMING_TARGET_MISS,
+    /*!
+     * RX window timing status. Setting this MIB restarts the learning.
+     */
+    MIB_RX_TIMING_STATUS,
+    /*!
+     * Per state energy accounting. Setting this MIB clears the figures.
+     */
+    MIB_ENERGY_STATUS,
+    /*!
+     * MAC statistics. Setting this MIB clears the counters.
+     */
+    MIB_MAC_STATISTICS,
+    /*!
+     * Listen before talk in the regions that do not require it
+     */
+    MIB_LBT_ENABLE,
+    /*!
+     * Listen before talk probing method
+     */
+    MIB_LBT_MODE,
+    /*!
+     * Listen before talk statistics. Setting this MIB clears them.
+     */
+    MIB_LBT_STATUS,
+    /*!
+     * Choose the datarate, spacing and channel of the confirmed uplink
+     * retransmissions from the acknowledgement history
+     */
+    MIB_RETRY_ADAPTIVE,
+    /*!
+     * Delivery deadline of the confirmed uplinks in ms, 0 for none
+     */
+    MIB_RETRY_DEADLINE,
+    /*!
+     * Retransmission history. Setting this MIB clears it.
+     */
+    MIB_RETRY_STATUS,
+    /*!
+     * Choose the uplink datarate from the link estimator while ADR is off
+     */
+    MIB_LINK_ESTIMATOR,
+    /*!
+     * Target packet error rate of the estimator datarate, in per mille
+     */
+    MIB_LINK_TARGET_PER,
+    /*!
+     * Link estimator status. Setting this MIB clears the estimates.
+     */
+    MIB_LINK_STATUS,
+    /*!
+     * Lower the TX power from the link margin while ADR is off
+     */
+    MIB_TX_POWER_CONTROL,
+    /*!
+     * Link margin kept by the TX power control in dB
+     */
+    MIB_TX_POWER_TARGET_MARGIN,
+    /*!
+     * TX power control status. Setting this MIB clears the savings.
+     */
+    MIB_TX_POWER_STATUS,
 
 #ifdef CONFIG_LWAN
     MIB_RX1_DATARATE_OFFSET,
@@ -1985,6 +2510,114 @@ typedef union uMibParam {
      * Related MIB type: \ref MIB_PING_SLOT_DATARATE
      */
     int8_t PingSlotDatarate;
+    /*!
+     * ADR convergence status
+     *
+     * Related MIB type: \ref MIB_ADR_STATUS
+     */
+    LoRaMacAdrStatus_t *AdrStatus;
+    /*!
+     * Adaptive RX window sizing
+     *
+     * Related MIB type: \ref MIB_RX_TIMING_ADAPTIVE
+     */
+    bool RxTimingAdaptive;
+    /*!
+     * RX window target miss probability in per mille
+     *
+     * Related MIB type: \ref MIB_RX_TIMING_TARGET_MISS
+     */
+    uint16_t RxTimingTargetMiss;
+    /*!
+     * RX window timing status
+     *
+     * Related MIB type: \ref MIB_RX_TIMING_STATUS
+     */
+    LoRaMacRxTimingStatus_t *RxTimingStatus;
+    /*!
+     * Energy accounting status
+     *
+     * Related MIB type: \ref MIB_ENERGY_STATUS
+     */
+    EnergyStatus_t *EnergyStatus;
+    /*!
+     * MAC statistics
+     *
+     * Related MIB type: \ref MIB_MAC_STATISTICS
+     */
+    LoRaMacStatistics_t *Statistics;
+    /*!
+     * Listen before talk in all the regions
+     *
+     * Related MIB type: \ref MIB_LBT_ENABLE
+     */
+    bool LbtEnable;
+    /*!
+     * Listen before talk probing method
+     *
+     * Related MIB type: \ref MIB_LBT_MODE
+     */
+    LoRaMacLbtMode_t LbtMode;
+    /*!
+     * Listen before talk statistics
+     *
+     * Related MIB type: \ref MIB_LBT_STATUS
+     */
+    LoRaMacLbtStatus_t *LbtStatus;
+    /*!
+     * Adaptive confirmed uplink retransmissions
+     *
+     * Related MIB type: \ref MIB_RETRY_ADAPTIVE
+     */
+    bool RetryAdaptive;
+    /*!
+     * Confirmed uplink delivery deadline in ms
+     *
+     * Related MIB type: \ref MIB_RETRY_DEADLINE
+     */
+    uint32_t RetryDeadline;
+    /*!
+     * Retransmission status
+     *
+     * Related MIB type: \ref MIB_RETRY_STATUS
+     */
+    LoRaMacRetryStatus_t *RetryStatus;
+    /*!
+     * Device side datarate selection
+     *
+     * Related MIB type: \ref MIB_LINK_ESTIMATOR
+     */
+    bool LinkEstimator;
+    /*!
+     * Target packet error rate in per mille
+     *
+     * Related MIB type: \ref MIB_LINK_TARGET_PER
+     */
+    uint16_t LinkTargetPer;
+    /*!
+     * Link estimator status
+     *
+     * Related MIB type: \ref MIB_LINK_STATUS
+     */
+    LoRaMacLinkStatus_t *LinkStatus;
+    /*!
+     * TX power control
+     *
+     * Related MIB type: \ref MIB_TX_POWER_CONTROL
+     */
+    bool TxPowerControl;
+    /*!
+     * TX power control target margin in dB
+     *
+     * Related MIB type: \ref MIB_TX_POWER_TARGET_MARGIN
+     */
+    uint8_t TxPowerTargetMargin;
+    /*!
+     * TX power control status
+     *
+     * Related MIB type: \ref MIB_TX_POWER_STATUS
+     */
+    LoRaMacPowerStatus_t *TxPowerStatus;
 
 #ifdef CONFIG_LWAN
     uint8_t Rx1DrOffset;
@@ -2457,6 +3090,80 @@ LoRaMacStatus_t LoRaMacMlmeRequest( MlmeReq_t *mlmeRequest );
  */
 LoRaMacStatus_t LoRaMacMcpsRequest( McpsReq_t *mcpsRequest );
 
+/*!
+ * LoRaMac context, see LoRaMacCtx.h. The LoRaMacXxx functions above work on
+ * the default context, LoRaMacCtxXxx ones on the given context.
+ *
+ * Contexts share the radio: a request returns \ref LORAMAC_STATUS_BUSY while
+ * another context has a request running, a wait for its duty cycle
+ * included, and the radio events go to the context that started the
+ * operation. Everything must run from the same task.
+ */
+typedef struct sLoRaMacCtx LoRaMacCtx_t;
+
+/*!
+ * \brief   LoRaMAC layer initialization of a context
+ *
+ * \details Same as \ref LoRaMacInitialization. The context takes one of the
+ *          LORAMAC_MAX_CONTEXTS slots the first time it is initialized.
+ *
+ * \param   [IN] ctx - Context, zero initialized, must stay valid.
+ *
+ * \retval  LoRaMacStatus_t Same as \ref LoRaMacInitialization, and
+ *          \ref LORAMAC_STATUS_BUSY when all the slots are used.
+ */
+LoRaMacStatus_t LoRaMacCtxInitialization( LoRaMacCtx_t *ctx, LoRaMacPrimitives_t *primitives,
+                                          LoRaMacCallback_t *callbacks, LoRaMacRegion_t region );
+
+/*!
+ * \brief   Same as \ref LoRaMacQueryTxPossible, on a context
+ */
+LoRaMacStatus_t LoRaMacCtxQueryTxPossible( LoRaMacCtx_t *ctx, uint8_t size, LoRaMacTxInfo_t *txInfo );
+
+/*!
+ * \brief   Same as \ref LoRaMacChannelAdd, on a context
+ */
+LoRaMacStatus_t LoRaMacCtxChannelAdd( LoRaMacCtx_t *ctx, uint8_t id, ChannelParams_t params );
+
+/*!
+ * \brief   Same as \ref LoRaMacChannelRemove, on a context
+ */
+LoRaMacStatus_t LoRaMacCtxChannelRemove( LoRaMacCtx_t *ctx, uint8_t id );
+
+/*!
+ * \brief   Same as \ref LoRaMacMulticastChannelLink, on a context
+ */
+LoRaMacStatus_t LoRaMacCtxMulticastChannelLink( LoRaMacCtx_t *ctx, MulticastParams_t *channelParam );
+
+/*!
+ * \brief   Same as \ref LoRaMacMulticastChannelUnlink, on a context
+ */
+LoRaMacStatus_t LoRaMacCtxMulticastChannelUnlink( LoRaMacCtx_t *ctx, MulticastParams_t *channelParam );
+
+/*!
+ * \brief   Same as \ref LoRaMacMibGetRequestConfirm, on a context
+ */
+LoRaMacStatus_t LoRaMacCtxMibGetRequestConfirm( LoRaMacCtx_t *ctx, MibRequestConfirm_t *mibGet );
+
+/*!
+ * \brief   Same as \ref LoRaMacMibSetRequestConfirm, on a context
+ */
+LoRaMacStatus_t LoRaMacCtxMibSetRequestConfirm( LoRaMacCtx_t *ctx, MibRequestConfirm_t *mibSet );
+
+/*!
+ * \brief   Same as \ref LoRaMacMlmeRequest, on a context
+ *
+ * \retval  \ref LORAMAC_STATUS_BUSY as well when another context uses the radio
+ */
+LoRaMacStatus_t LoRaMacCtxMlmeRequest( LoRaMacCtx_t *ctx, MlmeReq_t *mlmeRequest );
+
+/*!
+ * \brief   Same as \ref LoRaMacMcpsRequest, on a context
+ *
+ * \retval  \ref LORAMAC_STATUS_BUSY as well when another context uses the radio
+ */
+LoRaMacStatus_t LoRaMacCtxMcpsRequest( LoRaMacCtx_t *ctx, McpsReq_t *mcpsRequest );
+
 extern	void RGB_ON(uint32_t color,uint32_t time);
 extern	void RGB_OFF(void);
 
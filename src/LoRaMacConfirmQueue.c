@@ -25,42 +25,20 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #include "utilities.h"
 #include "LoRaMac.h"
 #include "LoRaMacConfirmQueue.h"
+#include "LoRaMacCtx.h"
 
 
-static LoRaMacPrimitives_t* Primitives;
-
 /*!
- * MlmeConfirm queue data structure
+ * Confirm queue state the functions work on, bound by the MAC
  */
-static MlmeConfirmQueue_t MlmeConfirmQueue[LORA_MAC_MLME_CONFIRM_QUEUE_LEN];
-
-/*!
- * Counts the number of MlmeConfirms to process
- */
-static uint8_t MlmeConfirmQueueCnt;
-
-/*!
- * Pointer to the first element of the ring buffer
- */
-MlmeConfirmQueue_t* BufferStart;
-
-/*!
- * Pointer to the last element of the ring buffer
- */
-MlmeConfirmQueue_t* BufferEnd;
-
-/*!
- * Variable which holds a common status
- */
-LoRaMacEventInfoStatus_t CommonStatus;
-
+static LoRaMacConfirmQueueCtx_t* QueueCtx = &LoRaMacDefaultCtx.ConfirmQueue;
 
 static MlmeConfirmQueue_t* IncreaseBufferPointer( MlmeConfirmQueue_t* bufferPointer )
 {
-    if( bufferPointer == &MlmeConfirmQueue[LORA_MAC_MLME_CONFIRM_QUEUE_LEN - 1] )
+    if( bufferPointer == &QueueCtx->MlmeConfirmQueue[LORA_MAC_MLME_CONFIRM_QUEUE_LEN - 1] )
     {
         // Reset to the first element
-        bufferPointer = MlmeConfirmQueue;
+        bufferPointer = QueueCtx->MlmeConfirmQueue;
     }
     else
     {
@@ -72,10 +50,10 @@ static MlmeConfirmQueue_t* IncreaseBufferPointer( MlmeConfirmQueue_t* bufferPoin
 
 static MlmeConfirmQueue_t* DecreaseBufferPointer( MlmeConfirmQueue_t* bufferPointer )
 {
-    if( bufferPointer == MlmeConfirmQueue )
+    if( bufferPointer == QueueCtx->MlmeConfirmQueue )
     {
         // Reset to the last element
-        bufferPointer = &MlmeConfirmQueue[LORA_MAC_MLME_CONFIRM_QUEUE_LEN - 1];
+        bufferPointer = &QueueCtx->MlmeConfirmQueue[LORA_MAC_MLME_CONFIRM_QUEUE_LEN - 1];
     }
     else
     {
@@ -105,70 +83,75 @@ static MlmeConfirmQueue_t* GetElement( Mlme_t request, MlmeConfirmQueue_t* buffe
 }
 
 
+void LoRaMacConfirmQueueSetContext( LoRaMacConfirmQueueCtx_t* ctx )
+{
+    QueueCtx = ctx;
+}
+
 void LoRaMacConfirmQueueInit( LoRaMacPrimitives_t* primitives )
 {
-    Primitives = primitives;
+    QueueCtx->Primitives = primitives;
 
     // Init counter
-    MlmeConfirmQueueCnt = 0;
+    QueueCtx->MlmeConfirmQueueCnt = 0;
 
     // Init buffer
-    BufferStart = MlmeConfirmQueue;
-    BufferEnd = MlmeConfirmQueue;
+    QueueCtx->BufferStart = QueueCtx->MlmeConfirmQueue;
+    QueueCtx->BufferEnd = QueueCtx->MlmeConfirmQueue;
 
-    memset1( (uint8_t*) MlmeConfirmQueue, 0xFF, sizeof( MlmeConfirmQueue ) );
+    memset1( (uint8_t*) QueueCtx->MlmeConfirmQueue, 0xFF, sizeof( QueueCtx->MlmeConfirmQueue ) );
 
     // Common status
-    CommonStatus = LORAMAC_EVENT_INFO_STATUS_ERROR;
+    QueueCtx->CommonStatus = LORAMAC_EVENT_INFO_STATUS_ERROR;
 }
 
 bool LoRaMacConfirmQueueAdd( MlmeConfirmQueue_t* mlmeConfirm )
 {
-    if( MlmeConfirmQueueCnt >= LORA_MAC_MLME_CONFIRM_QUEUE_LEN )
+    if( QueueCtx->MlmeConfirmQueueCnt >= LORA_MAC_MLME_CONFIRM_QUEUE_LEN )
     {
         // Protect the buffer against overwrites
         return false;
     }
 
     // Add the element to the ring buffer
-    BufferEnd->Request = mlmeConfirm->Request;
-    BufferEnd->Status = mlmeConfirm->Status;
-    BufferEnd->RestrictCommonReadyToHandle = mlmeConfirm->RestrictCommonReadyToHandle;
-    BufferEnd->ReadyToHandle = false;
+    QueueCtx->BufferEnd->Request = mlmeConfirm->Request;
+    QueueCtx->BufferEnd->Status = mlmeConfirm->Status;
+    QueueCtx->BufferEnd->RestrictCommonReadyToHandle = mlmeConfirm->RestrictCommonReadyToHandle;
+    QueueCtx->BufferEnd->ReadyToHandle = false;
     // Increase counter
-    MlmeConfirmQueueCnt++;
+    QueueCtx->MlmeConfirmQueueCnt++;
     // Update end pointer
-    BufferEnd = IncreaseBufferPointer( BufferEnd );
+    QueueCtx->BufferEnd = IncreaseBufferPointer( QueueCtx->BufferEnd );
 
     return true;
 }
 
 bool LoRaMacConfirmQueueRemoveLast( void )
 {
-    if( MlmeConfirmQueueCnt == 0 )
+    if( QueueCtx->MlmeConfirmQueueCnt == 0 )
     {
         return false;
     }
 
     // Increase counter
-    MlmeConfirmQueueCnt--;
+    QueueCtx->MlmeConfirmQueueCnt--;
     // Update start pointer
-    BufferEnd = DecreaseBufferPointer( BufferEnd );
+    QueueCtx->BufferEnd = DecreaseBufferPointer( QueueCtx->BufferEnd );
 
     return true;
 }
 
 bool LoRaMacConfirmQueueRemoveFirst( void )
 {
-    if( MlmeConfirmQueueCnt == 0 )
+    if( QueueCtx->MlmeConfirmQueueCnt == 0 )
     {
         return false;
     }
 
     // Increase counter
-    MlmeConfirmQueueCnt--;
+    QueueCtx->MlmeConfirmQueueCnt--;
     // Update start pointer
-    BufferStart = IncreaseBufferPointer( BufferStart );
+    QueueCtx->BufferStart = IncreaseBufferPointer( QueueCtx->BufferStart );
 
     return true;
 }
@@ -177,9 +160,9 @@ void LoRaMacConfirmQueueSetStatus( LoRaMacEventInfoStatus_t status, Mlme_t reque
 {
     MlmeConfirmQueue_t* element = NULL;
 
-    if( MlmeConfirmQueueCnt > 0 )
+    if( QueueCtx->MlmeConfirmQueueCnt > 0 )
     {
-        element = GetElement( request, BufferStart, BufferEnd );
+        element = GetElement( request, QueueCtx->BufferStart, QueueCtx->BufferEnd );
         if( element != NULL )
         {
             element->Status = status;
@@ -192,9 +175,9 @@ LoRaMacEventInfoStatus_t LoRaMacConfirmQueueGetStatus( Mlme_t request )
 {
     MlmeConfirmQueue_t* element = NULL;
 
-    if( MlmeConfirmQueueCnt > 0 )
+    if( QueueCtx->MlmeConfirmQueueCnt > 0 )
     {
-        element = GetElement( request, BufferStart, BufferEnd );
+        element = GetElement( request, QueueCtx->BufferStart, QueueCtx->BufferEnd );
         if( element != NULL )
         {
             return element->Status;
@@ -205,11 +188,11 @@ LoRaMacEventInfoStatus_t LoRaMacConfirmQueueGetStatus( Mlme_t request )
 
 void LoRaMacConfirmQueueSetStatusCmn( LoRaMacEventInfoStatus_t status )
 {
-    MlmeConfirmQueue_t* element = BufferStart;
+    MlmeConfirmQueue_t* element = QueueCtx->BufferStart;
 
-    CommonStatus = status;
+    QueueCtx->CommonStatus = status;
 
-    if( MlmeConfirmQueueCnt > 0 )
+    if( QueueCtx->MlmeConfirmQueueCnt > 0 )
     {
         do
         {
@@ -221,18 +204,18 @@ void LoRaMacConfirmQueueSetStatusCmn( LoRaMacEventInfoStatus_t status )
                 element->ReadyToHandle = true;
             }
             element = IncreaseBufferPointer( element );
-        }while( element != BufferEnd );
+        }while( element != QueueCtx->BufferEnd );
     }
 }
 
 LoRaMacEventInfoStatus_t LoRaMacConfirmQueueGetStatusCmn( void )
 {
-    return CommonStatus;
+    return QueueCtx->CommonStatus;
 }
 
 bool LoRaMacConfirmQueueIsCmdActive( Mlme_t request )
 {
-    if( GetElement( request, BufferStart, BufferEnd ) != NULL )
+    if( GetElement( request, QueueCtx->BufferStart, QueueCtx->BufferEnd ) != NULL )
     {
         return true;
     }
@@ -241,26 +224,26 @@ bool LoRaMacConfirmQueueIsCmdActive( Mlme_t request )
 
 void LoRaMacConfirmQueueHandleCb( MlmeConfirm_t* mlmeConfirm )
 {
-    uint8_t nbElements = MlmeConfirmQueueCnt;
+    uint8_t nbElements = QueueCtx->MlmeConfirmQueueCnt;
     bool readyToHandle = false;
     MlmeConfirmQueue_t mlmeConfirmToStore;
 
     for( uint8_t i = 0; i < nbElements; i++ )
     {
-        mlmeConfirm->MlmeRequest = BufferStart->Request;
-        mlmeConfirm->Status = BufferStart->Status;
-        readyToHandle = BufferStart->ReadyToHandle;
+        mlmeConfirm->MlmeRequest = QueueCtx->BufferStart->Request;
+        mlmeConfirm->Status = QueueCtx->BufferStart->Status;
+        readyToHandle = QueueCtx->BufferStart->ReadyToHandle;
 
         if( readyToHandle == true )
         {
-            Primitives->MacMlmeConfirm( mlmeConfirm );
+            QueueCtx->Primitives->MacMlmeConfirm( mlmeConfirm );
         }
         else
         {
             // The request is not processed yet. Store the state.
-            mlmeConfirmToStore.Request = BufferStart->Request;
-            mlmeConfirmToStore.Status = BufferStart->Status;
-            mlmeConfirmToStore.RestrictCommonReadyToHandle = BufferStart->RestrictCommonReadyToHandle;
+            mlmeConfirmToStore.Request = QueueCtx->BufferStart->Request;
+            mlmeConfirmToStore.Status = QueueCtx->BufferStart->Status;
+            mlmeConfirmToStore.RestrictCommonReadyToHandle = QueueCtx->BufferStart->RestrictCommonReadyToHandle;
         }
 
         // Increase the pointer afterwards to prevent overwrites
@@ -276,12 +259,12 @@ void LoRaMacConfirmQueueHandleCb( MlmeConfirm_t* mlmeConfirm )
 
 uint8_t LoRaMacConfirmQueueGetCnt( void )
 {
-    return MlmeConfirmQueueCnt;
+    return QueueCtx->MlmeConfirmQueueCnt;
 }
 
 bool LoRaMacConfirmQueueIsFull( void )
 {
-    if( MlmeConfirmQueueCnt >= LORA_MAC_MLME_CONFIRM_QUEUE_LEN )
+    if( QueueCtx->MlmeConfirmQueueCnt >= LORA_MAC_MLME_CONFIRM_QUEUE_LEN )
     {
         return true;
     }
@@ -69,6 +69,44 @@ typedef struct sMlmeConfirmQueue
     bool RestrictCommonReadyToHandle;
 }MlmeConfirmQueue_t;
 
+/*!
+ * MLME confirm queue state of one LoRaMac context
+ */
+typedef struct sLoRaMacConfirmQueueCtx
+{
+    /*!
+     * LoRaMac upper layer event functions
+     */
+    LoRaMacPrimitives_t* Primitives;
+    /*!
+     * MlmeConfirm queue data structure
+     */
+    MlmeConfirmQueue_t MlmeConfirmQueue[LORA_MAC_MLME_CONFIRM_QUEUE_LEN];
+    /*!
+     * Counts the number of MlmeConfirms to process
+     */
+    uint8_t MlmeConfirmQueueCnt;
+    /*!
+     * Pointer to the first element of the ring buffer
+     */
+    MlmeConfirmQueue_t* BufferStart;
+    /*!
+     * Pointer to the last element of the ring buffer
+     */
+    MlmeConfirmQueue_t* BufferEnd;
+    /*!
+     * Variable which holds a common status
+     */
+    LoRaMacEventInfoStatus_t CommonStatus;
+}LoRaMacConfirmQueueCtx_t;
+
+/*!
+ * \brief   Makes the confirm queue functions work on a context
+ *
+ * \param   [IN] ctx - Confirm queue state of a LoRaMac context
+ */
+void LoRaMacConfirmQueueSetContext( LoRaMacConfirmQueueCtx_t* ctx );
+
 /*!
  * \brief   Initializes the confirm queue
  *
@@ -29,6 +29,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #include "cmac.h"
 
 #include "LoRaMacCrypto.h"
+#include "trace.h"
 
 /*!
  * CMAC/AES Message Integrity Code (MIC) Block B0 size
@@ -36,38 +37,9 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #define LORAMAC_MIC_BLOCK_B0_SIZE                   16
 
 /*!
- * MIC field computation initial data
+ * The scratch blocks and the AES and CMAC contexts are locals, the functions
+ * are reentrant and may be used by several LoRaMac contexts.
  */
-static uint8_t MicBlockB0[] = { 0x49, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-                              };
-
-/*!
- * Contains the computed MIC field.
- *
- * \remark Only the 4 first bytes are used
- */
-static uint8_t Mic[16];
-
-/*!
- * Encryption aBlock and sBlock
- */
-static uint8_t aBlock[] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-                          };
-static uint8_t sBlock[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-                            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-                          };
-
-/*!
- * AES computation context variable
- */
-static aes_context AesContext;
-
-/*!
- * CMAC computation context variable
- */
-static AES_CMAC_CTX AesCmacCtx[1];
 
 /*!
  * \brief Computes the LoRaMAC frame MIC field
@@ -82,31 +54,37 @@ static AES_CMAC_CTX AesCmacCtx[1];
  */
 void LoRaMacComputeMic( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t address, uint8_t dir, uint32_t sequenceCounter, uint32_t *mic )
 {
-    MicBlockB0[5] = dir;
+    uint8_t micBlockB0[LORAMAC_MIC_BLOCK_B0_SIZE] = { 0x49 };
+    uint8_t cmac[16];
+    AES_CMAC_CTX cmacCtx[1];
+
+    TRACE( TRACE_EVENT_CRYPTO_START, TRACE_CRYPTO_MIC, size );
+    micBlockB0[5] = dir;
 
-    MicBlockB0[6] = ( address ) & 0xFF;
-    MicBlockB0[7] = ( address >> 8 ) & 0xFF;
-    MicBlockB0[8] = ( address >> 16 ) & 0xFF;
-    MicBlockB0[9] = ( address >> 24 ) & 0xFF;
+    micBlockB0[6] = ( address ) & 0xFF;
+    micBlockB0[7] = ( address >> 8 ) & 0xFF;
+    micBlockB0[8] = ( address >> 16 ) & 0xFF;
+    micBlockB0[9] = ( address >> 24 ) & 0xFF;
 
-    MicBlockB0[10] = ( sequenceCounter ) & 0xFF;
-    MicBlockB0[11] = ( sequenceCounter >> 8 ) & 0xFF;
-    MicBlockB0[12] = ( sequenceCounter >> 16 ) & 0xFF;
-    MicBlockB0[13] = ( sequenceCounter >> 24 ) & 0xFF;
+    micBlockB0[10] = ( sequenceCounter ) & 0xFF;
+    micBlockB0[11] = ( sequenceCounter >> 8 ) & 0xFF;
+    micBlockB0[12] = ( sequenceCounter >> 16 ) & 0xFF;
+    micBlockB0[13] = ( sequenceCounter >> 24 ) & 0xFF;
 
-    MicBlockB0[15] = size & 0xFF;
+    micBlockB0[15] = size & 0xFF;
 
-    AES_CMAC_Init( AesCmacCtx );
+    AES_CMAC_Init( cmacCtx );
 
-    AES_CMAC_SetKey( AesCmacCtx, key );
+    AES_CMAC_SetKey( cmacCtx, key );
 
-    AES_CMAC_Update( AesCmacCtx, MicBlockB0, LORAMAC_MIC_BLOCK_B0_SIZE );
+    AES_CMAC_Update( cmacCtx, micBlockB0, LORAMAC_MIC_BLOCK_B0_SIZE );
 
-    AES_CMAC_Update( AesCmacCtx, buffer, size & 0xFF );
+    AES_CMAC_Update( cmacCtx, buffer, size & 0xFF );
 
-    AES_CMAC_Final( Mic, AesCmacCtx );
+    AES_CMAC_Final( cmac, cmacCtx );
 
-    *mic = ( uint32_t )( ( uint32_t )Mic[3] << 24 | ( uint32_t )Mic[2] << 16 | ( uint32_t )Mic[1] << 8 | ( uint32_t )Mic[0] );
+    *mic = ( uint32_t )( ( uint32_t )cmac[3] << 24 | ( uint32_t )cmac[2] << 16 | ( uint32_t )cmac[1] << 8 | ( uint32_t )cmac[0] );
+    TRACE( TRACE_EVENT_CRYPTO_END, TRACE_CRYPTO_MIC, 0 );
 }
 
 void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t address, uint8_t dir, uint32_t sequenceCounter, uint8_t *encBuffer )
@@ -114,9 +92,13 @@ void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t
     uint16_t i;
     uint8_t bufferIndex = 0;
     uint16_t ctr = 1;
+    uint8_t aBlock[16] = { 0x01 };
+    uint8_t sBlock[16];
+    aes_context aesContext;
 
-    memset1( AesContext.ksch, '\0', 240 );
-    lorawan_aes_set_key( key, 16, &AesContext );
+    TRACE( TRACE_EVENT_CRYPTO_START, TRACE_CRYPTO_PAYLOAD, size );
+    memset1( aesContext.ksch, '\0', 240 );
+    lorawan_aes_set_key( key, 16, &aesContext );
 
     aBlock[5] = dir;
 
@@ -134,7 +116,7 @@ void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t
     {
         aBlock[15] = ( ( ctr ) & 0xFF );
         ctr++;
-        lora_aes_encrypt( aBlock, sBlock, &AesContext );
+        lora_aes_encrypt( aBlock, sBlock, &aesContext );
         for( i = 0; i < 16; i++ )
         {
             encBuffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
@@ -146,12 +128,13 @@ void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t
     if( size > 0 )
     {
         aBlock[15] = ( ( ctr ) & 0xFF );
-        lora_aes_encrypt( aBlock, sBlock, &AesContext );
+        lora_aes_encrypt( aBlock, sBlock, &aesContext );
         for( i = 0; i < size; i++ )
         {
             encBuffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
         }
     }
+    TRACE( TRACE_EVENT_CRYPTO_END, TRACE_CRYPTO_PAYLOAD, 0 );
 }
 
 void LoRaMacPayloadDecrypt( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t address, uint8_t dir, uint32_t sequenceCounter, uint8_t *decBuffer )
@@ -161,48 +144,60 @@ void LoRaMacPayloadDecrypt( const uint8_t *buffer, uint16_t size, const uint8_t
 
 void LoRaMacJoinComputeMic( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t *mic )
 {
-    AES_CMAC_Init( AesCmacCtx );
+    uint8_t cmac[16];
+    AES_CMAC_CTX cmacCtx[1];
 
-    AES_CMAC_SetKey( AesCmacCtx, key );
+    TRACE( TRACE_EVENT_CRYPTO_START, TRACE_CRYPTO_JOIN_MIC, size );
+    AES_CMAC_Init( cmacCtx );
 
-    AES_CMAC_Update( AesCmacCtx, buffer, size & 0xFF );
+    AES_CMAC_SetKey( cmacCtx, key );
 
-    AES_CMAC_Final( Mic, AesCmacCtx );
+    AES_CMAC_Update( cmacCtx, buffer, size & 0xFF );
 
-    *mic = ( uint32_t )( ( uint32_t )Mic[3] << 24 | ( uint32_t )Mic[2] << 16 | ( uint32_t )Mic[1] << 8 | ( uint32_t )Mic[0] );
+    AES_CMAC_Final( cmac, cmacCtx );
+
+    *mic = ( uint32_t )( ( uint32_t )cmac[3] << 24 | ( uint32_t )cmac[2] << 16 | ( uint32_t )cmac[1] << 8 | ( uint32_t )cmac[0] );
+    TRACE( TRACE_EVENT_CRYPTO_END, TRACE_CRYPTO_JOIN_MIC, 0 );
 }
 
 void LoRaMacJoinDecrypt( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint8_t *decBuffer )
 {
-    memset1( AesContext.ksch, '\0', 240 );
-    lorawan_aes_set_key( key, 16, &AesContext );
-    lora_aes_encrypt( buffer, decBuffer, &AesContext );
+    aes_context aesContext;
+
+    TRACE( TRACE_EVENT_CRYPTO_START, TRACE_CRYPTO_JOIN_DECRYPT, size );
+    memset1( aesContext.ksch, '\0', 240 );
+    lorawan_aes_set_key( key, 16, &aesContext );
+    lora_aes_encrypt( buffer, decBuffer, &aesContext );
     // Check if optional CFList is included
     if( size >= 16 )
     {
-        lora_aes_encrypt( buffer + 16, decBuffer + 16, &AesContext );
+        lora_aes_encrypt( buffer + 16, decBuffer + 16, &aesContext );
     }
+    TRACE( TRACE_EVENT_CRYPTO_END, TRACE_CRYPTO_JOIN_DECRYPT, 0 );
 }
 
 void LoRaMacJoinComputeSKeys( const uint8_t *key, const uint8_t *appNonce, uint16_t devNonce, uint8_t *nwkSKey, uint8_t *appSKey )
 {
     uint8_t nonce[16];
     uint8_t *pDevNonce = ( uint8_t * )&devNonce;
+    aes_context aesContext;
 
-    memset1( AesContext.ksch, '\0', 240 );
-    lorawan_aes_set_key( key, 16, &AesContext );
+    TRACE( TRACE_EVENT_CRYPTO_START, TRACE_CRYPTO_SKEYS, 0 );
+    memset1( aesContext.ksch, '\0', 240 );
+    lorawan_aes_set_key( key, 16, &aesContext );
 
     memset1( nonce, 0, sizeof( nonce ) );
     nonce[0] = 0x01;
     memcpy1( nonce + 1, appNonce, 6 );
     memcpy1( nonce + 7, pDevNonce, 2 );
-    lora_aes_encrypt( nonce, nwkSKey, &AesContext );
+    lora_aes_encrypt( nonce, nwkSKey, &aesContext );
 
     memset1( nonce, 0, sizeof( nonce ) );
     nonce[0] = 0x02;
     memcpy1( nonce + 1, appNonce, 6 );
     memcpy1( nonce + 7, pDevNonce, 2 );
-    lora_aes_encrypt( nonce, appSKey, &AesContext );
+    lora_aes_encrypt( nonce, appSKey, &aesContext );
+    TRACE( TRACE_EVENT_CRYPTO_END, TRACE_CRYPTO_SKEYS, 0 );
 }
 
 void LoRaMacBeaconComputePingOffset( uint64_t beaconTime, uint32_t address, uint16_t pingPeriod, uint16_t *pingOffset )
@@ -211,6 +206,7 @@ void LoRaMacBeaconComputePingOffset( uint64_t beaconTime, uint32_t address, uint
     uint8_t buffer[16];
     uint8_t cipher[16];
     uint32_t result = 0;
+    aes_context aesContext;
     /* Refer to chapter 15.2 of the LoRaWAN specification v1.1. The beacon time
      * GPS time in seconds modulo 2^32
      */
@@ -219,7 +215,7 @@ void LoRaMacBeaconComputePingOffset( uint64_t beaconTime, uint32_t address, uint
     memset1( zeroKey, 0, 16 );
     memset1( buffer, 0, 16 );
     memset1( cipher, 0, 16 );
-    memset1( AesContext.ksch, '\0', 240 );
+    memset1( aesContext.ksch, '\0', 240 );
 
     buffer[0] = ( time ) & 0xFF;
     buffer[1] = ( time >> 8 ) & 0xFF;
@@ -231,8 +227,8 @@ void LoRaMacBeaconComputePingOffset( uint64_t beaconTime, uint32_t address, uint
     buffer[6] = ( address >> 16 ) & 0xFF;
     buffer[7] = ( address >> 24 ) & 0xFF;
 
-    lorawan_aes_set_key( zeroKey, 16, &AesContext );
-    lora_aes_encrypt( buffer, cipher, &AesContext );
+    lorawan_aes_set_key( zeroKey, 16, &aesContext );
+    lora_aes_encrypt( buffer, cipher, &aesContext );
 
     result = ( ( ( uint32_t ) cipher[0] ) + ( ( ( uint32_t ) cipher[1] ) * 256 ) );
 
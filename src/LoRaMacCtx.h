@@ -0,0 +1,378 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: LoRaMac context, the whole state of one LoRaWAN device
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __LORAMAC_CTX_H__
+#define __LORAMAC_CTX_H__
+
+#include <sys/time.h>
+#include "timer.h"
+#include "radio.h"
+#include "LoRaMac.h"
+#include "LoRaMacConfirmQueue.h"
+#include "region/Region.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Maximum number of contexts initialized at the same time, the default one
+ * included. Each context needs its own set of timer callbacks, which caps
+ * it at 4, unless the timers carry their context (TIMER_EVENT_CONTEXT, the
+ * host timer list).
+ */
+#ifndef LORAMAC_MAX_CONTEXTS
+#define LORAMAC_MAX_CONTEXTS                        4
+#endif
+
+/*!
+ * Maximum PHY layer payload size
+ */
+#define LORAMAC_PHY_MAXPAYLOAD                      255
+
+/*!
+ * Maximum MAC commands buffer size
+ */
+#define LORA_MAC_COMMAND_MAX_LENGTH                 128
+
+/*!
+ * LoRaMac context. Holds everything the MAC layer, its region and its
+ * MLME confirm queue keep between calls. Must be zero initialized before
+ * its first LoRaMacCtxInitialization, as static storage is.
+ *
+ * \remark The contexts share the radio and are not protected against each
+ *         other: all of them must be used from the same task.
+ */
+struct sLoRaMacCtx
+{
+    /*!
+     * LoRaMac region.
+     */
+    LoRaMacRegion_t LoRaMacRegion;
+    /*!
+     * Device IEEE EUI
+     */
+    uint8_t *LoRaMacDevEui;
+    /*!
+     * Application IEEE EUI
+     */
+    uint8_t *LoRaMacAppEui;
+    /*!
+     * AES encryption/decryption cipher application key
+     */
+    uint8_t *LoRaMacAppKey;
+    /*!
+     * AES encryption/decryption cipher network session key
+     */
+    uint8_t LoRaMacNwkSKey[16];
+    /*!
+     * AES encryption/decryption cipher application session key
+     */
+    uint8_t LoRaMacAppSKey[16];
+    /*!
+     * Device nonce is a random value extracted by issuing a sequence of RSSI
+     * measurements
+     */
+    uint16_t LoRaMacDevNonce;
+    /*!
+     * Network ID ( 3 bytes )
+     */
+    uint32_t LoRaMacNetID;
+    /*!
+     * Mote Address
+     */
+    uint32_t LoRaMacDevAddr;
+    /*!
+     * Multicast channels linked list
+     */
+    MulticastParams_t *MulticastChannels;
+    /*!
+     * Actual device class
+     */
+    DeviceClass_t LoRaMacDeviceClass;
+    /*!
+     * Indicates if the node is connected to a private or public network
+     */
+    bool PublicNetwork;
+    /*!
+     * Buffer containing the data to be sent or received.
+     */
+    uint8_t LoRaMacBuffer[LORAMAC_PHY_MAXPAYLOAD];
+    /*!
+     * Length of packet in LoRaMacBuffer
+     */
+    uint16_t LoRaMacBufferPktLen;
+    /*!
+     * Length of the payload in LoRaMacBuffer
+     */
+    uint8_t LoRaMacTxPayloadLen;
+    /*!
+     * Buffer containing the upper layer data.
+     */
+    uint8_t LoRaMacRxPayload[LORAMAC_PHY_MAXPAYLOAD];
+    /*!
+     * LoRaMAC frame counter. Each time a packet is sent the counter is incremented.
+     * Only the 16 LSB bits are sent
+     */
+    uint32_t UpLinkCounter;
+    /*!
+     * LoRaMAC frame counter. Each time a packet is received the counter is incremented.
+     * Only the 16 LSB bits are received
+     */
+    uint32_t DownLinkCounter;
+    /*!
+     * IsPacketCounterFixed enables the MIC field tests by fixing the
+     * UpLinkCounter value
+     */
+    bool IsUpLinkCounterFixed;
+    /*!
+     * Used for test purposes. Disables the opening of the reception windows.
+     */
+    bool IsRxWindowsEnabled;
+    /*!
+     * Indicates if the MAC layer has already joined a network.
+     */
+    bool NetworkJoined;
+    /*!
+     * LoRaMac ADR control status
+     */
+    bool AdrCtrlOn;
+    /*!
+     * Counts the number of missed ADR acknowledgements
+     */
+    uint32_t AdrAckCounter;
+    /*!
+     * ADR backoff episode tracking
+     */
+    LoRaMacAdrStatus_t AdrStatus;
+    /*!
+     * RX window timing learning. Kept across joins, it describes the hardware.
+     */
+    LoRaMacRxTimingStatus_t RxTiming;
+    /*!
+     * MAC statistics, kept across deep sleep and joins
+     */
+    LoRaMacStatistics_t Statistics;
+    /*!
+     * Confirmed uplink retransmission history, kept across deep sleep and joins
+     */
+    LoRaMacRetryStatus_t Retry;
+    /*!
+     * Time of the confirmed uplink request, for its delivery deadline
+     */
+    TimerTime_t RetryRequestTime;
+    /*!
+     * Link estimator, kept across deep sleep and joins
+     */
+    LoRaMacLinkStatus_t Link;
+    /*!
+     * TX power control, kept across deep sleep and joins
+     */
+    LoRaMacPowerStatus_t Power;
+    /*!
+     * If the node has sent a FRAME_TYPE_DATA_CONFIRMED_UP this variable indicates
+     * if the nodes needs to manage the server acknowledgement.
+     */
+    bool NodeAckRequested;
+    /*!
+     * If the server has sent a FRAME_TYPE_DATA_CONFIRMED_DOWN this variable indicates
+     * if the ACK bit must be set for the next transmission
+     */
+    bool SrvAckRequested;
+    /*!
+     * Indicates if the MAC layer wants to send MAC commands
+     */
+    bool MacCommandsInNextTx;
+    /*!
+     * Contains the current MacCommandsBuffer index
+     */
+    uint8_t MacCommandsBufferIndex;
+    /*!
+     * Contains the current MacCommandsBuffer index for MAC commands to repeat
+     */
+    uint8_t MacCommandsBufferToRepeatIndex;
+    /*!
+     * Buffer containing the MAC layer commands
+     */
+    uint8_t MacCommandsBuffer[LORA_MAC_COMMAND_MAX_LENGTH];
+    /*!
+     * Buffer containing the MAC layer commands which must be repeated
+     */
+    uint8_t MacCommandsBufferToRepeat[LORA_MAC_COMMAND_MAX_LENGTH];
+    /*!
+     * LoRaMac parameters
+     */
+    LoRaMacParams_t LoRaMacParams;
+    /*!
+     * LoRaMac default parameters
+     */
+    LoRaMacParams_t LoRaMacParamsDefaults;
+    /*!
+     * Uplink messages repetitions counter
+     */
+    uint8_t ChannelsNbRepCounter;
+    /*!
+     * Maximum duty cycle
+     * \remark Possibility to shutdown the device.
+     */
+    uint8_t MaxDCycle;
+    /*!
+     * Aggregated duty cycle management
+     */
+    uint16_t AggregatedDCycle;
+    TimerTime_t AggregatedLastTxDoneTime;
+    TimerTime_t AggregatedTimeOff;
+    /*!
+     * Enables/Disables duty cycle management (Test only)
+     */
+    bool DutyCycleOn;
+    /*!
+     * Current channel index
+     */
+    uint8_t Channel;
+    /*!
+     * Current channel index
+     */
+    uint8_t LastTxChannel;
+    /*!
+     * Set to true, if the last uplink was a join request
+     */
+    bool LastTxIsJoinRequest;
+    /*!
+     * Stores the time at LoRaMac initialization.
+     */
+    TimerTime_t LoRaMacInitializationTime;
+    /*!
+     * RTC time of the first join request since the last join, 0 when joined
+     *
+     * \remark Used for the BACKOFF_DC computation, it survives resets.
+     */
+    uint64_t JoinStartTime;
+    /*!
+     * LoRaMac internal state
+     */
+    uint32_t LoRaMacState;
+    /*!
+     * System time at the last Radio.Send
+     */
+    struct timeval TxStartSysTime;
+    /*!
+     * System time at the end of the last uplink
+     */
+    struct timeval LastTxSysTime;
+    /*!
+     * LoRaMac timer used to check the LoRaMacState (runs every second)
+     */
+    TimerEvent_t MacStateCheckTimer;
+    /*!
+     * LoRaMac upper layer event functions
+     */
+    LoRaMacPrimitives_t *LoRaMacPrimitives;
+    /*!
+     * LoRaMac upper layer callback functions
+     */
+    LoRaMacCallback_t *LoRaMacCallbacks;
+    /*!
+     * LoRaMac duty cycle delayed Tx timer
+     */
+    TimerEvent_t TxDelayedTimer;
+    /*!
+     * LoRaMac reception windows timers
+     */
+    TimerEvent_t RxWindowTimer1;
+    TimerEvent_t RxWindowTimer2;
+    /*!
+     * LoRaMac reception windows delay
+     * \remark normal frame: RxWindowXDelay = ReceiveDelayX - RADIO_WAKEUP_TIME
+     *         join frame  : RxWindowXDelay = JoinAcceptDelayX - RADIO_WAKEUP_TIME
+     */
+    uint32_t RxWindow1Delay;
+    uint32_t RxWindow2Delay;
+    /*!
+     * LoRaMac Rx windows configuration
+     */
+    RxConfigParams_t RxWindow1Config;
+    RxConfigParams_t RxWindow2Config;
+    /*!
+     * Acknowledge timeout timer. Used for packet retransmissions.
+     */
+    TimerEvent_t AckTimeoutTimer;
+    /*!
+     * Number of trials to get a frame acknowledged
+     */
+    uint8_t AckTimeoutRetries;
+    /*!
+     * Number of trials to get a frame acknowledged
+     */
+    uint8_t AckTimeoutRetriesCounter;
+    /*!
+     * Indicates if the AckTimeout timer has expired or not
+     */
+    bool AckTimeoutRetry;
+    /*!
+     * Last transmission time on air
+     */
+    TimerTime_t TxTimeOnAir;
+    /*!
+     * Number of trials for the Join Request
+     */
+    uint8_t JoinRequestTrials;
+    /*!
+     * Maximum number of trials for the Join Request
+     */
+    uint8_t MaxJoinRequestTrials;
+    /*!
+     * Structure to hold an MCPS indication data.
+     */
+    McpsIndication_t McpsIndication;
+    /*!
+     * Structure to hold MCPS confirm data.
+     */
+    McpsConfirm_t McpsConfirm;
+    /*!
+     * Structure to hold MLME indication data.
+     */
+    MlmeIndication_t MlmeIndication;
+    /*!
+     * Structure to hold MLME confirm data.
+     */
+    MlmeConfirm_t MlmeConfirm;
+    /*!
+     * Holds the current rx window slot
+     */
+    LoRaMacRxSlot_t RxSlot;
+    /*!
+     * LoRaMac tx/rx operation state
+     */
+    LoRaMacFlags_t LoRaMacFlags;
+    /*!
+     * MLME confirm queue
+     */
+    LoRaMacConfirmQueueCtx_t ConfirmQueue;
+    /*!
+     * Channels, bands and channel masks of the region
+     */
+    RegionCtx_t Region;
+};
+
+/*!
+ * Context used by the LoRaMacXxx API, kept across deep sleep
+ */
+extern LoRaMacCtx_t LoRaMacDefaultCtx;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LORAMAC_CTX_H__
@@ -0,0 +1,340 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: LoRa MAC listen before talk implementation
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis ( Semtech ) and Gregory Cristian ( Semtech )
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "radio.h"
+#include "timer.h"
+#include "utilities.h"
+#include "LoRaMacLbt.h"
+
+/*!
+ * Time given to the receiver to settle before the first RSSI sample [ms]
+ */
+#define LBT_RSSI_SETTLE_TIME                        1
+
+/*!
+ * Interval between RSSI samples [ms]
+ */
+#define LBT_RSSI_SAMPLE_PERIOD                      1
+
+/*!
+ * Time after which a CAD without done interrupt falls back to RSSI [ms]
+ */
+#define LBT_CAD_TIMEOUT                             200
+
+/*!
+ * Backoff unit after a busy scan [ms]
+ */
+#define LBT_BACKOFF_SLOT                            20
+
+/*!
+ * The backoff window doubles after each busy scan, up to
+ * 2^LBT_BACKOFF_MAX_EXP slots
+ */
+#define LBT_BACKOFF_MAX_EXP                         6
+
+/*!
+ * Candidate channel
+ */
+typedef struct sLbtCandidate
+{
+    uint8_t Channel;
+    uint32_t Frequency;
+}LbtCandidate_t;
+
+/*!
+ * Settings, kept across deep sleep like the other MAC parameters
+ */
+RTC_DATA_ATTR static bool LbtEnabled = false;
+RTC_DATA_ATTR static LoRaMacLbtMode_t LbtMode = LBT_MODE_RSSI;
+
+/*!
+ * Statistics and consecutive busy scans
+ */
+RTC_DATA_ATTR static LoRaMacLbtStatus_t LbtStatus;
+RTC_DATA_ATTR static uint8_t BusyScans = 0;
+
+static void ( *LbtCallback )( bool channelFree, uint8_t channel );
+
+static LbtCandidate_t Candidates[LBT_MAX_NB_CANDIDATES];
+static uint8_t NbCandidates = 0;
+static int16_t RssiThreshold = LBT_DEFAULT_RSSI_THRESHOLD;
+static uint32_t CarrierSenseTime = LBT_DEFAULT_CARRIER_SENSE_TIME;
+
+/*!
+ * The region requires the carrier sense, a CAD does not replace it
+ */
+static bool CarrierSenseRequired = false;
+
+/*!
+ * Scan state
+ */
+static bool Running = false;
+static uint8_t ProbeIndex;
+static bool ProbeCad;
+static uint32_t ProbeSamples;
+static int16_t ProbeMaxRssi;
+static TimerTime_t ScanStartTime;
+static TimerEvent_t ProbeTimer;
+
+static void ProbeStart( void );
+
+static void Finish( bool channelFree )
+{
+    uint8_t channel = 0;
+
+    Running = false;
+    Radio.Standby( );
+    LbtStatus.ScanTime += TimerGetElapsedTime( ScanStartTime );
+
+    if( channelFree == true )
+    {
+        channel = Candidates[ProbeIndex].Channel;
+        BusyScans = 0;
+        LbtStatus.Scans++;
+    }
+    else
+    {
+        LbtStatus.ScansBusy++;
+    }
+
+    if( LbtCallback != NULL )
+    {
+        LbtCallback( channelFree, channel );
+    }
+}
+
+static void ProbeDone( bool busy )
+{
+    uint8_t channel = Candidates[ProbeIndex].Channel;
+
+    if( channel < LBT_MAX_NB_CHANNELS )
+    {
+        LbtStatus.Channels[channel].Probes++;
+        if( busy == true )
+        {
+            LbtStatus.Channels[channel].Busy++;
+        }
+        if( ProbeSamples > 0 )
+        {
+            LbtStatus.Channels[channel].LastRssi = ProbeMaxRssi;
+        }
+    }
+
+    if( busy == false )
+    {
+        Finish( true );
+        return;
+    }
+    ProbeIndex++;
+    ProbeStart( );
+}
+
+static void RssiStart( void )
+{
+    ProbeCad = false;
+    Radio.StartCarrierSense( MODEM_LORA, Candidates[ProbeIndex].Frequency );
+    TimerSetValue( &ProbeTimer, LBT_RSSI_SETTLE_TIME );
+    TimerStart( &ProbeTimer );
+}
+
+static void ProbeStart( void )
+{
+    if( ProbeIndex >= NbCandidates )
+    {
+        Finish( false );
+        return;
+    }
+    ProbeSamples = 0;
+    ProbeMaxRssi = INT16_MIN;
+
+    if( LbtMode == LBT_MODE_CAD )
+    {
+        ProbeCad = true;
+        Radio.SetChannel( Candidates[ProbeIndex].Frequency );
+        Radio.StartCad( );
+        TimerSetValue( &ProbeTimer, LBT_CAD_TIMEOUT );
+        TimerStart( &ProbeTimer );
+    }
+    else
+    {
+        RssiStart( );
+    }
+}
+
+static void OnProbeTimerEvent( void )
+{
+    int16_t rssi;
+
+    TimerStop( &ProbeTimer );
+
+    if( Running == false )
+    {
+        return;
+    }
+
+    if( ProbeCad == true )
+    {
+        // No CAD done interrupt, measure the channel instead
+        LbtStatus.CadTimeouts++;
+        RssiStart( );
+        return;
+    }
+
+    rssi = Radio.Rssi( MODEM_LORA );
+    ProbeSamples++;
+    ProbeMaxRssi = MAX( ProbeMaxRssi, rssi );
+
+    if( rssi > RssiThreshold )
+    {
+        ProbeDone( true );
+    }
+    else if( ( ProbeSamples * LBT_RSSI_SAMPLE_PERIOD ) >= CarrierSenseTime )
+    {
+        ProbeDone( false );
+    }
+    else
+    {
+        TimerSetValue( &ProbeTimer, LBT_RSSI_SAMPLE_PERIOD );
+        TimerStart( &ProbeTimer );
+    }
+}
+
+void LoRaMacLbtInit( void ( *callback )( bool channelFree, uint8_t channel ) )
+{
+    LbtCallback = callback;
+    Running = false;
+    NbCandidates = 0;
+    TimerInit( &ProbeTimer, OnProbeTimerEvent );
+}
+
+void LoRaMacLbtEnable( bool enable )
+{
+    LbtEnabled = enable;
+}
+
+bool LoRaMacLbtIsEnabled( void )
+{
+    return LbtEnabled;
+}
+
+void LoRaMacLbtSetMode( LoRaMacLbtMode_t mode )
+{
+    LbtMode = mode;
+}
+
+LoRaMacLbtMode_t LoRaMacLbtGetMode( void )
+{
+    return LbtMode;
+}
+
+void LoRaMacLbtClearCandidates( void )
+{
+    NbCandidates = 0;
+    RssiThreshold = LBT_DEFAULT_RSSI_THRESHOLD;
+    CarrierSenseTime = LBT_DEFAULT_CARRIER_SENSE_TIME;
+    CarrierSenseRequired = false;
+}
+
+void LoRaMacLbtSetCarrierSense( int16_t rssiThreshold, uint32_t carrierSenseTime )
+{
+    RssiThreshold = rssiThreshold;
+    CarrierSenseTime = carrierSenseTime;
+    CarrierSenseRequired = true;
+}
+
+bool LoRaMacLbtAddCandidate( uint8_t channel, uint32_t frequency )
+{
+    if( NbCandidates >= LBT_MAX_NB_CANDIDATES )
+    {
+        return false;
+    }
+    Candidates[NbCandidates].Channel = channel;
+    Candidates[NbCandidates].Frequency = frequency;
+    NbCandidates++;
+    return true;
+}
+
+uint8_t LoRaMacLbtGetNbCandidates( void )
+{
+    return NbCandidates;
+}
+
+void LoRaMacLbtStart( void )
+{
+    Running = true;
+    ProbeIndex = 0;
+    ScanStartTime = TimerGetCurrentTime( );
+    ProbeStart( );
+}
+
+void LoRaMacLbtStop( void )
+{
+    if( Running == false )
+    {
+        return;
+    }
+    TimerStop( &ProbeTimer );
+    Running = false;
+    Radio.Standby( );
+}
+
+bool LoRaMacLbtIsRunning( void )
+{
+    return Running;
+}
+
+void LoRaMacLbtOnCadDone( bool channelActivityDetected )
+{
+    if( ( Running == false ) || ( ProbeCad == false ) )
+    {
+        return;
+    }
+    TimerStop( &ProbeTimer );
+    if( ( channelActivityDetected == false ) && ( CarrierSenseRequired == true ) )
+    {
+        // Free of LoRa preambles, the carrier sense of the region decides
+        RssiStart( );
+        return;
+    }
+    ProbeDone( channelActivityDetected );
+}
+
+TimerTime_t LoRaMacLbtGetBackoff( void )
+{
+    TimerTime_t backoff;
+
+    if( BusyScans < LBT_BACKOFF_MAX_EXP )
+    {
+        BusyScans++;
+    }
+    backoff = ( TimerTime_t )randr( 1, 1 << BusyScans ) * LBT_BACKOFF_SLOT;
+
+    LbtStatus.Backoffs++;
+    LbtStatus.BackoffTime += backoff;
+    return backoff;
+}
+
+LoRaMacLbtStatus_t* LoRaMacLbtGetStatus( void )
+{
+    return &LbtStatus;
+}
+
+void LoRaMacLbtResetStatus( void )
+{
+    memset1( ( uint8_t* )&LbtStatus, 0, sizeof( LbtStatus ) );
+}
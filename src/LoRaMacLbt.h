@@ -0,0 +1,245 @@
+/*!
+ * \file      LoRaMacLbt.h
+ *
+ * \brief     LoRa MAC listen before talk implementation
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \code
+ *                ______                              _
+ *               / _____)             _              | |
+ *              ( (____  _____ ____ _| |_ _____  ____| |__
+ *               \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ *               _____) ) ____| | | || |_| ____( (___| | | |
+ *              (______/|_____)_|_|_| \__)_____)\____)_| |_|
+ *              (C)2013 Semtech
+ *
+ * \endcode
+ *
+ * \author    Miguel Luis ( Semtech )
+ *
+ * \author    Gregory Cristian ( Semtech )
+ *
+ * \defgroup  LORAMACLBT LoRa MAC listen before talk implementation
+ *            The regions requiring listen before talk hand the MAC a list of
+ *            candidate channels. The channels are probed one after the other
+ *            with timer driven RSSI measurements or IRQ driven CAD, and the
+ *            first free one is used. The CPU is never held while probing.
+ * \{
+ */
+#ifndef __LORAMAC_LBT_H__
+#define __LORAMAC_LBT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "timer.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Maximum number of channels probed in a scan
+ */
+#define LBT_MAX_NB_CANDIDATES                       16
+
+/*!
+ * Number of channels with their own statistics, higher channel indexes
+ * are only counted in the totals
+ */
+#define LBT_MAX_NB_CHANNELS                         16
+
+/*!
+ * RSSI threshold used by the regions without their own [dBm]
+ */
+#define LBT_DEFAULT_RSSI_THRESHOLD                  -80
+
+/*!
+ * Carrier sense time used by the regions without their own [ms]
+ */
+#define LBT_DEFAULT_CARRIER_SENSE_TIME              5
+
+/*!
+ * Listen before talk probing method
+ */
+typedef enum eLoRaMacLbtMode
+{
+    /*!
+     * RSSI measured for the carrier sense time, detects any emission
+     */
+    LBT_MODE_RSSI,
+    /*!
+     * Channel activity detection at the uplink spreading factor. Faster,
+     * but only detects LoRa preambles of the same spreading factor. In the
+     * regions requiring listen before talk a channel free of preambles is
+     * then measured for the carrier sense time of the region.
+     */
+    LBT_MODE_CAD,
+}LoRaMacLbtMode_t;
+
+/*!
+ * Per channel listen before talk statistics
+ */
+typedef struct sLoRaMacLbtChannelStatus
+{
+    /*!
+     * Number of probes
+     */
+    uint32_t Probes;
+    /*!
+     * Number of probes that found the channel busy
+     */
+    uint32_t Busy;
+    /*!
+     * Highest RSSI measured by the last RSSI probe [dBm]
+     */
+    int16_t LastRssi;
+}LoRaMacLbtChannelStatus_t;
+
+/*!
+ * Listen before talk statistics
+ */
+typedef struct sLoRaMacLbtStatus
+{
+    /*!
+     * Scans that found a free channel
+     */
+    uint32_t Scans;
+    /*!
+     * Scans that found every candidate busy
+     */
+    uint32_t ScansBusy;
+    /*!
+     * CAD probes that got no CAD done interrupt and fell back to RSSI
+     */
+    uint32_t CadTimeouts;
+    /*!
+     * Time spent probing [ms]
+     */
+    TimerTime_t ScanTime;
+    /*!
+     * Number of backoffs after a busy scan
+     */
+    uint32_t Backoffs;
+    /*!
+     * Accumulated backoff time [ms]
+     */
+    TimerTime_t BackoffTime;
+    /*!
+     * Per channel statistics, indexed by channel
+     */
+    LoRaMacLbtChannelStatus_t Channels[LBT_MAX_NB_CHANNELS];
+}LoRaMacLbtStatus_t;
+
+/*!
+ * \brief Initializes the listen before talk module
+ *
+ * \param [IN] callback Called at the end of a scan with the first free
+ *                      channel, channelFree is false when every candidate
+ *                      was busy
+ */
+void LoRaMacLbtInit( void ( *callback )( bool channelFree, uint8_t channel ) );
+
+/*!
+ * \brief Enables listen before talk in the regions that do not require it
+ *
+ * \param [IN] enable true to enable
+ */
+void LoRaMacLbtEnable( bool enable );
+
+/*!
+ * \brief Checks if listen before talk is enabled for all the regions
+ */
+bool LoRaMacLbtIsEnabled( void );
+
+/*!
+ * \brief Sets the probing method
+ *
+ * \param [IN] mode Probing method
+ */
+void LoRaMacLbtSetMode( LoRaMacLbtMode_t mode );
+
+/*!
+ * \brief Returns the probing method
+ */
+LoRaMacLbtMode_t LoRaMacLbtGetMode( void );
+
+/*!
+ * \brief Clears the candidate list and restores the default carrier sense
+ *        parameters. Called by the MAC before the channel selection.
+ */
+void LoRaMacLbtClearCandidates( void );
+
+/*!
+ * \brief Sets the carrier sense parameters of the region, which then requires
+ *        the RSSI measurement in every probe
+ *
+ * \param [IN] rssiThreshold    RSSI above which a channel is busy [dBm]
+ * \param [IN] carrierSenseTime Time a channel must stay below the threshold [ms]
+ */
+void LoRaMacLbtSetCarrierSense( int16_t rssiThreshold, uint32_t carrierSenseTime );
+
+/*!
+ * \brief Adds a channel to the candidate list, in probing order
+ *
+ * \param [IN] channel   Channel index
+ * \param [IN] frequency Channel frequency [Hz]
+ *
+ * \retval status [true: added, false: list full]
+ */
+bool LoRaMacLbtAddCandidate( uint8_t channel, uint32_t frequency );
+
+/*!
+ * \brief Returns the number of candidates
+ */
+uint8_t LoRaMacLbtGetNbCandidates( void );
+
+/*!
+ * \brief Starts probing the candidates. The radio must be configured for
+ *        the uplink beforehand, CAD uses its modulation.
+ */
+void LoRaMacLbtStart( void );
+
+/*!
+ * \brief Aborts a scan, the callback is not called
+ */
+void LoRaMacLbtStop( void );
+
+/*!
+ * \brief Checks if a scan is running
+ */
+bool LoRaMacLbtIsRunning( void );
+
+/*!
+ * \brief Radio CAD done event handler, forwarded by the MAC
+ *
+ * \param [IN] channelActivityDetected true if a preamble was detected
+ */
+void LoRaMacLbtOnCadDone( bool channelActivityDetected );
+
+/*!
+ * \brief Returns the backoff before the next channel selection after a
+ *        busy scan. The backoff is random and grows with the number of
+ *        consecutive busy scans.
+ *
+ * \retval backoff Backoff time [ms]
+ */
+TimerTime_t LoRaMacLbtGetBackoff( void );
+
+/*!
+ * \brief Returns the statistics
+ */
+LoRaMacLbtStatus_t* LoRaMacLbtGetStatus( void );
+
+/*!
+ * \brief Clears the statistics
+ */
+void LoRaMacLbtResetStatus( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+/*! \} defgroup LORAMACLBT */
+
+#endif // __LORAMAC_LBT_H__
@@ -33,12 +33,87 @@
 #ifndef __BOARD_CONFIG_H__
 #define __BOARD_CONFIG_H__
 
+#if defined( RADIO_SX126X )
+/*!
+ * Defines the time required for the TCXO to wakeup [ms].
+ */
+#define BOARD_TCXO_WAKEUP_TIME                      5
+
+/*!
+ * Board current profile used by the energy accounting [uA].
+ *
+ * Typical figures of the SX1262 datasheet, DC-DC regulator, and the ESP32
+ * running at 80 MHz with the WiFi and BT radios off.
+ */
+#define BOARD_SUPPLY_VOLTAGE                        3300    // [mV]
+#define BOARD_MCU_ACTIVE_CURRENT                    30000
+#define BOARD_MCU_SLEEP_CURRENT                     800
+#define BOARD_RADIO_SLEEP_CURRENT                   1
+#define BOARD_RADIO_STANDBY_CURRENT                 600
+#define BOARD_RADIO_RX_CURRENT                      4600
+#define BOARD_RADIO_CAD_CURRENT                     4600
+
+/*!
+ * Radio TX current per output power, high power PA with the datasheet optimal
+ * duty cycle and size of the smallest of the 14, 17, 20 and 22 dBm settings
+ * covering the power [uA]
+ */
+#define BOARD_RADIO_TX_POWER_MIN                    2
+#define BOARD_RADIO_TX_POWER_MAX                    22
+#define BOARD_RADIO_TX_CURRENT                      { 32000, 34000, 36000, 38000, 40000, 42000, 44000, 47000, \
+                                                      50000, 54000, 58000, 62000, 67000, 72000, 78000, 84000, \
+                                                      90000, 97000, 104000, 111000, 118000 }
+
+/*!
+ * Board MCU pins definitions, Heltec LoRa 32 V3 (ESP32-S3 + SX1262)
+ */
+#define RADIO_NSS                                   8
+#define RADIO_SCLK                                  9
+#define RADIO_MOSI                                  10
+#define RADIO_MISO                                  11
+#define RADIO_RESET                                 12
+#define RADIO_BUSY                                  13
+#define RADIO_DIO_1                                 14
+
+/*!
+ * Pins set as inputs before deep sleep
+ */
+#define BOARD_LPM_INPUT_PINS                        { RADIO_NSS, RADIO_SCLK, RADIO_MOSI, RADIO_MISO, \
+                                                      RADIO_RESET, RADIO_BUSY, RADIO_DIO_1 }
+
+#else
 /*!
  * Defines the time required for the TCXO to wakeup [ms].
  */
 
 #define BOARD_TCXO_WAKEUP_TIME                      0
 
+/*!
+ * Board current profile used by the energy accounting [uA].
+ *
+ * Typical figures of the SX1276 datasheet and the ESP32 running at 80 MHz
+ * with the WiFi and BT radios off. Measure the actual board when the
+ * absolute values matter.
+ */
+#define BOARD_SUPPLY_VOLTAGE                        3300    // [mV]
+#define BOARD_MCU_ACTIVE_CURRENT                    30000
+#define BOARD_MCU_SLEEP_CURRENT                     800
+#define BOARD_RADIO_SLEEP_CURRENT                   1
+#define BOARD_RADIO_STANDBY_CURRENT                 1600
+#define BOARD_RADIO_RX_CURRENT                      11500
+#define BOARD_RADIO_CAD_CURRENT                     11500
+
+/*!
+ * Radio TX current per output power, PA_BOOST [uA]. The +20 dBm DAC is only
+ * enabled from BOARD_RADIO_PA_HIGH_POWER_MIN, it wastes current below. The
+ * RFO output is not wired on the Heltec boards.
+ */
+#define BOARD_RADIO_PA_HIGH_POWER_MIN               18
+#define BOARD_RADIO_TX_POWER_MIN                    2
+#define BOARD_RADIO_TX_POWER_MAX                    20
+#define BOARD_RADIO_TX_CURRENT                      { 24000, 25000, 26000, 28000, 30000, 32000, 34000, 37000, \
+                                                      40000, 44000, 48000, 53000, 59000, 66000, 76000, 87000, \
+                                                      102000, 111000, 120000 }
 
 /*!
  * Board MCU pins definitions
@@ -59,6 +134,13 @@
 	#define RADIO_DIO_1    33   // GPIO33 -- SX127x's IRQ(Interrupt Request) V1
 #endif
 
+/*!
+ * Pins set as inputs before deep sleep, the radio and the OLED ones
+ */
+#define BOARD_LPM_INPUT_PINS                        { 4, 5, 14, 15, 16, 17, 18, 19, 26, 27 }
+
+#endif
+
 //#define Vext  21
 
 
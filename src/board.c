@@ -34,39 +34,16 @@ static void BoardUnusedIoInit (void);
  */
 static void SystemClockConfig (void);
 
-/*!
- * Used to measure and calibrate the system wake-up time from STOP mode
- */
-static void CalibrateSystemWakeupTime (void);
-
 /*!
  * System Clock Re-Configuration when waking up from STOP mode
  */
 static void SystemClockReConfig (void);
 
-/*!
- * Timer used at first boot to calibrate the SystemWakeupTime
- */
-static TimerEvent_t CalibrateSystemWakeupTimeTimer;
-
 /*!
  * Flag to indicate if the MCU is Initialized
  */
 static bool McuInitialized = false;
 
-/*!
- * Flag to indicate if the SystemWakeupTime is Calibrated
- */
-static bool SystemWakeupTimeCalibrated = false;
-
-/*!
- * Callback indicating the end of the system wake-up time calibration
- */
-static void OnCalibrateSystemWakeupTimeTimerEvent (void)
-{
-  SystemWakeupTimeCalibrated = true;
-}
-
 /*!
  * Nested interrupt counter.
  *
@@ -168,19 +145,6 @@ void SystemClockConfig (void)
 {
 }
 
-void CalibrateSystemWakeupTime (void)
-{
-  if (SystemWakeupTimeCalibrated == false)
-  {
-    TimerInit (&CalibrateSystemWakeupTimeTimer, OnCalibrateSystemWakeupTimeTimerEvent);
-    TimerSetValue (&CalibrateSystemWakeupTimeTimer, 1000);
-    TimerStart (&CalibrateSystemWakeupTimeTimer);
-
-    while (SystemWakeupTimeCalibrated == false)
-      TimerLowPowerHandler ();
-  }
-}
-
 void SystemClockReConfig (void)
 {
 }
@@ -0,0 +1,204 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Per state energy accounting of the MCU and the radio
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include "utilities.h"
+#include "energy.h"
+
+/*!
+ * Radio TX current per output power [uA]
+ */
+static const uint32_t TxCurrent[ENERGY_TX_POWER_LEVELS] = BOARD_RADIO_TX_CURRENT;
+
+/*!
+ * Accumulated figures. Kept in RTC memory so that deep sleep cycles add up.
+ */
+RTC_DATA_ATTR static EnergyStatus_t EnergyStatus;
+
+/*!
+ * Current MCU state and the time it was entered
+ */
+RTC_DATA_ATTR static EnergyState_t McuState = ENERGY_STATE_MCU_ACTIVE;
+RTC_DATA_ATTR static TimerTime_t McuStateTime = 0;
+
+/*!
+ * Current radio state and the time it was entered
+ */
+RTC_DATA_ATTR static EnergyState_t RadioState = ENERGY_STATE_RADIO_SLEEP;
+RTC_DATA_ATTR static TimerTime_t RadioStateTime = 0;
+
+/*!
+ * Index of the current output power in TxCurrent
+ */
+RTC_DATA_ATTR static uint8_t TxPowerIndex = ENERGY_TX_POWER_LEVELS - 1;
+
+/*!
+ * Set while an uplink is accounted, with the total charge at its start
+ */
+RTC_DATA_ATTR static bool UplinkRunning = false;
+RTC_DATA_ATTR static uint64_t UplinkStartCharge;
+
+static uint32_t GetCurrent( EnergyState_t state )
+{
+    switch( state )
+    {
+    case ENERGY_STATE_MCU_ACTIVE:
+        return BOARD_MCU_ACTIVE_CURRENT;
+    case ENERGY_STATE_MCU_SLEEP:
+        return BOARD_MCU_SLEEP_CURRENT;
+    case ENERGY_STATE_RADIO_SLEEP:
+        return BOARD_RADIO_SLEEP_CURRENT;
+    case ENERGY_STATE_RADIO_STANDBY:
+        return BOARD_RADIO_STANDBY_CURRENT;
+    case ENERGY_STATE_RADIO_RX:
+        return BOARD_RADIO_RX_CURRENT;
+    case ENERGY_STATE_RADIO_TX:
+        return TxCurrent[TxPowerIndex];
+    case ENERGY_STATE_RADIO_CAD:
+        return BOARD_RADIO_CAD_CURRENT;
+    default:
+        return 0;
+    }
+}
+
+/*!
+ * \brief Accounts the time spent in a state up to now
+ *
+ * \param [IN] state     Accounted state
+ * \param [IN|OUT] since Time the state was entered, updated to now
+ */
+static void Accumulate( EnergyState_t state, TimerTime_t *since )
+{
+    TimerTime_t now = TimerGetCurrentTime( );
+    TimerTime_t elapsed = now - *since;
+
+    *since = now;
+    if( state >= ENERGY_STATE_MAX )
+    {
+        return;
+    }
+    EnergyStatus.Time[state] += elapsed;
+    EnergyStatus.Charge[state] += ( uint64_t )elapsed * GetCurrent( state );
+    if( state == ENERGY_STATE_RADIO_TX )
+    {
+        EnergyStatus.TxTime[TxPowerIndex] += elapsed;
+    }
+}
+
+static uint64_t GetTotalCharge( void )
+{
+    uint64_t charge = 0;
+
+    for( uint8_t i = 0; i < ENERGY_STATE_MAX; i++ )
+    {
+        charge += EnergyStatus.Charge[i];
+    }
+    return charge;
+}
+
+void EnergySetRadioState( EnergyState_t state )
+{
+    if( state == RadioState )
+    {
+        return;
+    }
+    Accumulate( RadioState, &RadioStateTime );
+    RadioState = state;
+}
+
+void EnergySetMcuSleep( bool sleep )
+{
+    EnergyState_t state = ( sleep == true ) ? ENERGY_STATE_MCU_SLEEP : ENERGY_STATE_MCU_ACTIVE;
+
+    if( state == McuState )
+    {
+        return;
+    }
+    Accumulate( McuState, &McuStateTime );
+    McuState = state;
+}
+
+void EnergySetTxPower( int8_t power )
+{
+    power = MAX( power, BOARD_RADIO_TX_POWER_MIN );
+    power = MIN( power, BOARD_RADIO_TX_POWER_MAX );
+
+    if( RadioState == ENERGY_STATE_RADIO_TX )
+    {
+        Accumulate( RadioState, &RadioStateTime );
+    }
+    TxPowerIndex = power - BOARD_RADIO_TX_POWER_MIN;
+}
+
+uint32_t EnergyGetTxCurrent( int8_t power )
+{
+    power = MAX( power, BOARD_RADIO_TX_POWER_MIN );
+    power = MIN( power, BOARD_RADIO_TX_POWER_MAX );
+
+    return TxCurrent[power - BOARD_RADIO_TX_POWER_MIN];
+}
+
+void EnergyUplinkStart( void )
+{
+    if( UplinkRunning == true )
+    {
+        return;
+    }
+    Accumulate( McuState, &McuStateTime );
+    Accumulate( RadioState, &RadioStateTime );
+    UplinkStartCharge = GetTotalCharge( );
+    UplinkRunning = true;
+}
+
+void EnergyUplinkDone( uint8_t sentBytes, bool acknowledged )
+{
+    if( UplinkRunning == false )
+    {
+        return;
+    }
+    Accumulate( McuState, &McuStateTime );
+    Accumulate( RadioState, &RadioStateTime );
+    EnergyStatus.UplinkEnergy = ( ( GetTotalCharge( ) - UplinkStartCharge ) * BOARD_SUPPLY_VOLTAGE ) / 1000000;
+    EnergyStatus.Uplinks++;
+    EnergyStatus.SentBytes += sentBytes;
+    if( acknowledged == true )
+    {
+        EnergyStatus.DeliveredBytes += sentBytes;
+    }
+    UplinkRunning = false;
+}
+
+EnergyStatus_t* EnergyGetStatus( void )
+{
+    Accumulate( McuState, &McuStateTime );
+    Accumulate( RadioState, &RadioStateTime );
+
+    // nC x mV = pJ
+    EnergyStatus.TotalEnergy = ( GetTotalCharge( ) * BOARD_SUPPLY_VOLTAGE ) / 1000000;
+    if( EnergyStatus.DeliveredBytes != 0 )
+    {
+        EnergyStatus.EnergyPerByte = EnergyStatus.TotalEnergy / EnergyStatus.DeliveredBytes;
+    }
+    if( EnergyStatus.SentBytes != 0 )
+    {
+        EnergyStatus.EnergyPerSentByte = EnergyStatus.TotalEnergy / EnergyStatus.SentBytes;
+    }
+    return &EnergyStatus;
+}
+
+void EnergyReset( void )
+{
+    memset1( ( uint8_t* )&EnergyStatus, 0, sizeof( EnergyStatus ) );
+    McuStateTime = RadioStateTime = TimerGetCurrentTime( );
+    UplinkRunning = false;
+}
@@ -0,0 +1,161 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Per state energy accounting of the MCU and the radio
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __ENERGY_H__
+#define __ENERGY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "timer.h"
+#include "board-config.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Number of accounted output power levels
+ */
+#define ENERGY_TX_POWER_LEVELS                      ( BOARD_RADIO_TX_POWER_MAX - BOARD_RADIO_TX_POWER_MIN + 1 )
+
+/*!
+ * Accounted states. The MCU and the radio states are tracked independently,
+ * the board consumption is the sum of both.
+ */
+typedef enum eEnergyState
+{
+    ENERGY_STATE_MCU_ACTIVE = 0,
+    ENERGY_STATE_MCU_SLEEP,
+    ENERGY_STATE_RADIO_SLEEP,
+    ENERGY_STATE_RADIO_STANDBY,
+    ENERGY_STATE_RADIO_RX,
+    ENERGY_STATE_RADIO_TX,
+    ENERGY_STATE_RADIO_CAD,
+    ENERGY_STATE_MAX
+}EnergyState_t;
+
+/*!
+ * Energy accounting status
+ */
+typedef struct sEnergyStatus
+{
+    /*!
+     * Time spent in each state [ms]
+     */
+    TimerTime_t Time[ENERGY_STATE_MAX];
+    /*!
+     * Charge drawn in each state [nC] ( uA x ms )
+     */
+    uint64_t Charge[ENERGY_STATE_MAX];
+    /*!
+     * Time spent transmitting at each output power, index 0 is
+     * BOARD_RADIO_TX_POWER_MIN [ms]
+     */
+    TimerTime_t TxTime[ENERGY_TX_POWER_LEVELS];
+    /*!
+     * Energy drawn since the last reset [uJ]
+     */
+    uint64_t TotalEnergy;
+    /*!
+     * Energy drawn by the last completed uplink, retransmissions and
+     * receive windows included [uJ]
+     */
+    uint32_t UplinkEnergy;
+    /*!
+     * Number of completed uplinks
+     */
+    uint32_t Uplinks;
+    /*!
+     * Application payload bytes of the uplinks sent, unconfirmed ones and
+     * confirmed ones without acknowledge included
+     */
+    uint32_t SentBytes;
+    /*!
+     * Application payload bytes the network acknowledged, the only ones
+     * known to be delivered
+     */
+    uint32_t DeliveredBytes;
+    /*!
+     * Total energy divided by the delivered bytes, 0 until an uplink is
+     * acknowledged [uJ/byte]
+     */
+    uint32_t EnergyPerByte;
+    /*!
+     * Total energy divided by the sent bytes [uJ/byte]
+     */
+    uint32_t EnergyPerSentByte;
+}EnergyStatus_t;
+
+/*!
+ * \brief Changes the accounted radio state
+ *
+ * \param [IN] state One of the ENERGY_STATE_RADIO_XXX states
+ */
+void EnergySetRadioState( EnergyState_t state );
+
+/*!
+ * \brief Changes the accounted MCU state
+ *
+ * \param [IN] sleep true when the MCU enters sleep, false when it wakes up
+ */
+void EnergySetMcuSleep( bool sleep );
+
+/*!
+ * \brief Sets the output power used for the following transmissions
+ *
+ * \param [IN] power RF output power [dBm]
+ */
+void EnergySetTxPower( int8_t power );
+
+/*!
+ * \brief Returns the radio TX current of the board at an output power
+ *
+ * \param [IN] power RF output power [dBm]
+ *
+ * \retval current TX current [uA]
+ */
+uint32_t EnergyGetTxCurrent( int8_t power );
+
+/*!
+ * \brief Marks the start of an uplink. Retransmissions of the same uplink
+ *        are ignored until \ref EnergyUplinkDone is called.
+ */
+void EnergyUplinkStart( void );
+
+/*!
+ * \brief Marks the end of an uplink
+ *
+ * \param [IN] sentBytes    Application payload bytes sent, 0 when the uplink
+ *                          failed
+ * \param [IN] acknowledged The network acknowledged the uplink
+ */
+void EnergyUplinkDone( uint8_t sentBytes, bool acknowledged );
+
+/*!
+ * \brief Brings the status up to date and returns it
+ *
+ * \retval status Pointer to the energy accounting status
+ */
+EnergyStatus_t* EnergyGetStatus( void );
+
+/*!
+ * \brief Clears the accumulated figures, the current states are kept
+ */
+void EnergyReset( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ENERGY_H__
@@ -62,5 +62,5 @@ void GpioMcuToggle( Gpio_t *obj )
 
 uint32_t GpioMcuRead( Gpio_t *obj )
 {
-	return 0;
+	return digitalRead(obj->pin);
 }
@@ -25,6 +25,10 @@
 
 #include "gpio.h"
 
+#ifdef __cplusplus
+extern "C"{
+#endif
+
 /*!
  * SPI peripheral ID
  */
@@ -97,4 +101,8 @@ void SpiFrequency( Spi_t *obj, uint32_t hz );
  */
 uint16_t SpiInOut( Spi_t *obj, uint16_t outData );
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // __SPI_H__
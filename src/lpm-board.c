@@ -0,0 +1,384 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Low power modes management of the ESP32
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <math.h>
+#include "esp_sleep.h"
+#include "esp_clk.h"
+#include "driver/gpio.h"
+#include "utilities.h"
+#include "board-config.h"
+#include "rtc-board.h"
+#include "radio.h"
+#include "energy.h"
+#include "rtc-drift.h"
+#include "lpm-board.h"
+
+/*!
+ * Radio DIO edge flags, processed by Radio.IrqProcess
+ */
+extern bool Irq0Fired;
+extern bool Irq1Fired;
+
+/*!
+ * Light sleep wake-up latency samples after which the average becomes exponential
+ */
+#define LPM_LATENCY_MIN_SAMPLES                     8
+
+/*!
+ * Seed of the RTC time check
+ */
+#define LPM_RTC_TIME_CHECK                          0x5254432054494D45ULL
+
+/*!
+ * Pins left floating in deep sleep
+ */
+static const uint8_t DeepSleepInputPins[] = BOARD_LPM_INPUT_PINS;
+
+/*!
+ * Users disabling each mode. Deep sleep is disabled by the library until
+ * \ref LpmSetDeepSleepMode enables it, light sleep by the application until
+ * \ref LpmSetLightSleepMode enables it: only the timer and the radio DIOs
+ * wake it up, WiFi and the application interrupts would stall.
+ */
+static uint32_t DeepSleepDisable = LPM_LIB_ID;
+static uint32_t LightSleepDisable = LPM_APPLI_ID;
+
+/*!
+ * Consecutive requests allowing deep sleep
+ */
+static uint8_t DeepSleepRequests = 0;
+
+/*!
+ * Light sleep wake-up latency samples, mean and variance [us, us^2]
+ */
+RTC_DATA_ATTR static uint32_t LatencySamples = 0;
+RTC_DATA_ATTR static float LatencyMean = LPM_LIGHT_SLEEP_DEFAULT_LATENCY;
+RTC_DATA_ATTR static float LatencyVariance = 0;
+
+/*!
+ * RTC counter at the start of the deep sleep, 0 if none, and its duration [us]
+ */
+RTC_DATA_ATTR static uint64_t DeepSleepStart = 0;
+RTC_DATA_ATTR static uint64_t DeepSleepDuration = 0;
+
+/*!
+ * Low power status. Kept in RTC memory so that deep sleep cycles add up.
+ */
+RTC_DATA_ATTR static LpmStatus_t LpmStatus;
+
+/*!
+ * RTC time and the RTC counter it was last updated at, and their check. Kept
+ * in RTC memory not initialized at reset, as the RTC counter only restarts at
+ * power-on.
+ */
+RTC_NOINIT_ATTR static uint64_t RtcTime;
+RTC_NOINIT_ATTR static uint64_t RtcTimeCounter;
+RTC_NOINIT_ATTR static uint64_t RtcTimeCheck;
+
+/*!
+ * \brief Returns the time elapsed on the RTC counter, which keeps running in
+ *        light and deep sleep
+ *
+ * \param [IN] start RTC counter at the start
+ *
+ * \retval time Elapsed time with the current slow clock calibration [us]
+ */
+static uint64_t GetRtcElapsedTime( uint64_t start )
+{
+    return rtc_time_slowclk_to_us( rtc_time_get( ) - start, esp_clk_slowclk_cal_get( ) );
+}
+
+/*!
+ * \brief Returns the time to the next timer event
+ *
+ * \retval time Time to the next event [ms], UINT32_MAX without running timer
+ */
+static uint32_t GetTimeToAlarm( void )
+{
+    TimerTime_t now = TimerGetTimerValue( );
+
+    if( TimerListHead == NULL )
+    {
+        return UINT32_MAX;
+    }
+    if( nextAlarm <= now )
+    {
+        return 0;
+    }
+    return ( uint32_t )MIN( nextAlarm - now, UINT32_MAX - 1 );
+}
+
+/*!
+ * \brief Selects the deepest mode compatible with the time to the next timer
+ *        event and the radio
+ *
+ * \param [IN] timeToAlarm Time to the next timer event [ms]
+ * \param [IN] radioBusy   The radio is receiving, transmitting or doing a CAD
+ *
+ * \retval mode Low power mode
+ */
+static LpmGetMode_t SelectMode( uint32_t timeToAlarm, bool radioBusy )
+{
+    // A busy radio must be able to raise its DIOs, only light sleep wakes on
+    // them. Deep sleep needs a timer event to wake up for.
+    if( ( radioBusy == false ) && ( DeepSleepDisable == 0 ) && ( timeToAlarm != UINT32_MAX ) &&
+        ( timeToAlarm >= ( LPM_DEEP_SLEEP_MIN_TIME + LpmStatus.DeepSleepLatency ) ) )
+    {
+        if( DeepSleepRequests >= LPM_DEEP_SLEEP_REQUESTS )
+        {
+            return LPM_DEEP_SLEEP_MODE;
+        }
+        return LPM_IDLE_MODE;
+    }
+    // The timer values have a 1 ms resolution, the event may be up to 1 ms closer
+    if( ( LightSleepDisable == 0 ) && ( timeToAlarm > 1 ) &&
+        ( ( ( uint64_t )( timeToAlarm - 1 ) * 1000 ) >= ( LPM_LIGHT_SLEEP_MIN_TIME + LpmGetWakeupTime( ) ) ) )
+    {
+        return LPM_LIGHT_SLEEP_MODE;
+    }
+    return LPM_IDLE_MODE;
+}
+
+/*!
+ * \brief Runs the timer events due, waiting for the next one if it is closer
+ *        than the wake-up advance
+ */
+static void RunTimerEvents( void )
+{
+    uint32_t timeToAlarm = GetTimeToAlarm( );
+
+    while( ( timeToAlarm > 0 ) && ( ( ( uint64_t )timeToAlarm * 1000 ) <= LpmGetWakeupTime( ) ) )
+    {
+        timeToAlarm = GetTimeToAlarm( );
+    }
+    if( timeToAlarm == 0 )
+    {
+        TimerIrqHandler( );
+    }
+}
+
+/*!
+ * \brief Sets the wake-up sources of a radio DIO for light sleep
+ *
+ * \param [IN] pin    DIO pin
+ * \param [IN] enable true before the light sleep, false after
+ */
+static void SetDioWakeup( uint8_t pin, bool enable )
+{
+    if( enable == true )
+    {
+        gpio_wakeup_enable( ( gpio_num_t )pin, GPIO_INTR_HIGH_LEVEL );
+    }
+    else
+    {
+        // gpio_wakeup_disable also disables the edge interrupt of the DIO
+        gpio_wakeup_disable( ( gpio_num_t )pin );
+        gpio_set_intr_type( ( gpio_num_t )pin, GPIO_INTR_POSEDGE );
+    }
+}
+
+static void EnterLightSleep( uint32_t timeToAlarm, bool radioBusy )
+{
+    uint64_t sleepTime = ( uint64_t )( MIN( timeToAlarm, LPM_LIGHT_SLEEP_MAX_TIME ) - 1 ) * 1000 - LpmGetWakeupTime( );
+    uint64_t rtcStart;
+    uint64_t rtcElapsed;
+    uint64_t timerStart;
+    uint64_t timerElapsed;
+    uint64_t rtcTicks;
+    uint32_t ticksPerMs = TimeSwitch & 0x00FFFFFF;
+    esp_sleep_wakeup_cause_t cause;
+
+    esp_sleep_enable_timer_wakeup( sleepTime );
+    if( radioBusy == true )
+    {
+#if defined( RADIO_DIO_0 )
+        SetDioWakeup( RADIO_DIO_0, true );
+#endif
+        SetDioWakeup( RADIO_DIO_1, true );
+        esp_sleep_enable_gpio_wakeup( );
+    }
+
+    // The sleep is timed by the slow clock, calibrated for the temperature
+    RtcDriftApply( );
+    EnergySetMcuSleep( true );
+    timerStart = timerRead( timer );
+    rtcStart = rtc_time_get( );
+    esp_light_sleep_start( );
+    rtcElapsed = GetRtcElapsedTime( rtcStart );
+    timerElapsed = timerRead( timer ) - timerStart;
+
+    // The timer runs from the APB clock which is gated in light sleep, catch
+    // up with the RTC. In timer ticks, whole milliseconds would lose up to
+    // 1 ms at each sleep.
+    rtcTicks = rtcElapsed * ticksPerMs / 1000;
+    if( rtcTicks > timerElapsed )
+    {
+        timerWrite( timer, timerRead( timer ) + ( rtcTicks - timerElapsed ) );
+    }
+    EnergySetMcuSleep( false );
+
+    cause = esp_sleep_get_wakeup_cause( );
+    esp_sleep_disable_wakeup_source( ESP_SLEEP_WAKEUP_ALL );
+    if( radioBusy == true )
+    {
+#if defined( RADIO_DIO_0 )
+        SetDioWakeup( RADIO_DIO_0, false );
+        if( digitalRead( RADIO_DIO_0 ) == HIGH )
+        {
+            Irq0Fired = true;
+        }
+#endif
+        SetDioWakeup( RADIO_DIO_1, false );
+        if( digitalRead( RADIO_DIO_1 ) == HIGH )
+        {
+            Irq1Fired = true;
+        }
+    }
+
+    LpmStatus.LightSleeps++;
+    LpmStatus.LightSleepTime += rtcElapsed / 1000;
+    if( cause == ESP_SLEEP_WAKEUP_TIMER )
+    {
+        float latency = ( rtcElapsed > sleepTime ) ? ( float )( rtcElapsed - sleepTime ) : 0;
+        float alpha;
+        float delta;
+
+        LatencySamples++;
+        alpha = ( LatencySamples < LPM_LATENCY_MIN_SAMPLES ) ? 1.0f / LatencySamples : 1.0f / LPM_LATENCY_MIN_SAMPLES;
+        delta = latency - LatencyMean;
+        LatencyMean += alpha * delta;
+        LatencyVariance = ( 1.0f - alpha ) * ( LatencyVariance + alpha * delta * delta );
+        LpmStatus.LightSleepLatency = ( uint32_t )LatencyMean;
+        LpmStatus.LightSleepJitter = ( uint32_t )sqrtf( LatencyVariance );
+    }
+    else
+    {
+        LpmStatus.DioWakeups++;
+    }
+}
+
+static void EnterDeepSleep( uint32_t timeToAlarm )
+{
+    uint64_t sleepTime = ( uint64_t )( timeToAlarm - LpmStatus.DeepSleepLatency ) * 1000;
+
+    for( uint8_t i = 0; i < sizeof( DeepSleepInputPins ); i++ )
+    {
+        pinMode( DeepSleepInputPins[i], INPUT );
+    }
+    LpmStatus.DeepSleeps++;
+    RtcDriftApply( );
+    DeepSleepStart = rtc_time_get( );
+    DeepSleepDuration = sleepTime;
+    EnergySetMcuSleep( true );
+    esp_sleep_enable_timer_wakeup( sleepTime );
+    esp_deep_sleep_start( );
+}
+
+void LpmInit( void )
+{
+    if( ( DeepSleepStart != 0 ) && ( esp_sleep_get_wakeup_cause( ) == ESP_SLEEP_WAKEUP_TIMER ) )
+    {
+        uint64_t elapsed = GetRtcElapsedTime( DeepSleepStart );
+
+        LpmStatus.DeepSleepTime += DeepSleepDuration / 1000;
+        if( elapsed > DeepSleepDuration )
+        {
+            LpmStatus.DeepSleepLatency = ( elapsed - DeepSleepDuration ) / 1000;
+        }
+    }
+    DeepSleepStart = 0;
+}
+
+void LpmSetDeepSleepMode( LpmId_t id, LpmSetMode_t mode )
+{
+    if( mode == LPM_DISABLE )
+    {
+        DeepSleepDisable |= ( uint32_t )id;
+        DeepSleepRequests = 0;
+    }
+    else
+    {
+        DeepSleepDisable &= ~( uint32_t )id;
+    }
+}
+
+void LpmSetLightSleepMode( LpmId_t id, LpmSetMode_t mode )
+{
+    if( mode == LPM_DISABLE )
+    {
+        LightSleepDisable |= ( uint32_t )id;
+    }
+    else
+    {
+        LightSleepDisable &= ~( uint32_t )id;
+    }
+}
+
+LpmGetMode_t LpmGetMode( void )
+{
+    return SelectMode( GetTimeToAlarm( ), Radio.GetStatus( ) != RF_IDLE );
+}
+
+void LpmEnterLowPower( void )
+{
+    uint32_t timeToAlarm = GetTimeToAlarm( );
+    bool radioBusy = Radio.GetStatus( ) != RF_IDLE;
+    LpmGetMode_t mode = SelectMode( timeToAlarm, radioBusy );
+
+    if( mode == LPM_DEEP_SLEEP_MODE )
+    {
+        EnterDeepSleep( timeToAlarm );
+    }
+    if( DeepSleepDisable == 0 )
+    {
+        DeepSleepRequests = MIN( DeepSleepRequests + 1, LPM_DEEP_SLEEP_REQUESTS );
+    }
+    else
+    {
+        DeepSleepRequests = 0;
+    }
+    if( mode == LPM_LIGHT_SLEEP_MODE )
+    {
+        EnterLightSleep( timeToAlarm, radioBusy );
+    }
+    RunTimerEvents( );
+}
+
+uint64_t LpmGetRtcTime( void )
+{
+    uint64_t counter = rtc_time_get( );
+
+    // The counter and the RTC memory are random after power-on
+    if( ( RtcTimeCheck != ( RtcTime ^ RtcTimeCounter ^ LPM_RTC_TIME_CHECK ) ) || ( counter < RtcTimeCounter ) )
+    {
+        RtcTime = 0;
+        RtcTimeCounter = counter;
+    }
+    // Only the cycles since the last update are converted, a new slow clock
+    // calibration does not move the past time
+    RtcTime += rtc_time_slowclk_to_us( counter - RtcTimeCounter, esp_clk_slowclk_cal_get( ) );
+    RtcTimeCounter = counter;
+    RtcTimeCheck = RtcTime ^ RtcTimeCounter ^ LPM_RTC_TIME_CHECK;
+    return RtcTime / 1000;
+}
+
+uint32_t LpmGetWakeupTime( void )
+{
+    return ( uint32_t )( LatencyMean + 2 * sqrtf( LatencyVariance ) );
+}
+
+void LpmGetStatus( LpmStatus_t *status )
+{
+    *status = LpmStatus;
+}
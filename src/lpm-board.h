@@ -0,0 +1,182 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Low power modes management of the ESP32
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __LPM_BOARD_H__
+#define __LPM_BOARD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "timer.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Consecutive requests, each one allowing deep sleep, before the MCU enters it
+ */
+#define LPM_DEEP_SLEEP_REQUESTS                     5
+
+/*!
+ * Minimum time to the next timer event to enter deep sleep [ms]
+ */
+#define LPM_DEEP_SLEEP_MIN_TIME                     1000
+
+/*!
+ * Minimum light sleep time, wake-up latency excluded [us]
+ */
+#define LPM_LIGHT_SLEEP_MIN_TIME                    2000
+
+/*!
+ * Maximum light sleep time without running timer [ms]
+ */
+#define LPM_LIGHT_SLEEP_MAX_TIME                    1000
+
+/*!
+ * Light sleep wake-up latency assumed before the first measurement [us]
+ */
+#define LPM_LIGHT_SLEEP_DEFAULT_LATENCY             1000
+
+/*!
+ * Low power mode users, each one can disable a mode
+ */
+typedef enum
+{
+    LPM_APPLI_ID = ( 1 << 0 ),
+    LPM_LIB_ID   = ( 1 << 1 ),
+}LpmId_t;
+
+typedef enum
+{
+    LPM_DISABLE = 0,
+    LPM_ENABLE,
+}LpmSetMode_t;
+
+/*!
+ * Low power modes, from the lightest to the deepest
+ *
+ * LPM_IDLE_MODE        The MCU keeps running until the next timer event
+ * LPM_LIGHT_SLEEP_MODE The MCU is woken up by the RTC timer or the radio DIOs,
+ *                      RAM and peripherals are retained
+ * LPM_DEEP_SLEEP_MODE  The MCU is woken up by the RTC timer and restarts,
+ *                      only the RTC memory is retained
+ */
+typedef enum
+{
+    LPM_IDLE_MODE = 0,
+    LPM_LIGHT_SLEEP_MODE,
+    LPM_DEEP_SLEEP_MODE,
+}LpmGetMode_t;
+
+/*!
+ * Low power status
+ */
+typedef struct sLpmStatus
+{
+    /*!
+     * Light and deep sleeps entered
+     */
+    uint32_t LightSleeps;
+    uint32_t DeepSleeps;
+    /*!
+     * Light sleeps ended by a radio DIO
+     */
+    uint32_t DioWakeups;
+    /*!
+     * Time spent in light and deep sleep [ms]
+     */
+    TimerTime_t LightSleepTime;
+    TimerTime_t DeepSleepTime;
+    /*!
+     * Light sleep wake-up latency mean and standard deviation, measured on the
+     * timer wake-ups [us]
+     */
+    uint32_t LightSleepLatency;
+    uint32_t LightSleepJitter;
+    /*!
+     * Deep sleep wake-up latency, from the timer wake-up to \ref LpmInit [ms]
+     */
+    uint32_t DeepSleepLatency;
+}LpmStatus_t;
+
+/*!
+ * \brief Measures the latency of the deep sleep wake-up, if any. To be called
+ *        at startup, once the board is ready to run.
+ */
+void LpmInit( void );
+
+/*!
+ * \brief Enables or disables the deep sleep mode for a user
+ *
+ * \param [IN] id   User
+ * \param [IN] mode LPM_ENABLE, deep sleep is entered when all the users enable it
+ */
+void LpmSetDeepSleepMode( LpmId_t id, LpmSetMode_t mode );
+
+/*!
+ * \brief Enables or disables the light sleep mode for a user
+ *
+ * \remark Disabled for LPM_APPLI_ID at startup. Only the RTC timer and the
+ *         radio DIOs wake the MCU up, an application using WiFi or GPIO
+ *         interrupts keeps it disabled.
+ *
+ * \param [IN] id   User
+ * \param [IN] mode LPM_ENABLE, light sleep is entered when all the users enable it
+ */
+void LpmSetLightSleepMode( LpmId_t id, LpmSetMode_t mode );
+
+/*!
+ * \brief Returns the mode \ref LpmEnterLowPower would enter now
+ *
+ * \retval mode Deepest mode compatible with the next timer event, the radio
+ *              and the users
+ */
+LpmGetMode_t LpmGetMode( void );
+
+/*!
+ * \brief Enters the deepest possible low power mode until the next timer
+ *        event or radio DIO, and runs the timer events due
+ *
+ * \remark Does not return from deep sleep
+ */
+void LpmEnterLowPower( void );
+
+/*!
+ * \brief Returns the RTC time. It runs across light and deep sleep and resets,
+ *        and only restarts from 0 at power-on.
+ *
+ * \retval time RTC time [ms]
+ */
+uint64_t LpmGetRtcTime( void );
+
+/*!
+ * \brief Returns the time the MCU wakes up ahead of a timer event to absorb
+ *        the light sleep wake-up latency
+ *
+ * \retval time Wake-up advance [us]
+ */
+uint32_t LpmGetWakeupTime( void );
+
+/*!
+ * \brief Returns the low power status
+ *
+ * \param [OUT] status Copy of the status
+ */
+void LpmGetStatus( LpmStatus_t *status );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __LPM_BOARD_H__
@@ -0,0 +1,694 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Point to point LoRa link layer for bulk transfers
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stddef.h>
+#include "radio.h"
+#include "timer.h"
+#include "utilities.h"
+#include "p2p.h"
+
+/*!
+ * Frame header, first byte
+ *
+ * | 7   | 6       | 5..3 | 2..0        |
+ * | ACK | ACK_REQ | Rate | Count - 1   |
+ *
+ * Data frames carry the rate the sender moves to once the window is fully
+ * acknowledged. ACK frames carry the rate the receiver listens on after
+ * the ACK.
+ *
+ * Data frame: header, sequence number, window base, payload size, payload
+ * ACK frame  : header, window base, received bitmap, lowest window SNR
+ */
+#define P2P_FRAME_ACK                               0x80
+#define P2P_FRAME_ACK_REQ                           0x40
+#define P2P_FRAME_RATE_SHIFT                        3
+#define P2P_FRAME_RATE_MASK                         0x38
+#define P2P_FRAME_COUNT_MASK                        0x07
+
+/*!
+ * Radio TX timeout. The longest frame at SF12 BW125 lasts about 10 s.
+ */
+#define P2P_TX_TIMEOUT                              15000
+
+/*!
+ * Delay before the receiver answers an ACK request, leaves the sender the
+ * time to turn its radio around [ms]
+ */
+#define P2P_ACK_DELAY                               5
+
+/*!
+ * Margin added to the ACK time on air for the ACK timeout [ms]
+ */
+#define P2P_ACK_TURNAROUND                          30
+
+/*!
+ * Consecutive missed ACKs after which the sender falls back to the base rate
+ */
+#define P2P_FALLBACK_MISSES                         2
+
+/*!
+ * Link states
+ */
+typedef enum eP2pState
+{
+    P2P_STATE_IDLE,
+    P2P_STATE_TX_DATA,
+    P2P_STATE_WAIT_ACK,
+    P2P_STATE_TX_ACK,
+}P2pState_t;
+
+/*!
+ * Rate table, slowest first. The floors are the SX1276 demodulator limits.
+ */
+static const P2pRate_t Rates[P2P_RATE_COUNT] =
+{
+    { 12, 0, -200 },
+    { 11, 0, -175 },
+    { 10, 0, -150 },
+    {  9, 0, -125 },
+    {  8, 0, -100 },
+    {  7, 0,  -75 },
+    {  7, 1,  -75 },
+    {  7, 2,  -75 },
+};
+
+static P2pParams_t Params;
+static P2pEvents_t *Events;
+static RadioEvents_t P2pRadioEvents;
+static P2pStatistics_t Statistics;
+
+static P2pState_t State = P2P_STATE_IDLE;
+static bool Listening = false;
+
+/*!
+ * Rate in use and the rate announced to the receiver
+ */
+static uint8_t CurrentRate;
+static uint8_t TargetRate;
+
+/*!
+ * ACK reception timeout at the current rate [ms]
+ */
+static uint32_t AckTimeout;
+
+static TimerEvent_t AckDelayTimer;
+static TimerEvent_t LinkTimer;
+
+/*!
+ * Sender window. Frames are stored with room for their header.
+ */
+static uint8_t TxFrames[P2P_WINDOW_SIZE][P2P_HEADER_SIZE + P2P_MAX_PAYLOAD];
+static uint8_t TxSizes[P2P_WINDOW_SIZE];
+static uint8_t TxQueued = 0;
+static uint8_t TxBase = 0;
+static uint8_t TxAcked;
+static int8_t TxNext;
+static uint8_t TxRetries;
+static bool TxFirstPass;
+static uint8_t AckMisses = 0;
+
+/*!
+ * Receiver window
+ */
+static bool RxWindowValid = false;
+static uint8_t RxBase;
+static uint8_t RxBitmap;
+static uint8_t RxCount;
+static uint8_t RxRequestedRate;
+static int8_t RxMinSnr;
+static uint8_t RxAckRate;
+static uint8_t AckFrame[P2P_HEADER_SIZE + P2P_MAX_PAYLOAD];
+
+static void OnRadioTxDone( void );
+static void OnRadioTxTimeout( void );
+static void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr );
+static void OnRadioRxTimeout( void );
+static void OnRadioRxError( void );
+static void OnAckDelayTimerEvent( void );
+static void OnLinkTimerEvent( void );
+
+/*!
+ * \brief Returns the on air size of a frame
+ *
+ * \param [IN] size Payload size
+ */
+static uint8_t FrameLength( uint8_t size )
+{
+    if( Params.FixedPayload != 0 )
+    {
+        return P2P_HEADER_SIZE + Params.FixedPayload;
+    }
+    return P2P_HEADER_SIZE + size;
+}
+
+/*!
+ * \brief Configures the radio for a rate table entry
+ *
+ * \param [IN] rate Rate table index
+ */
+static void ApplyRate( uint8_t rate )
+{
+    const P2pRate_t *entry = &Rates[rate];
+    bool fixLen = ( Params.FixedPayload != 0 );
+
+    Radio.SetChannel( Params.Frequency );
+    Radio.SetTxConfig( MODEM_LORA, Params.TxPower, 0, entry->Bandwidth,
+                       entry->SpreadingFactor, Params.Coderate,
+                       Params.PreambleLen, fixLen,
+                       true, 0, 0, false, P2P_TX_TIMEOUT );
+    Radio.SetRxConfig( MODEM_LORA, entry->Bandwidth, entry->SpreadingFactor,
+                       Params.Coderate, 0, Params.PreambleLen,
+                       0, fixLen, FrameLength( 0 ),
+                       true, 0, 0, false, true );
+
+    AckTimeout = Radio.TimeOnAir( MODEM_LORA, FrameLength( 0 ) ) * 2 + P2P_ACK_DELAY + P2P_ACK_TURNAROUND;
+    CurrentRate = rate;
+}
+
+/*!
+ * \brief Changes the link rate
+ *
+ * \param [IN] rate Rate table index
+ */
+static void SetRate( uint8_t rate )
+{
+    if( rate == CurrentRate )
+    {
+        return;
+    }
+    ApplyRate( rate );
+    Statistics.RateChanges++;
+
+    if( ( Events != NULL ) && ( Events->RateChanged != NULL ) )
+    {
+        Events->RateChanged( rate );
+    }
+}
+
+/*!
+ * \brief Returns to the base rate after a link loss
+ */
+static void FallBack( void )
+{
+    if( CurrentRate == Params.BaseRate )
+    {
+        return;
+    }
+    TargetRate = Params.BaseRate;
+    SetRate( Params.BaseRate );
+    Statistics.RateFallbacks++;
+}
+
+/*!
+ * \brief (Re)starts the link supervision timer, the link falls back to the
+ *        base rate if it stays silent for LinkTimeout
+ */
+static void RestartLinkTimer( void )
+{
+    TimerStop( &LinkTimer );
+    if( CurrentRate != Params.BaseRate )
+    {
+        TimerStart( &LinkTimer );
+    }
+}
+
+/*!
+ * \brief Selects the fastest rate the reported SNR supports
+ *
+ * \param [IN] snr Lowest SNR the receiver saw in the window [dB]
+ *
+ * \retval rate Rate table index
+ */
+static uint8_t SelectRate( int8_t snr )
+{
+    int16_t available = ( ( int16_t )snr - Params.SnrMargin ) * 10;
+    uint8_t rate = 0;
+
+    for( uint8_t i = 0; i <= Params.MaxRate; i++ )
+    {
+        // The SNR was measured at the current bandwidth, it drops by 3 dB
+        // each time the bandwidth doubles
+        int16_t floor = Rates[i].SnrFloor + 30 * ( ( int16_t )Rates[i].Bandwidth - Rates[CurrentRate].Bandwidth );
+
+        if( available >= floor )
+        {
+            rate = i;
+        }
+    }
+    // Step up one rate at a time, faster rates are only probed once the
+    // current one is confirmed
+    return MIN( rate, CurrentRate + 1 );
+}
+
+static void ResumeListening( void )
+{
+    if( Listening == true )
+    {
+        Radio.Rx( 0 );
+    }
+    else
+    {
+        Radio.Sleep( );
+    }
+}
+
+/*!
+ * \brief Returns the index of the next unacknowledged frame after index
+ *
+ * \retval next Frame index, -1 when none is left
+ */
+static int8_t FindNextFrame( int8_t index )
+{
+    for( int8_t i = index + 1; i < TxQueued; i++ )
+    {
+        if( ( TxAcked & ( 1 << i ) ) == 0 )
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*!
+ * \brief Writes the header of a queued frame
+ */
+static void PrepareFrame( int8_t index )
+{
+    uint8_t *frame = TxFrames[index];
+
+    frame[0] = ( TargetRate << P2P_FRAME_RATE_SHIFT ) | ( TxQueued - 1 );
+    if( FindNextFrame( index ) < 0 )
+    {
+        frame[0] |= P2P_FRAME_ACK_REQ;
+    }
+    frame[1] = TxBase + index;
+    frame[2] = TxBase;
+    frame[3] = TxSizes[index];
+}
+
+/*!
+ * \brief Starts the transmission of a frame and prepares the following one
+ *        while it is on air, so that TxDone only has to start the radio
+ *        again.
+ */
+static void SendFrame( int8_t index )
+{
+    State = P2P_STATE_TX_DATA;
+    Radio.Send( TxFrames[index], FrameLength( TxSizes[index] ) );
+
+    Statistics.FramesSent++;
+    if( TxFirstPass == false )
+    {
+        Statistics.Retransmissions++;
+    }
+
+    TxNext = FindNextFrame( index );
+    if( TxNext >= 0 )
+    {
+        PrepareFrame( TxNext );
+    }
+}
+
+/*!
+ * \brief Sends every unacknowledged frame of the window, the last one
+ *        requests an ACK
+ */
+static void StartPass( void )
+{
+    int8_t index = FindNextFrame( -1 );
+
+    PrepareFrame( index );
+    Radio.Standby( );
+    SendFrame( index );
+}
+
+static void FinishWindow( bool success )
+{
+    TxQueued = 0;
+    TxBase += Params.WindowSize;
+    State = P2P_STATE_IDLE;
+    RestartLinkTimer( );
+    ResumeListening( );
+
+    if( ( Events != NULL ) && ( Events->WindowDone != NULL ) )
+    {
+        Events->WindowDone( success );
+    }
+}
+
+static void RetryWindow( void )
+{
+    if( ++TxRetries >= Params.MaxRetries )
+    {
+        Statistics.WindowsFailed++;
+        FallBack( );
+        FinishWindow( false );
+        return;
+    }
+    StartPass( );
+}
+
+static void OnAckMissed( void )
+{
+    Statistics.AckTimeouts++;
+    if( ++AckMisses >= P2P_FALLBACK_MISSES )
+    {
+        // The receiver may have moved to another rate, meet it at the
+        // base rate once its link timer expires
+        FallBack( );
+    }
+    RetryWindow( );
+}
+
+static void ProcessAck( uint8_t *payload )
+{
+    uint8_t mask = ( 1 << TxQueued ) - 1;
+
+    if( payload[1] != TxBase )
+    {
+        OnAckMissed( );
+        return;
+    }
+    Statistics.AcksReceived++;
+    AckMisses = 0;
+    TxAcked |= payload[2] & mask;
+
+    if( Params.AutoRate == true )
+    {
+        TargetRate = SelectRate( ( int8_t )payload[3] );
+    }
+
+    if( TxAcked != mask )
+    {
+        RetryWindow( );
+        return;
+    }
+
+    for( uint8_t i = 0; i < TxQueued; i++ )
+    {
+        Statistics.BytesAcked += TxSizes[i];
+    }
+    Statistics.WindowsDone++;
+    SetRate( MIN( ( payload[0] & P2P_FRAME_RATE_MASK ) >> P2P_FRAME_RATE_SHIFT, P2P_RATE_COUNT - 1 ) );
+    FinishWindow( true );
+}
+
+static void ProcessData( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
+{
+    uint8_t count = ( payload[0] & P2P_FRAME_COUNT_MASK ) + 1;
+    uint8_t index = payload[1] - payload[2];
+    uint8_t length = payload[3];
+
+    if( ( index >= count ) || ( length > ( size - P2P_HEADER_SIZE ) ) )
+    {
+        return;
+    }
+
+    if( ( RxWindowValid == false ) || ( payload[2] != RxBase ) )
+    {
+        RxWindowValid = true;
+        RxBase = payload[2];
+        RxBitmap = 0;
+        RxMinSnr = INT8_MAX;
+    }
+    RxCount = count;
+    RxRequestedRate = ( payload[0] & P2P_FRAME_RATE_MASK ) >> P2P_FRAME_RATE_SHIFT;
+    RxMinSnr = MIN( RxMinSnr, snr );
+
+    if( ( RxBitmap & ( 1 << index ) ) != 0 )
+    {
+        Statistics.Duplicates++;
+    }
+    else
+    {
+        RxBitmap |= 1 << index;
+        Statistics.FramesReceived++;
+        Statistics.BytesReceived += length;
+
+        if( ( Events != NULL ) && ( Events->RxData != NULL ) )
+        {
+            Events->RxData( payload[1], payload + P2P_HEADER_SIZE, length, rssi, snr );
+        }
+    }
+    RestartLinkTimer( );
+
+    if( ( payload[0] & P2P_FRAME_ACK_REQ ) != 0 )
+    {
+        State = P2P_STATE_TX_ACK;
+        TimerStart( &AckDelayTimer );
+    }
+}
+
+static void OnAckDelayTimerEvent( void )
+{
+    TimerStop( &AckDelayTimer );
+
+    // Follow the sender only once the whole window made it through, it
+    // keeps the current rate until then
+    RxAckRate = CurrentRate;
+    if( RxBitmap == ( ( 1 << RxCount ) - 1 ) )
+    {
+        RxAckRate = MIN( RxRequestedRate, P2P_RATE_COUNT - 1 );
+    }
+
+    AckFrame[0] = P2P_FRAME_ACK | ( RxAckRate << P2P_FRAME_RATE_SHIFT );
+    AckFrame[1] = RxBase;
+    AckFrame[2] = RxBitmap;
+    AckFrame[3] = ( uint8_t )RxMinSnr;
+
+    Radio.Standby( );
+    Radio.Send( AckFrame, FrameLength( 0 ) );
+}
+
+static void OnLinkTimerEvent( void )
+{
+    TimerStop( &LinkTimer );
+
+    if( State != P2P_STATE_IDLE )
+    {
+        return;
+    }
+    FallBack( );
+    ResumeListening( );
+}
+
+static void OnRadioTxDone( void )
+{
+    switch( State )
+    {
+        case P2P_STATE_TX_DATA:
+            if( TxNext >= 0 )
+            {
+                SendFrame( TxNext );
+            }
+            else
+            {
+                TxFirstPass = false;
+                State = P2P_STATE_WAIT_ACK;
+                Radio.Rx( AckTimeout );
+            }
+            break;
+        case P2P_STATE_TX_ACK:
+            State = P2P_STATE_IDLE;
+            SetRate( RxAckRate );
+            RestartLinkTimer( );
+            ResumeListening( );
+            break;
+        default:
+            break;
+    }
+}
+
+static void OnRadioTxTimeout( void )
+{
+    switch( State )
+    {
+        case P2P_STATE_TX_DATA:
+            RetryWindow( );
+            break;
+        case P2P_STATE_TX_ACK:
+            State = P2P_STATE_IDLE;
+            ResumeListening( );
+            break;
+        default:
+            break;
+    }
+}
+
+static void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
+{
+    if( State == P2P_STATE_WAIT_ACK )
+    {
+        if( ( size >= P2P_HEADER_SIZE ) && ( ( payload[0] & P2P_FRAME_ACK ) != 0 ) )
+        {
+            ProcessAck( payload );
+        }
+        else
+        {
+            OnAckMissed( );
+        }
+        return;
+    }
+
+    if( ( State == P2P_STATE_IDLE ) && ( size >= P2P_HEADER_SIZE ) && ( ( payload[0] & P2P_FRAME_ACK ) == 0 ) )
+    {
+        ProcessData( payload, size, rssi, snr );
+    }
+}
+
+static void OnRadioRxTimeout( void )
+{
+    if( State == P2P_STATE_WAIT_ACK )
+    {
+        OnAckMissed( );
+    }
+}
+
+static void OnRadioRxError( void )
+{
+    if( State == P2P_STATE_WAIT_ACK )
+    {
+        OnAckMissed( );
+    }
+}
+
+bool P2pInit( P2pParams_t *params, P2pEvents_t *events )
+{
+    if( ( params == NULL ) ||
+        ( params->BaseRate > params->MaxRate ) ||
+        ( params->MaxRate >= P2P_RATE_COUNT ) ||
+        ( params->WindowSize == 0 ) ||
+        ( params->WindowSize > P2P_WINDOW_SIZE ) ||
+        ( params->FixedPayload > P2P_MAX_PAYLOAD ) ||
+        ( params->MaxRetries == 0 ) )
+    {
+        return false;
+    }
+    Params = *params;
+    Events = events;
+
+    P2pRadioEvents.TxDone = OnRadioTxDone;
+    P2pRadioEvents.TxTimeout = OnRadioTxTimeout;
+    P2pRadioEvents.RxDone = OnRadioRxDone;
+    P2pRadioEvents.RxTimeout = OnRadioRxTimeout;
+    P2pRadioEvents.RxError = OnRadioRxError;
+    Radio.Init( &P2pRadioEvents );
+
+    TimerInit( &AckDelayTimer, OnAckDelayTimerEvent );
+    TimerSetValue( &AckDelayTimer, P2P_ACK_DELAY );
+    TimerInit( &LinkTimer, OnLinkTimerEvent );
+    TimerSetValue( &LinkTimer, Params.LinkTimeout );
+
+    State = P2P_STATE_IDLE;
+    Listening = false;
+    TxQueued = 0;
+    AckMisses = 0;
+    RxWindowValid = false;
+    TargetRate = Params.BaseRate;
+    ApplyRate( Params.BaseRate );
+    Radio.Sleep( );
+
+    return true;
+}
+
+void P2pListen( void )
+{
+    Listening = true;
+    if( State == P2P_STATE_IDLE )
+    {
+        Radio.Rx( 0 );
+    }
+}
+
+void P2pStop( void )
+{
+    TimerStop( &AckDelayTimer );
+    TimerStop( &LinkTimer );
+    State = P2P_STATE_IDLE;
+    Listening = false;
+    TxQueued = 0;
+    Radio.Sleep( );
+}
+
+bool P2pSend( const uint8_t *buffer, uint8_t size )
+{
+    uint8_t maxSize = ( Params.FixedPayload != 0 ) ? Params.FixedPayload : P2P_MAX_PAYLOAD;
+    uint8_t *frame;
+
+    if( ( State != P2P_STATE_IDLE ) || ( TxQueued >= Params.WindowSize ) || ( size > maxSize ) )
+    {
+        return false;
+    }
+
+    frame = TxFrames[TxQueued];
+    memcpy1( frame + P2P_HEADER_SIZE, buffer, size );
+    // Implicit header frames are padded to the fixed size
+    memset1( frame + P2P_HEADER_SIZE + size, 0, maxSize - size );
+    TxSizes[TxQueued++] = size;
+
+    if( TxQueued == Params.WindowSize )
+    {
+        P2pFlush( );
+    }
+    return true;
+}
+
+bool P2pFlush( void )
+{
+    if( ( State != P2P_STATE_IDLE ) || ( TxQueued == 0 ) )
+    {
+        return false;
+    }
+    TimerStop( &LinkTimer );
+    TxAcked = 0;
+    TxRetries = 0;
+    TxFirstPass = true;
+    StartPass( );
+    return true;
+}
+
+bool P2pIsBusy( void )
+{
+    return ( State != P2P_STATE_IDLE );
+}
+
+void P2pSetRate( uint8_t rate )
+{
+    TargetRate = MIN( rate, Params.MaxRate );
+}
+
+uint8_t P2pGetCurrentRate( void )
+{
+    return CurrentRate;
+}
+
+const P2pRate_t* P2pGetRate( uint8_t rate )
+{
+    if( rate >= P2P_RATE_COUNT )
+    {
+        return NULL;
+    }
+    return &Rates[rate];
+}
+
+P2pStatistics_t* P2pGetStatistics( void )
+{
+    return &Statistics;
+}
+
+void P2pResetStatistics( void )
+{
+    memset1( ( uint8_t* )&Statistics, 0, sizeof( Statistics ) );
+}
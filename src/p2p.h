@@ -0,0 +1,293 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Point to point LoRa link layer for bulk transfers
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __P2P_H__
+#define __P2P_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Maximum number of frames in flight. Bounded by the 8 bits ACK bitmap.
+ */
+#ifndef P2P_WINDOW_SIZE
+#define P2P_WINDOW_SIZE                             8
+#endif
+
+/*!
+ * Maximum application payload per frame
+ */
+#ifndef P2P_MAX_PAYLOAD
+#define P2P_MAX_PAYLOAD                             240
+#endif
+
+/*!
+ * Frame header size
+ */
+#define P2P_HEADER_SIZE                             4
+
+/*!
+ * Number of entries in the rate table, see \ref P2pGetRate
+ */
+#define P2P_RATE_COUNT                              8
+
+/*!
+ * Link rate, a spreading factor and bandwidth pair
+ */
+typedef struct sP2pRate
+{
+    /*!
+     * Spreading factor [7..12]
+     */
+    uint8_t SpreadingFactor;
+    /*!
+     * Bandwidth [0: 125 kHz, 1: 250 kHz, 2: 500 kHz]
+     */
+    uint8_t Bandwidth;
+    /*!
+     * Demodulation floor [dB x 10]
+     */
+    int16_t SnrFloor;
+}P2pRate_t;
+
+/*!
+ * Link parameters. Both ends must use the same values.
+ */
+typedef struct sP2pParams
+{
+    /*!
+     * RF frequency [Hz]
+     */
+    uint32_t Frequency;
+    /*!
+     * RF output power [dBm]
+     */
+    int8_t TxPower;
+    /*!
+     * Coding rate [1: 4/5, 2: 4/6, 3: 4/7, 4: 4/8]
+     */
+    uint8_t Coderate;
+    /*!
+     * Preamble length [symbols]
+     */
+    uint16_t PreambleLen;
+    /*!
+     * Rate table index used at start and after a link loss. Index 0 is the
+     * slowest rate.
+     */
+    uint8_t BaseRate;
+    /*!
+     * Highest rate table index the automatic selection may use
+     */
+    uint8_t MaxRate;
+    /*!
+     * Enables the automatic rate selection
+     */
+    bool AutoRate;
+    /*!
+     * SNR margin kept above the demodulation floor [dB]
+     */
+    uint8_t SnrMargin;
+    /*!
+     * Implicit header payload size, every frame is padded to it.
+     * 0 selects the explicit header mode.
+     */
+    uint8_t FixedPayload;
+    /*!
+     * Frames sent before an ACK is requested [1..P2P_WINDOW_SIZE]
+     */
+    uint8_t WindowSize;
+    /*!
+     * Maximum number of ACK requests for a window before giving up
+     */
+    uint8_t MaxRetries;
+    /*!
+     * Time without traffic after which the receiver falls back to the base
+     * rate [ms]
+     */
+    uint32_t LinkTimeout;
+}P2pParams_t;
+
+/*!
+ * Link statistics
+ */
+typedef struct sP2pStatistics
+{
+    /*!
+     * Data frames sent, retransmissions included
+     */
+    uint32_t FramesSent;
+    /*!
+     * Data frames sent again after a missing ACK bit
+     */
+    uint32_t Retransmissions;
+    /*!
+     * ACK frames received by the sender
+     */
+    uint32_t AcksReceived;
+    /*!
+     * ACK requests that got no answer
+     */
+    uint32_t AckTimeouts;
+    /*!
+     * Windows fully acknowledged
+     */
+    uint32_t WindowsDone;
+    /*!
+     * Windows abandoned after MaxRetries
+     */
+    uint32_t WindowsFailed;
+    /*!
+     * Application bytes acknowledged by the receiver
+     */
+    uint32_t BytesAcked;
+    /*!
+     * Data frames received, duplicates excluded
+     */
+    uint32_t FramesReceived;
+    /*!
+     * Duplicated data frames dropped by the receiver
+     */
+    uint32_t Duplicates;
+    /*!
+     * Application bytes delivered by the receiver
+     */
+    uint32_t BytesReceived;
+    /*!
+     * Rate changes
+     */
+    uint32_t RateChanges;
+    /*!
+     * Fallbacks to the base rate
+     */
+    uint32_t RateFallbacks;
+}P2pStatistics_t;
+
+/*!
+ * Link event callbacks
+ */
+typedef struct sP2pEvents
+{
+    /*!
+     * \brief Window transfer done. New frames may be queued.
+     *
+     * \param [IN] success true when every frame of the window was acknowledged
+     */
+    void ( *WindowDone )( bool success );
+    /*!
+     * \brief Data frame received. Frames of a window are delivered as they
+     *        arrive, retransmissions may reorder them.
+     *
+     * \param [IN] seq     Frame sequence number
+     * \param [IN] payload Frame payload
+     * \param [IN] size    Payload size
+     * \param [IN] rssi    Frame RSSI [dBm]
+     * \param [IN] snr     Frame SNR [dB]
+     */
+    void ( *RxData )( uint8_t seq, uint8_t *payload, uint8_t size, int16_t rssi, int8_t snr );
+    /*!
+     * \brief The link rate changed
+     *
+     * \param [IN] rate New rate table index
+     */
+    void ( *RateChanged )( uint8_t rate );
+}P2pEvents_t;
+
+/*!
+ * \brief Initializes the link and takes over the radio events. The radio
+ *        must not be used by the LoRaWAN stack at the same time.
+ *
+ * \param [IN] params Link parameters, copied
+ * \param [IN] events Event callbacks, must stay valid
+ *
+ * \retval status [true: ok, false: invalid parameters]
+ */
+bool P2pInit( P2pParams_t *params, P2pEvents_t *events );
+
+/*!
+ * \brief Starts listening for data frames. The node goes back to listening
+ *        after each window it sends.
+ */
+void P2pListen( void );
+
+/*!
+ * \brief Stops the link and puts the radio to sleep
+ */
+void P2pStop( void );
+
+/*!
+ * \brief Queues a frame in the current window. The window is sent once it
+ *        is full or \ref P2pFlush is called.
+ *
+ * \param [IN] buffer Payload
+ * \param [IN] size   Payload size, at most P2P_MAX_PAYLOAD or FixedPayload
+ *                    less the header in implicit header mode
+ *
+ * \retval status [true: queued, false: window busy or size too large]
+ */
+bool P2pSend( const uint8_t *buffer, uint8_t size );
+
+/*!
+ * \brief Sends the frames queued so far as a window
+ *
+ * \retval status [true: window started, false: nothing queued or busy]
+ */
+bool P2pFlush( void );
+
+/*!
+ * \brief Checks if a window is being transferred
+ *
+ * \retval busy true while a window waits for its acknowledgement
+ */
+bool P2pIsBusy( void );
+
+/*!
+ * \brief Requests a rate for the next windows. Used when AutoRate is
+ *        disabled, the receiver follows once it acknowledges a full window.
+ *
+ * \param [IN] rate Rate table index
+ */
+void P2pSetRate( uint8_t rate );
+
+/*!
+ * \brief Returns the current rate table index
+ */
+uint8_t P2pGetCurrentRate( void );
+
+/*!
+ * \brief Returns a rate table entry
+ *
+ * \param [IN] rate Rate table index
+ */
+const P2pRate_t* P2pGetRate( uint8_t rate );
+
+/*!
+ * \brief Returns the link statistics
+ */
+P2pStatistics_t* P2pGetStatistics( void );
+
+/*!
+ * \brief Clears the link statistics
+ */
+void P2pResetStatistics( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __P2P_H__
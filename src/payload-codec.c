@@ -0,0 +1,280 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Schema driven codec of the sensor samples sent in the uplinks
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <math.h>
+#include "utilities.h"
+#include "payload-codec.h"
+
+/*!
+ * Frame header bits: sample identifier and distance to the reference
+ */
+#define PAYLOAD_CODEC_ID_BITS                       4
+#define PAYLOAD_CODEC_HEADER_BITS                   ( 2 * PAYLOAD_CODEC_ID_BITS )
+
+/*!
+ * Bit stream over a frame
+ */
+typedef struct sPayloadCodecBits
+{
+    uint8_t *Buffer;
+    uint16_t Size;
+    uint16_t Position;
+}PayloadCodecBits_t;
+
+static void WriteBits( PayloadCodecBits_t *bits, uint32_t value, uint8_t nbBits )
+{
+    while( nbBits-- > 0 )
+    {
+        if( ( value >> nbBits ) & 1 )
+        {
+            bits->Buffer[bits->Position >> 3] |= 0x80 >> ( bits->Position & 7 );
+        }
+        bits->Position++;
+    }
+}
+
+static bool ReadBits( PayloadCodecBits_t *bits, uint8_t nbBits, uint32_t *value )
+{
+    if( ( bits->Position + nbBits ) > ( bits->Size * 8 ) )
+    {
+        return false;
+    }
+    *value = 0;
+    while( nbBits-- > 0 )
+    {
+        *value = ( *value << 1 ) | ( ( bits->Buffer[bits->Position >> 3] >> ( 7 - ( bits->Position & 7 ) ) ) & 1 );
+        bits->Position++;
+    }
+    return true;
+}
+
+static uint8_t BitLength( uint32_t value )
+{
+    uint8_t length = 0;
+
+    while( value != 0 )
+    {
+        length++;
+        value >>= 1;
+    }
+    return length;
+}
+
+static uint32_t ZigZag( int32_t value )
+{
+    return ( ( uint32_t )value << 1 ) ^ ( uint32_t )( value >> 31 );
+}
+
+static int32_t UnZigZag( uint32_t value )
+{
+    return ( int32_t )( value >> 1 ) ^ -( int32_t )( value & 1 );
+}
+
+static uint8_t VarintBits( uint32_t value )
+{
+    uint8_t groups = ( BitLength( value ) + PAYLOAD_CODEC_VARINT_BITS - 1 ) / PAYLOAD_CODEC_VARINT_BITS;
+
+    return MAX( groups, 1 ) * ( PAYLOAD_CODEC_VARINT_BITS + 1 );
+}
+
+static void WriteVarint( PayloadCodecBits_t *bits, uint32_t value )
+{
+    do
+    {
+        WriteBits( bits, value & ( ( 1 << PAYLOAD_CODEC_VARINT_BITS ) - 1 ), PAYLOAD_CODEC_VARINT_BITS );
+        value >>= PAYLOAD_CODEC_VARINT_BITS;
+        WriteBits( bits, ( value != 0 ) ? 1 : 0, 1 );
+    }while( value != 0 );
+}
+
+static bool ReadVarint( PayloadCodecBits_t *bits, uint32_t *value )
+{
+    uint32_t group;
+    uint32_t more = 1;
+    uint8_t shift = 0;
+
+    *value = 0;
+    while( more != 0 )
+    {
+        if( ( shift >= 32 ) ||
+            ( ReadBits( bits, PAYLOAD_CODEC_VARINT_BITS, &group ) == false ) ||
+            ( ReadBits( bits, 1, &more ) == false ) )
+        {
+            return false;
+        }
+        *value |= group << shift;
+        shift += PAYLOAD_CODEC_VARINT_BITS;
+    }
+    return true;
+}
+
+static uint32_t GetRange( const PayloadCodecField_t *field )
+{
+    return ( uint32_t )lroundf( ( field->Max - field->Min ) / field->Step );
+}
+
+static int32_t Quantize( const PayloadCodecField_t *field, float value )
+{
+    value = MIN( MAX( value, field->Min ), field->Max );
+    return ( int32_t )MIN( ( uint32_t )lroundf( ( value - field->Min ) / field->Step ), GetRange( field ) );
+}
+
+void PayloadCodecInit( PayloadCodec_t *codec, const PayloadCodecField_t *fields, uint8_t nbFields )
+{
+    if( ( codec->Fields == fields ) && ( codec->NbFields == nbFields ) )
+    {
+        return;
+    }
+    memset1( ( uint8_t * )codec, 0, sizeof( PayloadCodec_t ) );
+    codec->Fields = fields;
+    codec->NbFields = MIN( nbFields, PAYLOAD_CODEC_MAX_FIELDS );
+}
+
+uint8_t PayloadCodecEncode( PayloadCodec_t *codec, const float *values, uint8_t *buffer, uint8_t maxSize )
+{
+    PayloadCodecBits_t bits = { buffer, maxSize, 0 };
+    int32_t sample[PAYLOAD_CODEC_MAX_FIELDS] = { 0 };
+    uint8_t absoluteBits[PAYLOAD_CODEC_MAX_FIELDS];
+    uint32_t deltas[PAYLOAD_CODEC_MAX_FIELDS];
+    uint16_t absoluteSize = PAYLOAD_CODEC_HEADER_BITS;
+    uint16_t deltaSize = PAYLOAD_CODEC_HEADER_BITS;
+    uint8_t distance = ( codec->Id - codec->ReferenceId ) & ( PAYLOAD_CODEC_IDS - 1 );
+    uint16_t size;
+    uint8_t i;
+
+    for( i = 0; i < codec->NbFields; i++ )
+    {
+        sample[i] = Quantize( &codec->Fields[i], values[i] );
+        absoluteBits[i] = BitLength( GetRange( &codec->Fields[i] ) );
+        deltas[i] = ZigZag( sample[i] - codec->Reference[i] );
+        absoluteSize += absoluteBits[i];
+        deltaSize += 1 + MIN( VarintBits( deltas[i] ), absoluteBits[i] );
+    }
+
+    // Past PAYLOAD_CODEC_IDS - 1 frames the identifier of the reference wraps
+    // and may have been replaced in the decoder by a later sample
+    if( ( codec->ReferenceValid == false ) || ( codec->SinceReference >= ( PAYLOAD_CODEC_IDS - 1 ) ) ||
+        ( absoluteSize <= deltaSize ) )
+    {
+        distance = 0;
+    }
+    size = ( ( distance == 0 ) ? absoluteSize : deltaSize );
+    size = ( size + 7 ) / 8;
+    if( size > maxSize )
+    {
+        return 0;
+    }
+    memset1( buffer, 0, size );
+
+    WriteBits( &bits, codec->Id, PAYLOAD_CODEC_ID_BITS );
+    WriteBits( &bits, distance, PAYLOAD_CODEC_ID_BITS );
+    for( i = 0; i < codec->NbFields; i++ )
+    {
+        if( distance == 0 )
+        {
+            WriteBits( &bits, sample[i], absoluteBits[i] );
+        }
+        else if( VarintBits( deltas[i] ) < absoluteBits[i] )
+        {
+            WriteBits( &bits, 0, 1 );
+            WriteVarint( &bits, deltas[i] );
+        }
+        else
+        {
+            WriteBits( &bits, 1, 1 );
+            WriteBits( &bits, sample[i], absoluteBits[i] );
+        }
+    }
+
+    memcpy1( ( uint8_t * )codec->Last, ( uint8_t * )sample, sizeof( codec->Last ) );
+    codec->LastId = codec->Id;
+    codec->LastValid = true;
+    codec->Id = ( codec->Id + 1 ) & ( PAYLOAD_CODEC_IDS - 1 );
+    if( codec->SinceReference < UINT8_MAX )
+    {
+        codec->SinceReference++;
+    }
+    return size;
+}
+
+void PayloadCodecAck( PayloadCodec_t *codec )
+{
+    if( codec->LastValid == false )
+    {
+        return;
+    }
+    memcpy1( ( uint8_t * )codec->Reference, ( uint8_t * )codec->Last, sizeof( codec->Reference ) );
+    codec->ReferenceId = codec->LastId;
+    codec->ReferenceValid = true;
+    codec->SinceReference = 0;
+}
+
+void PayloadCodecDecoderInit( PayloadCodecDecoder_t *decoder, const PayloadCodecField_t *fields, uint8_t nbFields )
+{
+    memset1( ( uint8_t * )decoder, 0, sizeof( PayloadCodecDecoder_t ) );
+    decoder->Fields = fields;
+    decoder->NbFields = MIN( nbFields, PAYLOAD_CODEC_MAX_FIELDS );
+}
+
+bool PayloadCodecDecode( PayloadCodecDecoder_t *decoder, const uint8_t *buffer, uint8_t size, float *values )
+{
+    PayloadCodecBits_t bits = { ( uint8_t * )buffer, size, 0 };
+    int32_t sample[PAYLOAD_CODEC_MAX_FIELDS] = { 0 };
+    uint32_t id;
+    uint32_t distance;
+    uint32_t absolute = 1;
+    uint32_t value;
+    uint8_t reference;
+    uint8_t i;
+
+    if( ( ReadBits( &bits, PAYLOAD_CODEC_ID_BITS, &id ) == false ) ||
+        ( ReadBits( &bits, PAYLOAD_CODEC_ID_BITS, &distance ) == false ) )
+    {
+        return false;
+    }
+    reference = ( id - distance ) & ( PAYLOAD_CODEC_IDS - 1 );
+    if( ( distance != 0 ) && ( ( decoder->Valid & ( 1 << reference ) ) == 0 ) )
+    {
+        return false;
+    }
+
+    for( i = 0; i < decoder->NbFields; i++ )
+    {
+        if( ( distance != 0 ) && ( ReadBits( &bits, 1, &absolute ) == false ) )
+        {
+            return false;
+        }
+        if( absolute != 0 )
+        {
+            if( ReadBits( &bits, BitLength( GetRange( &decoder->Fields[i] ) ), &value ) == false )
+            {
+                return false;
+            }
+            sample[i] = ( int32_t )value;
+        }
+        else
+        {
+            if( ReadVarint( &bits, &value ) == false )
+            {
+                return false;
+            }
+            sample[i] = decoder->Samples[reference][i] + UnZigZag( value );
+        }
+        values[i] = decoder->Fields[i].Min + sample[i] * decoder->Fields[i].Step;
+    }
+
+    memcpy1( ( uint8_t * )decoder->Samples[id], ( uint8_t * )sample, sizeof( decoder->Samples[id] ) );
+    decoder->Valid |= 1 << id;
+    return true;
+}
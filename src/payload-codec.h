@@ -0,0 +1,223 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Schema driven codec of the sensor samples sent in the uplinks
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __PAYLOAD_CODEC_H__
+#define __PAYLOAD_CODEC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Maximum number of fields of a schema
+ */
+#ifndef PAYLOAD_CODEC_MAX_FIELDS
+#define PAYLOAD_CODEC_MAX_FIELDS                    8
+#endif
+
+/*!
+ * Sample identifiers, the decoder keeps the last sample of each one
+ */
+#define PAYLOAD_CODEC_IDS                           16
+
+/*!
+ * Data bits of a varint group, each group is followed by a continuation bit
+ */
+#define PAYLOAD_CODEC_VARINT_BITS                   3
+
+/*!
+ * Field of a schema. The value is quantized to ( value - Min ) / Step,
+ * clamped to [Min, Max].
+ */
+typedef struct sPayloadCodecField
+{
+    float Min;
+    float Max;
+    float Step;
+}PayloadCodecField_t;
+
+/*!
+ * Encoder state. A frame is a bit stream, MSB first:
+ *
+ * - sample identifier (4 bits) and distance to the identifier of its
+ *   reference (4 bits), 0 without reference
+ * - without reference, each field quantized on the bits of its range
+ * - with reference, each field as a flag bit, then either the zig-zag
+ *   difference to the reference as a varint of PAYLOAD_CODEC_VARINT_BITS
+ *   groups, least significant first (flag 0), or quantized (flag 1)
+ *
+ * The reference is the last acknowledged sample, the decoder always has it.
+ * Once PAYLOAD_CODEC_IDS - 1 frames are encoded after it, its identifier may
+ * be reused and the frames are sent without reference until the next
+ * acknowledge.
+ */
+typedef struct sPayloadCodec
+{
+    const PayloadCodecField_t *Fields;
+    uint8_t NbFields;
+    /*!
+     * Identifier of the next sample
+     */
+    uint8_t Id;
+    /*!
+     * Last encoded sample, quantized, and its identifier
+     */
+    int32_t Last[PAYLOAD_CODEC_MAX_FIELDS];
+    uint8_t LastId;
+    bool LastValid;
+    /*!
+     * Last acknowledged sample, quantized, and its identifier
+     */
+    int32_t Reference[PAYLOAD_CODEC_MAX_FIELDS];
+    uint8_t ReferenceId;
+    bool ReferenceValid;
+    /*!
+     * Frames encoded after the reference, saturated
+     */
+    uint8_t SinceReference;
+}PayloadCodec_t;
+
+/*!
+ * Decoder state
+ */
+typedef struct sPayloadCodecDecoder
+{
+    const PayloadCodecField_t *Fields;
+    uint8_t NbFields;
+    /*!
+     * Last decoded sample of each identifier, quantized, and the identifiers
+     * having one
+     */
+    int32_t Samples[PAYLOAD_CODEC_IDS][PAYLOAD_CODEC_MAX_FIELDS];
+    uint16_t Valid;
+}PayloadCodecDecoder_t;
+
+/*!
+ * \brief Initializes an encoder. It is kept when already initialized with
+ *        the same schema, so that an encoder in RTC memory keeps its
+ *        reference across deep sleep.
+ *
+ * \param [IN] codec    Encoder
+ * \param [IN] fields   Schema
+ * \param [IN] nbFields Number of fields, up to PAYLOAD_CODEC_MAX_FIELDS
+ */
+void PayloadCodecInit( PayloadCodec_t *codec, const PayloadCodecField_t *fields, uint8_t nbFields );
+
+/*!
+ * \brief Encodes a sample, against the reference when it is smaller
+ *
+ * \param [IN]  codec   Encoder
+ * \param [IN]  values  Field values, in the schema order
+ * \param [OUT] buffer  Frame
+ * \param [IN]  maxSize Maximum frame size
+ *
+ * \retval size Frame size, 0 when it does not fit
+ */
+uint8_t PayloadCodecEncode( PayloadCodec_t *codec, const float *values, uint8_t *buffer, uint8_t maxSize );
+
+/*!
+ * \brief Makes the last encoded sample the reference, once its frame is
+ *        acknowledged
+ *
+ * \param [IN] codec Encoder
+ */
+void PayloadCodecAck( PayloadCodec_t *codec );
+
+/*!
+ * \brief Initializes a decoder
+ *
+ * \param [IN] decoder  Decoder
+ * \param [IN] fields   Schema
+ * \param [IN] nbFields Number of fields, up to PAYLOAD_CODEC_MAX_FIELDS
+ */
+void PayloadCodecDecoderInit( PayloadCodecDecoder_t *decoder, const PayloadCodecField_t *fields, uint8_t nbFields );
+
+/*!
+ * \brief Decodes a frame
+ *
+ * \param [IN]  decoder Decoder
+ * \param [IN]  buffer  Frame
+ * \param [IN]  size    Frame size
+ * \param [OUT] values  Field values, in the schema order
+ *
+ * \retval [false: frame too short or reference unknown, true: decoded]
+ */
+bool PayloadCodecDecode( PayloadCodecDecoder_t *decoder, const uint8_t *buffer, uint8_t size, float *values );
+
+/*!
+ * Schema declaration helpers. A schema is a list macro calling its argument
+ * once per field with the name, minimum, maximum and step, e.g.
+ *
+ *   #define WEATHER_FIELDS( FIELD )              \
+ *       FIELD( Temperature, -40.0f, 125.0f, 0.01f ) \
+ *       FIELD( Humidity,      0.0f, 100.0f, 0.1f )
+ *
+ *   PAYLOAD_CODEC_DEFINE( Weather, WEATHER_FIELDS )
+ *
+ * defines the WeatherSample_t structure, the WeatherFields schema and the
+ * WeatherEncode and WeatherDecode functions, taking the structure.
+ */
+#define PAYLOAD_CODEC_MEMBER( name, min, max, step )    float name;
+#define PAYLOAD_CODEC_FIELD( name, min, max, step )     { ( min ), ( max ), ( step ) },
+#define PAYLOAD_CODEC_LOAD( name, min, max, step )      sample->name,
+#define PAYLOAD_CODEC_STORE( name, min, max, step )     sample->name = values[i++];
+
+#define PAYLOAD_CODEC_DEFINE( codec, FIELDS )                                                       \
+    typedef struct                                                                                  \
+    {                                                                                               \
+        FIELDS( PAYLOAD_CODEC_MEMBER )                                                              \
+    }codec##Sample_t;                                                                               \
+                                                                                                    \
+    static const PayloadCodecField_t codec##Fields[] = { FIELDS( PAYLOAD_CODEC_FIELD ) };           \
+                                                                                                    \
+    static inline void codec##Init( PayloadCodec_t *state )                                         \
+    {                                                                                               \
+        PayloadCodecInit( state, codec##Fields, sizeof( codec##Fields ) / sizeof( codec##Fields[0] ) ); \
+    }                                                                                               \
+                                                                                                    \
+    static inline uint8_t codec##Encode( PayloadCodec_t *state, const codec##Sample_t *sample,      \
+                                         uint8_t *buffer, uint8_t maxSize )                         \
+    {                                                                                               \
+        const float values[] = { FIELDS( PAYLOAD_CODEC_LOAD ) };                                    \
+                                                                                                    \
+        return PayloadCodecEncode( state, values, buffer, maxSize );                                \
+    }                                                                                               \
+                                                                                                    \
+    static inline void codec##DecoderInit( PayloadCodecDecoder_t *state )                           \
+    {                                                                                               \
+        PayloadCodecDecoderInit( state, codec##Fields, sizeof( codec##Fields ) / sizeof( codec##Fields[0] ) ); \
+    }                                                                                               \
+                                                                                                    \
+    static inline bool codec##Decode( PayloadCodecDecoder_t *state, const uint8_t *buffer,          \
+                                      uint8_t size, codec##Sample_t *sample )                       \
+    {                                                                                               \
+        float values[PAYLOAD_CODEC_MAX_FIELDS];                                                     \
+        uint8_t i = 0;                                                                              \
+                                                                                                    \
+        if( PayloadCodecDecode( state, buffer, size, values ) == false )                            \
+        {                                                                                           \
+            return false;                                                                           \
+        }                                                                                           \
+        FIELDS( PAYLOAD_CODEC_STORE )                                                               \
+        return true;                                                                                \
+    }
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __PAYLOAD_CODEC_H__
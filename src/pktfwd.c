@@ -0,0 +1,851 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Single channel packet forwarder, Semtech UDP protocol v2
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Arduino.h>
+#include "radio.h"
+#include "timer.h"
+#include "utilities.h"
+#include "pktfwd.h"
+
+/*!
+ * Semtech UDP protocol version and datagram identifiers
+ */
+#define PKTFWD_PROTOCOL_VERSION                     2
+#define PKTFWD_PUSH_DATA                            0x00
+#define PKTFWD_PUSH_ACK                             0x01
+#define PKTFWD_PULL_DATA                            0x02
+#define PKTFWD_PULL_RESP                            0x03
+#define PKTFWD_PULL_ACK                             0x04
+#define PKTFWD_TX_ACK                               0x05
+
+/*!
+ * Datagram header size, version, token, identifier and gateway EUI
+ */
+#define PKTFWD_HEADER_SIZE                          12
+
+/*!
+ * Time before a downlink at which the radio is configured. PktFwdProcess
+ * then waits for the exact start time [us]
+ */
+#ifndef PKTFWD_TX_PREPARE_TIME
+#define PKTFWD_TX_PREPARE_TIME                      20000
+#endif
+
+/*!
+ * Time between Radio.Send and the start of the emission, FIFO write and
+ * PLL lock [us]
+ */
+#ifndef PKTFWD_TX_START_DELAY
+#define PKTFWD_TX_START_DELAY                       500
+#endif
+
+/*!
+ * Downlinks scheduled further ahead are rejected as TOO_EARLY [us]
+ */
+#define PKTFWD_TX_MAX_ADVANCE                       30000000
+
+/*!
+ * Radio TX timeout [ms]
+ */
+#define PKTFWD_TX_TIMEOUT                           15000
+
+/*!
+ * Downlink acceptance results, reported in TX_ACK
+ */
+typedef enum ePktFwdTxError
+{
+    PKTFWD_TX_NONE,
+    PKTFWD_TX_TOO_LATE,
+    PKTFWD_TX_TOO_EARLY,
+    PKTFWD_TX_COLLISION_PACKET,
+    PKTFWD_TX_FREQ,
+    PKTFWD_TX_GPS_UNLOCKED,
+    PKTFWD_TX_MALFORMED,
+}PktFwdTxError_t;
+
+static const char * const TxErrorNames[] =
+{
+    "NONE", "TOO_LATE", "TOO_EARLY", "COLLISION_PACKET", "TX_FREQ", "GPS_UNLOCKED",
+};
+
+typedef enum ePktFwdState
+{
+    PKTFWD_STATE_STOPPED,
+    PKTFWD_STATE_RX,
+    PKTFWD_STATE_TX,
+}PktFwdState_t;
+
+/*!
+ * Received packet waiting to be forwarded
+ */
+typedef struct sPktFwdUplink
+{
+    uint32_t Tmst;
+    int16_t Rssi;
+    int8_t Snr;
+    uint8_t Size;
+    uint8_t Payload[255];
+}PktFwdUplink_t;
+
+/*!
+ * Scheduled downlink
+ */
+typedef struct sPktFwdDownlink
+{
+    uint32_t Tmst;
+    uint32_t Duration;
+    uint32_t Frequency;
+    int8_t Power;
+    uint8_t SpreadingFactor;
+    uint8_t Bandwidth;
+    uint8_t Coderate;
+    uint16_t PreambleLen;
+    bool IqInverted;
+    bool CrcOn;
+    uint8_t Size;
+    uint8_t Payload[255];
+}PktFwdDownlink_t;
+
+static const char Base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static PktFwdParams_t Params;
+static PktFwdNetwork_t *Network;
+static RadioEvents_t PktFwdRadioEvents;
+static PktFwdStatistics_t Statistics;
+static PktFwdStatistics_t ReportBase;
+static PktFwdState_t State = PKTFWD_STATE_STOPPED;
+
+static PktFwdUplink_t Uplinks[PKTFWD_UPLINK_QUEUE_SIZE];
+static uint8_t UplinkHead;
+static uint8_t UplinkCount;
+
+/*!
+ * Downlinks, sorted by start time
+ */
+static PktFwdDownlink_t Downlinks[PKTFWD_DOWNLINK_QUEUE_SIZE];
+static uint8_t DownlinkCount;
+
+static uint16_t PushToken;
+static bool PushPending;
+static uint16_t PullToken;
+static bool PullPending;
+static TimerTime_t LastPull;
+static TimerTime_t LastStat;
+static bool PullSentOnce;
+
+static uint8_t Datagram[PKTFWD_DATAGRAM_SIZE];
+static char Json[PKTFWD_DATAGRAM_SIZE + 1];
+
+static void OnRadioTxDone( void );
+static void OnRadioTxTimeout( void );
+static void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr );
+static void OnRadioRxError( void );
+
+/*!
+ * \brief Computes the time on air of a LoRa frame, explicit header
+ *
+ * \retval duration Time on air [us]
+ */
+static uint32_t TimeOnAir( uint8_t sf, uint8_t bw, uint8_t cr, uint16_t preambleLen, uint8_t size, bool crcOn )
+{
+    bool lowDatarateOptimize = ( ( bw == 0 ) && ( sf >= 11 ) ) || ( ( bw == 1 ) && ( sf == 12 ) );
+    int32_t numerator = 8 * size - 4 * sf + 28 + ( crcOn ? 16 : 0 );
+    int32_t denominator = 4 * ( sf - ( lowDatarateOptimize ? 2 : 0 ) );
+    uint32_t payloadSymbols = 0;
+    uint32_t quarterSymbols;
+
+    if( numerator > 0 )
+    {
+        payloadSymbols = ( ( numerator + denominator - 1 ) / denominator ) * ( cr + 4 );
+    }
+    // Preamble, 4.25 sync symbols and 8 header symbols, in quarter symbols
+    quarterSymbols = 4 * ( preambleLen + 8 + payloadSymbols ) + 17;
+
+    return ( uint32_t )( ( ( uint64_t )quarterSymbols << sf ) * 1000000 / ( 4 * ( 125000UL << bw ) ) );
+}
+
+static uint16_t Base64Encode( const uint8_t *src, uint16_t size, char *dst )
+{
+    uint16_t out = 0;
+
+    for( uint16_t i = 0; i < size; i += 3 )
+    {
+        uint32_t block = ( uint32_t )src[i] << 16;
+
+        if( ( i + 1 ) < size )
+        {
+            block |= ( uint32_t )src[i + 1] << 8;
+        }
+        if( ( i + 2 ) < size )
+        {
+            block |= src[i + 2];
+        }
+        dst[out++] = Base64Chars[( block >> 18 ) & 0x3F];
+        dst[out++] = Base64Chars[( block >> 12 ) & 0x3F];
+        dst[out++] = ( ( i + 1 ) < size ) ? Base64Chars[( block >> 6 ) & 0x3F] : '=';
+        dst[out++] = ( ( i + 2 ) < size ) ? Base64Chars[block & 0x3F] : '=';
+    }
+    return out;
+}
+
+/*!
+ * \brief Decodes a base64 string, stops at the first non base64 character
+ *
+ * \retval size Decoded size, -1 when the result exceeds maxSize
+ */
+static int16_t Base64Decode( const char *src, uint8_t *dst, uint16_t maxSize )
+{
+    uint32_t block = 0;
+    uint8_t bits = 0;
+    int16_t size = 0;
+    const char *c;
+
+    for( ; *src != '\0'; src++ )
+    {
+        if( ( c = strchr( Base64Chars, *src ) ) == NULL )
+        {
+            break;
+        }
+        block = ( block << 6 ) | ( uint32_t )( c - Base64Chars );
+        bits += 6;
+        if( bits >= 8 )
+        {
+            bits -= 8;
+            if( size >= maxSize )
+            {
+                return -1;
+            }
+            dst[size++] = ( uint8_t )( block >> bits );
+        }
+    }
+    return size;
+}
+
+/*!
+ * \brief Finds the value of a JSON field
+ *
+ * \retval value First character of the value, NULL when the field is absent
+ */
+static const char* JsonFind( const char *json, const char *key )
+{
+    size_t len = strlen( key );
+    const char *p = json;
+
+    while( ( p = strstr( p, key ) ) != NULL )
+    {
+        if( ( p > json ) && ( p[-1] == '"' ) && ( p[len] == '"' ) )
+        {
+            const char *value = p + len + 1;
+
+            while( *value == ' ' )
+            {
+                value++;
+            }
+            if( *value == ':' )
+            {
+                value++;
+                while( *value == ' ' )
+                {
+                    value++;
+                }
+                return value;
+            }
+        }
+        p++;
+    }
+    return NULL;
+}
+
+static bool JsonGetInt( const char *json, const char *key, int32_t *value )
+{
+    const char *p = JsonFind( json, key );
+    char *end;
+
+    if( p == NULL )
+    {
+        return false;
+    }
+    *value = strtol( p, &end, 10 );
+    return ( end != p );
+}
+
+static bool JsonGetUint( const char *json, const char *key, uint32_t *value )
+{
+    const char *p = JsonFind( json, key );
+    char *end;
+
+    if( p == NULL )
+    {
+        return false;
+    }
+    *value = strtoul( p, &end, 10 );
+    return ( end != p );
+}
+
+static bool JsonGetBool( const char *json, const char *key )
+{
+    const char *p = JsonFind( json, key );
+
+    return ( p != NULL ) && ( strncmp( p, "true", 4 ) == 0 );
+}
+
+/*!
+ * \brief Returns a string value, without its quotes
+ */
+static const char* JsonGetString( const char *json, const char *key )
+{
+    const char *p = JsonFind( json, key );
+
+    if( ( p == NULL ) || ( *p != '"' ) )
+    {
+        return NULL;
+    }
+    return p + 1;
+}
+
+/*!
+ * \brief Reads a frequency given in MHz with up to 6 decimals
+ *
+ * \retval frequency Frequency [Hz], 0 when absent
+ */
+static uint32_t JsonGetFrequency( const char *json, const char *key )
+{
+    const char *p = JsonFind( json, key );
+    char *end;
+    uint32_t frequency;
+    uint32_t scale = 100000;
+
+    if( p == NULL )
+    {
+        return 0;
+    }
+    frequency = strtoul( p, &end, 10 ) * 1000000;
+    if( *end == '.' )
+    {
+        for( end++; ( *end >= '0' ) && ( *end <= '9' ) && ( scale > 0 ); end++ )
+        {
+            frequency += ( *end - '0' ) * scale;
+            scale /= 10;
+        }
+    }
+    return frequency;
+}
+
+/*!
+ * \brief Writes the datagram header
+ *
+ * \retval size Header size
+ */
+static uint16_t PrepareHeader( uint8_t identifier, uint16_t token )
+{
+    Datagram[0] = PKTFWD_PROTOCOL_VERSION;
+    Datagram[1] = token >> 8;
+    Datagram[2] = token & 0xFF;
+    Datagram[3] = identifier;
+    memcpy1( Datagram + 4, Params.GatewayEui, 8 );
+    return PKTFWD_HEADER_SIZE;
+}
+
+static uint16_t NewToken( void )
+{
+    return ( uint16_t )randr( 0, 0xFFFF );
+}
+
+static bool SendPushData( uint16_t size )
+{
+    uint16_t token = NewToken( );
+
+    PrepareHeader( PKTFWD_PUSH_DATA, token );
+    if( Network->Send( PKTFWD_SOCKET_UP, Datagram, size ) == false )
+    {
+        return false;
+    }
+    PushToken = token;
+    PushPending = true;
+    Statistics.PushSent++;
+    return true;
+}
+
+static void SendPullData( void )
+{
+    uint16_t token = NewToken( );
+
+    if( Network->Send( PKTFWD_SOCKET_DOWN, Datagram, PrepareHeader( PKTFWD_PULL_DATA, token ) ) == true )
+    {
+        PullToken = token;
+        PullPending = true;
+        Statistics.PullSent++;
+    }
+}
+
+static void SendTxAck( uint16_t token, PktFwdTxError_t error )
+{
+    uint16_t size = PrepareHeader( PKTFWD_TX_ACK, token );
+
+    size += snprintf( ( char* )Datagram + size, sizeof( Datagram ) - size,
+                      "{\"txpk_ack\":{\"error\":\"%s\"}}", TxErrorNames[error] );
+    Network->Send( PKTFWD_SOCKET_DOWN, Datagram, size );
+}
+
+/*!
+ * \brief Sends the oldest queued uplink in a PUSH_DATA
+ */
+static void ForwardUplink( void )
+{
+    PktFwdUplink_t *uplink = &Uplinks[UplinkHead];
+    uint16_t size = PKTFWD_HEADER_SIZE;
+
+    size += snprintf( ( char* )Datagram + size, sizeof( Datagram ) - size,
+                      "{\"rxpk\":[{\"tmst\":%lu,\"chan\":0,\"rfch\":0,\"freq\":%lu.%06lu,\"stat\":1,"
+                      "\"modu\":\"LORA\",\"datr\":\"SF%uBW%u\",\"codr\":\"4/%u\",\"rssi\":%d,\"lsnr\":%d,"
+                      "\"size\":%u,\"data\":\"",
+                      ( unsigned long )uplink->Tmst,
+                      ( unsigned long )( Params.Frequency / 1000000 ), ( unsigned long )( Params.Frequency % 1000000 ),
+                      Params.SpreadingFactor, 125 << Params.Bandwidth, Params.Coderate + 4,
+                      uplink->Rssi, uplink->Snr, uplink->Size );
+    size += Base64Encode( uplink->Payload, uplink->Size, ( char* )Datagram + size );
+    memcpy1( Datagram + size, ( const uint8_t* )"\"}]}", 4 );
+    size += 4;
+
+    if( SendPushData( size ) == true )
+    {
+        Statistics.RxForwarded++;
+    }
+    else
+    {
+        Statistics.RxDropped++;
+    }
+    UplinkHead = ( UplinkHead + 1 ) % PKTFWD_UPLINK_QUEUE_SIZE;
+    UplinkCount--;
+}
+
+/*!
+ * \brief Sends the status report, counters since the previous report
+ */
+static void SendStat( void )
+{
+    uint32_t pushSent = Statistics.PushSent - ReportBase.PushSent;
+    uint32_t ackRatio = ( pushSent != 0 ) ? ( ( Statistics.PushAcked - ReportBase.PushAcked ) * 1000 / pushSent ) : 0;
+    uint16_t size = PKTFWD_HEADER_SIZE;
+
+    size += snprintf( ( char* )Datagram + size, sizeof( Datagram ) - size,
+                      "{\"stat\":{\"rxnb\":%lu,\"rxok\":%lu,\"rxfw\":%lu,\"ackr\":%lu.%lu,\"dwnb\":%lu,\"txnb\":%lu}}",
+                      ( unsigned long )( Statistics.RxReceived - ReportBase.RxReceived ),
+                      ( unsigned long )( Statistics.RxOk - ReportBase.RxOk ),
+                      ( unsigned long )( Statistics.RxForwarded - ReportBase.RxForwarded ),
+                      ( unsigned long )( ackRatio / 10 ), ( unsigned long )( ackRatio % 10 ),
+                      ( unsigned long )( Statistics.DownlinksReceived - ReportBase.DownlinksReceived ),
+                      ( unsigned long )( Statistics.DownlinksSent - ReportBase.DownlinksSent ) );
+    ReportBase = Statistics;
+    SendPushData( size );
+}
+
+static void StartReception( void )
+{
+    Radio.SetChannel( Params.Frequency );
+    Radio.SetRxConfig( MODEM_LORA, Params.Bandwidth, Params.SpreadingFactor,
+                       Params.Coderate, 0, Params.PreambleLen,
+                       0, false, 0, true, 0, 0, false, true );
+    Radio.Rx( 0 );
+    State = PKTFWD_STATE_RX;
+}
+
+static void RemoveDownlink( uint8_t index )
+{
+    DownlinkCount--;
+    memmove( &Downlinks[index], &Downlinks[index + 1], ( DownlinkCount - index ) * sizeof( PktFwdDownlink_t ) );
+}
+
+/*!
+ * \brief Parses a txpk object and schedules the downlink
+ */
+static PktFwdTxError_t ScheduleDownlink( const char *json )
+{
+    PktFwdDownlink_t downlink;
+    const char *txpk = JsonFind( json, "txpk" );
+    const char *value;
+    uint32_t now = PktFwdGetTimestamp( );
+    uint32_t bandwidth;
+    uint32_t size;
+    int32_t power;
+    int32_t delta;
+    uint8_t index;
+
+    if( txpk == NULL )
+    {
+        return PKTFWD_TX_MALFORMED;
+    }
+
+    value = JsonGetString( txpk, "modu" );
+    if( ( value == NULL ) || ( strncmp( value, "LORA", 4 ) != 0 ) )
+    {
+        return PKTFWD_TX_MALFORMED;
+    }
+
+    // "SF9BW125"
+    value = JsonGetString( txpk, "datr" );
+    if( ( value == NULL ) || ( strncmp( value, "SF", 2 ) != 0 ) )
+    {
+        return PKTFWD_TX_MALFORMED;
+    }
+    downlink.SpreadingFactor = strtoul( value + 2, ( char** )&value, 10 );
+    if( ( strncmp( value, "BW", 2 ) != 0 ) || ( downlink.SpreadingFactor < 7 ) || ( downlink.SpreadingFactor > 12 ) )
+    {
+        return PKTFWD_TX_MALFORMED;
+    }
+    bandwidth = strtoul( value + 2, NULL, 10 );
+    if( bandwidth == 125 )
+    {
+        downlink.Bandwidth = 0;
+    }
+    else if( bandwidth == 250 )
+    {
+        downlink.Bandwidth = 1;
+    }
+    else if( bandwidth == 500 )
+    {
+        downlink.Bandwidth = 2;
+    }
+    else
+    {
+        return PKTFWD_TX_MALFORMED;
+    }
+
+    // "4/5"
+    value = JsonGetString( txpk, "codr" );
+    if( ( value == NULL ) || ( value[0] != '4' ) || ( value[1] != '/' ) || ( value[2] < '5' ) || ( value[2] > '8' ) )
+    {
+        return PKTFWD_TX_MALFORMED;
+    }
+    downlink.Coderate = value[2] - '4';
+
+    downlink.Frequency = JsonGetFrequency( txpk, "freq" );
+    if( ( downlink.Frequency == 0 ) || ( Radio.CheckRfFrequency( downlink.Frequency ) == false ) )
+    {
+        return PKTFWD_TX_FREQ;
+    }
+
+    downlink.Power = ( JsonGetInt( txpk, "powe", &power ) == true ) ? ( int8_t )power : 14;
+    downlink.PreambleLen = ( JsonGetUint( txpk, "prea", &size ) == true ) ? ( uint16_t )size : Params.PreambleLen;
+    downlink.IqInverted = JsonGetBool( txpk, "ipol" );
+    downlink.CrcOn = !JsonGetBool( txpk, "ncrc" );
+
+    value = JsonGetString( txpk, "data" );
+    if( value == NULL )
+    {
+        return PKTFWD_TX_MALFORMED;
+    }
+    delta = Base64Decode( value, downlink.Payload, sizeof( downlink.Payload ) );
+    if( ( delta < 0 ) || ( ( JsonGetUint( txpk, "size", &size ) == true ) && ( size != ( uint32_t )delta ) ) )
+    {
+        return PKTFWD_TX_MALFORMED;
+    }
+    downlink.Size = delta;
+    downlink.Duration = TimeOnAir( downlink.SpreadingFactor, downlink.Bandwidth, downlink.Coderate,
+                                   downlink.PreambleLen, downlink.Size, downlink.CrcOn );
+
+    if( JsonGetBool( txpk, "imme" ) == true )
+    {
+        downlink.Tmst = now + PKTFWD_TX_PREPARE_TIME;
+    }
+    else if( JsonGetUint( txpk, "tmst", &downlink.Tmst ) == false )
+    {
+        // GPS time scheduling, there is no GPS
+        return PKTFWD_TX_GPS_UNLOCKED;
+    }
+
+    delta = ( int32_t )( downlink.Tmst - now );
+    if( delta < PKTFWD_TX_START_DELAY )
+    {
+        return PKTFWD_TX_TOO_LATE;
+    }
+    if( delta > PKTFWD_TX_MAX_ADVANCE )
+    {
+        return PKTFWD_TX_TOO_EARLY;
+    }
+
+    // Sorted insert, rejects overlapping emissions
+    for( index = 0; index < DownlinkCount; index++ )
+    {
+        PktFwdDownlink_t *other = &Downlinks[index];
+
+        if( ( ( int32_t )( downlink.Tmst - ( other->Tmst + other->Duration ) ) < 0 ) &&
+            ( ( int32_t )( other->Tmst - ( downlink.Tmst + downlink.Duration ) ) < 0 ) )
+        {
+            return PKTFWD_TX_COLLISION_PACKET;
+        }
+        if( ( int32_t )( downlink.Tmst - other->Tmst ) < 0 )
+        {
+            break;
+        }
+    }
+    for( uint8_t i = index; i < DownlinkCount; i++ )
+    {
+        PktFwdDownlink_t *other = &Downlinks[i];
+
+        if( ( int32_t )( other->Tmst - ( downlink.Tmst + downlink.Duration ) ) < 0 )
+        {
+            return PKTFWD_TX_COLLISION_PACKET;
+        }
+    }
+    if( DownlinkCount >= PKTFWD_DOWNLINK_QUEUE_SIZE )
+    {
+        return PKTFWD_TX_COLLISION_PACKET;
+    }
+    memmove( &Downlinks[index + 1], &Downlinks[index], ( DownlinkCount - index ) * sizeof( PktFwdDownlink_t ) );
+    Downlinks[index] = downlink;
+    DownlinkCount++;
+    return PKTFWD_TX_NONE;
+}
+
+/*!
+ * \brief Starts the first downlink once it is due
+ */
+static void ProcessDownlinks( void )
+{
+    while( DownlinkCount > 0 )
+    {
+        PktFwdDownlink_t *downlink = &Downlinks[0];
+        int32_t delta = ( int32_t )( downlink->Tmst - PktFwdGetTimestamp( ) );
+
+        if( delta < PKTFWD_TX_START_DELAY )
+        {
+            // The main loop was held too long
+            Statistics.TxTooLate++;
+            RemoveDownlink( 0 );
+            continue;
+        }
+        if( delta > PKTFWD_TX_PREPARE_TIME )
+        {
+            return;
+        }
+
+        Radio.Standby( );
+        Radio.SetChannel( downlink->Frequency );
+        Radio.SetTxConfig( MODEM_LORA, downlink->Power, 0, downlink->Bandwidth,
+                           downlink->SpreadingFactor, downlink->Coderate,
+                           downlink->PreambleLen, false, downlink->CrcOn,
+                           0, 0, downlink->IqInverted, PKTFWD_TX_TIMEOUT );
+
+        while( ( int32_t )( downlink->Tmst - PKTFWD_TX_START_DELAY - PktFwdGetTimestamp( ) ) > 0 )
+        {
+        }
+        Radio.Send( downlink->Payload, downlink->Size );
+        State = PKTFWD_STATE_TX;
+        RemoveDownlink( 0 );
+        return;
+    }
+}
+
+static void OnRadioTxDone( void )
+{
+    Statistics.DownlinksSent++;
+    StartReception( );
+}
+
+static void OnRadioTxTimeout( void )
+{
+    Statistics.TxErrors++;
+    StartReception( );
+}
+
+static void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
+{
+    PktFwdUplink_t *uplink;
+
+    Statistics.RxReceived++;
+    Statistics.RxOk++;
+
+    if( UplinkCount >= PKTFWD_UPLINK_QUEUE_SIZE )
+    {
+        Statistics.RxDropped++;
+        return;
+    }
+    uplink = &Uplinks[( UplinkHead + UplinkCount ) % PKTFWD_UPLINK_QUEUE_SIZE];
+    // Time of the end of the packet, not of this event which may run late
+    uplink->Tmst = Radio.GetIrqTime( );
+    uplink->Rssi = rssi;
+    uplink->Snr = snr;
+    uplink->Size = size;
+    memcpy1( uplink->Payload, payload, size );
+    UplinkCount++;
+}
+
+static void OnRadioRxError( void )
+{
+    Statistics.RxReceived++;
+}
+
+bool PktFwdInit( PktFwdParams_t *params, PktFwdNetwork_t *network )
+{
+    if( ( params == NULL ) || ( network == NULL ) || ( network->Send == NULL ) ||
+        ( params->SpreadingFactor < 7 ) || ( params->SpreadingFactor > 12 ) ||
+        ( params->Bandwidth > 2 ) ||
+        ( params->Coderate < 1 ) || ( params->Coderate > 4 ) ||
+        ( params->KeepaliveInterval == 0 ) )
+    {
+        return false;
+    }
+    Params = *params;
+    Network = network;
+
+    PktFwdRadioEvents.TxDone = OnRadioTxDone;
+    PktFwdRadioEvents.TxTimeout = OnRadioTxTimeout;
+    PktFwdRadioEvents.RxDone = OnRadioRxDone;
+    PktFwdRadioEvents.RxError = OnRadioRxError;
+    Radio.Init( &PktFwdRadioEvents );
+    Radio.SetPublicNetwork( Params.PublicNetwork );
+
+    UplinkHead = 0;
+    UplinkCount = 0;
+    DownlinkCount = 0;
+    PushPending = false;
+    PullPending = false;
+    PullSentOnce = false;
+    LastStat = TimerGetCurrentTime( );
+    ReportBase = Statistics;
+
+    StartReception( );
+    return true;
+}
+
+void PktFwdStop( void )
+{
+    State = PKTFWD_STATE_STOPPED;
+    DownlinkCount = 0;
+    UplinkCount = 0;
+    Radio.Sleep( );
+}
+
+void PktFwdProcess( void )
+{
+    if( State == PKTFWD_STATE_STOPPED )
+    {
+        return;
+    }
+
+    Radio.IrqProcess( );
+
+    if( State == PKTFWD_STATE_RX )
+    {
+        ProcessDownlinks( );
+    }
+
+    // Network sends may block, keep them away from a due downlink
+    if( ( DownlinkCount > 0 ) &&
+        ( ( int32_t )( Downlinks[0].Tmst - PktFwdGetTimestamp( ) ) < 2 * PKTFWD_TX_PREPARE_TIME ) )
+    {
+        return;
+    }
+
+    while( UplinkCount > 0 )
+    {
+        ForwardUplink( );
+    }
+
+    if( ( PullSentOnce == false ) || ( TimerGetElapsedTime( LastPull ) >= Params.KeepaliveInterval ) )
+    {
+        PullSentOnce = true;
+        LastPull = TimerGetCurrentTime( );
+        SendPullData( );
+    }
+
+    if( ( Params.StatInterval != 0 ) && ( TimerGetElapsedTime( LastStat ) >= Params.StatInterval ) )
+    {
+        LastStat = TimerGetCurrentTime( );
+        SendStat( );
+    }
+}
+
+void PktFwdOnDatagram( PktFwdSocket_t socket, const uint8_t *buffer, uint16_t size )
+{
+    uint16_t token;
+    PktFwdTxError_t error;
+
+    if( ( State == PKTFWD_STATE_STOPPED ) || ( size < 4 ) || ( buffer[0] != PKTFWD_PROTOCOL_VERSION ) )
+    {
+        return;
+    }
+    token = ( ( uint16_t )buffer[1] << 8 ) | buffer[2];
+
+    switch( buffer[3] )
+    {
+        case PKTFWD_PUSH_ACK:
+            if( ( PushPending == true ) && ( token == PushToken ) )
+            {
+                PushPending = false;
+                Statistics.PushAcked++;
+            }
+            break;
+        case PKTFWD_PULL_ACK:
+            if( ( PullPending == true ) && ( token == PullToken ) )
+            {
+                PullPending = false;
+                Statistics.PullAcked++;
+            }
+            break;
+        case PKTFWD_PULL_RESP:
+            Statistics.DownlinksReceived++;
+            size = MIN( size - 4, PKTFWD_DATAGRAM_SIZE );
+            memcpy1( ( uint8_t* )Json, buffer + 4, size );
+            Json[size] = '\0';
+
+            error = ScheduleDownlink( Json );
+            switch( error )
+            {
+                case PKTFWD_TX_NONE:
+                    break;
+                case PKTFWD_TX_TOO_LATE:
+                    Statistics.TxTooLate++;
+                    break;
+                case PKTFWD_TX_TOO_EARLY:
+                    Statistics.TxTooEarly++;
+                    break;
+                case PKTFWD_TX_COLLISION_PACKET:
+                    Statistics.TxCollisions++;
+                    break;
+                default:
+                    Statistics.TxErrors++;
+                    break;
+            }
+            // Malformed requests are not acknowledged
+            if( error != PKTFWD_TX_MALFORMED )
+            {
+                SendTxAck( token, error );
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+uint32_t PktFwdGetTimestamp( void )
+{
+    return micros( );
+}
+
+PktFwdStatistics_t* PktFwdGetStatistics( void )
+{
+    return &Statistics;
+}
+
+void PktFwdResetStatistics( void )
+{
+    memset1( ( uint8_t* )&Statistics, 0, sizeof( Statistics ) );
+    ReportBase = Statistics;
+}
@@ -0,0 +1,242 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Single channel packet forwarder, Semtech UDP protocol v2
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __PKTFWD_H__
+#define __PKTFWD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Received packets waiting to be forwarded. The newest packets are dropped
+ * when the queue is full.
+ */
+#ifndef PKTFWD_UPLINK_QUEUE_SIZE
+#define PKTFWD_UPLINK_QUEUE_SIZE                    8
+#endif
+
+/*!
+ * Scheduled downlinks
+ */
+#ifndef PKTFWD_DOWNLINK_QUEUE_SIZE
+#define PKTFWD_DOWNLINK_QUEUE_SIZE                  4
+#endif
+
+/*!
+ * Largest datagram sent or accepted, a 255 bytes payload with its JSON
+ * object fits
+ */
+#define PKTFWD_DATAGRAM_SIZE                        768
+
+/*!
+ * Gateway sockets. Semtech servers expect the uplinks and the downlink
+ * polling on two UDP sockets, usually both to port 1700.
+ */
+typedef enum ePktFwdSocket
+{
+    /*!
+     * PUSH_DATA, the server answers PUSH_ACK
+     */
+    PKTFWD_SOCKET_UP,
+    /*!
+     * PULL_DATA and TX_ACK, the server answers PULL_ACK and PULL_RESP
+     */
+    PKTFWD_SOCKET_DOWN,
+}PktFwdSocket_t;
+
+/*!
+ * Forwarder parameters
+ */
+typedef struct sPktFwdParams
+{
+    /*!
+     * Gateway EUI, MSB first
+     */
+    uint8_t GatewayEui[8];
+    /*!
+     * Listening RF frequency [Hz]
+     */
+    uint32_t Frequency;
+    /*!
+     * Listening spreading factor [7..12]
+     */
+    uint8_t SpreadingFactor;
+    /*!
+     * Listening bandwidth [0: 125 kHz, 1: 250 kHz, 2: 500 kHz]
+     */
+    uint8_t Bandwidth;
+    /*!
+     * Coding rate [1: 4/5, 2: 4/6, 3: 4/7, 4: 4/8]
+     */
+    uint8_t Coderate;
+    /*!
+     * Preamble length, uplinks and downlinks [symbols]
+     */
+    uint16_t PreambleLen;
+    /*!
+     * LoRaWAN public network sync word
+     */
+    bool PublicNetwork;
+    /*!
+     * PULL_DATA period [ms]
+     */
+    uint32_t KeepaliveInterval;
+    /*!
+     * Status report period [ms], 0 disables the reports
+     */
+    uint32_t StatInterval;
+}PktFwdParams_t;
+
+/*!
+ * Network interface, implemented by the application
+ */
+typedef struct sPktFwdNetwork
+{
+    /*!
+     * \brief Sends a datagram to the server
+     *
+     * \param [IN] socket Gateway socket
+     * \param [IN] buffer Datagram
+     * \param [IN] size   Datagram size
+     *
+     * \retval status [true: sent, false: network error]
+     */
+    bool ( *Send )( PktFwdSocket_t socket, const uint8_t *buffer, uint16_t size );
+}PktFwdNetwork_t;
+
+/*!
+ * Forwarder statistics
+ */
+typedef struct sPktFwdStatistics
+{
+    /*!
+     * Packets received, CRC errors included
+     */
+    uint32_t RxReceived;
+    /*!
+     * Packets received with a valid CRC
+     */
+    uint32_t RxOk;
+    /*!
+     * Packets sent to the server
+     */
+    uint32_t RxForwarded;
+    /*!
+     * Packets dropped because the uplink queue was full or the network failed
+     */
+    uint32_t RxDropped;
+    /*!
+     * PUSH_DATA datagrams sent, status reports included
+     */
+    uint32_t PushSent;
+    /*!
+     * PUSH_ACK received for the last PUSH_DATA
+     */
+    uint32_t PushAcked;
+    /*!
+     * PULL_DATA datagrams sent
+     */
+    uint32_t PullSent;
+    /*!
+     * PULL_ACK received for the last PULL_DATA
+     */
+    uint32_t PullAcked;
+    /*!
+     * PULL_RESP received
+     */
+    uint32_t DownlinksReceived;
+    /*!
+     * Downlinks transmitted
+     */
+    uint32_t DownlinksSent;
+    /*!
+     * Downlinks rejected or dropped because their time had passed
+     */
+    uint32_t TxTooLate;
+    /*!
+     * Downlinks rejected because their time was too far ahead
+     */
+    uint32_t TxTooEarly;
+    /*!
+     * Downlinks rejected because they overlapped a scheduled one or the
+     * queue was full
+     */
+    uint32_t TxCollisions;
+    /*!
+     * Downlinks rejected for their parameters, malformed PULL_RESP included
+     */
+    uint32_t TxErrors;
+}PktFwdStatistics_t;
+
+/*!
+ * \brief Initializes the forwarder, takes over the radio events and starts
+ *        the continuous reception. The radio must not be used by the
+ *        LoRaWAN stack at the same time.
+ *
+ * \param [IN] params  Forwarder parameters, copied
+ * \param [IN] network Network interface, must stay valid
+ *
+ * \retval status [true: ok, false: invalid parameters]
+ */
+bool PktFwdInit( PktFwdParams_t *params, PktFwdNetwork_t *network );
+
+/*!
+ * \brief Stops the forwarder and puts the radio to sleep
+ */
+void PktFwdStop( void );
+
+/*!
+ * \brief Runs the radio events, forwards the queued uplinks, starts the
+ *        downlinks that are due and sends the keepalives. Must be called
+ *        from the main loop as often as possible. Received packets are
+ *        timestamped by the radio IRQ, a late call only delays them.
+ *
+ * \remark Waits up to PKTFWD_TX_PREPARE_TIME when a downlink is about to
+ *         start, to start it at its exact time.
+ */
+void PktFwdProcess( void );
+
+/*!
+ * \brief Handles a datagram received from the server
+ *
+ * \param [IN] socket Gateway socket the datagram arrived on
+ * \param [IN] buffer Datagram
+ * \param [IN] size   Datagram size
+ */
+void PktFwdOnDatagram( PktFwdSocket_t socket, const uint8_t *buffer, uint16_t size );
+
+/*!
+ * \brief Returns the concentrator counter used for the tmst fields [us]
+ */
+uint32_t PktFwdGetTimestamp( void );
+
+/*!
+ * \brief Returns the forwarder statistics
+ */
+PktFwdStatistics_t* PktFwdGetStatistics( void );
+
+/*!
+ * \brief Clears the forwarder statistics
+ */
+void PktFwdResetStatistics( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PKTFWD_H__
@@ -46,6 +46,38 @@ typedef enum
     RF_CAD,        //!< The radio is doing channel activity detection
 }RadioState_t;
 
+/*!
+ * Radio capabilities, returned by Radio.GetCapabilities
+ */
+/*!
+ * RxBoosted is available
+ */
+#define RADIO_CAP_RX_BOOSTED                        ( 1 << 0 )
+/*!
+ * SetRxDutyCycle is available, the radio alternates reception and sleep by
+ * itself
+ */
+#define RADIO_CAP_RX_DUTY_CYCLE                     ( 1 << 1 )
+/*!
+ * StartCadRx is available, the radio goes from CAD to reception by itself
+ * when activity is detected
+ */
+#define RADIO_CAP_CAD_TO_RX                         ( 1 << 2 )
+/*!
+ * The Tx and Rx timeouts are counted by the radio, no MCU timer runs
+ */
+#define RADIO_CAP_HW_TIMEOUT                        ( 1 << 3 )
+/*!
+ * Commands are handshaked on the radio BUSY line, the radio is woken up
+ * from sleep by the next access
+ */
+#define RADIO_CAP_BUSY_PIN                          ( 1 << 4 )
+/*!
+ * The FSK packets are moved through a FIFO refilled by the driver during the
+ * reception and the transmission, larger packets take more interrupts
+ */
+#define RADIO_CAP_FSK_FIFO                          ( 1 << 5 )
+
 /*!
  * \brief Radio driver callback functions
  */
@@ -343,6 +375,21 @@ struct Radio_s
      * \brief Process radio irq
      */
     void ( *IrqProcess )( void );
+    /*!
+     * \brief Starts the receiver on the given channel for RSSI measurements
+     *        and returns. No packet is received, Rssi reads the channel
+     *        power until Standby or Sleep is called.
+     *
+     * \param [IN] modem      Radio modem to be used [0: FSK, 1: LoRa]
+     * \param [IN] freq       Channel RF frequency
+     */
+    void    ( *StartCarrierSense )( RadioModems_t modem, uint32_t freq );
+    /*!
+     * \brief Returns the features of the radio
+     *
+     * \retval capabilities RADIO_CAP_xxx flags
+     */
+    uint32_t ( *GetCapabilities )( void );
     /*
      * The next functions are available only on SX126x radios.
      */
@@ -360,10 +407,28 @@ struct Radio_s
      *
      * \remark Available on SX126x radios only.
      *
-     * \param [in]  rxTime        Structure describing reception timeout value
-     * \param [in]  sleepTime     Structure describing sleep timeout value
+     * \param [in]  rxTime        Reception time [15.625 us steps]
+     * \param [in]  sleepTime     Sleep time [15.625 us steps]
      */
     void ( *SetRxDutyCycle ) ( uint32_t rxTime, uint32_t sleepTime );
+    /*!
+     * \brief Starts a Channel Activity Detection followed by a reception
+     *        when activity is detected. CadDone is called at the end of
+     *        the CAD, then RxDone, RxError or RxTimeout if activity was
+     *        detected.
+     *
+     * \remark Available on SX126x radios only.
+     *
+     * \param [IN] timeout Reception timeout [ms]
+     */
+    void    ( *StartCadRx )( uint32_t timeout );
+    /*!
+     * \brief Returns the time of the IRQ edge of the last TxDone or RxDone,
+     *        latched before the event is processed
+     *
+     * \retval time micros( ) at the IRQ [us]
+     */
+    uint32_t ( *GetIrqTime )( void );
 };
 
 /*!
@@ -27,12 +27,15 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 
 #include "timer.h"
 #include "LoRaMac.h"
+#include "LoRaMacCtx.h"
 
 
 
 // Regional includes
 #include "Region.h"
 
+RegionCtx_t *RegionCtx = &LoRaMacDefaultCtx.Region;
+
 
 
 // Setup regions
@@ -112,6 +115,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #define AU915_ALTERNATE_DR( )                      AU915_CASE { return RegionAU915AlternateDr( alternateDr ); }
 #define AU915_CALC_BACKOFF( )                      AU915_CASE { RegionAU915CalcBackOff( calcBackOff ); break; }
 #define AU915_NEXT_CHANNEL( )                      AU915_CASE { return RegionAU915NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define AU915_JOIN_ACCEPTED( )                     AU915_CASE { RegionAU915JoinAccepted( channel ); break; }
 #define AU915_CHANNEL_ADD( )                       AU915_CASE { return RegionAU915ChannelAdd( channelAdd ); }
 #define AU915_CHANNEL_REMOVE( )                    AU915_CASE { return RegionAU915ChannelsRemove( channelRemove ); }
 #define AU915_SET_CONTINUOUS_WAVE( )               AU915_CASE { RegionAU915SetContinuousWave( continuousWave ); break; }
@@ -137,6 +141,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #define AU915_ALTERNATE_DR( )
 #define AU915_CALC_BACKOFF( )
 #define AU915_NEXT_CHANNEL( )
+#define AU915_JOIN_ACCEPTED( )
 #define AU915_CHANNEL_ADD( )
 #define AU915_CHANNEL_REMOVE( )
 #define AU915_SET_CONTINUOUS_WAVE( )
@@ -544,6 +549,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #define US915_ALTERNATE_DR( )                      US915_CASE { return RegionUS915AlternateDr( alternateDr ); }
 #define US915_CALC_BACKOFF( )                      US915_CASE { RegionUS915CalcBackOff( calcBackOff ); break; }
 #define US915_NEXT_CHANNEL( )                      US915_CASE { return RegionUS915NextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define US915_JOIN_ACCEPTED( )                     US915_CASE { RegionUS915JoinAccepted( channel ); break; }
 #define US915_CHANNEL_ADD( )                       US915_CASE { return RegionUS915ChannelAdd( channelAdd ); }
 #define US915_CHANNEL_REMOVE( )                    US915_CASE { return RegionUS915ChannelsRemove( channelRemove ); }
 #define US915_SET_CONTINUOUS_WAVE( )               US915_CASE { RegionUS915SetContinuousWave( continuousWave ); break; }
@@ -569,6 +575,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #define US915_ALTERNATE_DR( )
 #define US915_CALC_BACKOFF( )
 #define US915_NEXT_CHANNEL( )
+#define US915_JOIN_ACCEPTED( )
 #define US915_CHANNEL_ADD( )
 #define US915_CHANNEL_REMOVE( )
 #define US915_SET_CONTINUOUS_WAVE( )
@@ -598,6 +605,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #define US915_HYBRID_ALTERNATE_DR( )                      US915_HYBRID_CASE { return RegionUS915HybridAlternateDr( alternateDr ); }
 #define US915_HYBRID_CALC_BACKOFF( )                      US915_HYBRID_CASE { RegionUS915HybridCalcBackOff( calcBackOff ); break; }
 #define US915_HYBRID_NEXT_CHANNEL( )                      US915_HYBRID_CASE { return RegionUS915HybridNextChannel( nextChanParams, channel, time, aggregatedTimeOff ); }
+#define US915_HYBRID_JOIN_ACCEPTED( )                     US915_HYBRID_CASE { RegionUS915HybridJoinAccepted( channel ); break; }
 #define US915_HYBRID_CHANNEL_ADD( )                       US915_HYBRID_CASE { return RegionUS915HybridChannelAdd( channelAdd ); }
 #define US915_HYBRID_CHANNEL_REMOVE( )                    US915_HYBRID_CASE { return RegionUS915HybridChannelsRemove( channelRemove ); }
 #define US915_HYBRID_SET_CONTINUOUS_WAVE( )               US915_HYBRID_CASE { RegionUS915HybridSetContinuousWave( continuousWave ); break; }
@@ -623,6 +631,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #define US915_HYBRID_ALTERNATE_DR( )
 #define US915_HYBRID_CALC_BACKOFF( )
 #define US915_HYBRID_NEXT_CHANNEL( )
+#define US915_HYBRID_JOIN_ACCEPTED( )
 #define US915_HYBRID_CHANNEL_ADD( )
 #define US915_HYBRID_CHANNEL_REMOVE( )
 #define US915_HYBRID_SET_CONTINUOUS_WAVE( )
@@ -630,6 +639,11 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #define US915_HYBRID_RX_BEACON_SETUP( )
 #endif
 
+void RegionSetContext( RegionCtx_t *ctx )
+{
+    RegionCtx = ctx;
+}
+
 bool RegionIsActive( LoRaMacRegion_t region )
 {
     switch( region )
@@ -1049,6 +1063,20 @@ bool RegionNextChannel( LoRaMacRegion_t region, NextChanParams_t* nextChanParams
     }
 }
 
+void RegionJoinAccepted( LoRaMacRegion_t region, uint8_t channel )
+{
+    switch( region )
+    {
+        AU915_JOIN_ACCEPTED( );
+        US915_JOIN_ACCEPTED( );
+        US915_HYBRID_JOIN_ACCEPTED( );
+        default:
+        {
+            break;
+        }
+    }
+}
+
 LoRaMacStatus_t RegionChannelAdd( LoRaMacRegion_t region, ChannelAddParams_t* channelAdd )
 {
     switch( region )
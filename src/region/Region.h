@@ -878,6 +878,10 @@ typedef struct sSetBandTxDoneParams {
      * Last TX done time.
      */
     TimerTime_t LastTxDoneTime;
+    /*!
+     * Time on air of the last TX.
+     */
+    TimerTime_t LastTxAirTime;
 } SetBandTxDoneParams_t;
 
 /*!
@@ -1021,6 +1025,10 @@ typedef struct sRxConfigParams {
      * Sets the RX window.
      */
     LoRaMacRxSlot_t RxSlot;
+    /*!
+     * Modem the window was opened with, set by RegionRxConfig.
+     */
+    RadioModems_t Modem;
 #ifdef CONFIG_LINKWAN
     /*!
      * Node current Work Mode
@@ -1322,6 +1330,75 @@ typedef struct sRxBeaconSetupParams
     uint32_t Frequency;
 }RxBeaconSetup_t;
 
+/*!
+ * Largest channel plan of the active regions
+ */
+#if defined( REGION_CN470 )
+#define REGION_CTX_MAX_NB_CHANNELS                  96
+#elif defined( REGION_US915 ) || defined( REGION_US915_HYBRID ) || defined( REGION_AU915 ) || defined( REGION_LA915 )
+#define REGION_CTX_MAX_NB_CHANNELS                  72
+#else
+#define REGION_CTX_MAX_NB_CHANNELS                  16
+#endif
+
+/*!
+ * Largest number of bands of the regions, EU868
+ */
+#define REGION_CTX_MAX_NB_BANDS                     5
+
+/*!
+ * Largest channels mask size of the regions
+ */
+#define REGION_CTX_CHANNELS_MASK_SIZE               6
+
+/*!
+ * Region state of one LoRaMac context
+ */
+typedef struct sRegionCtx
+{
+    /*!
+     * LoRaMAC channels
+     */
+    ChannelParams_t Channels[REGION_CTX_MAX_NB_CHANNELS];
+    /*!
+     * LoRaMac bands
+     */
+    Band_t Bands[REGION_CTX_MAX_NB_BANDS];
+    /*!
+     * LoRaMac channels mask
+     */
+    uint16_t ChannelsMask[REGION_CTX_CHANNELS_MASK_SIZE];
+    /*!
+     * LoRaMac channels remaining, regions with 72 or 96 channels
+     */
+    uint16_t ChannelsMaskRemaining[REGION_CTX_CHANNELS_MASK_SIZE];
+    /*!
+     * LoRaMac channels default mask
+     */
+    uint16_t ChannelsDefaultMask[REGION_CTX_CHANNELS_MASK_SIZE];
+    /*!
+     * Subband of the next join request, regions with 8 subbands. Not reset
+     * at initialization, a device rejoins on the subband that last worked.
+     */
+    uint8_t JoinSubBand;
+    /*!
+     * Join requests already sent on JoinSubBand
+     */
+    uint8_t JoinSubBandTrials;
+}RegionCtx_t;
+
+/*!
+ * Region state the region functions work on, bound by the MAC
+ */
+extern RegionCtx_t *RegionCtx;
+
+/*!
+ * \brief Makes the region functions work on a context
+ *
+ * \param [IN] ctx Region state of a LoRaMac context
+ */
+void RegionSetContext( RegionCtx_t *ctx );
+
 
 
 /*!
@@ -1594,6 +1671,17 @@ void RegionCalcBackOff( LoRaMacRegion_t region, CalcBackOffParams_t *calcBackOff
 bool RegionNextChannel( LoRaMacRegion_t region, NextChanParams_t *nextChanParams, uint8_t *channel, TimerTime_t *time,
                         TimerTime_t *aggregatedTimeOff );
 
+/*!
+ * \brief Tells the region the channel a join request was accepted on. The
+ *        US915, AU915 and US915 Hybrid join requests rotate through the
+ *        subbands, the next ones start on the subband of that channel.
+ *
+ * \param [IN] region LoRaWAN region.
+ *
+ * \param [IN] channel Channel of the accepted join request.
+ */
+void RegionJoinAccepted( LoRaMacRegion_t region, uint8_t channel );
+
 /*!
  * \brief Adds a channel.
  *
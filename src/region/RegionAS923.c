@@ -29,6 +29,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 #include "radio.h"
 #include "timer.h"
 #include "LoRaMac.h"
+#include "LoRaMacLbt.h"
 
 #include "utilities.h"
 
@@ -42,28 +43,13 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 
 // Global attributes
 /*!
- * LoRaMAC channels
+ * LoRaMac bands, copied to the context at initialization
  */
-RTC_DATA_ATTR static ChannelParams_t Channels[AS923_MAX_NB_CHANNELS];
-
-/*!
- * LoRaMac bands
- */
-RTC_DATA_ATTR static Band_t Bands[AS923_MAX_NB_BANDS] =
+static const Band_t BandsDefault[AS923_MAX_NB_BANDS] =
 {
     AS923_BAND0
 };
 
-/*!
- * LoRaMac channels mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsMask[CHANNELS_MASK_SIZE];
-
-/*!
- * LoRaMac channels default mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsDefaultMask[CHANNELS_MASK_SIZE];
-
 // Static functions
 static int8_t GetNextLowerTxDr( int8_t dr, int8_t minDr )
 {
@@ -293,12 +279,12 @@ PhyParam_t RegionAS923GetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS_MASK:
         {
-            phyParam.ChannelsMask = ChannelsMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsMask;
             break;
         }
         case PHY_CHANNELS_DEFAULT_MASK:
         {
-            phyParam.ChannelsMask = ChannelsDefaultMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsDefaultMask;
             break;
         }
         case PHY_MAX_NB_CHANNELS:
@@ -308,7 +294,7 @@ PhyParam_t RegionAS923GetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS:
         {
-            phyParam.Channels = Channels;
+            phyParam.Channels = RegionCtx->Channels;
             break;
         }
         case PHY_DEF_UPLINK_DWELL_TIME:
@@ -365,7 +351,7 @@ PhyParam_t RegionAS923GetPhyParam( GetPhyParams_t* getPhy )
 
 void RegionAS923SetBandTxDone( SetBandTxDoneParams_t* txDone )
 {
-    RegionCommonSetBandTxDone( txDone->Joined, &Bands[Channels[txDone->Channel].Band], txDone->LastTxDoneTime );
+    RegionCommonSetBandTxDone( txDone->Joined, &RegionCtx->Bands[RegionCtx->Channels[txDone->Channel].Band], txDone->LastTxDoneTime, txDone->LastTxAirTime );
 }
 
 void RegionAS923InitDefaults( InitType_t type )
@@ -374,20 +360,23 @@ void RegionAS923InitDefaults( InitType_t type )
     {
         case INIT_TYPE_INIT:
         {
+            // Bands
+            memcpy( RegionCtx->Bands, BandsDefault, sizeof( BandsDefault ) );
+
             // Channels
-            Channels[0] = ( ChannelParams_t ) AS923_LC1;
-            Channels[1] = ( ChannelParams_t ) AS923_LC2;
+            RegionCtx->Channels[0] = ( ChannelParams_t ) AS923_LC1;
+            RegionCtx->Channels[1] = ( ChannelParams_t ) AS923_LC2;
 
             // Initialize the channels default mask
-            ChannelsDefaultMask[0] = LC( 1 ) + LC( 2 );
+            RegionCtx->ChannelsDefaultMask[0] = LC( 1 ) + LC( 2 );
             // Update the channels mask
-            RegionCommonChanMaskCopy( ChannelsMask, ChannelsDefaultMask, 1 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, RegionCtx->ChannelsDefaultMask, 1 );
             break;
         }
         case INIT_TYPE_RESTORE:
         {
             // Restore channels default mask
-            ChannelsMask[0] |= ChannelsDefaultMask[0];
+            RegionCtx->ChannelsMask[0] |= RegionCtx->ChannelsDefaultMask[0];
             break;
         }
         default:
@@ -505,12 +494,12 @@ bool RegionAS923ChanMaskSet( ChanMaskSetParams_t* chanMaskSet )
     {
         case CHANNELS_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsMask, chanMaskSet->ChannelsMaskIn, 1 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, chanMaskSet->ChannelsMaskIn, 1 );
             break;
         }
         case CHANNELS_DEFAULT_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 1 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 1 );
             break;
         }
         default:
@@ -576,7 +565,7 @@ bool RegionAS923AdrNext( AdrNextParams_t* adrNext, int8_t* drOut, int8_t* txPowO
                         if( adrNext->UpdateChanMask == true )
                         {
                             // Re-enable default channels
-                            ChannelsMask[0] |= LC( 1 ) + LC( 2 );
+                            RegionCtx->ChannelsMask[0] |= LC( 1 ) + LC( 2 );
                         }
                     }
                 }
@@ -626,11 +615,11 @@ bool RegionAS923RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
     if( rxConfig->RxSlot == RX_SLOT_WIN_1 )
     {
         // Apply window 1 frequency
-        frequency = Channels[rxConfig->Channel].Frequency;
+        frequency = RegionCtx->Channels[rxConfig->Channel].Frequency;
         // Apply the alternative RX 1 window frequency, if it is available
-        if( Channels[rxConfig->Channel].Rx1Frequency != 0 )
+        if( RegionCtx->Channels[rxConfig->Channel].Rx1Frequency != 0 )
         {
-            frequency = Channels[rxConfig->Channel].Rx1Frequency;
+            frequency = RegionCtx->Channels[rxConfig->Channel].Rx1Frequency;
         }
     }
 
@@ -650,6 +639,7 @@ bool RegionAS923RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
         modem = MODEM_LORA;
         Radio.SetRxConfig( modem, rxConfig->Bandwidth, phyDr, 1, 0, 8, rxConfig->WindowTimeout, false, 0, false, 0, 0, true, rxConfig->RxContinuous );
     }
+    rxConfig->Modem = modem;
 
         // Check for repeater support
         if( rxConfig->RepeaterSupport == true )
@@ -672,7 +662,7 @@ bool RegionAS923TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
 {
     RadioModems_t modem;
     int8_t phyDr = DataratesAS923[txConfig->Datarate];
-    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, Bands[Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, RegionCtx->Bands[RegionCtx->Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, RegionCtx->ChannelsMask );
     uint32_t bandwidth = GetBandwidth( txConfig->Datarate );
     int8_t phyTxPower = 0;
 
@@ -680,7 +670,7 @@ bool RegionAS923TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, txConfig->MaxEirp, txConfig->AntennaGain );
 
     // Setup the radio frequency
-    Radio.SetChannel( Channels[txConfig->Channel].Frequency );
+    Radio.SetChannel( RegionCtx->Channels[txConfig->Channel].Frequency );
 
     if( txConfig->Datarate == DR_7 )
     { // High Speed FSK channel
@@ -692,7 +682,7 @@ bool RegionAS923TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
         modem = MODEM_LORA;
         Radio.SetTxConfig( modem, phyTxPower, 0, bandwidth, phyDr, 1, LORAWAN_PREAMBLE_LENGTH, false, true, 0, 0, false, 3e3 );
     }
-    DBG_PRINTF("TX on freq %u Hz at DR %d\r\n", (unsigned int)Channels[txConfig->Channel].Frequency, txConfig->Datarate);
+    DBG_PRINTF("TX on freq %u Hz at DR %d\r\n", (unsigned int)RegionCtx->Channels[txConfig->Channel].Frequency, txConfig->Datarate);
     // Setup maximum payload lenght of the radio driver
     Radio.SetMaxPayloadLength( modem, txConfig->PktLen );
     // Get the time-on-air of the next tx frame
@@ -744,7 +734,7 @@ uint8_t RegionAS923LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
             {
                 if( linkAdrParams.ChMaskCtrl == 6 )
                 {
-                    if( Channels[i].Frequency != 0 )
+                    if( RegionCtx->Channels[i].Frequency != 0 )
                     {
                         chMask |= 1 << i;
                     }
@@ -752,7 +742,7 @@ uint8_t RegionAS923LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
                 else
                 {
                     if( ( ( chMask & ( 1 << i ) ) != 0 ) &&
-                        ( Channels[i].Frequency == 0 ) )
+                        ( RegionCtx->Channels[i].Frequency == 0 ) )
                     {// Trying to enable an undefined channel
                         status &= 0xFE; // Channel mask KO
                     }
@@ -762,7 +752,7 @@ uint8_t RegionAS923LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
     }
 
     // Verify datarate
-    if( RegionCommonChanVerifyDr( AS923_MAX_NB_CHANNELS, &chMask, linkAdrParams.Datarate, AS923_TX_MIN_DATARATE, AS923_TX_MAX_DATARATE, Channels  ) == false )
+    if( RegionCommonChanVerifyDr( AS923_MAX_NB_CHANNELS, &chMask, linkAdrParams.Datarate, AS923_TX_MIN_DATARATE, AS923_TX_MAX_DATARATE, RegionCtx->Channels  ) == false )
     {
         status &= 0xFD; // Datarate KO
     }
@@ -790,9 +780,9 @@ uint8_t RegionAS923LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
         }
 
         // Set the channels mask to a default value
-        memset( ChannelsMask, 0, sizeof( ChannelsMask ) );
+        memset( RegionCtx->ChannelsMask, 0, sizeof( RegionCtx->ChannelsMask ) );
         // Update the channels mask
-        ChannelsMask[0] = chMask;
+        RegionCtx->ChannelsMask[0] = chMask;
     }
 
     // Update status variables
@@ -892,6 +882,11 @@ uint8_t RegionAS923DlChannelReq( DlChannelReqParams_t* dlChannelReq )
 {
     uint8_t status = 0x03;
 
+    if( dlChannelReq->ChannelId >= AS923_MAX_NB_CHANNELS )
+    {
+        return 0;
+    }
+
     // Verify if the frequency is supported
     if( VerifyTxFreq( dlChannelReq->Rx1Frequency ) == false )
     {
@@ -899,7 +894,7 @@ uint8_t RegionAS923DlChannelReq( DlChannelReqParams_t* dlChannelReq )
     }
 
     // Verify if an uplink frequency exists
-    if( Channels[dlChannelReq->ChannelId].Frequency == 0 )
+    if( RegionCtx->Channels[dlChannelReq->ChannelId].Frequency == 0 )
     {
         status &= 0xFD;
     }
@@ -907,7 +902,7 @@ uint8_t RegionAS923DlChannelReq( DlChannelReqParams_t* dlChannelReq )
     // Apply Rx1 frequency, if the status is OK
     if( status == 0x03 )
     {
-        Channels[dlChannelReq->ChannelId].Rx1Frequency = dlChannelReq->Rx1Frequency;
+        RegionCtx->Channels[dlChannelReq->ChannelId].Rx1Frequency = dlChannelReq->Rx1Frequency;
     }
 
     return status;
@@ -922,11 +917,11 @@ int8_t RegionAS923AlternateDr( AlternateDrParams_t* alternateDr )
 void RegionAS923CalcBackOff( CalcBackOffParams_t* calcBackOff )
 {
     uint8_t channel = calcBackOff->Channel;
-    uint16_t dutyCycle = Bands[Channels[channel].Band].DCycle;
+    uint16_t dutyCycle = RegionCtx->Bands[RegionCtx->Channels[channel].Band].DCycle;
     uint16_t joinDutyCycle = 0;
 
     // Reset time-off to initial value.
-    Bands[Channels[channel].Band].TimeOff = 0;
+    RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = 0;
 
     if( calcBackOff->Joined == false )
     {
@@ -935,13 +930,13 @@ void RegionAS923CalcBackOff( CalcBackOffParams_t* calcBackOff )
         // Apply the most restricting duty cycle
         dutyCycle = MAX( dutyCycle, joinDutyCycle );
         // Apply band time-off.
-        Bands[Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * dutyCycle - calcBackOff->TxTimeOnAir;
+        RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * dutyCycle - calcBackOff->TxTimeOnAir;
     }
     else
     {
         if( calcBackOff->DutyCycleEnabled == true )
         {
-            Bands[Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * dutyCycle - calcBackOff->TxTimeOnAir;
+            RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * dutyCycle - calcBackOff->TxTimeOnAir;
         }
     }
 }
@@ -954,9 +949,9 @@ bool RegionAS923NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
     uint8_t enabledChannels[AS923_MAX_NB_CHANNELS] = { 0 };
     TimerTime_t nextTxDelay = 0;
 
-    if( RegionCommonCountChannels( ChannelsMask, 0, 1 ) == 0 )
+    if( RegionCommonCountChannels( RegionCtx->ChannelsMask, 0, 1 ) == 0 )
     { // Reactivate default channels
-        ChannelsMask[0] |= LC( 1 ) + LC( 2 );
+        RegionCtx->ChannelsMask[0] |= LC( 1 ) + LC( 2 );
     }
 
     if( nextChanParams->AggrTimeOff <= TimerGetElapsedTime( nextChanParams->LastAggrTx ) )
@@ -965,12 +960,12 @@ bool RegionAS923NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
         *aggregatedTimeOff = 0;
 
         // Update bands Time OFF
-        nextTxDelay = RegionCommonUpdateBandTimeOff( nextChanParams->Joined, nextChanParams->DutyCycleEnabled, Bands, AS923_MAX_NB_BANDS );
+        nextTxDelay = RegionCommonUpdateBandTimeOff( nextChanParams->Joined, nextChanParams->DutyCycleEnabled, RegionCtx->Bands, AS923_MAX_NB_BANDS );
 
         // Search how many channels are enabled
         nbEnabledChannels = CountNbOfEnabledChannels( nextChanParams->Joined, nextChanParams->Datarate,
-                                                      ChannelsMask, Channels,
-                                                      Bands, enabledChannels, &delayTx );
+                                                      RegionCtx->ChannelsMask, RegionCtx->Channels,
+                                                      RegionCtx->Bands, enabledChannels, &delayTx );
     }
     else
     {
@@ -980,22 +975,22 @@ bool RegionAS923NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
 
     if( nbEnabledChannels > 0 )
     {
-        for( uint8_t  i = 0, j = randr( 0, nbEnabledChannels - 1 ); i < AS923_MAX_NB_CHANNELS; i++ )
+        // The MAC performs the carrier sense for AS923_CARRIER_SENSE_TIME on
+        // the enabled channels, in a random order, and uses the first free one
+        LoRaMacLbtSetCarrierSense( AS923_RSSI_FREE_TH, AS923_CARRIER_SENSE_TIME );
+        for( uint8_t  i = 0, j = randr( 0, nbEnabledChannels - 1 ); i < nbEnabledChannels; i++ )
         {
             channelNext = enabledChannels[j];
             j = ( j + 1 ) % nbEnabledChannels;
 
-            // Perform carrier sense for AS923_CARRIER_SENSE_TIME
-            // If the channel is free, we can stop the LBT mechanism
-            if( Radio.IsChannelFree( MODEM_LORA, Channels[channelNext].Frequency, AS923_RSSI_FREE_TH, AS923_CARRIER_SENSE_TIME ) == true )
+            LoRaMacLbtAddCandidate( channelNext, RegionCtx->Channels[channelNext].Frequency );
+            if( i == 0 )
             {
-                // Free channel found
                 *channel = channelNext;
-                *time = 0;
-                return true;
             }
         }
-        return false;
+        *time = 0;
+        return true;
     }
     else
     {
@@ -1006,7 +1001,7 @@ bool RegionAS923NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
             return true;
         }
         // Datarate not supported by any channel, restore defaults
-        ChannelsMask[0] |= LC( 1 ) + LC( 2 );
+        RegionCtx->ChannelsMask[0] |= LC( 1 ) + LC( 2 );
         *time = 0;
         return false;
     }
@@ -1052,7 +1047,7 @@ LoRaMacStatus_t RegionAS923ChannelAdd( ChannelAddParams_t* channelAdd )
             drInvalid = true;
         }
         // We are not allowed to change the frequency
-        if( channelAdd->NewChannel->Frequency != Channels[id].Frequency )
+        if( channelAdd->NewChannel->Frequency != RegionCtx->Channels[id].Frequency )
         {
             freqInvalid = true;
         }
@@ -1081,9 +1076,9 @@ LoRaMacStatus_t RegionAS923ChannelAdd( ChannelAddParams_t* channelAdd )
         return LORAMAC_STATUS_FREQUENCY_INVALID;
     }
 
-    memcpy( &(Channels[id]), channelAdd->NewChannel, sizeof( Channels[id] ) );
-    Channels[id].Band = band;
-    ChannelsMask[0] |= ( 1 << id );
+    memcpy( &(RegionCtx->Channels[id]), channelAdd->NewChannel, sizeof( RegionCtx->Channels[id] ) );
+    RegionCtx->Channels[id].Band = band;
+    RegionCtx->ChannelsMask[0] |= ( 1 << id );
     return LORAMAC_STATUS_OK;
 }
 
@@ -1097,16 +1092,16 @@ bool RegionAS923ChannelsRemove( ChannelRemoveParams_t* channelRemove  )
     }
 
     // Remove the channel from the list of channels
-    Channels[id] = ( ChannelParams_t ){ 0, 0, { 0 }, 0 };
+    RegionCtx->Channels[id] = ( ChannelParams_t ){ 0, 0, { 0 }, 0 };
 
-    return RegionCommonChanDisable( ChannelsMask, id, AS923_MAX_NB_CHANNELS );
+    return RegionCommonChanDisable( RegionCtx->ChannelsMask, id, AS923_MAX_NB_CHANNELS );
 }
 
 void RegionAS923SetContinuousWave( ContinuousWaveParams_t* continuousWave )
 {
-    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, Bands[Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, RegionCtx->Bands[RegionCtx->Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, RegionCtx->ChannelsMask );
     int8_t phyTxPower = 0;
-    uint32_t frequency = Channels[continuousWave->Channel].Frequency;
+    uint32_t frequency = RegionCtx->Channels[continuousWave->Channel].Frequency;
 
     // Calculate physical TX power
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, continuousWave->MaxEirp, continuousWave->AntennaGain );
@@ -41,33 +41,13 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 
 // Global attributes
 /*!
- * LoRaMAC channels
+ * LoRaMac bands, copied to the context at initialization
  */
-RTC_DATA_ATTR static ChannelParams_t Channels[AU915_MAX_NB_CHANNELS];
-
-/*!
- * LoRaMac bands
- */
-RTC_DATA_ATTR static Band_t Bands[AU915_MAX_NB_BANDS] =
+static const Band_t BandsDefault[AU915_MAX_NB_BANDS] =
 {
     AU915_BAND0
 };
 
-/*!
- * LoRaMac channels mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsMask[CHANNELS_MASK_SIZE];
-
-/*!
- * LoRaMac channels remaining
- */
-RTC_DATA_ATTR static uint16_t ChannelsMaskRemaining[CHANNELS_MASK_SIZE];
-
-/*!
- * LoRaMac channels default mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsDefaultMask[CHANNELS_MASK_SIZE];
-
 // Static functions
 static int8_t GetNextLowerTxDr( int8_t dr, int8_t minDr )
 {
@@ -240,12 +220,12 @@ PhyParam_t RegionAU915GetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS_MASK:
         {
-            phyParam.ChannelsMask = ChannelsMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsMask;
             break;
         }
         case PHY_CHANNELS_DEFAULT_MASK:
         {
-            phyParam.ChannelsMask = ChannelsDefaultMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsDefaultMask;
             break;
         }
         case PHY_MAX_NB_CHANNELS:
@@ -255,7 +235,7 @@ PhyParam_t RegionAU915GetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS:
         {
-            phyParam.Channels = Channels;
+            phyParam.Channels = RegionCtx->Channels;
             break;
         }
         case PHY_DEF_UPLINK_DWELL_TIME:
@@ -313,7 +293,7 @@ PhyParam_t RegionAU915GetPhyParam( GetPhyParams_t* getPhy )
 
 void RegionAU915SetBandTxDone( SetBandTxDoneParams_t* txDone )
 {
-    RegionCommonSetBandTxDone( txDone->Joined, &Bands[Channels[txDone->Channel].Band], txDone->LastTxDoneTime );
+    RegionCommonSetBandTxDone( txDone->Joined, &RegionCtx->Bands[RegionCtx->Channels[txDone->Channel].Band], txDone->LastTxDoneTime, txDone->LastTxAirTime );
 }
 
 void RegionAU915InitDefaults( InitType_t type )
@@ -322,45 +302,48 @@ void RegionAU915InitDefaults( InitType_t type )
     {
         case INIT_TYPE_INIT:
         {
+            // Bands
+            memcpy( RegionCtx->Bands, BandsDefault, sizeof( BandsDefault ) );
+
             // Channels
             // 125 kHz channels
             for( uint8_t i = 0; i < AU915_MAX_NB_CHANNELS - 8; i++ )
             {
-                Channels[i].Frequency = 915200000 + i * 200000;
-                Channels[i].DrRange.Value = ( DR_5 << 4 ) | DR_0;
-                Channels[i].Band = 0;
+                RegionCtx->Channels[i].Frequency = 915200000 + i * 200000;
+                RegionCtx->Channels[i].DrRange.Value = ( DR_5 << 4 ) | DR_0;
+                RegionCtx->Channels[i].Band = 0;
             }
             // 500 kHz channels
             for( uint8_t i = AU915_MAX_NB_CHANNELS - 8; i < AU915_MAX_NB_CHANNELS; i++ )
             {
-                Channels[i].Frequency = 915900000 + ( i - ( AU915_MAX_NB_CHANNELS - 8 ) ) * 1600000;
-                Channels[i].DrRange.Value = ( DR_6 << 4 ) | DR_6;
-                Channels[i].Band = 0;
+                RegionCtx->Channels[i].Frequency = 915900000 + ( i - ( AU915_MAX_NB_CHANNELS - 8 ) ) * 1600000;
+                RegionCtx->Channels[i].DrRange.Value = ( DR_6 << 4 ) | DR_6;
+                RegionCtx->Channels[i].Band = 0;
             }
 
             // Initialize channels default mask
-            ChannelsDefaultMask[0] = 0xFFFF;
-            ChannelsDefaultMask[1] = 0xFFFF;
-            ChannelsDefaultMask[2] = 0xFFFF;
-            ChannelsDefaultMask[3] = 0xFFFF;
-            ChannelsDefaultMask[4] = 0x00FF;
-            ChannelsDefaultMask[5] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[0] = 0xFFFF;
+            RegionCtx->ChannelsDefaultMask[1] = 0xFFFF;
+            RegionCtx->ChannelsDefaultMask[2] = 0xFFFF;
+            RegionCtx->ChannelsDefaultMask[3] = 0xFFFF;
+            RegionCtx->ChannelsDefaultMask[4] = 0x00FF;
+            RegionCtx->ChannelsDefaultMask[5] = 0x0000;
 
             // Copy channels default mask
-            RegionCommonChanMaskCopy( ChannelsMask, ChannelsDefaultMask, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, RegionCtx->ChannelsDefaultMask, 6 );
 
             // Copy into channels mask remaining
-            RegionCommonChanMaskCopy( ChannelsMaskRemaining, ChannelsMask, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMaskRemaining, RegionCtx->ChannelsMask, 6 );
             break;
         }
         case INIT_TYPE_RESTORE:
         {
             // Copy channels default mask
-            RegionCommonChanMaskCopy( ChannelsMask, ChannelsDefaultMask, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, RegionCtx->ChannelsDefaultMask, 6 );
 
             for( uint8_t i = 0; i < 6; i++ )
             { // Copy-And the channels mask
-                ChannelsMaskRemaining[i] &= ChannelsMask[i];
+                RegionCtx->ChannelsMaskRemaining[i] &= RegionCtx->ChannelsMask[i];
             }
             break;
         }
@@ -430,17 +413,17 @@ bool RegionAU915ChanMaskSet( ChanMaskSetParams_t* chanMaskSet )
     {
         case CHANNELS_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsMask, chanMaskSet->ChannelsMaskIn, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, chanMaskSet->ChannelsMaskIn, 6 );
 
             for( uint8_t i = 0; i < 6; i++ )
             { // Copy-And the channels mask
-                ChannelsMaskRemaining[i] &= ChannelsMask[i];
+                RegionCtx->ChannelsMaskRemaining[i] &= RegionCtx->ChannelsMask[i];
             }
             break;
         }
         case CHANNELS_DEFAULT_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 6 );
             break;
         }
         default:
@@ -496,12 +479,12 @@ bool RegionAU915AdrNext( AdrNextParams_t* adrNext, int8_t* drOut, int8_t* txPowO
                         if( adrNext->UpdateChanMask == true )
                         {
                             // Re-enable default channels
-                            ChannelsMask[0] = 0xFFFF;
-                            ChannelsMask[1] = 0xFFFF;
-                            ChannelsMask[2] = 0xFFFF;
-                            ChannelsMask[3] = 0xFFFF;
-                            ChannelsMask[4] = 0x00FF;
-                            ChannelsMask[5] = 0x0000;
+                            RegionCtx->ChannelsMask[0] = 0xFFFF;
+                            RegionCtx->ChannelsMask[1] = 0xFFFF;
+                            RegionCtx->ChannelsMask[2] = 0xFFFF;
+                            RegionCtx->ChannelsMask[3] = 0xFFFF;
+                            RegionCtx->ChannelsMask[4] = 0x00FF;
+                            RegionCtx->ChannelsMask[5] = 0x0000;
                         }
                     }
                 }
@@ -579,18 +562,18 @@ bool RegionAU915RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
 bool RegionAU915TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime_t* txTimeOnAir )
 {
     int8_t phyDr = DataratesAU915[txConfig->Datarate];
-    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, Bands[Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, RegionCtx->Bands[RegionCtx->Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, RegionCtx->ChannelsMask );
     uint32_t bandwidth = GetBandwidth( txConfig->Datarate );
     int8_t phyTxPower = 0;
 
     // Calculate physical TX power
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, txConfig->MaxEirp, txConfig->AntennaGain );
 
-    Radio.SetChannel( Channels[txConfig->Channel].Frequency );
+    Radio.SetChannel( RegionCtx->Channels[txConfig->Channel].Frequency );
 
     Radio.SetMaxPayloadLength( MODEM_LORA, txConfig->PktLen );
     Radio.SetTxConfig( MODEM_LORA, phyTxPower, 0, bandwidth, phyDr, 1, LORAWAN_PREAMBLE_LENGTH, false, true, 0, 0, false, 3e3 );
-    DBG_PRINTF("TX on freq %u Hz at DR %d\r\n", (unsigned int)Channels[txConfig->Channel].Frequency, txConfig->Datarate);
+    DBG_PRINTF("TX on freq %u Hz at DR %d\r\n", (unsigned int)RegionCtx->Channels[txConfig->Channel].Frequency, txConfig->Datarate);
 
     *txTimeOnAir = Radio.TimeOnAir( MODEM_LORA,  txConfig->PktLen );
     *txPower = txPowerLimited;
@@ -607,7 +590,7 @@ uint8_t RegionAU915LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
     uint16_t channelsMask[6] = { 0, 0, 0, 0, 0, 0 };
 
     // Initialize local copy of channels mask
-    RegionCommonChanMaskCopy( channelsMask, ChannelsMask, 6 );
+    RegionCommonChanMaskCopy( channelsMask, RegionCtx->ChannelsMask, 6 );
 
     while( bytesProcessed < linkAdrReq->PayloadSize )
     {
@@ -660,7 +643,7 @@ uint8_t RegionAU915LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
     }
 
     // Verify datarate
-    if( RegionCommonChanVerifyDr( AU915_MAX_NB_CHANNELS, channelsMask, linkAdrParams.Datarate, AU915_TX_MIN_DATARATE, AU915_TX_MAX_DATARATE, Channels  ) == false )
+    if( RegionCommonChanVerifyDr( AU915_MAX_NB_CHANNELS, channelsMask, linkAdrParams.Datarate, AU915_TX_MIN_DATARATE, AU915_TX_MAX_DATARATE, RegionCtx->Channels  ) == false )
     {
         status &= 0xFD; // Datarate KO
     }
@@ -688,14 +671,14 @@ uint8_t RegionAU915LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
         }
 
         // Copy Mask
-        RegionCommonChanMaskCopy( ChannelsMask, channelsMask, 6 );
+        RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, channelsMask, 6 );
 
-        ChannelsMaskRemaining[0] &= ChannelsMask[0];
-        ChannelsMaskRemaining[1] &= ChannelsMask[1];
-        ChannelsMaskRemaining[2] &= ChannelsMask[2];
-        ChannelsMaskRemaining[3] &= ChannelsMask[3];
-        ChannelsMaskRemaining[4] = ChannelsMask[4];
-        ChannelsMaskRemaining[5] = ChannelsMask[5];
+        RegionCtx->ChannelsMaskRemaining[0] &= RegionCtx->ChannelsMask[0];
+        RegionCtx->ChannelsMaskRemaining[1] &= RegionCtx->ChannelsMask[1];
+        RegionCtx->ChannelsMaskRemaining[2] &= RegionCtx->ChannelsMask[2];
+        RegionCtx->ChannelsMaskRemaining[3] &= RegionCtx->ChannelsMask[3];
+        RegionCtx->ChannelsMaskRemaining[4] = RegionCtx->ChannelsMask[4];
+        RegionCtx->ChannelsMaskRemaining[5] = RegionCtx->ChannelsMask[5];
     }
 
     // Update status variables
@@ -762,15 +745,15 @@ int8_t RegionAU915AlternateDr( AlternateDrParams_t* alternateDr )
     int8_t datarate = 0;
 
     // Re-enable 500 kHz default channels
-    ChannelsMask[4] = 0x00FF;
+    RegionCtx->ChannelsMask[4] = 0x00FF;
 
     if( ( alternateDr->NbTrials & 0x01 ) == 0x01 )
     {
-        datarate = DR_4;
+        datarate = DR_6;
     }
     else
     {
-        datarate = DR_0;
+        datarate = DR_2;
     }
     return datarate;
 }
@@ -785,11 +768,11 @@ void RegionAU915CalcBackOff( CalcBackOffParams_t* calcBackOff )
         // Get the join duty cycle
         joinDutyCycle = RegionCommonGetJoinDc( calcBackOff->ElapsedTime );
         // Apply band time-off.
-        Bands[Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * joinDutyCycle - calcBackOff->TxTimeOnAir;
+        RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * joinDutyCycle - calcBackOff->TxTimeOnAir;
     }
     else
     {
-        Bands[Channels[channel].Band].TimeOff = 0;
+        RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = 0;
     }
 }
 
@@ -801,16 +784,16 @@ bool RegionAU915NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
     TimerTime_t nextTxDelay = 0;
 
     // Count 125kHz channels
-    if( RegionCommonCountChannels( ChannelsMaskRemaining, 0, 4 ) == 0 )
+    if( RegionCommonCountChannels( RegionCtx->ChannelsMaskRemaining, 0, 4 ) == 0 )
     { // Reactivate default channels
-        RegionCommonChanMaskCopy( ChannelsMaskRemaining, ChannelsMask, 4  );
+        RegionCommonChanMaskCopy( RegionCtx->ChannelsMaskRemaining, RegionCtx->ChannelsMask, 4  );
     }
     // Check other channels
-    if( nextChanParams->Datarate >= DR_4 )
+    if( nextChanParams->Datarate >= DR_6 )
     {
-        if( ( ChannelsMaskRemaining[4] & 0x00FF ) == 0 )
+        if( ( RegionCtx->ChannelsMaskRemaining[4] & 0x00FF ) == 0 )
         {
-            ChannelsMaskRemaining[4] = ChannelsMask[4];
+            RegionCtx->ChannelsMaskRemaining[4] = RegionCtx->ChannelsMask[4];
         }
     }
 
@@ -819,10 +802,20 @@ bool RegionAU915NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
         // Reset Aggregated time off
         *aggregatedTimeOff = 0;
 
-        // Search how many channels are enabled
+        // Update bands Time OFF
+        nextTxDelay = RegionCommonUpdateBandTimeOff( nextChanParams->Joined, nextChanParams->DutyCycleEnabled, RegionCtx->Bands, AU915_MAX_NB_BANDS );
+
+        // Search how many channels are enabled, join requests use the whole mask
         nbEnabledChannels = CountNbOfEnabledChannels( nextChanParams->Datarate,
-                                                      ChannelsMaskRemaining, Channels,
-                                                      Bands, enabledChannels, &delayTx );
+                                                      ( nextChanParams->Joined == true ) ? RegionCtx->ChannelsMaskRemaining : RegionCtx->ChannelsMask,
+                                                      RegionCtx->Channels, RegionCtx->Bands, enabledChannels, &delayTx );
+
+        if( ( nextChanParams->Joined == false ) && ( nbEnabledChannels > 0 ) )
+        {
+            // Join requests rotate through the subbands
+            nbEnabledChannels = RegionCommonJoinSubBandFilter( &RegionCtx->JoinSubBand, &RegionCtx->JoinSubBandTrials,
+                                                               enabledChannels, nbEnabledChannels );
+        }
     }
     else
     {
@@ -835,7 +828,7 @@ bool RegionAU915NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
         // We found a valid channel
         *channel = enabledChannels[randr( 0, nbEnabledChannels - 1 )];
         // Disable the channel in the mask
-        RegionCommonChanDisable( ChannelsMaskRemaining, *channel, AU915_MAX_NB_CHANNELS - 8 );
+        RegionCommonChanDisable( RegionCtx->ChannelsMaskRemaining, *channel, AU915_MAX_NB_CHANNELS - 8 );
 
         *time = 0;
         return true;
@@ -854,6 +847,11 @@ bool RegionAU915NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
     }
 }
 
+void RegionAU915JoinAccepted( uint8_t channel )
+{
+    RegionCommonJoinSubBandAccepted( channel, &RegionCtx->JoinSubBand, &RegionCtx->JoinSubBandTrials );
+}
+
 LoRaMacStatus_t RegionAU915ChannelAdd( ChannelAddParams_t* channelAdd )
 {
     return LORAMAC_STATUS_PARAMETER_INVALID;
@@ -866,9 +864,9 @@ bool RegionAU915ChannelsRemove( ChannelRemoveParams_t* channelRemove  )
 
 void RegionAU915SetContinuousWave( ContinuousWaveParams_t* continuousWave )
 {
-    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, Bands[Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, RegionCtx->Bands[RegionCtx->Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, RegionCtx->ChannelsMask );
     int8_t phyTxPower = 0;
-    uint32_t frequency = Channels[continuousWave->Channel].Frequency;
+    uint32_t frequency = RegionCtx->Channels[continuousWave->Channel].Frequency;
 
     // Calculate physical TX power
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, continuousWave->MaxEirp, continuousWave->AntennaGain );
@@ -461,6 +461,14 @@ void RegionAU915CalcBackOff( CalcBackOffParams_t* calcBackOff );
  */
 bool RegionAU915NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel, TimerTime_t* time, TimerTime_t* aggregatedTimeOff );
 
+/*!
+ * \brief Makes the next join requests start on the subband of the channel
+ *        a join request was accepted on.
+ *
+ * \param [IN] channel Channel of the accepted join request.
+ */
+void RegionAU915JoinAccepted( uint8_t channel );
+
 /*!
  * \brief Adds a channel.
  *
@@ -42,28 +42,13 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 
 // Global attributes
 /*!
- * LoRaMAC channels
+ * LoRaMac bands, copied to the context at initialization
  */
-RTC_DATA_ATTR static ChannelParams_t Channels[CN470_MAX_NB_CHANNELS];
-
-/*!
- * LoRaMac bands
- */
-RTC_DATA_ATTR static Band_t Bands[CN470_MAX_NB_BANDS] =
+static const Band_t BandsDefault[CN470_MAX_NB_BANDS] =
 {
     CN470_BAND0
 };
 
-/*!
- * LoRaMac channels mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsMask[CHANNELS_MASK_SIZE];
-
-/*!
- * LoRaMac channels default mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsDefaultMask[CHANNELS_MASK_SIZE];
-
 // Static functions
 static int8_t GetNextLowerTxDr( int8_t dr, int8_t minDr )
 {
@@ -236,12 +221,12 @@ PhyParam_t RegionCN470GetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS_MASK:
         {
-            phyParam.ChannelsMask = ChannelsMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsMask;
             break;
         }
         case PHY_CHANNELS_DEFAULT_MASK:
         {
-            phyParam.ChannelsMask = ChannelsDefaultMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsDefaultMask;
             break;
         }
         case PHY_MAX_NB_CHANNELS:
@@ -251,7 +236,7 @@ PhyParam_t RegionCN470GetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS:
         {
-            phyParam.Channels = Channels;
+            phyParam.Channels = RegionCtx->Channels;
             break;
         }
         case PHY_DEF_UPLINK_DWELL_TIME:
@@ -310,7 +295,7 @@ PhyParam_t RegionCN470GetPhyParam( GetPhyParams_t* getPhy )
 
 void RegionCN470SetBandTxDone( SetBandTxDoneParams_t* txDone )
 {
-    RegionCommonSetBandTxDone( txDone->Joined, &Bands[Channels[txDone->Channel].Band], txDone->LastTxDoneTime );
+    RegionCommonSetBandTxDone( txDone->Joined, &RegionCtx->Bands[RegionCtx->Channels[txDone->Channel].Band], txDone->LastTxDoneTime, txDone->LastTxAirTime );
 }
 
 void RegionCN470InitDefaults( InitType_t type )
@@ -319,31 +304,34 @@ void RegionCN470InitDefaults( InitType_t type )
     {
         case INIT_TYPE_INIT:
         {
+            // Bands
+            memcpy( RegionCtx->Bands, BandsDefault, sizeof( BandsDefault ) );
+
             // Channels
             // 125 kHz channels
             for( uint8_t i = 0; i < CN470_MAX_NB_CHANNELS; i++ )
             {
-                Channels[i].Frequency = 470300000 + i * 200000;
-                Channels[i].DrRange.Value = ( DR_5 << 4 ) | DR_0;
-                Channels[i].Band = 0;
+                RegionCtx->Channels[i].Frequency = 470300000 + i * 200000;
+                RegionCtx->Channels[i].DrRange.Value = ( DR_5 << 4 ) | DR_0;
+                RegionCtx->Channels[i].Band = 0;
             }
 
             // Initialize the channels default mask
-            ChannelsDefaultMask[0] = 0xFFFF;
-            ChannelsDefaultMask[1] = 0xFFFF;
-            ChannelsDefaultMask[2] = 0xFFFF;
-            ChannelsDefaultMask[3] = 0xFFFF;
-            ChannelsDefaultMask[4] = 0xFFFF;
-            ChannelsDefaultMask[5] = 0xFFFF;
+            RegionCtx->ChannelsDefaultMask[0] = 0xFFFF;
+            RegionCtx->ChannelsDefaultMask[1] = 0xFFFF;
+            RegionCtx->ChannelsDefaultMask[2] = 0xFFFF;
+            RegionCtx->ChannelsDefaultMask[3] = 0xFFFF;
+            RegionCtx->ChannelsDefaultMask[4] = 0xFFFF;
+            RegionCtx->ChannelsDefaultMask[5] = 0xFFFF;
 
             // Update the channels mask
-            RegionCommonChanMaskCopy( ChannelsMask, ChannelsDefaultMask, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, RegionCtx->ChannelsDefaultMask, 6 );
             break;
         }
         case INIT_TYPE_RESTORE:
         {
             // Restore channels default mask
-            RegionCommonChanMaskCopy( ChannelsMask, ChannelsDefaultMask, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, RegionCtx->ChannelsDefaultMask, 6 );
             break;
         }
         default:
@@ -401,12 +389,12 @@ bool RegionCN470ChanMaskSet( ChanMaskSetParams_t* chanMaskSet )
     {
         case CHANNELS_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsMask, chanMaskSet->ChannelsMaskIn, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, chanMaskSet->ChannelsMaskIn, 6 );
             break;
         }
         case CHANNELS_DEFAULT_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 6 );
             break;
         }
         default:
@@ -462,12 +450,12 @@ bool RegionCN470AdrNext( AdrNextParams_t* adrNext, int8_t* drOut, int8_t* txPowO
                         if( adrNext->UpdateChanMask == true )
                         {
                             // Re-enable default channels
-                            ChannelsMask[0] = 0xFFFF;
-                            ChannelsMask[1] = 0xFFFF;
-                            ChannelsMask[2] = 0xFFFF;
-                            ChannelsMask[3] = 0xFFFF;
-                            ChannelsMask[4] = 0xFFFF;
-                            ChannelsMask[5] = 0xFFFF;
+                            RegionCtx->ChannelsMask[0] = 0xFFFF;
+                            RegionCtx->ChannelsMask[1] = 0xFFFF;
+                            RegionCtx->ChannelsMask[2] = 0xFFFF;
+                            RegionCtx->ChannelsMask[3] = 0xFFFF;
+                            RegionCtx->ChannelsMask[4] = 0xFFFF;
+                            RegionCtx->ChannelsMask[5] = 0xFFFF;
                         }
                     }
                 }
@@ -537,14 +525,14 @@ bool RegionCN470RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
 bool RegionCN470TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime_t* txTimeOnAir )
 {
     int8_t phyDr = DataratesCN470[txConfig->Datarate];
-    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, Bands[Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, RegionCtx->Bands[RegionCtx->Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, RegionCtx->ChannelsMask );
     int8_t phyTxPower = 0;
 	
     // Calculate physical TX power
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, txConfig->MaxEirp, txConfig->AntennaGain );
 	//printf("\r\ntx Power: %d freq: %d\r\n",txPowerLimited,Channels[txConfig->Channel].Frequency);
     // Setup the radio frequency
-    Radio.SetChannel( Channels[txConfig->Channel].Frequency );
+    Radio.SetChannel( RegionCtx->Channels[txConfig->Channel].Frequency );
 
     
     Radio.SetTxConfig( MODEM_LORA, phyTxPower, 0, 0, phyDr, 1, LORAWAN_PREAMBLE_LENGTH, false, true, 0, 0, false, 3000 );
@@ -553,7 +541,7 @@ bool RegionCN470TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
     Radio.SetMaxPayloadLength( MODEM_LORA, txConfig->PktLen );
     // Get the time-on-air of the next tx frame
     *txTimeOnAir = Radio.TimeOnAir( MODEM_LORA,  txConfig->PktLen );
-	DBG_PRINTF("TX on freq %u Hz at DR %d\r\n", (unsigned int)Channels[txConfig->Channel].Frequency, txConfig->Datarate);
+	DBG_PRINTF("TX on freq %u Hz at DR %d\r\n", (unsigned int)RegionCtx->Channels[txConfig->Channel].Frequency, txConfig->Datarate);
     *txPower = txPowerLimited;
 
     return true;
@@ -568,7 +556,7 @@ uint8_t RegionCN470LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
     uint16_t channelsMask[6] = { 0, 0, 0, 0, 0, 0 };
 
     // Initialize local copy of channels mask
-    RegionCommonChanMaskCopy( channelsMask, ChannelsMask, 6 );
+    RegionCommonChanMaskCopy( channelsMask, RegionCtx->ChannelsMask, 6 );
 
     while( bytesProcessed < linkAdrReq->PayloadSize )
     {
@@ -604,7 +592,7 @@ uint8_t RegionCN470LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
             for( uint8_t i = 0; i < 16; i++ )
             {
                 if( ( ( linkAdrParams.ChMask & ( 1 << i ) ) != 0 ) &&
-                    ( Channels[linkAdrParams.ChMaskCtrl * 16 + i].Frequency == 0 ) )
+                    ( RegionCtx->Channels[linkAdrParams.ChMaskCtrl * 16 + i].Frequency == 0 ) )
                 {// Trying to enable an undefined channel
                     status &= 0xFE; // Channel mask KO
                 }
@@ -613,7 +601,7 @@ uint8_t RegionCN470LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
         }
     }
     // Verify datarate
-    if( RegionCommonChanVerifyDr( CN470_MAX_NB_CHANNELS, channelsMask, linkAdrParams.Datarate, CN470_TX_MIN_DATARATE, CN470_TX_MAX_DATARATE, Channels  ) == false )
+    if( RegionCommonChanVerifyDr( CN470_MAX_NB_CHANNELS, channelsMask, linkAdrParams.Datarate, CN470_TX_MIN_DATARATE, CN470_TX_MAX_DATARATE, RegionCtx->Channels  ) == false )
     {
         status &= 0xFD; // Datarate KO
     }
@@ -639,7 +627,7 @@ uint8_t RegionCN470LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
         }
 
         // Copy Mask
-        RegionCommonChanMaskCopy( ChannelsMask, channelsMask, 6 );
+        RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, channelsMask, 6 );
     }
 	//printf("status:%d\r\n",status);
     // Update status variables
@@ -737,11 +725,11 @@ void RegionCN470CalcBackOff( CalcBackOffParams_t* calcBackOff )
         // Get the join duty cycle
         joinDutyCycle = RegionCommonGetJoinDc( calcBackOff->ElapsedTime );
         // Apply band time-off.
-        Bands[Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * joinDutyCycle - calcBackOff->TxTimeOnAir;
+        RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * joinDutyCycle - calcBackOff->TxTimeOnAir;
     }
     else
     {
-        Bands[Channels[channel].Band].TimeOff = 0;
+        RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = 0;
     }
 }
 
@@ -752,14 +740,14 @@ bool RegionCN470NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
     uint8_t enabledChannels[CN470_MAX_NB_CHANNELS] = { 0 };
     TimerTime_t nextTxDelay = 0;
     // Count 125kHz channels
-    if( RegionCommonCountChannels( ChannelsMask, 0, 6 ) == 0 )
+    if( RegionCommonCountChannels( RegionCtx->ChannelsMask, 0, 6 ) == 0 )
     { // Reactivate default channels
-        ChannelsMask[0] = 0xFFFF;
-        ChannelsMask[1] = 0xFFFF;
-        ChannelsMask[2] = 0xFFFF;
-        ChannelsMask[3] = 0xFFFF;
-        ChannelsMask[4] = 0xFFFF;
-        ChannelsMask[5] = 0xFFFF;
+        RegionCtx->ChannelsMask[0] = 0xFFFF;
+        RegionCtx->ChannelsMask[1] = 0xFFFF;
+        RegionCtx->ChannelsMask[2] = 0xFFFF;
+        RegionCtx->ChannelsMask[3] = 0xFFFF;
+        RegionCtx->ChannelsMask[4] = 0xFFFF;
+        RegionCtx->ChannelsMask[5] = 0xFFFF;
     }
 
     if( nextChanParams->AggrTimeOff <= TimerGetElapsedTime( nextChanParams->LastAggrTx ) )
@@ -768,12 +756,12 @@ bool RegionCN470NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
         *aggregatedTimeOff = 0;
 
         // Update bands Time OFF
-        nextTxDelay = RegionCommonUpdateBandTimeOff( nextChanParams->Joined, nextChanParams->DutyCycleEnabled, Bands, CN470_MAX_NB_BANDS );
+        nextTxDelay = RegionCommonUpdateBandTimeOff( nextChanParams->Joined, nextChanParams->DutyCycleEnabled, RegionCtx->Bands, CN470_MAX_NB_BANDS );
 
         // Search how many channels are enabled
         nbEnabledChannels = CountNbOfEnabledChannels( nextChanParams->Datarate,
-                                                      ChannelsMask, Channels,
-                                                      Bands, enabledChannels, &delayTx );
+                                                      RegionCtx->ChannelsMask, RegionCtx->Channels,
+                                                      RegionCtx->Bands, enabledChannels, &delayTx );
     }
     else
     {
@@ -815,9 +803,9 @@ bool RegionCN470ChannelsRemove( ChannelRemoveParams_t* channelRemove  )
 
 void RegionCN470SetContinuousWave( ContinuousWaveParams_t* continuousWave )
 {
-    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, Bands[Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, RegionCtx->Bands[RegionCtx->Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, RegionCtx->ChannelsMask );
     int8_t phyTxPower = 0;
-    uint32_t frequency = Channels[continuousWave->Channel].Frequency;
+    uint32_t frequency = RegionCtx->Channels[continuousWave->Channel].Frequency;
 
     // Calculate physical TX power
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, continuousWave->MaxEirp, continuousWave->AntennaGain );
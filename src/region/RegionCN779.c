@@ -42,28 +42,13 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 
 // Global attributes
 /*!
- * LoRaMAC channels
+ * LoRaMac bands, copied to the context at initialization
  */
-RTC_DATA_ATTR static ChannelParams_t Channels[CN779_MAX_NB_CHANNELS];
-
-/*!
- * LoRaMac bands
- */
-RTC_DATA_ATTR static Band_t Bands[CN779_MAX_NB_BANDS] =
+static const Band_t BandsDefault[CN779_MAX_NB_BANDS] =
 {
     CN779_BAND0
 };
 
-/*!
- * LoRaMac channels mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsMask[CHANNELS_MASK_SIZE];
-
-/*!
- * LoRaMac channels default mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsDefaultMask[CHANNELS_MASK_SIZE];
-
 // Static functions
 static int8_t GetNextLowerTxDr( int8_t dr, int8_t minDr )
 {
@@ -258,12 +243,12 @@ PhyParam_t RegionCN779GetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS_MASK:
         {
-            phyParam.ChannelsMask = ChannelsMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsMask;
             break;
         }
         case PHY_CHANNELS_DEFAULT_MASK:
         {
-            phyParam.ChannelsMask = ChannelsDefaultMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsDefaultMask;
             break;
         }
         case PHY_MAX_NB_CHANNELS:
@@ -273,7 +258,7 @@ PhyParam_t RegionCN779GetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS:
         {
-            phyParam.Channels = Channels;
+            phyParam.Channels = RegionCtx->Channels;
             break;
         }
         case PHY_DEF_UPLINK_DWELL_TIME:
@@ -326,7 +311,7 @@ PhyParam_t RegionCN779GetPhyParam( GetPhyParams_t* getPhy )
 
 void RegionCN779SetBandTxDone( SetBandTxDoneParams_t* txDone )
 {
-    RegionCommonSetBandTxDone( txDone->Joined, &Bands[Channels[txDone->Channel].Band], txDone->LastTxDoneTime );
+    RegionCommonSetBandTxDone( txDone->Joined, &RegionCtx->Bands[RegionCtx->Channels[txDone->Channel].Band], txDone->LastTxDoneTime, txDone->LastTxAirTime );
 }
 
 void RegionCN779InitDefaults( InitType_t type )
@@ -335,21 +320,24 @@ void RegionCN779InitDefaults( InitType_t type )
     {
         case INIT_TYPE_INIT:
         {
+            // Bands
+            memcpy( RegionCtx->Bands, BandsDefault, sizeof( BandsDefault ) );
+
             // Channels
-            Channels[0] = ( ChannelParams_t ) CN779_LC1;
-            Channels[1] = ( ChannelParams_t ) CN779_LC2;
-            Channels[2] = ( ChannelParams_t ) CN779_LC3;
+            RegionCtx->Channels[0] = ( ChannelParams_t ) CN779_LC1;
+            RegionCtx->Channels[1] = ( ChannelParams_t ) CN779_LC2;
+            RegionCtx->Channels[2] = ( ChannelParams_t ) CN779_LC3;
 
             // Initialize the channels default mask
-            ChannelsDefaultMask[0] = LC( 1 ) + LC( 2 ) + LC( 3 );
+            RegionCtx->ChannelsDefaultMask[0] = LC( 1 ) + LC( 2 ) + LC( 3 );
             // Update the channels mask
-            RegionCommonChanMaskCopy( ChannelsMask, ChannelsDefaultMask, 1 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, RegionCtx->ChannelsDefaultMask, 1 );
             break;
         }
         case INIT_TYPE_RESTORE:
         {
             // Restore channels default mask
-            ChannelsMask[0] |= ChannelsDefaultMask[0];
+            RegionCtx->ChannelsMask[0] |= RegionCtx->ChannelsDefaultMask[0];
             break;
         }
         default:
@@ -458,12 +446,12 @@ bool RegionCN779ChanMaskSet( ChanMaskSetParams_t* chanMaskSet )
     {
         case CHANNELS_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsMask, chanMaskSet->ChannelsMaskIn, 1 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, chanMaskSet->ChannelsMaskIn, 1 );
             break;
         }
         case CHANNELS_DEFAULT_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 1 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 1 );
             break;
         }
         default:
@@ -519,7 +507,7 @@ bool RegionCN779AdrNext( AdrNextParams_t* adrNext, int8_t* drOut, int8_t* txPowO
                         if( adrNext->UpdateChanMask == true )
                         {
                             // Re-enable default channels
-                            ChannelsMask[0] |= LC( 1 ) + LC( 2 ) + LC( 3 );
+                            RegionCtx->ChannelsMask[0] |= LC( 1 ) + LC( 2 ) + LC( 3 );
                         }
                     }
                 }
@@ -569,11 +557,11 @@ bool RegionCN779RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
     if( rxConfig->RxSlot == RX_SLOT_WIN_1 )
     {
         // Apply window 1 frequency
-        frequency = Channels[rxConfig->Channel].Frequency;
+        frequency = RegionCtx->Channels[rxConfig->Channel].Frequency;
         // Apply the alternative RX 1 window frequency, if it is available
-        if( Channels[rxConfig->Channel].Rx1Frequency != 0 )
+        if( RegionCtx->Channels[rxConfig->Channel].Rx1Frequency != 0 )
         {
-            frequency = Channels[rxConfig->Channel].Rx1Frequency;
+            frequency = RegionCtx->Channels[rxConfig->Channel].Rx1Frequency;
         }
     }
 
@@ -593,6 +581,7 @@ bool RegionCN779RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
         modem = MODEM_LORA;
         Radio.SetRxConfig( modem, rxConfig->Bandwidth, phyDr, 1, 0, 8, rxConfig->WindowTimeout, false, 0, false, 0, 0, true, rxConfig->RxContinuous );
     }
+    rxConfig->Modem = modem;
 
     if( rxConfig->RepeaterSupport == true )
     {
@@ -613,7 +602,7 @@ bool RegionCN779TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
 {
     RadioModems_t modem;
     int8_t phyDr = DataratesCN779[txConfig->Datarate];
-    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, Bands[Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, RegionCtx->Bands[RegionCtx->Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, RegionCtx->ChannelsMask );
     uint32_t bandwidth = GetBandwidth( txConfig->Datarate );
     int8_t phyTxPower = 0;
 
@@ -621,7 +610,7 @@ bool RegionCN779TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, txConfig->MaxEirp, txConfig->AntennaGain );
 
     // Setup the radio frequency
-    Radio.SetChannel( Channels[txConfig->Channel].Frequency );
+    Radio.SetChannel( RegionCtx->Channels[txConfig->Channel].Frequency );
 
     if( txConfig->Datarate == DR_7 )
     { // High Speed FSK channel
@@ -633,7 +622,7 @@ bool RegionCN779TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
         modem = MODEM_LORA;
         Radio.SetTxConfig( modem, phyTxPower, 0, bandwidth, phyDr, 1, LORAWAN_PREAMBLE_LENGTH, false, true, 0, 0, false, 3e3 );
     }
-    DBG_PRINTF("TX on freq %u Hz at DR %d\r\n", (unsigned int)Channels[txConfig->Channel].Frequency, txConfig->Datarate);
+    DBG_PRINTF("TX on freq %u Hz at DR %d\r\n", (unsigned int)RegionCtx->Channels[txConfig->Channel].Frequency, txConfig->Datarate);
     // Setup maximum payload lenght of the radio driver
     Radio.SetMaxPayloadLength( modem, txConfig->PktLen );
     // Get the time-on-air of the next tx frame
@@ -685,7 +674,7 @@ uint8_t RegionCN779LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
             {
                 if( linkAdrParams.ChMaskCtrl == 6 )
                 {
-                    if( Channels[i].Frequency != 0 )
+                    if( RegionCtx->Channels[i].Frequency != 0 )
                     {
                         chMask |= 1 << i;
                     }
@@ -693,7 +682,7 @@ uint8_t RegionCN779LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
                 else
                 {
                     if( ( ( chMask & ( 1 << i ) ) != 0 ) &&
-                        ( Channels[i].Frequency == 0 ) )
+                        ( RegionCtx->Channels[i].Frequency == 0 ) )
                     {// Trying to enable an undefined channel
                         status &= 0xFE; // Channel mask KO
                     }
@@ -703,7 +692,7 @@ uint8_t RegionCN779LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
     }
 
     // Verify datarate
-    if( RegionCommonChanVerifyDr( CN779_MAX_NB_CHANNELS, &chMask, linkAdrParams.Datarate, CN779_TX_MIN_DATARATE, CN779_TX_MAX_DATARATE, Channels  ) == false )
+    if( RegionCommonChanVerifyDr( CN779_MAX_NB_CHANNELS, &chMask, linkAdrParams.Datarate, CN779_TX_MIN_DATARATE, CN779_TX_MAX_DATARATE, RegionCtx->Channels  ) == false )
     {
         status &= 0xFD; // Datarate KO
     }
@@ -731,9 +720,9 @@ uint8_t RegionCN779LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
         }
 
         // Set the channels mask to a default value
-        memset( ChannelsMask, 0, sizeof( ChannelsMask ) );
+        memset( RegionCtx->ChannelsMask, 0, sizeof( RegionCtx->ChannelsMask ) );
         // Update the channels mask
-        ChannelsMask[0] = chMask;
+        RegionCtx->ChannelsMask[0] = chMask;
     }
 
     // Update status variables
@@ -832,6 +821,11 @@ uint8_t RegionCN779DlChannelReq( DlChannelReqParams_t* dlChannelReq )
 {
     uint8_t status = 0x03;
 
+    if( dlChannelReq->ChannelId >= CN779_MAX_NB_CHANNELS )
+    {
+        return 0;
+    }
+
     // Verify if the frequency is supported
     if( VerifyTxFreq( dlChannelReq->Rx1Frequency ) == false )
     {
@@ -839,7 +833,7 @@ uint8_t RegionCN779DlChannelReq( DlChannelReqParams_t* dlChannelReq )
     }
 
     // Verify if an uplink frequency exists
-    if( Channels[dlChannelReq->ChannelId].Frequency == 0 )
+    if( RegionCtx->Channels[dlChannelReq->ChannelId].Frequency == 0 )
     {
         status &= 0xFD;
     }
@@ -847,7 +841,7 @@ uint8_t RegionCN779DlChannelReq( DlChannelReqParams_t* dlChannelReq )
     // Apply Rx1 frequency, if the status is OK
     if( status == 0x03 )
     {
-        Channels[dlChannelReq->ChannelId].Rx1Frequency = dlChannelReq->Rx1Frequency;
+        RegionCtx->Channels[dlChannelReq->ChannelId].Rx1Frequency = dlChannelReq->Rx1Frequency;
     }
 
     return status;
@@ -887,11 +881,11 @@ int8_t RegionCN779AlternateDr( AlternateDrParams_t* alternateDr )
 void RegionCN779CalcBackOff( CalcBackOffParams_t* calcBackOff )
 {
     uint8_t channel = calcBackOff->Channel;
-    uint16_t dutyCycle = Bands[Channels[channel].Band].DCycle;
+    uint16_t dutyCycle = RegionCtx->Bands[RegionCtx->Channels[channel].Band].DCycle;
     uint16_t joinDutyCycle = 0;
 
     // Reset time-off to initial value.
-    Bands[Channels[channel].Band].TimeOff = 0;
+    RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = 0;
 
     if( calcBackOff->Joined == false )
     {
@@ -900,13 +894,13 @@ void RegionCN779CalcBackOff( CalcBackOffParams_t* calcBackOff )
         // Apply the most restricting duty cycle
         dutyCycle = MAX( dutyCycle, joinDutyCycle );
         // Apply band time-off.
-        Bands[Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * dutyCycle - calcBackOff->TxTimeOnAir;
+        RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * dutyCycle - calcBackOff->TxTimeOnAir;
     }
     else
     {
         if( calcBackOff->DutyCycleEnabled == true )
         {
-            Bands[Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * dutyCycle - calcBackOff->TxTimeOnAir;
+            RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * dutyCycle - calcBackOff->TxTimeOnAir;
         }
     }
 }
@@ -918,9 +912,9 @@ bool RegionCN779NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
     uint8_t enabledChannels[CN779_MAX_NB_CHANNELS] = { 0 };
     TimerTime_t nextTxDelay = 0;
 
-    if( RegionCommonCountChannels( ChannelsMask, 0, 1 ) == 0 )
+    if( RegionCommonCountChannels( RegionCtx->ChannelsMask, 0, 1 ) == 0 )
     { // Reactivate default channels
-        ChannelsMask[0] |= LC( 1 ) + LC( 2 ) + LC( 3 );
+        RegionCtx->ChannelsMask[0] |= LC( 1 ) + LC( 2 ) + LC( 3 );
     }
 
     if( nextChanParams->AggrTimeOff <= TimerGetElapsedTime( nextChanParams->LastAggrTx ) )
@@ -929,12 +923,12 @@ bool RegionCN779NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
         *aggregatedTimeOff = 0;
 
         // Update bands Time OFF
-        nextTxDelay = RegionCommonUpdateBandTimeOff( nextChanParams->Joined, nextChanParams->DutyCycleEnabled, Bands, CN779_MAX_NB_BANDS );
+        nextTxDelay = RegionCommonUpdateBandTimeOff( nextChanParams->Joined, nextChanParams->DutyCycleEnabled, RegionCtx->Bands, CN779_MAX_NB_BANDS );
 
         // Search how many channels are enabled
         nbEnabledChannels = CountNbOfEnabledChannels( nextChanParams->Joined, nextChanParams->Datarate,
-                                                      ChannelsMask, Channels,
-                                                      Bands, enabledChannels, &delayTx );
+                                                      RegionCtx->ChannelsMask, RegionCtx->Channels,
+                                                      RegionCtx->Bands, enabledChannels, &delayTx );
     }
     else
     {
@@ -959,7 +953,7 @@ bool RegionCN779NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
             return true;
         }
         // Datarate not supported by any channel, restore defaults
-        ChannelsMask[0] |= LC( 1 ) + LC( 2 ) + LC( 3 );
+        RegionCtx->ChannelsMask[0] |= LC( 1 ) + LC( 2 ) + LC( 3 );
         *time = 0;
         return false;
     }
@@ -1005,7 +999,7 @@ LoRaMacStatus_t RegionCN779ChannelAdd( ChannelAddParams_t* channelAdd )
             drInvalid = true;
         }
         // We are not allowed to change the frequency
-        if( channelAdd->NewChannel->Frequency != Channels[id].Frequency )
+        if( channelAdd->NewChannel->Frequency != RegionCtx->Channels[id].Frequency )
         {
             freqInvalid = true;
         }
@@ -1034,9 +1028,9 @@ LoRaMacStatus_t RegionCN779ChannelAdd( ChannelAddParams_t* channelAdd )
         return LORAMAC_STATUS_FREQUENCY_INVALID;
     }
 
-    memcpy( &(Channels[id]), channelAdd->NewChannel, sizeof( Channels[id] ) );
-    Channels[id].Band = band;
-    ChannelsMask[0] |= ( 1 << id );
+    memcpy( &(RegionCtx->Channels[id]), channelAdd->NewChannel, sizeof( RegionCtx->Channels[id] ) );
+    RegionCtx->Channels[id].Band = band;
+    RegionCtx->ChannelsMask[0] |= ( 1 << id );
     return LORAMAC_STATUS_OK;
 }
 
@@ -1050,16 +1044,16 @@ bool RegionCN779ChannelsRemove( ChannelRemoveParams_t* channelRemove  )
     }
 
     // Remove the channel from the list of channels
-    Channels[id] = ( ChannelParams_t ){ 0, 0, { 0 }, 0 };
+    RegionCtx->Channels[id] = ( ChannelParams_t ){ 0, 0, { 0 }, 0 };
 
-    return RegionCommonChanDisable( ChannelsMask, id, CN779_MAX_NB_CHANNELS );
+    return RegionCommonChanDisable( RegionCtx->ChannelsMask, id, CN779_MAX_NB_CHANNELS );
 }
 
 void RegionCN779SetContinuousWave( ContinuousWaveParams_t* continuousWave )
 {
-    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, Bands[Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, RegionCtx->Bands[RegionCtx->Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, RegionCtx->ChannelsMask );
     int8_t phyTxPower = 0;
-    uint32_t frequency = Channels[continuousWave->Channel].Frequency;
+    uint32_t frequency = RegionCtx->Channels[continuousWave->Channel].Frequency;
 
     // Calculate physical TX power
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, continuousWave->MaxEirp, continuousWave->AntennaGain );
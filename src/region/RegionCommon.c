@@ -29,6 +29,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 
 #include "timer.h"
 #include "utilities.h"
+#include "lpm-board.h"
 #include "LoRaMac.h"
 #include "RegionCommon.h"
 
@@ -160,7 +161,7 @@ void RegionCommonChanMaskCopy( uint16_t* channelsMaskDest, uint16_t* channelsMas
     }
 }
 
-void RegionCommonSetBandTxDone( bool joined, Band_t* band, TimerTime_t lastTxDone )
+void RegionCommonSetBandTxDone( bool joined, Band_t* band, TimerTime_t lastTxDone, TimerTime_t lastTxAirTime )
 {
     if (joined == true) {
         band->LastTxDoneTime = lastTxDone;
@@ -168,6 +169,32 @@ void RegionCommonSetBandTxDone( bool joined, Band_t* band, TimerTime_t lastTxDon
         band->LastTxDoneTime = lastTxDone;
         band->LastJoinTxDoneTime = lastTxDone;
     }
+
+    // The time-off is the time on air times the duty cycle, less the time on air
+    RegionCommonUpdateBandCredits( band, 1 );
+    if( band->TimeOff != 0 )
+    {
+        band->TimeCredits -= ( int32_t )( band->TimeOff + lastTxAirTime );
+    }
+}
+
+void RegionCommonUpdateBandCredits( Band_t* bands, uint8_t nbBands )
+{
+    uint64_t now = LpmGetRtcTime( );
+
+    for( uint8_t i = 0; i < nbBands; i++ )
+    {
+        if( bands[i].LastBandUpdateTime == 0 )
+        {
+            bands[i].TimeCredits = REGION_COMMON_DC_PERIOD;
+        }
+        else if( now > bands[i].LastBandUpdateTime )
+        {
+            bands[i].TimeCredits = ( int32_t )MIN( ( int64_t )bands[i].TimeCredits + ( int64_t )( now - bands[i].LastBandUpdateTime ),
+                                                   REGION_COMMON_DC_PERIOD );
+        }
+        bands[i].LastBandUpdateTime = now;
+    }
 }
 
 TimerTime_t RegionCommonUpdateBandTimeOff( bool joined, bool dutyCycle, Band_t* bands, uint8_t nbBands )
@@ -175,39 +202,20 @@ TimerTime_t RegionCommonUpdateBandTimeOff( bool joined, bool dutyCycle, Band_t*
     TimerTime_t nextTxDelay = ( TimerTime_t )( -1 );
 
     // Update bands Time OFF
+    RegionCommonUpdateBandCredits( bands, nbBands );
     for( uint8_t i = 0; i < nbBands; i++ )
     {
-        if( joined == false )
+        if( ( joined == true ) && ( dutyCycle == false ) )
         {
-            uint64_t txDoneTime =  MAX( TimerGetElapsedTime( bands[i].LastJoinTxDoneTime ),
-                                        ( dutyCycle == true ) ? TimerGetElapsedTime( bands[i].LastTxDoneTime ) : 0 );
-            if( bands[i].TimeOff <= txDoneTime )
-            {
-                bands[i].TimeOff = 0;
-            }
-            if( bands[i].TimeOff != 0 )
-            {
-                nextTxDelay = MIN( bands[i].TimeOff - txDoneTime, nextTxDelay );
-            }
+            nextTxDelay = 0;
+            bands[i].TimeOff = 0;
         }
         else
         {
-            if( dutyCycle == true )
-            {
-                if( bands[i].TimeOff <= TimerGetElapsedTime( bands[i].LastTxDoneTime ) )
-                {
-                    bands[i].TimeOff = 0;
-                }
-                if( bands[i].TimeOff != 0 )
-                {
-                    nextTxDelay = MIN( bands[i].TimeOff - TimerGetElapsedTime( bands[i].LastTxDoneTime ),
-                                       nextTxDelay );
-                }
-            }
-            else
+            bands[i].TimeOff = ( bands[i].TimeCredits < 0 ) ? ( TimerTime_t )( -bands[i].TimeCredits ) : 0;
+            if( bands[i].TimeOff != 0 )
             {
-                nextTxDelay = 0;
-                bands[i].TimeOff = 0;
+                nextTxDelay = MIN( bands[i].TimeOff, nextTxDelay );
             }
         }
     }
@@ -290,3 +298,51 @@ void RegionCommonRxBeaconSetup( RegionCommonRxBeaconSetupParams_t* rxBeaconSetup
 
     Radio.Rx( rxBeaconSetupParams->RxTime );
 }
+
+static uint8_t JoinSubBandOf( uint8_t channel )
+{
+    // 125 kHz channels 0 to 63, 500 kHz channels 64 to 71
+    return ( channel < 64 ) ? ( channel / 8 ) : ( channel - 64 );
+}
+
+uint8_t RegionCommonJoinSubBandFilter( uint8_t* subBand, uint8_t* trials, uint8_t* enabledChannels, uint8_t nbEnabledChannels )
+{
+    for( uint8_t n = 0; n < 8; n++ )
+    {
+        uint8_t band = ( *subBand + n ) % 8;
+        uint8_t nbChannels = 0;
+
+        for( uint8_t i = 0; i < nbEnabledChannels; i++ )
+        {
+            if( JoinSubBandOf( enabledChannels[i] ) == band )
+            {
+                enabledChannels[nbChannels++] = enabledChannels[i];
+            }
+        }
+        if( nbChannels == 0 )
+        {
+            continue;
+        }
+
+        if( n != 0 )
+        {
+            // Subband skipped
+            *subBand = band;
+            *trials = 0;
+        }
+        if( ++( *trials ) >= 2 )
+        {
+            // Both data rates tried, next subband
+            *subBand = ( band + 1 ) % 8;
+            *trials = 0;
+        }
+        return nbChannels;
+    }
+    return nbEnabledChannels;
+}
+
+void RegionCommonJoinSubBandAccepted( uint8_t channel, uint8_t* subBand, uint8_t* trials )
+{
+    *subBand = JoinSubBandOf( channel );
+    *trials = 0;
+}
@@ -39,6 +39,12 @@
 #ifndef __REGIONCOMMON_H__
 #define __REGIONCOMMON_H__
 
+/*!
+ * Duty cycle observation period [ms]. A band holds at most the time credits
+ * of one period, its whole duty cycle budget.
+ */
+#define REGION_COMMON_DC_PERIOD                     3600000
+
 typedef struct sLinkAdrParams
 {
     /*!
@@ -180,19 +186,38 @@ uint8_t RegionCommonCountChannels( uint16_t* channelsMask, uint8_t startIdx, uin
 void RegionCommonChanMaskCopy( uint16_t* channelsMaskDest, uint16_t* channelsMaskSrc, uint8_t len );
 
 /*!
- * \brief Sets the last tx done property.
+ * \brief Sets the last tx done property, and takes the time on air times the
+ *        duty cycle from the time credits of the band.
  *        This is a generic function and valid for all regions.
  *
+ * \remark The duty cycle is the one RegionXXCalcBackOff applied to the
+ *         time-off of the band for this TX, none when the time-off is 0.
+ *
  * \param [IN] joined Set to true, if the node has joined the network
  *
  * \param [IN] band The band to be updated.
  *
  * \param [IN] lastTxDone The time of the last TX done.
+ *
+ * \param [IN] lastTxAirTime The time on air of the last TX.
+ */
+void RegionCommonSetBandTxDone( bool joined, Band_t* band, TimerTime_t lastTxDone, TimerTime_t lastTxAirTime );
+
+/*!
+ * \brief Adds the time elapsed since their last update to the time credits
+ *        of the bands, up to REGION_COMMON_DC_PERIOD. A band not updated yet
+ *        starts with all its credits.
+ *        This is a generic function and valid for all regions.
+ *
+ * \param [IN] bands A pointer to the bands.
+ *
+ * \param [IN] nbBands The number of bands available.
  */
-void RegionCommonSetBandTxDone( bool joined, Band_t* band, TimerTime_t lastTxDone );
+void RegionCommonUpdateBandCredits( Band_t* bands, uint8_t nbBands );
 
 /*!
- * \brief Updates the time-offs of the bands.
+ * \brief Updates the time-offs of the bands from their time credits, a band
+ *        is off until they are back to 0.
  *        This is a generic function and valid for all regions.
  *
  * \param [IN] joined Set to true, if the node has joined the network
@@ -281,6 +306,40 @@ int8_t RegionCommonComputeTxPower( int8_t txPowerIndex, float maxEirp, float ant
  */
 void RegionCommonRxBeaconSetup( RegionCommonRxBeaconSetupParams_t* rxBeaconSetupParams );
 
+/*!
+ * \brief Restricts the channels a join request may use to one subband, for
+ *        the regions with 64 channels of 125 kHz in 8 subbands and 8 channels
+ *        of 500 kHz, one per subband.
+ *        Join requests rotate through the subbands, two per subband: one on
+ *        a 125 kHz channel of the subband and one on its 500 kHz channel, as
+ *        the join data rate alternates. Subbands without a usable channel are
+ *        skipped.
+ *
+ * \param [IN/OUT] subBand Subband of the next join request, advanced.
+ *
+ * \param [IN/OUT] trials Join requests already sent on subBand.
+ *
+ * \param [IN/OUT] enabledChannels Usable channels, only the ones of the
+ *                 chosen subband are kept.
+ *
+ * \param [IN] nbEnabledChannels Number of usable channels.
+ *
+ * \retval Returns the number of channels kept.
+ */
+uint8_t RegionCommonJoinSubBandFilter( uint8_t* subBand, uint8_t* trials, uint8_t* enabledChannels, uint8_t nbEnabledChannels );
+
+/*!
+ * \brief Makes the next join requests start on the subband of the channel
+ *        a join request was accepted on, see RegionCommonJoinSubBandFilter.
+ *
+ * \param [IN] channel Channel of the accepted join request.
+ *
+ * \param [OUT] subBand Subband of the next join request.
+ *
+ * \param [OUT] trials Join requests already sent on subBand.
+ */
+void RegionCommonJoinSubBandAccepted( uint8_t channel, uint8_t* subBand, uint8_t* trials );
+
 /*! \} defgroup REGIONCOMMON */
 
 #endif // __REGIONCOMMON_H__
@@ -42,33 +42,13 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 
 // Global attributes
 /*!
- * LoRaMAC channels
+ * LoRaMac bands, copied to the context at initialization
  */
-RTC_DATA_ATTR static ChannelParams_t Channels[LA915_MAX_NB_CHANNELS];
-
-/*!
- * LoRaMac bands
- */
-RTC_DATA_ATTR static Band_t Bands[LA915_MAX_NB_BANDS] =
+static const Band_t BandsDefault[LA915_MAX_NB_BANDS] =
 {
     LA915_BAND0
 };
 
-/*!
- * LoRaMac channels mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsMask[CHANNELS_MASK_SIZE];
-
-/*!
- * LoRaMac channels remaining
- */
-RTC_DATA_ATTR static uint16_t ChannelsMaskRemaining[CHANNELS_MASK_SIZE];
-
-/*!
- * LoRaMac channels default mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsDefaultMask[CHANNELS_MASK_SIZE];
-
 // Static functions
 static int8_t GetNextLowerTxDr( int8_t dr, int8_t minDr )
 {
@@ -280,12 +260,12 @@ PhyParam_t RegionLA915GetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS_MASK:
         {
-            phyParam.ChannelsMask = ChannelsMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsMask;
             break;
         }
         case PHY_CHANNELS_DEFAULT_MASK:
         {
-            phyParam.ChannelsMask = ChannelsDefaultMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsDefaultMask;
             break;
         }
         case PHY_MAX_NB_CHANNELS:
@@ -295,7 +275,7 @@ PhyParam_t RegionLA915GetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS:
         {
-            phyParam.Channels = Channels;
+            phyParam.Channels = RegionCtx->Channels;
             break;
         }
         case PHY_DEF_UPLINK_DWELL_TIME:
@@ -357,7 +337,7 @@ PhyParam_t RegionLA915GetPhyParam( GetPhyParams_t* getPhy )
 
 void RegionLA915SetBandTxDone( SetBandTxDoneParams_t* txDone )
 {
-    RegionCommonSetBandTxDone( txDone->Joined, &Bands[Channels[txDone->Channel].Band], txDone->LastTxDoneTime );
+    RegionCommonSetBandTxDone( txDone->Joined, &RegionCtx->Bands[RegionCtx->Channels[txDone->Channel].Band], txDone->LastTxDoneTime, txDone->LastTxAirTime );
 }
 
 void RegionLA915InitDefaults( InitType_t type )
@@ -368,45 +348,48 @@ void RegionLA915InitDefaults( InitType_t type )
     {
         case INIT_TYPE_INIT:
         {
+            // Bands
+            memcpy( RegionCtx->Bands, BandsDefault, sizeof( BandsDefault ) );
+
             // Channels
             // 125 kHz channels
             for( uint8_t i = 0; i < LA915_MAX_NB_CHANNELS - 8; i++ )
             {
-                Channels[i].Frequency = 915200000 + i * 200000;
-                Channels[i].DrRange.Value = ( DR_5 << 4 ) | DR_0;
-                Channels[i].Band = 0;
+                RegionCtx->Channels[i].Frequency = 915200000 + i * 200000;
+                RegionCtx->Channels[i].DrRange.Value = ( DR_5 << 4 ) | DR_0;
+                RegionCtx->Channels[i].Band = 0;
             }
             // 500 kHz channels
             for( uint8_t i = LA915_MAX_NB_CHANNELS - 8; i < LA915_MAX_NB_CHANNELS; i++ )
             {
-                Channels[i].Frequency = 915900000 + ( i - ( LA915_MAX_NB_CHANNELS - 8 ) ) * 1600000;
-                Channels[i].DrRange.Value = ( DR_6 << 4 ) | DR_6;
-                Channels[i].Band = 0;
+                RegionCtx->Channels[i].Frequency = 915900000 + ( i - ( LA915_MAX_NB_CHANNELS - 8 ) ) * 1600000;
+                RegionCtx->Channels[i].DrRange.Value = ( DR_6 << 4 ) | DR_6;
+                RegionCtx->Channels[i].Band = 0;
             }
 
             // Initialize channels default mask
-            ChannelsDefaultMask[0] = 0x00FF;
-            ChannelsDefaultMask[1] = 0x0000;
-            ChannelsDefaultMask[2] = 0x0000;
-            ChannelsDefaultMask[3] = 0x0000;
-            ChannelsDefaultMask[4] = 0x0000;
-            ChannelsDefaultMask[5] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[0] = 0x00FF;
+            RegionCtx->ChannelsDefaultMask[1] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[2] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[3] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[4] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[5] = 0x0000;
 
             // Copy channels default mask
-            RegionCommonChanMaskCopy( ChannelsMask, ChannelsDefaultMask, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, RegionCtx->ChannelsDefaultMask, 6 );
 
             // Copy into channels mask remaining
-            RegionCommonChanMaskCopy( ChannelsMaskRemaining, ChannelsMask, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMaskRemaining, RegionCtx->ChannelsMask, 6 );
             break;
         }
         case INIT_TYPE_RESTORE:
         {
             // Copy channels default mask
-            RegionCommonChanMaskCopy( ChannelsMask, ChannelsDefaultMask, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, RegionCtx->ChannelsDefaultMask, 6 );
 
             for( uint8_t i = 0; i < 6; i++ )
             { // Copy-And the channels mask
-                ChannelsMaskRemaining[i] &= ChannelsMask[i];
+                RegionCtx->ChannelsMaskRemaining[i] &= RegionCtx->ChannelsMask[i];
             }
             break;
         }
@@ -485,14 +468,14 @@ void RegionLA915ApplyCFList( ApplyCFListParams_t* applyCFList )
     // ChMask0 - ChMask4 must be set (every ChMask has 16 bit)
     for( uint8_t chMaskItr = 0, cntPayload = 0; chMaskItr <= 4; chMaskItr++, cntPayload+=2 )
     {
-        ChannelsMask[chMaskItr] = (uint16_t) (0x00FF & applyCFList->Payload[cntPayload]);
-        ChannelsMask[chMaskItr] |= (uint16_t) (applyCFList->Payload[cntPayload+1] << 8);
+        RegionCtx->ChannelsMask[chMaskItr] = (uint16_t) (0x00FF & applyCFList->Payload[cntPayload]);
+        RegionCtx->ChannelsMask[chMaskItr] |= (uint16_t) (applyCFList->Payload[cntPayload+1] << 8);
         if( chMaskItr == 4 )
         {
-            ChannelsMask[chMaskItr] = ChannelsMask[chMaskItr] & CHANNELS_MASK_500KHZ_MASK;
+            RegionCtx->ChannelsMask[chMaskItr] = RegionCtx->ChannelsMask[chMaskItr] & CHANNELS_MASK_500KHZ_MASK;
         }
         // Set the channel mask to the remaining
-        ChannelsMaskRemaining[chMaskItr] &= ChannelsMask[chMaskItr];
+        RegionCtx->ChannelsMaskRemaining[chMaskItr] &= RegionCtx->ChannelsMask[chMaskItr];
     }
 }
 
@@ -513,20 +496,20 @@ bool RegionLA915ChanMaskSet( ChanMaskSetParams_t* chanMaskSet )
     {
         case CHANNELS_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsMask, chanMaskSet->ChannelsMaskIn, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, chanMaskSet->ChannelsMaskIn, 6 );
 
-            ChannelsDefaultMask[4] = ChannelsDefaultMask[4] & CHANNELS_MASK_500KHZ_MASK;
-            ChannelsDefaultMask[5] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[4] = RegionCtx->ChannelsDefaultMask[4] & CHANNELS_MASK_500KHZ_MASK;
+            RegionCtx->ChannelsDefaultMask[5] = 0x0000;
 
             for( uint8_t i = 0; i < 6; i++ )
             { // Copy-And the channels mask
-                ChannelsMaskRemaining[i] &= ChannelsMask[i];
+                RegionCtx->ChannelsMaskRemaining[i] &= RegionCtx->ChannelsMask[i];
             }
             break;
         }
         case CHANNELS_DEFAULT_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 6 );
             break;
         }
         default:
@@ -582,12 +565,12 @@ bool RegionLA915AdrNext( AdrNextParams_t* adrNext, int8_t* drOut, int8_t* txPowO
                         if( adrNext->UpdateChanMask == true )
                         {
                             // Re-enable default channels
-                            ChannelsMask[0] = 0x00FF;
-                            ChannelsMask[1] = 0x0000;
-                            ChannelsMask[2] = 0x0000;
-                            ChannelsMask[3] = 0x0000;
-                            ChannelsMask[4] = 0x0000;
-                            ChannelsMask[5] = 0x0000;
+                            RegionCtx->ChannelsMask[0] = 0x00FF;
+                            RegionCtx->ChannelsMask[1] = 0x0000;
+                            RegionCtx->ChannelsMask[2] = 0x0000;
+                            RegionCtx->ChannelsMask[3] = 0x0000;
+                            RegionCtx->ChannelsMask[4] = 0x0000;
+                            RegionCtx->ChannelsMask[5] = 0x0000;
                         }
                     }
                 }
@@ -657,20 +640,20 @@ bool RegionLA915RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
 bool RegionLA915TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime_t* txTimeOnAir )
 {
     int8_t phyDr = DataratesLA915[txConfig->Datarate];
-    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, Bands[Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, RegionCtx->Bands[RegionCtx->Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, RegionCtx->ChannelsMask );
     uint32_t bandwidth = GetBandwidth( txConfig->Datarate );
     int8_t phyTxPower = 0;
 
     // Calculate physical TX power
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, txConfig->MaxEirp, txConfig->AntennaGain );
 
-    Radio.SetChannel( Channels[txConfig->Channel].Frequency );
+    Radio.SetChannel( RegionCtx->Channels[txConfig->Channel].Frequency );
 
     Radio.SetTxConfig( MODEM_LORA, phyTxPower, 0, bandwidth, phyDr, 1, LORAWAN_PREAMBLE_LENGTH, false, true, 0, 0, false, 4000 );
 
     // Setup maximum payload lenght of the radio driver
     Radio.SetMaxPayloadLength( MODEM_LORA, txConfig->PktLen );
-    DBG_PRINTF("LATX on freq %u Hz at DR %d  %d\r\n", (unsigned int)Channels[txConfig->Channel].Frequency, txConfig->Datarate ,txConfig->Channel);
+    DBG_PRINTF("LATX on freq %u Hz at DR %d  %d\r\n", (unsigned int)RegionCtx->Channels[txConfig->Channel].Frequency, txConfig->Datarate ,txConfig->Channel);
 
     *txTimeOnAir = Radio.TimeOnAir( MODEM_LORA,  txConfig->PktLen );
     *txPower = txPowerLimited;
@@ -687,7 +670,7 @@ uint8_t RegionLA915LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
     uint16_t channelsMask[6] = { 0, 0, 0, 0, 0, 0 };
 
     // Initialize local copy of channels mask
-    RegionCommonChanMaskCopy( channelsMask, ChannelsMask, 6 );
+    RegionCommonChanMaskCopy( channelsMask, RegionCtx->ChannelsMask, 6 );
 
     while( bytesProcessed < linkAdrReq->PayloadSize )
     {
@@ -789,7 +772,7 @@ uint8_t RegionLA915LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
     }
 
     // Verify datarate
-    if( RegionCommonChanVerifyDr( LA915_MAX_NB_CHANNELS, channelsMask, linkAdrParams.Datarate, LA915_TX_MIN_DATARATE, LA915_TX_MAX_DATARATE, Channels  ) == false )
+    if( RegionCommonChanVerifyDr( LA915_MAX_NB_CHANNELS, channelsMask, linkAdrParams.Datarate, LA915_TX_MIN_DATARATE, LA915_TX_MAX_DATARATE, RegionCtx->Channels  ) == false )
     {
         status &= 0xFD; // Datarate KO
     }
@@ -817,14 +800,14 @@ uint8_t RegionLA915LinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drOut, in
         }
 
         // Copy Mask
-        RegionCommonChanMaskCopy( ChannelsMask, channelsMask, 6 );
-
-        ChannelsMaskRemaining[0] &= ChannelsMask[0];
-        ChannelsMaskRemaining[1] &= ChannelsMask[1];
-        ChannelsMaskRemaining[2] &= ChannelsMask[2];
-        ChannelsMaskRemaining[3] &= ChannelsMask[3];
-        ChannelsMaskRemaining[4] = ChannelsMask[4];
-        ChannelsMaskRemaining[5] = ChannelsMask[5];
+        RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, channelsMask, 6 );
+
+        RegionCtx->ChannelsMaskRemaining[0] &= RegionCtx->ChannelsMask[0];
+        RegionCtx->ChannelsMaskRemaining[1] &= RegionCtx->ChannelsMask[1];
+        RegionCtx->ChannelsMaskRemaining[2] &= RegionCtx->ChannelsMask[2];
+        RegionCtx->ChannelsMaskRemaining[3] &= RegionCtx->ChannelsMask[3];
+        RegionCtx->ChannelsMaskRemaining[4] = RegionCtx->ChannelsMask[4];
+        RegionCtx->ChannelsMaskRemaining[5] = RegionCtx->ChannelsMask[5];
     }
 
     // Update status variables
@@ -892,7 +875,7 @@ int8_t RegionLA915AlternateDr( AlternateDrParams_t* alternateDr )
     int8_t datarate = 0;
 
     // Re-enable 500 kHz default channels
-    ChannelsMask[4] = CHANNELS_MASK_500KHZ_MASK;
+    RegionCtx->ChannelsMask[4] = CHANNELS_MASK_500KHZ_MASK;
 
     if( ( alternateDr->NbTrials & 0x01 ) == 0x01 )
     {
@@ -915,11 +898,11 @@ void RegionLA915CalcBackOff( CalcBackOffParams_t* calcBackOff )
         // Get the join duty cycle
         joinDutyCycle = RegionCommonGetJoinDc( calcBackOff->ElapsedTime );
         // Apply band time-off.
-        Bands[Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * joinDutyCycle - calcBackOff->TxTimeOnAir;
+        RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * joinDutyCycle - calcBackOff->TxTimeOnAir;
     }
     else
     {
-        Bands[Channels[channel].Band].TimeOff = 0;
+        RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = 0;
     }
 }
 
@@ -932,16 +915,16 @@ bool RegionLA915NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
     uint16_t random;
 
     // Count 125kHz channels
-    if( RegionCommonCountChannels( ChannelsMaskRemaining, 0, 4 ) == 0 )
+    if( RegionCommonCountChannels( RegionCtx->ChannelsMaskRemaining, 0, 4 ) == 0 )
     { // Reactivate default channels
-        RegionCommonChanMaskCopy( ChannelsMaskRemaining, ChannelsMask, 4  );
+        RegionCommonChanMaskCopy( RegionCtx->ChannelsMaskRemaining, RegionCtx->ChannelsMask, 4  );
     }
     // Check other channels
     if( nextChanParams->Datarate >= DR_6 )
     {
-        if( ( ChannelsMaskRemaining[4] & CHANNELS_MASK_500KHZ_MASK ) == 0 )
+        if( ( RegionCtx->ChannelsMaskRemaining[4] & CHANNELS_MASK_500KHZ_MASK ) == 0 )
         {
-            ChannelsMaskRemaining[4] = ChannelsMask[4];
+            RegionCtx->ChannelsMaskRemaining[4] = RegionCtx->ChannelsMask[4];
         }
     }
 
@@ -950,10 +933,13 @@ bool RegionLA915NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
         // Reset Aggregated time off
         *aggregatedTimeOff = 0;
 
+        // Update bands Time OFF
+        nextTxDelay = RegionCommonUpdateBandTimeOff( nextChanParams->Joined, nextChanParams->DutyCycleEnabled, RegionCtx->Bands, LA915_MAX_NB_BANDS );
+
         // Search how many channels are enabled
         nbEnabledChannels = CountNbOfEnabledChannels( nextChanParams->Datarate,
-                                                      ChannelsMaskRemaining, Channels,
-                                                      Bands, enabledChannels, &delayTx );
+                                                      RegionCtx->ChannelsMaskRemaining, RegionCtx->Channels,
+                                                      RegionCtx->Bands, enabledChannels, &delayTx );
     }
     else
     {
@@ -968,7 +954,7 @@ bool RegionLA915NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel,
         random = randr( 0, nbEnabledChannels - 1 );
         *channel = enabledChannels[randr( 0, nbEnabledChannels - 1 )];
         // Disable the channel in the mask
-        RegionCommonChanDisable( ChannelsMaskRemaining, *channel, LA915_MAX_NB_CHANNELS - 8 );
+        RegionCommonChanDisable( RegionCtx->ChannelsMaskRemaining, *channel, LA915_MAX_NB_CHANNELS - 8 );
 
         *time = 0;
         return true;
@@ -999,9 +985,9 @@ bool RegionLA915ChannelsRemove( ChannelRemoveParams_t* channelRemove  )
 
 void RegionLA915SetContinuousWave( ContinuousWaveParams_t* continuousWave )
 {
-    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, Bands[Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, RegionCtx->Bands[RegionCtx->Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, RegionCtx->ChannelsMask );
     int8_t phyTxPower = 0;
-    uint32_t frequency = Channels[continuousWave->Channel].Frequency;
+    uint32_t frequency = RegionCtx->Channels[continuousWave->Channel].Frequency;
 
     // Calculate physical TX power
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, continuousWave->MaxEirp, continuousWave->AntennaGain );
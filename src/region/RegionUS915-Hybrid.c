@@ -42,33 +42,13 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jae
 
 // Global attributes
 /*!
- * LoRaMAC channels
+ * LoRaMac bands, copied to the context at initialization
  */
-RTC_DATA_ATTR static ChannelParams_t Channels[US915_HYBRID_MAX_NB_CHANNELS];
-
-/*!
- * LoRaMac bands
- */
-RTC_DATA_ATTR static Band_t Bands[US915_HYBRID_MAX_NB_BANDS] =
+static const Band_t BandsDefault[US915_HYBRID_MAX_NB_BANDS] =
 {
     US915_HYBRID_BAND0
 };
 
-/*!
- * LoRaMac channels mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsMask[CHANNELS_MASK_SIZE];
-
-/*!
- * LoRaMac channels remaining
- */
-RTC_DATA_ATTR static uint16_t ChannelsMaskRemaining[CHANNELS_MASK_SIZE];
-
-/*!
- * LoRaMac channels default mask
- */
-RTC_DATA_ATTR static uint16_t ChannelsDefaultMask[CHANNELS_MASK_SIZE];
-
 // Static functions
 static int8_t GetNextLowerTxDr( int8_t dr, int8_t minDr )
 {
@@ -341,12 +321,12 @@ PhyParam_t RegionUS915HybridGetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS_MASK:
         {
-            phyParam.ChannelsMask = ChannelsMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsMask;
             break;
         }
         case PHY_CHANNELS_DEFAULT_MASK:
         {
-            phyParam.ChannelsMask = ChannelsDefaultMask;
+            phyParam.ChannelsMask = RegionCtx->ChannelsDefaultMask;
             break;
         }
         case PHY_MAX_NB_CHANNELS:
@@ -356,7 +336,7 @@ PhyParam_t RegionUS915HybridGetPhyParam( GetPhyParams_t* getPhy )
         }
         case PHY_CHANNELS:
         {
-            phyParam.Channels = Channels;
+            phyParam.Channels = RegionCtx->Channels;
             break;
         }
         case PHY_DEF_UPLINK_DWELL_TIME:
@@ -415,7 +395,7 @@ PhyParam_t RegionUS915HybridGetPhyParam( GetPhyParams_t* getPhy )
 
 void RegionUS915HybridSetBandTxDone( SetBandTxDoneParams_t* txDone )
 {
-    RegionCommonSetBandTxDone( txDone->Joined, &Bands[Channels[txDone->Channel].Band], txDone->LastTxDoneTime );
+    RegionCommonSetBandTxDone( txDone->Joined, &RegionCtx->Bands[RegionCtx->Channels[txDone->Channel].Band], txDone->LastTxDoneTime, txDone->LastTxAirTime );
 }
 
 void RegionUS915HybridInitDefaults( InitType_t type )
@@ -424,44 +404,47 @@ void RegionUS915HybridInitDefaults( InitType_t type )
     {
         case INIT_TYPE_INIT:
         {
+            // Bands
+            memcpy( RegionCtx->Bands, BandsDefault, sizeof( BandsDefault ) );
+
             // Channels
             // 125 kHz channels
             for( uint8_t i = 0; i < US915_HYBRID_MAX_NB_CHANNELS - 8; i++ )
             {
-                Channels[i].Frequency = 902300000 + i * 200000;
-                Channels[i].DrRange.Value = ( DR_3 << 4 ) | DR_0;
-                Channels[i].Band = 0;
+                RegionCtx->Channels[i].Frequency = 902300000 + i * 200000;
+                RegionCtx->Channels[i].DrRange.Value = ( DR_3 << 4 ) | DR_0;
+                RegionCtx->Channels[i].Band = 0;
             }
             // 500 kHz channels
             for( uint8_t i = US915_HYBRID_MAX_NB_CHANNELS - 8; i < US915_HYBRID_MAX_NB_CHANNELS; i++ )
             {
-                Channels[i].Frequency = 903000000 + ( i - ( US915_HYBRID_MAX_NB_CHANNELS - 8 ) ) * 1600000;
-                Channels[i].DrRange.Value = ( DR_4 << 4 ) | DR_4;
-                Channels[i].Band = 0;
+                RegionCtx->Channels[i].Frequency = 903000000 + ( i - ( US915_HYBRID_MAX_NB_CHANNELS - 8 ) ) * 1600000;
+                RegionCtx->Channels[i].DrRange.Value = ( DR_4 << 4 ) | DR_4;
+                RegionCtx->Channels[i].Band = 0;
             }
 
             // ChannelsMask
-            ChannelsDefaultMask[0] = 0x00FF;
-            ChannelsDefaultMask[1] = 0x0000;
-            ChannelsDefaultMask[2] = 0x0000;
-            ChannelsDefaultMask[3] = 0x0000;
-            ChannelsDefaultMask[4] = 0x0001;
-            ChannelsDefaultMask[5] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[0] = 0x00FF;
+            RegionCtx->ChannelsDefaultMask[1] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[2] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[3] = 0x0000;
+            RegionCtx->ChannelsDefaultMask[4] = 0x0001;
+            RegionCtx->ChannelsDefaultMask[5] = 0x0000;
 
             // Copy channels default mask
-            RegionCommonChanMaskCopy( ChannelsMask, ChannelsDefaultMask, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, RegionCtx->ChannelsDefaultMask, 6 );
 
             // Copy into channels mask remaining
-            RegionCommonChanMaskCopy( ChannelsMaskRemaining, ChannelsMask, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMaskRemaining, RegionCtx->ChannelsMask, 6 );
             break;
         }
         case INIT_TYPE_RESTORE:
         {
-            ReenableChannels( ChannelsDefaultMask[4], ChannelsMask );
+            ReenableChannels( RegionCtx->ChannelsDefaultMask[4], RegionCtx->ChannelsMask );
 
             for( uint8_t i = 0; i < 6; i++ )
             { // Copy-And the channels mask
-                ChannelsMaskRemaining[i] &= ChannelsMask[i];
+                RegionCtx->ChannelsMaskRemaining[i] &= RegionCtx->ChannelsMask[i];
             }
         }
         default:
@@ -537,17 +520,17 @@ bool RegionUS915HybridChanMaskSet( ChanMaskSetParams_t* chanMaskSet )
     {
         case CHANNELS_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsMask, chanMaskSet->ChannelsMaskIn, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, chanMaskSet->ChannelsMaskIn, 6 );
 
             for( uint8_t i = 0; i < 6; i++ )
             { // Copy-And the channels mask
-                ChannelsMaskRemaining[i] &= ChannelsMask[i];
+                RegionCtx->ChannelsMaskRemaining[i] &= RegionCtx->ChannelsMask[i];
             }
             break;
         }
         case CHANNELS_DEFAULT_MASK:
         {
-            RegionCommonChanMaskCopy( ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 6 );
+            RegionCommonChanMaskCopy( RegionCtx->ChannelsDefaultMask, chanMaskSet->ChannelsMaskIn, 6 );
             break;
         }
         default:
@@ -603,7 +586,7 @@ bool RegionUS915HybridAdrNext( AdrNextParams_t* adrNext, int8_t* drOut, int8_t*
                         if( adrNext->UpdateChanMask == true )
                         {
                             // Re-enable default channels
-                            ReenableChannels( ChannelsMask[4], ChannelsMask );
+                            ReenableChannels( RegionCtx->ChannelsMask[4], RegionCtx->ChannelsMask );
                         }
                     }
                 }
@@ -681,18 +664,18 @@ bool RegionUS915HybridRxConfig( RxConfigParams_t* rxConfig, int8_t* datarate )
 bool RegionUS915HybridTxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime_t* txTimeOnAir )
 {
     int8_t phyDr = DataratesUS915_HYBRID[txConfig->Datarate];
-    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, Bands[Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( txConfig->TxPower, RegionCtx->Bands[RegionCtx->Channels[txConfig->Channel].Band].TxMaxPower, txConfig->Datarate, RegionCtx->ChannelsMask );
     uint32_t bandwidth = GetBandwidth( txConfig->Datarate );
     int8_t phyTxPower = 0;
 
     // Calculate physical TX power
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, US915_HYBRID_DEFAULT_MAX_ERP, 0 );
 
-    Radio.SetChannel( Channels[txConfig->Channel].Frequency );
+    Radio.SetChannel( RegionCtx->Channels[txConfig->Channel].Frequency );
 
     Radio.SetMaxPayloadLength( MODEM_LORA, txConfig->PktLen );
     Radio.SetTxConfig( MODEM_LORA, phyTxPower, 0, bandwidth, phyDr, 1, LORAWAN_PREAMBLE_LENGTH, false, true, 0, 0, false, 3e3 );
-    DBG_PRINTF("TX on freq %u Hz at DR %d\r\n", (unsigned int)Channels[txConfig->Channel].Frequency, txConfig->Datarate);
+    DBG_PRINTF("TX on freq %u Hz at DR %d\r\n", (unsigned int)RegionCtx->Channels[txConfig->Channel].Frequency, txConfig->Datarate);
 
     *txTimeOnAir = Radio.TimeOnAir( MODEM_LORA,  txConfig->PktLen );
     *txPower = txPowerLimited;
@@ -709,7 +692,7 @@ uint8_t RegionUS915HybridLinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drO
     uint16_t channelsMask[6] = { 0, 0, 0, 0, 0, 0 };
 
     // Initialize local copy of channels mask
-    RegionCommonChanMaskCopy( channelsMask, ChannelsMask, 6 );
+    RegionCommonChanMaskCopy( channelsMask, RegionCtx->ChannelsMask, 6 );
 
     while( bytesProcessed < linkAdrReq->PayloadSize )
     {
@@ -767,7 +750,7 @@ uint8_t RegionUS915HybridLinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drO
     }
 
     // Verify datarate
-    if( RegionCommonChanVerifyDr( US915_HYBRID_MAX_NB_CHANNELS, channelsMask, linkAdrParams.Datarate, US915_HYBRID_TX_MIN_DATARATE, US915_HYBRID_TX_MAX_DATARATE, Channels  ) == false )
+    if( RegionCommonChanVerifyDr( US915_HYBRID_MAX_NB_CHANNELS, channelsMask, linkAdrParams.Datarate, US915_HYBRID_TX_MIN_DATARATE, US915_HYBRID_TX_MAX_DATARATE, RegionCtx->Channels  ) == false )
     {
         status &= 0xFD; // Datarate KO
     }
@@ -795,14 +778,14 @@ uint8_t RegionUS915HybridLinkAdrReq( LinkAdrReqParams_t* linkAdrReq, int8_t* drO
         }
 
         // Copy Mask
-        RegionCommonChanMaskCopy( ChannelsMask, channelsMask, 6 );
+        RegionCommonChanMaskCopy( RegionCtx->ChannelsMask, channelsMask, 6 );
 
-        ChannelsMaskRemaining[0] &= ChannelsMask[0];
-        ChannelsMaskRemaining[1] &= ChannelsMask[1];
-        ChannelsMaskRemaining[2] &= ChannelsMask[2];
-        ChannelsMaskRemaining[3] &= ChannelsMask[3];
-        ChannelsMaskRemaining[4] = ChannelsMask[4];
-        ChannelsMaskRemaining[5] = ChannelsMask[5];
+        RegionCtx->ChannelsMaskRemaining[0] &= RegionCtx->ChannelsMask[0];
+        RegionCtx->ChannelsMaskRemaining[1] &= RegionCtx->ChannelsMask[1];
+        RegionCtx->ChannelsMaskRemaining[2] &= RegionCtx->ChannelsMask[2];
+        RegionCtx->ChannelsMaskRemaining[3] &= RegionCtx->ChannelsMask[3];
+        RegionCtx->ChannelsMaskRemaining[4] = RegionCtx->ChannelsMask[4];
+        RegionCtx->ChannelsMaskRemaining[5] = RegionCtx->ChannelsMask[5];
     }
 
     // Update status variables
@@ -869,7 +852,7 @@ int8_t RegionUS915HybridAlternateDr( AlternateDrParams_t* alternateDr )
     int8_t datarate = 0;
 
     // Re-enable 500 kHz default channels
-    ReenableChannels( ChannelsMask[4], ChannelsMask );
+    ReenableChannels( RegionCtx->ChannelsMask[4], RegionCtx->ChannelsMask );
 
     if( ( alternateDr->NbTrials & 0x01 ) == 0x01 )
     {
@@ -892,11 +875,11 @@ void RegionUS915HybridCalcBackOff( CalcBackOffParams_t* calcBackOff )
         // Get the join duty cycle
         joinDutyCycle = RegionCommonGetJoinDc( calcBackOff->ElapsedTime );
         // Apply band time-off.
-        Bands[Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * joinDutyCycle - calcBackOff->TxTimeOnAir;
+        RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = calcBackOff->TxTimeOnAir * joinDutyCycle - calcBackOff->TxTimeOnAir;
     }
     else
     {
-        Bands[Channels[channel].Band].TimeOff = 0;
+        RegionCtx->Bands[RegionCtx->Channels[channel].Band].TimeOff = 0;
     }
 }
 
@@ -908,16 +891,16 @@ bool RegionUS915HybridNextChannel( NextChanParams_t* nextChanParams, uint8_t* ch
     TimerTime_t nextTxDelay = 0;
 
     // Count 125kHz channels
-    if( RegionCommonCountChannels( ChannelsMaskRemaining, 0, 4 ) == 0 )
+    if( RegionCommonCountChannels( RegionCtx->ChannelsMaskRemaining, 0, 4 ) == 0 )
     { // Reactivate default channels
-        RegionCommonChanMaskCopy( ChannelsMaskRemaining, ChannelsMask, 4  );
+        RegionCommonChanMaskCopy( RegionCtx->ChannelsMaskRemaining, RegionCtx->ChannelsMask, 4  );
     }
     // Check other channels
     if( nextChanParams->Datarate >= DR_4 )
     {
-        if( ( ChannelsMaskRemaining[4] & 0x00FF ) == 0 )
+        if( ( RegionCtx->ChannelsMaskRemaining[4] & 0x00FF ) == 0 )
         {
-            ChannelsMaskRemaining[4] = ChannelsMask[4];
+            RegionCtx->ChannelsMaskRemaining[4] = RegionCtx->ChannelsMask[4];
         }
     }
 
@@ -927,12 +910,19 @@ bool RegionUS915HybridNextChannel( NextChanParams_t* nextChanParams, uint8_t* ch
         *aggregatedTimeOff = 0;
 
         // Update bands Time OFF
-        nextTxDelay = RegionCommonUpdateBandTimeOff( nextChanParams->Joined, nextChanParams->DutyCycleEnabled, Bands, US915_HYBRID_MAX_NB_BANDS );
+        nextTxDelay = RegionCommonUpdateBandTimeOff( nextChanParams->Joined, nextChanParams->DutyCycleEnabled, RegionCtx->Bands, US915_HYBRID_MAX_NB_BANDS );
 
-        // Search how many channels are enabled
+        // Search how many channels are enabled, join requests use the whole mask
         nbEnabledChannels = CountNbOfEnabledChannels( nextChanParams->Datarate,
-                                                      ChannelsMaskRemaining, Channels,
-                                                      Bands, enabledChannels, &delayTx );
+                                                      ( nextChanParams->Joined == true ) ? RegionCtx->ChannelsMaskRemaining : RegionCtx->ChannelsMask,
+                                                      RegionCtx->Channels, RegionCtx->Bands, enabledChannels, &delayTx );
+
+        if( ( nextChanParams->Joined == false ) && ( nbEnabledChannels > 0 ) )
+        {
+            // Join requests rotate through the subbands
+            nbEnabledChannels = RegionCommonJoinSubBandFilter( &RegionCtx->JoinSubBand, &RegionCtx->JoinSubBandTrials,
+                                                               enabledChannels, nbEnabledChannels );
+        }
     }
     else
     {
@@ -945,7 +935,7 @@ bool RegionUS915HybridNextChannel( NextChanParams_t* nextChanParams, uint8_t* ch
         // We found a valid channel
         *channel = enabledChannels[randr( 0, nbEnabledChannels - 1 )];
         // Disable the channel in the mask
-        RegionCommonChanDisable( ChannelsMaskRemaining, *channel, US915_HYBRID_MAX_NB_CHANNELS - 8 );
+        RegionCommonChanDisable( RegionCtx->ChannelsMaskRemaining, *channel, US915_HYBRID_MAX_NB_CHANNELS - 8 );
 
         *time = 0;
         return true;
@@ -964,6 +954,11 @@ bool RegionUS915HybridNextChannel( NextChanParams_t* nextChanParams, uint8_t* ch
     }
 }
 
+void RegionUS915HybridJoinAccepted( uint8_t channel )
+{
+    RegionCommonJoinSubBandAccepted( channel, &RegionCtx->JoinSubBand, &RegionCtx->JoinSubBandTrials );
+}
+
 LoRaMacStatus_t RegionUS915HybridChannelAdd( ChannelAddParams_t* channelAdd )
 {
     return LORAMAC_STATUS_PARAMETER_INVALID;
@@ -976,9 +971,9 @@ bool RegionUS915HybridChannelsRemove( ChannelRemoveParams_t* channelRemove  )
 
 void RegionUS915HybridSetContinuousWave( ContinuousWaveParams_t* continuousWave )
 {
-    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, Bands[Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, ChannelsMask );
+    int8_t txPowerLimited = LimitTxPower( continuousWave->TxPower, RegionCtx->Bands[RegionCtx->Channels[continuousWave->Channel].Band].TxMaxPower, continuousWave->Datarate, RegionCtx->ChannelsMask );
     int8_t phyTxPower = 0;
-    uint32_t frequency = Channels[continuousWave->Channel].Frequency;
+    uint32_t frequency = RegionCtx->Channels[continuousWave->Channel].Frequency;
 
     // Calculate physical TX power
     phyTxPower = RegionCommonComputeTxPower( txPowerLimited, US915_HYBRID_DEFAULT_MAX_ERP, 0 );
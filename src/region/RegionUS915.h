@@ -454,6 +454,14 @@ void RegionUS915CalcBackOff( CalcBackOffParams_t* calcBackOff );
  */
 bool RegionUS915NextChannel( NextChanParams_t* nextChanParams, uint8_t* channel, TimerTime_t* time, TimerTime_t* aggregatedTimeOff );
 
+/*!
+ * \brief Makes the next join requests start on the subband of the channel
+ *        a join request was accepted on.
+ *
+ * \param [IN] channel Channel of the accepted join request.
+ */
+void RegionUS915JoinAccepted( uint8_t channel );
+
 /*!
  * \brief Adds a channel.
  *
@@ -0,0 +1,187 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Temperature model of the ESP32 150 kHz RTC slow clock drift
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <math.h>
+#include "soc/rtc.h"
+#include "esp_clk.h"
+#include "utilities.h"
+#include "lpm-board.h"
+#include "rtc-drift.h"
+
+/*!
+ * Nominal 150 kHz slow clock period, in us with RTC_CLK_CAL_FRACT fractional bits
+ */
+#define RTC_DRIFT_NOMINAL_CAL                       ( ( 1000000.0f / 150000.0f ) * ( 1 << RTC_CLK_CAL_FRACT ) )
+
+/*!
+ * Measurements of a bin after which its average becomes exponential
+ */
+#define RTC_DRIFT_MIN_SAMPLES                       8
+
+/*!
+ * Share of the network time error moved into the bias
+ */
+#define RTC_DRIFT_BIAS_GAIN                         0.5f
+
+/*!
+ * Model, kept in RTC memory so that it survives deep sleep
+ */
+RTC_DATA_ATTR static RtcDriftStatus_t RtcDrift;
+
+/*!
+ * Set once a temperature is known
+ */
+RTC_DATA_ATTR static bool TemperatureValid = false;
+
+/*!
+ * Slow clock calibration before the first one set by the model
+ */
+RTC_DATA_ATTR static uint32_t BootCal = 0;
+
+/*!
+ * Sleep time at the last network time [ms]
+ */
+RTC_DATA_ATTR static TimerTime_t SyncSleepTime = 0;
+
+static uint8_t GetBin( float temperature )
+{
+    int32_t bin = ( int32_t )floorf( ( temperature - RTC_DRIFT_TEMPERATURE_MIN ) / RTC_DRIFT_TEMPERATURE_STEP );
+
+    return ( uint8_t )MIN( MAX( bin, 0 ), RTC_DRIFT_TEMPERATURE_BINS - 1 );
+}
+
+static TimerTime_t GetSleepTime( void )
+{
+    LpmStatus_t status;
+
+    LpmGetStatus( &status );
+    return status.LightSleepTime + status.DeepSleepTime;
+}
+
+void RtcDriftUpdate( float temperature )
+{
+    uint32_t cal = rtc_clk_cal( RTC_CAL_RTC_MUX, RTC_DRIFT_CAL_CYCLES );
+    uint8_t bin = GetBin( temperature );
+    float ppm;
+    float alpha;
+
+    if( cal == 0 )
+    {
+        // The slow clock did not run the cycles in time
+        return;
+    }
+    ppm = ( ( float )cal / RTC_DRIFT_NOMINAL_CAL - 1.0f ) * 1e6f;
+
+    if( RtcDrift.Samples[bin] < UINT16_MAX )
+    {
+        RtcDrift.Samples[bin]++;
+    }
+    alpha = ( RtcDrift.Samples[bin] < RTC_DRIFT_MIN_SAMPLES ) ? 1.0f / RtcDrift.Samples[bin] : 1.0f / RTC_DRIFT_MIN_SAMPLES;
+    RtcDrift.Ppm[bin] += alpha * ( ppm - RtcDrift.Ppm[bin] );
+    RtcDrift.Temperature = temperature;
+    TemperatureValid = true;
+}
+
+void RtcDriftSync( int32_t error )
+{
+    TimerTime_t sleepTime = GetSleepTime( );
+    TimerTime_t slept = sleepTime - SyncSleepTime;
+    float ppm;
+
+    // The time is kept by the crystal while awake, the error builds up in sleep
+    if( ( RtcDrift.Syncs > 0 ) && ( slept >= RTC_DRIFT_MIN_SYNC_SLEEP ) )
+    {
+        ppm = ( ( float )error * 1e6f ) / ( float )slept;
+        if( fabsf( ppm ) <= RTC_DRIFT_MAX_SYNC_PPM )
+        {
+            RtcDrift.BiasPpm += RTC_DRIFT_BIAS_GAIN * ppm;
+        }
+    }
+    RtcDrift.Syncs++;
+    RtcDrift.SyncError = error;
+    SyncSleepTime = sleepTime;
+}
+
+bool RtcDriftGetPpm( float temperature, float *ppm )
+{
+    int8_t bin = GetBin( temperature );
+    int8_t below = -1;
+    int8_t above = -1;
+    int8_t i;
+
+    for( i = bin; i >= 0; i-- )
+    {
+        if( RtcDrift.Samples[i] > 0 )
+        {
+            below = i;
+            break;
+        }
+    }
+    for( i = bin; i < RTC_DRIFT_TEMPERATURE_BINS; i++ )
+    {
+        if( RtcDrift.Samples[i] > 0 )
+        {
+            above = i;
+            break;
+        }
+    }
+    if( ( below < 0 ) && ( above < 0 ) )
+    {
+        return false;
+    }
+
+    // Interpolate between the closest measured temperatures, hold the
+    // extreme ones outside
+    if( below < 0 )
+    {
+        *ppm = RtcDrift.Ppm[above];
+    }
+    else if( ( above < 0 ) || ( above == below ) )
+    {
+        *ppm = RtcDrift.Ppm[below];
+    }
+    else
+    {
+        *ppm = RtcDrift.Ppm[below] + ( RtcDrift.Ppm[above] - RtcDrift.Ppm[below] ) * ( bin - below ) / ( above - below );
+    }
+    *ppm += RtcDrift.BiasPpm;
+    return true;
+}
+
+void RtcDriftApply( void )
+{
+    float ppm;
+
+    if( BootCal == 0 )
+    {
+        BootCal = esp_clk_slowclk_cal_get( );
+    }
+    if( ( TemperatureValid == false ) || ( RtcDriftGetPpm( RtcDrift.Temperature, &ppm ) == false ) )
+    {
+        // Without temperature, only the bias learned from the network time
+        // corrects the boot calibration
+        if( RtcDrift.BiasPpm == 0.0f )
+        {
+            return;
+        }
+        ppm = ( ( float )BootCal / RTC_DRIFT_NOMINAL_CAL * ( 1.0f + RtcDrift.BiasPpm / 1e6f ) - 1.0f ) * 1e6f;
+    }
+    esp_clk_slowclk_cal_set( ( uint32_t )( RTC_DRIFT_NOMINAL_CAL * ( 1.0f + ppm / 1e6f ) ) );
+    RtcDrift.AppliedPpm = ppm;
+}
+
+void RtcDriftGetStatus( RtcDriftStatus_t *status )
+{
+    *status = RtcDrift;
+}
@@ -0,0 +1,125 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Temperature model of the ESP32 150 kHz RTC slow clock drift
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __RTC_DRIFT_H__
+#define __RTC_DRIFT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Temperature range of the model, in bins of RTC_DRIFT_TEMPERATURE_STEP [degC]
+ */
+#define RTC_DRIFT_TEMPERATURE_MIN                   -40
+#define RTC_DRIFT_TEMPERATURE_STEP                  5
+#define RTC_DRIFT_TEMPERATURE_BINS                  26
+
+/*!
+ * Slow clock cycles counted against the crystal by a measurement, 1024
+ * cycles take about 7 ms
+ */
+#define RTC_DRIFT_CAL_CYCLES                        1024
+
+/*!
+ * Sleep time between two network times below which they are not used [ms]
+ */
+#define RTC_DRIFT_MIN_SYNC_SLEEP                    600000
+
+/*!
+ * Drift between two network times above which the local time is taken as
+ * reset rather than drifting [ppm]
+ */
+#define RTC_DRIFT_MAX_SYNC_PPM                      1000
+
+/*!
+ * Slow clock drift status
+ */
+typedef struct sRtcDriftStatus
+{
+    /*!
+     * Measurements and mean period error in ppm of the nominal 150 kHz, per
+     * temperature bin
+     */
+    uint16_t Samples[RTC_DRIFT_TEMPERATURE_BINS];
+    float Ppm[RTC_DRIFT_TEMPERATURE_BINS];
+    /*!
+     * Period error in sleep not seen by the measurements, learned from the
+     * network time [ppm]
+     */
+    float BiasPpm;
+    /*!
+     * Temperature of the last measurement [degC]
+     */
+    float Temperature;
+    /*!
+     * Period error applied to the slow clock calibration [ppm]
+     */
+    float AppliedPpm;
+    /*!
+     * Network times received and error of the last one, positive when the
+     * local time was late [ms]
+     */
+    uint32_t Syncs;
+    int32_t SyncError;
+}RtcDriftStatus_t;
+
+/*!
+ * \brief Measures the slow clock period against the crystal and adds it to
+ *        the model
+ *
+ * \param [IN] temperature Board temperature [degC]
+ */
+void RtcDriftUpdate( float temperature );
+
+/*!
+ * \brief Adds the error of the local time found by a network time
+ *
+ * \param [IN] error Network time minus local time [ms]
+ */
+void RtcDriftSync( int32_t error );
+
+/*!
+ * \brief Returns the slow clock period error predicted by the model
+ *
+ * \param [IN]  temperature Board temperature [degC]
+ * \param [OUT] ppm         Period error [ppm]
+ *
+ * \retval [false: no measurement yet, true: ppm valid]
+ */
+bool RtcDriftGetPpm( float temperature, float *ppm );
+
+/*!
+ * \brief Sets the slow clock calibration, used to time the sleeps and to
+ *        keep the time across them, to the period predicted at the last
+ *        temperature. Without temperature, the boot calibration is only
+ *        corrected by the bias learned from the network time.
+ */
+void RtcDriftApply( void );
+
+/*!
+ * \brief Returns the slow clock drift status
+ *
+ * \param [OUT] status Copy of the status
+ */
+void RtcDriftGetStatus( RtcDriftStatus_t *status );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __RTC_DRIFT_H__
@@ -32,6 +32,14 @@ THE SOFTWARE.
 
 #include "HDC1080.h"
 
+// Conversion times [us]
+#define HDC1080_TEMPERATURE_14BIT_TIME	6350
+#define HDC1080_TEMPERATURE_11BIT_TIME	3650
+#define HDC1080_HUMIDITY_14BIT_TIME		6500
+#define HDC1080_HUMIDITY_11BIT_TIME		3850
+#define HDC1080_HUMIDITY_8BIT_TIME		2500
+
+HDC1080 *HDC1080::_acquiring = NULL;
 
 HDC1080::HDC1080()
 {
@@ -39,6 +47,11 @@ HDC1080::HDC1080()
 
 void HDC1080::begin(uint8_t address) {
 	_address = address;
+	_config.rawData = 0;
+	_configLost = false;
+	_state = HDC1080_ACQUISITION_IDLE;
+	TimerStop(&_timer);
+	TimerInit(&_timer, onAcquisitionTimerEvent);
 	Wire.begin();
 
 	setResolution(HDC1080_RESOLUTION_14BIT, HDC1080_RESOLUTION_14BIT);
@@ -50,7 +63,7 @@ void HDC1080::end() {
 
 
 void HDC1080::setResolution(HDC1080_MeasurementResolution humidity, HDC1080_MeasurementResolution temperature) {
-	HDC1080_Registers reg;
+	HDC1080_Registers reg = _config;
 	reg.HumidityMeasurementResolution = 0;
 	reg.TemperatureMeasurementResolution = 0;
 
@@ -87,12 +100,28 @@ HDC1080_Registers HDC1080::readRegister() {
 }
 
 void HDC1080::writeRegister(HDC1080_Registers reg) {
+	writeConfiguration(reg);
+	if (reg.SoftwareReset) {
+		reg.rawData = 0x10; // reset values: sequential acquisition, 14 bits
+		delay(HDC1080_POWER_UP_TIME);
+	}
+	_config = reg;
+	updateAcquisitionTime();
+}
+
+bool HDC1080::writeConfiguration(HDC1080_Registers reg) {
 	Wire.beginTransmission(_address);
 	Wire.write(HDC1080_CONFIGURATION);
 	Wire.write(reg.rawData);
 	Wire.write(0x00);
-	Wire.endTransmission();
-	delay(10);
+	return Wire.endTransmission() == 0;
+}
+
+void HDC1080::setSequentialMode(bool sequential) {
+	if (_config.ModeOfAcquisition != sequential) {
+		_config.ModeOfAcquisition = sequential;
+		writeConfiguration(_config);
+	}
 }
 
 void HDC1080::heatUp(uint8_t seconds) {
@@ -121,8 +150,9 @@ double HDC1080::readT() {
 }
 
 double HDC1080::readTemperature() {
+	setSequentialMode(false);
 	uint16_t rawT = readData(HDC1080_TEMPERATURE);
-	return (rawT / pow(2, 16)) * 165.0 - 40.0;
+	return rawT * (165.0 / 65536) - 40.0;
 }
 
 double HDC1080::readH() {
@@ -130,8 +160,143 @@ double HDC1080::readH() {
 }
 
 double HDC1080::readHumidity() {
+	setSequentialMode(false);
 	uint16_t rawH = readData(HDC1080_HUMIDITY);
-	return (rawH / pow(2, 16)) * 100.0;
+	return rawH * (100.0 / 65536);
+}
+
+int16_t HDC1080::toCentiCelsius(uint16_t raw) {
+	// raw / 2^16 * 165 - 40 C, rounded
+	return (int16_t)(((uint32_t)raw * 16500 + 0x8000) >> 16) - 4000;
+}
+
+uint16_t HDC1080::toCentiPercent(uint16_t raw) {
+	// raw / 2^16 * 100 %RH, rounded
+	return (uint16_t)(((uint32_t)raw * 10000 + 0x8000) >> 16);
+}
+
+void HDC1080::updateAcquisitionTime() {
+	uint32_t time = _config.TemperatureMeasurementResolution ? HDC1080_TEMPERATURE_11BIT_TIME : HDC1080_TEMPERATURE_14BIT_TIME;
+
+	switch (_config.HumidityMeasurementResolution)
+	{
+		case 0x02:
+			time += HDC1080_HUMIDITY_8BIT_TIME;
+			break;
+		case 0x01:
+			time += HDC1080_HUMIDITY_11BIT_TIME;
+			break;
+		default:
+			time += HDC1080_HUMIDITY_14BIT_TIME;
+			break;
+	}
+
+	// Rounded up, plus the 1 ms resolution of the timer
+	_acquisitionTime = (time + 999) / 1000 + 1;
+}
+
+uint16_t HDC1080::acquisitionTime() {
+	return _acquisitionTime;
+}
+
+bool HDC1080::startAcquisition(uint16_t powerUpDelay, void (*onReady)(void)) {
+	TimerStop(&_timer);
+	_acquiring = this;
+	_onReady = onReady;
+
+	if (powerUpDelay > 0) {
+		// Powered up, the configuration is back to its reset values
+		_configLost = true;
+		_state = HDC1080_ACQUISITION_POWER_UP;
+		startStepTimer(powerUpDelay);
+		return true;
+	}
+
+	triggerAcquisition();
+	return _state == HDC1080_ACQUISITION_CONVERTING;
+}
+
+void HDC1080::triggerAcquisition() {
+	HDC1080_Registers reg = _config;
+	reg.ModeOfAcquisition = 1;
+
+	if (_configLost || !_config.ModeOfAcquisition) {
+		if (!writeConfiguration(reg)) {
+			_state = HDC1080_ACQUISITION_FAILED;
+			return;
+		}
+		_config = reg;
+		_configLost = false;
+	}
+
+	// Pointing the temperature register starts both conversions
+	Wire.beginTransmission(_address);
+	Wire.write(HDC1080_TEMPERATURE);
+	if (Wire.endTransmission() != 0) {
+		_state = HDC1080_ACQUISITION_FAILED;
+		return;
+	}
+	_state = HDC1080_ACQUISITION_CONVERTING;
+	startStepTimer(_acquisitionTime);
+}
+
+void HDC1080::startStepTimer(uint16_t duration) {
+	_stepEnd = millis() + duration;
+	TimerSetValue(&_timer, duration);
+	TimerStart(&_timer);
+}
+
+void HDC1080::onAcquisitionTimerEvent() {
+	if (_acquiring != NULL)
+		_acquiring->endStep();
+}
+
+void HDC1080::endStep() {
+	TimerStop(&_timer);
+
+	if (_state == HDC1080_ACQUISITION_POWER_UP) {
+		triggerAcquisition();
+		if (_state == HDC1080_ACQUISITION_CONVERTING)
+			return;
+	} else if (_state == HDC1080_ACQUISITION_CONVERTING) {
+		_state = HDC1080_ACQUISITION_READY;
+	} else {
+		return;
+	}
+
+	if (_onReady)
+		_onReady();
+}
+
+HDC1080_AcquisitionState HDC1080::acquisitionState() {
+	// The step may be over before its timer event is run, e.g. without sleep
+	if (((_state == HDC1080_ACQUISITION_POWER_UP) || (_state == HDC1080_ACQUISITION_CONVERTING)) &&
+		((int32_t)(millis() - _stepEnd) >= 0))
+		endStep();
+	return _state;
+}
+
+bool HDC1080::readAcquisition(HDC1080_Measurement *measurement) {
+	HDC1080_AcquisitionState state;
+
+	while (((state = acquisitionState()) == HDC1080_ACQUISITION_POWER_UP) || (state == HDC1080_ACQUISITION_CONVERTING)) {
+		int32_t remaining = (int32_t)(_stepEnd - millis());
+		if (remaining > 0)
+			delay(remaining);
+	}
+	_state = HDC1080_ACQUISITION_IDLE;
+	if (state != HDC1080_ACQUISITION_READY)
+		return false;
+
+	// Temperature then humidity, read in one transfer
+	uint8_t buf[4];
+	Wire.requestFrom(_address, (uint8_t)4);
+	if (Wire.readBytes(buf, (size_t)4) != 4)
+		return false;
+
+	measurement->temperature = toCentiCelsius(buf[0] << 8 | buf[1]);
+	measurement->humidity = toCentiPercent(buf[2] << 8 | buf[3]);
+	return true;
 }
 
 uint16_t HDC1080::readManufacturerId() {
@@ -32,6 +32,9 @@ THE SOFTWARE.
 
 #define _HDC1080_h
 #include <Arduino.h>
+#include "timer.h"
+
+#define HDC1080_POWER_UP_TIME	15	// Start-up time after power-on or a software reset [ms]
 
 typedef enum {
 	HDC1080_RESOLUTION_8BIT,
@@ -72,6 +75,19 @@ typedef union {
 	};
 } HDC1080_Registers;
 
+typedef enum {
+	HDC1080_ACQUISITION_IDLE,
+	HDC1080_ACQUISITION_POWER_UP,
+	HDC1080_ACQUISITION_CONVERTING,
+	HDC1080_ACQUISITION_READY,
+	HDC1080_ACQUISITION_FAILED,
+} HDC1080_AcquisitionState;
+
+typedef struct {
+	int16_t temperature;	// [0.01 C]
+	uint16_t humidity;		// [0.01 %RH]
+} HDC1080_Measurement;
+
 class HDC1080 {
 public:
 	HDC1080();
@@ -96,9 +112,36 @@ public:
 	double readT(); // short-cut for readTemperature
 	double readH(); // short-cut for readHumidity
 
+	// Asynchronous acquisition: temperature and humidity are converted in one
+	// sequence, a timer event ends each step. One acquisition at a time.
+	bool startAcquisition(uint16_t powerUpDelay = 0, void (*onReady)(void) = NULL);
+	HDC1080_AcquisitionState acquisitionState();
+	bool readAcquisition(HDC1080_Measurement *measurement); // waits the rest of the conversion
+	uint16_t acquisitionTime(); // [ms], conversions at the current resolutions
+
+	static int16_t toCentiCelsius(uint16_t raw);
+	static uint16_t toCentiPercent(uint16_t raw);
+
 private:
 	uint8_t _address;
+	HDC1080_Registers _config;
+	bool _configLost;
+	uint16_t _acquisitionTime;
+	volatile HDC1080_AcquisitionState _state;
+	uint32_t _stepEnd;
+	TimerEvent_t _timer;
+	void (*_onReady)(void);
+
+	static HDC1080 *_acquiring;
+	static void onAcquisitionTimerEvent();
+
 	uint16_t readData(uint8_t pointer);
+	bool writeConfiguration(HDC1080_Registers reg);
+	void updateAcquisitionTime();
+	void setSequentialMode(bool sequential);
+	void triggerAcquisition();
+	void endStep();
+	void startStepTimer(uint16_t duration);
 
 };
 
@@ -0,0 +1,82 @@
+/*!
+ * \file      spi-board.cpp
+ *
+ * \brief     Target board SPI driver implementation
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \code
+ *                ______                              _
+ *               / _____)             _              | |
+ *              ( (____  _____ ____ _| |_ _____  ____| |__
+ *               \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ *               _____) ) ____| | | || |_| ____( (___| | | |
+ *              (______/|_____)_|_|_| \__)_____)\____)_| |_|
+ *              (C)2013-2017 Semtech
+ *
+ * \endcode
+ *
+ * \author    Miguel Luis ( Semtech )
+ *
+ * \author    Gregory Cristian ( Semtech )
+ */
+#include <Arduino.h>
+#include <SPI.h>
+#include "lorawan_spi.h"
+
+/*!
+ * SPI_1 is the Arduino SPI object, shared with Mcu.init, SPI_2 the HSPI
+ * peripheral
+ */
+static SPIClass Spi2( HSPI );
+
+/*!
+ * Transfer settings of each peripheral
+ */
+static uint32_t SpiHz[2] = { 8000000, 8000000 };
+static uint8_t SpiMode[2] = { SPI_MODE0, SPI_MODE0 };
+
+static SPIClass* SpiGetPeripheral( Spi_t *obj )
+{
+    return ( obj->SpiId == SPI_2 ) ? &Spi2 : &SPI;
+}
+
+void SpiInit( Spi_t *obj, SpiId_t spiId, uint8_t mosi, uint8_t miso, uint8_t sclk, uint8_t nss )
+{
+    obj->SpiId = spiId;
+    obj->Mosi.pin = mosi;
+    obj->Miso.pin = miso;
+    obj->Sclk.pin = sclk;
+
+    // The chip select is driven by the radio drivers, not by the peripheral
+    SpiGetPeripheral( obj )->begin( sclk, miso, mosi, -1 );
+}
+
+void SpiDeInit( Spi_t *obj )
+{
+    SpiGetPeripheral( obj )->end( );
+}
+
+void SpiFormat( Spi_t *obj, int8_t bits, int8_t cpol, int8_t cpha, int8_t slave )
+{
+    // Only 8 bits master transfers are supported
+    SpiMode[obj->SpiId] = ( cpol == 0 ) ? ( ( cpha == 0 ) ? SPI_MODE0 : SPI_MODE1 ) :
+                                          ( ( cpha == 0 ) ? SPI_MODE2 : SPI_MODE3 );
+}
+
+void SpiFrequency( Spi_t *obj, uint32_t hz )
+{
+    SpiHz[obj->SpiId] = hz;
+}
+
+uint16_t SpiInOut( Spi_t *obj, uint16_t outData )
+{
+    SPIClass *spi = SpiGetPeripheral( obj );
+    uint8_t inData;
+
+    spi->beginTransaction( SPISettings( SpiHz[obj->SpiId], MSBFIRST, SpiMode[obj->SpiId] ) );
+    inData = spi->transfer( ( uint8_t )outData );
+    spi->endTransaction( );
+
+    return inData;
+}
@@ -0,0 +1,879 @@
+/*!
+ * \file      sx126x-radio.c
+ *
+ * \brief     Radio driver API definition for the SX126x transceivers
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \code
+ *                ______                              _
+ *               / _____)             _              | |
+ *              ( (____  _____ ____ _| |_ _____  ____| |__
+ *               \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ *               _____) ) ____| | | || |_| ____( (___| | | |
+ *              (______/|_____)_|_|_| \__)_____)\____)_| |_|
+ *              (C)2013-2017 Semtech
+ *
+ * \endcode
+ *
+ * \author    Miguel Luis ( Semtech )
+ *
+ * \author    Gregory Cristian ( Semtech )
+ */
+#if defined( RADIO_SX126X )
+#include <math.h>
+#include <string.h>
+#include "utilities.h"
+#include "timer.h"
+#include "delay.h"
+#include "radio.h"
+#include "sx126x.h"
+#include "sx126x-board.h"
+
+/*!
+ * FSK bandwidth definition
+ */
+typedef struct
+{
+    uint32_t bandwidth;
+    uint8_t  RegValue;
+}FskBandwidth_t;
+
+/*!
+ * Precomputed FSK bandwidth registers values
+ */
+const FskBandwidth_t FskBandwidths[] =
+{
+    { 4800  , 0x1F },
+    { 5800  , 0x17 },
+    { 7300  , 0x0F },
+    { 9700  , 0x1E },
+    { 11700 , 0x16 },
+    { 14600 , 0x0E },
+    { 19500 , 0x1D },
+    { 23400 , 0x15 },
+    { 29300 , 0x0D },
+    { 39000 , 0x1C },
+    { 46900 , 0x14 },
+    { 58600 , 0x0C },
+    { 78200 , 0x1B },
+    { 93800 , 0x13 },
+    { 117300, 0x0B },
+    { 156200, 0x1A },
+    { 187200, 0x12 },
+    { 234300, 0x0A },
+    { 312000, 0x19 },
+    { 373600, 0x11 },
+    { 467000, 0x09 },
+    { 500000, 0x00 }, // Invalid Bandwidth
+};
+
+/*!
+ * LoRa bandwidths, indexed by the Radio API bandwidth [0: 125 kHz, 1: 250 kHz, 2: 500 kHz]
+ */
+const RadioLoRaBandwidths_t Bandwidths[] = { LORA_BW_125, LORA_BW_250, LORA_BW_500 };
+static const uint32_t BandwidthsHz[] = { 125000, 250000, 500000 };
+
+/*!
+ * CAD peak detection threshold per spreading factor, SF7 to SF12
+ */
+static const uint8_t CadDetPeak[] = { 22, 22, 24, 25, 25, 28 };
+
+/*!
+ * CAD minimum detection threshold
+ */
+#define RADIO_CAD_DET_MIN                           10
+
+/*!
+ * Radio callbacks variable
+ */
+static RadioEvents_t* RadioEvents;
+
+/*!
+ * Reception buffer
+ */
+static uint8_t RadioRxPayload[RX_BUFFER_SIZE];
+
+/*!
+ * Current modem settings
+ */
+static bool RxContinuous = false;
+static uint32_t TxTimeout = 0;
+static uint8_t MaxPayloadLength = 0xFF;
+static uint8_t LoRaBandwidth = 0;
+static bool PublicNetwork = true;
+
+/*!
+ * Set when the running CAD moves to reception on activity
+ */
+static bool CadToRx = false;
+
+/*!
+ * DIO1 and continuous wave timer events, handled by RadioIrqProcess
+ */
+static volatile bool IrqFired = false;
+static volatile bool CwTimeoutFired = false;
+
+/*!
+ * micros( ) at the last DIO1 IRQ, before RadioIrqProcess reads its cause
+ */
+static volatile uint32_t IrqTime = 0;
+
+/*!
+ * Continuous wave duration timer
+ */
+static TimerEvent_t TxCwTimer;
+
+/*
+ * Radio driver functions implementation
+ */
+
+static void RadioInit( RadioEvents_t *events );
+static RadioState_t RadioGetStatus( void );
+static void RadioSetModem( RadioModems_t modem );
+static void RadioSetChannel( uint32_t freq );
+static bool RadioIsChannelFree( RadioModems_t modem, uint32_t freq, int16_t rssiThresh, uint32_t maxCarrierSenseTime );
+static uint32_t RadioRandom( void );
+static void RadioSetRxConfig( RadioModems_t modem, uint32_t bandwidth,
+                              uint32_t datarate, uint8_t coderate,
+                              uint32_t bandwidthAfc, uint16_t preambleLen,
+                              uint16_t symbTimeout, bool fixLen,
+                              uint8_t payloadLen,
+                              bool crcOn, bool freqHopOn, uint8_t hopPeriod,
+                              bool iqInverted, bool rxContinuous );
+static void RadioSetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
+                              uint32_t bandwidth, uint32_t datarate,
+                              uint8_t coderate, uint16_t preambleLen,
+                              bool fixLen, bool crcOn, bool freqHopOn,
+                              uint8_t hopPeriod, bool iqInverted, uint32_t timeout );
+static uint32_t RadioTimeOnAir( RadioModems_t modem, uint8_t pktLen );
+static void RadioSend( uint8_t *buffer, uint8_t size );
+static void RadioSleep( void );
+static void RadioStandby( void );
+static void RadioRx( uint32_t timeout );
+static void RadioStartCad( void );
+static void RadioSetTxContinuousWave( uint32_t freq, int8_t power, uint16_t time );
+static int16_t RadioRssi( RadioModems_t modem );
+static void RadioWrite( uint16_t addr, uint8_t data );
+static uint8_t RadioRead( uint16_t addr );
+static void RadioWriteBuffer( uint16_t addr, uint8_t *buffer, uint8_t size );
+static void RadioReadBuffer( uint16_t addr, uint8_t *buffer, uint8_t size );
+static void RadioSetMaxPayloadLength( RadioModems_t modem, uint8_t max );
+static void RadioSetPublicNetwork( bool enable );
+static uint32_t RadioGetWakeupTime( void );
+static void RadioIrqProcess( void );
+static void RadioStartCarrierSense( RadioModems_t modem, uint32_t freq );
+static uint32_t RadioGetCapabilities( void );
+static void RadioRxBoosted( uint32_t timeout );
+static void RadioSetRxDutyCycle( uint32_t rxTime, uint32_t sleepTime );
+static void RadioStartCadRx( uint32_t timeout );
+static uint32_t RadioGetIrqTime( void );
+
+/*!
+ * Radio driver structure initialization
+ */
+const struct Radio_s Radio =
+{
+    RadioInit,
+    RadioGetStatus,
+    RadioSetModem,
+    RadioSetChannel,
+    RadioIsChannelFree,
+    RadioRandom,
+    RadioSetRxConfig,
+    RadioSetTxConfig,
+    SX126xCheckRfFrequency,
+    RadioTimeOnAir,
+    RadioSend,
+    RadioSleep,
+    RadioStandby,
+    RadioRx,
+    RadioStartCad,
+    RadioSetTxContinuousWave,
+    RadioRssi,
+    RadioWrite,
+    RadioRead,
+    RadioWriteBuffer,
+    RadioReadBuffer,
+    RadioSetMaxPayloadLength,
+    RadioSetPublicNetwork,
+    RadioGetWakeupTime,
+    RadioIrqProcess,
+    RadioStartCarrierSense,
+    RadioGetCapabilities,
+    RadioRxBoosted,
+    RadioSetRxDutyCycle,
+    RadioStartCadRx,
+    RadioGetIrqTime
+};
+
+/*!
+ * \brief DIO1 IRQ callback
+ */
+static void RadioOnDioIrq( void )
+{
+    IrqTime = micros( );
+    IrqFired = true;
+}
+
+/*!
+ * \brief Continuous wave timer callback
+ */
+static void RadioOnCwTimeoutIrq( void )
+{
+    CwTimeoutFired = true;
+}
+
+/*!
+ * \brief Returns the register value of the closest FSK bandwidth
+ *
+ * \param [IN] bandwidth Double side band bandwidth [Hz]
+ * \retval regValue Bandwidth register value
+ */
+static uint8_t RadioGetFskBandwidthRegValue( uint32_t bandwidth )
+{
+    uint8_t i;
+
+    if( bandwidth == 0 )
+    {
+        return( 0x1F );
+    }
+
+    for( i = 0; i < ( sizeof( FskBandwidths ) / sizeof( FskBandwidth_t ) ) - 1; i++ )
+    {
+        if( ( bandwidth >= FskBandwidths[i].bandwidth ) && ( bandwidth < FskBandwidths[i + 1].bandwidth ) )
+        {
+            return FskBandwidths[i+1].RegValue;
+        }
+    }
+    // ERROR: Value not found
+    while( 1 );
+}
+
+/*!
+ * \brief Fills the LoRa modulation parameters shared by Tx and Rx configurations
+ */
+static void RadioSetLoRaModulation( uint32_t bandwidth, uint32_t datarate, uint8_t coderate )
+{
+    SX126x.ModulationParams.PacketType = PACKET_TYPE_LORA;
+    SX126x.ModulationParams.Params.LoRa.SpreadingFactor = ( RadioLoRaSpreadingFactors_t )datarate;
+    SX126x.ModulationParams.Params.LoRa.Bandwidth = Bandwidths[bandwidth];
+    SX126x.ModulationParams.Params.LoRa.CodingRate = ( RadioLoRaCodingRates_t )coderate;
+
+    if( ( ( bandwidth == 0 ) && ( ( datarate == 11 ) || ( datarate == 12 ) ) ) ||
+        ( ( bandwidth == 1 ) && ( datarate == 12 ) ) )
+    {
+        SX126x.ModulationParams.Params.LoRa.LowDatarateOptimize = 0x01;
+    }
+    else
+    {
+        SX126x.ModulationParams.Params.LoRa.LowDatarateOptimize = 0x00;
+    }
+    LoRaBandwidth = bandwidth;
+}
+
+/*!
+ * \brief Implicit header mode timeout workaround, see datasheet chapter 15.3
+ */
+static void RadioStopRtc( void )
+{
+    SX126xWriteRegister( REG_RTC_CTRL, 0x00 );
+    SX126xWriteRegister( REG_EVT_CLR, SX126xReadRegister( REG_EVT_CLR ) | ( 1 << 1 ) );
+}
+
+static void RadioInit( RadioEvents_t *events )
+{
+    RadioEvents = events;
+
+    SX126xIoInit( );
+    SX126xInit( RadioOnDioIrq );
+
+    TimerInit( &TxCwTimer, RadioOnCwTimeoutIrq );
+
+    IrqFired = false;
+    CwTimeoutFired = false;
+}
+
+static RadioState_t RadioGetStatus( void )
+{
+    switch( SX126xGetOperatingMode( ) )
+    {
+        case MODE_TX:
+            return RF_TX_RUNNING;
+        case MODE_RX:
+        case MODE_RX_DC:
+            return RF_RX_RUNNING;
+        case MODE_CAD:
+            return RF_CAD;
+        default:
+            return RF_IDLE;
+    }
+}
+
+static void RadioSetModem( RadioModems_t modem )
+{
+    switch( modem )
+    {
+    default:
+    case MODEM_FSK:
+        SX126xSetPacketType( PACKET_TYPE_GFSK );
+        break;
+    case MODEM_LORA:
+        SX126xSetPacketType( PACKET_TYPE_LORA );
+        // The sync word is reset by the packet type change
+        RadioSetPublicNetwork( PublicNetwork );
+        break;
+    }
+}
+
+static void RadioSetChannel( uint32_t freq )
+{
+    SX126xSetRfFrequency( freq );
+}
+
+static bool RadioIsChannelFree( RadioModems_t modem, uint32_t freq, int16_t rssiThresh, uint32_t maxCarrierSenseTime )
+{
+    bool status = true;
+    int16_t rssi = 0;
+    TimerTime_t carrierSenseTime = 0;
+
+    RadioStartCarrierSense( modem, freq );
+
+    DelayMs( 1 );
+
+    carrierSenseTime = TimerGetCurrentTime( );
+
+    // Perform carrier sense for maxCarrierSenseTime
+    while( TimerGetElapsedTime( carrierSenseTime ) < maxCarrierSenseTime )
+    {
+        rssi = RadioRssi( modem );
+
+        if( rssi > rssiThresh )
+        {
+            status = false;
+            break;
+        }
+    }
+    RadioSleep( );
+    return status;
+}
+
+static uint32_t RadioRandom( void )
+{
+    RadioSetModem( MODEM_LORA );
+
+    // Disable LoRa modem interrupts
+    SX126xSetDioIrqParams( IRQ_RADIO_NONE, IRQ_RADIO_NONE, IRQ_RADIO_NONE, IRQ_RADIO_NONE );
+
+    return SX126xGetRandom( );
+}
+
+static void RadioSetRxConfig( RadioModems_t modem, uint32_t bandwidth,
+                              uint32_t datarate, uint8_t coderate,
+                              uint32_t bandwidthAfc, uint16_t preambleLen,
+                              uint16_t symbTimeout, bool fixLen,
+                              uint8_t payloadLen,
+                              bool crcOn, bool freqHopOn, uint8_t hopPeriod,
+                              bool iqInverted, bool rxContinuous )
+{
+    uint8_t syncWord[8] = { 0xC1, 0x94, 0xC1, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+    RxContinuous = rxContinuous;
+    if( rxContinuous == true )
+    {
+        symbTimeout = 0;
+    }
+    MaxPayloadLength = ( fixLen == true ) ? payloadLen : 0xFF;
+
+    switch( modem )
+    {
+        case MODEM_FSK:
+            SX126xSetStopRxTimerOnPreambleDetect( false );
+            SX126x.ModulationParams.PacketType = PACKET_TYPE_GFSK;
+
+            SX126x.ModulationParams.Params.Gfsk.BitRate = datarate;
+            SX126x.ModulationParams.Params.Gfsk.ModulationShaping = MOD_SHAPING_G_BT_1;
+            SX126x.ModulationParams.Params.Gfsk.Bandwidth = RadioGetFskBandwidthRegValue( bandwidth << 1 );
+
+            SX126x.PacketParams.PacketType = PACKET_TYPE_GFSK;
+            SX126x.PacketParams.Params.Gfsk.PreambleLength = ( preambleLen << 3 ); // convert byte into bit
+            SX126x.PacketParams.Params.Gfsk.PreambleMinDetect = RADIO_PREAMBLE_DETECTOR_08_BITS;
+            SX126x.PacketParams.Params.Gfsk.SyncWordLength = 3 << 3; // convert byte into bit
+            SX126x.PacketParams.Params.Gfsk.AddrComp = RADIO_ADDRESSCOMP_FILT_OFF;
+            SX126x.PacketParams.Params.Gfsk.HeaderType = ( fixLen == true ) ? RADIO_PACKET_FIXED_LENGTH : RADIO_PACKET_VARIABLE_LENGTH;
+            SX126x.PacketParams.Params.Gfsk.PayloadLength = MaxPayloadLength;
+            SX126x.PacketParams.Params.Gfsk.CrcLength = ( crcOn == true ) ? RADIO_CRC_2_BYTES_CCIT : RADIO_CRC_OFF;
+            SX126x.PacketParams.Params.Gfsk.DcFree = RADIO_DC_FREEWHITENING;
+
+            RadioStandby( );
+            RadioSetModem( MODEM_FSK );
+            SX126xSetModulationParams( &SX126x.ModulationParams );
+            SX126xSetPacketParams( &SX126x.PacketParams );
+            SX126xSetSyncWord( syncWord );
+            SX126xSetWhiteningSeed( 0x01FF );
+            break;
+
+        case MODEM_LORA:
+            SX126xSetStopRxTimerOnPreambleDetect( false );
+            SX126xSetLoRaSymbNumTimeout( symbTimeout );
+            RadioSetLoRaModulation( bandwidth, datarate, coderate );
+
+            SX126x.PacketParams.PacketType = PACKET_TYPE_LORA;
+            if( ( ( datarate == LORA_SF5 ) || ( datarate == LORA_SF6 ) ) && ( preambleLen < 12 ) )
+            {
+                // SF5 and SF6 need at least 12 preamble symbols
+                preambleLen = 12;
+            }
+            SX126x.PacketParams.Params.LoRa.PreambleLength = preambleLen;
+            SX126x.PacketParams.Params.LoRa.HeaderType = ( RadioLoRaPacketLengthsMode_t )fixLen;
+            SX126x.PacketParams.Params.LoRa.PayloadLength = MaxPayloadLength;
+            SX126x.PacketParams.Params.LoRa.CrcMode = ( RadioLoRaCrcModes_t )crcOn;
+            SX126x.PacketParams.Params.LoRa.InvertIQ = ( RadioLoRaIQModes_t )iqInverted;
+
+            RadioStandby( );
+            RadioSetModem( MODEM_LORA );
+            SX126xSetModulationParams( &SX126x.ModulationParams );
+            SX126xSetPacketParams( &SX126x.PacketParams );
+            break;
+    }
+}
+
+static void RadioSetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
+                              uint32_t bandwidth, uint32_t datarate,
+                              uint8_t coderate, uint16_t preambleLen,
+                              bool fixLen, bool crcOn, bool freqHopOn,
+                              uint8_t hopPeriod, bool iqInverted, uint32_t timeout )
+{
+    uint8_t syncWord[8] = { 0xC1, 0x94, 0xC1, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+    switch( modem )
+    {
+        case MODEM_FSK:
+            SX126x.ModulationParams.PacketType = PACKET_TYPE_GFSK;
+            SX126x.ModulationParams.Params.Gfsk.BitRate = datarate;
+            SX126x.ModulationParams.Params.Gfsk.ModulationShaping = MOD_SHAPING_G_BT_1;
+            SX126x.ModulationParams.Params.Gfsk.Bandwidth = RadioGetFskBandwidthRegValue( bandwidth << 1 );
+            SX126x.ModulationParams.Params.Gfsk.Fdev = fdev;
+
+            SX126x.PacketParams.PacketType = PACKET_TYPE_GFSK;
+            SX126x.PacketParams.Params.Gfsk.PreambleLength = ( preambleLen << 3 ); // convert byte into bit
+            SX126x.PacketParams.Params.Gfsk.PreambleMinDetect = RADIO_PREAMBLE_DETECTOR_08_BITS;
+            SX126x.PacketParams.Params.Gfsk.SyncWordLength = 3 << 3 ; // convert byte into bit
+            SX126x.PacketParams.Params.Gfsk.AddrComp = RADIO_ADDRESSCOMP_FILT_OFF;
+            SX126x.PacketParams.Params.Gfsk.HeaderType = ( fixLen == true ) ? RADIO_PACKET_FIXED_LENGTH : RADIO_PACKET_VARIABLE_LENGTH;
+            SX126x.PacketParams.Params.Gfsk.CrcLength = ( crcOn == true ) ? RADIO_CRC_2_BYTES_CCIT : RADIO_CRC_OFF;
+            SX126x.PacketParams.Params.Gfsk.DcFree = RADIO_DC_FREEWHITENING;
+
+            RadioStandby( );
+            RadioSetModem( MODEM_FSK );
+            SX126xSetModulationParams( &SX126x.ModulationParams );
+            SX126xSetPacketParams( &SX126x.PacketParams );
+            SX126xSetSyncWord( syncWord );
+            SX126xSetWhiteningSeed( 0x01FF );
+            break;
+
+        case MODEM_LORA:
+            RadioSetLoRaModulation( bandwidth, datarate, coderate );
+
+            SX126x.PacketParams.PacketType = PACKET_TYPE_LORA;
+            if( ( ( datarate == LORA_SF5 ) || ( datarate == LORA_SF6 ) ) && ( preambleLen < 12 ) )
+            {
+                // SF5 and SF6 need at least 12 preamble symbols
+                preambleLen = 12;
+            }
+            SX126x.PacketParams.Params.LoRa.PreambleLength = preambleLen;
+            SX126x.PacketParams.Params.LoRa.HeaderType = ( RadioLoRaPacketLengthsMode_t )fixLen;
+            SX126x.PacketParams.Params.LoRa.PayloadLength = MaxPayloadLength;
+            SX126x.PacketParams.Params.LoRa.CrcMode = ( RadioLoRaCrcModes_t )crcOn;
+            SX126x.PacketParams.Params.LoRa.InvertIQ = ( RadioLoRaIQModes_t )iqInverted;
+
+            RadioStandby( );
+            RadioSetModem( MODEM_LORA );
+            SX126xSetModulationParams( &SX126x.ModulationParams );
+            SX126xSetPacketParams( &SX126x.PacketParams );
+            break;
+    }
+    SX126xSetRfTxPower( power );
+    TxTimeout = timeout;
+}
+
+static uint32_t RadioTimeOnAir( RadioModems_t modem, uint8_t pktLen )
+{
+    uint32_t numerator = 0;
+    uint32_t denominator = 1;
+
+    switch( modem )
+    {
+    case MODEM_FSK:
+        {
+            PacketParams_t *params = &SX126x.PacketParams;
+
+            numerator = 1000U * ( params->Params.Gfsk.PreambleLength +
+                                  ( ( params->Params.Gfsk.HeaderType == RADIO_PACKET_FIXED_LENGTH ) ? 0 : 8 ) +
+                                  params->Params.Gfsk.SyncWordLength +
+                                  ( ( pktLen + ( ( params->Params.Gfsk.CrcLength == RADIO_CRC_OFF ) ? 0 : 2 ) ) << 3 ) );
+            denominator = SX126x.ModulationParams.Params.Gfsk.BitRate;
+        }
+        break;
+    case MODEM_LORA:
+        {
+            int32_t datarate = SX126x.ModulationParams.Params.LoRa.SpreadingFactor;
+            int32_t ceilDenominator;
+            int32_t ceilNumerator = ( pktLen << 3 ) +
+                                    ( ( SX126x.PacketParams.Params.LoRa.CrcMode == LORA_CRC_ON ) ? 16 : 0 ) -
+                                    ( 4 * datarate ) +
+                                    ( ( SX126x.PacketParams.Params.LoRa.HeaderType == LORA_PACKET_FIXED_LENGTH ) ? 0 : 20 );
+            int32_t intermediate;
+
+            if( datarate <= 6 )
+            {
+                ceilDenominator = 4 * datarate;
+            }
+            else
+            {
+                ceilNumerator += 8;
+                if( SX126x.ModulationParams.Params.LoRa.LowDatarateOptimize != 0 )
+                {
+                    ceilDenominator = 4 * ( datarate - 2 );
+                }
+                else
+                {
+                    ceilDenominator = 4 * datarate;
+                }
+            }
+            if( ceilNumerator < 0 )
+            {
+                ceilNumerator = 0;
+            }
+
+            // Symbols of the payload plus 4.25 preamble overhead, counted in quarter symbols
+            intermediate = ( ( ceilNumerator + ceilDenominator - 1 ) / ceilDenominator ) *
+                           ( SX126x.ModulationParams.Params.LoRa.CodingRate + 4 ) +
+                           SX126x.PacketParams.Params.LoRa.PreambleLength + 12;
+            if( datarate <= 6 )
+            {
+                intermediate += 2;
+            }
+            numerator = 1000U * ( uint32_t )( ( 4 * intermediate + 1 ) * ( 1 << ( datarate - 2 ) ) );
+            denominator = BandwidthsHz[LoRaBandwidth];
+        }
+        break;
+    }
+    // Time on air in ms, rounded up
+    return ( numerator + denominator - 1 ) / denominator;
+}
+
+static void RadioSend( uint8_t *buffer, uint8_t size )
+{
+    SX126xSetDioIrqParams( IRQ_TX_DONE | IRQ_RX_TX_TIMEOUT,
+                           IRQ_TX_DONE | IRQ_RX_TX_TIMEOUT,
+                           IRQ_RADIO_NONE,
+                           IRQ_RADIO_NONE );
+
+    if( SX126xGetPacketType( ) == PACKET_TYPE_LORA )
+    {
+        SX126x.PacketParams.Params.LoRa.PayloadLength = size;
+    }
+    else
+    {
+        SX126x.PacketParams.Params.Gfsk.PayloadLength = size;
+    }
+    SX126xSetPacketParams( &SX126x.PacketParams );
+
+    // The timeout is handled by the radio, 15.625 us steps
+    SX126xSendPayload( buffer, size, TxTimeout << 6 );
+}
+
+static void RadioSleep( void )
+{
+    // Warm start, the configuration is retained
+    SX126xSetSleep( 0x04 );
+
+    DelayMs( 2 );
+}
+
+static void RadioStandby( void )
+{
+    SX126xSetStandby( STDBY_RC );
+}
+
+static void RadioRx( uint32_t timeout )
+{
+    SX126xSetDioIrqParams( IRQ_RADIO_ALL, IRQ_RADIO_ALL, IRQ_RADIO_NONE, IRQ_RADIO_NONE );
+
+    if( RxContinuous == true )
+    {
+        SX126xSetRx( 0xFFFFFF ); // Rx Continuous
+    }
+    else
+    {
+        SX126xSetRx( timeout << 6 );
+    }
+}
+
+static void RadioRxBoosted( uint32_t timeout )
+{
+    SX126xSetDioIrqParams( IRQ_RADIO_ALL, IRQ_RADIO_ALL, IRQ_RADIO_NONE, IRQ_RADIO_NONE );
+
+    if( RxContinuous == true )
+    {
+        SX126xSetRxBoosted( 0xFFFFFF ); // Rx Continuous
+    }
+    else
+    {
+        SX126xSetRxBoosted( timeout << 6 );
+    }
+}
+
+static void RadioSetRxDutyCycle( uint32_t rxTime, uint32_t sleepTime )
+{
+    SX126xSetDioIrqParams( IRQ_RADIO_ALL, IRQ_RADIO_ALL, IRQ_RADIO_NONE, IRQ_RADIO_NONE );
+    SX126xSetRxDutyCycle( rxTime, sleepTime );
+}
+
+/*!
+ * \brief Starts a CAD with the thresholds of the current spreading factor
+ *
+ * \param [IN] exitMode CAD only or CAD followed by a reception
+ * \param [IN] timeout  Reception timeout [15.625 us steps]
+ */
+static void RadioCad( RadioCadExitModes_t exitMode, uint32_t timeout )
+{
+    int8_t sf = SX126x.ModulationParams.Params.LoRa.SpreadingFactor;
+    uint8_t index = ( sf < 7 ) ? 0 : ( ( sf > 12 ) ? 5 : sf - 7 );
+
+    CadToRx = ( exitMode == LORA_CAD_RX );
+    SX126xSetCadParams( LORA_CAD_02_SYMBOL, CadDetPeak[index], RADIO_CAD_DET_MIN, exitMode, timeout );
+    SX126xSetCad( );
+}
+
+static void RadioStartCad( void )
+{
+    SX126xSetDioIrqParams( IRQ_CAD_DONE | IRQ_CAD_ACTIVITY_DETECTED, IRQ_CAD_DONE | IRQ_CAD_ACTIVITY_DETECTED, IRQ_RADIO_NONE, IRQ_RADIO_NONE );
+    RadioCad( LORA_CAD_ONLY, 0 );
+}
+
+static void RadioStartCadRx( uint32_t timeout )
+{
+    SX126xSetDioIrqParams( IRQ_RADIO_ALL, IRQ_RADIO_ALL, IRQ_RADIO_NONE, IRQ_RADIO_NONE );
+    RadioCad( LORA_CAD_RX, timeout << 6 );
+}
+
+static void RadioSetTxContinuousWave( uint32_t freq, int8_t power, uint16_t time )
+{
+    SX126xSetRfFrequency( freq );
+    SX126xSetRfTxPower( power );
+    SX126xSetTxContinuousWave( );
+
+    TimerSetValue( &TxCwTimer, time * 1000 );
+    TimerStart( &TxCwTimer );
+}
+
+static int16_t RadioRssi( RadioModems_t modem )
+{
+    return SX126xGetRssiInst( );
+}
+
+static void RadioWrite( uint16_t addr, uint8_t data )
+{
+    SX126xWriteRegister( addr, data );
+}
+
+static uint8_t RadioRead( uint16_t addr )
+{
+    return SX126xReadRegister( addr );
+}
+
+static void RadioWriteBuffer( uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+    SX126xWriteRegisters( addr, buffer, size );
+}
+
+static void RadioReadBuffer( uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+    SX126xReadRegisters( addr, buffer, size );
+}
+
+static void RadioSetMaxPayloadLength( RadioModems_t modem, uint8_t max )
+{
+    if( modem == MODEM_LORA )
+    {
+        SX126x.PacketParams.Params.LoRa.PayloadLength = MaxPayloadLength = max;
+        SX126xSetPacketParams( &SX126x.PacketParams );
+    }
+    else
+    {
+        if( SX126x.PacketParams.Params.Gfsk.HeaderType == RADIO_PACKET_VARIABLE_LENGTH )
+        {
+            SX126x.PacketParams.Params.Gfsk.PayloadLength = MaxPayloadLength = max;
+            SX126xSetPacketParams( &SX126x.PacketParams );
+        }
+    }
+}
+
+static void RadioSetPublicNetwork( bool enable )
+{
+    uint16_t syncWord = ( enable == true ) ? LORA_MAC_PUBLIC_SYNCWORD : LORA_MAC_PRIVATE_SYNCWORD;
+
+    PublicNetwork = enable;
+    if( SX126xGetPacketType( ) == PACKET_TYPE_LORA )
+    {
+        SX126xWriteRegister( REG_LR_SYNCWORD, ( syncWord >> 8 ) & 0xFF );
+        SX126xWriteRegister( REG_LR_SYNCWORD + 1, syncWord & 0xFF );
+    }
+}
+
+static uint32_t RadioGetWakeupTime( void )
+{
+    return SX126xGetBoardTcxoWakeupTime( ) + RADIO_WAKEUP_TIME;
+}
+
+static void RadioStartCarrierSense( RadioModems_t modem, uint32_t freq )
+{
+    RadioSetModem( modem );
+
+    RadioSetChannel( freq );
+
+    // Receive without events, Rssi samples the channel
+    SX126xSetDioIrqParams( IRQ_RADIO_NONE, IRQ_RADIO_NONE, IRQ_RADIO_NONE, IRQ_RADIO_NONE );
+    SX126xSetRx( 0xFFFFFF );
+}
+
+static uint32_t RadioGetCapabilities( void )
+{
+    return RADIO_CAP_RX_BOOSTED | RADIO_CAP_RX_DUTY_CYCLE | RADIO_CAP_CAD_TO_RX |
+           RADIO_CAP_HW_TIMEOUT | RADIO_CAP_BUSY_PIN;
+}
+
+static uint32_t RadioGetIrqTime( void )
+{
+    return IrqTime;
+}
+
+extern bool Irq0Fired;
+extern bool Irq1Fired;
+
+static void RadioIrqProcess( void )
+{
+    uint16_t irqRegs;
+    uint8_t size;
+
+    // Mcu.init may own the DIO1 pin interrupt
+    if( ( Irq0Fired == true ) || ( Irq1Fired == true ) )
+    {
+        // That IRQ only flags the edge, the time is taken at its first sight
+        Irq0Fired = false;
+        Irq1Fired = false;
+        IrqTime = micros( );
+        IrqFired = true;
+    }
+
+    if( CwTimeoutFired == true )
+    {
+        CwTimeoutFired = false;
+        RadioSleep( );
+        if( ( RadioEvents != NULL ) && ( RadioEvents->TxTimeout != NULL ) )
+        {
+            RadioEvents->TxTimeout( );
+        }
+    }
+
+    if( IrqFired == false )
+    {
+        return;
+    }
+    IrqFired = false;
+
+    irqRegs = SX126xGetIrqStatus( );
+    SX126xClearIrqStatus( IRQ_RADIO_ALL );
+
+    if( ( irqRegs & IRQ_TX_DONE ) == IRQ_TX_DONE )
+    {
+        SX126xSetOperatingMode( MODE_STDBY_RC );
+        if( ( RadioEvents != NULL ) && ( RadioEvents->TxDone != NULL ) )
+        {
+            RadioEvents->TxDone( );
+        }
+    }
+
+    if( ( irqRegs & IRQ_RX_DONE ) == IRQ_RX_DONE )
+    {
+        if( RxContinuous == false )
+        {
+            SX126xSetOperatingMode( MODE_STDBY_RC );
+            RadioStopRtc( );
+        }
+
+        if( ( irqRegs & IRQ_CRC_ERROR ) == IRQ_CRC_ERROR )
+        {
+            if( ( RadioEvents != NULL ) && ( RadioEvents->RxError != NULL ) )
+            {
+                RadioEvents->RxError( );
+            }
+        }
+        else
+        {
+            size = 0;
+            SX126xGetPayload( RadioRxPayload, &size, 255 );
+            SX126xGetPacketStatus( &SX126x.PacketStatus );
+            if( ( RadioEvents != NULL ) && ( RadioEvents->RxDone != NULL ) )
+            {
+                if( SX126x.PacketStatus.packetType == PACKET_TYPE_LORA )
+                {
+                    RadioEvents->RxDone( RadioRxPayload, size, SX126x.PacketStatus.Params.LoRa.RssiPkt,
+                                         SX126x.PacketStatus.Params.LoRa.SnrPkt );
+                }
+                else
+                {
+                    RadioEvents->RxDone( RadioRxPayload, size, SX126x.PacketStatus.Params.Gfsk.RssiAvg, 0 );
+                }
+            }
+        }
+    }
+
+    if( ( irqRegs & IRQ_CAD_DONE ) == IRQ_CAD_DONE )
+    {
+        bool detected = ( ( irqRegs & IRQ_CAD_ACTIVITY_DETECTED ) == IRQ_CAD_ACTIVITY_DETECTED );
+
+        // With LORA_CAD_RX the radio is already receiving on activity
+        SX126xSetOperatingMode( ( ( CadToRx == true ) && ( detected == true ) ) ? MODE_RX : MODE_STDBY_RC );
+        if( ( RadioEvents != NULL ) && ( RadioEvents->CadDone != NULL ) )
+        {
+            RadioEvents->CadDone( detected );
+        }
+    }
+
+    if( ( irqRegs & IRQ_RX_TX_TIMEOUT ) == IRQ_RX_TX_TIMEOUT )
+    {
+        if( SX126xGetOperatingMode( ) == MODE_TX )
+        {
+            SX126xSetOperatingMode( MODE_STDBY_RC );
+            if( ( RadioEvents != NULL ) && ( RadioEvents->TxTimeout != NULL ) )
+            {
+                RadioEvents->TxTimeout( );
+            }
+        }
+        else if( SX126xGetOperatingMode( ) == MODE_RX )
+        {
+            SX126xSetOperatingMode( MODE_STDBY_RC );
+            RadioStopRtc( );
+            if( ( RadioEvents != NULL ) && ( RadioEvents->RxTimeout != NULL ) )
+            {
+                RadioEvents->RxTimeout( );
+            }
+        }
+    }
+
+    if( ( irqRegs & IRQ_HEADER_ERROR ) == IRQ_HEADER_ERROR )
+    {
+        if( RxContinuous == false )
+        {
+            SX126xSetOperatingMode( MODE_STDBY_RC );
+        }
+        if( ( RadioEvents != NULL ) && ( RadioEvents->RxTimeout != NULL ) )
+        {
+            RadioEvents->RxTimeout( );
+        }
+    }
+}
+#endif
@@ -20,48 +20,198 @@
  *
  * \author    Gregory Cristian ( Semtech )
  */
+#if !defined( RADIO_SX126X )
 #include <stdlib.h>
 #include "utilities.h"
 #include "board-config.h"
 #include "delay.h"
 #include "radio.h"
 #include "sx1276-board.h"
+#include "energy.h"
 #include <Arduino.h>
 /*!
  * Flag used to set the RF switch control pins in low power mode when the radio is not active.
  */
 static bool RadioIsActive = false;
 
+/*
+ * Radio driver functions, bound to the default radio
+ */
+
+static void RadioInit( RadioEvents_t *events )
+{
+    SX1276Init( &SX1276, events );
+}
+
+static RadioState_t RadioGetStatus( void )
+{
+    return SX1276GetStatus( &SX1276 );
+}
+
+static void RadioSetModem( RadioModems_t modem )
+{
+    SX1276SetModem( &SX1276, modem );
+}
+
+static void RadioSetChannel( uint32_t freq )
+{
+    SX1276SetChannel( &SX1276, freq );
+}
+
+static bool RadioIsChannelFree( RadioModems_t modem, uint32_t freq, int16_t rssiThresh, uint32_t maxCarrierSenseTime )
+{
+    return SX1276IsChannelFree( &SX1276, modem, freq, rssiThresh, maxCarrierSenseTime );
+}
+
+static uint32_t RadioRandom( void )
+{
+    return SX1276Random( &SX1276 );
+}
+
+static void RadioSetRxConfig( RadioModems_t modem, uint32_t bandwidth,
+                              uint32_t datarate, uint8_t coderate,
+                              uint32_t bandwidthAfc, uint16_t preambleLen,
+                              uint16_t symbTimeout, bool fixLen,
+                              uint8_t payloadLen,
+                              bool crcOn, bool freqHopOn, uint8_t hopPeriod,
+                              bool iqInverted, bool rxContinuous )
+{
+    SX1276SetRxConfig( &SX1276, modem, bandwidth, datarate, coderate, bandwidthAfc, preambleLen,
+                       symbTimeout, fixLen, payloadLen, crcOn, freqHopOn, hopPeriod,
+                       iqInverted, rxContinuous );
+}
+
+static void RadioSetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
+                              uint32_t bandwidth, uint32_t datarate,
+                              uint8_t coderate, uint16_t preambleLen,
+                              bool fixLen, bool crcOn, bool freqHopOn,
+                              uint8_t hopPeriod, bool iqInverted, uint32_t timeout )
+{
+    SX1276SetTxConfig( &SX1276, modem, power, fdev, bandwidth, datarate, coderate, preambleLen,
+                       fixLen, crcOn, freqHopOn, hopPeriod, iqInverted, timeout );
+}
+
+static uint32_t RadioGetTimeOnAir( RadioModems_t modem, uint8_t pktLen )
+{
+    return SX1276GetTimeOnAir( &SX1276, modem, pktLen );
+}
+
+static void RadioSend( uint8_t *buffer, uint8_t size )
+{
+    SX1276Send( &SX1276, buffer, size );
+}
+
+static void RadioSetSleep( void )
+{
+    SX1276SetSleep( &SX1276 );
+}
+
+static void RadioSetStby( void )
+{
+    SX1276SetStby( &SX1276 );
+}
+
+static void RadioSetRx( uint32_t timeout )
+{
+    SX1276SetRx( &SX1276, timeout );
+}
+
+static void RadioStartCad( void )
+{
+    SX1276StartCad( &SX1276 );
+}
+
+static void RadioSetTxContinuousWave( uint32_t freq, int8_t power, uint16_t time )
+{
+    SX1276SetTxContinuousWave( &SX1276, freq, power, time );
+}
+
+static int16_t RadioReadRssi( RadioModems_t modem )
+{
+    return SX1276ReadRssi( &SX1276, modem );
+}
+
+static void RadioWrite( uint16_t addr, uint8_t data )
+{
+    SX1276Write( &SX1276, addr, data );
+}
+
+static uint8_t RadioRead( uint16_t addr )
+{
+    return SX1276Read( &SX1276, addr );
+}
+
+static void RadioWriteBuffer( uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+    SX1276WriteBuffer( &SX1276, addr, buffer, size );
+}
+
+static void RadioReadBuffer( uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+    SX1276ReadBuffer( &SX1276, addr, buffer, size );
+}
+
+static void RadioSetMaxPayloadLength( RadioModems_t modem, uint8_t max )
+{
+    SX1276SetMaxPayloadLength( &SX1276, modem, max );
+}
+
+static void RadioSetPublicNetwork( bool enable )
+{
+    SX1276SetPublicNetwork( &SX1276, enable );
+}
+
+static void RadioStartCarrierSense( RadioModems_t modem, uint32_t freq )
+{
+    SX1276StartCarrierSense( &SX1276, modem, freq );
+}
+
+static uint32_t RadioGetCapabilities( void )
+{
+    return RADIO_CAP_FSK_FIFO;
+}
+
+static uint32_t RadioGetIrqTime( void )
+{
+    return SX1276GetDio0Time( &SX1276 );
+}
+
 /*!
  * Radio driver structure initialization
  */
 const struct Radio_s Radio =
 {
-    SX1276Init,
-    SX1276GetStatus,
-    SX1276SetModem,
-    SX1276SetChannel,
-    SX1276IsChannelFree,
-    SX1276Random,
-    SX1276SetRxConfig,
-    SX1276SetTxConfig,
+    RadioInit,
+    RadioGetStatus,
+    RadioSetModem,
+    RadioSetChannel,
+    RadioIsChannelFree,
+    RadioRandom,
+    RadioSetRxConfig,
+    RadioSetTxConfig,
     SX1276CheckRfFrequency,
-    SX1276GetTimeOnAir,
-    SX1276Send,
-    SX1276SetSleep,
-    SX1276SetStby,
-    SX1276SetRx,
-    SX1276StartCad,
-    SX1276SetTxContinuousWave,
-    SX1276ReadRssi,
-    SX1276Write,
-    SX1276Read,
-    SX1276WriteBuffer,
-    SX1276ReadBuffer,
-    SX1276SetMaxPayloadLength,
-    SX1276SetPublicNetwork,
+    RadioGetTimeOnAir,
+    RadioSend,
+    RadioSetSleep,
+    RadioSetStby,
+    RadioSetRx,
+    RadioStartCad,
+    RadioSetTxContinuousWave,
+    RadioReadRssi,
+    RadioWrite,
+    RadioRead,
+    RadioWriteBuffer,
+    RadioReadBuffer,
+    RadioSetMaxPayloadLength,
+    RadioSetPublicNetwork,
     SX1276GetWakeupTime,
-    RadioIrqProcess
+    RadioIrqProcess,
+    RadioStartCarrierSense,
+    RadioGetCapabilities,
+    NULL,
+    NULL,
+    NULL,
+    RadioGetIrqTime
 };
 
 /*!
@@ -69,27 +219,27 @@ const struct Radio_s Radio =
  */
 Gpio_t AntSwitch;
 
-void SX1276IoInit( void )
+void SX1276IoInit( SX1276_t *obj )
 {
-    GpioInit( &SX1276.Spi.Nss, RADIO_NSS, OUTPUT, PIN_PUSH_PULL, PIN_PULL_UP, 1 );
-    GpioInit( &SX1276.DIO0, RADIO_DIO_0, INPUT, PIN_PUSH_PULL, PIN_PULL_UP, 0 );
-    GpioInit( &SX1276.DIO1, RADIO_DIO_1, INPUT, PIN_PUSH_PULL, PIN_PULL_UP, 0 );
+    GpioInit( &obj->Spi.Nss, RADIO_NSS, OUTPUT, PIN_PUSH_PULL, PIN_PULL_UP, 1 );
+    GpioInit( &obj->DIO0, RADIO_DIO_0, INPUT, PIN_PUSH_PULL, PIN_PULL_UP, 0 );
+    GpioInit( &obj->DIO1, RADIO_DIO_1, INPUT, PIN_PUSH_PULL, PIN_PULL_UP, 0 );
 
 }
 
-void SX1276IoIrqInit( DioIrqHandler **irqHandlers )
+void SX1276IoIrqInit( SX1276_t *obj, DioIrqHandler **irqHandlers )
 {
-    GpioSetInterrupt( &SX1276.DIO0, IRQ_RISING_EDGE, IRQ_HIGH_PRIORITY, irqHandlers[0] );
-    GpioSetInterrupt( &SX1276.DIO1, IRQ_RISING_EDGE, IRQ_HIGH_PRIORITY, irqHandlers[1] );
+    GpioSetInterrupt( &obj->DIO0, IRQ_RISING_EDGE, IRQ_HIGH_PRIORITY, irqHandlers[0] );
+    GpioSetInterrupt( &obj->DIO1, IRQ_RISING_EDGE, IRQ_HIGH_PRIORITY, irqHandlers[1] );
 
 }
 
-void SX1276IoDeInit( void )
+void SX1276IoDeInit( SX1276_t *obj )
 {
-    GpioInit( &SX1276.Spi.Nss, RADIO_NSS, OUTPUT, PIN_PUSH_PULL, PIN_NO_PULL, 1 );
+    GpioInit( &obj->Spi.Nss, RADIO_NSS, OUTPUT, PIN_PUSH_PULL, PIN_NO_PULL, 1 );
 
-    GpioInit( &SX1276.DIO0, RADIO_DIO_0, INPUT, PIN_PUSH_PULL, PIN_NO_PULL, 0 );
-    GpioInit( &SX1276.DIO1, RADIO_DIO_1, INPUT, PIN_PUSH_PULL, PIN_NO_PULL, 0 );
+    GpioInit( &obj->DIO0, RADIO_DIO_0, INPUT, PIN_PUSH_PULL, PIN_NO_PULL, 0 );
+    GpioInit( &obj->DIO1, RADIO_DIO_1, INPUT, PIN_PUSH_PULL, PIN_NO_PULL, 0 );
 }
 
 /*!
@@ -118,8 +268,18 @@ uint32_t SX1276GetBoardTcxoWakeupTime( void )
     return BOARD_TCXO_WAKEUP_TIME;
 }
 
-void SX1276Reset( void )
+void SX1276Reset( SX1276_t *obj )
 {
+    if( obj->Bus != NULL )
+    {
+        // Additional radio, reset pin given to SX1276AddInstance
+        GpioWrite( &obj->Reset, 0 );
+        DelayMs( 1 );
+        GpioWrite( &obj->Reset, 1 );
+        DelayMs( 6 );
+        return;
+    }
+
     // Set RESET pin to 0
     digitalWrite(RADIO_RESET, LOW);
     // Wait 1 ms
@@ -132,28 +292,28 @@ void SX1276Reset( void )
     DelayMs( 6 );
 }
 
-void SX1276SetRfTxPower( int8_t power )
+void SX1276SetRfTxPower( SX1276_t *obj, int8_t power )
 {
     uint8_t paConfig = 0;
     uint8_t paDac = 0;
 
-    paConfig = SX1276Read( REG_PACONFIG );
-    paDac = SX1276Read( REG_PADAC );
+    paConfig = SX1276Read( obj, REG_PACONFIG );
+    paDac = SX1276Read( obj, REG_PADAC );
 
-    paConfig = ( paConfig & RF_PACONFIG_PASELECT_MASK ) | SX1276GetPaSelect( SX1276.Settings.Channel );
+    paConfig = ( paConfig & RF_PACONFIG_PASELECT_MASK ) | SX1276GetPaSelect( obj->Settings.Channel );
     paConfig = ( paConfig & RF_PACONFIG_MAX_POWER_MASK ) | 0x70;
 
     if( ( paConfig & RF_PACONFIG_PASELECT_PABOOST ) == RF_PACONFIG_PASELECT_PABOOST )
     {
-        paDac = ( paDac & RF_PADAC_20DBM_MASK ) | RF_PADAC_20DBM_ON;
-        //if( power > 17 )
-        //{
-        //    paDac = ( paDac & RF_PADAC_20DBM_MASK ) | RF_PADAC_20DBM_ON;
-       // }
-       // else
-       // {
-        //    paDac = ( paDac & RF_PADAC_20DBM_MASK ) | RF_PADAC_20DBM_OFF;
-        //}
+        // The +20 dBm DAC draws more current, only enable it when needed
+        if( power >= BOARD_RADIO_PA_HIGH_POWER_MIN )
+        {
+            paDac = ( paDac & RF_PADAC_20DBM_MASK ) | RF_PADAC_20DBM_ON;
+        }
+        else
+        {
+            paDac = ( paDac & RF_PADAC_20DBM_MASK ) | RF_PADAC_20DBM_OFF;
+        }
         if( ( paDac & RF_PADAC_20DBM_ON ) == RF_PADAC_20DBM_ON )
         {
             if( power < 5 )
@@ -191,8 +351,12 @@ void SX1276SetRfTxPower( int8_t power )
         }
         paConfig = ( paConfig & RF_PACONFIG_OUTPUTPOWER_MASK ) | ( uint8_t )( ( uint16_t )( power + 1 ) & 0x0F );
     }
-    SX1276Write( REG_PACONFIG, paConfig );
-    SX1276Write( REG_PADAC, paDac );
+    SX1276Write( obj, REG_PACONFIG, paConfig );
+    SX1276Write( obj, REG_PADAC, paDac );
+    if( obj == &SX1276 )
+    {
+        EnergySetTxPower( power );
+    }
 }
 
 uint8_t SX1276GetPaSelect( uint32_t channel )
@@ -208,8 +372,13 @@ uint8_t SX1276GetPaSelect( uint32_t channel )
     return RF_PACONFIG_PASELECT_PABOOST;
 }
 
-void SX1276SetAntSwLowPower( bool status )
+void SX1276SetAntSwLowPower( SX1276_t *obj, bool status )
 {
+    if( obj != &SX1276 )
+    {
+        // The antenna switch belongs to the default radio
+        return;
+    }
     if( RadioIsActive != status )
     {
         RadioIsActive = status;
@@ -237,8 +406,13 @@ void SX1276AntSwDeInit( void )
 //    GpioInit( &AntSwitch, RADIO_ANT_SWITCH, PIN_OUTPUT, PIN_PUSH_PULL, PIN_NO_PULL, 0 );
 }
 
-void SX1276SetAntSw( uint8_t opMode )
+void SX1276SetAntSw( SX1276_t *obj, uint8_t opMode )
 {
+    if( obj != &SX1276 )
+    {
+        // The antenna switch belongs to the default radio
+        return;
+    }
     switch( opMode )
     {
     case RFLR_OPMODE_TRANSMITTER:
@@ -258,3 +432,4 @@ bool SX1276CheckRfFrequency( uint32_t frequency )
     // Implement check. Currently all frequencies are supported
     return true;
 }
+#endif
@@ -27,6 +27,10 @@
 #include <stdbool.h>
 #include "sx1276.h"
 
+#ifdef __cplusplus
+extern "C"{
+#endif
+
 /*!
  * \brief Radio hardware registers initialization definition
  *
@@ -56,34 +60,42 @@
 
 /*!
  * \brief Initializes the radio I/Os pins interface
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276IoInit( void );
+void SX1276IoInit( SX1276_t *obj );
 
 /*!
  * \brief Initializes DIO IRQ handlers
  *
+ * \param [IN] obj Radio object
  * \param [IN] irqHandlers Array containing the IRQ callback functions
  */
-void SX1276IoIrqInit( DioIrqHandler **irqHandlers );
+void SX1276IoIrqInit( SX1276_t *obj, DioIrqHandler **irqHandlers );
 
 /*!
  * \brief De-initializes the radio I/Os pins interface.
  *
  * \remark Useful when going in MCU low power modes
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276IoDeInit( void );
+void SX1276IoDeInit( SX1276_t *obj );
 
 /*!
  * \brief Resets the radio
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276Reset( void );
+void SX1276Reset( SX1276_t *obj );
 
 /*!
  * \brief Sets the radio output power.
  *
+ * \param [IN] obj Radio object
  * \param [IN] power Sets the RF output power
  */
-void SX1276SetRfTxPower( int8_t power );
+void SX1276SetRfTxPower( SX1276_t *obj, int8_t power );
 
 /*!
  * \brief Gets the board PA selection configuration
@@ -96,9 +108,10 @@ uint8_t SX1276GetPaSelect( uint32_t channel );
 /*!
  * \brief Set the RF Switch I/Os pins in low power mode
  *
+ * \param [IN] obj Radio object
  * \param [IN] status enable or disable
  */
-void SX1276SetAntSwLowPower( bool status );
+void SX1276SetAntSwLowPower( SX1276_t *obj, bool status );
 
 /*!
  * \brief Initializes the RF Switch I/Os pins interface
@@ -117,9 +130,10 @@ void SX1276AntSwDeInit( void );
  *
  * \remark see errata note
  *
+ * \param [IN] obj Radio object
  * \param [IN] opMode Current radio operating mode
  */
-void SX1276SetAntSw( uint8_t opMode );
+void SX1276SetAntSw( SX1276_t *obj, uint8_t opMode );
 
 /*!
  * \brief Checks if the given RF frequency is supported by the hardware
@@ -141,4 +155,8 @@ uint32_t SX1276GetBoardTcxoWakeupTime( void );
  */
 extern SX1276_t SX1276;
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // __SX1276_BOARD_H__
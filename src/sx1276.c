@@ -22,6 +22,7 @@
  *
  * \author    Wael Guibene ( Semtech )
  */
+#if !defined( RADIO_SX126X )
 #include <math.h>
 #include <string.h>
 #include "utilities.h"
@@ -30,6 +31,8 @@
 #include "delay.h"
 #include "sx1276-board.h"
 #include "debug.h"
+#include "energy.h"
+#include "trace.h"
 extern  int xprintf(const char *format, ...);
 
 
@@ -57,37 +60,43 @@ typedef struct
  * Performs the Rx chain calibration for LF and HF bands
  * \remark Must be called just after the reset so all registers are at their
  *         default values
+ *
+ * \param [IN] obj Radio object
  */
-static void RxChainCalibration( void );
+static void RxChainCalibration( SX1276_t *obj );
 
 /*!
  * \brief Sets the SX1276 in transmission mode for the given time
+ * \param [IN] obj Radio object
  * \param [IN] timeout Transmission timeout [ms] [0: continuous, others timeout]
  */
-void SX1276SetTx( uint32_t timeout );
+void SX1276SetTx( SX1276_t *obj, uint32_t timeout );
 
 /*!
  * \brief Writes the buffer contents to the SX1276 FIFO
  *
+ * \param [IN] obj Radio object
  * \param [IN] buffer Buffer containing data to be put on the FIFO.
  * \param [IN] size Number of bytes to be written to the FIFO
  */
-void SX1276WriteFifo( uint8_t *buffer, uint8_t size );
+void SX1276WriteFifo( SX1276_t *obj, uint8_t *buffer, uint8_t size );
 
 /*!
  * \brief Reads the contents of the SX1276 FIFO
  *
+ * \param [IN] obj Radio object
  * \param [OUT] buffer Buffer where to copy the FIFO read data.
  * \param [IN] size Number of bytes to be read from the FIFO
  */
-void SX1276ReadFifo( uint8_t *buffer, uint8_t size );
+void SX1276ReadFifo( SX1276_t *obj, uint8_t *buffer, uint8_t size );
 
 /*!
  * \brief Sets the SX1276 operating mode
  *
+ * \param [IN] obj Radio object
  * \param [IN] opMode New operating mode
  */
-void SX1276SetOpMode( uint8_t opMode );
+void SX1276SetOpMode( SX1276_t *obj, uint8_t opMode );
 
 /*
  * SX1276 DIO IRQ callback functions prototype
@@ -95,38 +104,52 @@ void SX1276SetOpMode( uint8_t opMode );
 
 /*!
  * \brief DIO 0 IRQ callback
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276OnDio0Irq( void );
+void SX1276OnDio0Irq( SX1276_t *obj );
 
 /*!
  * \brief DIO 1 IRQ callback
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276OnDio1Irq( void );
+void SX1276OnDio1Irq( SX1276_t *obj );
 
 /*!
  * \brief DIO 2 IRQ callback
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276OnDio2Irq( void );
+void SX1276OnDio2Irq( SX1276_t *obj );
 
 /*!
  * \brief DIO 3 IRQ callback
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276OnDio3Irq( void );
+void SX1276OnDio3Irq( SX1276_t *obj );
 
 /*!
  * \brief DIO 4 IRQ callback
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276OnDio4Irq( void );
+void SX1276OnDio4Irq( SX1276_t *obj );
 
 /*!
  * \brief DIO 5 IRQ callback
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276OnDio5Irq( void );
+void SX1276OnDio5Irq( SX1276_t *obj );
 
 /*!
  * \brief Tx & Rx timeout timer callback
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276OnTimeoutIrq( void );
+void SX1276OnTimeoutIrq( SX1276_t *obj );
 
 /*
  * Private global constants
@@ -175,41 +198,72 @@ const FskBandwidth_t FskBandwidths[] =
 };
 
 /*
- * Private global variables
- */
-
-/*!
- * Radio callbacks variable
+ * Public global variables
  */
-static RadioEvents_t *RadioEvents;
 
 /*!
- * Reception buffer
+ * Radio hardware and global parameters, default radio used by the Radio
+ * driver structure
  */
-static uint8_t RxTxBuffer[RX_BUFFER_SIZE];
+SX1276_t SX1276;
 
 /*
- * Public global variables
+ * Private global variables
  */
 
 /*!
- * Radio hardware and global parameters
+ * Radios in use, the default one is always present
  */
-SX1276_t SX1276;
+static SX1276_t *Instances[SX1276_MAX_INSTANCES] = { &SX1276 };
 
 /*!
- * Hardware DIO IRQ callback initialization
+ * Timer and DIO IRQ callbacks take no argument, each instance slot has its
+ * own set that forwards to its radio. DIO IRQs are only flagged, they are
+ * processed by SX1276IrqProcess. DIO0 ends the transmissions and receptions,
+ * its time is latched here rather than when the event is processed.
  */
-DioIrqHandler *DioIrq[] = { SX1276OnDio0Irq, SX1276OnDio1Irq,
-                            SX1276OnDio2Irq, SX1276OnDio3Irq,
-                            SX1276OnDio4Irq, NULL };
+static void OnTimeoutIrq0( void )
+{
+    SX1276OnTimeoutIrq( Instances[0] );
+}
+
+static void OnTimeoutIrq1( void )
+{
+    SX1276OnTimeoutIrq( Instances[1] );
+}
+
+static void OnDio0Irq0( void )
+{
+    Instances[0]->Dio0Time = micros( );
+    Instances[0]->Dio0Fired = true;
+}
+
+static void OnDio1Irq0( void )
+{
+    Instances[0]->Dio1Fired = true;
+}
+
+static void OnDio0Irq1( void )
+{
+    Instances[1]->Dio0Time = micros( );
+    Instances[1]->Dio0Fired = true;
+}
+
+static void OnDio1Irq1( void )
+{
+    Instances[1]->Dio1Fired = true;
+}
+
+static void ( * const TimeoutIrq[SX1276_MAX_INSTANCES] )( void ) = { OnTimeoutIrq0, OnTimeoutIrq1 };
 
 /*!
- * Tx and Rx timers
+ * Hardware DIO IRQ callback initialization
  */
-TimerEvent_t TxTimeoutTimer;
-TimerEvent_t RxTimeoutTimer;
-TimerEvent_t RxTimeoutSyncWord;
+static DioIrqHandler *DioIrq[SX1276_MAX_INSTANCES][2] =
+{
+    { OnDio0Irq0, OnDio1Irq0 },
+    { OnDio0Irq1, OnDio1Irq1 },
+};
 
 #if defined( USE_RADIO_DEBUG )
 Gpio_t DbgPinTx;
@@ -220,59 +274,100 @@ Gpio_t DbgPinRx;
  * Radio driver functions implementation
  */
 
-void SX1276Init( RadioEvents_t *events )
+bool SX1276AddInstance( SX1276_t *obj, const SX1276Bus_t *bus, uint8_t reset, uint8_t dio0, uint8_t dio1 )
 {
     uint8_t i;
 
-    RadioEvents = events;
+    for( i = 0; i < SX1276_MAX_INSTANCES; i++ )
+    {
+        if( ( Instances[i] == NULL ) || ( Instances[i] == obj ) )
+        {
+            break;
+        }
+    }
+    if( ( i == SX1276_MAX_INSTANCES ) || ( bus == NULL ) )
+    {
+        return false;
+    }
+
+    memset( obj, 0, sizeof( SX1276_t ) );
+    obj->Bus = bus;
+    GpioInit( &obj->Reset, reset, OUTPUT, PIN_PUSH_PULL, PIN_NO_PULL, 1 );
+    GpioInit( &obj->DIO0, dio0, INPUT, PIN_PUSH_PULL, PIN_NO_PULL, 0 );
+    GpioInit( &obj->DIO1, dio1, INPUT, PIN_PUSH_PULL, PIN_NO_PULL, 0 );
+    Instances[i] = obj;
+
+    SX1276Reset( obj );
+    return true;
+}
+
+void SX1276Init( SX1276_t *obj, RadioEvents_t *events )
+{
+    uint8_t i;
+    uint8_t slot;
+
+    for( slot = 0; slot < SX1276_MAX_INSTANCES; slot++ )
+    {
+        if( Instances[slot] == obj )
+        {
+            break;
+        }
+    }
+    if( slot == SX1276_MAX_INSTANCES )
+    {
+        // Not set up by SX1276AddInstance
+        return;
+    }
+
+    obj->Events = events;
 
     // Initialize driver timeout timers
-    TimerInit( &TxTimeoutTimer, SX1276OnTimeoutIrq );
-    TimerInit( &RxTimeoutTimer, SX1276OnTimeoutIrq );
-    TimerInit( &RxTimeoutSyncWord, SX1276OnTimeoutIrq );
+    TimerInit( &obj->TxTimeoutTimer, TimeoutIrq[slot] );
+    TimerInit( &obj->RxTimeoutTimer, TimeoutIrq[slot] );
+    TimerInit( &obj->RxTimeoutSyncWord, TimeoutIrq[slot] );
 
-    RxChainCalibration( );
+    RxChainCalibration( obj );
 
-    SX1276SetOpMode( RF_OPMODE_SLEEP );
+    SX1276SetOpMode( obj, RF_OPMODE_SLEEP );
 
-    SX1276IoIrqInit( DioIrq );
+    SX1276IoIrqInit( obj, DioIrq[slot] );
 
     for( i = 0; i < sizeof( RadioRegsInit ) / sizeof( RadioRegisters_t ); i++ )
     {
-        SX1276SetModem( RadioRegsInit[i].Modem );
-        SX1276Write( RadioRegsInit[i].Addr, RadioRegsInit[i].Value );
+        SX1276SetModem( obj, RadioRegsInit[i].Modem );
+        SX1276Write( obj, RadioRegsInit[i].Addr, RadioRegsInit[i].Value );
     }
 
-    SX1276SetModem( MODEM_FSK );
+    SX1276SetModem( obj, MODEM_FSK );
 
-    SX1276.Settings.State = RF_IDLE;
+    obj->Settings.State = RF_IDLE;
 }
 
-RadioState_t SX1276GetStatus( void )
+RadioState_t SX1276GetStatus( SX1276_t *obj )
 {
-    return SX1276.Settings.State;
+    return obj->Settings.State;
 }
 
-void SX1276SetChannel( uint32_t freq )
+void SX1276SetChannel( SX1276_t *obj, uint32_t freq )
 {
-    SX1276.Settings.Channel = freq;
+    obj->Settings.Channel = freq;
     freq = ( uint32_t )( ( double )freq / ( double )FREQ_STEP );
-    SX1276Write( REG_FRFMSB, ( uint8_t )( ( freq >> 16 ) & 0xFF ) );
-    SX1276Write( REG_FRFMID, ( uint8_t )( ( freq >> 8 ) & 0xFF ) );
-    SX1276Write( REG_FRFLSB, ( uint8_t )( freq & 0xFF ) );
+    SX1276Write( obj, REG_FRFMSB, ( uint8_t )( ( freq >> 16 ) & 0xFF ) );
+    SX1276Write( obj, REG_FRFMID, ( uint8_t )( ( freq >> 8 ) & 0xFF ) );
+    SX1276Write( obj, REG_FRFLSB, ( uint8_t )( freq & 0xFF ) );
 }
 
-bool SX1276IsChannelFree( RadioModems_t modem, uint32_t freq, int16_t rssiThresh, uint32_t maxCarrierSenseTime )
+bool SX1276IsChannelFree( SX1276_t *obj, RadioModems_t modem, uint32_t freq, int16_t rssiThresh, uint32_t maxCarrierSenseTime )
 {
     bool status = true;
     int16_t rssi = 0;
     uint32_t carrierSenseTime = 0;
 
-    SX1276SetModem( modem );
+    SX1276SetModem( obj, modem );
 
-    SX1276SetChannel( freq );
+    SX1276SetChannel( obj, freq );
 
-    SX1276SetOpMode( RF_OPMODE_RECEIVER );
+    SX1276SetOpMode( obj, RF_OPMODE_RECEIVER );
 
     DelayMs( 1 );
 
@@ -281,7 +376,7 @@ bool SX1276IsChannelFree( RadioModems_t modem, uint32_t freq, int16_t rssiThresh
     // Perform carrier sense for maxCarrierSenseTime
     while( TimerGetElapsedTime( carrierSenseTime ) < maxCarrierSenseTime )
     {
-        rssi = SX1276ReadRssi( modem );
+        rssi = SX1276ReadRssi( obj, modem );
 
         if( rssi > rssiThresh )
         {
@@ -289,11 +384,25 @@ bool SX1276IsChannelFree( RadioModems_t modem, uint32_t freq, int16_t rssiThresh
             break;
         }
     }
-    SX1276SetSleep( );
+    SX1276SetSleep( obj );
     return status;
 }
 
-uint32_t SX1276Random( void )
+void SX1276StartCarrierSense( SX1276_t *obj, RadioModems_t modem, uint32_t freq )
+{
+    SX1276SetModem( obj, modem );
+
+    SX1276SetChannel( obj, freq );
+
+    if( modem == MODEM_LORA )
+    {
+        SX1276Write( obj, REG_LR_IRQFLAGSMASK, 0xFF );
+    }
+    obj->Settings.State = RF_IDLE;
+    SX1276SetOpMode( obj, RF_OPMODE_RECEIVER );
+}
+
+uint32_t SX1276Random( SX1276_t *obj )
 {
     uint8_t i;
     uint32_t rnd = 0;
@@ -302,10 +411,10 @@ uint32_t SX1276Random( void )
      * Radio setup for random number generation
      */
     // Set LoRa modem ON
-    SX1276SetModem( MODEM_LORA );
+    SX1276SetModem( obj, MODEM_LORA );
 
     // Disable LoRa modem interrupts
-    SX1276Write( REG_LR_IRQFLAGSMASK, RFLR_IRQFLAGS_RXTIMEOUT |
+    SX1276Write( obj, REG_LR_IRQFLAGSMASK, RFLR_IRQFLAGS_RXTIMEOUT |
                   RFLR_IRQFLAGS_RXDONE |
                   RFLR_IRQFLAGS_PAYLOADCRCERROR |
                   RFLR_IRQFLAGS_VALIDHEADER |
@@ -315,16 +424,16 @@ uint32_t SX1276Random( void )
                   RFLR_IRQFLAGS_CADDETECTED );
 
     // Set radio in continuous reception
-    SX1276SetOpMode( RF_OPMODE_RECEIVER );
+    SX1276SetOpMode( obj, RF_OPMODE_RECEIVER );
 
     for( i = 0; i < 32; i++ )
     {
         DelayMs( 1 );
         // Unfiltered RSSI value reading. Only takes the LSB value
-        rnd |= ( ( uint32_t )SX1276Read( REG_LR_RSSIWIDEBAND ) & 0x01 ) << i;
+        rnd |= ( ( uint32_t )SX1276Read( obj, REG_LR_RSSIWIDEBAND ) & 0x01 ) << i;
     }
 
-    SX1276SetSleep( );
+    SX1276SetSleep( obj );
 
     return rnd;
 }
@@ -334,38 +443,38 @@ uint32_t SX1276Random( void )
  * \remark Must be called just after the reset so all registers are at their
  *         default values
  */
-static void RxChainCalibration( void )
+static void RxChainCalibration( SX1276_t *obj )
 {
     uint8_t regPaConfigInitVal;
     uint32_t initialFreq;
 
     // Save context
-    regPaConfigInitVal = SX1276Read( REG_PACONFIG );
-    initialFreq = ( double )( ( ( uint32_t )SX1276Read( REG_FRFMSB ) << 16 ) |
-                              ( ( uint32_t )SX1276Read( REG_FRFMID ) << 8 ) |
-                              ( ( uint32_t )SX1276Read( REG_FRFLSB ) ) ) * ( double )FREQ_STEP;
+    regPaConfigInitVal = SX1276Read( obj, REG_PACONFIG );
+    initialFreq = ( double )( ( ( uint32_t )SX1276Read( obj, REG_FRFMSB ) << 16 ) |
+                              ( ( uint32_t )SX1276Read( obj, REG_FRFMID ) << 8 ) |
+                              ( ( uint32_t )SX1276Read( obj, REG_FRFLSB ) ) ) * ( double )FREQ_STEP;
 
     // Cut the PA just in case, RFO output, power = -1 dBm
-    SX1276Write( REG_PACONFIG, 0x00 );
+    SX1276Write( obj, REG_PACONFIG, 0x00 );
 
     // Launch Rx chain calibration for LF band
-    SX1276Write( REG_IMAGECAL, ( SX1276Read( REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_MASK ) | RF_IMAGECAL_IMAGECAL_START );
-    while( ( SX1276Read( REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_RUNNING ) == RF_IMAGECAL_IMAGECAL_RUNNING )
+    SX1276Write( obj, REG_IMAGECAL, ( SX1276Read( obj, REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_MASK ) | RF_IMAGECAL_IMAGECAL_START );
+    while( ( SX1276Read( obj, REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_RUNNING ) == RF_IMAGECAL_IMAGECAL_RUNNING )
     {
     }
 
     // Sets a Frequency in HF band
-    SX1276SetChannel( 868000000 );
+    SX1276SetChannel( obj, 868000000 );
 
     // Launch Rx chain calibration for HF band
-    SX1276Write( REG_IMAGECAL, ( SX1276Read( REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_MASK ) | RF_IMAGECAL_IMAGECAL_START );
-    while( ( SX1276Read( REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_RUNNING ) == RF_IMAGECAL_IMAGECAL_RUNNING )
+    SX1276Write( obj, REG_IMAGECAL, ( SX1276Read( obj, REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_MASK ) | RF_IMAGECAL_IMAGECAL_START );
+    while( ( SX1276Read( obj, REG_IMAGECAL ) & RF_IMAGECAL_IMAGECAL_RUNNING ) == RF_IMAGECAL_IMAGECAL_RUNNING )
     {
     }
 
     // Restore context
-    SX1276Write( REG_PACONFIG, regPaConfigInitVal );
-    SX1276SetChannel( initialFreq );
+    SX1276Write( obj, REG_PACONFIG, regPaConfigInitVal );
+    SX1276SetChannel( obj, initialFreq );
 }
 
 /*!
@@ -389,7 +498,7 @@ static uint8_t GetFskBandwidthRegValue( uint32_t bandwidth )
     while( 1 );
 }
 
-void SX1276SetRxConfig( RadioModems_t modem, uint32_t bandwidth,
+void SX1276SetRxConfig( SX1276_t *obj, RadioModems_t modem, uint32_t bandwidth,
                          uint32_t datarate, uint8_t coderate,
                          uint32_t bandwidthAfc, uint16_t preambleLen,
                          uint16_t symbTimeout, bool fixLen,
@@ -397,49 +506,49 @@ void SX1276SetRxConfig( RadioModems_t modem, uint32_t bandwidth,
                          bool crcOn, bool freqHopOn, uint8_t hopPeriod,
                          bool iqInverted, bool rxContinuous )
 {
-    SX1276SetModem( modem );
+    SX1276SetModem( obj, modem );
 
     switch( modem )
     {
     case MODEM_FSK:
         {
-            SX1276.Settings.Fsk.Bandwidth = bandwidth;
-            SX1276.Settings.Fsk.Datarate = datarate;
-            SX1276.Settings.Fsk.BandwidthAfc = bandwidthAfc;
-            SX1276.Settings.Fsk.FixLen = fixLen;
-            SX1276.Settings.Fsk.PayloadLen = payloadLen;
-            SX1276.Settings.Fsk.CrcOn = crcOn;
-            SX1276.Settings.Fsk.IqInverted = iqInverted;
-            SX1276.Settings.Fsk.RxContinuous = rxContinuous;
-            SX1276.Settings.Fsk.PreambleLen = preambleLen;
-            SX1276.Settings.Fsk.RxSingleTimeout = ( uint32_t )( symbTimeout * ( ( 1.0 / ( double )datarate ) * 8.0 ) * 1000 );
+            obj->Settings.Fsk.Bandwidth = bandwidth;
+            obj->Settings.Fsk.Datarate = datarate;
+            obj->Settings.Fsk.BandwidthAfc = bandwidthAfc;
+            obj->Settings.Fsk.FixLen = fixLen;
+            obj->Settings.Fsk.PayloadLen = payloadLen;
+            obj->Settings.Fsk.CrcOn = crcOn;
+            obj->Settings.Fsk.IqInverted = iqInverted;
+            obj->Settings.Fsk.RxContinuous = rxContinuous;
+            obj->Settings.Fsk.PreambleLen = preambleLen;
+            obj->Settings.Fsk.RxSingleTimeout = ( uint32_t )( symbTimeout * ( ( 1.0 / ( double )datarate ) * 8.0 ) * 1000 );
 
             datarate = ( uint16_t )( ( double )XTAL_FREQ / ( double )datarate );
-            SX1276Write( REG_BITRATEMSB, ( uint8_t )( datarate >> 8 ) );
-            SX1276Write( REG_BITRATELSB, ( uint8_t )( datarate & 0xFF ) );
+            SX1276Write( obj, REG_BITRATEMSB, ( uint8_t )( datarate >> 8 ) );
+            SX1276Write( obj, REG_BITRATELSB, ( uint8_t )( datarate & 0xFF ) );
 
-            SX1276Write( REG_RXBW, GetFskBandwidthRegValue( bandwidth ) );
-            SX1276Write( REG_AFCBW, GetFskBandwidthRegValue( bandwidthAfc ) );
+            SX1276Write( obj, REG_RXBW, GetFskBandwidthRegValue( bandwidth ) );
+            SX1276Write( obj, REG_AFCBW, GetFskBandwidthRegValue( bandwidthAfc ) );
 
-            SX1276Write( REG_PREAMBLEMSB, ( uint8_t )( ( preambleLen >> 8 ) & 0xFF ) );
-            SX1276Write( REG_PREAMBLELSB, ( uint8_t )( preambleLen & 0xFF ) );
+            SX1276Write( obj, REG_PREAMBLEMSB, ( uint8_t )( ( preambleLen >> 8 ) & 0xFF ) );
+            SX1276Write( obj, REG_PREAMBLELSB, ( uint8_t )( preambleLen & 0xFF ) );
 
             if( fixLen == 1 )
             {
-                SX1276Write( REG_PAYLOADLENGTH, payloadLen );
+                SX1276Write( obj, REG_PAYLOADLENGTH, payloadLen );
             }
             else
             {
-                SX1276Write( REG_PAYLOADLENGTH, 0xFF ); // Set payload length to the maximum
+                SX1276Write( obj, REG_PAYLOADLENGTH, 0xFF ); // Set payload length to the maximum
             }
 
-            SX1276Write( REG_PACKETCONFIG1,
-                         ( SX1276Read( REG_PACKETCONFIG1 ) &
+            SX1276Write( obj, REG_PACKETCONFIG1,
+                         ( SX1276Read( obj, REG_PACKETCONFIG1 ) &
                            RF_PACKETCONFIG1_CRC_MASK &
                            RF_PACKETCONFIG1_PACKETFORMAT_MASK ) |
                            ( ( fixLen == 1 ) ? RF_PACKETCONFIG1_PACKETFORMAT_FIXED : RF_PACKETCONFIG1_PACKETFORMAT_VARIABLE ) |
                            ( crcOn << 4 ) );
-            SX1276Write( REG_PACKETCONFIG2, ( SX1276Read( REG_PACKETCONFIG2 ) | RF_PACKETCONFIG2_DATAMODE_PACKET ) );
+            SX1276Write( obj, REG_PACKETCONFIG2, ( SX1276Read( obj, REG_PACKETCONFIG2 ) | RF_PACKETCONFIG2_DATAMODE_PACKET ) );
         }
         break;
     case MODEM_LORA:
@@ -450,17 +559,17 @@ void SX1276SetRxConfig( RadioModems_t modem, uint32_t bandwidth,
                 while( 1 );
             }
             bandwidth += 7;
-            SX1276.Settings.LoRa.Bandwidth = bandwidth;
-            SX1276.Settings.LoRa.Datarate = datarate;
-            SX1276.Settings.LoRa.Coderate = coderate;
-            SX1276.Settings.LoRa.PreambleLen = preambleLen;
-            SX1276.Settings.LoRa.FixLen = fixLen;
-            SX1276.Settings.LoRa.PayloadLen = payloadLen;
-            SX1276.Settings.LoRa.CrcOn = crcOn;
-            SX1276.Settings.LoRa.FreqHopOn = freqHopOn;
-            SX1276.Settings.LoRa.HopPeriod = hopPeriod;
-            SX1276.Settings.LoRa.IqInverted = iqInverted;
-            SX1276.Settings.LoRa.RxContinuous = rxContinuous;
+            obj->Settings.LoRa.Bandwidth = bandwidth;
+            obj->Settings.LoRa.Datarate = datarate;
+            obj->Settings.LoRa.Coderate = coderate;
+            obj->Settings.LoRa.PreambleLen = preambleLen;
+            obj->Settings.LoRa.FixLen = fixLen;
+            obj->Settings.LoRa.PayloadLen = payloadLen;
+            obj->Settings.LoRa.CrcOn = crcOn;
+            obj->Settings.LoRa.FreqHopOn = freqHopOn;
+            obj->Settings.LoRa.HopPeriod = hopPeriod;
+            obj->Settings.LoRa.IqInverted = iqInverted;
+            obj->Settings.LoRa.RxContinuous = rxContinuous;
 
             if( datarate > 12 )
             {
@@ -474,83 +583,83 @@ void SX1276SetRxConfig( RadioModems_t modem, uint32_t bandwidth,
             if( ( ( bandwidth == 7 ) && ( ( datarate == 11 ) || ( datarate == 12 ) ) ) ||
                 ( ( bandwidth == 8 ) && ( datarate == 12 ) ) )
             {
-                SX1276.Settings.LoRa.LowDatarateOptimize = 0x01;
+                obj->Settings.LoRa.LowDatarateOptimize = 0x01;
             }
             else
             {
-                SX1276.Settings.LoRa.LowDatarateOptimize = 0x00;
+                obj->Settings.LoRa.LowDatarateOptimize = 0x00;
             }
 
-            SX1276Write( REG_LR_MODEMCONFIG1,
-                         ( SX1276Read( REG_LR_MODEMCONFIG1 ) &
+            SX1276Write( obj, REG_LR_MODEMCONFIG1,
+                         ( SX1276Read( obj, REG_LR_MODEMCONFIG1 ) &
                            RFLR_MODEMCONFIG1_BW_MASK &
                            RFLR_MODEMCONFIG1_CODINGRATE_MASK &
                            RFLR_MODEMCONFIG1_IMPLICITHEADER_MASK ) |
                            ( bandwidth << 4 ) | ( coderate << 1 ) |
                            fixLen );
 
-            SX1276Write( REG_LR_MODEMCONFIG2,
-                         ( SX1276Read( REG_LR_MODEMCONFIG2 ) &
+            SX1276Write( obj, REG_LR_MODEMCONFIG2,
+                         ( SX1276Read( obj, REG_LR_MODEMCONFIG2 ) &
                            RFLR_MODEMCONFIG2_SF_MASK &
                            RFLR_MODEMCONFIG2_RXPAYLOADCRC_MASK &
                            RFLR_MODEMCONFIG2_SYMBTIMEOUTMSB_MASK ) |
                            ( datarate << 4 ) | ( crcOn << 2 ) |
                            ( ( symbTimeout >> 8 ) & ~RFLR_MODEMCONFIG2_SYMBTIMEOUTMSB_MASK ) );
 
-            SX1276Write( REG_LR_MODEMCONFIG3,
-                         ( SX1276Read( REG_LR_MODEMCONFIG3 ) &
+            SX1276Write( obj, REG_LR_MODEMCONFIG3,
+                         ( SX1276Read( obj, REG_LR_MODEMCONFIG3 ) &
                            RFLR_MODEMCONFIG3_LOWDATARATEOPTIMIZE_MASK ) |
-                           ( SX1276.Settings.LoRa.LowDatarateOptimize << 3 ) );
+                           ( obj->Settings.LoRa.LowDatarateOptimize << 3 ) );
 
-            SX1276Write( REG_LR_SYMBTIMEOUTLSB, ( uint8_t )( symbTimeout & 0xFF ) );
-            SX1276Write( REG_LR_PREAMBLEMSB, ( uint8_t )( ( preambleLen >> 8 ) & 0xFF ) );
-            SX1276Write( REG_LR_PREAMBLELSB, ( uint8_t )( preambleLen & 0xFF ) );
+            SX1276Write( obj, REG_LR_SYMBTIMEOUTLSB, ( uint8_t )( symbTimeout & 0xFF ) );
+            SX1276Write( obj, REG_LR_PREAMBLEMSB, ( uint8_t )( ( preambleLen >> 8 ) & 0xFF ) );
+            SX1276Write( obj, REG_LR_PREAMBLELSB, ( uint8_t )( preambleLen & 0xFF ) );
 
             if( fixLen == 1 )
             {
-                SX1276Write( REG_LR_PAYLOADLENGTH, payloadLen );
+                SX1276Write( obj, REG_LR_PAYLOADLENGTH, payloadLen );
             }
 
-            if( SX1276.Settings.LoRa.FreqHopOn == true )
+            if( obj->Settings.LoRa.FreqHopOn == true )
             {
-                SX1276Write( REG_LR_PLLHOP, ( SX1276Read( REG_LR_PLLHOP ) & RFLR_PLLHOP_FASTHOP_MASK ) | RFLR_PLLHOP_FASTHOP_ON );
-                SX1276Write( REG_LR_HOPPERIOD, SX1276.Settings.LoRa.HopPeriod );
+                SX1276Write( obj, REG_LR_PLLHOP, ( SX1276Read( obj, REG_LR_PLLHOP ) & RFLR_PLLHOP_FASTHOP_MASK ) | RFLR_PLLHOP_FASTHOP_ON );
+                SX1276Write( obj, REG_LR_HOPPERIOD, obj->Settings.LoRa.HopPeriod );
             }
 
-            if( ( bandwidth == 9 ) && ( SX1276.Settings.Channel > RF_MID_BAND_THRESH ) )
+            if( ( bandwidth == 9 ) && ( obj->Settings.Channel > RF_MID_BAND_THRESH ) )
             {
                 // ERRATA 2.1 - Sensitivity Optimization with a 500 kHz Bandwidth
-                SX1276Write( REG_LR_TEST36, 0x02 );
-                SX1276Write( REG_LR_TEST3A, 0x64 );
+                SX1276Write( obj, REG_LR_TEST36, 0x02 );
+                SX1276Write( obj, REG_LR_TEST3A, 0x64 );
             }
             else if( bandwidth == 9 )
             {
                 // ERRATA 2.1 - Sensitivity Optimization with a 500 kHz Bandwidth
-                SX1276Write( REG_LR_TEST36, 0x02 );
-                SX1276Write( REG_LR_TEST3A, 0x7F );
+                SX1276Write( obj, REG_LR_TEST36, 0x02 );
+                SX1276Write( obj, REG_LR_TEST3A, 0x7F );
             }
             else
             {
                 // ERRATA 2.1 - Sensitivity Optimization with a 500 kHz Bandwidth
-                SX1276Write( REG_LR_TEST36, 0x03 );
+                SX1276Write( obj, REG_LR_TEST36, 0x03 );
             }
 
             if( datarate == 6 )
             {
-                SX1276Write( REG_LR_DETECTOPTIMIZE,
-                             ( SX1276Read( REG_LR_DETECTOPTIMIZE ) &
+                SX1276Write( obj, REG_LR_DETECTOPTIMIZE,
+                             ( SX1276Read( obj, REG_LR_DETECTOPTIMIZE ) &
                                RFLR_DETECTIONOPTIMIZE_MASK ) |
                                RFLR_DETECTIONOPTIMIZE_SF6 );
-                SX1276Write( REG_LR_DETECTIONTHRESHOLD,
+                SX1276Write( obj, REG_LR_DETECTIONTHRESHOLD,
                              RFLR_DETECTIONTHRESH_SF6 );
             }
             else
             {
-                SX1276Write( REG_LR_DETECTOPTIMIZE,
-                             ( SX1276Read( REG_LR_DETECTOPTIMIZE ) &
+                SX1276Write( obj, REG_LR_DETECTOPTIMIZE,
+                             ( SX1276Read( obj, REG_LR_DETECTOPTIMIZE ) &
                              RFLR_DETECTIONOPTIMIZE_MASK ) |
                              RFLR_DETECTIONOPTIMIZE_SF7_TO_SF12 );
-                SX1276Write( REG_LR_DETECTIONTHRESHOLD,
+                SX1276Write( obj, REG_LR_DETECTIONTHRESHOLD,
                              RFLR_DETECTIONTHRESH_SF7_TO_SF12 );
             }
         }
@@ -558,69 +667,69 @@ void SX1276SetRxConfig( RadioModems_t modem, uint32_t bandwidth,
     }
 }
 
-void SX1276SetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
+void SX1276SetTxConfig( SX1276_t *obj, RadioModems_t modem, int8_t power, uint32_t fdev,
                         uint32_t bandwidth, uint32_t datarate,
                         uint8_t coderate, uint16_t preambleLen,
                         bool fixLen, bool crcOn, bool freqHopOn,
                         uint8_t hopPeriod, bool iqInverted, uint32_t timeout )
 {
-    SX1276SetModem( modem );
+    SX1276SetModem( obj, modem );
 
-    SX1276SetRfTxPower( power );
+    SX1276SetRfTxPower( obj, power );
 
     switch( modem )
     {
     case MODEM_FSK:
         {
-            SX1276.Settings.Fsk.Power = power;
-            SX1276.Settings.Fsk.Fdev = fdev;
-            SX1276.Settings.Fsk.Bandwidth = bandwidth;
-            SX1276.Settings.Fsk.Datarate = datarate;
-            SX1276.Settings.Fsk.PreambleLen = preambleLen;
-            SX1276.Settings.Fsk.FixLen = fixLen;
-            SX1276.Settings.Fsk.CrcOn = crcOn;
-            SX1276.Settings.Fsk.IqInverted = iqInverted;
-            SX1276.Settings.Fsk.TxTimeout = timeout;
+            obj->Settings.Fsk.Power = power;
+            obj->Settings.Fsk.Fdev = fdev;
+            obj->Settings.Fsk.Bandwidth = bandwidth;
+            obj->Settings.Fsk.Datarate = datarate;
+            obj->Settings.Fsk.PreambleLen = preambleLen;
+            obj->Settings.Fsk.FixLen = fixLen;
+            obj->Settings.Fsk.CrcOn = crcOn;
+            obj->Settings.Fsk.IqInverted = iqInverted;
+            obj->Settings.Fsk.TxTimeout = timeout;
 
             fdev = ( uint16_t )( ( double )fdev / ( double )FREQ_STEP );
-            SX1276Write( REG_FDEVMSB, ( uint8_t )( fdev >> 8 ) );
-            SX1276Write( REG_FDEVLSB, ( uint8_t )( fdev & 0xFF ) );
+            SX1276Write( obj, REG_FDEVMSB, ( uint8_t )( fdev >> 8 ) );
+            SX1276Write( obj, REG_FDEVLSB, ( uint8_t )( fdev & 0xFF ) );
 
             datarate = ( uint16_t )( ( double )XTAL_FREQ / ( double )datarate );
-            SX1276Write( REG_BITRATEMSB, ( uint8_t )( datarate >> 8 ) );
-            SX1276Write( REG_BITRATELSB, ( uint8_t )( datarate & 0xFF ) );
+            SX1276Write( obj, REG_BITRATEMSB, ( uint8_t )( datarate >> 8 ) );
+            SX1276Write( obj, REG_BITRATELSB, ( uint8_t )( datarate & 0xFF ) );
 
-            SX1276Write( REG_PREAMBLEMSB, ( preambleLen >> 8 ) & 0x00FF );
-            SX1276Write( REG_PREAMBLELSB, preambleLen & 0xFF );
+            SX1276Write( obj, REG_PREAMBLEMSB, ( preambleLen >> 8 ) & 0x00FF );
+            SX1276Write( obj, REG_PREAMBLELSB, preambleLen & 0xFF );
 
-            SX1276Write( REG_PACKETCONFIG1,
-                         ( SX1276Read( REG_PACKETCONFIG1 ) &
+            SX1276Write( obj, REG_PACKETCONFIG1,
+                         ( SX1276Read( obj, REG_PACKETCONFIG1 ) &
                            RF_PACKETCONFIG1_CRC_MASK &
                            RF_PACKETCONFIG1_PACKETFORMAT_MASK ) |
                            ( ( fixLen == 1 ) ? RF_PACKETCONFIG1_PACKETFORMAT_FIXED : RF_PACKETCONFIG1_PACKETFORMAT_VARIABLE ) |
                            ( crcOn << 4 ) );
-            SX1276Write( REG_PACKETCONFIG2, ( SX1276Read( REG_PACKETCONFIG2 ) | RF_PACKETCONFIG2_DATAMODE_PACKET ) );
+            SX1276Write( obj, REG_PACKETCONFIG2, ( SX1276Read( obj, REG_PACKETCONFIG2 ) | RF_PACKETCONFIG2_DATAMODE_PACKET ) );
         }
         break;
     case MODEM_LORA:
         {
-            SX1276.Settings.LoRa.Power = power;
+            obj->Settings.LoRa.Power = power;
             if( bandwidth > 2 )
             {
                 // Fatal error: When using LoRa modem only bandwidths 125, 250 and 500 kHz are supported
                 while( 1 );
             }
             bandwidth += 7;
-            SX1276.Settings.LoRa.Bandwidth = bandwidth;
-            SX1276.Settings.LoRa.Datarate = datarate;
-            SX1276.Settings.LoRa.Coderate = coderate;
-            SX1276.Settings.LoRa.PreambleLen = preambleLen;
-            SX1276.Settings.LoRa.FixLen = fixLen;
-            SX1276.Settings.LoRa.FreqHopOn = freqHopOn;
-            SX1276.Settings.LoRa.HopPeriod = hopPeriod;
-            SX1276.Settings.LoRa.CrcOn = crcOn;
-            SX1276.Settings.LoRa.IqInverted = iqInverted;
-            SX1276.Settings.LoRa.TxTimeout = timeout;
+            obj->Settings.LoRa.Bandwidth = bandwidth;
+            obj->Settings.LoRa.Datarate = datarate;
+            obj->Settings.LoRa.Coderate = coderate;
+            obj->Settings.LoRa.PreambleLen = preambleLen;
+            obj->Settings.LoRa.FixLen = fixLen;
+            obj->Settings.LoRa.FreqHopOn = freqHopOn;
+            obj->Settings.LoRa.HopPeriod = hopPeriod;
+            obj->Settings.LoRa.CrcOn = crcOn;
+            obj->Settings.LoRa.IqInverted = iqInverted;
+            obj->Settings.LoRa.TxTimeout = timeout;
 
             if( datarate > 12 )
             {
@@ -633,57 +742,57 @@ void SX1276SetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
             if( ( ( bandwidth == 7 ) && ( ( datarate == 11 ) || ( datarate == 12 ) ) ) ||
                 ( ( bandwidth == 8 ) && ( datarate == 12 ) ) )
             {
-                SX1276.Settings.LoRa.LowDatarateOptimize = 0x01;
+                obj->Settings.LoRa.LowDatarateOptimize = 0x01;
             }
             else
             {
-                SX1276.Settings.LoRa.LowDatarateOptimize = 0x00;
+                obj->Settings.LoRa.LowDatarateOptimize = 0x00;
             }
 
-            if( SX1276.Settings.LoRa.FreqHopOn == true )
+            if( obj->Settings.LoRa.FreqHopOn == true )
             {
-                SX1276Write( REG_LR_PLLHOP, ( SX1276Read( REG_LR_PLLHOP ) & RFLR_PLLHOP_FASTHOP_MASK ) | RFLR_PLLHOP_FASTHOP_ON );
-                SX1276Write( REG_LR_HOPPERIOD, SX1276.Settings.LoRa.HopPeriod );
+                SX1276Write( obj, REG_LR_PLLHOP, ( SX1276Read( obj, REG_LR_PLLHOP ) & RFLR_PLLHOP_FASTHOP_MASK ) | RFLR_PLLHOP_FASTHOP_ON );
+                SX1276Write( obj, REG_LR_HOPPERIOD, obj->Settings.LoRa.HopPeriod );
             }
 
-            SX1276Write( REG_LR_MODEMCONFIG1,
-                         ( SX1276Read( REG_LR_MODEMCONFIG1 ) &
+            SX1276Write( obj, REG_LR_MODEMCONFIG1,
+                         ( SX1276Read( obj, REG_LR_MODEMCONFIG1 ) &
                            RFLR_MODEMCONFIG1_BW_MASK &
                            RFLR_MODEMCONFIG1_CODINGRATE_MASK &
                            RFLR_MODEMCONFIG1_IMPLICITHEADER_MASK ) |
                            ( bandwidth << 4 ) | ( coderate << 1 ) |
                            fixLen );
 
-            SX1276Write( REG_LR_MODEMCONFIG2,
-                         ( SX1276Read( REG_LR_MODEMCONFIG2 ) &
+            SX1276Write( obj, REG_LR_MODEMCONFIG2,
+                         ( SX1276Read( obj, REG_LR_MODEMCONFIG2 ) &
                            RFLR_MODEMCONFIG2_SF_MASK &
                            RFLR_MODEMCONFIG2_RXPAYLOADCRC_MASK ) |
                            ( datarate << 4 ) | ( crcOn << 2 ) );
 
-            SX1276Write( REG_LR_MODEMCONFIG3,
-                         ( SX1276Read( REG_LR_MODEMCONFIG3 ) &
+            SX1276Write( obj, REG_LR_MODEMCONFIG3,
+                         ( SX1276Read( obj, REG_LR_MODEMCONFIG3 ) &
                            RFLR_MODEMCONFIG3_LOWDATARATEOPTIMIZE_MASK ) |
-                           ( SX1276.Settings.LoRa.LowDatarateOptimize << 3 ) );
+                           ( obj->Settings.LoRa.LowDatarateOptimize << 3 ) );
 
-            SX1276Write( REG_LR_PREAMBLEMSB, ( preambleLen >> 8 ) & 0x00FF );
-            SX1276Write( REG_LR_PREAMBLELSB, preambleLen & 0xFF );
+            SX1276Write( obj, REG_LR_PREAMBLEMSB, ( preambleLen >> 8 ) & 0x00FF );
+            SX1276Write( obj, REG_LR_PREAMBLELSB, preambleLen & 0xFF );
 
             if( datarate == 6 )
             {
-                SX1276Write( REG_LR_DETECTOPTIMIZE,
-                             ( SX1276Read( REG_LR_DETECTOPTIMIZE ) &
+                SX1276Write( obj, REG_LR_DETECTOPTIMIZE,
+                             ( SX1276Read( obj, REG_LR_DETECTOPTIMIZE ) &
                                RFLR_DETECTIONOPTIMIZE_MASK ) |
                                RFLR_DETECTIONOPTIMIZE_SF6 );
-                SX1276Write( REG_LR_DETECTIONTHRESHOLD,
+                SX1276Write( obj, REG_LR_DETECTIONTHRESHOLD,
                              RFLR_DETECTIONTHRESH_SF6 );
             }
             else
             {
-                SX1276Write( REG_LR_DETECTOPTIMIZE,
-                             ( SX1276Read( REG_LR_DETECTOPTIMIZE ) &
+                SX1276Write( obj, REG_LR_DETECTOPTIMIZE,
+                             ( SX1276Read( obj, REG_LR_DETECTOPTIMIZE ) &
                              RFLR_DETECTIONOPTIMIZE_MASK ) |
                              RFLR_DETECTIONOPTIMIZE_SF7_TO_SF12 );
-                SX1276Write( REG_LR_DETECTIONTHRESHOLD,
+                SX1276Write( obj, REG_LR_DETECTIONTHRESHOLD,
                              RFLR_DETECTIONTHRESH_SF7_TO_SF12 );
             }
         }
@@ -691,7 +800,7 @@ void SX1276SetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
     }
 }
 
-uint32_t SX1276GetTimeOnAir( RadioModems_t modem, uint8_t pktLen )
+uint32_t SX1276GetTimeOnAir( SX1276_t *obj, RadioModems_t modem, uint8_t pktLen )
 {
     uint32_t airTime = 0;
 
@@ -699,20 +808,20 @@ uint32_t SX1276GetTimeOnAir( RadioModems_t modem, uint8_t pktLen )
     {
     case MODEM_FSK:
         {
-            airTime = round( ( 8 * ( SX1276.Settings.Fsk.PreambleLen +
-                                     ( ( SX1276Read( REG_SYNCCONFIG ) & ~RF_SYNCCONFIG_SYNCSIZE_MASK ) + 1 ) +
-                                     ( ( SX1276.Settings.Fsk.FixLen == 0x01 ) ? 0.0 : 1.0 ) +
-                                     ( ( ( SX1276Read( REG_PACKETCONFIG1 ) & ~RF_PACKETCONFIG1_ADDRSFILTERING_MASK ) != 0x00 ) ? 1.0 : 0 ) +
+            airTime = round( ( 8 * ( obj->Settings.Fsk.PreambleLen +
+                                     ( ( SX1276Read( obj, REG_SYNCCONFIG ) & ~RF_SYNCCONFIG_SYNCSIZE_MASK ) + 1 ) +
+                                     ( ( obj->Settings.Fsk.FixLen == 0x01 ) ? 0.0 : 1.0 ) +
+                                     ( ( ( SX1276Read( obj, REG_PACKETCONFIG1 ) & ~RF_PACKETCONFIG1_ADDRSFILTERING_MASK ) != 0x00 ) ? 1.0 : 0 ) +
                                      pktLen +
-                                     ( ( SX1276.Settings.Fsk.CrcOn == 0x01 ) ? 2.0 : 0 ) ) /
-                                     SX1276.Settings.Fsk.Datarate ) * 1000 );
+                                     ( ( obj->Settings.Fsk.CrcOn == 0x01 ) ? 2.0 : 0 ) ) /
+                                     obj->Settings.Fsk.Datarate ) * 1000 );
         }
         break;
     case MODEM_LORA:
         {
             double bw = 0.0;
             // REMARK: When using LoRa modem only bandwidths 125, 250 and 500 kHz are supported
-            switch( SX1276.Settings.LoRa.Bandwidth )
+            switch( obj->Settings.LoRa.Bandwidth )
             {
             //case 0: // 7.8 kHz
             //    bw = 7800;
@@ -747,17 +856,17 @@ uint32_t SX1276GetTimeOnAir( RadioModems_t modem, uint8_t pktLen )
             }
 
             // Symbol rate : time for one symbol (secs)
-            double rs = bw / ( 1 << SX1276.Settings.LoRa.Datarate );
+            double rs = bw / ( 1 << obj->Settings.LoRa.Datarate );
             double ts = 1 / rs;
             // time of preamble
-            double tPreamble = ( SX1276.Settings.LoRa.PreambleLen + 4.25 ) * ts;
+            double tPreamble = ( obj->Settings.LoRa.PreambleLen + 4.25 ) * ts;
             // Symbol length of payload and time
-            double tmp = ceil( ( 8 * pktLen - 4 * SX1276.Settings.LoRa.Datarate +
-                                 28 + 16 * SX1276.Settings.LoRa.CrcOn -
-                                 ( SX1276.Settings.LoRa.FixLen ? 20 : 0 ) ) /
-                                 ( double )( 4 * ( SX1276.Settings.LoRa.Datarate -
-                                 ( ( SX1276.Settings.LoRa.LowDatarateOptimize > 0 ) ? 2 : 0 ) ) ) ) *
-                                 ( SX1276.Settings.LoRa.Coderate + 4 );
+            double tmp = ceil( ( 8 * pktLen - 4 * obj->Settings.LoRa.Datarate +
+                                 28 + 16 * obj->Settings.LoRa.CrcOn -
+                                 ( obj->Settings.LoRa.FixLen ? 20 : 0 ) ) /
+                                 ( double )( 4 * ( obj->Settings.LoRa.Datarate -
+                                 ( ( obj->Settings.LoRa.LowDatarateOptimize > 0 ) ? 2 : 0 ) ) ) ) *
+                                 ( obj->Settings.LoRa.Coderate + 4 );
             double nPayload = 8 + ( ( tmp > 0 ) ? tmp : 0 );
             double tPayload = nPayload * ts;
             // Time on air
@@ -771,107 +880,107 @@ uint32_t SX1276GetTimeOnAir( RadioModems_t modem, uint8_t pktLen )
 }
 
 
-void SX1276Send( uint8_t *buffer, uint8_t size )
+void SX1276Send( SX1276_t *obj, uint8_t *buffer, uint8_t size )
 {
     uint32_t txTimeout = 0;
 
-    switch( SX1276.Settings.Modem )
+    switch( obj->Settings.Modem )
     {
     case MODEM_FSK:
         {
-            SX1276.Settings.FskPacketHandler.NbBytes = 0;
-            SX1276.Settings.FskPacketHandler.Size = size;
+            obj->Settings.FskPacketHandler.NbBytes = 0;
+            obj->Settings.FskPacketHandler.Size = size;
 
-            if( SX1276.Settings.Fsk.FixLen == false )
+            if( obj->Settings.Fsk.FixLen == false )
             {
-                SX1276WriteFifo( ( uint8_t* )&size, 1 );
+                SX1276WriteFifo( obj, ( uint8_t* )&size, 1 );
             }
             else
             {
-                SX1276Write( REG_PAYLOADLENGTH, size );
+                SX1276Write( obj, REG_PAYLOADLENGTH, size );
             }
 
             if( ( size > 0 ) && ( size <= 64 ) )
             {
-                SX1276.Settings.FskPacketHandler.ChunkSize = size;
+                obj->Settings.FskPacketHandler.ChunkSize = size;
             }
             else
             {
-                memcpy1( RxTxBuffer, buffer, size );
-                SX1276.Settings.FskPacketHandler.ChunkSize = 32;
+                memcpy1( obj->RxTxBuffer, buffer, size );
+                obj->Settings.FskPacketHandler.ChunkSize = 32;
             }
 
             // Write payload buffer
-            SX1276WriteFifo( buffer, SX1276.Settings.FskPacketHandler.ChunkSize );
-            SX1276.Settings.FskPacketHandler.NbBytes += SX1276.Settings.FskPacketHandler.ChunkSize;
-            txTimeout = SX1276.Settings.Fsk.TxTimeout;
+            SX1276WriteFifo( obj, buffer, obj->Settings.FskPacketHandler.ChunkSize );
+            obj->Settings.FskPacketHandler.NbBytes += obj->Settings.FskPacketHandler.ChunkSize;
+            txTimeout = obj->Settings.Fsk.TxTimeout;
         }
         break;
     case MODEM_LORA:
         {
-            if( SX1276.Settings.LoRa.IqInverted == true )
+            if( obj->Settings.LoRa.IqInverted == true )
             {
-                SX1276Write( REG_LR_INVERTIQ, ( ( SX1276Read( REG_LR_INVERTIQ ) & RFLR_INVERTIQ_TX_MASK & RFLR_INVERTIQ_RX_MASK ) | RFLR_INVERTIQ_RX_OFF | RFLR_INVERTIQ_TX_ON ) );
-                SX1276Write( REG_LR_INVERTIQ2, RFLR_INVERTIQ2_ON );
+                SX1276Write( obj, REG_LR_INVERTIQ, ( ( SX1276Read( obj, REG_LR_INVERTIQ ) & RFLR_INVERTIQ_TX_MASK & RFLR_INVERTIQ_RX_MASK ) | RFLR_INVERTIQ_RX_OFF | RFLR_INVERTIQ_TX_ON ) );
+                SX1276Write( obj, REG_LR_INVERTIQ2, RFLR_INVERTIQ2_ON );
             }
             else
             {
-                SX1276Write( REG_LR_INVERTIQ, ( ( SX1276Read( REG_LR_INVERTIQ ) & RFLR_INVERTIQ_TX_MASK & RFLR_INVERTIQ_RX_MASK ) | RFLR_INVERTIQ_RX_OFF | RFLR_INVERTIQ_TX_OFF ) );
-                SX1276Write( REG_LR_INVERTIQ2, RFLR_INVERTIQ2_OFF );
+                SX1276Write( obj, REG_LR_INVERTIQ, ( ( SX1276Read( obj, REG_LR_INVERTIQ ) & RFLR_INVERTIQ_TX_MASK & RFLR_INVERTIQ_RX_MASK ) | RFLR_INVERTIQ_RX_OFF | RFLR_INVERTIQ_TX_OFF ) );
+                SX1276Write( obj, REG_LR_INVERTIQ2, RFLR_INVERTIQ2_OFF );
             }
 
-            SX1276.Settings.LoRaPacketHandler.Size = size;
+            obj->Settings.LoRaPacketHandler.Size = size;
 
             // Initializes the payload size
-            SX1276Write( REG_LR_PAYLOADLENGTH, size );
+            SX1276Write( obj, REG_LR_PAYLOADLENGTH, size );
 
             // Full buffer used for Tx
-            SX1276Write( REG_LR_FIFOTXBASEADDR, 0 );
-            SX1276Write( REG_LR_FIFOADDRPTR, 0 );
+            SX1276Write( obj, REG_LR_FIFOTXBASEADDR, 0 );
+            SX1276Write( obj, REG_LR_FIFOADDRPTR, 0 );
 
             // FIFO operations can not take place in Sleep mode
-            if( ( SX1276Read( REG_OPMODE ) & ~RF_OPMODE_MASK ) == RF_OPMODE_SLEEP )
+            if( ( SX1276Read( obj, REG_OPMODE ) & ~RF_OPMODE_MASK ) == RF_OPMODE_SLEEP )
             {
-                SX1276SetStby( );
+                SX1276SetStby( obj );
                 DelayMs( 1 );
             }
             // Write payload buffer
-            SX1276WriteFifo( buffer, size );
-            txTimeout = SX1276.Settings.LoRa.TxTimeout;
+            SX1276WriteFifo( obj, buffer, size );
+            txTimeout = obj->Settings.LoRa.TxTimeout;
         }
         break;
     }
 
-    SX1276SetTx( txTimeout );
+    SX1276SetTx( obj, txTimeout );
 }
 
-void SX1276SetSleep( void )
+void SX1276SetSleep( SX1276_t *obj )
 {
-    TimerStop( &RxTimeoutTimer );
-    TimerStop( &TxTimeoutTimer );
+    TimerStop( &obj->RxTimeoutTimer );
+    TimerStop( &obj->TxTimeoutTimer );
 
-    SX1276SetOpMode( RF_OPMODE_SLEEP );
-    SX1276.Settings.State = RF_IDLE;
+    SX1276SetOpMode( obj, RF_OPMODE_SLEEP );
+    obj->Settings.State = RF_IDLE;
 }
 
-void SX1276SetStby( void )
+void SX1276SetStby( SX1276_t *obj )
 {
-    TimerStop( &RxTimeoutTimer );
-    TimerStop( &TxTimeoutTimer );
+    TimerStop( &obj->RxTimeoutTimer );
+    TimerStop( &obj->TxTimeoutTimer );
 
-    SX1276SetOpMode( RF_OPMODE_STANDBY );
-    SX1276.Settings.State = RF_IDLE;
+    SX1276SetOpMode( obj, RF_OPMODE_STANDBY );
+    obj->Settings.State = RF_IDLE;
 }
 
-void SX1276SetRx( uint32_t timeout )
+void SX1276SetRx( SX1276_t *obj, uint32_t timeout )
 {
     bool rxContinuous = false;
 
-    switch( SX1276.Settings.Modem )
+    switch( obj->Settings.Modem )
     {
     case MODEM_FSK:
         {
-            rxContinuous = SX1276.Settings.Fsk.RxContinuous;
+            rxContinuous = obj->Settings.Fsk.RxContinuous;
 
             // DIO0=PayloadReady
             // DIO1=FifoLevel
@@ -879,93 +988,93 @@ void SX1276SetRx( uint32_t timeout )
             // DIO3=FifoEmpty
             // DIO4=Preamble
             // DIO5=ModeReady
-            SX1276Write( REG_DIOMAPPING1, ( SX1276Read( REG_DIOMAPPING1 ) & RF_DIOMAPPING1_DIO0_MASK &
+            SX1276Write( obj, REG_DIOMAPPING1, ( SX1276Read( obj, REG_DIOMAPPING1 ) & RF_DIOMAPPING1_DIO0_MASK &
                                                                             RF_DIOMAPPING1_DIO1_MASK &
                                                                             RF_DIOMAPPING1_DIO2_MASK ) |
                                                                             RF_DIOMAPPING1_DIO0_00 |
                                                                             RF_DIOMAPPING1_DIO1_00 |
                                                                             RF_DIOMAPPING1_DIO2_11 );
 
-            SX1276Write( REG_DIOMAPPING2, ( SX1276Read( REG_DIOMAPPING2 ) & RF_DIOMAPPING2_DIO4_MASK &
+            SX1276Write( obj, REG_DIOMAPPING2, ( SX1276Read( obj, REG_DIOMAPPING2 ) & RF_DIOMAPPING2_DIO4_MASK &
                                                                             RF_DIOMAPPING2_MAP_MASK ) |
                                                                             RF_DIOMAPPING2_DIO4_11 |
                                                                             RF_DIOMAPPING2_MAP_PREAMBLEDETECT );
 
-            SX1276.Settings.FskPacketHandler.FifoThresh = SX1276Read( REG_FIFOTHRESH ) & 0x3F;
+            obj->Settings.FskPacketHandler.FifoThresh = SX1276Read( obj, REG_FIFOTHRESH ) & 0x3F;
 
-            SX1276Write( REG_RXCONFIG, RF_RXCONFIG_AFCAUTO_ON | RF_RXCONFIG_AGCAUTO_ON | RF_RXCONFIG_RXTRIGER_PREAMBLEDETECT );
+            SX1276Write( obj, REG_RXCONFIG, RF_RXCONFIG_AFCAUTO_ON | RF_RXCONFIG_AGCAUTO_ON | RF_RXCONFIG_RXTRIGER_PREAMBLEDETECT );
 
-            SX1276.Settings.FskPacketHandler.PreambleDetected = false;
-            SX1276.Settings.FskPacketHandler.SyncWordDetected = false;
-            SX1276.Settings.FskPacketHandler.NbBytes = 0;
-            SX1276.Settings.FskPacketHandler.Size = 0;
+            obj->Settings.FskPacketHandler.PreambleDetected = false;
+            obj->Settings.FskPacketHandler.SyncWordDetected = false;
+            obj->Settings.FskPacketHandler.NbBytes = 0;
+            obj->Settings.FskPacketHandler.Size = 0;
         }
         break;
     case MODEM_LORA:
         {
-            if( SX1276.Settings.LoRa.IqInverted == true )
+            if( obj->Settings.LoRa.IqInverted == true )
             {
-                SX1276Write( REG_LR_INVERTIQ, ( ( SX1276Read( REG_LR_INVERTIQ ) & RFLR_INVERTIQ_TX_MASK & RFLR_INVERTIQ_RX_MASK ) | RFLR_INVERTIQ_RX_ON | RFLR_INVERTIQ_TX_OFF ) );
-                SX1276Write( REG_LR_INVERTIQ2, RFLR_INVERTIQ2_ON );
+                SX1276Write( obj, REG_LR_INVERTIQ, ( ( SX1276Read( obj, REG_LR_INVERTIQ ) & RFLR_INVERTIQ_TX_MASK & RFLR_INVERTIQ_RX_MASK ) | RFLR_INVERTIQ_RX_ON | RFLR_INVERTIQ_TX_OFF ) );
+                SX1276Write( obj, REG_LR_INVERTIQ2, RFLR_INVERTIQ2_ON );
             }
             else
             {
-                SX1276Write( REG_LR_INVERTIQ, ( ( SX1276Read( REG_LR_INVERTIQ ) & RFLR_INVERTIQ_TX_MASK & RFLR_INVERTIQ_RX_MASK ) | RFLR_INVERTIQ_RX_OFF | RFLR_INVERTIQ_TX_OFF ) );
-                SX1276Write( REG_LR_INVERTIQ2, RFLR_INVERTIQ2_OFF );
+                SX1276Write( obj, REG_LR_INVERTIQ, ( ( SX1276Read( obj, REG_LR_INVERTIQ ) & RFLR_INVERTIQ_TX_MASK & RFLR_INVERTIQ_RX_MASK ) | RFLR_INVERTIQ_RX_OFF | RFLR_INVERTIQ_TX_OFF ) );
+                SX1276Write( obj, REG_LR_INVERTIQ2, RFLR_INVERTIQ2_OFF );
             }
 
             // ERRATA 2.3 - Receiver Spurious Reception of a LoRa Signal
-            if( SX1276.Settings.LoRa.Bandwidth < 9 )
+            if( obj->Settings.LoRa.Bandwidth < 9 )
             {
-                SX1276Write( REG_LR_DETECTOPTIMIZE, SX1276Read( REG_LR_DETECTOPTIMIZE ) & 0x7F );
-                SX1276Write( REG_LR_TEST30, 0x00 );
-                switch( SX1276.Settings.LoRa.Bandwidth )
+                SX1276Write( obj, REG_LR_DETECTOPTIMIZE, SX1276Read( obj, REG_LR_DETECTOPTIMIZE ) & 0x7F );
+                SX1276Write( obj, REG_LR_TEST30, 0x00 );
+                switch( obj->Settings.LoRa.Bandwidth )
                 {
                 case 0: // 7.8 kHz
-                    SX1276Write( REG_LR_TEST2F, 0x48 );
-                    SX1276SetChannel(SX1276.Settings.Channel + 7810 );
+                    SX1276Write( obj, REG_LR_TEST2F, 0x48 );
+                    SX1276SetChannel( obj, obj->Settings.Channel + 7810 );
                     break;
                 case 1: // 10.4 kHz
-                    SX1276Write( REG_LR_TEST2F, 0x44 );
-                    SX1276SetChannel(SX1276.Settings.Channel + 10420 );
+                    SX1276Write( obj, REG_LR_TEST2F, 0x44 );
+                    SX1276SetChannel( obj, obj->Settings.Channel + 10420 );
                     break;
                 case 2: // 15.6 kHz
-                    SX1276Write( REG_LR_TEST2F, 0x44 );
-                    SX1276SetChannel(SX1276.Settings.Channel + 15620 );
+                    SX1276Write( obj, REG_LR_TEST2F, 0x44 );
+                    SX1276SetChannel( obj, obj->Settings.Channel + 15620 );
                     break;
                 case 3: // 20.8 kHz
-                    SX1276Write( REG_LR_TEST2F, 0x44 );
-                    SX1276SetChannel(SX1276.Settings.Channel + 20830 );
+                    SX1276Write( obj, REG_LR_TEST2F, 0x44 );
+                    SX1276SetChannel( obj, obj->Settings.Channel + 20830 );
                     break;
                 case 4: // 31.2 kHz
-                    SX1276Write( REG_LR_TEST2F, 0x44 );
-                    SX1276SetChannel(SX1276.Settings.Channel + 31250 );
+                    SX1276Write( obj, REG_LR_TEST2F, 0x44 );
+                    SX1276SetChannel( obj, obj->Settings.Channel + 31250 );
                     break;
                 case 5: // 41.4 kHz
-                    SX1276Write( REG_LR_TEST2F, 0x44 );
-                    SX1276SetChannel(SX1276.Settings.Channel + 41670 );
+                    SX1276Write( obj, REG_LR_TEST2F, 0x44 );
+                    SX1276SetChannel( obj, obj->Settings.Channel + 41670 );
                     break;
                 case 6: // 62.5 kHz
-                    SX1276Write( REG_LR_TEST2F, 0x40 );
+                    SX1276Write( obj, REG_LR_TEST2F, 0x40 );
                     break;
                 case 7: // 125 kHz
-                    SX1276Write( REG_LR_TEST2F, 0x40 );
+                    SX1276Write( obj, REG_LR_TEST2F, 0x40 );
                     break;
                 case 8: // 250 kHz
-                    SX1276Write( REG_LR_TEST2F, 0x40 );
+                    SX1276Write( obj, REG_LR_TEST2F, 0x40 );
                     break;
                 }
             }
             else
             {
-                SX1276Write( REG_LR_DETECTOPTIMIZE, SX1276Read( REG_LR_DETECTOPTIMIZE ) | 0x80 );
+                SX1276Write( obj, REG_LR_DETECTOPTIMIZE, SX1276Read( obj, REG_LR_DETECTOPTIMIZE ) | 0x80 );
             }
 
-            rxContinuous = SX1276.Settings.LoRa.RxContinuous;
+            rxContinuous = obj->Settings.LoRa.RxContinuous;
 
-            if( SX1276.Settings.LoRa.FreqHopOn == true )
+            if( obj->Settings.LoRa.FreqHopOn == true )
             {
-                SX1276Write( REG_LR_IRQFLAGSMASK, //RFLR_IRQFLAGS_RXTIMEOUT |
+                SX1276Write( obj, REG_LR_IRQFLAGSMASK, //RFLR_IRQFLAGS_RXTIMEOUT |
                                                   //RFLR_IRQFLAGS_RXDONE |
                                                   //RFLR_IRQFLAGS_PAYLOADCRCERROR |
                                                   RFLR_IRQFLAGS_VALIDHEADER |
@@ -975,11 +1084,11 @@ void SX1276SetRx( uint32_t timeout )
                                                   RFLR_IRQFLAGS_CADDETECTED );
 
                 // DIO0=RxDone, DIO2=FhssChangeChannel
-                SX1276Write( REG_DIOMAPPING1, ( SX1276Read( REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO0_MASK & RFLR_DIOMAPPING1_DIO2_MASK  ) | RFLR_DIOMAPPING1_DIO0_00 | RFLR_DIOMAPPING1_DIO2_00 );
+                SX1276Write( obj, REG_DIOMAPPING1, ( SX1276Read( obj, REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO0_MASK & RFLR_DIOMAPPING1_DIO2_MASK  ) | RFLR_DIOMAPPING1_DIO0_00 | RFLR_DIOMAPPING1_DIO2_00 );
             }
             else
             {
-                SX1276Write( REG_LR_IRQFLAGSMASK, //RFLR_IRQFLAGS_RXTIMEOUT |
+                SX1276Write( obj, REG_LR_IRQFLAGSMASK, //RFLR_IRQFLAGS_RXTIMEOUT |
                                                   //RFLR_IRQFLAGS_RXDONE |
                                                   //RFLR_IRQFLAGS_PAYLOADCRCERROR |
                                                   RFLR_IRQFLAGS_VALIDHEADER |
@@ -989,51 +1098,52 @@ void SX1276SetRx( uint32_t timeout )
                                                   RFLR_IRQFLAGS_CADDETECTED );
 
                 // DIO0=RxDone
-                SX1276Write( REG_DIOMAPPING1, ( SX1276Read( REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO0_MASK ) | RFLR_DIOMAPPING1_DIO0_00 );
+                SX1276Write( obj, REG_DIOMAPPING1, ( SX1276Read( obj, REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO0_MASK ) | RFLR_DIOMAPPING1_DIO0_00 );
             }
-            SX1276Write( REG_LR_FIFORXBASEADDR, 0 );
-            SX1276Write( REG_LR_FIFOADDRPTR, 0 );
+            SX1276Write( obj, REG_LR_FIFORXBASEADDR, 0 );
+            SX1276Write( obj, REG_LR_FIFOADDRPTR, 0 );
         }
         break;
     }
 
-    memset( RxTxBuffer, 0, ( size_t )RX_BUFFER_SIZE );
+    memset( obj->RxTxBuffer, 0, ( size_t )RX_BUFFER_SIZE );
 
-    SX1276.Settings.State = RF_RX_RUNNING;
+    obj->Settings.State = RF_RX_RUNNING;
     if( timeout != 0 )
     {
-        TimerSetValue( &RxTimeoutTimer, timeout );
-        TimerStart( &RxTimeoutTimer );
+        TimerSetValue( &obj->RxTimeoutTimer, timeout );
+        TimerStart( &obj->RxTimeoutTimer );
+        TRACE( TRACE_EVENT_TIMER_START, TRACE_TIMER_RADIO_RX_TIMEOUT, timeout );
     }
 
-    if( SX1276.Settings.Modem == MODEM_FSK )
+    if( obj->Settings.Modem == MODEM_FSK )
     {
-        SX1276SetOpMode( RF_OPMODE_RECEIVER );
+        SX1276SetOpMode( obj, RF_OPMODE_RECEIVER );
 
         if( rxContinuous == false )
         {
-            TimerSetValue( &RxTimeoutSyncWord, SX1276.Settings.Fsk.RxSingleTimeout );
-            TimerStart( &RxTimeoutSyncWord );
+            TimerSetValue( &obj->RxTimeoutSyncWord, obj->Settings.Fsk.RxSingleTimeout );
+            TimerStart( &obj->RxTimeoutSyncWord );
         }
     }
     else
     {
         if( rxContinuous == true )
         {
-            SX1276SetOpMode( RFLR_OPMODE_RECEIVER );
+            SX1276SetOpMode( obj, RFLR_OPMODE_RECEIVER );
         }
         else
         {
-            SX1276SetOpMode( RFLR_OPMODE_RECEIVER_SINGLE );
+            SX1276SetOpMode( obj, RFLR_OPMODE_RECEIVER_SINGLE );
         }
     }
 }
 
-void SX1276SetTx( uint32_t timeout )
+void SX1276SetTx( SX1276_t *obj, uint32_t timeout )
 {
-    TimerSetValue( &TxTimeoutTimer, timeout );
+    TimerSetValue( &obj->TxTimeoutTimer, timeout );
 
-    switch( SX1276.Settings.Modem )
+    switch( obj->Settings.Modem )
     {
     case MODEM_FSK:
         {
@@ -1043,21 +1153,21 @@ void SX1276SetTx( uint32_t timeout )
             // DIO3=FifoEmpty
             // DIO4=LowBat
             // DIO5=ModeReady
-            SX1276Write( REG_DIOMAPPING1, ( SX1276Read( REG_DIOMAPPING1 ) & RF_DIOMAPPING1_DIO0_MASK &
+            SX1276Write( obj, REG_DIOMAPPING1, ( SX1276Read( obj, REG_DIOMAPPING1 ) & RF_DIOMAPPING1_DIO0_MASK &
                                                                             RF_DIOMAPPING1_DIO1_MASK &
                                                                             RF_DIOMAPPING1_DIO2_MASK ) |
                                                                             RF_DIOMAPPING1_DIO1_01 );
 
-            SX1276Write( REG_DIOMAPPING2, ( SX1276Read( REG_DIOMAPPING2 ) & RF_DIOMAPPING2_DIO4_MASK &
+            SX1276Write( obj, REG_DIOMAPPING2, ( SX1276Read( obj, REG_DIOMAPPING2 ) & RF_DIOMAPPING2_DIO4_MASK &
                                                                             RF_DIOMAPPING2_MAP_MASK ) );
-            SX1276.Settings.FskPacketHandler.FifoThresh = SX1276Read( REG_FIFOTHRESH ) & 0x3F;
+            obj->Settings.FskPacketHandler.FifoThresh = SX1276Read( obj, REG_FIFOTHRESH ) & 0x3F;
         }
         break;
     case MODEM_LORA:
         {
-            if( SX1276.Settings.LoRa.FreqHopOn == true )
+            if( obj->Settings.LoRa.FreqHopOn == true )
             {
-                SX1276Write( REG_LR_IRQFLAGSMASK, RFLR_IRQFLAGS_RXTIMEOUT |
+                SX1276Write( obj, REG_LR_IRQFLAGSMASK, RFLR_IRQFLAGS_RXTIMEOUT |
                                                   RFLR_IRQFLAGS_RXDONE |
                                                   RFLR_IRQFLAGS_PAYLOADCRCERROR |
                                                   RFLR_IRQFLAGS_VALIDHEADER |
@@ -1067,11 +1177,11 @@ void SX1276SetTx( uint32_t timeout )
                                                   RFLR_IRQFLAGS_CADDETECTED );
 
                 // DIO0=TxDone, DIO2=FhssChangeChannel
-                SX1276Write( REG_DIOMAPPING1, ( SX1276Read( REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO0_MASK & RFLR_DIOMAPPING1_DIO2_MASK ) | RFLR_DIOMAPPING1_DIO0_01 | RFLR_DIOMAPPING1_DIO2_00 );
+                SX1276Write( obj, REG_DIOMAPPING1, ( SX1276Read( obj, REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO0_MASK & RFLR_DIOMAPPING1_DIO2_MASK ) | RFLR_DIOMAPPING1_DIO0_01 | RFLR_DIOMAPPING1_DIO2_00 );
             }
             else
             {
-                SX1276Write( REG_LR_IRQFLAGSMASK, RFLR_IRQFLAGS_RXTIMEOUT |
+                SX1276Write( obj, REG_LR_IRQFLAGSMASK, RFLR_IRQFLAGS_RXTIMEOUT |
                                                   RFLR_IRQFLAGS_RXDONE |
                                                   RFLR_IRQFLAGS_PAYLOADCRCERROR |
                                                   RFLR_IRQFLAGS_VALIDHEADER |
@@ -1081,20 +1191,21 @@ void SX1276SetTx( uint32_t timeout )
                                                   RFLR_IRQFLAGS_CADDETECTED );
 
                 // DIO0=TxDone
-                SX1276Write( REG_DIOMAPPING1, ( SX1276Read( REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO0_MASK ) | RFLR_DIOMAPPING1_DIO0_01 );
+                SX1276Write( obj, REG_DIOMAPPING1, ( SX1276Read( obj, REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO0_MASK ) | RFLR_DIOMAPPING1_DIO0_01 );
             }
         }
         break;
     }
 
-    SX1276.Settings.State = RF_TX_RUNNING;
-    TimerStart( &TxTimeoutTimer );
-    SX1276SetOpMode( RF_OPMODE_TRANSMITTER );
+    obj->Settings.State = RF_TX_RUNNING;
+    TimerStart( &obj->TxTimeoutTimer );
+    TRACE( TRACE_EVENT_TIMER_START, TRACE_TIMER_RADIO_TX_TIMEOUT, obj->TxTimeoutTimer.ReloadValue );
+    SX1276SetOpMode( obj, RF_OPMODE_TRANSMITTER );
 }
 
-void SX1276StartCad( void )
+void SX1276StartCad( SX1276_t *obj )
 {
-    switch( SX1276.Settings.Modem )
+    switch( obj->Settings.Modem )
     {
     case MODEM_FSK:
         {
@@ -1103,7 +1214,7 @@ void SX1276StartCad( void )
         break;
     case MODEM_LORA:
         {
-            SX1276Write( REG_LR_IRQFLAGSMASK, RFLR_IRQFLAGS_RXTIMEOUT |
+            SX1276Write( obj, REG_LR_IRQFLAGSMASK, RFLR_IRQFLAGS_RXTIMEOUT |
                                         RFLR_IRQFLAGS_RXDONE |
                                         RFLR_IRQFLAGS_PAYLOADCRCERROR |
                                         RFLR_IRQFLAGS_VALIDHEADER |
@@ -1113,11 +1224,12 @@ void SX1276StartCad( void )
                                         //RFLR_IRQFLAGS_CADDETECTED
                                         );
 
-            // DIO3=CADDone
-            SX1276Write( REG_DIOMAPPING1, ( SX1276Read( REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO3_MASK ) | RFLR_DIOMAPPING1_DIO3_00 );
+            // DIO3=CADDone, DIO0=CADDone as DIO3 is not wired on every board
+            SX1276Write( obj, REG_DIOMAPPING1, ( SX1276Read( obj, REG_DIOMAPPING1 ) & RFLR_DIOMAPPING1_DIO3_MASK & RFLR_DIOMAPPING1_DIO0_MASK ) |
+                                          RFLR_DIOMAPPING1_DIO3_00 | RFLR_DIOMAPPING1_DIO0_10 );
 
-            SX1276.Settings.State = RF_CAD;
-            SX1276SetOpMode( RFLR_OPMODE_CAD );
+            obj->Settings.State = RF_CAD;
+            SX1276SetOpMode( obj, RFLR_OPMODE_CAD );
         }
         break;
     default:
@@ -1125,43 +1237,44 @@ void SX1276StartCad( void )
     }
 }
 
-void SX1276SetTxContinuousWave( uint32_t freq, int8_t power, uint16_t time )
+void SX1276SetTxContinuousWave( SX1276_t *obj, uint32_t freq, int8_t power, uint16_t time )
 {
     uint32_t timeout = ( uint32_t )( time * 1000 );
 
-    SX1276SetChannel( freq );
+    SX1276SetChannel( obj, freq );
 
-    SX1276SetTxConfig( MODEM_FSK, power, 0, 0, 4800, 0, 5, false, false, 0, 0, 0, timeout );
+    SX1276SetTxConfig( obj, MODEM_FSK, power, 0, 0, 4800, 0, 5, false, false, 0, 0, 0, timeout );
 
-    SX1276Write( REG_PACKETCONFIG2, ( SX1276Read( REG_PACKETCONFIG2 ) & RF_PACKETCONFIG2_DATAMODE_MASK ) );
+    SX1276Write( obj, REG_PACKETCONFIG2, ( SX1276Read( obj, REG_PACKETCONFIG2 ) & RF_PACKETCONFIG2_DATAMODE_MASK ) );
     // Disable radio interrupts
-    SX1276Write( REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_11 | RF_DIOMAPPING1_DIO1_11 );
-    SX1276Write( REG_DIOMAPPING2, RF_DIOMAPPING2_DIO4_10 | RF_DIOMAPPING2_DIO5_10 );
+    SX1276Write( obj, REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_11 | RF_DIOMAPPING1_DIO1_11 );
+    SX1276Write( obj, REG_DIOMAPPING2, RF_DIOMAPPING2_DIO4_10 | RF_DIOMAPPING2_DIO5_10 );
 
-    TimerSetValue( &TxTimeoutTimer, timeout );
+    TimerSetValue( &obj->TxTimeoutTimer, timeout );
 
-    SX1276.Settings.State = RF_TX_RUNNING;
-    TimerStart( &TxTimeoutTimer );
-    SX1276SetOpMode( RF_OPMODE_TRANSMITTER );
+    obj->Settings.State = RF_TX_RUNNING;
+    TimerStart( &obj->TxTimeoutTimer );
+    TRACE( TRACE_EVENT_TIMER_START, TRACE_TIMER_RADIO_TX_TIMEOUT, obj->TxTimeoutTimer.ReloadValue );
+    SX1276SetOpMode( obj, RF_OPMODE_TRANSMITTER );
 }
 
-int16_t SX1276ReadRssi( RadioModems_t modem )
+int16_t SX1276ReadRssi( SX1276_t *obj, RadioModems_t modem )
 {
     int16_t rssi = 0;
 
     switch( modem )
     {
     case MODEM_FSK:
-        rssi = -( SX1276Read( REG_RSSIVALUE ) >> 1 );
+        rssi = -( SX1276Read( obj, REG_RSSIVALUE ) >> 1 );
         break;
     case MODEM_LORA:
-        if( SX1276.Settings.Channel > RF_MID_BAND_THRESH )
+        if( obj->Settings.Channel > RF_MID_BAND_THRESH )
         {
-            rssi = RSSI_OFFSET_HF + SX1276Read( REG_LR_RSSIVALUE );
+            rssi = RSSI_OFFSET_HF + SX1276Read( obj, REG_LR_RSSIVALUE );
         }
         else
         {
-            rssi = RSSI_OFFSET_LF + SX1276Read( REG_LR_RSSIVALUE );
+            rssi = RSSI_OFFSET_LF + SX1276Read( obj, REG_LR_RSSIVALUE );
         }
         break;
     default:
@@ -1171,7 +1284,7 @@ int16_t SX1276ReadRssi( RadioModems_t modem )
     return rssi;
 }
 
-void SX1276SetOpMode( uint8_t opMode )
+void SX1276SetOpMode( SX1276_t *obj, uint8_t opMode )
 {
 #if defined( USE_RADIO_DEBUG )
     switch( opMode )
@@ -1191,12 +1304,35 @@ void SX1276SetOpMode( uint8_t opMode )
 #endif
     if( opMode == RF_OPMODE_SLEEP )
     {
-        SX1276SetAntSwLowPower( true );
+        SX1276SetAntSwLowPower( obj, true );
     }
     else
     {
-        SX1276SetAntSwLowPower( false );
-        SX1276SetAntSw( opMode );
+        SX1276SetAntSwLowPower( obj, false );
+        SX1276SetAntSw( obj, opMode );
+    }
+    // The energy profile of the board covers the default radio only
+    if( obj == &SX1276 )
+    {
+        switch( opMode )
+        {
+            case RF_OPMODE_SLEEP:
+                EnergySetRadioState( ENERGY_STATE_RADIO_SLEEP );
+                break;
+            case RF_OPMODE_TRANSMITTER:
+                EnergySetRadioState( ENERGY_STATE_RADIO_TX );
+                break;
+            case RF_OPMODE_RECEIVER:
+            case RFLR_OPMODE_RECEIVER_SINGLE:
+                EnergySetRadioState( ENERGY_STATE_RADIO_RX );
+                break;
+            case RFLR_OPMODE_CAD:
+                EnergySetRadioState( ENERGY_STATE_RADIO_CAD );
+                break;
+            default:
+                EnergySetRadioState( ENERGY_STATE_RADIO_STANDBY );
+                break;
+        }
     }
 	/*
 	if(opMode==RF_OPMODE_RECEIVER||opMode==RFLR_OPMODE_RECEIVER_SINGLE)
@@ -1208,42 +1344,43 @@ void SX1276SetOpMode( uint8_t opMode )
 		xprintf("Tx\r\n");
 	}
 	*/
-    SX1276Write( REG_OPMODE, ( SX1276Read( REG_OPMODE ) & RF_OPMODE_MASK ) | opMode );
+    SX1276Write( obj, REG_OPMODE, ( SX1276Read( obj, REG_OPMODE ) & RF_OPMODE_MASK ) | opMode );
+    TRACE( TRACE_EVENT_OPMODE, opMode, 0 );
 }
 
-void SX1276SetModem( RadioModems_t modem )
+void SX1276SetModem( SX1276_t *obj, RadioModems_t modem )
 {
-    if( ( SX1276Read( REG_OPMODE ) & RFLR_OPMODE_LONGRANGEMODE_ON ) != 0 )
+    if( ( SX1276Read( obj, REG_OPMODE ) & RFLR_OPMODE_LONGRANGEMODE_ON ) != 0 )
     {
-        SX1276.Settings.Modem = MODEM_LORA;
+        obj->Settings.Modem = MODEM_LORA;
     }
     else
     {
-        SX1276.Settings.Modem = MODEM_FSK;
+        obj->Settings.Modem = MODEM_FSK;
     }
 
-    if( SX1276.Settings.Modem == modem )
+    if( obj->Settings.Modem == modem )
     {
         return;
     }
 
-    SX1276.Settings.Modem = modem;
-    switch( SX1276.Settings.Modem )
+    obj->Settings.Modem = modem;
+    switch( obj->Settings.Modem )
     {
     default:
     case MODEM_FSK:
-        SX1276SetSleep( );
-        SX1276Write( REG_OPMODE, ( SX1276Read( REG_OPMODE ) & RFLR_OPMODE_LONGRANGEMODE_MASK ) | RFLR_OPMODE_LONGRANGEMODE_OFF );
+        SX1276SetSleep( obj );
+        SX1276Write( obj, REG_OPMODE, ( SX1276Read( obj, REG_OPMODE ) & RFLR_OPMODE_LONGRANGEMODE_MASK ) | RFLR_OPMODE_LONGRANGEMODE_OFF );
 
-        SX1276Write( REG_DIOMAPPING1, 0x00 );
-        SX1276Write( REG_DIOMAPPING2, 0x30 ); // DIO5=ModeReady
+        SX1276Write( obj, REG_DIOMAPPING1, 0x00 );
+        SX1276Write( obj, REG_DIOMAPPING2, 0x30 ); // DIO5=ModeReady
         break;
     case MODEM_LORA:
-        SX1276SetSleep( );
-        SX1276Write( REG_OPMODE, ( SX1276Read( REG_OPMODE ) & RFLR_OPMODE_LONGRANGEMODE_MASK ) | RFLR_OPMODE_LONGRANGEMODE_ON );
+        SX1276SetSleep( obj );
+        SX1276Write( obj, REG_OPMODE, ( SX1276Read( obj, REG_OPMODE ) & RFLR_OPMODE_LONGRANGEMODE_MASK ) | RFLR_OPMODE_LONGRANGEMODE_ON );
 
-        SX1276Write( REG_DIOMAPPING1, 0x00 );
-        SX1276Write( REG_DIOMAPPING2, 0x00 );
+        SX1276Write( obj, REG_DIOMAPPING1, 0x00 );
+        SX1276Write( obj, REG_DIOMAPPING2, 0x00 );
         break;
     }
 }
@@ -1253,67 +1390,89 @@ extern uint8_t read0(uint16_t address);
 extern void writefifo(uint16_t address, uint8_t *buffer, uint8_t size);
 extern void readfifo(uint16_t address, uint8_t *buffer, uint8_t size);
 
-void SX1276Write( uint16_t addr, uint8_t data )
+void SX1276Write( SX1276_t *obj, uint16_t addr, uint8_t data )
 {
+    if( obj->Bus != NULL )
+    {
+        obj->Bus->Write( obj, addr, &data, 1 );
+        return;
+    }
 	write0(addr,data);//write(address, value);
 }
 
-uint8_t SX1276Read( uint16_t addr )
+uint8_t SX1276Read( SX1276_t *obj, uint16_t addr )
 {
+    uint8_t data;
+
+    if( obj->Bus != NULL )
+    {
+        obj->Bus->Read( obj, addr, &data, 1 );
+        return data;
+    }
 	return read0(addr);//read(address);
 }
 
-void SX1276WriteBuffer( uint16_t addr, uint8_t *buffer, uint8_t size )
+void SX1276WriteBuffer( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size )
 {
-
+    if( obj->Bus != NULL )
+    {
+        obj->Bus->Write( obj, addr, buffer, size );
+        return;
+    }
+	writefifo(addr | 0x80, buffer, size);
 }
 
-void SX1276ReadBuffer( uint16_t addr, uint8_t *buffer, uint8_t size )
+void SX1276ReadBuffer( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size )
 {
-
+    if( obj->Bus != NULL )
+    {
+        obj->Bus->Read( obj, addr, buffer, size );
+        return;
+    }
+	readfifo(addr & 0x7F, buffer, size);
 }
 
-void SX1276WriteFifo( uint8_t *buffer, uint8_t size )
+void SX1276WriteFifo( SX1276_t *obj, uint8_t *buffer, uint8_t size )
 {
-	writefifo(0X00 | 0x80, buffer, size);
+    SX1276WriteBuffer( obj, 0, buffer, size );
 }
 
-void SX1276ReadFifo( uint8_t *buffer, uint8_t size )
+void SX1276ReadFifo( SX1276_t *obj, uint8_t *buffer, uint8_t size )
 {
-	readfifo(0X00 & 0x7F, buffer, size);
+    SX1276ReadBuffer( obj, 0, buffer, size );
 }
 
-void SX1276SetMaxPayloadLength( RadioModems_t modem, uint8_t max )
+void SX1276SetMaxPayloadLength( SX1276_t *obj, RadioModems_t modem, uint8_t max )
 {
-    SX1276SetModem( modem );
+    SX1276SetModem( obj, modem );
 
     switch( modem )
     {
     case MODEM_FSK:
-        if( SX1276.Settings.Fsk.FixLen == false )
+        if( obj->Settings.Fsk.FixLen == false )
         {
-            SX1276Write( REG_PAYLOADLENGTH, max );
+            SX1276Write( obj, REG_PAYLOADLENGTH, max );
         }
         break;
     case MODEM_LORA:
-        SX1276Write( REG_LR_PAYLOADMAXLENGTH, max );
+        SX1276Write( obj, REG_LR_PAYLOADMAXLENGTH, max );
         break;
     }
 }
 
-void SX1276SetPublicNetwork( bool enable )
+void SX1276SetPublicNetwork( SX1276_t *obj, bool enable )
 {
-    SX1276SetModem( MODEM_LORA );
-    SX1276.Settings.LoRa.PublicNetwork = enable;
+    SX1276SetModem( obj, MODEM_LORA );
+    obj->Settings.LoRa.PublicNetwork = enable;
     if( enable == true )
     {
         // Change LoRa modem SyncWord
-        SX1276Write( REG_LR_SYNCWORD, LORA_MAC_PUBLIC_SYNCWORD );
+        SX1276Write( obj, REG_LR_SYNCWORD, LORA_MAC_PUBLIC_SYNCWORD );
     }
     else
     {
         // Change LoRa modem SyncWord
-        SX1276Write( REG_LR_SYNCWORD, LORA_MAC_PRIVATE_SYNCWORD );
+        SX1276Write( obj, REG_LR_SYNCWORD, LORA_MAC_PRIVATE_SYNCWORD );
     }
 }
 
@@ -1322,39 +1481,45 @@ uint32_t SX1276GetWakeupTime( void )
     return SX1276GetBoardTcxoWakeupTime( ) + RADIO_WAKEUP_TIME;
 }
 
-void SX1276OnTimeoutIrq( void )
+uint32_t SX1276GetDio0Time( SX1276_t *obj )
 {
-    switch( SX1276.Settings.State )
+    return obj->Dio0Time;
+}
+
+void SX1276OnTimeoutIrq( SX1276_t *obj )
+{
+    TRACE( TRACE_EVENT_TIMER_FIRE, ( obj->Settings.State == RF_TX_RUNNING ) ? TRACE_TIMER_RADIO_TX_TIMEOUT : TRACE_TIMER_RADIO_RX_TIMEOUT, obj->Settings.State );
+    switch( obj->Settings.State )
     {
     case RF_RX_RUNNING:
-        if( SX1276.Settings.Modem == MODEM_FSK )
+        if( obj->Settings.Modem == MODEM_FSK )
         {
-            SX1276.Settings.FskPacketHandler.PreambleDetected = false;
-            SX1276.Settings.FskPacketHandler.SyncWordDetected = false;
-            SX1276.Settings.FskPacketHandler.NbBytes = 0;
-            SX1276.Settings.FskPacketHandler.Size = 0;
+            obj->Settings.FskPacketHandler.PreambleDetected = false;
+            obj->Settings.FskPacketHandler.SyncWordDetected = false;
+            obj->Settings.FskPacketHandler.NbBytes = 0;
+            obj->Settings.FskPacketHandler.Size = 0;
 
             // Clear Irqs
-            SX1276Write( REG_IRQFLAGS1, RF_IRQFLAGS1_RSSI |
+            SX1276Write( obj, REG_IRQFLAGS1, RF_IRQFLAGS1_RSSI |
                                         RF_IRQFLAGS1_PREAMBLEDETECT |
                                         RF_IRQFLAGS1_SYNCADDRESSMATCH );
-            SX1276Write( REG_IRQFLAGS2, RF_IRQFLAGS2_FIFOOVERRUN );
+            SX1276Write( obj, REG_IRQFLAGS2, RF_IRQFLAGS2_FIFOOVERRUN );
 
-            if( SX1276.Settings.Fsk.RxContinuous == true )
+            if( obj->Settings.Fsk.RxContinuous == true )
             {
                 // Continuous mode restart Rx chain
-                SX1276Write( REG_RXCONFIG, SX1276Read( REG_RXCONFIG ) | RF_RXCONFIG_RESTARTRXWITHOUTPLLLOCK );
-                TimerStart( &RxTimeoutSyncWord );
+                SX1276Write( obj, REG_RXCONFIG, SX1276Read( obj, REG_RXCONFIG ) | RF_RXCONFIG_RESTARTRXWITHOUTPLLLOCK );
+                TimerStart( &obj->RxTimeoutSyncWord );
             }
             else
             {
-                SX1276.Settings.State = RF_IDLE;
-                TimerStop( &RxTimeoutSyncWord );
+                obj->Settings.State = RF_IDLE;
+                TimerStop( &obj->RxTimeoutSyncWord );
             }
         }
-        if( ( RadioEvents != NULL ) && ( RadioEvents->RxTimeout != NULL ) )
+        if( ( obj->Events != NULL ) && ( obj->Events->RxTimeout != NULL ) )
         {
-            RadioEvents->RxTimeout( );
+            obj->Events->RxTimeout( );
         }
         break;
     case RF_TX_RUNNING:
@@ -1367,29 +1532,29 @@ void SX1276OnTimeoutIrq( void )
         // BEGIN WORKAROUND
 
         // Reset the radio
-        SX1276Reset( );
+        SX1276Reset( obj );
 
         // Calibrate Rx chain
-        RxChainCalibration( );
+        RxChainCalibration( obj );
 
         // Initialize radio default values
-        SX1276SetOpMode( RF_OPMODE_SLEEP );
+        SX1276SetOpMode( obj, RF_OPMODE_SLEEP );
 
         for( uint8_t i = 0; i < sizeof( RadioRegsInit ) / sizeof( RadioRegisters_t ); i++ )
         {
-            SX1276SetModem( RadioRegsInit[i].Modem );
-            SX1276Write( RadioRegsInit[i].Addr, RadioRegsInit[i].Value );
+            SX1276SetModem( obj, RadioRegsInit[i].Modem );
+            SX1276Write( obj, RadioRegsInit[i].Addr, RadioRegsInit[i].Value );
         }
-        SX1276SetModem( MODEM_FSK );
+        SX1276SetModem( obj, MODEM_FSK );
 
         // Restore previous network type setting.
-        SX1276SetPublicNetwork( SX1276.Settings.LoRa.PublicNetwork );
+        SX1276SetPublicNetwork( obj, obj->Settings.LoRa.PublicNetwork );
         // END WORKAROUND
 
-        SX1276.Settings.State = RF_IDLE;
-        if( ( RadioEvents != NULL ) && ( RadioEvents->TxTimeout != NULL ) )
+        obj->Settings.State = RF_IDLE;
+        if( ( obj->Events != NULL ) && ( obj->Events->TxTimeout != NULL ) )
         {
-            RadioEvents->TxTimeout( );
+            obj->Events->TxTimeout( );
         }
         break;
     default:
@@ -1398,179 +1563,180 @@ void SX1276OnTimeoutIrq( void )
 }
 
 
-void SX1276OnDio0Irq( void )
+void SX1276OnDio0Irq( SX1276_t *obj )
 {
-	//xprintf("0\r\n");
     volatile uint8_t irqFlags = 0;
-    switch( SX1276.Settings.State )
+
+    TRACE( TRACE_EVENT_IRQ, 0, obj->Settings.State );
+    switch( obj->Settings.State )
     {
         case RF_RX_RUNNING:
-            //TimerStop( &RxTimeoutTimer );
+            //TimerStop( &obj->RxTimeoutTimer );
             // RxDone interrupt
-            switch( SX1276.Settings.Modem )
+            switch( obj->Settings.Modem )
             {
             case MODEM_FSK:
-                if( SX1276.Settings.Fsk.CrcOn == true )
+                if( obj->Settings.Fsk.CrcOn == true )
                 {
-                    irqFlags = SX1276Read( REG_IRQFLAGS2 );
+                    irqFlags = SX1276Read( obj, REG_IRQFLAGS2 );
                     if( ( irqFlags & RF_IRQFLAGS2_CRCOK ) != RF_IRQFLAGS2_CRCOK )
                     {
                         // Clear Irqs
-                        SX1276Write( REG_IRQFLAGS1, RF_IRQFLAGS1_RSSI |
+                        SX1276Write( obj, REG_IRQFLAGS1, RF_IRQFLAGS1_RSSI |
                                                     RF_IRQFLAGS1_PREAMBLEDETECT |
                                                     RF_IRQFLAGS1_SYNCADDRESSMATCH );
-                        SX1276Write( REG_IRQFLAGS2, RF_IRQFLAGS2_FIFOOVERRUN );
+                        SX1276Write( obj, REG_IRQFLAGS2, RF_IRQFLAGS2_FIFOOVERRUN );
 
-                        TimerStop( &RxTimeoutTimer );
+                        TimerStop( &obj->RxTimeoutTimer );
 
-                        if( SX1276.Settings.Fsk.RxContinuous == false )
+                        if( obj->Settings.Fsk.RxContinuous == false )
                         {
-                            TimerStop( &RxTimeoutSyncWord );
-                            SX1276.Settings.State = RF_IDLE;
+                            TimerStop( &obj->RxTimeoutSyncWord );
+                            obj->Settings.State = RF_IDLE;
                         }
                         else
                         {
                             // Continuous mode restart Rx chain
-                            SX1276Write( REG_RXCONFIG, SX1276Read( REG_RXCONFIG ) | RF_RXCONFIG_RESTARTRXWITHOUTPLLLOCK );
-                            TimerStart( &RxTimeoutSyncWord );
+                            SX1276Write( obj, REG_RXCONFIG, SX1276Read( obj, REG_RXCONFIG ) | RF_RXCONFIG_RESTARTRXWITHOUTPLLLOCK );
+                            TimerStart( &obj->RxTimeoutSyncWord );
                         }
 
-                        if( ( RadioEvents != NULL ) && ( RadioEvents->RxError != NULL ) )
+                        if( ( obj->Events != NULL ) && ( obj->Events->RxError != NULL ) )
                         {
-                            RadioEvents->RxError( );
+                            obj->Events->RxError( );
                         }
-                        SX1276.Settings.FskPacketHandler.PreambleDetected = false;
-                        SX1276.Settings.FskPacketHandler.SyncWordDetected = false;
-                        SX1276.Settings.FskPacketHandler.NbBytes = 0;
-                        SX1276.Settings.FskPacketHandler.Size = 0;
+                        obj->Settings.FskPacketHandler.PreambleDetected = false;
+                        obj->Settings.FskPacketHandler.SyncWordDetected = false;
+                        obj->Settings.FskPacketHandler.NbBytes = 0;
+                        obj->Settings.FskPacketHandler.Size = 0;
                         break;
                     }
                 }
 
                 // Read received packet size
-                if( ( SX1276.Settings.FskPacketHandler.Size == 0 ) && ( SX1276.Settings.FskPacketHandler.NbBytes == 0 ) )
+                if( ( obj->Settings.FskPacketHandler.Size == 0 ) && ( obj->Settings.FskPacketHandler.NbBytes == 0 ) )
                 {
-                    if( SX1276.Settings.Fsk.FixLen == false )
+                    if( obj->Settings.Fsk.FixLen == false )
                     {
-                        SX1276ReadFifo( ( uint8_t* )&SX1276.Settings.FskPacketHandler.Size, 1 );
+                        SX1276ReadFifo( obj, ( uint8_t* )&obj->Settings.FskPacketHandler.Size, 1 );
                     }
                     else
                     {
-                        SX1276.Settings.FskPacketHandler.Size = SX1276Read( REG_PAYLOADLENGTH );
+                        obj->Settings.FskPacketHandler.Size = SX1276Read( obj, REG_PAYLOADLENGTH );
                     }
-                    SX1276ReadFifo( RxTxBuffer + SX1276.Settings.FskPacketHandler.NbBytes, SX1276.Settings.FskPacketHandler.Size - SX1276.Settings.FskPacketHandler.NbBytes );
-                    SX1276.Settings.FskPacketHandler.NbBytes += ( SX1276.Settings.FskPacketHandler.Size - SX1276.Settings.FskPacketHandler.NbBytes );
+                    SX1276ReadFifo( obj, obj->RxTxBuffer + obj->Settings.FskPacketHandler.NbBytes, obj->Settings.FskPacketHandler.Size - obj->Settings.FskPacketHandler.NbBytes );
+                    obj->Settings.FskPacketHandler.NbBytes += ( obj->Settings.FskPacketHandler.Size - obj->Settings.FskPacketHandler.NbBytes );
                 }
                 else
                 {
-                    SX1276ReadFifo( RxTxBuffer + SX1276.Settings.FskPacketHandler.NbBytes, SX1276.Settings.FskPacketHandler.Size - SX1276.Settings.FskPacketHandler.NbBytes );
-                    SX1276.Settings.FskPacketHandler.NbBytes += ( SX1276.Settings.FskPacketHandler.Size - SX1276.Settings.FskPacketHandler.NbBytes );
+                    SX1276ReadFifo( obj, obj->RxTxBuffer + obj->Settings.FskPacketHandler.NbBytes, obj->Settings.FskPacketHandler.Size - obj->Settings.FskPacketHandler.NbBytes );
+                    obj->Settings.FskPacketHandler.NbBytes += ( obj->Settings.FskPacketHandler.Size - obj->Settings.FskPacketHandler.NbBytes );
                 }
 
-                TimerStop( &RxTimeoutTimer );
+                TimerStop( &obj->RxTimeoutTimer );
 
-                if( SX1276.Settings.Fsk.RxContinuous == false )
+                if( obj->Settings.Fsk.RxContinuous == false )
                 {
-                    SX1276.Settings.State = RF_IDLE;
-                    TimerStop( &RxTimeoutSyncWord );
+                    obj->Settings.State = RF_IDLE;
+                    TimerStop( &obj->RxTimeoutSyncWord );
                 }
                 else
                 {
                     // Continuous mode restart Rx chain
-                    SX1276Write( REG_RXCONFIG, SX1276Read( REG_RXCONFIG ) | RF_RXCONFIG_RESTARTRXWITHOUTPLLLOCK );
-                    TimerStart( &RxTimeoutSyncWord );
+                    SX1276Write( obj, REG_RXCONFIG, SX1276Read( obj, REG_RXCONFIG ) | RF_RXCONFIG_RESTARTRXWITHOUTPLLLOCK );
+                    TimerStart( &obj->RxTimeoutSyncWord );
                 }
 
-                if( ( RadioEvents != NULL ) && ( RadioEvents->RxDone != NULL ) )
+                if( ( obj->Events != NULL ) && ( obj->Events->RxDone != NULL ) )
                 {
-                    RadioEvents->RxDone( RxTxBuffer, SX1276.Settings.FskPacketHandler.Size, SX1276.Settings.FskPacketHandler.RssiValue, 0 );
+                    obj->Events->RxDone( obj->RxTxBuffer, obj->Settings.FskPacketHandler.Size, obj->Settings.FskPacketHandler.RssiValue, 0 );
                 }
-                SX1276.Settings.FskPacketHandler.PreambleDetected = false;
-                SX1276.Settings.FskPacketHandler.SyncWordDetected = false;
-                SX1276.Settings.FskPacketHandler.NbBytes = 0;
-                SX1276.Settings.FskPacketHandler.Size = 0;
+                obj->Settings.FskPacketHandler.PreambleDetected = false;
+                obj->Settings.FskPacketHandler.SyncWordDetected = false;
+                obj->Settings.FskPacketHandler.NbBytes = 0;
+                obj->Settings.FskPacketHandler.Size = 0;
                 break;
             case MODEM_LORA:
                 {
                     int8_t snr = 0;
 
                     // Clear Irq
-                    SX1276Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_RXDONE );
+                    SX1276Write( obj, REG_LR_IRQFLAGS, RFLR_IRQFLAGS_RXDONE );
 
-                    irqFlags = SX1276Read( REG_LR_IRQFLAGS );
+                    irqFlags = SX1276Read( obj, REG_LR_IRQFLAGS );
                     if( ( irqFlags & RFLR_IRQFLAGS_PAYLOADCRCERROR_MASK ) == RFLR_IRQFLAGS_PAYLOADCRCERROR )
                     {
                         // Clear Irq
-                        SX1276Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_PAYLOADCRCERROR );
+                        SX1276Write( obj, REG_LR_IRQFLAGS, RFLR_IRQFLAGS_PAYLOADCRCERROR );
 
-                        if( SX1276.Settings.LoRa.RxContinuous == false )
+                        if( obj->Settings.LoRa.RxContinuous == false )
                         {
-                            SX1276.Settings.State = RF_IDLE;
+                            obj->Settings.State = RF_IDLE;
                         }
-                        TimerStop( &RxTimeoutTimer );
+                        TimerStop( &obj->RxTimeoutTimer );
 
-                        if( ( RadioEvents != NULL ) && ( RadioEvents->RxError != NULL ) )
+                        if( ( obj->Events != NULL ) && ( obj->Events->RxError != NULL ) )
                         {
                         	DIO_PRINTF("DIO0:RX Error\r\n");
-                            RadioEvents->RxError( );
+                            obj->Events->RxError( );
                         }
                         break;
                     }
 
-                    SX1276.Settings.LoRaPacketHandler.SnrValue = ( ( ( int8_t )SX1276Read( REG_LR_PKTSNRVALUE ) ) + 2 ) >> 2;
+                    obj->Settings.LoRaPacketHandler.SnrValue = ( ( ( int8_t )SX1276Read( obj, REG_LR_PKTSNRVALUE ) ) + 2 ) >> 2;
                     /*
-                    if( SX1276.Settings.LoRaPacketHandler.SnrValue & 0x80 ) // The SNR sign bit is 1
+                    if( obj->Settings.LoRaPacketHandler.SnrValue & 0x80 ) // The SNR sign bit is 1
                     {
                         // Invert and divide by 4
-                        snr = ( ( ~SX1276.Settings.LoRaPacketHandler.SnrValue + 1 ) & 0xFF ) >> 2;
+                        snr = ( ( ~obj->Settings.LoRaPacketHandler.SnrValue + 1 ) & 0xFF ) >> 2;
                         snr = -snr;
                     }
                     else
                     {
                         // Divide by 4
-                        snr = ( SX1276.Settings.LoRaPacketHandler.SnrValue & 0xFF ) >> 2;
+                        snr = ( obj->Settings.LoRaPacketHandler.SnrValue & 0xFF ) >> 2;
                     }*/
 
-                    int16_t rssi = SX1276Read( REG_LR_PKTRSSIVALUE );
+                    int16_t rssi = SX1276Read( obj, REG_LR_PKTRSSIVALUE );
                     if( snr < 0 )
                     {
-                        if( SX1276.Settings.Channel > RF_MID_BAND_THRESH )
+                        if( obj->Settings.Channel > RF_MID_BAND_THRESH )
                         {
-                            SX1276.Settings.LoRaPacketHandler.RssiValue = RSSI_OFFSET_HF + rssi + ( rssi >> 4 ) +
+                            obj->Settings.LoRaPacketHandler.RssiValue = RSSI_OFFSET_HF + rssi + ( rssi >> 4 ) +
                                                                           snr;
                         }
                         else
                         {
-                            SX1276.Settings.LoRaPacketHandler.RssiValue = RSSI_OFFSET_LF + rssi + ( rssi >> 4 ) +
+                            obj->Settings.LoRaPacketHandler.RssiValue = RSSI_OFFSET_LF + rssi + ( rssi >> 4 ) +
                                                                           snr;
                         }
                     }
                     else
                     {
-                        if( SX1276.Settings.Channel > RF_MID_BAND_THRESH )
+                        if( obj->Settings.Channel > RF_MID_BAND_THRESH )
                         {
-                            SX1276.Settings.LoRaPacketHandler.RssiValue = RSSI_OFFSET_HF + rssi + ( rssi >> 4 );
+                            obj->Settings.LoRaPacketHandler.RssiValue = RSSI_OFFSET_HF + rssi + ( rssi >> 4 );
                         }
                         else
                         {
-                            SX1276.Settings.LoRaPacketHandler.RssiValue = RSSI_OFFSET_LF + rssi + ( rssi >> 4 );
+                            obj->Settings.LoRaPacketHandler.RssiValue = RSSI_OFFSET_LF + rssi + ( rssi >> 4 );
                         }
                     }
 
-                    SX1276.Settings.LoRaPacketHandler.Size = SX1276Read( REG_LR_RXNBBYTES );
-                    SX1276Write( REG_LR_FIFOADDRPTR, SX1276Read( REG_LR_FIFORXCURRENTADDR ) );
-                    SX1276ReadFifo( RxTxBuffer, SX1276.Settings.LoRaPacketHandler.Size );
+                    obj->Settings.LoRaPacketHandler.Size = SX1276Read( obj, REG_LR_RXNBBYTES );
+                    SX1276Write( obj, REG_LR_FIFOADDRPTR, SX1276Read( obj, REG_LR_FIFORXCURRENTADDR ) );
+                    SX1276ReadFifo( obj, obj->RxTxBuffer, obj->Settings.LoRaPacketHandler.Size );
 
-                    if( SX1276.Settings.LoRa.RxContinuous == false )
+                    if( obj->Settings.LoRa.RxContinuous == false )
                     {
-                        SX1276.Settings.State = RF_IDLE;
+                        obj->Settings.State = RF_IDLE;
                     }
-                    TimerStop( &RxTimeoutTimer );
+                    TimerStop( &obj->RxTimeoutTimer );
 
-                    if( ( RadioEvents != NULL ) && ( RadioEvents->RxDone != NULL ) )
+                    if( ( obj->Events != NULL ) && ( obj->Events->RxDone != NULL ) )
                     {
                     	DIO_PRINTF("DIO0:RX Done\r\n");
-                        RadioEvents->RxDone( RxTxBuffer, SX1276.Settings.LoRaPacketHandler.Size, SX1276.Settings.LoRaPacketHandler.RssiValue, SX1276.Settings.LoRaPacketHandler.SnrValue );
+                        obj->Events->RxDone( obj->RxTxBuffer, obj->Settings.LoRaPacketHandler.Size, obj->Settings.LoRaPacketHandler.RssiValue, obj->Settings.LoRaPacketHandler.SnrValue );
                     }
                 }
                 break;
@@ -1579,75 +1745,79 @@ void SX1276OnDio0Irq( void )
             }
             break;
         case RF_TX_RUNNING:
-            TimerStop( &TxTimeoutTimer );
+            TimerStop( &obj->TxTimeoutTimer );
             // TxDone interrupt
-            switch( SX1276.Settings.Modem )
+            switch( obj->Settings.Modem )
             {
             case MODEM_LORA:
                 // Clear Irq
-                SX1276Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_TXDONE );
+                SX1276Write( obj, REG_LR_IRQFLAGS, RFLR_IRQFLAGS_TXDONE );
                 // Intentional fall through
             case MODEM_FSK:
             default:
-                SX1276.Settings.State = RF_IDLE;
-                if( ( RadioEvents != NULL ) && ( RadioEvents->TxDone != NULL ) )
+                obj->Settings.State = RF_IDLE;
+                if( ( obj->Events != NULL ) && ( obj->Events->TxDone != NULL ) )
                 {
                 	DIO_PRINTF("DIO0:TX Done\r\n");
-                    RadioEvents->TxDone( );
+                    obj->Events->TxDone( );
                 }
                 break;
             }
             break;
+        case RF_CAD:
+            // CadDone interrupt
+            SX1276OnDio3Irq( obj );
+            break;
         default:
             break;
     }
 }
 
-void SX1276OnDio1Irq( void )
+void SX1276OnDio1Irq( SX1276_t *obj )
 {
-	//xprintf("1\r\n");
-    switch( SX1276.Settings.State )
+    TRACE( TRACE_EVENT_IRQ, 1, obj->Settings.State );
+    switch( obj->Settings.State )
     {
         case RF_RX_RUNNING:
-            switch( SX1276.Settings.Modem )
+            switch( obj->Settings.Modem )
             {
             case MODEM_FSK:
                 // FifoLevel interrupt
                 // Read received packet size
-                if( ( SX1276.Settings.FskPacketHandler.Size == 0 ) && ( SX1276.Settings.FskPacketHandler.NbBytes == 0 ) )
+                if( ( obj->Settings.FskPacketHandler.Size == 0 ) && ( obj->Settings.FskPacketHandler.NbBytes == 0 ) )
                 {
-                    if( SX1276.Settings.Fsk.FixLen == false )
+                    if( obj->Settings.Fsk.FixLen == false )
                     {
-                        SX1276ReadFifo( ( uint8_t* )&SX1276.Settings.FskPacketHandler.Size, 1 );
+                        SX1276ReadFifo( obj, ( uint8_t* )&obj->Settings.FskPacketHandler.Size, 1 );
                     }
                     else
                     {
-                        SX1276.Settings.FskPacketHandler.Size = SX1276Read( REG_PAYLOADLENGTH );
+                        obj->Settings.FskPacketHandler.Size = SX1276Read( obj, REG_PAYLOADLENGTH );
                     }
                 }
 
-                if( ( SX1276.Settings.FskPacketHandler.Size - SX1276.Settings.FskPacketHandler.NbBytes ) > SX1276.Settings.FskPacketHandler.FifoThresh )
+                if( ( obj->Settings.FskPacketHandler.Size - obj->Settings.FskPacketHandler.NbBytes ) > obj->Settings.FskPacketHandler.FifoThresh )
                 {
-                    SX1276ReadFifo( ( RxTxBuffer + SX1276.Settings.FskPacketHandler.NbBytes ), SX1276.Settings.FskPacketHandler.FifoThresh );
-                    SX1276.Settings.FskPacketHandler.NbBytes += SX1276.Settings.FskPacketHandler.FifoThresh;
+                    SX1276ReadFifo( obj, ( obj->RxTxBuffer + obj->Settings.FskPacketHandler.NbBytes ), obj->Settings.FskPacketHandler.FifoThresh );
+                    obj->Settings.FskPacketHandler.NbBytes += obj->Settings.FskPacketHandler.FifoThresh;
                 }
                 else
                 {
-                    SX1276ReadFifo( ( RxTxBuffer + SX1276.Settings.FskPacketHandler.NbBytes ), SX1276.Settings.FskPacketHandler.Size - SX1276.Settings.FskPacketHandler.NbBytes );
-                    SX1276.Settings.FskPacketHandler.NbBytes += ( SX1276.Settings.FskPacketHandler.Size - SX1276.Settings.FskPacketHandler.NbBytes );
+                    SX1276ReadFifo( obj, ( obj->RxTxBuffer + obj->Settings.FskPacketHandler.NbBytes ), obj->Settings.FskPacketHandler.Size - obj->Settings.FskPacketHandler.NbBytes );
+                    obj->Settings.FskPacketHandler.NbBytes += ( obj->Settings.FskPacketHandler.Size - obj->Settings.FskPacketHandler.NbBytes );
                 }
                 break;
             case MODEM_LORA:
                 // Sync time out
-                TimerStop( &RxTimeoutTimer );
+                TimerStop( &obj->RxTimeoutTimer );
                 // Clear Irq
-                SX1276Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_RXTIMEOUT );
+                SX1276Write( obj, REG_LR_IRQFLAGS, RFLR_IRQFLAGS_RXTIMEOUT );
 
-                SX1276.Settings.State = RF_IDLE;
-                if( ( RadioEvents != NULL ) && ( RadioEvents->RxTimeout != NULL ) )
+                obj->Settings.State = RF_IDLE;
+                if( ( obj->Events != NULL ) && ( obj->Events->RxTimeout != NULL ) )
                 {
                 	DIO_PRINTF("DIO1:RX Timeout\r\n");
-                    RadioEvents->RxTimeout( );
+                    obj->Events->RxTimeout( );
                 }
                 break;
             default:
@@ -1655,20 +1825,20 @@ void SX1276OnDio1Irq( void )
             }
             break;
         case RF_TX_RUNNING:
-            switch( SX1276.Settings.Modem )
+            switch( obj->Settings.Modem )
             {
             case MODEM_FSK:
                 // FifoEmpty interrupt
-                if( ( SX1276.Settings.FskPacketHandler.Size - SX1276.Settings.FskPacketHandler.NbBytes ) > SX1276.Settings.FskPacketHandler.ChunkSize )
+                if( ( obj->Settings.FskPacketHandler.Size - obj->Settings.FskPacketHandler.NbBytes ) > obj->Settings.FskPacketHandler.ChunkSize )
                 {
-                    SX1276WriteFifo( ( RxTxBuffer + SX1276.Settings.FskPacketHandler.NbBytes ), SX1276.Settings.FskPacketHandler.ChunkSize );
-                    SX1276.Settings.FskPacketHandler.NbBytes += SX1276.Settings.FskPacketHandler.ChunkSize;
+                    SX1276WriteFifo( obj, ( obj->RxTxBuffer + obj->Settings.FskPacketHandler.NbBytes ), obj->Settings.FskPacketHandler.ChunkSize );
+                    obj->Settings.FskPacketHandler.NbBytes += obj->Settings.FskPacketHandler.ChunkSize;
                 }
                 else
                 {
                     // Write the last chunk of data
-                    SX1276WriteFifo( RxTxBuffer + SX1276.Settings.FskPacketHandler.NbBytes, SX1276.Settings.FskPacketHandler.Size - SX1276.Settings.FskPacketHandler.NbBytes );
-                    SX1276.Settings.FskPacketHandler.NbBytes += SX1276.Settings.FskPacketHandler.Size - SX1276.Settings.FskPacketHandler.NbBytes;
+                    SX1276WriteFifo( obj, obj->RxTxBuffer + obj->Settings.FskPacketHandler.NbBytes, obj->Settings.FskPacketHandler.Size - obj->Settings.FskPacketHandler.NbBytes );
+                    obj->Settings.FskPacketHandler.NbBytes += obj->Settings.FskPacketHandler.Size - obj->Settings.FskPacketHandler.NbBytes;
                 }
                 break;
             case MODEM_LORA:
@@ -1682,43 +1852,43 @@ void SX1276OnDio1Irq( void )
     }
 }
 
-void SX1276OnDio2Irq( void )
+void SX1276OnDio2Irq( SX1276_t *obj )
 {
-    switch( SX1276.Settings.State )
+    switch( obj->Settings.State )
     {
         case RF_RX_RUNNING:
-            switch( SX1276.Settings.Modem )
+            switch( obj->Settings.Modem )
             {
             case MODEM_FSK:
                 // Checks if DIO4 is connected. If it is not PreambleDetected is set to true.
-                if( SX1276.DIO4.port == NULL )
+                if( obj->DIO4.port == NULL )
                 {
-                    SX1276.Settings.FskPacketHandler.PreambleDetected = true;
+                    obj->Settings.FskPacketHandler.PreambleDetected = true;
                 }
 
-                if( ( SX1276.Settings.FskPacketHandler.PreambleDetected == true ) && ( SX1276.Settings.FskPacketHandler.SyncWordDetected == false ) )
+                if( ( obj->Settings.FskPacketHandler.PreambleDetected == true ) && ( obj->Settings.FskPacketHandler.SyncWordDetected == false ) )
                 {
-                    TimerStop( &RxTimeoutSyncWord );
+                    TimerStop( &obj->RxTimeoutSyncWord );
 
-                    SX1276.Settings.FskPacketHandler.SyncWordDetected = true;
+                    obj->Settings.FskPacketHandler.SyncWordDetected = true;
 
-                    SX1276.Settings.FskPacketHandler.RssiValue = -( SX1276Read( REG_RSSIVALUE ) >> 1 );
+                    obj->Settings.FskPacketHandler.RssiValue = -( SX1276Read( obj, REG_RSSIVALUE ) >> 1 );
 
-                    SX1276.Settings.FskPacketHandler.AfcValue = ( int32_t )( double )( ( ( uint16_t )SX1276Read( REG_AFCMSB ) << 8 ) |
-                                                                           ( uint16_t )SX1276Read( REG_AFCLSB ) ) *
+                    obj->Settings.FskPacketHandler.AfcValue = ( int32_t )( double )( ( ( uint16_t )SX1276Read( obj, REG_AFCMSB ) << 8 ) |
+                                                                           ( uint16_t )SX1276Read( obj, REG_AFCLSB ) ) *
                                                                            ( double )FREQ_STEP;
-                    SX1276.Settings.FskPacketHandler.RxGain = ( SX1276Read( REG_LNA ) >> 5 ) & 0x07;
+                    obj->Settings.FskPacketHandler.RxGain = ( SX1276Read( obj, REG_LNA ) >> 5 ) & 0x07;
                 }
                 break;
             case MODEM_LORA:
-                if( SX1276.Settings.LoRa.FreqHopOn == true )
+                if( obj->Settings.LoRa.FreqHopOn == true )
                 {
                     // Clear Irq
-                    SX1276Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_FHSSCHANGEDCHANNEL );
+                    SX1276Write( obj, REG_LR_IRQFLAGS, RFLR_IRQFLAGS_FHSSCHANGEDCHANNEL );
 
-                    if( ( RadioEvents != NULL ) && ( RadioEvents->FhssChangeChannel != NULL ) )
+                    if( ( obj->Events != NULL ) && ( obj->Events->FhssChangeChannel != NULL ) )
                     {
-                        RadioEvents->FhssChangeChannel( ( SX1276Read( REG_LR_HOPCHANNEL ) & RFLR_HOPCHANNEL_CHANNEL_MASK ) );
+                        obj->Events->FhssChangeChannel( ( SX1276Read( obj, REG_LR_HOPCHANNEL ) & RFLR_HOPCHANNEL_CHANNEL_MASK ) );
                     }
                 }
                 break;
@@ -1727,19 +1897,19 @@ void SX1276OnDio2Irq( void )
             }
             break;
         case RF_TX_RUNNING:
-            switch( SX1276.Settings.Modem )
+            switch( obj->Settings.Modem )
             {
             case MODEM_FSK:
                 break;
             case MODEM_LORA:
-                if( SX1276.Settings.LoRa.FreqHopOn == true )
+                if( obj->Settings.LoRa.FreqHopOn == true )
                 {
                     // Clear Irq
-                    SX1276Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_FHSSCHANGEDCHANNEL );
+                    SX1276Write( obj, REG_LR_IRQFLAGS, RFLR_IRQFLAGS_FHSSCHANGEDCHANNEL );
 
-                    if( ( RadioEvents != NULL ) && ( RadioEvents->FhssChangeChannel != NULL ) )
+                    if( ( obj->Events != NULL ) && ( obj->Events->FhssChangeChannel != NULL ) )
                     {
-                        RadioEvents->FhssChangeChannel( ( SX1276Read( REG_LR_HOPCHANNEL ) & RFLR_HOPCHANNEL_CHANNEL_MASK ) );
+                        obj->Events->FhssChangeChannel( ( SX1276Read( obj, REG_LR_HOPCHANNEL ) & RFLR_HOPCHANNEL_CHANNEL_MASK ) );
                     }
                 }
                 break;
@@ -1752,29 +1922,36 @@ void SX1276OnDio2Irq( void )
     }
 }
 
-void SX1276OnDio3Irq( void )
+void SX1276OnDio3Irq( SX1276_t *obj )
 {
-    switch( SX1276.Settings.Modem )
+    TRACE( TRACE_EVENT_IRQ, 3, obj->Settings.State );
+    switch( obj->Settings.Modem )
     {
     case MODEM_FSK:
         break;
     case MODEM_LORA:
-        if( ( SX1276Read( REG_LR_IRQFLAGS ) & RFLR_IRQFLAGS_CADDETECTED ) == RFLR_IRQFLAGS_CADDETECTED )
+        if( obj->Settings.State != RF_CAD )
+        {
+            // Already handled through DIO0
+            break;
+        }
+        obj->Settings.State = RF_IDLE;
+        if( ( SX1276Read( obj, REG_LR_IRQFLAGS ) & RFLR_IRQFLAGS_CADDETECTED ) == RFLR_IRQFLAGS_CADDETECTED )
         {
             // Clear Irq
-            SX1276Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_CADDETECTED | RFLR_IRQFLAGS_CADDONE );
-            if( ( RadioEvents != NULL ) && ( RadioEvents->CadDone != NULL ) )
+            SX1276Write( obj, REG_LR_IRQFLAGS, RFLR_IRQFLAGS_CADDETECTED | RFLR_IRQFLAGS_CADDONE );
+            if( ( obj->Events != NULL ) && ( obj->Events->CadDone != NULL ) )
             {
-                RadioEvents->CadDone( true );
+                obj->Events->CadDone( true );
             }
         }
         else
         {
             // Clear Irq
-            SX1276Write( REG_LR_IRQFLAGS, RFLR_IRQFLAGS_CADDONE );
-            if( ( RadioEvents != NULL ) && ( RadioEvents->CadDone != NULL ) )
+            SX1276Write( obj, REG_LR_IRQFLAGS, RFLR_IRQFLAGS_CADDONE );
+            if( ( obj->Events != NULL ) && ( obj->Events->CadDone != NULL ) )
             {
-                RadioEvents->CadDone( false );
+                obj->Events->CadDone( false );
             }
         }
         break;
@@ -1783,15 +1960,15 @@ void SX1276OnDio3Irq( void )
     }
 }
 
-void SX1276OnDio4Irq( void )
+void SX1276OnDio4Irq( SX1276_t *obj )
 {
-    switch( SX1276.Settings.Modem )
+    switch( obj->Settings.Modem )
     {
     case MODEM_FSK:
         {
-            if( SX1276.Settings.FskPacketHandler.PreambleDetected == false )
+            if( obj->Settings.FskPacketHandler.PreambleDetected == false )
             {
-                SX1276.Settings.FskPacketHandler.PreambleDetected = true;
+                obj->Settings.FskPacketHandler.PreambleDetected = true;
             }
         }
         break;
@@ -1802,9 +1979,9 @@ void SX1276OnDio4Irq( void )
     }
 }
 
-void SX1276OnDio5Irq( void )
+void SX1276OnDio5Irq( SX1276_t *obj )
 {
-    switch( SX1276.Settings.Modem )
+    switch( obj->Settings.Modem )
     {
     case MODEM_FSK:
         break;
@@ -1815,6 +1992,20 @@ void SX1276OnDio5Irq( void )
     }
 }
 
+void SX1276IrqProcess( SX1276_t *obj )
+{
+    if( obj->Dio0Fired == true )
+    {
+        obj->Dio0Fired = false;
+        SX1276OnDio0Irq( obj );
+    }
+    if( obj->Dio1Fired == true )
+    {
+        obj->Dio1Fired = false;
+        SX1276OnDio1Irq( obj );
+    }
+}
+
 extern bool Irq0Fired;
 extern bool Irq1Fired;
 
@@ -1822,14 +2013,17 @@ void  RadioIrqProcess(void)
 {
 	if(Irq0Fired)
 	{
+		// The DIO0 IRQ of Mcu.S only flags the edge, the time is taken at
+		// its first sight
 		Irq0Fired = false;
-		SX1276OnDio0Irq();
+		SX1276.Dio0Time = micros( );
+		SX1276.Dio0Fired = true;
 	}
 	if(Irq1Fired)
 	{
 		Irq1Fired = false;
-		SX1276OnDio1Irq();
+		SX1276.Dio1Fired = true;
 	}
-
+	SX1276IrqProcess( &SX1276 );
 }
-
+#endif
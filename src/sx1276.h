@@ -29,9 +29,14 @@
 #include "gpio.h"
 #include "lorawan_spi.h"
 #include "radio.h"
+#include "timer.h"
 #include "sx1276Regs-Fsk.h"
 #include "sx1276Regs-LoRa.h"
 
+#ifdef __cplusplus
+extern "C"{
+#endif
+
 /*!
  * Radio wake-up time from sleep
  */
@@ -129,10 +134,51 @@ typedef struct
     RadioLoRaPacketHandler_t LoRaPacketHandler;
 }RadioSettings_t;
 
+/*!
+ * SX1276 definitions
+ */
+#define XTAL_FREQ                                   32000000
+#define FREQ_STEP                                   61.03515625
+
+#define RX_BUFFER_SIZE                              256
+
+/*!
+ * Maximum number of radios driven at the same time, the default one included
+ */
+#define SX1276_MAX_INSTANCES                        2
+
+typedef struct SX1276_s SX1276_t;
+
+/*!
+ * Register access of a radio. The default radio uses the SPI bus and chip
+ * select given to Mcu.init, additional radios provide their own.
+ */
+typedef struct sSX1276Bus
+{
+    /*!
+     * \brief Writes consecutive registers
+     *
+     * \param [IN] obj    Radio object
+     * \param [IN] addr   First register address, without the write bit
+     * \param [IN] buffer Values to write
+     * \param [IN] size   Number of registers
+     */
+    void ( *Write )( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size );
+    /*!
+     * \brief Reads consecutive registers
+     *
+     * \param [IN]  obj    Radio object
+     * \param [IN]  addr   First register address
+     * \param [OUT] buffer Read values
+     * \param [IN]  size   Number of registers
+     */
+    void ( *Read )( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size );
+}SX1276Bus_t;
+
 /*!
  * Radio hardware and global parameters
  */
-typedef struct SX1276_s
+struct SX1276_s
 {
     Gpio_t        Reset;
     Gpio_t        DIO0;
@@ -143,21 +189,40 @@ typedef struct SX1276_s
     Gpio_t        DIO5;
     Spi_t         Spi;
     RadioSettings_t Settings;
-}SX1276_t;
+    /*!
+     * Register access, NULL for the bus set up by Mcu.init
+     */
+    const SX1276Bus_t *Bus;
+    /*!
+     * Radio callbacks
+     */
+    RadioEvents_t *Events;
+    /*!
+     * Tx and Rx timers
+     */
+    TimerEvent_t  TxTimeoutTimer;
+    TimerEvent_t  RxTimeoutTimer;
+    TimerEvent_t  RxTimeoutSyncWord;
+    /*!
+     * DIO interrupts waiting for \ref SX1276IrqProcess
+     */
+    volatile bool Dio0Fired;
+    volatile bool Dio1Fired;
+    /*!
+     * micros( ) at the last DIO0 IRQ, TxDone and RxDone of both modems
+     */
+    volatile uint32_t Dio0Time;
+    /*!
+     * Reception and transmission buffer
+     */
+    uint8_t       RxTxBuffer[RX_BUFFER_SIZE];
+};
 
 /*!
  * Hardware IO IRQ callback function definition
  */
 typedef void ( DioIrqHandler )( void );
 
-/*!
- * SX1276 definitions
- */
-#define XTAL_FREQ                                   32000000
-#define FREQ_STEP                                   61.03515625
-
-#define RX_BUFFER_SIZE                              256
-
 /*!
  * ============================================================================
  * Public functions prototypes
@@ -167,34 +232,39 @@ typedef void ( DioIrqHandler )( void );
 /*!
  * \brief Initializes the radio
  *
+ * \param [IN] obj Radio object
  * \param [IN] events Structure containing the driver callback functions
  */
-void SX1276Init( RadioEvents_t *events );
+void SX1276Init( SX1276_t *obj, RadioEvents_t *events );
 
 /*!
  * Return current radio status
  *
+ * \param [IN] obj Radio object
  * \param status Radio status.[RF_IDLE, RF_RX_RUNNING, RF_TX_RUNNING]
  */
-RadioState_t SX1276GetStatus( void );
+RadioState_t SX1276GetStatus( SX1276_t *obj );
 
 /*!
  * \brief Configures the radio with the given modem
  *
+ * \param [IN] obj Radio object
  * \param [IN] modem Modem to be used [0: FSK, 1: LoRa]
  */
-void SX1276SetModem( RadioModems_t modem );
+void SX1276SetModem( SX1276_t *obj, RadioModems_t modem );
 
 /*!
  * \brief Sets the channel configuration
  *
+ * \param [IN] obj Radio object
  * \param [IN] freq         Channel RF frequency
  */
-void SX1276SetChannel( uint32_t freq );
+void SX1276SetChannel( SX1276_t *obj, uint32_t freq );
 
 /*!
  * \brief Checks if the channel is free for the given time
  *
+ * \param [IN] obj Radio object
  * \param [IN] modem      Radio modem to be used [0: FSK, 1: LoRa]
  * \param [IN] freq       Channel RF frequency
  * \param [IN] rssiThresh RSSI threshold
@@ -202,7 +272,17 @@ void SX1276SetChannel( uint32_t freq );
  *
  * \retval isFree         [true: Channel is free, false: Channel is not free]
  */
-bool SX1276IsChannelFree( RadioModems_t modem, uint32_t freq, int16_t rssiThresh, uint32_t maxCarrierSenseTime );
+bool SX1276IsChannelFree( SX1276_t *obj, RadioModems_t modem, uint32_t freq, int16_t rssiThresh, uint32_t maxCarrierSenseTime );
+
+/*!
+ * \brief Starts the receiver on the given channel for RSSI measurements.
+ *        The interrupts are masked, nothing is received.
+ *
+ * \param [IN] obj Radio object
+ * \param [IN] modem      Radio modem to be used [0: FSK, 1: LoRa]
+ * \param [IN] freq       Channel RF frequency
+ */
+void SX1276StartCarrierSense( SX1276_t *obj, RadioModems_t modem, uint32_t freq );
 
 /*!
  * \brief Generates a 32 bits random value based on the RSSI readings
@@ -212,15 +292,17 @@ bool SX1276IsChannelFree( RadioModems_t modem, uint32_t freq, int16_t rssiThresh
  *         After calling this function either SX1276SetRxConfig or
  *         SX1276SetTxConfig functions must be called.
  *
+ * \param [IN] obj Radio object
  * \retval randomValue    32 bits random value
  */
-uint32_t SX1276Random( void );
+uint32_t SX1276Random( SX1276_t *obj );
 
 /*!
  * \brief Sets the reception parameters
  *
  * \remark When using LoRa modem only bandwidths 125, 250 and 500 kHz are supported
  *
+ * \param [IN] obj Radio object
  * \param [IN] modem        Radio modem to be used [0: FSK, 1: LoRa]
  * \param [IN] bandwidth    Sets the bandwidth
  *                          FSK : >= 2600 and <= 250000 Hz
@@ -257,7 +339,7 @@ uint32_t SX1276Random( void );
  * \param [IN] rxContinuous Sets the reception in continuous mode
  *                          [false: single mode, true: continuous mode]
  */
-void SX1276SetRxConfig( RadioModems_t modem, uint32_t bandwidth,
+void SX1276SetRxConfig( SX1276_t *obj, RadioModems_t modem, uint32_t bandwidth,
                          uint32_t datarate, uint8_t coderate,
                          uint32_t bandwidthAfc, uint16_t preambleLen,
                          uint16_t symbTimeout, bool fixLen,
@@ -270,6 +352,7 @@ void SX1276SetRxConfig( RadioModems_t modem, uint32_t bandwidth,
  *
  * \remark When using LoRa modem only bandwidths 125, 250 and 500 kHz are supported
  *
+ * \param [IN] obj Radio object
  * \param [IN] modem        Radio modem to be used [0: FSK, 1: LoRa]
  * \param [IN] power        Sets the output power [dBm]
  * \param [IN] fdev         Sets the frequency deviation (FSK only)
@@ -302,7 +385,7 @@ void SX1276SetRxConfig( RadioModems_t modem, uint32_t bandwidth,
  *                          LoRa: [0: not inverted, 1: inverted]
  * \param [IN] timeout      Transmission timeout [ms]
  */
-void SX1276SetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
+void SX1276SetTxConfig( SX1276_t *obj, RadioModems_t modem, int8_t power, uint32_t fdev,
                         uint32_t bandwidth, uint32_t datarate,
                         uint8_t coderate, uint16_t preambleLen,
                         bool fixLen, bool crcOn, bool freqHopOn,
@@ -313,109 +396,126 @@ void SX1276SetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
  *
  * \Remark Can only be called once SetRxConfig or SetTxConfig have been called
  *
+ * \param [IN] obj Radio object
  * \param [IN] modem      Radio modem to be used [0: FSK, 1: LoRa]
  * \param [IN] pktLen     Packet payload length
  *
  * \retval airTime        Computed airTime (ms) for the given packet payload length
  */
-uint32_t SX1276GetTimeOnAir( RadioModems_t modem, uint8_t pktLen );
+uint32_t SX1276GetTimeOnAir( SX1276_t *obj, RadioModems_t modem, uint8_t pktLen );
 
 /*!
  * \brief Sends the buffer of size. Prepares the packet to be sent and sets
  *        the radio in transmission
  *
+ * \param [IN] obj Radio object
  * \param [IN]: buffer     Buffer pointer
  * \param [IN]: size       Buffer size
  */
-void SX1276Send( uint8_t *buffer, uint8_t size );
+void SX1276Send( SX1276_t *obj, uint8_t *buffer, uint8_t size );
 
 /*!
  * \brief Sets the radio in sleep mode
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276SetSleep( void );
+void SX1276SetSleep( SX1276_t *obj );
 
 /*!
  * \brief Sets the radio in standby mode
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276SetStby( void );
+void SX1276SetStby( SX1276_t *obj );
 
 /*!
  * \brief Sets the radio in reception mode for the given time
+ * \param [IN] obj Radio object
  * \param [IN] timeout Reception timeout [ms] [0: continuous, others timeout]
  */
-void SX1276SetRx( uint32_t timeout );
+void SX1276SetRx( SX1276_t *obj, uint32_t timeout );
 
 /*!
  * \brief Start a Channel Activity Detection
+ *
+ * \param [IN] obj Radio object
  */
-void SX1276StartCad( void );
+void SX1276StartCad( SX1276_t *obj );
 
 /*!
  * \brief Sets the radio in continuous wave transmission mode
  *
+ * \param [IN] obj Radio object
  * \param [IN]: freq       Channel RF frequency
  * \param [IN]: power      Sets the output power [dBm]
  * \param [IN]: time       Transmission mode timeout [s]
  */
-void SX1276SetTxContinuousWave( uint32_t freq, int8_t power, uint16_t time );
+void SX1276SetTxContinuousWave( SX1276_t *obj, uint32_t freq, int8_t power, uint16_t time );
 
 /*!
  * \brief Reads the current RSSI value
  *
+ * \param [IN] obj Radio object
  * \retval rssiValue Current RSSI value in [dBm]
  */
-int16_t SX1276ReadRssi( RadioModems_t modem );
+int16_t SX1276ReadRssi( SX1276_t *obj, RadioModems_t modem );
 
 /*!
  * \brief Writes the radio register at the specified address
  *
+ * \param [IN] obj Radio object
  * \param [IN]: addr Register address
  * \param [IN]: data New register value
  */
-void SX1276Write( uint16_t addr, uint8_t data );
+void SX1276Write( SX1276_t *obj, uint16_t addr, uint8_t data );
 
 /*!
  * \brief Reads the radio register at the specified address
  *
+ * \param [IN] obj Radio object
  * \param [IN]: addr Register address
  * \retval data Register value
  */
-uint8_t SX1276Read( uint16_t addr );
+uint8_t SX1276Read( SX1276_t *obj, uint16_t addr );
 
 /*!
  * \brief Writes multiple radio registers starting at address
  *
+ * \param [IN] obj Radio object
  * \param [IN] addr   First Radio register address
  * \param [IN] buffer Buffer containing the new register's values
  * \param [IN] size   Number of registers to be written
  */
-void SX1276WriteBuffer( uint16_t addr, uint8_t *buffer, uint8_t size );
+void SX1276WriteBuffer( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size );
 
 /*!
  * \brief Reads multiple radio registers starting at address
  *
+ * \param [IN] obj Radio object
  * \param [IN] addr First Radio register address
  * \param [OUT] buffer Buffer where to copy the registers data
  * \param [IN] size Number of registers to be read
  */
-void SX1276ReadBuffer( uint16_t addr, uint8_t *buffer, uint8_t size );
+void SX1276ReadBuffer( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size );
 
 /*!
  * \brief Sets the maximum payload length.
  *
+ * \param [IN] obj Radio object
  * \param [IN] modem      Radio modem to be used [0: FSK, 1: LoRa]
  * \param [IN] max        Maximum payload length in bytes
  */
-void SX1276SetMaxPayloadLength( RadioModems_t modem, uint8_t max );
+void SX1276SetMaxPayloadLength( SX1276_t *obj, RadioModems_t modem, uint8_t max );
 
 /*!
  * \brief Sets the network to public or private. Updates the sync byte.
  *
  * \remark Applies to LoRa modem only
  *
+ * \param [IN] obj Radio object
  * \param [IN] enable if true, it enables a public network
  */
-void SX1276SetPublicNetwork( bool enable );
+void SX1276SetPublicNetwork( SX1276_t *obj, bool enable );
 
 /*!
  * \brief Gets the time required for the board plus radio to get out of sleep.[ms]
@@ -424,6 +524,44 @@ void SX1276SetPublicNetwork( bool enable );
  */
 uint32_t SX1276GetWakeupTime( void );
 
+/*!
+ * \brief Returns the time of the last DIO0 IRQ, the end of the last
+ *        transmission or reception
+ *
+ * \param [IN] obj Radio object
+ *
+ * \retval time micros( ) at the IRQ [us]
+ */
+uint32_t SX1276GetDio0Time( SX1276_t *obj );
+
+/*!
+ * \brief Sets up an additional radio. The default radio, \ref SX1276, uses
+ *        the pins given to Mcu.init and is always available.
+ *
+ * \remark Call \ref SX1276Init afterwards, and \ref SX1276IrqProcess from
+ *         the main loop
+ *
+ * \param [IN] obj   Radio object
+ * \param [IN] bus   Register access of the radio
+ * \param [IN] reset Reset pin
+ * \param [IN] dio0  DIO0 pin
+ * \param [IN] dio1  DIO1 pin
+ * \retval status [true: ok, false: SX1276_MAX_INSTANCES radios already in use]
+ */
+bool SX1276AddInstance( SX1276_t *obj, const SX1276Bus_t *bus, uint8_t reset, uint8_t dio0, uint8_t dio1 );
+
+/*!
+ * \brief Processes the DIO interrupts of a radio outside of the interrupt
+ *        context. The radio events are called from here.
+ *
+ * \param [IN] obj Radio object
+ */
+void SX1276IrqProcess( SX1276_t *obj );
+
 void  RadioIrqProcess(void);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // __SX1276_H__
@@ -0,0 +1,104 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Network time service, GPS time and its accuracy
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <math.h>
+#include "utilities.h"
+#include "LoRaMac.h"
+#include "rtc-drift.h"
+#include "systime.h"
+
+/*!
+ * Share of a new drift measurement in its mean
+ */
+#define SYSTIME_DRIFT_GAIN                          0.5f
+
+/*!
+ * Status, kept in RTC memory as the system time survives deep sleep. The mean
+ * drift starts from the default bound.
+ */
+RTC_DATA_ATTR static SysTimeStatus_t SysTime = { .MeanDrift = SYSTIME_DEFAULT_DRIFT / 2, .DriftBound = SYSTIME_DEFAULT_DRIFT };
+
+/*!
+ * Local time set by the last network time
+ */
+RTC_DATA_ATTR static struct timeval SyncTime;
+
+static int64_t GetMs( struct timeval time )
+{
+    return ( int64_t )time.tv_sec * 1000 + time.tv_usec / 1000;
+}
+
+void SysTimeSync( struct timeval gpsTime, struct timeval txDoneTime )
+{
+    struct timeval now;
+    struct timeval sysTime;
+    int64_t error;
+    int64_t elapsed;
+    float drift;
+
+    // The network time is the one of the end of the uplink, move it to now
+    gettimeofday( &now, NULL );
+    gpsTime.tv_sec += UNIX_GPS_EPOCH_OFFSET;
+    sysTime = add_timeval( now, sub_timeval( gpsTime, txDoneTime ) );
+    error = GetMs( sub_timeval( sysTime, now ) );
+
+    if( SysTime.Syncs > 0 )
+    {
+        elapsed = GetMs( sub_timeval( now, SyncTime ) );
+        if( elapsed >= SYSTIME_MIN_DRIFT_INTERVAL )
+        {
+            drift = ( ( float )error * 1e6f ) / ( float )elapsed;
+            if( fabsf( drift ) <= SYSTIME_MAX_DRIFT )
+            {
+                // The bound covers twice the mean drift left by the slow
+                // clock model
+                SysTime.Drift = drift;
+                SysTime.MeanDrift += SYSTIME_DRIFT_GAIN * ( fabsf( drift ) - SysTime.MeanDrift );
+                SysTime.DriftBound = MAX( ( uint32_t )ceilf( 2.0f * SysTime.MeanDrift ), SYSTIME_MIN_DRIFT );
+            }
+        }
+    }
+
+    SysTime.Syncs++;
+    SysTime.SyncError = ( int32_t )MAX( MIN( error, INT32_MAX ), INT32_MIN );
+
+    // The error builds up in sleep, where the slow clock keeps the time
+    RtcDriftSync( SysTime.SyncError );
+
+    settimeofday( &sysTime, NULL );
+    SyncTime = sysTime;
+}
+
+bool SysTimeGetGps( SysTimeGps_t *time )
+{
+    struct timeval now;
+    int64_t elapsed;
+
+    if( SysTime.Syncs == 0 )
+    {
+        return false;
+    }
+    gettimeofday( &now, NULL );
+    elapsed = MAX( GetMs( sub_timeval( now, SyncTime ) ), 0 );
+
+    time->Seconds = ( uint32_t )( now.tv_sec - UNIX_GPS_EPOCH_OFFSET );
+    time->SubSeconds = ( uint16_t )( now.tv_usec / 1000 );
+    time->Accuracy = SYSTIME_SYNC_ACCURACY + ( uint32_t )( ( elapsed * SysTime.DriftBound + 999999 ) / 1000000 );
+    return true;
+}
+
+void SysTimeGetStatus( SysTimeStatus_t *status )
+{
+    *status = SysTime;
+}
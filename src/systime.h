@@ -0,0 +1,121 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Network time service, GPS time and its accuracy
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __SYSTIME_H__
+#define __SYSTIME_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Accuracy of the time right after a network time [ms]: the DeviceTimeAns
+ * fractional second is 1/256 s, and the end of the uplink is known within
+ * 1 ms
+ */
+#define SYSTIME_SYNC_ACCURACY                       3
+
+/*!
+ * Drift bound of the local time before two network times measured it, and
+ * the one it never goes under [ppm]
+ */
+#define SYSTIME_DEFAULT_DRIFT                       500
+#define SYSTIME_MIN_DRIFT                           20
+
+/*!
+ * Time between two network times below which the drift is not measured [ms]
+ */
+#define SYSTIME_MIN_DRIFT_INTERVAL                  300000
+
+/*!
+ * Drift between two network times above which the local time is taken as
+ * reset rather than drifting [ppm]
+ */
+#define SYSTIME_MAX_DRIFT                           1000
+
+/*!
+ * GPS time, seconds since 00:00:00, Sunday 6th of January 1980
+ */
+typedef struct sSysTimeGps
+{
+    uint32_t Seconds;
+    /*!
+     * Milliseconds in the second
+     */
+    uint16_t SubSeconds;
+    /*!
+     * Bound of the error of the time [ms]
+     */
+    uint32_t Accuracy;
+}SysTimeGps_t;
+
+/*!
+ * Network time status
+ */
+typedef struct sSysTimeStatus
+{
+    /*!
+     * Network times received
+     */
+    uint32_t Syncs;
+    /*!
+     * Error of the local time found by the last network time, positive when
+     * the local time was late [ms]
+     */
+    int32_t SyncError;
+    /*!
+     * Drift measured between the last two network times, and mean of its
+     * magnitude [ppm]
+     */
+    float Drift;
+    float MeanDrift;
+    /*!
+     * Drift bound used for the accuracy [ppm]
+     */
+    uint32_t DriftBound;
+}SysTimeStatus_t;
+
+/*!
+ * \brief Sets the local time from a network time
+ *
+ * \param [IN] gpsTime    Network GPS time at the end of the uplink
+ * \param [IN] txDoneTime Local time at the end of the uplink
+ */
+void SysTimeSync( struct timeval gpsTime, struct timeval txDoneTime );
+
+/*!
+ * \brief Returns the GPS time
+ *
+ * \param [OUT] time GPS time and its accuracy
+ *
+ * \retval [false: no network time yet, true: time valid]
+ */
+bool SysTimeGetGps( SysTimeGps_t *time );
+
+/*!
+ * \brief Returns the network time status
+ *
+ * \param [OUT] status Copy of the status
+ */
+void SysTimeGetStatus( SysTimeStatus_t *status );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __SYSTIME_H__
@@ -31,6 +31,9 @@ typedef struct TimerEvent_s
     bool IsRunning;             //! Is the timer currently running
     void ( *Callback )( void ); //! Timer IRQ callback function
     struct TimerEvent_s *Next;  //! Pointer to the next Timer object.
+#ifdef TIMER_EVENT_CONTEXT
+    void *Context;              //! Context of the callback, see TimerSetContext
+#endif
 }TimerEvent_t;
 
 /*!
@@ -108,6 +111,24 @@ TimerTime_t TimerGetFutureTime( TimerTime_t eventInFuture );
  * \brief Manages the entry into ARM cortex deep-sleep mode
  */
 void TimerLowPowerHandler( void );
+
+#ifdef TIMER_EVENT_CONTEXT
+/*!
+ * \brief Sets the context the timer callback runs with. Timers without one
+ *        run with NULL. Only the host timer list carries it, timer.S does not.
+ *
+ * \param [IN] obj     Structure containing the timer object parameters
+ * \param [IN] context Context returned by TimerGetContext in the callback
+ */
+void TimerSetContext( TimerEvent_t *obj, void *context );
+
+/*!
+ * \brief Returns the context of the timer whose callback is running
+ *
+ * \retval context Context set by TimerSetContext, NULL out of a callback
+ */
+void *TimerGetContext( void );
+#endif
 void IRAM_ATTR TimerIrqHandler( void );
 
 #ifdef __cplusplus
@@ -0,0 +1,111 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Binary trace buffer of timestamped MAC and radio events
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include "Arduino.h"
+#include "debug.h"
+#include "trace.h"
+
+#ifdef LORAWAN_TRACE
+
+/*!
+ * Trace records. The write index only ever increases, its low bits select
+ * the record so that concurrent writers never share a slot.
+ */
+static TraceRecord_t TraceBuffer[TRACE_BUFFER_SIZE];
+static uint32_t TraceHead = 0;
+static volatile bool TraceEnabled = true;
+
+static inline uint32_t IRAM_ATTR TraceGetCycles( void )
+{
+#if defined( __XTENSA__ )
+    uint32_t ccount;
+
+    __asm__ __volatile__( "rsr %0, ccount" : "=a"( ccount ) );
+    return ccount;
+#else
+    return micros( );
+#endif
+}
+
+void IRAM_ATTR TraceRecord( TraceEvent_t event, uint8_t arg0, uint32_t arg1 )
+{
+    TraceRecord_t *record;
+
+    if( TraceEnabled == false )
+    {
+        return;
+    }
+
+    record = &TraceBuffer[__atomic_fetch_add( &TraceHead, 1, __ATOMIC_RELAXED ) & ( TRACE_BUFFER_SIZE - 1 )];
+    record->Event = 0;
+    record->Cycles = TraceGetCycles( );
+    record->Arg0 = arg0;
+    record->Arg1 = arg1;
+    // Publish the record last, the dump skips records still being written
+    __atomic_store_n( &record->Event, ( uint8_t )event, __ATOMIC_RELEASE );
+}
+
+void TraceEnable( bool enable )
+{
+    TraceEnabled = enable;
+}
+
+void TraceDump( void )
+{
+    bool enabled = TraceEnabled;
+    uint32_t head;
+    uint32_t count;
+
+    TraceEnabled = false;
+
+    head = __atomic_load_n( &TraceHead, __ATOMIC_ACQUIRE );
+    count = MIN( head, TRACE_BUFFER_SIZE );
+
+#if defined( __XTENSA__ )
+    xprintf( "TRACE BEGIN %u %u\r\n", ( unsigned )getCpuFrequencyMhz( ), ( unsigned )count );
+#else
+    xprintf( "TRACE BEGIN 1 %u\r\n", ( unsigned )count );
+#endif
+    for( uint32_t i = head - count; i != head; i++ )
+    {
+        TraceRecord_t *record = &TraceBuffer[i & ( TRACE_BUFFER_SIZE - 1 )];
+
+        if( record->Event != 0 )
+        {
+            xprintf( "T %08x %02x %02x %08x\r\n", ( unsigned )record->Cycles, record->Event, record->Arg0, ( unsigned )record->Arg1 );
+            record->Event = 0;
+        }
+    }
+    xprintf( "TRACE END\r\n" );
+
+    __atomic_store_n( &TraceHead, 0, __ATOMIC_RELEASE );
+    TraceEnabled = enabled;
+}
+
+#else
+
+void TraceRecord( TraceEvent_t event, uint8_t arg0, uint32_t arg1 )
+{
+}
+
+void TraceEnable( bool enable )
+{
+}
+
+void TraceDump( void )
+{
+    xprintf( "TRACE DISABLED\r\n" );
+}
+
+#endif
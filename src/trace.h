@@ -0,0 +1,178 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Binary trace buffer of timestamped MAC and radio events
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Number of records kept in the trace buffer. Must be a power of 2.
+ */
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE                           256
+#endif
+
+/*!
+ * Trace event identifiers
+ */
+typedef enum eTraceEvent
+{
+    /*!
+     * Arg0: \ref TraceTimer_t, Arg1: timeout [ms]
+     */
+    TRACE_EVENT_TIMER_START = 1,
+    /*!
+     * Arg0: \ref TraceTimer_t
+     */
+    TRACE_EVENT_TIMER_FIRE,
+    /*!
+     * Arg0: new radio operating mode
+     */
+    TRACE_EVENT_OPMODE,
+    /*!
+     * Arg0: DIO number, Arg1: radio state
+     */
+    TRACE_EVENT_IRQ,
+    /*!
+     * Arg0: \ref TraceMacEvent_t, Arg1: LoRaMacState
+     */
+    TRACE_EVENT_MAC,
+    /*!
+     * Arg0: MAC command identifier, Arg1: MAC command index in the frame
+     */
+    TRACE_EVENT_MAC_CMD,
+    /*!
+     * Arg0: \ref TraceCrypto_t
+     */
+    TRACE_EVENT_CRYPTO_START,
+    /*!
+     * Arg0: \ref TraceCrypto_t
+     */
+    TRACE_EVENT_CRYPTO_END,
+    /*!
+     * Arg1: system time [ms]. The cycle counter stops while sleeping, the
+     * decoder uses these records to realign the time base.
+     */
+    TRACE_EVENT_SLEEP,
+    /*!
+     * Arg1: system time [ms]
+     */
+    TRACE_EVENT_WAKEUP,
+}TraceEvent_t;
+
+/*!
+ * Traced timers
+ */
+typedef enum eTraceTimer
+{
+    TRACE_TIMER_MAC_STATE_CHECK,
+    TRACE_TIMER_TX_DELAYED,
+    TRACE_TIMER_RX_WINDOW_1,
+    TRACE_TIMER_RX_WINDOW_2,
+    TRACE_TIMER_ACK_TIMEOUT,
+    TRACE_TIMER_RADIO_TX_TIMEOUT,
+    TRACE_TIMER_RADIO_RX_TIMEOUT,
+}TraceTimer_t;
+
+/*!
+ * Traced MAC events
+ */
+typedef enum eTraceMacEvent
+{
+    TRACE_MAC_SEND,
+    TRACE_MAC_TX_DONE,
+    TRACE_MAC_RX_DONE,
+    TRACE_MAC_TX_TIMEOUT,
+    TRACE_MAC_RX_ERROR,
+    TRACE_MAC_RX_TIMEOUT,
+    TRACE_MAC_IDLE,
+}TraceMacEvent_t;
+
+/*!
+ * Traced crypto operations
+ */
+typedef enum eTraceCrypto
+{
+    TRACE_CRYPTO_MIC,
+    TRACE_CRYPTO_PAYLOAD,
+    TRACE_CRYPTO_JOIN_MIC,
+    TRACE_CRYPTO_JOIN_DECRYPT,
+    TRACE_CRYPTO_SKEYS,
+}TraceCrypto_t;
+
+/*!
+ * Trace record, 12 bytes
+ */
+typedef struct sTraceRecord
+{
+    /*!
+     * CPU cycle counter at the time of the event
+     */
+    uint32_t Cycles;
+    /*!
+     * Event identifier, 0 for an unused record
+     */
+    uint8_t Event;
+    uint8_t Arg0;
+    uint16_t Reserved;
+    uint32_t Arg1;
+}TraceRecord_t;
+
+#ifdef LORAWAN_TRACE
+
+#define TRACE( event, arg0, arg1 )                  TraceRecord( event, arg0, arg1 )
+
+#else
+
+#define TRACE( event, arg0, arg1 )
+
+#endif
+
+/*!
+ * \brief Adds a record to the trace buffer. Safe to call from interrupts
+ *        and from both cores, the oldest records are overwritten.
+ *
+ * \param [IN] event Event identifier
+ * \param [IN] arg0  First event argument
+ * \param [IN] arg1  Second event argument
+ */
+void TraceRecord( TraceEvent_t event, uint8_t arg0, uint32_t arg1 );
+
+/*!
+ * \brief Enables or disables recording. Recording is enabled by default.
+ *
+ * \param [IN] enable Recording state
+ */
+void TraceEnable( bool enable );
+
+/*!
+ * \brief Writes the buffer contents, oldest record first, as hex lines to
+ *        the serial console and empties the buffer. Recording is suspended
+ *        while dumping.
+ *
+ *        The output is read by tools/trace_decode.py.
+ */
+void TraceDump( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TRACE_H__
@@ -0,0 +1,57 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Flash partition of the ESP32 holding the uplink log
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+#include "uplink-log-board.h"
+
+static const esp_partition_t *Partition = NULL;
+
+static bool Read( uint32_t address, void *buffer, uint32_t size )
+{
+    return esp_partition_read( Partition, address, buffer, size ) == ESP_OK;
+}
+
+static bool Write( uint32_t address, const void *buffer, uint32_t size )
+{
+    return esp_partition_write( Partition, address, buffer, size ) == ESP_OK;
+}
+
+static bool Erase( uint32_t address )
+{
+    return esp_partition_erase_range( Partition, address, SPI_FLASH_SEC_SIZE ) == ESP_OK;
+}
+
+static UplinkLogFlash_t UplinkLogFlash =
+{
+    .SectorSize = SPI_FLASH_SEC_SIZE,
+    .NbSectors = 0,
+    .Read = Read,
+    .Write = Write,
+    .Erase = Erase,
+};
+
+const UplinkLogFlash_t *UplinkLogBoardGetFlash( void )
+{
+    if( Partition == NULL )
+    {
+        Partition = esp_partition_find_first( ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, UPLINK_LOG_PARTITION_LABEL );
+        if( Partition == NULL )
+        {
+            return NULL;
+        }
+        UplinkLogFlash.NbSectors = Partition->size / SPI_FLASH_SEC_SIZE;
+    }
+    return &UplinkLogFlash;
+}
@@ -0,0 +1,43 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Flash partition of the ESP32 holding the uplink log
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __UPLINK_LOG_BOARD_H__
+#define __UPLINK_LOG_BOARD_H__
+
+#include "uplink-log.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Label of the data partition holding the log, to be added to the partition
+ * table, e.g. "uplog, data, 0x40, , 0x10000," for 16 sectors
+ */
+#ifndef UPLINK_LOG_PARTITION_LABEL
+#define UPLINK_LOG_PARTITION_LABEL                  "uplog"
+#endif
+
+/*!
+ * \brief Returns the flash of the log partition
+ *
+ * \retval flash Flash to give to \ref UplinkLogInit, NULL without partition
+ */
+const UplinkLogFlash_t *UplinkLogBoardGetFlash( void );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __UPLINK_LOG_BOARD_H__
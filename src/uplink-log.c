@@ -0,0 +1,466 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Store-and-forward log of the application uplinks in flash
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stddef.h>
+#include "esp_attr.h"
+#include "utilities.h"
+#include "uplink-log.h"
+
+/*!
+ * Sector header magic, "ULOG"
+ */
+#define UPLINK_LOG_MAGIC                            0x474F4C55
+
+/*!
+ * Record size byte of the erased space after the last record
+ */
+#define UPLINK_LOG_FREE                             0xFF
+
+/*!
+ * Record acknowledgement byte values. It is written once delivered, which
+ * only clears bits and needs no erase.
+ */
+#define UPLINK_LOG_PENDING                          0xFF
+#define UPLINK_LOG_DELIVERED                        0x00
+
+/*!
+ * Sector header. The sectors are written in turn, each one with the sequence
+ * of the previous one plus one.
+ */
+typedef struct sUplinkLogSector
+{
+    uint32_t Magic;
+    uint32_t Sequence;
+    uint32_t EraseCount;
+    uint32_t Check;
+}UplinkLogSector_t;
+
+/*!
+ * Record header, followed by the data. The CRC covers the size, the port,
+ * the time and the data.
+ */
+typedef struct sUplinkLogRecord
+{
+    uint8_t Size;
+    uint8_t Ack;
+    uint8_t Port;
+    uint8_t Crc;
+    uint32_t Time;
+}UplinkLogRecord_t;
+
+#define UPLINK_LOG_SECTOR_HEADER_SIZE               sizeof( UplinkLogSector_t )
+#define UPLINK_LOG_RECORD_HEADER_SIZE               sizeof( UplinkLogRecord_t )
+
+/*!
+ * Log state
+ */
+typedef struct sUplinkLog
+{
+    /*!
+     * Flash of the mounted log, NULL when not mounted
+     */
+    const UplinkLogFlash_t *Flash;
+    /*!
+     * Newest sector, its sequence, and the address of the next record in it
+     */
+    uint32_t HeadSector;
+    uint32_t Sequence;
+    uint32_t Head;
+    /*!
+     * Address of the oldest pending record, the head when none
+     */
+    uint32_t Tail;
+    /*!
+     * Records of the last frame packed from the tail
+     */
+    uint32_t PackCount;
+    UplinkLogStatus_t Status;
+}UplinkLog_t;
+
+/*!
+ * State, kept in RTC memory so that a deep sleep wake-up does not scan the flash
+ */
+RTC_DATA_ATTR static UplinkLog_t Log;
+
+static uint32_t SectorStart( uint32_t sector )
+{
+    return sector * Log.Flash->SectorSize;
+}
+
+static uint32_t NextSector( uint32_t sector )
+{
+    return ( sector + 1 ) % Log.Flash->NbSectors;
+}
+
+/*!
+ * \brief Returns the sector of a record address. The address after the last
+ *        record of a full sector is still in this sector.
+ */
+static uint32_t SectorOf( uint32_t address )
+{
+    return ( address - 1 ) / Log.Flash->SectorSize;
+}
+
+static uint32_t SectorCheck( UplinkLogSector_t *sector )
+{
+    return ~( sector->Magic ^ sector->Sequence ^ sector->EraseCount );
+}
+
+static bool ReadSector( uint32_t sector, UplinkLogSector_t *header )
+{
+    if( Log.Flash->Read( SectorStart( sector ), header, UPLINK_LOG_SECTOR_HEADER_SIZE ) == false )
+    {
+        return false;
+    }
+    return ( header->Magic == UPLINK_LOG_MAGIC ) && ( header->Check == SectorCheck( header ) );
+}
+
+/*!
+ * \brief Reads the header of a record
+ *
+ * \retval [false: no record, Size is UPLINK_LOG_FREE at the end of the records
+ *          and something else on a cut write, true: record valid]
+ */
+static bool ReadRecord( uint32_t address, UplinkLogRecord_t *record )
+{
+    uint32_t end = SectorStart( SectorOf( address ) ) + Log.Flash->SectorSize;
+
+    if( ( ( address + UPLINK_LOG_RECORD_HEADER_SIZE ) > end ) ||
+        ( Log.Flash->Read( address, record, UPLINK_LOG_RECORD_HEADER_SIZE ) == false ) )
+    {
+        record->Size = UPLINK_LOG_FREE;
+        return false;
+    }
+    return ( record->Size <= UPLINK_LOG_MAX_DATA_SIZE ) && ( ( address + UPLINK_LOG_RECORD_HEADER_SIZE + record->Size ) <= end );
+}
+
+/*!
+ * \brief Returns the address of the record at or after an address, in the
+ *        next sector once past the last record of a sector
+ */
+static uint32_t NextRecord( uint32_t address )
+{
+    UplinkLogRecord_t record;
+
+    if( ( address == Log.Head ) || ( ReadRecord( address, &record ) == true ) )
+    {
+        return address;
+    }
+    return SectorStart( NextSector( SectorOf( address ) ) ) + UPLINK_LOG_SECTOR_HEADER_SIZE;
+}
+
+static uint8_t Crc8( uint8_t crc, const uint8_t *data, uint16_t size )
+{
+    while( size-- > 0 )
+    {
+        crc ^= *data++;
+        for( uint8_t i = 0; i < 8; i++ )
+        {
+            crc = ( crc & 0x80 ) ? ( crc << 1 ) ^ 0x07 : ( crc << 1 );
+        }
+    }
+    return crc;
+}
+
+static uint8_t RecordCrc( UplinkLogRecord_t *record, const uint8_t *data )
+{
+    uint8_t crc = Crc8( 0, &record->Size, 1 );
+
+    crc = Crc8( crc, &record->Port, 1 );
+    crc = Crc8( crc, ( uint8_t * )&record->Time, sizeof( record->Time ) );
+    return Crc8( crc, data, record->Size );
+}
+
+/*!
+ * \brief Marks the oldest pending record delivered and moves the tail past it
+ */
+static void AdvanceTail( void )
+{
+    UplinkLogRecord_t record;
+    uint8_t ack = UPLINK_LOG_DELIVERED;
+
+    if( ReadRecord( Log.Tail, &record ) == true )
+    {
+        Log.Flash->Write( Log.Tail + offsetof( UplinkLogRecord_t, Ack ), &ack, 1 );
+        Log.Tail = NextRecord( Log.Tail + UPLINK_LOG_RECORD_HEADER_SIZE + record.Size );
+    }
+    else
+    {
+        Log.Tail = NextRecord( Log.Tail );
+    }
+    Log.Status.Pending--;
+    if( Log.Status.Pending == 0 )
+    {
+        Log.Tail = Log.Head;
+    }
+}
+
+/*!
+ * \brief Erases the sector after the head one and makes it the head, dropping
+ *        its pending records
+ */
+static bool OpenSector( void )
+{
+    UplinkLogSector_t header;
+    uint32_t next = NextSector( Log.HeadSector );
+    uint32_t eraseCount;
+
+    // The frame in flight starts at the tail, it cannot be acknowledged anymore
+    if( ( Log.Status.Pending > 0 ) && ( ( Log.Tail / Log.Flash->SectorSize ) == next ) )
+    {
+        Log.PackCount = 0;
+    }
+    while( ( Log.Status.Pending > 0 ) && ( ( Log.Tail / Log.Flash->SectorSize ) == next ) )
+    {
+        AdvanceTail( );
+        Log.Status.Dropped++;
+    }
+
+    eraseCount = ( ReadSector( next, &header ) == true ) ? header.EraseCount + 1 : MAX( Log.Status.EraseCount, 1 );
+    if( Log.Flash->Erase( SectorStart( next ) ) == false )
+    {
+        return false;
+    }
+    header.Magic = UPLINK_LOG_MAGIC;
+    header.Sequence = Log.Sequence + 1;
+    header.EraseCount = eraseCount;
+    header.Check = SectorCheck( &header );
+    if( Log.Flash->Write( SectorStart( next ), &header, UPLINK_LOG_SECTOR_HEADER_SIZE ) == false )
+    {
+        return false;
+    }
+
+    Log.HeadSector = next;
+    Log.Sequence = header.Sequence;
+    Log.Head = SectorStart( next ) + UPLINK_LOG_SECTOR_HEADER_SIZE;
+    Log.Status.EraseCount = eraseCount;
+    if( Log.Status.Pending == 0 )
+    {
+        Log.Tail = Log.Head;
+    }
+    return true;
+}
+
+bool UplinkLogInit( const UplinkLogFlash_t *flash )
+{
+    UplinkLogSector_t header;
+    UplinkLogRecord_t record;
+    uint32_t oldest;
+    uint32_t address;
+    uint32_t sector;
+    bool found = false;
+
+    if( Log.Flash == flash )
+    {
+        return true;
+    }
+    if( ( flash->NbSectors < 2 ) ||
+        ( flash->SectorSize < ( UPLINK_LOG_SECTOR_HEADER_SIZE + UPLINK_LOG_RECORD_HEADER_SIZE + UPLINK_LOG_MAX_DATA_SIZE ) ) )
+    {
+        return false;
+    }
+    memset1( ( uint8_t * )&Log, 0, sizeof( Log ) );
+    Log.Flash = flash;
+
+    // The head sector has the highest sequence
+    for( sector = 0; sector < flash->NbSectors; sector++ )
+    {
+        if( ( ReadSector( sector, &header ) == true ) && ( ( found == false ) || ( ( int32_t )( header.Sequence - Log.Sequence ) > 0 ) ) )
+        {
+            found = true;
+            Log.HeadSector = sector;
+            Log.Sequence = header.Sequence;
+            Log.Status.EraseCount = header.EraseCount;
+        }
+    }
+    if( found == false )
+    {
+        Log.HeadSector = flash->NbSectors - 1;
+        if( OpenSector( ) == false )
+        {
+            Log.Flash = NULL;
+            return false;
+        }
+        return true;
+    }
+
+    // The older sectors precede it, each one with the previous sequence
+    oldest = Log.HeadSector;
+    for( sector = 1; sector < flash->NbSectors; sector++ )
+    {
+        address = ( Log.HeadSector + flash->NbSectors - sector ) % flash->NbSectors;
+        if( ( ReadSector( address, &header ) == false ) || ( header.Sequence != ( Log.Sequence - sector ) ) )
+        {
+            break;
+        }
+        oldest = address;
+    }
+
+    // Walk the records up to the end of the head sector ones
+    address = SectorStart( oldest ) + UPLINK_LOG_SECTOR_HEADER_SIZE;
+    for( ;; )
+    {
+        if( ReadRecord( address, &record ) == true )
+        {
+            if( record.Ack != UPLINK_LOG_DELIVERED )
+            {
+                if( Log.Status.Pending == 0 )
+                {
+                    Log.Tail = address;
+                }
+                Log.Status.Pending++;
+            }
+            address += UPLINK_LOG_RECORD_HEADER_SIZE + record.Size;
+        }
+        else if( SectorOf( address ) != Log.HeadSector )
+        {
+            address = SectorStart( NextSector( SectorOf( address ) ) ) + UPLINK_LOG_SECTOR_HEADER_SIZE;
+        }
+        else
+        {
+            break;
+        }
+    }
+    Log.Head = address;
+    if( record.Size != UPLINK_LOG_FREE )
+    {
+        // A record write was cut, the space after it is not erased
+        Log.Head = SectorStart( Log.HeadSector ) + flash->SectorSize;
+    }
+    if( Log.Status.Pending == 0 )
+    {
+        Log.Tail = Log.Head;
+    }
+    return true;
+}
+
+bool UplinkLogAppend( uint8_t port, uint32_t time, const uint8_t *data, uint8_t size )
+{
+    uint8_t buffer[UPLINK_LOG_RECORD_HEADER_SIZE + UPLINK_LOG_MAX_DATA_SIZE];
+    UplinkLogRecord_t record;
+
+    if( ( Log.Flash == NULL ) || ( size > UPLINK_LOG_MAX_DATA_SIZE ) )
+    {
+        return false;
+    }
+    if( ( Log.Head + UPLINK_LOG_RECORD_HEADER_SIZE + size ) > ( SectorStart( Log.HeadSector ) + Log.Flash->SectorSize ) )
+    {
+        if( OpenSector( ) == false )
+        {
+            return false;
+        }
+    }
+
+    record.Size = size;
+    record.Ack = UPLINK_LOG_PENDING;
+    record.Port = port;
+    record.Time = time;
+    record.Crc = RecordCrc( &record, data );
+    memcpy1( buffer, ( uint8_t * )&record, UPLINK_LOG_RECORD_HEADER_SIZE );
+    memcpy1( buffer + UPLINK_LOG_RECORD_HEADER_SIZE, data, size );
+
+    if( Log.Flash->Write( Log.Head, buffer, UPLINK_LOG_RECORD_HEADER_SIZE + size ) == false )
+    {
+        // The space may hold a part of the record, leave the sector
+        Log.Head = SectorStart( Log.HeadSector ) + Log.Flash->SectorSize;
+        if( Log.Status.Pending == 0 )
+        {
+            Log.Tail = Log.Head;
+        }
+        return false;
+    }
+    Log.Head += UPLINK_LOG_RECORD_HEADER_SIZE + size;
+    Log.Status.Pending++;
+    Log.Status.Stored++;
+    return true;
+}
+
+uint8_t UplinkLogPack( uint32_t time, uint8_t *buffer, uint8_t maxSize )
+{
+    UplinkLogRecord_t record;
+    uint32_t address;
+    uint32_t pending;
+    uint32_t age;
+    uint8_t *entry;
+    uint8_t size = 0;
+
+    Log.PackCount = 0;
+    if( Log.Flash == NULL )
+    {
+        return 0;
+    }
+
+    address = Log.Tail;
+    pending = Log.Status.Pending;
+    while( pending > 0 )
+    {
+        entry = buffer + size;
+        if( ( ReadRecord( address, &record ) == false ) ||
+            ( ( size + UPLINK_LOG_ENTRY_HEADER_SIZE + record.Size ) > maxSize ) ||
+            ( Log.Flash->Read( address + UPLINK_LOG_RECORD_HEADER_SIZE, entry + UPLINK_LOG_ENTRY_HEADER_SIZE, record.Size ) == false ) )
+        {
+            break;
+        }
+        if( record.Crc != RecordCrc( &record, entry + UPLINK_LOG_ENTRY_HEADER_SIZE ) )
+        {
+            // Corrupted, dropped once it is the oldest one
+            if( Log.PackCount > 0 )
+            {
+                break;
+            }
+            AdvanceTail( );
+            Log.Status.Dropped++;
+            address = Log.Tail;
+            pending = Log.Status.Pending;
+            continue;
+        }
+
+        age = ( time >= record.Time ) ? MIN( time - record.Time, UPLINK_LOG_AGE_UNKNOWN - 1 ) : UPLINK_LOG_AGE_UNKNOWN;
+        entry[0] = record.Port;
+        entry[1] = record.Size;
+        entry[2] = age & 0xFF;
+        entry[3] = ( age >> 8 ) & 0xFF;
+        entry[4] = ( age >> 16 ) & 0xFF;
+        size += UPLINK_LOG_ENTRY_HEADER_SIZE + record.Size;
+
+        address = NextRecord( address + UPLINK_LOG_RECORD_HEADER_SIZE + record.Size );
+        pending--;
+        Log.PackCount++;
+    }
+    return size;
+}
+
+void UplinkLogAck( bool delivered )
+{
+    if( delivered == true )
+    {
+        while( ( Log.PackCount > 0 ) && ( Log.Status.Pending > 0 ) )
+        {
+            AdvanceTail( );
+            Log.Status.Delivered++;
+            Log.PackCount--;
+        }
+    }
+    Log.PackCount = 0;
+}
+
+uint32_t UplinkLogPending( void )
+{
+    return Log.Status.Pending;
+}
+
+void UplinkLogGetStatus( UplinkLogStatus_t *status )
+{
+    *status = Log.Status;
+}
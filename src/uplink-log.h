@@ -0,0 +1,155 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Store-and-forward log of the application uplinks in flash
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __UPLINK_LOG_H__
+#define __UPLINK_LOG_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*!
+ * Application port of the frames packing the log records
+ */
+#ifndef UPLINK_LOG_FPORT
+#define UPLINK_LOG_FPORT                            10
+#endif
+
+/*!
+ * Size of a record in a frame, before its data: port, data size and age
+ */
+#define UPLINK_LOG_ENTRY_HEADER_SIZE                5
+
+/*!
+ * Maximum data size of a record, packed alone in the largest frame
+ */
+#define UPLINK_LOG_MAX_DATA_SIZE                    ( 242 - UPLINK_LOG_ENTRY_HEADER_SIZE )
+
+/*!
+ * Age of a record whose time is after the frame time, the RTC time restarted
+ */
+#define UPLINK_LOG_AGE_UNKNOWN                      0xFFFFFF
+
+/*!
+ * Flash holding the log. Erasing a sector sets its bytes to 0xFF, writing only
+ * clears bits.
+ */
+typedef struct sUplinkLogFlash
+{
+    /*!
+     * Erase sector size and number of sectors, at least 2
+     */
+    uint32_t SectorSize;
+    uint16_t NbSectors;
+    /*!
+     * Functions, returning false on a flash error. Addresses are from the
+     * start of the log.
+     */
+    bool ( *Read )( uint32_t address, void *buffer, uint32_t size );
+    bool ( *Write )( uint32_t address, const void *buffer, uint32_t size );
+    bool ( *Erase )( uint32_t address );
+}UplinkLogFlash_t;
+
+/*!
+ * Log status
+ */
+typedef struct sUplinkLogStatus
+{
+    /*!
+     * Records waiting for their delivery
+     */
+    uint32_t Pending;
+    /*!
+     * Records appended, delivered, and dropped either to make room or as
+     * corrupted, since the log was mounted
+     */
+    uint32_t Stored;
+    uint32_t Delivered;
+    uint32_t Dropped;
+    /*!
+     * Erases of the newest sector. The sectors are used in turn, the others
+     * have the same count or one less.
+     */
+    uint32_t EraseCount;
+}UplinkLogStatus_t;
+
+/*!
+ * \brief Mounts the log, formatting the sectors not holding it yet
+ *
+ * \remark The log state is kept in RTC memory, the flash is only scanned the
+ *         first time or after a reset
+ *
+ * \param [IN] flash Flash holding the log
+ *
+ * \retval [false: flash error or too small, true: log mounted]
+ */
+bool UplinkLogInit( const UplinkLogFlash_t *flash );
+
+/*!
+ * \brief Appends a record, dropping the oldest sector when the log is full
+ *
+ * \param [IN] port Application port of the data
+ * \param [IN] time Time of the data, from the same clock as the one given to
+ *                  \ref UplinkLogPack [s]
+ * \param [IN] data Record data
+ * \param [IN] size Record data size, up to UPLINK_LOG_MAX_DATA_SIZE
+ *
+ * \retval [false: not mounted, size or flash error, true: record appended]
+ */
+bool UplinkLogAppend( uint8_t port, uint32_t time, const uint8_t *data, uint8_t size );
+
+/*!
+ * \brief Packs the oldest pending records in a frame payload, each one as
+ *        port, data size, age [s] on 24 bits LSB first and data. The records
+ *        stay pending until \ref UplinkLogAck.
+ *
+ * \param [IN]  time    Time of the frame [s]
+ * \param [OUT] buffer  Frame payload
+ * \param [IN]  maxSize Maximum frame payload size
+ *
+ * \retval size Frame payload size, 0 when no record is pending or the oldest
+ *              one does not fit
+ */
+uint8_t UplinkLogPack( uint32_t time, uint8_t *buffer, uint8_t maxSize );
+
+/*!
+ * \brief Ends the frame of the last \ref UplinkLogPack
+ *
+ * \param [IN] delivered The frame was acknowledged, its records are marked
+ *                       delivered in flash. Otherwise they stay pending.
+ */
+void UplinkLogAck( bool delivered );
+
+/*!
+ * \brief Returns the number of records waiting for their delivery
+ *
+ * \retval pending Pending records
+ */
+uint32_t UplinkLogPending( void );
+
+/*!
+ * \brief Returns the log status
+ *
+ * \param [OUT] status Copy of the status
+ */
+void UplinkLogGetStatus( UplinkLogStatus_t *status );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __UPLINK_LOG_H__
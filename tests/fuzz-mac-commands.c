@@ -0,0 +1,322 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Fuzz harness and benchmark of the downlink MAC commands parsing
+
+             Built with LORAWAN_FUZZER, it is a libFuzzer target: the first
+             byte of the input is the SNR, the others the MAC commands.
+             Otherwise, it runs the files given as arguments through the
+             same checks, or random frames followed by a benchmark of the
+             parsing:
+
+               fuzz-mac-commands [frames|files...]
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <time.h>
+// The parsing is static to the MAC
+#include "LoRaMac.c"
+#include "host-clock.h"
+#include "host-board.h"
+#include "radio-sim.h"
+
+/*!
+ * Longest MAC commands block, in a FRMPayload on port 0
+ */
+#define FUZZ_MAX_COMMANDS_SIZE                      242
+
+/*!
+ * Frames of a benchmark batch
+ */
+#define BENCH_BATCH_SIZE                            1024
+
+/*!
+ * MAC context after the initialization, restored before each input
+ */
+static LoRaMacCtx_t InitialCtx;
+
+static void OnMacMcpsConfirm( McpsConfirm_t *mcpsConfirm )
+{
+}
+
+static void OnMacMcpsIndication( McpsIndication_t *mcpsIndication )
+{
+}
+
+static void OnMacMlmeConfirm( MlmeConfirm_t *mlmeConfirm )
+{
+}
+
+static void OnMacMlmeIndication( MlmeIndication_t *mlmeIndication )
+{
+}
+
+static uint8_t GetBatteryLevel( void )
+{
+    return 128;
+}
+
+static float GetTemperatureLevel( void )
+{
+    return 25.0f;
+}
+
+static LoRaMacPrimitives_t Primitives =
+{
+    .MacMcpsConfirm = OnMacMcpsConfirm,
+    .MacMcpsIndication = OnMacMcpsIndication,
+    .MacMlmeConfirm = OnMacMlmeConfirm,
+    .MacMlmeIndication = OnMacMlmeIndication,
+};
+
+static LoRaMacCallback_t Callbacks =
+{
+    .GetBatteryLevel = GetBatteryLevel,
+    .GetTemperatureLevel = GetTemperatureLevel,
+};
+
+/*!
+ * \brief Initializes a joined EU868 device with ADR, and saves its context
+ */
+static void Setup( void )
+{
+    MibRequestConfirm_t mibReq;
+
+    HostClockReset( );
+    HostBoardReset( 1, false );
+    RadioSimReset( 1 );
+    if( LoRaMacInitialization( &Primitives, &Callbacks, LORAMAC_REGION_EU868 ) != LORAMAC_STATUS_OK )
+    {
+        printf( "LoRaMacInitialization failed\n" );
+        abort( );
+    }
+    mibReq.Type = MIB_NETWORK_JOINED;
+    mibReq.Param.IsNetworkJoined = true;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = true;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    InitialCtx = *Ctx;
+}
+
+/*!
+ * \brief Checks that the answers are well formed uplink MAC commands, which
+ *        fit with the commands to repeat
+ */
+static void CheckAnswers( void )
+{
+    uint8_t repeat[LORA_MAC_COMMAND_MAX_LENGTH];
+    uint8_t i = 0;
+
+    if( Ctx->MacCommandsBufferIndex > ( LORA_MAC_COMMAND_MAX_LENGTH - Ctx->MacCommandsBufferToRepeatIndex ) )
+    {
+        printf( "MAC commands buffer overflow: %u + %u\n", Ctx->MacCommandsBufferIndex, Ctx->MacCommandsBufferToRepeatIndex );
+        abort( );
+    }
+    while( i < Ctx->MacCommandsBufferIndex )
+    {
+        uint8_t cid = Ctx->MacCommandsBuffer[i];
+
+        if( ( cid > MAC_CMD_CID_MAX ) || ( MacCommandsUp[cid].Valid == false ) )
+        {
+            printf( "Invalid answer 0x%02X at %u\n", cid, i );
+            abort( );
+        }
+        i += 1 + MacCommandsUp[cid].Length;
+    }
+    if( i != Ctx->MacCommandsBufferIndex )
+    {
+        printf( "Truncated answer: %u bytes for %u\n", i, Ctx->MacCommandsBufferIndex );
+        abort( );
+    }
+    if( ParseMacCommandsToRepeat( Ctx->MacCommandsBuffer, Ctx->MacCommandsBufferIndex, repeat ) > Ctx->MacCommandsBufferIndex )
+    {
+        printf( "More commands to repeat than answers\n" );
+        abort( );
+    }
+}
+
+/*!
+ * \brief Processes one input from the initial context
+ *
+ * \param [IN] data Input, SNR then MAC commands
+ * \param [IN] size Input size
+ */
+static void RunInput( const uint8_t *data, size_t size )
+{
+    // The parsing must not read past the commands, a copy of their exact
+    // size lets ASan check it
+    uint8_t *commands;
+    uint8_t commandsSize;
+
+    if( size < 1 )
+    {
+        return;
+    }
+    commandsSize = ( uint8_t )MIN( size - 1, FUZZ_MAX_COMMANDS_SIZE );
+    commands = malloc( MAX( commandsSize, 1 ) );
+    memcpy1( commands, data + 1, commandsSize );
+    *Ctx = InitialCtx;
+    ProcessMacCommands( commands, 0, commandsSize, data[0], RX_SLOT_WIN_1 );
+    CheckAnswers( );
+    free( commands );
+}
+
+#if defined( LORAWAN_FUZZER )
+
+int LLVMFuzzerTestOneInput( const uint8_t *data, size_t size )
+{
+    static bool initialized = false;
+
+    if( initialized == false )
+    {
+        Setup( );
+        initialized = true;
+    }
+    RunInput( data, size );
+    return 0;
+}
+
+#else
+
+static uint32_t RandomState = 0x12345678;
+
+static uint32_t NextRandom( void )
+{
+    // xorshift32
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 17;
+    RandomState ^= RandomState << 5;
+    return RandomState;
+}
+
+/*!
+ * \brief Builds a random frame: mostly known commands with random payloads,
+ *        sometimes random bytes, in a FOpts field or a port 0 payload
+ *
+ * \param [OUT] frame SNR then MAC commands
+ *
+ * \retval size Frame size
+ */
+static uint8_t BuildFrame( uint8_t *frame )
+{
+    uint8_t size = ( ( NextRandom( ) & 7 ) == 0 ) ? 1 + NextRandom( ) % FUZZ_MAX_COMMANDS_SIZE : 1 + NextRandom( ) % 16;
+    uint8_t i = 1;
+
+    frame[0] = NextRandom( );
+    while( i < size )
+    {
+        uint8_t cid = NextRandom( ) % ( MAC_CMD_CID_MAX + 2 );
+
+        if( ( ( NextRandom( ) & 3 ) == 0 ) || ( cid > MAC_CMD_CID_MAX ) || ( MacCommandsDown[cid].Valid == false ) )
+        {
+            frame[i++] = NextRandom( );
+            continue;
+        }
+        frame[i++] = cid;
+        for( uint8_t j = 0; ( j < MacCommandsDown[cid].Length ) && ( i < size ); j++ )
+        {
+            frame[i++] = NextRandom( );
+        }
+    }
+    return size;
+}
+
+static uint64_t GetHostTime( void )
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return ( uint64_t )now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/*!
+ * \brief Measures the parsing alone: the answers buffer is emptied between
+ *        the frames instead of restoring the whole context
+ */
+static void Benchmark( uint32_t frames )
+{
+    static uint8_t batch[BENCH_BATCH_SIZE][FUZZ_MAX_COMMANDS_SIZE + 1];
+    static uint8_t sizes[BENCH_BATCH_SIZE];
+    uint64_t elapsed = 0;
+    uint32_t commands;
+
+    *Ctx = InitialCtx;
+    commands = Ctx->Statistics.MacCommands;
+    for( uint32_t done = 0; done < frames; done += BENCH_BATCH_SIZE )
+    {
+        uint64_t start;
+
+        for( uint16_t i = 0; i < BENCH_BATCH_SIZE; i++ )
+        {
+            sizes[i] = BuildFrame( batch[i] );
+        }
+        start = GetHostTime( );
+        for( uint16_t i = 0; i < BENCH_BATCH_SIZE; i++ )
+        {
+            Ctx->MacCommandsBufferIndex = 0;
+            ProcessMacCommands( &batch[i][1], 0, sizes[i] - 1, batch[i][0], RX_SLOT_WIN_1 );
+        }
+        elapsed += GetHostTime( ) - start;
+    }
+    commands = Ctx->Statistics.MacCommands - commands;
+    printf( "%u MAC commands in %.3f ms, %.1f M commands/s\n", ( unsigned )commands, elapsed / 1e6,
+            ( elapsed > 0 ) ? commands * 1e3 / elapsed : 0.0 );
+}
+
+static bool RunFile( const char *path )
+{
+    static uint8_t data[FUZZ_MAX_COMMANDS_SIZE + 1];
+    FILE *file = fopen( path, "rb" );
+    size_t size;
+
+    if( file == NULL )
+    {
+        printf( "%s: cannot open\n", path );
+        return false;
+    }
+    size = fread( data, 1, sizeof( data ), file );
+    fclose( file );
+    RunInput( data, size );
+    printf( "%s: %u bytes\n", path, ( unsigned )size );
+    return true;
+}
+
+int main( int argc, char **argv )
+{
+    uint8_t frame[FUZZ_MAX_COMMANDS_SIZE + 1];
+    uint32_t frames = 100000;
+
+    Setup( );
+    if( ( argc > 1 ) && ( atoi( argv[1] ) == 0 ) )
+    {
+        for( int i = 1; i < argc; i++ )
+        {
+            if( RunFile( argv[i] ) == false )
+            {
+                return 1;
+            }
+        }
+        return 0;
+    }
+    if( argc > 1 )
+    {
+        frames = atoi( argv[1] );
+    }
+    for( uint32_t i = 0; i < frames; i++ )
+    {
+        RunInput( frame, BuildFrame( frame ) );
+    }
+    printf( "%u random frames checked\n", ( unsigned )frames );
+    Benchmark( frames );
+    return 0;
+}
+
+#endif
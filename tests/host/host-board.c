@@ -0,0 +1,87 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host board of the MAC tests: console, random numbers and a
+             light sleep on the virtual clock
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdarg.h>
+#include "Arduino.h"
+#include "esp_sleep.h"
+#include "host-clock.h"
+#include "host-board.h"
+
+static bool Verbose = false;
+static uint32_t RandomState = 1;
+static uint64_t WakeupTime = 0;
+
+void HostBoardReset( uint32_t seed, bool verbose )
+{
+    RandomState = ( seed != 0 ) ? seed : 1;
+    Verbose = verbose;
+}
+
+int xprintf( const char *format, ... )
+{
+    va_list args;
+    int length = 0;
+
+    if( Verbose == true )
+    {
+        va_start( args, format );
+        length = vprintf( format, args );
+        va_end( args );
+    }
+    return length;
+}
+
+uint32_t esp_random( void )
+{
+    // xorshift32
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 17;
+    RandomState ^= RandomState << 5;
+    return RandomState;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup( uint64_t time_in_us )
+{
+    WakeupTime = time_in_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup( void )
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source( esp_sleep_source_t source )
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start( void )
+{
+    HostClockGate( WakeupTime );
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start( void )
+{
+    // The MAC tests keep the deep sleep disabled, a reset would end them
+    printf( "esp_deep_sleep_start: no deep sleep on the host\n" );
+    abort( );
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause( void )
+{
+    return ESP_SLEEP_WAKEUP_TIMER;
+}
@@ -0,0 +1,35 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host board of the MAC tests: console, random numbers and a
+             light sleep on the virtual clock
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __HOST_BOARD_H__
+#define __HOST_BOARD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * \brief Resets the board
+ *
+ * \param [IN] seed    Seed of esp_random
+ * \param [IN] verbose Prints the xprintf output of the library
+ */
+void HostBoardReset( uint32_t seed, bool verbose );
+
+/*!
+ * \brief Console of the library, printed when verbose
+ */
+int xprintf( const char *format, ... );
+
+#endif // __HOST_BOARD_H__
@@ -0,0 +1,393 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Virtual clock of the host tests, and the timer list of timer.S
+             on it. The list keeps absolute expiry times instead of the
+             deltas of timer.S, the callers see the same behaviour.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <sys/time.h>
+#include "Arduino.h"
+#include "esp_clk.h"
+#include "rtc-board.h"
+#include "host-clock.h"
+
+/*!
+ * Hardware timer ticks per ms, 1 MHz as the 80 MHz APB clock divided by 80
+ */
+#define HOST_TIMER_TICKS_PER_MS                     1000
+
+/*!
+ * Nominal slow clock frequency [Hz]
+ */
+#define HOST_RTC_FREQUENCY                          150000.0
+
+struct hw_timer_s
+{
+    uint8_t Number;
+};
+
+static hw_timer_t HwTimer;
+
+hw_timer_t *timer = &HwTimer;
+uint32_t TimeSwitch = HOST_TIMER_TICKS_PER_MS;
+uint64_t preAlarmtimer = 0;
+uint64_t nextAlarm = 0;
+TimerEvent_t *TimerListHead = NULL;
+
+/*!
+ * Context of the timer whose callback is running
+ */
+static void *TimerContext = NULL;
+
+/*!
+ * Virtual time [us] and offset of the hardware timer from it [ticks]
+ */
+static uint64_t ClockTime = 0;
+static int64_t TimerOffset = 0;
+
+/*!
+ * Virtual time of each timer read [us]
+ */
+static uint32_t PollCost = 0;
+
+/*!
+ * Slow clock error [ppm] and calibration in use
+ */
+static double RtcError = 0;
+static uint32_t SlowClkCal = 0;
+
+/*!
+ * System time at the virtual time 0 [us]
+ */
+static int64_t SysTimeOffset = 0;
+
+/*!
+ * \brief Returns the slow clock period, as measured by a calibration
+ *
+ * \retval period Period [us] with RTC_CLK_CAL_FRACT fractional bits
+ */
+static uint32_t GetRtcPeriod( void )
+{
+    return ( uint32_t )( ( 1e6 / ( HOST_RTC_FREQUENCY * ( 1.0 + RtcError / 1e6 ) ) ) * ( 1 << RTC_CLK_CAL_FRACT ) );
+}
+
+/*!
+ * \brief Updates nextAlarm to the expiry of the head of the list
+ */
+static void UpdateNextAlarm( void )
+{
+    nextAlarm = ( TimerListHead != NULL ) ? TimerListHead->Timestamp : 0;
+}
+
+/*!
+ * \brief Checks if the timer object is in the list
+ */
+static bool TimerExists( TimerEvent_t *obj )
+{
+    for( TimerEvent_t *cur = TimerListHead; cur != NULL; cur = cur->Next )
+    {
+        if( cur == obj )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HostClockReset( void )
+{
+    ClockTime = 0;
+    TimerOffset = 0;
+    PollCost = 0;
+    RtcError = 0;
+    SlowClkCal = GetRtcPeriod( );
+    SysTimeOffset = 0;
+    TimerListHead = NULL;
+    TimerContext = NULL;
+    UpdateNextAlarm( );
+}
+
+uint64_t HostClockGetTime( void )
+{
+    return ClockTime;
+}
+
+void HostClockAdvance( uint64_t time )
+{
+    ClockTime += time;
+}
+
+void HostClockGate( uint64_t time )
+{
+    ClockTime += time;
+    TimerOffset -= ( int64_t )time * HOST_TIMER_TICKS_PER_MS / 1000;
+}
+
+void HostClockRun( uint64_t time )
+{
+    uint64_t end = ClockTime + time;
+
+    while( TimerListHead != NULL )
+    {
+        uint64_t ticks = timerRead( timer );
+        uint64_t expiry = ( uint64_t )TimerListHead->Timestamp * HOST_TIMER_TICKS_PER_MS;
+        uint64_t due = ClockTime + ( ( expiry > ticks ) ? ( expiry - ticks ) * 1000 / HOST_TIMER_TICKS_PER_MS : 0 );
+
+        if( due > end )
+        {
+            break;
+        }
+        ClockTime = due;
+        TimerIrqHandler( );
+    }
+    if( ClockTime < end )
+    {
+        ClockTime = end;
+    }
+}
+
+bool HostClockRunAll( uint64_t limit )
+{
+    while( ( TimerListHead != NULL ) && ( ClockTime < limit ) )
+    {
+        uint64_t ticks = timerRead( timer );
+        uint64_t expiry = ( uint64_t )TimerListHead->Timestamp * HOST_TIMER_TICKS_PER_MS;
+
+        HostClockRun( ( expiry > ticks ) ? ( expiry - ticks ) * 1000 / HOST_TIMER_TICKS_PER_MS : 0 );
+    }
+    return TimerListHead == NULL;
+}
+
+void HostClockSetPollCost( uint32_t cost )
+{
+    PollCost = cost;
+}
+
+void HostClockSetRtcError( float ppm )
+{
+    RtcError = ppm;
+}
+
+/*
+ * Hardware timer
+ */
+
+uint64_t timerRead( hw_timer_t *timer )
+{
+    return ( uint64_t )( ( int64_t )( ClockTime * HOST_TIMER_TICKS_PER_MS / 1000 ) + TimerOffset );
+}
+
+void timerWrite( hw_timer_t *timer, uint64_t value )
+{
+    TimerOffset = ( int64_t )value - ( int64_t )( ClockTime * HOST_TIMER_TICKS_PER_MS / 1000 );
+}
+
+TimerTime_t TimerGetTimerValue( void )
+{
+    ClockTime += PollCost;
+    return timerRead( timer ) / ( TimeSwitch & 0x00FFFFFF );
+}
+
+/*
+ * Timer list
+ */
+
+void TimerInit( TimerEvent_t *obj, void ( *callback )( void ) )
+{
+    obj->Timestamp = 0;
+    obj->ReloadValue = 0;
+    obj->IsRunning = false;
+    obj->Callback = callback;
+    obj->Next = NULL;
+    obj->Context = NULL;
+}
+
+void TimerStart( TimerEvent_t *obj )
+{
+    TimerEvent_t **cur = &TimerListHead;
+
+    if( ( obj == NULL ) || ( TimerExists( obj ) == true ) )
+    {
+        return;
+    }
+    obj->Timestamp = ( uint32_t )( TimerGetTimerValue( ) + obj->ReloadValue );
+    obj->IsRunning = true;
+    // Events of the same expiry run in their start order
+    while( ( *cur != NULL ) && ( ( *cur )->Timestamp <= obj->Timestamp ) )
+    {
+        cur = &( *cur )->Next;
+    }
+    obj->Next = *cur;
+    *cur = obj;
+    UpdateNextAlarm( );
+}
+
+void TimerStop( TimerEvent_t *obj )
+{
+    for( TimerEvent_t **cur = &TimerListHead; *cur != NULL; cur = &( *cur )->Next )
+    {
+        if( *cur == obj )
+        {
+            *cur = obj->Next;
+            break;
+        }
+    }
+    obj->Next = NULL;
+    obj->IsRunning = false;
+    UpdateNextAlarm( );
+}
+
+void TimerReset( TimerEvent_t *obj )
+{
+    TimerStop( obj );
+    TimerStart( obj );
+}
+
+void TimerSetValue( TimerEvent_t *obj, uint32_t value )
+{
+    TimerStop( obj );
+    obj->Timestamp = value;
+    obj->ReloadValue = value;
+}
+
+TimerTime_t TimerGetCurrentTime( void )
+{
+    return TimerGetTimerValue( );
+}
+
+TimerTime_t TimerGetElapsedTime( TimerTime_t savedTime )
+{
+    return TimerGetTimerValue( ) - savedTime;
+}
+
+TimerTime_t TimerGetFutureTime( TimerTime_t eventInFuture )
+{
+    return eventInFuture - TimerGetTimerValue( );
+}
+
+void TimerLowPowerHandler( void )
+{
+}
+
+void TimerSetContext( TimerEvent_t *obj, void *context )
+{
+    obj->Context = context;
+}
+
+void *TimerGetContext( void )
+{
+    return TimerContext;
+}
+
+void TimerIrqHandler( void )
+{
+    // A callback may start timers already due, they run in the same pass
+    while( ( TimerListHead != NULL ) && ( TimerListHead->Timestamp <= timerRead( timer ) / ( TimeSwitch & 0x00FFFFFF ) ) )
+    {
+        TimerEvent_t *obj = TimerListHead;
+
+        TimerListHead = obj->Next;
+        obj->Next = NULL;
+        obj->IsRunning = false;
+        UpdateNextAlarm( );
+        if( obj->Callback != NULL )
+        {
+            void *caller = TimerContext;
+
+            TimerContext = obj->Context;
+            obj->Callback( );
+            TimerContext = caller;
+        }
+    }
+}
+
+/*
+ * Arduino time
+ */
+
+unsigned long millis( void )
+{
+    return ( unsigned long )( ClockTime / 1000 );
+}
+
+unsigned long micros( void )
+{
+    return ( unsigned long )ClockTime;
+}
+
+void delay( uint32_t ms )
+{
+    ClockTime += ( uint64_t )ms * 1000;
+}
+
+void delayMicroseconds( uint32_t us )
+{
+    ClockTime += us;
+}
+
+uint32_t getCpuFrequencyMhz( void )
+{
+    return 240;
+}
+
+/*
+ * RTC slow clock
+ */
+
+uint64_t rtc_time_get( void )
+{
+    return ( uint64_t )( ( double )ClockTime * HOST_RTC_FREQUENCY * ( 1.0 + RtcError / 1e6 ) / 1e6 );
+}
+
+uint64_t rtc_time_slowclk_to_us( uint64_t rtc_cycles, uint32_t period )
+{
+    return ( rtc_cycles * period ) >> RTC_CLK_CAL_FRACT;
+}
+
+uint32_t rtc_clk_cal( rtc_cal_sel_t cal_clk, uint32_t slow_clk_cycles )
+{
+    ClockTime += ( uint64_t )slow_clk_cycles * 1000000 / ( uint64_t )HOST_RTC_FREQUENCY;
+    return GetRtcPeriod( );
+}
+
+uint32_t esp_clk_slowclk_cal_get( void )
+{
+    if( SlowClkCal == 0 )
+    {
+        SlowClkCal = GetRtcPeriod( );
+    }
+    return SlowClkCal;
+}
+
+void esp_clk_slowclk_cal_set( uint32_t value )
+{
+    SlowClkCal = value;
+}
+
+/*
+ * System time, kept off the host clock
+ */
+
+int gettimeofday( struct timeval *tv, void *tz )
+{
+    int64_t time = ( int64_t )ClockTime + SysTimeOffset;
+
+    tv->tv_sec = time / 1000000;
+    tv->tv_usec = time % 1000000;
+    return 0;
+}
+
+int settimeofday( const struct timeval *tv, const struct timezone *tz )
+{
+    SysTimeOffset = ( int64_t )tv->tv_sec * 1000000 + tv->tv_usec - ( int64_t )ClockTime;
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Virtual clock of the host tests. It drives the hardware timer
+             behind the timer list, the Arduino time functions and the RTC
+             slow clock.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __HOST_CLOCK_H__
+#define __HOST_CLOCK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * \brief Restarts the virtual clock at 0 with an empty timer list
+ */
+void HostClockReset( void );
+
+/*!
+ * \brief Returns the virtual time
+ *
+ * \retval time Virtual time [us]
+ */
+uint64_t HostClockGetTime( void );
+
+/*!
+ * \brief Advances the virtual time without running the timer events
+ *
+ * \param [IN] time Time to advance [us]
+ */
+void HostClockAdvance( uint64_t time );
+
+/*!
+ * \brief Advances the virtual time with the hardware timer stopped, as its
+ *        APB clock in light sleep
+ *
+ * \param [IN] time Time to advance [us]
+ */
+void HostClockGate( uint64_t time );
+
+/*!
+ * \brief Advances the virtual time, running the timer events as they become
+ *        due
+ *
+ * \param [IN] time Time to advance [us]
+ */
+void HostClockRun( uint64_t time );
+
+/*!
+ * \brief Runs the timer events until the timer list is empty or the time
+ *        limit is reached
+ *
+ * \param [IN] limit Virtual time limit [us]
+ *
+ * \retval empty true when the timer list is empty
+ */
+bool HostClockRunAll( uint64_t limit );
+
+/*!
+ * \brief Sets the virtual time taken by each read of the timer, so that the
+ *        busy waits on it end
+ *
+ * \param [IN] cost Time of a timer read [us]
+ */
+void HostClockSetPollCost( uint32_t cost );
+
+/*!
+ * \brief Sets the error of the slow clock, which its calibration measures
+ *
+ * \param [IN] ppm Slow clock frequency error [ppm]
+ */
+void HostClockSetRtcError( float ppm );
+
+#endif // __HOST_CLOCK_H__
@@ -0,0 +1,138 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Pins of the host tests, driving the Arduino GPIO functions and
+             the GPIO wake-up
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include "Arduino.h"
+#include "driver/gpio.h"
+#include "host-gpio.h"
+
+typedef struct sHostPin
+{
+    uint8_t Level;
+    uint8_t Mode;
+    gpio_int_type_t IntrType;
+    bool Wakeup;
+    void ( *Handler )( void );
+}HostPin_t;
+
+static HostPin_t Pins[HOST_GPIO_NB_PINS];
+
+static void ( *WriteHook )( uint8_t pin, uint8_t level ) = NULL;
+static void ( *ReadHook )( uint8_t pin ) = NULL;
+
+void HostGpioReset( void )
+{
+    memset( Pins, 0, sizeof( Pins ) );
+    WriteHook = NULL;
+    ReadHook = NULL;
+}
+
+void HostGpioSet( uint8_t pin, uint8_t level )
+{
+    HostPin_t *p = &Pins[pin];
+    uint8_t previous = p->Level;
+
+    p->Level = level;
+    if( ( p->Handler == NULL ) || ( previous == level ) )
+    {
+        return;
+    }
+    // Level interrupts only wake up the light sleep, they are not handled
+    if( ( ( p->IntrType == GPIO_INTR_POSEDGE ) && ( level == HIGH ) ) ||
+        ( ( p->IntrType == GPIO_INTR_NEGEDGE ) && ( level == LOW ) ) ||
+        ( p->IntrType == GPIO_INTR_ANYEDGE ) )
+    {
+        p->Handler( );
+    }
+}
+
+uint8_t HostGpioGetMode( uint8_t pin )
+{
+    return Pins[pin].Mode;
+}
+
+bool HostGpioGetWakeup( uint8_t pin )
+{
+    return Pins[pin].Wakeup;
+}
+
+void HostGpioSetWriteHook( void ( *hook )( uint8_t pin, uint8_t level ) )
+{
+    WriteHook = hook;
+}
+
+void HostGpioSetReadHook( void ( *hook )( uint8_t pin ) )
+{
+    ReadHook = hook;
+}
+
+void pinMode( uint8_t pin, uint8_t mode )
+{
+    Pins[pin].Mode = mode;
+}
+
+void digitalWrite( uint8_t pin, uint8_t value )
+{
+    Pins[pin].Level = value;
+    if( WriteHook != NULL )
+    {
+        WriteHook( pin, value );
+    }
+}
+
+int digitalRead( uint8_t pin )
+{
+    if( ReadHook != NULL )
+    {
+        ReadHook( pin );
+    }
+    return Pins[pin].Level;
+}
+
+void attachInterrupt( uint8_t pin, void ( *handler )( void ), int mode )
+{
+    Pins[pin].Handler = handler;
+    Pins[pin].IntrType = ( mode == RISING ) ? GPIO_INTR_POSEDGE :
+                         ( mode == FALLING ) ? GPIO_INTR_NEGEDGE : GPIO_INTR_ANYEDGE;
+}
+
+void detachInterrupt( uint8_t pin )
+{
+    Pins[pin].Handler = NULL;
+    Pins[pin].IntrType = GPIO_INTR_DISABLE;
+}
+
+esp_err_t gpio_wakeup_enable( gpio_num_t gpio_num, gpio_int_type_t intr_type )
+{
+    if( ( intr_type != GPIO_INTR_LOW_LEVEL ) && ( intr_type != GPIO_INTR_HIGH_LEVEL ) )
+    {
+        return ESP_FAIL;
+    }
+    Pins[gpio_num].Wakeup = true;
+    Pins[gpio_num].IntrType = intr_type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable( gpio_num_t gpio_num )
+{
+    Pins[gpio_num].Wakeup = false;
+    Pins[gpio_num].IntrType = GPIO_INTR_DISABLE;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type( gpio_num_t gpio_num, gpio_int_type_t intr_type )
+{
+    Pins[gpio_num].IntrType = intr_type;
+    return ESP_OK;
+}
@@ -0,0 +1,75 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Pins of the host tests, driving the Arduino GPIO functions and
+             the GPIO wake-up
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __HOST_GPIO_H__
+#define __HOST_GPIO_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * Pins of the ESP32
+ */
+#define HOST_GPIO_NB_PINS                           40
+
+/*!
+ * \brief Releases all the pins, low without interrupt nor wake-up
+ */
+void HostGpioReset( void );
+
+/*!
+ * \brief Drives an input pin from outside, calling its interrupt handler on
+ *        a matching edge
+ *
+ * \param [IN] pin   Pin number
+ * \param [IN] level HIGH or LOW
+ */
+void HostGpioSet( uint8_t pin, uint8_t level );
+
+/*!
+ * \brief Returns the last mode set by pinMode
+ *
+ * \param [IN] pin Pin number
+ *
+ * \retval mode Pin mode, 0 if never set
+ */
+uint8_t HostGpioGetMode( uint8_t pin );
+
+/*!
+ * \brief Checks if the pin wakes up the light sleep
+ *
+ * \param [IN] pin Pin number
+ *
+ * \retval enabled true when gpio_wakeup_enable is in effect
+ */
+bool HostGpioGetWakeup( uint8_t pin );
+
+/*!
+ * \brief Sets a hook called by digitalWrite, to emulate the devices wired to
+ *        the outputs
+ *
+ * \param [IN] hook Called with the pin and the level written
+ */
+void HostGpioSetWriteHook( void ( *hook )( uint8_t pin, uint8_t level ) );
+
+/*!
+ * \brief Sets a hook called by digitalRead before it returns the level, to
+ *        emulate the devices whose outputs change while they are polled
+ *
+ * \param [IN] hook Called with the pin read, may update it with HostGpioSet
+ */
+void HostGpioSetReadHook( void ( *hook )( uint8_t pin ) );
+
+#endif // __HOST_GPIO_H__
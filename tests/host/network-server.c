@@ -0,0 +1,879 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Network server of the host tests, the in-process counterpart
+             of tools/network_server.py on the simulated radio. The frames
+             are built and checked here from the AES and CMAC primitives,
+             apart from LoRaMacCrypto.c, so that the two sides check each
+             other. Needs aes.c built with AES_DEC_PREKEYED for the join
+             accepts.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "aes.h"
+#include "cmac.h"
+#include "utilities.h"
+#include "host-clock.h"
+#include "radio-sim.h"
+#include "network-server.h"
+
+#define MTYPE_JOIN_REQUEST                          0
+#define MTYPE_JOIN_ACCEPT                           1
+#define MTYPE_UNCONFIRMED_UP                        2
+#define MTYPE_UNCONFIRMED_DOWN                      3
+#define MTYPE_CONFIRMED_UP                          4
+
+/*!
+ * Answer delays after the end of the uplink [us]
+ */
+#define JOIN_ACCEPT_DELAY1                          5000000
+#define RECEIVE_DELAY1                              1000000
+#define RX2_EXTRA_DELAY                             1000000
+
+/*!
+ * First US915 uplink channels of 125 kHz and of 500 kHz, first downlink
+ * channel, and their spacing [Hz]
+ */
+#define US915_FIRST_UPLINK_125                      902300000
+#define US915_FIRST_UPLINK_500                      903000000
+#define US915_FIRST_DOWNLINK                        923300000
+#define US915_STEP_UPLINK_125                       200000
+#define US915_STEP_UPLINK_500                       1600000
+#define US915_STEP_DOWNLINK                         600000
+
+/*!
+ * Longest MAC answers carried in FOpts
+ */
+#define FOPTS_MAX_SIZE                              15
+
+/*!
+ * Uplink MAC commands the server takes
+ */
+#define MOTE_MAC_LINK_CHECK_REQ                     0x02
+#define MOTE_MAC_LINK_ADR_ANS                       0x03
+#define MOTE_MAC_DEVICE_TIME_REQ                    0x0D
+
+static const uint32_t CfListFrequencies[] = { 867100000, 867300000, 867500000, 867700000, 867900000 };
+
+/*!
+ * Channel plan of a region
+ */
+typedef struct sRegionPlan
+{
+    /*!
+     * Highest datarate of the ADR policy, on 125 kHz, and highest TX power
+     * index
+     */
+    uint8_t AdrMaxDatarate;
+    uint8_t AdrMaxTxPower;
+    /*!
+     * Gateway output power [dBm]
+     */
+    int8_t GatewayTxPower;
+    /*!
+     * RX2 channel: frequency, spreading factor and bandwidth index
+     */
+    uint32_t Rx2Frequency;
+    uint8_t Rx2SpreadingFactor;
+    uint8_t Rx2Bandwidth;
+}RegionPlan_t;
+
+/*!
+ * EU868: DR5 SF7BW125, TX_POWER_7, RX2 869.525 MHz SF12BW125
+ */
+static const RegionPlan_t Eu868Plan = { 5, 7, 14, 869525000, 12, 0 };
+
+/*!
+ * US915: DR3 SF7BW125, TX_POWER_10, RX2 923.3 MHz SF12BW500
+ */
+static const RegionPlan_t Us915Plan = { 3, 10, 27, 923300000, 12, 2 };
+
+/*!
+ * Application downlink
+ */
+typedef struct sDownlink
+{
+    uint8_t Port;
+    uint8_t Size;
+    uint8_t Payload[242];
+}Downlink_t;
+
+/*!
+ * Device session
+ */
+typedef struct sSession
+{
+    /*!
+     * Device identity, MSB first, and address given at join
+     */
+    uint8_t DevEui[8];
+    uint32_t DevAddr;
+    bool Joined;
+    uint8_t NwkSKey[16];
+    uint8_t AppSKey[16];
+    bool FCntUpValid;
+    uint32_t FCntUp;
+    uint32_t FCntDown;
+    float Snr[NETWORK_SERVER_ADR_HISTORY];
+    uint8_t SnrCount;
+    uint8_t SnrIndex;
+    uint8_t TxPower;
+}Session_t;
+
+static NetworkServerParams_t Params;
+static const RegionPlan_t *Plan = &Eu868Plan;
+static NetworkServerStats_t Stats;
+static Session_t Sessions[NETWORK_SERVER_MAX_DEVICES];
+static uint8_t NbSessions;
+/*!
+ * Session of the uplink being processed
+ */
+static Session_t *Session = &Sessions[0];
+/*!
+ * Application downlinks of the first device
+ */
+static Downlink_t Queue[NETWORK_SERVER_QUEUE_SIZE];
+static uint8_t QueueCount;
+static uint32_t RandomState = 1;
+
+static uint32_t NextRandom( void )
+{
+    // xorshift32
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 17;
+    RandomState ^= RandomState << 5;
+    return RandomState;
+}
+
+static float NextUniform( void )
+{
+    return ( NextRandom( ) + 1.0f ) / 4294967297.0f;
+}
+
+static void AesEncrypt( const uint8_t *key, const uint8_t *in, uint8_t *out )
+{
+    aes_context ctx;
+
+    lorawan_aes_set_key( key, 16, &ctx );
+    lora_aes_encrypt( in, out, &ctx );
+}
+
+static void AesDecrypt( const uint8_t *key, const uint8_t *in, uint8_t *out )
+{
+    aes_context ctx;
+
+    lorawan_aes_set_key( key, 16, &ctx );
+    aes_decrypt( in, out, &ctx );
+}
+
+/*!
+ * \brief Computes the 4 bytes CMAC of a B0 block, if any, and a message
+ */
+static void Cmac( const uint8_t *key, const uint8_t *b0, const uint8_t *buffer, uint16_t size, uint8_t *mic )
+{
+    AES_CMAC_CTX ctx;
+    uint8_t digest[AES_CMAC_DIGEST_LENGTH];
+
+    AES_CMAC_Init( &ctx );
+    AES_CMAC_SetKey( &ctx, key );
+    if( b0 != NULL )
+    {
+        AES_CMAC_Update( &ctx, b0, 16 );
+    }
+    AES_CMAC_Update( &ctx, buffer, size );
+    AES_CMAC_Final( digest, &ctx );
+    memcpy( mic, digest, 4 );
+}
+
+/*!
+ * \brief Returns the session of a device
+ *
+ * \param [IN] devEui  DevEui as sent in the join request, LSB first, or NULL
+ * \param [IN] devAddr Address of the device when devEui is NULL
+ *
+ * \retval session NULL for an unknown device
+ */
+static Session_t *FindSession( const uint8_t *devEui, uint32_t devAddr )
+{
+    for( uint8_t i = 0; i < NbSessions; i++ )
+    {
+        bool match = true;
+
+        for( uint8_t j = 0; ( devEui != NULL ) && ( j < 8 ); j++ )
+        {
+            match = match && ( devEui[j] == Sessions[i].DevEui[7 - j] );
+        }
+        if( ( devEui == NULL ) && ( devAddr != Sessions[i].DevAddr ) )
+        {
+            match = false;
+        }
+        if( match == true )
+        {
+            return &Sessions[i];
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * \brief Returns the application downlinks waiting for the device of the
+ *        session, only the first device has some
+ */
+static uint8_t GetQueueCount( void )
+{
+    return ( Session == &Sessions[0] ) ? QueueCount : 0;
+}
+
+/*!
+ * \brief Fills the B0 and Ai blocks of a data frame
+ */
+static void FrameBlock( uint8_t *block, uint8_t first, bool downlink, uint32_t fCnt, uint8_t last )
+{
+    memset( block, 0, 16 );
+    block[0] = first;
+    block[5] = ( downlink == true ) ? 1 : 0;
+    block[6] = Session->DevAddr & 0xFF;
+    block[7] = ( Session->DevAddr >> 8 ) & 0xFF;
+    block[8] = ( Session->DevAddr >> 16 ) & 0xFF;
+    block[9] = ( Session->DevAddr >> 24 ) & 0xFF;
+    block[10] = fCnt & 0xFF;
+    block[11] = ( fCnt >> 8 ) & 0xFF;
+    block[12] = ( fCnt >> 16 ) & 0xFF;
+    block[13] = ( fCnt >> 24 ) & 0xFF;
+    block[15] = last;
+}
+
+static void FrameMic( const uint8_t *frame, uint8_t size, bool downlink, uint32_t fCnt, uint8_t *mic )
+{
+    uint8_t b0[16];
+
+    FrameBlock( b0, 0x49, downlink, fCnt, size );
+    Cmac( Session->NwkSKey, b0, frame, size, mic );
+}
+
+/*!
+ * \brief Encrypts or decrypts a FRMPayload in place
+ */
+static void FrameCrypt( const uint8_t *key, uint8_t *buffer, uint8_t size, bool downlink, uint32_t fCnt )
+{
+    uint8_t a[16];
+    uint8_t s[16];
+
+    for( uint8_t i = 0; i < size; i += 16 )
+    {
+        FrameBlock( a, 0x01, downlink, fCnt, ( i / 16 ) + 1 );
+        AesEncrypt( key, a, s );
+        for( uint8_t j = 0; ( j < 16 ) && ( ( i + j ) < size ); j++ )
+        {
+            buffer[i + j] ^= s[j];
+        }
+    }
+}
+
+/*!
+ * \brief Returns the datarate of an uplink
+ */
+static uint8_t GetDatarate( const RadioSimPacket_t *packet )
+{
+    if( Params.Region == LORAMAC_REGION_US915 )
+    {
+        return ( packet->Bandwidth == 2 ) ? 4 : 10 - packet->Datarate;
+    }
+    return ( packet->Bandwidth == 1 ) ? 6 : 12 - packet->Datarate;
+}
+
+/*!
+ * \brief Returns the US915 channel of an uplink, 0 to 63 on 125 kHz and 64 to
+ *        71 on 500 kHz
+ */
+static uint32_t GetUs915Channel( const RadioSimPacket_t *packet )
+{
+    return ( packet->Bandwidth == 2 ) ? 64 + ( packet->Frequency - US915_FIRST_UPLINK_500 ) / US915_STEP_UPLINK_500 :
+                                        ( packet->Frequency - US915_FIRST_UPLINK_125 ) / US915_STEP_UPLINK_125;
+}
+
+/*!
+ * \brief Returns the spreading factor of a 125 kHz uplink datarate
+ */
+static uint8_t GetSpreadingFactor( uint8_t datarate )
+{
+    if( Params.Region == LORAMAC_REGION_US915 )
+    {
+        return 10 - datarate;
+    }
+    return 12 - datarate;
+}
+
+/*!
+ * \brief Returns the demodulation floor of a spreading factor [dB]
+ */
+static float GetRequiredSnr( uint8_t spreadingFactor )
+{
+    return 10.0f - 2.5f * spreadingFactor;
+}
+
+static uint64_t GetUplinkEnd( const RadioSimPacket_t *packet )
+{
+    return packet->Start + RadioSimGetLoRaTimeOnAir( packet->Datarate, packet->Bandwidth, true, packet->Size );
+}
+
+/*!
+ * \brief Puts an answer on the air in RX1 or RX2 of an uplink, unless the
+ *        loss drops it
+ */
+static void SendDownlink( const RadioSimPacket_t *uplink, const uint8_t *frame, uint8_t size, uint32_t delay )
+{
+    RadioSimPacket_t packet;
+
+    if( NextUniform( ) < Params.Loss )
+    {
+        Stats.DownlinksDropped++;
+        return;
+    }
+    memset( &packet, 0, sizeof( packet ) );
+    packet.Start = GetUplinkEnd( uplink ) + delay + Params.Offset;
+    packet.Modem = MODEM_LORA;
+    packet.Power = Plan->GatewayTxPower;
+    packet.IqInverted = true;
+    if( Params.Rx2 == true )
+    {
+        packet.Start += RX2_EXTRA_DELAY;
+        packet.Frequency = Plan->Rx2Frequency;
+        packet.Datarate = Plan->Rx2SpreadingFactor;
+        packet.Bandwidth = Plan->Rx2Bandwidth;
+    }
+    else if( Params.Region == LORAMAC_REGION_US915 )
+    {
+        // 500 kHz downlink channel of the uplink channel, RX1DROffset 0
+        packet.Frequency = US915_FIRST_DOWNLINK + ( GetUs915Channel( uplink ) % 8 ) * US915_STEP_DOWNLINK;
+        packet.Datarate = ( uplink->Bandwidth == 2 ) ? 7 : uplink->Datarate;
+        packet.Bandwidth = 2;
+    }
+    else
+    {
+        packet.Frequency = uplink->Frequency;
+        packet.Datarate = uplink->Datarate;
+        packet.Bandwidth = uplink->Bandwidth;
+    }
+    packet.Size = size;
+    memcpy( packet.Payload, frame, size );
+    RadioSimQueueDownlink( &packet );
+    Stats.Downlinks++;
+}
+
+static void OnJoinRequest( const RadioSimPacket_t *packet )
+{
+    const uint8_t *frame = packet->Payload;
+    uint8_t plain[32];
+    uint8_t accept[33];
+    uint8_t nonce[16];
+    uint8_t mic[4];
+    uint8_t size = 0;
+
+    if( packet->Size != 23 )
+    {
+        return;
+    }
+    for( uint8_t i = 0; i < 8; i++ )
+    {
+        if( frame[1 + i] != Params.AppEui[7 - i] )
+        {
+            return;
+        }
+    }
+    Session = FindSession( frame + 9, 0 );
+    if( Session == NULL )
+    {
+        return;
+    }
+    Cmac( Params.AppKey, NULL, frame, 19, mic );
+    if( memcmp( mic, frame + 19, 4 ) != 0 )
+    {
+        Stats.MicErrors++;
+        return;
+    }
+    Stats.JoinRequests++;
+
+    // AppNonce, NetID 0, DevAddr, DLSettings RX1DROffset 0 and RX2 DR0,
+    // RxDelay 1 s
+    accept[0] = MTYPE_JOIN_ACCEPT << 5;
+    plain[size++] = NextRandom( ) & 0xFF;
+    plain[size++] = NextRandom( ) & 0xFF;
+    plain[size++] = NextRandom( ) & 0xFF;
+    plain[size++] = 0;
+    plain[size++] = 0;
+    plain[size++] = 0;
+    plain[size++] = Session->DevAddr & 0xFF;
+    plain[size++] = ( Session->DevAddr >> 8 ) & 0xFF;
+    plain[size++] = ( Session->DevAddr >> 16 ) & 0xFF;
+    plain[size++] = ( Session->DevAddr >> 24 ) & 0xFF;
+    plain[size++] = 0;
+    plain[size++] = 1;
+    if( ( Params.CfList == true ) && ( Params.Region == LORAMAC_REGION_EU868 ) )
+    {
+        for( uint8_t i = 0; i < 5; i++ )
+        {
+            uint32_t frequency = CfListFrequencies[i] / 100;
+
+            plain[size++] = frequency & 0xFF;
+            plain[size++] = ( frequency >> 8 ) & 0xFF;
+            plain[size++] = ( frequency >> 16 ) & 0xFF;
+        }
+        plain[size++] = 0;
+    }
+    memcpy( accept + 1, plain, size );
+    Cmac( Params.AppKey, NULL, accept, size + 1, plain + size );
+    size += 4;
+    // The device encrypts to decrypt the join accept
+    for( uint8_t i = 0; i < size; i += 16 )
+    {
+        AesDecrypt( Params.AppKey, plain + i, accept + 1 + i );
+    }
+
+    // Session keys from AppNonce, NetID and DevNonce
+    memset( nonce, 0, sizeof( nonce ) );
+    memcpy( nonce + 1, plain, 6 );
+    memcpy( nonce + 7, frame + 17, 2 );
+    nonce[0] = 0x01;
+    AesEncrypt( Params.AppKey, nonce, Session->NwkSKey );
+    nonce[0] = 0x02;
+    AesEncrypt( Params.AppKey, nonce, Session->AppSKey );
+    Session->Joined = true;
+    Session->FCntUpValid = false;
+    Session->FCntDown = 0;
+    Session->SnrCount = 0;
+    Session->SnrIndex = 0;
+    Session->TxPower = 0;
+
+    SendDownlink( packet, accept, size + 1, JOIN_ACCEPT_DELAY1 );
+    Stats.JoinAccepts++;
+}
+
+/*!
+ * \brief Answers the MAC commands of an uplink
+ *
+ * \retval size Size of the answers
+ */
+static uint8_t ProcessMacCommands( const uint8_t *commands, uint8_t size, const RadioSimPacket_t *packet, uint8_t *answers )
+{
+    uint8_t length = 0;
+    uint8_t i = 0;
+
+    while( i < size )
+    {
+        switch( commands[i++] )
+        {
+            case MOTE_MAC_LINK_CHECK_REQ:
+            {
+                // Margin above the demodulation floor, one gateway
+                float margin = packet->Snr - GetRequiredSnr( packet->Datarate );
+
+                answers[length++] = MOTE_MAC_LINK_CHECK_REQ;
+                answers[length++] = ( margin > 0 ) ? ( uint8_t )margin : 0;
+                answers[length++] = 1;
+                Stats.LinkCheckAns++;
+                break;
+            }
+            case MOTE_MAC_DEVICE_TIME_REQ:
+            {
+                // GPS time at the end of the uplink, fractional second in
+                // 1/256 s
+                uint64_t gps = NETWORK_SERVER_GPS_START * 1000000ULL + GetUplinkEnd( packet );
+                uint32_t seconds = gps / 1000000;
+
+                answers[length++] = MOTE_MAC_DEVICE_TIME_REQ;
+                answers[length++] = seconds & 0xFF;
+                answers[length++] = ( seconds >> 8 ) & 0xFF;
+                answers[length++] = ( seconds >> 16 ) & 0xFF;
+                answers[length++] = ( seconds >> 24 ) & 0xFF;
+                answers[length++] = ( ( gps % 1000000 ) * 256 ) / 1000000;
+                Stats.DeviceTimeAns++;
+                break;
+            }
+            case MOTE_MAC_LINK_ADR_ANS:
+                if( ( commands[i] & 0x07 ) == 0x07 )
+                {
+                    Stats.LinkAdrAccepted++;
+                }
+                i++;
+                break;
+            case 0x05:
+            case 0x07:
+            case 0x0A:
+            case 0x10:
+            case 0x11:
+            case 0x13:
+                i++;
+                break;
+            case 0x06:
+                i += 2;
+                break;
+            case 0x04:
+            case 0x08:
+            case 0x09:
+            case 0x12:
+                break;
+            default:
+                // Unknown command, the rest cannot be parsed
+                return length;
+        }
+    }
+    return length;
+}
+
+/*!
+ * \brief ADR policy of tools/network_server.py: the margin of the best SNR
+ *        of the history raises the datarate, then lowers the power, 3 dB
+ *        per step
+ *
+ * \retval size Size of the LinkAdrReq, 0 when nothing changes
+ */
+static uint8_t Adr( const RadioSimPacket_t *packet, uint8_t *answers )
+{
+    uint8_t current = GetDatarate( packet );
+    uint8_t datarate = current;
+    uint8_t power = Session->TxPower;
+    float maxSnr = -100.0f;
+    int32_t steps;
+
+    Session->Snr[Session->SnrIndex] = packet->Snr;
+    Session->SnrIndex = ( Session->SnrIndex + 1 ) % NETWORK_SERVER_ADR_HISTORY;
+    if( Session->SnrCount < NETWORK_SERVER_ADR_HISTORY )
+    {
+        Session->SnrCount++;
+    }
+    if( ( Params.Adr == false ) || ( Session->SnrCount < NETWORK_SERVER_ADR_HISTORY ) || ( current > Plan->AdrMaxDatarate ) )
+    {
+        return 0;
+    }
+    for( uint8_t i = 0; i < NETWORK_SERVER_ADR_HISTORY; i++ )
+    {
+        maxSnr = MAX( maxSnr, Session->Snr[i] );
+    }
+    steps = ( int32_t )floorf( ( maxSnr - GetRequiredSnr( GetSpreadingFactor( datarate ) ) - Params.AdrMargin ) / 3.0f );
+    while( ( steps > 0 ) && ( datarate < Plan->AdrMaxDatarate ) )
+    {
+        datarate++;
+        steps--;
+    }
+    while( ( steps > 0 ) && ( power < Plan->AdrMaxTxPower ) )
+    {
+        power++;
+        steps--;
+    }
+    while( ( steps < 0 ) && ( power > 0 ) )
+    {
+        power--;
+        steps++;
+    }
+    if( ( datarate == current ) && ( power == Session->TxPower ) )
+    {
+        return 0;
+    }
+    Session->TxPower = power;
+    Session->SnrCount = 0;
+    Session->SnrIndex = 0;
+    Stats.TxPower = power;
+    Stats.LinkAdrReqs++;
+
+    answers[0] = 0x03;
+    answers[1] = ( datarate << 4 ) | power;
+    if( Params.Region == LORAMAC_REGION_US915 )
+    {
+        // Every 125 kHz channel and channels 64 - 71, NbRep 1
+        answers[2] = 0xFF;
+        answers[3] = 0x00;
+        answers[4] = 0x61;
+    }
+    else
+    {
+        // Channels 0 - 7 with the CFList, the 3 join channels otherwise, NbRep 1
+        answers[2] = ( Params.CfList == true ) ? 0xFF : 0x07;
+        answers[3] = 0x00;
+        answers[4] = 0x01;
+    }
+    return 5;
+}
+
+/*!
+ * \brief Builds and sends a data downlink with the ACK, the MAC answers and
+ *        the next application payload
+ */
+static void SendDataDownlink( const RadioSimPacket_t *uplink, bool ack, const uint8_t *answers, uint8_t answersSize )
+{
+    uint8_t frame[255];
+    uint8_t size = 0;
+    uint8_t fOptsLen = 0;
+    uint8_t fCtrl = 0x80;
+    const uint8_t *payload = NULL;
+    uint8_t payloadSize = 0;
+    int16_t port = -1;
+    const uint8_t *key = Session->AppSKey;
+
+    if( answersSize > FOPTS_MAX_SIZE )
+    {
+        // Too long for FOpts: sent on port 0, the application payload waits
+        port = 0;
+        payload = answers;
+        payloadSize = answersSize;
+        key = Session->NwkSKey;
+    }
+    else
+    {
+        fOptsLen = answersSize;
+        if( GetQueueCount( ) > 0 )
+        {
+            port = Queue[0].Port;
+            payload = Queue[0].Payload;
+            payloadSize = Queue[0].Size;
+        }
+    }
+    fCtrl |= fOptsLen;
+    if( ack == true )
+    {
+        fCtrl |= 0x20;
+        Stats.Acks++;
+    }
+    if( GetQueueCount( ) > ( ( port > 0 ) ? 1 : 0 ) )
+    {
+        fCtrl |= 0x10;
+    }
+
+    frame[size++] = MTYPE_UNCONFIRMED_DOWN << 5;
+    frame[size++] = Session->DevAddr & 0xFF;
+    frame[size++] = ( Session->DevAddr >> 8 ) & 0xFF;
+    frame[size++] = ( Session->DevAddr >> 16 ) & 0xFF;
+    frame[size++] = ( Session->DevAddr >> 24 ) & 0xFF;
+    frame[size++] = fCtrl;
+    frame[size++] = Session->FCntDown & 0xFF;
+    frame[size++] = ( Session->FCntDown >> 8 ) & 0xFF;
+    memcpy( frame + size, answers, fOptsLen );
+    size += fOptsLen;
+    if( port >= 0 )
+    {
+        frame[size++] = port;
+        memcpy( frame + size, payload, payloadSize );
+        FrameCrypt( key, frame + size, payloadSize, true, Session->FCntDown );
+        size += payloadSize;
+    }
+    FrameMic( frame, size, true, Session->FCntDown, frame + size );
+    size += 4;
+    Session->FCntDown++;
+
+    if( port > 0 )
+    {
+        QueueCount--;
+        memmove( Queue, Queue + 1, QueueCount * sizeof( Downlink_t ) );
+        Stats.DataDownlinks++;
+    }
+    SendDownlink( uplink, frame, size, RECEIVE_DELAY1 );
+}
+
+static void OnDataUplink( const RadioSimPacket_t *packet )
+{
+    const uint8_t *frame = packet->Payload;
+    uint8_t payload[255];
+    uint8_t answers[64];
+    uint8_t answersSize = 0;
+    uint32_t devAddr;
+    uint8_t fCtrl;
+    uint8_t fOptsLen;
+    uint32_t fCnt;
+    uint8_t mic[4];
+    uint8_t payloadSize;
+    bool confirmed = ( frame[0] >> 5 ) == MTYPE_CONFIRMED_UP;
+    bool repeated;
+    const uint8_t *commands;
+    uint8_t commandsSize;
+
+    if( packet->Size < 12 )
+    {
+        return;
+    }
+    devAddr = frame[1] | ( frame[2] << 8 ) | ( frame[3] << 16 ) | ( ( uint32_t )frame[4] << 24 );
+    fCtrl = frame[5];
+    fOptsLen = fCtrl & 0x0F;
+    Session = FindSession( NULL, devAddr );
+    if( ( Session == NULL ) || ( Session->Joined == false ) || ( packet->Size < ( 12 + fOptsLen ) ) )
+    {
+        return;
+    }
+
+    // 32 bits counter from its 16 LSBs
+    fCnt = frame[6] | ( frame[7] << 8 );
+    if( Session->FCntUpValid == true )
+    {
+        fCnt |= Session->FCntUp & 0xFFFF0000;
+        if( fCnt < Session->FCntUp )
+        {
+            fCnt += 0x10000;
+        }
+    }
+    FrameMic( frame, packet->Size - 4, false, fCnt, mic );
+    if( memcmp( mic, frame + packet->Size - 4, 4 ) != 0 )
+    {
+        Stats.MicErrors++;
+        return;
+    }
+    repeated = ( Session->FCntUpValid == true ) && ( fCnt == Session->FCntUp );
+    if( repeated == true )
+    {
+        if( confirmed == false )
+        {
+            return;
+        }
+        Stats.Retransmissions++;
+    }
+    else
+    {
+        Stats.Uplinks++;
+    }
+    Session->FCntUpValid = true;
+    Session->FCntUp = fCnt;
+    Stats.UplinkAirTime += GetUplinkEnd( packet ) - packet->Start;
+    Stats.Datarate = GetDatarate( packet );
+
+    commands = frame + 8;
+    commandsSize = fOptsLen;
+    payloadSize = packet->Size - 12 - fOptsLen;
+    if( payloadSize > 0 )
+    {
+        uint8_t port = frame[8 + fOptsLen];
+
+        payloadSize--;
+        memcpy( payload, frame + 9 + fOptsLen, payloadSize );
+        FrameCrypt( ( port == 0 ) ? Session->NwkSKey : Session->AppSKey, payload, payloadSize, false, fCnt );
+        if( port == 0 )
+        {
+            commands = payload;
+            commandsSize = payloadSize;
+        }
+        else if( repeated == false )
+        {
+            Stats.Delivered += payloadSize;
+            if( Params.OnData != NULL )
+            {
+                Params.OnData( port, payload, payloadSize );
+            }
+        }
+    }
+
+    answersSize = ProcessMacCommands( commands, commandsSize, packet, answers );
+    if( ( fCtrl & 0x80 ) != 0 )
+    {
+        answersSize += Adr( packet, answers + answersSize );
+    }
+    // Downlink on a confirmed uplink, MAC answers, pending data or an
+    // ADRACKReq
+    if( ( confirmed == true ) || ( answersSize > 0 ) || ( GetQueueCount( ) > 0 ) || ( ( fCtrl & 0x40 ) != 0 ) )
+    {
+        SendDataDownlink( packet, confirmed, answers, answersSize );
+    }
+}
+
+static void OnUplink( const RadioSimPacket_t *packet )
+{
+    if( ( packet->Modem != MODEM_LORA ) || ( packet->IqInverted == true ) || ( packet->Size == 0 ) )
+    {
+        return;
+    }
+    if( ( Params.Region == LORAMAC_REGION_US915 ) && ( Params.SubBand != 0 ) )
+    {
+        uint32_t channel = GetUs915Channel( packet );
+
+        // Not heard by a gateway of 8 + 1 channels
+        if( ( ( channel < 64 ) ? ( channel / 8 ) : ( channel - 64 ) ) != ( Params.SubBand - 1u ) )
+        {
+            return;
+        }
+    }
+    switch( packet->Payload[0] >> 5 )
+    {
+        case MTYPE_JOIN_REQUEST:
+            OnJoinRequest( packet );
+            break;
+        case MTYPE_UNCONFIRMED_UP:
+        case MTYPE_CONFIRMED_UP:
+            OnDataUplink( packet );
+            break;
+        default:
+            break;
+    }
+}
+
+void NetworkServerReset( const NetworkServerParams_t *params, uint32_t seed )
+{
+    Params = *params;
+    Plan = ( params->Region == LORAMAC_REGION_US915 ) ? &Us915Plan : &Eu868Plan;
+    memset( &Stats, 0, sizeof( Stats ) );
+    memset( Sessions, 0, sizeof( Sessions ) );
+    memcpy( Sessions[0].DevEui, params->DevEui, 8 );
+    Sessions[0].DevAddr = params->DevAddr;
+    NbSessions = 1;
+    Session = &Sessions[0];
+    QueueCount = 0;
+    RandomState = ( seed != 0 ) ? seed : 1;
+    RadioSimSetUplinkHandler( OnUplink );
+}
+
+bool NetworkServerQueueDownlink( uint8_t port, const uint8_t *payload, uint8_t size )
+{
+    if( ( QueueCount >= NETWORK_SERVER_QUEUE_SIZE ) || ( port == 0 ) || ( size > sizeof( Queue[0].Payload ) ) )
+    {
+        return false;
+    }
+    Queue[QueueCount].Port = port;
+    Queue[QueueCount].Size = size;
+    memcpy( Queue[QueueCount].Payload, payload, size );
+    QueueCount++;
+    return true;
+}
+
+bool NetworkServerAddDevice( const uint8_t *devEui, uint32_t devAddr )
+{
+    uint8_t lsbFirst[8];
+
+    for( uint8_t i = 0; i < 8; i++ )
+    {
+        lsbFirst[i] = devEui[7 - i];
+    }
+    if( ( NbSessions >= NETWORK_SERVER_MAX_DEVICES ) || ( FindSession( lsbFirst, 0 ) != NULL ) ||
+        ( FindSession( NULL, devAddr ) != NULL ) )
+    {
+        return false;
+    }
+    memcpy( Sessions[NbSessions].DevEui, devEui, 8 );
+    Sessions[NbSessions].DevAddr = devAddr;
+    NbSessions++;
+    return true;
+}
+
+uint64_t NetworkServerGetGpsTime( void )
+{
+    return NETWORK_SERVER_GPS_START * 1000000ULL + HostClockGetTime( );
+}
+
+void NetworkServerSetOffset( int32_t offset )
+{
+    Params.Offset = offset;
+}
+
+void NetworkServerSetLoss( float loss )
+{
+    Params.Loss = loss;
+}
+
+void NetworkServerGetStats( NetworkServerStats_t *stats )
+{
+    *stats = Stats;
+}
@@ -0,0 +1,210 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Network server of the host tests, the in-process counterpart
+             of tools/network_server.py on the simulated radio. It serves
+             EU868 or US915 end-devices: join accepts with a CFList, frame
+             MIC and encryption, ADR, DeviceTimeAns and the application
+             downlinks, answering in RX1 or RX2 with an offset and a seeded
+             loss. A US915 gateway may listen on one subband only.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __NETWORK_SERVER_H__
+#define __NETWORK_SERVER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "LoRaMac.h"
+
+/*!
+ * Devices served, the one of the parameters included
+ */
+#define NETWORK_SERVER_MAX_DEVICES                  8
+
+/*!
+ * Application downlinks waiting for the first device
+ */
+#define NETWORK_SERVER_QUEUE_SIZE                   8
+
+/*!
+ * Uplinks the ADR policy looks at, as the LoRaWAN reference ADR
+ */
+#define NETWORK_SERVER_ADR_HISTORY                  20
+
+/*!
+ * GPS time at the virtual time 0 [s]
+ */
+#define NETWORK_SERVER_GPS_START                    1300000000
+
+/*!
+ * Network server parameters
+ */
+typedef struct sNetworkServerParams
+{
+    /*!
+     * Channel plan, LORAMAC_REGION_EU868 or LORAMAC_REGION_US915
+     */
+    LoRaMacRegion_t Region;
+    /*!
+     * Device identity, MSB first as given to MLME_JOIN
+     */
+    uint8_t DevEui[8];
+    uint8_t AppEui[8];
+    uint8_t AppKey[16];
+    /*!
+     * Address given at join
+     */
+    uint32_t DevAddr;
+    /*!
+     * EU868 join accepts carry the CFList of the 867.1 - 867.9 MHz channels
+     */
+    bool CfList;
+    /*!
+     * US915 gateway listening on the 125 kHz channels and the 500 kHz
+     * channel of one subband, 1 to 8, 0 for every channel
+     */
+    uint8_t SubBand;
+    /*!
+     * Answers in RX2 instead of RX1
+     */
+    bool Rx2;
+    /*!
+     * Shift of the downlinks from the start of their window [us]
+     */
+    int32_t Offset;
+    /*!
+     * Fraction of the downlinks dropped before the air
+     */
+    float Loss;
+    /*!
+     * Enables the ADR policy
+     */
+    bool Adr;
+    /*!
+     * ADR installation margin [dB]
+     */
+    float AdrMargin;
+    /*!
+     * \brief Application data of the uplinks, called once per frame
+     *
+     * \param [IN] port    Frame port
+     * \param [IN] payload Decrypted payload
+     * \param [IN] size    Payload size
+     */
+    void ( *OnData )( uint8_t port, const uint8_t *payload, uint8_t size );
+}NetworkServerParams_t;
+
+/*!
+ * Network server statistics
+ */
+typedef struct sNetworkServerStats
+{
+    uint32_t JoinRequests;
+    /*!
+     * Join accepts put on the air
+     */
+    uint32_t JoinAccepts;
+    /*!
+     * New data uplinks, and the repetitions of confirmed ones
+     */
+    uint32_t Uplinks;
+    uint32_t Retransmissions;
+    uint32_t MicErrors;
+    /*!
+     * Downlinks put on the air, and the ones dropped by the loss
+     */
+    uint32_t Downlinks;
+    uint32_t DownlinksDropped;
+    uint32_t Acks;
+    uint32_t LinkAdrReqs;
+    /*!
+     * LinkAdrAns accepting every field
+     */
+    uint32_t LinkAdrAccepted;
+    uint32_t LinkCheckAns;
+    uint32_t DeviceTimeAns;
+    /*!
+     * Application downlinks sent
+     */
+    uint32_t DataDownlinks;
+    /*!
+     * Application bytes of the new uplinks
+     */
+    uint32_t Delivered;
+    /*!
+     * Time on air of the data uplinks, repetitions included [us]
+     */
+    uint64_t UplinkAirTime;
+    /*!
+     * Datarate of the last uplink, TX power index last requested
+     */
+    uint8_t Datarate;
+    uint8_t TxPower;
+}NetworkServerStats_t;
+
+/*!
+ * \brief Resets the server and takes the uplinks of the simulated radio
+ *
+ * \param [IN] params Server parameters, copied
+ * \param [IN] seed   Seed of the nonces and of the losses
+ */
+void NetworkServerReset( const NetworkServerParams_t *params, uint32_t seed );
+
+/*!
+ * \brief Adds a device to serve besides the one of the parameters, with the
+ *        same AppEui and AppKey and the same answers
+ *
+ * \param [IN] devEui  Device EUI, MSB first as given to MLME_JOIN
+ * \param [IN] devAddr Address given at join
+ *
+ * \retval added false when the server is full or the device already served
+ */
+bool NetworkServerAddDevice( const uint8_t *devEui, uint32_t devAddr );
+
+/*!
+ * \brief Queues an application downlink to the first device, sent with
+ *        FPending while others wait
+ *
+ * \param [IN] port    Frame port [1..223]
+ * \param [IN] payload Payload
+ * \param [IN] size    Payload size
+ *
+ * \retval queued false when the queue is full
+ */
+bool NetworkServerQueueDownlink( uint8_t port, const uint8_t *payload, uint8_t size );
+
+/*!
+ * \brief Moves the downlinks of the running session
+ *
+ * \param [IN] offset Shift of the downlinks from the start of their window [us]
+ */
+void NetworkServerSetOffset( int32_t offset );
+
+/*!
+ * \brief Changes the loss of the downlinks of the running session
+ *
+ * \param [IN] loss Fraction of the downlinks dropped before the air
+ */
+void NetworkServerSetLoss( float loss );
+
+/*!
+ * \brief Returns the network GPS time at the current virtual time [us]
+ */
+uint64_t NetworkServerGetGpsTime( void );
+
+/*!
+ * \brief Returns the statistics since the reset
+ *
+ * \param [OUT] stats Statistics
+ */
+void NetworkServerGetStats( NetworkServerStats_t *stats );
+
+#endif // __NETWORK_SERVER_H__
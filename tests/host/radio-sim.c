@@ -0,0 +1,724 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Simulated radio of the host tests. The Radio driver table runs
+             on the virtual clock, the packets go through a channel model to
+             the network side of the test.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <math.h>
+#include "Arduino.h"
+#include "timer.h"
+#include "utilities.h"
+#include "energy.h"
+#include "radio.h"
+#include "host-clock.h"
+#include "radio-sim.h"
+
+/*!
+ * Noise figure of the receivers [dB]
+ */
+#define RADIO_SIM_NOISE_FIGURE                      6
+
+/*!
+ * Preamble symbols the receiver needs to lock on a LoRa packet
+ */
+#define RADIO_SIM_LOCK_SYMBOLS                      5
+
+/*!
+ * Symbols of a CAD
+ */
+#define RADIO_SIM_CAD_SYMBOLS                       2
+
+/*!
+ * Interferer on a channel, on the air for OnTime at the start of every
+ * Period from Start
+ */
+typedef struct sRadioSimInterferer
+{
+    uint32_t Frequency;
+    int16_t Rssi;
+    uint64_t Start;
+    uint64_t OnTime;
+    uint64_t Period;
+    bool LoRa;
+}RadioSimInterferer_t;
+
+/*!
+ * Radio settings, as the drivers keep them
+ */
+typedef struct sRadioSimSettings
+{
+    RadioModems_t Modem;
+    uint32_t Frequency;
+    int8_t Power;
+    uint32_t Bandwidth;
+    uint32_t Datarate;
+    uint16_t PreambleLen;
+    uint16_t SymbTimeout;
+    bool CrcOn;
+    bool IqInverted;
+    bool RxContinuous;
+}RadioSimSettings_t;
+
+/*!
+ * DIO flags of the drivers, set by the light sleep wake-up
+ */
+bool Irq0Fired = false;
+bool Irq1Fired = false;
+
+static RadioEvents_t *RadioEvents;
+static RadioState_t Status = RF_IDLE;
+static RadioSimSettings_t TxSettings;
+static RadioSimSettings_t RxSettings;
+static uint32_t Frequency;
+static uint8_t Registers[256];
+
+/*!
+ * Packet being sent, packet being received and the downlinks on the air
+ */
+static RadioSimPacket_t TxPacket;
+static RadioSimPacket_t RxPacket;
+static RadioSimPacket_t Queue[RADIO_SIM_QUEUE_SIZE];
+static bool QueueUsed[RADIO_SIM_QUEUE_SIZE];
+
+/*!
+ * Virtual time the reception started at [us]
+ */
+static uint64_t RxStart;
+
+/*!
+ * Virtual time of the last TxDone or RxDone [us]
+ */
+static uint32_t IrqTime;
+
+static TimerEvent_t TxTimer;
+static TimerEvent_t RxTimeoutTimer;
+static TimerEvent_t RxDoneTimer;
+static TimerEvent_t CadTimer;
+
+static RadioSimInterferer_t Interferers[RADIO_SIM_MAX_INTERFERERS];
+
+static void ( *UplinkHandler )( const RadioSimPacket_t *packet ) = NULL;
+
+static float PathLoss = 100;
+static float Shadowing = 0;
+static uint8_t Gateways = 1;
+static uint32_t RandomState = 1;
+static RadioSimStats_t Stats;
+
+static uint32_t NextRandom( void )
+{
+    // xorshift32
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 17;
+    RandomState ^= RandomState << 5;
+    return RandomState;
+}
+
+static float NextUniform( void )
+{
+    return ( NextRandom( ) + 1.0f ) / 4294967297.0f;
+}
+
+static float NextGaussian( void )
+{
+    return sqrtf( -2.0f * logf( NextUniform( ) ) ) * cosf( 2.0f * ( float )M_PI * NextUniform( ) );
+}
+
+static uint32_t GetBandwidthHz( const RadioSimPacket_t *packet )
+{
+    return ( packet->Modem == MODEM_LORA ) ? ( 125000 << packet->Bandwidth ) : packet->Bandwidth;
+}
+
+/*!
+ * \brief Channel model: path loss and log-normal fading, then a reception
+ *        probability rising around the demodulation floor of the datarate
+ *
+ * \param [IN] interferer Interferer adding to the noise, NULL if none
+ *
+ * \retval received true when the packet goes through
+ */
+static bool Propagate( RadioSimPacket_t *packet, const RadioSimInterferer_t *interferer )
+{
+    float noise = -174.0f + 10.0f * log10f( GetBandwidthHz( packet ) ) + RADIO_SIM_NOISE_FIGURE;
+    float rssi = packet->Power - PathLoss + Shadowing * NextGaussian( );
+    float floorSnr = ( packet->Modem == MODEM_LORA ) ? -2.5f * ( int32_t )packet->Datarate + 10.0f : 10.0f;
+    float snr;
+
+    if( interferer != NULL )
+    {
+        noise = 10.0f * log10f( powf( 10.0f, noise / 10.0f ) + powf( 10.0f, interferer->Rssi / 10.0f ) );
+    }
+    snr = rssi - noise;
+    packet->Rssi = ( int16_t )lroundf( rssi );
+    packet->Snr = ( int8_t )lroundf( MAX( MIN( snr, 30.0f ), -30.0f ) );
+    return NextUniform( ) < ( 1.0f / ( 1.0f + expf( -1.5f * ( snr - floorSnr ) ) ) );
+}
+
+uint32_t RadioSimGetLoRaTimeOnAir( uint32_t datarate, uint32_t bandwidth, bool crcOn, uint8_t size )
+{
+    double ts = ( double )( 1 << datarate ) / ( 125000 << bandwidth );
+    bool lowDatarateOptimize = ( ( bandwidth == 0 ) && ( datarate >= 11 ) ) || ( ( bandwidth == 1 ) && ( datarate == 12 ) );
+    double tmp = ceil( ( 8.0 * size - 4.0 * datarate + 28 + ( crcOn ? 16 : 0 ) ) /
+                       ( 4.0 * ( datarate - ( lowDatarateOptimize ? 2 : 0 ) ) ) ) * 5;
+
+    return ( uint32_t )ceil( ( ( 8 + 4.25 ) + 8 + ( ( tmp > 0 ) ? tmp : 0 ) ) * ts * 1e6 );
+}
+
+static uint32_t GetTimeOnAir( const RadioSimSettings_t *settings, uint8_t size )
+{
+    if( settings->Modem == MODEM_LORA )
+    {
+        return RadioSimGetLoRaTimeOnAir( settings->Datarate, settings->Bandwidth, settings->CrcOn, size );
+    }
+    // Preamble, 3 bytes of sync word, length, payload and CRC
+    return ( uint32_t )( ( settings->PreambleLen + 3 + 1 + size + ( settings->CrcOn ? 2 : 0 ) ) * 8 * 1000000ULL / settings->Datarate );
+}
+
+static uint32_t GetSymbolTime( RadioModems_t modem, uint32_t datarate, uint32_t bandwidth )
+{
+    if( modem == MODEM_LORA )
+    {
+        return ( uint32_t )( ( 1000000ULL << datarate ) / ( 125000 << bandwidth ) );
+    }
+    return ( uint32_t )( 8000000ULL / datarate );
+}
+
+/*!
+ * \brief Starts a timer on a virtual time, rounded up to the timer resolution
+ */
+static void StartTimerAt( TimerEvent_t *obj, uint64_t time )
+{
+    uint64_t now = HostClockGetTime( );
+
+    TimerSetValue( obj, ( uint32_t )( ( time > now ) ? ( time - now + 999 ) / 1000 : 0 ) );
+    TimerStart( obj );
+}
+
+static void SetState( RadioState_t status, EnergyState_t energy )
+{
+    Status = status;
+    EnergySetRadioState( energy );
+}
+
+/*!
+ * \brief Returns the interferer on the air on the channel, NULL if none
+ */
+static const RadioSimInterferer_t* GetInterferer( uint32_t frequency )
+{
+    uint64_t now = HostClockGetTime( );
+
+    for( uint8_t i = 0; i < RADIO_SIM_MAX_INTERFERERS; i++ )
+    {
+        const RadioSimInterferer_t *interferer = &Interferers[i];
+
+        if( ( interferer->OnTime != 0 ) && ( interferer->Frequency == frequency ) && ( now >= interferer->Start ) &&
+            ( ( ( now - interferer->Start ) % interferer->Period ) < interferer->OnTime ) )
+        {
+            return interferer;
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * \brief Locks the reception on a queued downlink, if one is on the channel
+ *        and its preamble overlaps the listening time
+ */
+static void MatchReception( void )
+{
+    uint32_t symbol = GetSymbolTime( RxSettings.Modem, RxSettings.Datarate, RxSettings.Bandwidth );
+
+    for( uint8_t i = 0; i < RADIO_SIM_QUEUE_SIZE; i++ )
+    {
+        RadioSimPacket_t *packet = &Queue[i];
+        uint64_t lock = packet->Start + RADIO_SIM_LOCK_SYMBOLS * symbol;
+        uint64_t preambleEnd = packet->Start + ( uint64_t )( RxSettings.PreambleLen - RADIO_SIM_LOCK_SYMBOLS ) * symbol;
+        uint64_t rxEnd = ( ( RxSettings.RxContinuous == true ) || ( RxSettings.Modem != MODEM_LORA ) ) ? UINT64_MAX :
+                         RxStart + ( uint64_t )RxSettings.SymbTimeout * symbol;
+
+        if( ( QueueUsed[i] == false ) || ( packet->Frequency != Frequency ) || ( packet->Modem != RxSettings.Modem ) ||
+            ( packet->Datarate != RxSettings.Datarate ) || ( packet->Bandwidth != RxSettings.Bandwidth ) ||
+            ( packet->IqInverted != RxSettings.IqInverted ) )
+        {
+            continue;
+        }
+        if( ( RxStart > preambleEnd ) || ( lock > rxEnd ) )
+        {
+            continue;
+        }
+        QueueUsed[i] = false;
+        // Drowned by an interferer on the air at the node
+        if( Propagate( packet, GetInterferer( Frequency ) ) == false )
+        {
+            Stats.DownlinksLost++;
+            continue;
+        }
+        RxPacket = *packet;
+        TimerStop( &RxTimeoutTimer );
+        StartTimerAt( &RxDoneTimer, packet->Start + GetTimeOnAir( &RxSettings, packet->Size ) );
+        return;
+    }
+}
+
+/*!
+ * \brief Drops the downlinks whose preamble is over
+ */
+static void ExpireQueue( void )
+{
+    uint64_t now = HostClockGetTime( );
+
+    for( uint8_t i = 0; i < RADIO_SIM_QUEUE_SIZE; i++ )
+    {
+        RadioSimPacket_t *packet = &Queue[i];
+
+        if( ( QueueUsed[i] == true ) &&
+            ( ( packet->Start + 8 * GetSymbolTime( packet->Modem, packet->Datarate, packet->Bandwidth ) ) < now ) )
+        {
+            QueueUsed[i] = false;
+            Stats.DownlinksMissed++;
+        }
+    }
+}
+
+/*!
+ * \brief Propagates an uplink to each gateway, each with its own fading
+ *
+ * \retval received true when a gateway received it, the packet then carries
+ *                  the best reception
+ */
+static bool PropagateUplink( RadioSimPacket_t *packet )
+{
+    RadioSimPacket_t best = *packet;
+    bool received = false;
+
+    for( uint8_t i = 0; i < Gateways; i++ )
+    {
+        RadioSimPacket_t copy = *packet;
+
+        if( ( Propagate( &copy, NULL ) == true ) && ( ( received == false ) || ( copy.Snr > best.Snr ) ) )
+        {
+            best = copy;
+            received = true;
+        }
+    }
+    *packet = best;
+    return received;
+}
+
+static void OnTxDone( void )
+{
+    IrqTime = ( uint32_t )HostClockGetTime( );
+    SetState( RF_IDLE, ENERGY_STATE_RADIO_SLEEP );
+    Stats.Uplinks++;
+    if( PropagateUplink( &TxPacket ) == false )
+    {
+        Stats.UplinksLost++;
+    }
+    else if( UplinkHandler != NULL )
+    {
+        UplinkHandler( &TxPacket );
+    }
+    if( ( RadioEvents != NULL ) && ( RadioEvents->TxDone != NULL ) )
+    {
+        RadioEvents->TxDone( );
+    }
+}
+
+static void OnRxTimeout( void )
+{
+    if( RxSettings.RxContinuous == false )
+    {
+        SetState( RF_IDLE, ENERGY_STATE_RADIO_SLEEP );
+    }
+    if( ( RadioEvents != NULL ) && ( RadioEvents->RxTimeout != NULL ) )
+    {
+        RadioEvents->RxTimeout( );
+    }
+}
+
+static void OnRxDone( void )
+{
+    IrqTime = ( uint32_t )HostClockGetTime( );
+    if( RxSettings.RxContinuous == false )
+    {
+        SetState( RF_IDLE, ENERGY_STATE_RADIO_SLEEP );
+    }
+    Stats.Downlinks++;
+    if( ( RadioEvents != NULL ) && ( RadioEvents->RxDone != NULL ) )
+    {
+        RadioEvents->RxDone( RxPacket.Payload, RxPacket.Size, RxPacket.Rssi, RxPacket.Snr );
+    }
+}
+
+static void OnCadDone( void )
+{
+    const RadioSimInterferer_t *interferer = GetInterferer( Frequency );
+
+    SetState( RF_IDLE, ENERGY_STATE_RADIO_SLEEP );
+    if( ( RadioEvents != NULL ) && ( RadioEvents->CadDone != NULL ) )
+    {
+        RadioEvents->CadDone( ( interferer != NULL ) && ( interferer->LoRa == true ) );
+    }
+}
+
+void RadioSimReset( uint32_t seed )
+{
+    RadioEvents = NULL;
+    Status = RF_IDLE;
+    memset( &TxSettings, 0, sizeof( TxSettings ) );
+    memset( &RxSettings, 0, sizeof( RxSettings ) );
+    RxSettings.Modem = MODEM_LORA;
+    RxSettings.Datarate = 7;
+    RxSettings.PreambleLen = 8;
+    memset( QueueUsed, 0, sizeof( QueueUsed ) );
+    memset( &Stats, 0, sizeof( Stats ) );
+    UplinkHandler = NULL;
+    PathLoss = 100;
+    Shadowing = 0;
+    Gateways = 1;
+    RandomState = ( seed != 0 ) ? seed : 1;
+    IrqTime = 0;
+    TimerInit( &TxTimer, OnTxDone );
+    TimerInit( &RxTimeoutTimer, OnRxTimeout );
+    TimerInit( &RxDoneTimer, OnRxDone );
+    TimerInit( &CadTimer, OnCadDone );
+    memset( Interferers, 0, sizeof( Interferers ) );
+}
+
+void RadioSimSetUplinkHandler( void ( *handler )( const RadioSimPacket_t *packet ) )
+{
+    UplinkHandler = handler;
+}
+
+void RadioSimQueueDownlink( const RadioSimPacket_t *packet )
+{
+    ExpireQueue( );
+    for( uint8_t i = 0; i < RADIO_SIM_QUEUE_SIZE; i++ )
+    {
+        if( QueueUsed[i] == false )
+        {
+            Queue[i] = *packet;
+            QueueUsed[i] = true;
+            // A continuous reception may already listen on its channel
+            if( ( Status == RF_RX_RUNNING ) && ( RxDoneTimer.IsRunning == false ) )
+            {
+                MatchReception( );
+            }
+            return;
+        }
+    }
+}
+
+void RadioSimSetLink( float pathLoss, float shadowing )
+{
+    PathLoss = pathLoss;
+    Shadowing = shadowing;
+}
+
+void RadioSimSetGateways( uint8_t count )
+{
+    Gateways = MAX( count, 1 );
+}
+
+void RadioSimSetInterferer( uint32_t frequency, int16_t rssi, uint64_t onTime, uint64_t period, bool loRa )
+{
+    RadioSimInterferer_t *interferer = NULL;
+
+    for( uint8_t i = 0; i < RADIO_SIM_MAX_INTERFERERS; i++ )
+    {
+        if( ( Interferers[i].OnTime != 0 ) && ( Interferers[i].Frequency == frequency ) )
+        {
+            interferer = &Interferers[i];
+            break;
+        }
+        if( ( Interferers[i].OnTime == 0 ) && ( interferer == NULL ) )
+        {
+            interferer = &Interferers[i];
+        }
+    }
+    if( interferer == NULL )
+    {
+        return;
+    }
+    interferer->Frequency = frequency;
+    interferer->Rssi = rssi;
+    interferer->Start = HostClockGetTime( );
+    interferer->OnTime = onTime;
+    interferer->Period = MAX( period, onTime );
+    interferer->LoRa = loRa;
+}
+
+void RadioSimGetStats( RadioSimStats_t *stats )
+{
+    *stats = Stats;
+}
+
+/*
+ * Radio driver
+ */
+
+static void RadioInit( RadioEvents_t *events )
+{
+    RadioEvents = events;
+}
+
+static RadioState_t RadioGetStatus( void )
+{
+    return Status;
+}
+
+static void RadioSetModem( RadioModems_t modem )
+{
+    RxSettings.Modem = modem;
+    TxSettings.Modem = modem;
+}
+
+static void RadioSetChannel( uint32_t freq )
+{
+    Frequency = freq;
+}
+
+static bool RadioIsChannelFree( RadioModems_t modem, uint32_t freq, int16_t rssiThresh, uint32_t maxCarrierSenseTime )
+{
+    return true;
+}
+
+static uint32_t RadioRandom( void )
+{
+    return NextRandom( );
+}
+
+static void RadioSetRxConfig( RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                              uint32_t bandwidthAfc, uint16_t preambleLen, uint16_t symbTimeout, bool fixLen,
+                              uint8_t payloadLen, bool crcOn, bool freqHopOn, uint8_t hopPeriod,
+                              bool iqInverted, bool rxContinuous )
+{
+    RxSettings.Modem = modem;
+    RxSettings.Bandwidth = bandwidth;
+    RxSettings.Datarate = datarate;
+    RxSettings.PreambleLen = preambleLen;
+    RxSettings.SymbTimeout = symbTimeout;
+    RxSettings.CrcOn = crcOn;
+    RxSettings.IqInverted = iqInverted;
+    RxSettings.RxContinuous = rxContinuous;
+}
+
+static void RadioSetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev, uint32_t bandwidth, uint32_t datarate,
+                              uint8_t coderate, uint16_t preambleLen, bool fixLen, bool crcOn, bool freqHopOn,
+                              uint8_t hopPeriod, bool iqInverted, uint32_t timeout )
+{
+    TxSettings.Modem = modem;
+    TxSettings.Power = power;
+    TxSettings.Bandwidth = bandwidth;
+    TxSettings.Datarate = datarate;
+    TxSettings.PreambleLen = preambleLen;
+    TxSettings.CrcOn = crcOn;
+    TxSettings.IqInverted = iqInverted;
+    EnergySetTxPower( power );
+}
+
+static bool RadioCheckRfFrequency( uint32_t frequency )
+{
+    return true;
+}
+
+static uint32_t RadioTimeOnAir( RadioModems_t modem, uint8_t pktLen )
+{
+    RadioSimSettings_t settings = TxSettings;
+
+    settings.Modem = modem;
+    return ( GetTimeOnAir( &settings, pktLen ) + 999 ) / 1000;
+}
+
+static void RadioSend( uint8_t *buffer, uint8_t size )
+{
+    uint32_t timeOnAir = GetTimeOnAir( &TxSettings, size );
+
+    TimerStop( &RxTimeoutTimer );
+    TimerStop( &RxDoneTimer );
+    memset( &TxPacket, 0, sizeof( TxPacket ) );
+    TxPacket.Start = HostClockGetTime( );
+    TxPacket.Frequency = Frequency;
+    TxPacket.Modem = TxSettings.Modem;
+    TxPacket.Datarate = TxSettings.Datarate;
+    TxPacket.Bandwidth = TxSettings.Bandwidth;
+    TxPacket.Power = TxSettings.Power;
+    TxPacket.IqInverted = TxSettings.IqInverted;
+    TxPacket.Size = size;
+    memcpy1( TxPacket.Payload, buffer, size );
+    Stats.UplinkAirTime += ( timeOnAir + 999 ) / 1000;
+    SetState( RF_TX_RUNNING, ENERGY_STATE_RADIO_TX );
+    StartTimerAt( &TxTimer, TxPacket.Start + timeOnAir );
+}
+
+static void RadioSleep( void )
+{
+    TimerStop( &TxTimer );
+    TimerStop( &RxTimeoutTimer );
+    TimerStop( &RxDoneTimer );
+    TimerStop( &CadTimer );
+    SetState( RF_IDLE, ENERGY_STATE_RADIO_SLEEP );
+}
+
+static void RadioStandby( void )
+{
+    TimerStop( &TxTimer );
+    TimerStop( &RxTimeoutTimer );
+    TimerStop( &RxDoneTimer );
+    TimerStop( &CadTimer );
+    SetState( RF_IDLE, ENERGY_STATE_RADIO_STANDBY );
+}
+
+static void RadioRx( uint32_t timeout )
+{
+    TimerStop( &RxTimeoutTimer );
+    TimerStop( &RxDoneTimer );
+    if( timeout == 0 )
+    {
+        RxSettings.RxContinuous = true;
+    }
+    RxStart = HostClockGetTime( );
+    Stats.RxWindows++;
+    SetState( RF_RX_RUNNING, ENERGY_STATE_RADIO_RX );
+    ExpireQueue( );
+    MatchReception( );
+    if( ( RxDoneTimer.IsRunning == false ) && ( timeout != 0 ) )
+    {
+        // The LoRa modem times out on the symbol timeout of a single
+        // reception, the MCU timer on the timeout of the window, as the
+        // drivers also start it for the continuous receptions
+        uint64_t end = RxStart + ( uint64_t )timeout * 1000;
+
+        if( ( RxSettings.Modem == MODEM_LORA ) && ( RxSettings.RxContinuous == false ) )
+        {
+            end = MIN( end, RxStart + ( uint64_t )RxSettings.SymbTimeout *
+                       GetSymbolTime( RxSettings.Modem, RxSettings.Datarate, RxSettings.Bandwidth ) );
+        }
+        StartTimerAt( &RxTimeoutTimer, end );
+    }
+}
+
+static void RadioStartCad( void )
+{
+    // The CAD listens at the spreading factor of the uplinks
+    SetState( RF_CAD, ENERGY_STATE_RADIO_CAD );
+    Stats.Cads++;
+    StartTimerAt( &CadTimer, HostClockGetTime( ) + RADIO_SIM_CAD_SYMBOLS *
+                  GetSymbolTime( MODEM_LORA, TxSettings.Datarate, TxSettings.Bandwidth ) );
+}
+
+static void RadioSetTxContinuousWave( uint32_t freq, int8_t power, uint16_t time )
+{
+}
+
+static int16_t RadioRssi( RadioModems_t modem )
+{
+    const RadioSimInterferer_t *interferer = GetInterferer( Frequency );
+    int16_t noise = -174 + 51 + RADIO_SIM_NOISE_FIGURE;
+
+    Stats.RssiReads++;
+    return ( interferer != NULL ) ? MAX( interferer->Rssi, noise ) : noise;
+}
+
+static void RadioWrite( uint16_t addr, uint8_t data )
+{
+    Registers[addr & 0xFF] = data;
+}
+
+static uint8_t RadioRead( uint16_t addr )
+{
+    return Registers[addr & 0xFF];
+}
+
+static void RadioWriteBuffer( uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+    for( uint8_t i = 0; i < size; i++ )
+    {
+        RadioWrite( addr + i, buffer[i] );
+    }
+}
+
+static void RadioReadBuffer( uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+    for( uint8_t i = 0; i < size; i++ )
+    {
+        buffer[i] = RadioRead( addr + i );
+    }
+}
+
+static void RadioSetMaxPayloadLength( RadioModems_t modem, uint8_t max )
+{
+}
+
+static void RadioSetPublicNetwork( bool enable )
+{
+}
+
+static uint32_t RadioGetWakeupTime( void )
+{
+    return 1;
+}
+
+static void RadioIrqProcess( void )
+{
+}
+
+static void RadioStartCarrierSense( RadioModems_t modem, uint32_t freq )
+{
+    TimerStop( &CadTimer );
+    Frequency = freq;
+    SetState( RF_RX_RUNNING, ENERGY_STATE_RADIO_RX );
+}
+
+static uint32_t RadioGetCapabilities( void )
+{
+    return 0;
+}
+
+static uint32_t RadioGetIrqTime( void )
+{
+    return IrqTime;
+}
+
+const struct Radio_s Radio =
+{
+    .Init = RadioInit,
+    .GetStatus = RadioGetStatus,
+    .SetModem = RadioSetModem,
+    .SetChannel = RadioSetChannel,
+    .IsChannelFree = RadioIsChannelFree,
+    .Random = RadioRandom,
+    .SetRxConfig = RadioSetRxConfig,
+    .SetTxConfig = RadioSetTxConfig,
+    .CheckRfFrequency = RadioCheckRfFrequency,
+    .TimeOnAir = RadioTimeOnAir,
+    .Send = RadioSend,
+    .Sleep = RadioSleep,
+    .Standby = RadioStandby,
+    .Rx = RadioRx,
+    .StartCad = RadioStartCad,
+    .SetTxContinuousWave = RadioSetTxContinuousWave,
+    .Rssi = RadioRssi,
+    .Write = RadioWrite,
+    .Read = RadioRead,
+    .WriteBuffer = RadioWriteBuffer,
+    .ReadBuffer = RadioReadBuffer,
+    .SetMaxPayloadLength = RadioSetMaxPayloadLength,
+    .SetPublicNetwork = RadioSetPublicNetwork,
+    .GetWakeupTime = RadioGetWakeupTime,
+    .IrqProcess = RadioIrqProcess,
+    .StartCarrierSense = RadioStartCarrierSense,
+    .GetCapabilities = RadioGetCapabilities,
+    .RxBoosted = RadioRx,
+    .GetIrqTime = RadioGetIrqTime,
+};
@@ -0,0 +1,161 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Simulated radio of the host tests. The Radio driver table runs
+             on the virtual clock, the packets go through a channel model to
+             the network side of the test.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __RADIO_SIM_H__
+#define __RADIO_SIM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "radio.h"
+
+/*!
+ * Downlink packets waiting for a reception
+ */
+#define RADIO_SIM_QUEUE_SIZE                        8
+
+/*!
+ * Channels with an interferer
+ */
+#define RADIO_SIM_MAX_INTERFERERS                   8
+
+/*!
+ * Packet on the air
+ */
+typedef struct sRadioSimPacket
+{
+    /*!
+     * Virtual time of the first preamble symbol [us]
+     */
+    uint64_t Start;
+    uint32_t Frequency;
+    RadioModems_t Modem;
+    /*!
+     * LoRa spreading factor, or FSK datarate [bps]
+     */
+    uint32_t Datarate;
+    /*!
+     * LoRa bandwidth, 0: 125 kHz, 1: 250 kHz, 2: 500 kHz
+     */
+    uint32_t Bandwidth;
+    int8_t Power;
+    bool IqInverted;
+    /*!
+     * Reception quality, set by the channel model
+     */
+    int16_t Rssi;
+    int8_t Snr;
+    uint8_t Size;
+    uint8_t Payload[255];
+}RadioSimPacket_t;
+
+/*!
+ * Simulated radio statistics
+ */
+typedef struct sRadioSimStats
+{
+    uint32_t Uplinks;
+    uint32_t UplinksLost;
+    /*!
+     * Time on air of the uplinks [ms]
+     */
+    uint32_t UplinkAirTime;
+    uint32_t RxWindows;
+    uint32_t Downlinks;
+    uint32_t DownlinksLost;
+    /*!
+     * Downlinks on the air while the radio did not listen on their channel
+     */
+    uint32_t DownlinksMissed;
+    /*!
+     * RSSI measurements and CADs
+     */
+    uint32_t RssiReads;
+    uint32_t Cads;
+}RadioSimStats_t;
+
+/*!
+ * \brief Resets the radio, the channel and the statistics
+ *
+ * \param [IN] seed Seed of the radio and channel random numbers
+ */
+void RadioSimReset( uint32_t seed );
+
+/*!
+ * \brief Sets the handler of the packets sent, called at their end with the
+ *        packets going through the channel
+ *
+ * \param [IN] handler Network side of the test
+ */
+void RadioSimSetUplinkHandler( void ( *handler )( const RadioSimPacket_t *packet ) );
+
+/*!
+ * \brief Puts a downlink on the air, received if the radio listens on its
+ *        channel when its preamble starts
+ *
+ * \param [IN] packet Downlink, its Start in the future
+ */
+void RadioSimQueueDownlink( const RadioSimPacket_t *packet );
+
+/*!
+ * \brief Sets the channel model, the same both ways
+ *
+ * \param [IN] pathLoss  Path loss [dB]
+ * \param [IN] shadowing Standard deviation of the per packet fading [dB]
+ */
+void RadioSimSetLink( float pathLoss, float shadowing );
+
+/*!
+ * \brief Sets the gateways receiving the uplinks, each with its own fading
+ *        on the same path loss. The downlinks go through one of them.
+ *
+ * \param [IN] count Gateways, 1 after the reset
+ */
+void RadioSimSetGateways( uint8_t count );
+
+/*!
+ * \brief Puts an interferer on a channel, heard by the RSSI measurements,
+ *        for a LoRa one the CAD, and adding to the noise of the downlinks
+ *        received on its frequency. It is on the air for onTime at the
+ *        start of every period, counted from now.
+ *
+ * \param [IN] frequency Channel [Hz]
+ * \param [IN] rssi      RSSI of the interferer [dBm]
+ * \param [IN] onTime    Time on the air per period [us], 0 removes it
+ * \param [IN] period    Period [us], equal to onTime for a busy channel
+ * \param [IN] loRa      LoRa preambles, detected by the CAD
+ */
+void RadioSimSetInterferer( uint32_t frequency, int16_t rssi, uint64_t onTime, uint64_t period, bool loRa );
+
+/*!
+ * \brief Computes the time on air of a LoRa packet with an explicit header
+ *
+ * \param [IN] datarate  Spreading factor
+ * \param [IN] bandwidth 0: 125 kHz, 1: 250 kHz, 2: 500 kHz
+ * \param [IN] crcOn     Payload CRC, on for the uplinks
+ * \param [IN] size      Payload size
+ *
+ * \retval time Time on air [us]
+ */
+uint32_t RadioSimGetLoRaTimeOnAir( uint32_t datarate, uint32_t bandwidth, bool crcOn, uint8_t size );
+
+/*!
+ * \brief Returns the statistics since the reset
+ *
+ * \param [OUT] stats Statistics
+ */
+void RadioSimGetStats( RadioSimStats_t *stats );
+
+#endif // __RADIO_SIM_H__
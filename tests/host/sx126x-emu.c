@@ -0,0 +1,698 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: SX126x emulator of the host tests. It stands for the SPI driver
+             of spi-board.cpp, the transactions are framed by the NSS writes
+             and executed when NSS rises. BUSY is updated when it is read,
+             each read costs BUSY_POLL_COST of virtual time.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Arduino.h"
+#include "board-config.h"
+#include "timer.h"
+#include "sx126x.h"
+#include "host-clock.h"
+#include "host-gpio.h"
+#include "sx126x-emu.h"
+
+/*!
+ * Virtual time of a BUSY read [us]
+ */
+#define BUSY_POLL_COST                              1
+
+/*!
+ * BUSY polls longer than this are a dead lock of the driver [us]
+ */
+#define BUSY_STUCK_TIME                             1000000
+
+/*!
+ * BUSY time of the configuration commands, of the mode changes and of the
+ * calibrations [us]
+ */
+#define BUSY_COMMAND_TIME                           10
+#define BUSY_MODE_TIME                              100
+#define BUSY_CALIBRATE_TIME                         3500
+#define BUSY_CALIBRATE_IMAGE_TIME                   1000
+
+/*!
+ * Duration of a CAD [ms]
+ */
+#define CAD_TIME                                    1
+
+/*!
+ * Registers emulated, from 0x0000
+ */
+#define REGISTERS_SIZE                              0x1000
+
+/*!
+ * Longest transaction, a full buffer write
+ */
+#define TRANSACTION_SIZE                            ( 2 + 256 )
+
+/*!
+ * Receptions without timeout
+ */
+#define RX_SINGLE                                   0x000000
+#define RX_CONTINUOUS                               0xFFFFFF
+
+/*!
+ * Event ending the current mode
+ */
+typedef enum eEmuEvent
+{
+    EMU_EVENT_NONE,
+    EMU_EVENT_TX_DONE,
+    EMU_EVENT_TIMEOUT,
+    EMU_EVENT_CAD_DONE,
+}EmuEvent_t;
+
+typedef struct sEmu
+{
+    SX126xEmuMode_t Mode;
+    /*!
+     * NRESET low, and configuration kept by the sleep
+     */
+    bool InReset;
+    bool WarmStart;
+    uint64_t BusyUntil;
+    /*!
+     * Start of the BUSY polls, at the end of the last transaction
+     */
+    uint64_t PollStart;
+    /*!
+     * Transaction in progress
+     */
+    bool Selected;
+    bool Wakeup;
+    uint16_t Index;
+    uint8_t Tx[TRANSACTION_SIZE];
+    /*!
+     * Chip state
+     */
+    uint8_t Registers[REGISTERS_SIZE];
+    uint8_t Buffer[256];
+    uint8_t TxBase;
+    uint8_t RxBase;
+    uint8_t PacketType;
+    uint8_t PayloadLength;
+    uint32_t Frequency;
+    uint32_t TcxoTimeout;
+    uint16_t Irq;
+    uint16_t IrqMask;
+    uint16_t Dio1Mask;
+    uint8_t CadExitMode;
+    uint32_t CadTimeout;
+    bool RxContinuous;
+    /*!
+     * Last packet received
+     */
+    uint8_t RxLength;
+    int16_t Rssi;
+    int8_t Snr;
+    /*!
+     * Last packet sent
+     */
+    uint8_t Sent[256];
+    uint8_t SentLength;
+    /*!
+     * Test settings
+     */
+    uint32_t AirTime;
+    bool CadActivity;
+    EmuEvent_t Event;
+    /*!
+     * Time to the event from the end of the command [ms], set when the
+     * command starts one
+     */
+    uint32_t EventTime;
+    bool EventStarted;
+    SX126xEmuStats_t Stats;
+}Emu_t;
+
+static Emu_t Emu;
+
+/*!
+ * Timer of the event ending the current mode
+ */
+static TimerEvent_t EmuTimer;
+
+/*!
+ * \brief Sets the registers to their value after a reset
+ */
+static void ResetRegisters( void )
+{
+    memset( Emu.Registers, 0, sizeof( Emu.Registers ) );
+    Emu.Registers[REG_LR_SYNCWORD] = 0x14;
+    Emu.Registers[REG_LR_SYNCWORD + 1] = 0x24;
+    Emu.Registers[REG_RX_GAIN] = 0x94;
+    Emu.Registers[REG_OCP] = 0x38;
+}
+
+/*!
+ * \brief Drives DIO1 from the interrupts mapped to it
+ */
+static void UpdateDio1( void )
+{
+    HostGpioSet( RADIO_DIO_1, ( ( Emu.Irq & Emu.Dio1Mask ) != 0 ) ? HIGH : LOW );
+}
+
+static void RaiseIrq( uint16_t irq )
+{
+    Emu.Irq |= irq & Emu.IrqMask;
+    UpdateDio1( );
+}
+
+static void SetBusy( uint32_t time )
+{
+    Emu.BusyUntil = HostClockGetTime( ) + time;
+}
+
+/*!
+ * \brief Ends the current mode after a time. The time of a mode started by
+ *        a command runs from the end of its BUSY time.
+ *
+ * \param [IN] event Event at its end
+ * \param [IN] time  Time [ms]
+ */
+static void ScheduleEvent( EmuEvent_t event, uint32_t time )
+{
+    TimerStop( &EmuTimer );
+    Emu.Event = event;
+    Emu.EventTime = time;
+    Emu.EventStarted = true;
+}
+
+/*!
+ * \brief Starts the timer of the event scheduled
+ *
+ * \param [IN] delay Time before the mode starts [us]
+ */
+static void StartEvent( uint32_t delay )
+{
+    if( Emu.EventStarted == true )
+    {
+        Emu.EventStarted = false;
+        TimerSetValue( &EmuTimer, Emu.EventTime + ( delay + 999 ) / 1000 );
+        TimerStart( &EmuTimer );
+    }
+}
+
+static void CancelEvent( void )
+{
+    TimerStop( &EmuTimer );
+    Emu.Event = EMU_EVENT_NONE;
+    Emu.EventStarted = false;
+}
+
+/*!
+ * \brief Starts a reception
+ *
+ * \param [IN] timeout Timeout [15.625 us steps]
+ */
+static void StartRx( uint32_t timeout )
+{
+    Emu.Mode = SX126X_EMU_MODE_RX;
+    Emu.RxContinuous = ( timeout == RX_CONTINUOUS );
+    CancelEvent( );
+    if( ( timeout != RX_SINGLE ) && ( timeout != RX_CONTINUOUS ) )
+    {
+        ScheduleEvent( EMU_EVENT_TIMEOUT, ( timeout + 63 ) >> 6 );
+    }
+}
+
+static void OnEmuEvent( void )
+{
+    EmuEvent_t event = Emu.Event;
+
+    Emu.Event = EMU_EVENT_NONE;
+    switch( event )
+    {
+        case EMU_EVENT_TX_DONE:
+            Emu.Mode = SX126X_EMU_MODE_STDBY_RC;
+            Emu.SentLength = Emu.PayloadLength;
+            for( uint16_t i = 0; i < Emu.PayloadLength; i++ )
+            {
+                Emu.Sent[i] = Emu.Buffer[( uint8_t )( Emu.TxBase + i )];
+            }
+            Emu.Stats.Sent++;
+            RaiseIrq( IRQ_TX_DONE );
+            break;
+        case EMU_EVENT_TIMEOUT:
+            Emu.Mode = SX126X_EMU_MODE_STDBY_RC;
+            RaiseIrq( IRQ_RX_TX_TIMEOUT );
+            break;
+        case EMU_EVENT_CAD_DONE:
+            if( ( Emu.CadActivity == true ) && ( Emu.CadExitMode == LORA_CAD_RX ) )
+            {
+                StartRx( Emu.CadTimeout );
+                StartEvent( 0 );
+            }
+            else
+            {
+                Emu.Mode = SX126X_EMU_MODE_STDBY_RC;
+            }
+            RaiseIrq( IRQ_CAD_DONE | ( ( Emu.CadActivity == true ) ? IRQ_CAD_ACTIVITY_DETECTED : 0 ) );
+            break;
+        default:
+            break;
+    }
+}
+
+static uint8_t GetStatus( void )
+{
+    uint8_t mode = Emu.Mode;
+
+    if( ( mode == SX126X_EMU_MODE_RX_DC ) || ( mode == SX126X_EMU_MODE_CAD ) )
+    {
+        mode = SX126X_EMU_MODE_RX;
+    }
+    return ( uint8_t )( mode << 4 );
+}
+
+static uint32_t GetUint24( const uint8_t *buffer )
+{
+    return ( ( uint32_t )buffer[0] << 16 ) | ( ( uint32_t )buffer[1] << 8 ) | buffer[2];
+}
+
+/*!
+ * \brief Returns the byte clocked out of the chip during a transaction
+ *
+ * \param [IN] index Byte index, the opcode being the first
+ */
+static uint8_t GetAnswer( uint16_t index )
+{
+    uint16_t address = ( ( uint16_t )Emu.Tx[1] << 8 ) | Emu.Tx[2];
+
+    switch( Emu.Tx[0] )
+    {
+        case RADIO_READ_REGISTER:
+            if( index >= 4 )
+            {
+                return Emu.Registers[( address + index - 4 ) % REGISTERS_SIZE];
+            }
+            break;
+        case RADIO_READ_BUFFER:
+            if( index >= 3 )
+            {
+                return Emu.Buffer[( uint8_t )( Emu.Tx[1] + index - 3 )];
+            }
+            break;
+        case RADIO_GET_IRQSTATUS:
+            if( index >= 2 )
+            {
+                return ( index == 2 ) ? ( uint8_t )( Emu.Irq >> 8 ) : ( uint8_t )Emu.Irq;
+            }
+            break;
+        case RADIO_GET_RXBUFFERSTATUS:
+            if( index >= 2 )
+            {
+                return ( index == 2 ) ? Emu.RxLength : Emu.RxBase;
+            }
+            break;
+        case RADIO_GET_PACKETSTATUS:
+            if( index >= 2 )
+            {
+                return ( index == 3 ) ? ( uint8_t )( Emu.Snr * 4 ) : ( uint8_t )( -Emu.Rssi * 2 );
+            }
+            break;
+        case RADIO_GET_RSSIINST:
+            if( index >= 2 )
+            {
+                return ( uint8_t )( -Emu.Rssi * 2 );
+            }
+            break;
+        case RADIO_GET_PACKETTYPE:
+            if( index >= 2 )
+            {
+                return Emu.PacketType;
+            }
+            break;
+        case RADIO_GET_ERROR:
+        case RADIO_GET_STATS:
+            if( index >= 2 )
+            {
+                return 0;
+            }
+            break;
+        default:
+            break;
+    }
+    return GetStatus( );
+}
+
+/*!
+ * \brief Executes the transaction, when NSS rises
+ */
+static void Execute( void )
+{
+    uint8_t *tx = Emu.Tx;
+    uint16_t size = Emu.Index;
+    uint32_t busy = BUSY_COMMAND_TIME;
+    // Leaving STDBY_RC starts the TCXO first
+    uint32_t tcxo = ( Emu.Mode == SX126X_EMU_MODE_STDBY_RC ) ? ( Emu.TcxoTimeout * 15625 + 999 ) / 1000 : 0;
+
+    Emu.Stats.Commands++;
+    switch( tx[0] )
+    {
+        case RADIO_WRITE_REGISTER:
+            for( uint16_t i = 3; i < size; i++ )
+            {
+                Emu.Registers[( ( ( uint16_t )tx[1] << 8 ) + tx[2] + i - 3 ) % REGISTERS_SIZE] = tx[i];
+            }
+            break;
+        case RADIO_WRITE_BUFFER:
+            for( uint16_t i = 2; i < size; i++ )
+            {
+                Emu.Buffer[( uint8_t )( tx[1] + i - 2 )] = tx[i];
+            }
+            break;
+        case RADIO_SET_SLEEP:
+            CancelEvent( );
+            Emu.Mode = SX126X_EMU_MODE_SLEEP;
+            Emu.WarmStart = ( tx[1] & 0x04 ) != 0;
+            // BUSY stays high until the wake-up
+            Emu.BusyUntil = UINT64_MAX;
+            return;
+        case RADIO_SET_STANDBY:
+            CancelEvent( );
+            Emu.Mode = ( tx[1] == STDBY_XOSC ) ? SX126X_EMU_MODE_STDBY_XOSC : SX126X_EMU_MODE_STDBY_RC;
+            busy = BUSY_MODE_TIME + ( ( tx[1] == STDBY_XOSC ) ? tcxo : 0 );
+            break;
+        case RADIO_SET_FS:
+            Emu.Mode = SX126X_EMU_MODE_FS;
+            busy = BUSY_MODE_TIME + tcxo;
+            break;
+        case RADIO_SET_TX:
+            Emu.Mode = SX126X_EMU_MODE_TX;
+            if( ( GetUint24( tx + 1 ) != 0 ) && ( ( GetUint24( tx + 1 ) >> 6 ) < Emu.AirTime ) )
+            {
+                ScheduleEvent( EMU_EVENT_TIMEOUT, GetUint24( tx + 1 ) >> 6 );
+            }
+            else
+            {
+                ScheduleEvent( EMU_EVENT_TX_DONE, Emu.AirTime );
+            }
+            busy = BUSY_MODE_TIME + tcxo;
+            break;
+        case RADIO_SET_RX:
+            StartRx( GetUint24( tx + 1 ) );
+            busy = BUSY_MODE_TIME + tcxo;
+            break;
+        case RADIO_SET_RXDUTYCYCLE:
+            CancelEvent( );
+            Emu.Mode = SX126X_EMU_MODE_RX_DC;
+            Emu.RxContinuous = false;
+            busy = BUSY_MODE_TIME;
+            break;
+        case RADIO_SET_CAD:
+            Emu.Mode = SX126X_EMU_MODE_CAD;
+            ScheduleEvent( EMU_EVENT_CAD_DONE, CAD_TIME );
+            busy = BUSY_MODE_TIME + tcxo;
+            break;
+        case RADIO_SET_CADPARAMS:
+            Emu.CadExitMode = tx[4];
+            Emu.CadTimeout = GetUint24( tx + 5 );
+            break;
+        case RADIO_SET_TXCONTINUOUSWAVE:
+        case RADIO_SET_TXCONTINUOUSPREAMBLE:
+            CancelEvent( );
+            Emu.Mode = SX126X_EMU_MODE_TX;
+            busy = BUSY_MODE_TIME + tcxo;
+            break;
+        case RADIO_CFG_DIOIRQ:
+            Emu.IrqMask = ( ( uint16_t )tx[1] << 8 ) | tx[2];
+            Emu.Dio1Mask = ( ( uint16_t )tx[3] << 8 ) | tx[4];
+            UpdateDio1( );
+            break;
+        case RADIO_CLR_IRQSTATUS:
+            Emu.Irq &= ~( ( ( uint16_t )tx[1] << 8 ) | tx[2] );
+            UpdateDio1( );
+            break;
+        case RADIO_SET_RFFREQUENCY:
+            Emu.Frequency = ( uint32_t )( ( double )( ( ( uint32_t )tx[1] << 24 ) | ( ( uint32_t )tx[2] << 16 ) |
+                                                      ( ( uint32_t )tx[3] << 8 ) | tx[4] ) * XTAL_FREQ / ( 1 << 25 ) );
+            break;
+        case RADIO_SET_PACKETTYPE:
+            Emu.PacketType = tx[1];
+            break;
+        case RADIO_SET_PACKETPARAMS:
+            // LoRa: preamble length, header type, then payload length
+            Emu.PayloadLength = ( Emu.PacketType == PACKET_TYPE_LORA ) ? tx[4] : tx[7];
+            break;
+        case RADIO_SET_BUFFERBASEADDRESS:
+            Emu.TxBase = tx[1];
+            Emu.RxBase = tx[2];
+            break;
+        case RADIO_SET_TCXOMODE:
+            Emu.TcxoTimeout = GetUint24( tx + 2 );
+            break;
+        case RADIO_CALIBRATE:
+            busy = BUSY_CALIBRATE_TIME;
+            break;
+        case RADIO_CALIBRATEIMAGE:
+            busy = BUSY_CALIBRATE_IMAGE_TIME;
+            break;
+        case RADIO_GET_STATUS:
+        case RADIO_READ_REGISTER:
+        case RADIO_READ_BUFFER:
+        case RADIO_GET_PACKETTYPE:
+        case RADIO_GET_RXBUFFERSTATUS:
+        case RADIO_GET_PACKETSTATUS:
+        case RADIO_GET_RSSIINST:
+        case RADIO_GET_STATS:
+        case RADIO_RESET_STATS:
+        case RADIO_GET_IRQSTATUS:
+        case RADIO_GET_ERROR:
+        case RADIO_CLR_ERROR:
+        case RADIO_SET_TXPARAMS:
+        case RADIO_SET_PACONFIG:
+        case RADIO_SET_MODULATIONPARAMS:
+        case RADIO_SET_REGULATORMODE:
+        case RADIO_SET_TXFALLBACKMODE:
+        case RADIO_SET_RFSWITCHMODE:
+        case RADIO_SET_STOPRXTIMERONPREAMBLE:
+        case RADIO_SET_LORASYMBTIMEOUT:
+            break;
+        default:
+            Emu.Stats.UnknownCommands++;
+            Emu.Stats.LastViolation = tx[0];
+            break;
+    }
+    SetBusy( busy );
+    StartEvent( busy );
+}
+
+/*!
+ * \brief Wakes the chip up on the NSS falling edge
+ */
+static void Wakeup( void )
+{
+    CancelEvent( );
+    if( ( Emu.Mode == SX126X_EMU_MODE_SLEEP ) && ( Emu.WarmStart == false ) )
+    {
+        ResetRegisters( );
+    }
+    Emu.Mode = SX126X_EMU_MODE_STDBY_RC;
+    Emu.Stats.Wakeups++;
+    SetBusy( SX126X_EMU_WARM_START_TIME );
+}
+
+static void OnPinWrite( uint8_t pin, uint8_t level )
+{
+    if( pin == RADIO_RESET )
+    {
+        if( level == LOW )
+        {
+            CancelEvent( );
+            Emu.InReset = true;
+            Emu.BusyUntil = UINT64_MAX;
+        }
+        else if( Emu.InReset == true )
+        {
+            Emu.InReset = false;
+            Emu.Mode = SX126X_EMU_MODE_STDBY_RC;
+            Emu.Irq = 0;
+            Emu.IrqMask = 0;
+            Emu.Dio1Mask = 0;
+            Emu.TcxoTimeout = 0;
+            ResetRegisters( );
+            UpdateDio1( );
+            SetBusy( SX126X_EMU_RESET_TIME );
+            Emu.PollStart = HostClockGetTime( );
+        }
+        return;
+    }
+    if( pin != RADIO_NSS )
+    {
+        return;
+    }
+    if( ( level == LOW ) && ( Emu.Selected == false ) )
+    {
+        Emu.Selected = true;
+        Emu.Index = 0;
+        Emu.Wakeup = ( Emu.Mode == SX126X_EMU_MODE_SLEEP ) || ( Emu.Mode == SX126X_EMU_MODE_RX_DC );
+        if( Emu.Wakeup == true )
+        {
+            // Not executed, the chip starts when NSS falls
+            Wakeup( );
+        }
+        else if( ( Emu.InReset == true ) || ( HostClockGetTime( ) < Emu.BusyUntil ) )
+        {
+            Emu.Stats.BusyViolations++;
+            Emu.Stats.LastViolation = 0xFF;
+        }
+    }
+    else if( ( level == HIGH ) && ( Emu.Selected == true ) )
+    {
+        Emu.Selected = false;
+        Emu.PollStart = HostClockGetTime( );
+        if( ( Emu.Wakeup == false ) && ( Emu.Index > 0 ) )
+        {
+            Execute( );
+        }
+    }
+}
+
+static void OnPinRead( uint8_t pin )
+{
+    uint64_t now;
+
+    if( pin != RADIO_BUSY )
+    {
+        return;
+    }
+    HostClockAdvance( BUSY_POLL_COST );
+    now = HostClockGetTime( );
+    if( ( Emu.InReset == false ) && ( now >= Emu.BusyUntil ) )
+    {
+        HostGpioSet( RADIO_BUSY, LOW );
+        return;
+    }
+    HostGpioSet( RADIO_BUSY, HIGH );
+    if( ( now - Emu.PollStart ) > BUSY_STUCK_TIME )
+    {
+        printf( "SX126x emulator: BUSY polled for %u us, mode %u\n", BUSY_STUCK_TIME, Emu.Mode );
+        fflush( stdout );
+        abort( );
+    }
+}
+
+void SX126xEmuReset( void )
+{
+    memset( &Emu, 0, sizeof( Emu ) );
+    Emu.Mode = SX126X_EMU_MODE_STDBY_RC;
+    Emu.AirTime = 50;
+    ResetRegisters( );
+    TimerInit( &EmuTimer, OnEmuEvent );
+    HostGpioSetWriteHook( OnPinWrite );
+    HostGpioSetReadHook( OnPinRead );
+}
+
+void SX126xEmuSetAirTime( uint32_t time )
+{
+    Emu.AirTime = time;
+}
+
+void SX126xEmuSetCadActivity( bool activity )
+{
+    Emu.CadActivity = activity;
+}
+
+bool SX126xEmuReceive( const uint8_t *payload, uint8_t size, int16_t rssi, int8_t snr )
+{
+    if( ( Emu.Mode != SX126X_EMU_MODE_RX ) && ( Emu.Mode != SX126X_EMU_MODE_RX_DC ) )
+    {
+        return false;
+    }
+    for( uint16_t i = 0; i < size; i++ )
+    {
+        Emu.Buffer[( uint8_t )( Emu.RxBase + i )] = payload[i];
+    }
+    Emu.RxLength = size;
+    Emu.Rssi = rssi;
+    Emu.Snr = snr;
+    if( Emu.RxContinuous == false )
+    {
+        CancelEvent( );
+        Emu.Mode = SX126X_EMU_MODE_STDBY_RC;
+    }
+    RaiseIrq( IRQ_PREAMBLE_DETECTED | IRQ_HEADER_VALID | IRQ_RX_DONE );
+    return true;
+}
+
+SX126xEmuMode_t SX126xEmuGetMode( void )
+{
+    return Emu.Mode;
+}
+
+uint32_t SX126xEmuGetFrequency( void )
+{
+    return Emu.Frequency;
+}
+
+uint8_t SX126xEmuGetRegister( uint16_t address )
+{
+    return Emu.Registers[address % REGISTERS_SIZE];
+}
+
+const uint8_t *SX126xEmuGetSent( uint8_t *size )
+{
+    *size = Emu.SentLength;
+    return Emu.Sent;
+}
+
+void SX126xEmuGetStats( SX126xEmuStats_t *stats )
+{
+    *stats = Emu.Stats;
+}
+
+/*
+ * SPI driver of spi-board.cpp
+ */
+
+void SpiInit( Spi_t *obj, SpiId_t spiId, uint8_t mosi, uint8_t miso, uint8_t sclk, uint8_t nss )
+{
+    obj->SpiId = spiId;
+}
+
+void SpiDeInit( Spi_t *obj )
+{
+}
+
+void SpiFormat( Spi_t *obj, int8_t bits, int8_t cpol, int8_t cpha, int8_t slave )
+{
+}
+
+void SpiFrequency( Spi_t *obj, uint32_t hz )
+{
+}
+
+uint16_t SpiInOut( Spi_t *obj, uint16_t outData )
+{
+    uint8_t answer;
+
+    if( Emu.Selected == false )
+    {
+        Emu.Stats.NssViolations++;
+        return 0;
+    }
+    if( Emu.Index >= TRANSACTION_SIZE )
+    {
+        return 0;
+    }
+    Emu.Tx[Emu.Index] = ( uint8_t )outData;
+    answer = ( Emu.Index == 0 ) ? GetStatus( ) : GetAnswer( Emu.Index );
+    Emu.Index++;
+    return answer;
+}
@@ -0,0 +1,138 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: SX126x emulator of the host tests, at the command level. It
+             decodes the SPI transactions framed by NSS, drives BUSY and
+             DIO1 on the virtual clock, and counts the transactions that
+             break the BUSY handshake.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __SX126X_EMU_H__
+#define __SX126X_EMU_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * BUSY time of the startup after a reset, and of the warm start after a
+ * sleep [us]
+ */
+#define SX126X_EMU_RESET_TIME                       3500
+#define SX126X_EMU_WARM_START_TIME                  340
+
+/*!
+ * Chip modes, as in the GetStatus answer
+ */
+typedef enum eSX126xEmuMode
+{
+    SX126X_EMU_MODE_SLEEP = 0,
+    SX126X_EMU_MODE_STDBY_RC = 2,
+    SX126X_EMU_MODE_STDBY_XOSC = 3,
+    SX126X_EMU_MODE_FS = 4,
+    SX126X_EMU_MODE_RX = 5,
+    SX126X_EMU_MODE_TX = 6,
+    /*!
+     * Not reported by GetStatus, which wakes the chip up from them
+     */
+    SX126X_EMU_MODE_RX_DC = 8,
+    SX126X_EMU_MODE_CAD = 9,
+}SX126xEmuMode_t;
+
+/*!
+ * Emulator statistics
+ */
+typedef struct sSX126xEmuStats
+{
+    uint32_t Commands;
+    /*!
+     * Transactions started while BUSY was high, the wake-up ones apart
+     */
+    uint32_t BusyViolations;
+    /*!
+     * Bytes clocked while NSS was high
+     */
+    uint32_t NssViolations;
+    uint32_t UnknownCommands;
+    /*!
+     * Opcode of the last transaction in violation
+     */
+    uint8_t LastViolation;
+    /*!
+     * Wake-ups from the sleep and from the reception duty cycle
+     */
+    uint32_t Wakeups;
+    uint32_t Sent;
+}SX126xEmuStats_t;
+
+/*!
+ * \brief Powers the chip up and installs the pin hooks, the pins are the
+ *        ones of board-config.h
+ */
+void SX126xEmuReset( void );
+
+/*!
+ * \brief Sets the time on air of the packets sent
+ *
+ * \param [IN] time Time on air [ms]
+ */
+void SX126xEmuSetAirTime( uint32_t time );
+
+/*!
+ * \brief Sets the result of the next CADs
+ *
+ * \param [IN] activity true when the CADs detect a preamble
+ */
+void SX126xEmuSetCadActivity( bool activity );
+
+/*!
+ * \brief Ends a reception with a packet, as if it was on the air
+ *
+ * \param [IN] payload Packet
+ * \param [IN] size    Packet size
+ * \param [IN] rssi    Packet RSSI [dBm]
+ * \param [IN] snr     Packet SNR [dB]
+ *
+ * \retval received false when the chip is not receiving
+ */
+bool SX126xEmuReceive( const uint8_t *payload, uint8_t size, int16_t rssi, int8_t snr );
+
+/*!
+ * \brief Returns the chip mode
+ */
+SX126xEmuMode_t SX126xEmuGetMode( void );
+
+/*!
+ * \brief Returns the RF frequency set [Hz]
+ */
+uint32_t SX126xEmuGetFrequency( void );
+
+/*!
+ * \brief Returns a register value
+ */
+uint8_t SX126xEmuGetRegister( uint16_t address );
+
+/*!
+ * \brief Returns the last packet sent
+ *
+ * \param [OUT] size Packet size
+ *
+ * \retval payload Packet
+ */
+const uint8_t *SX126xEmuGetSent( uint8_t *size );
+
+/*!
+ * \brief Returns the statistics since the reset
+ *
+ * \param [OUT] stats Statistics
+ */
+void SX126xEmuGetStats( SX126xEmuStats_t *stats );
+
+#endif // __SX126X_EMU_H__
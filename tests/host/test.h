@@ -0,0 +1,55 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Checks of the host tests
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __TEST_H__
+#define __TEST_H__
+
+#include <stdio.h>
+
+/*!
+ * Failed checks of the test
+ */
+static int TestFailures = 0;
+
+/*!
+ * Checks a condition, reporting it and going on when it does not hold
+ */
+#define CHECK( condition )                                                      \
+    do                                                                          \
+    {                                                                           \
+        if( !( condition ) )                                                    \
+        {                                                                       \
+            printf( "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #condition ); \
+            TestFailures++;                                                     \
+        }                                                                       \
+    }while( 0 )
+
+/*!
+ * Runs a test case
+ */
+#define RUN( test )                                                             \
+    do                                                                          \
+    {                                                                           \
+        int failures = TestFailures;                                            \
+        test( );                                                                \
+        printf( "%s %s\n", ( failures == TestFailures ) ? "PASS" : "FAIL", #test ); \
+    }while( 0 )
+
+/*!
+ * Exit status of the test
+ */
+#define TEST_RESULT( )                                                          \
+    ( ( TestFailures == 0 ) ? 0 : 1 )
+
+#endif // __TEST_H__
@@ -0,0 +1,71 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host stand-in of the Arduino core, on the virtual clock of the
+             tests
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#ifndef __ARDUINO_H__
+#define __ARDUINO_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define HIGH                                        1
+#define LOW                                         0
+#define INPUT                                       0x01
+#define OUTPUT                                      0x02
+#define INPUT_PULLUP                                0x05
+#define RISING                                      0x01
+#define FALLING                                     0x02
+#define CHANGE                                      0x03
+
+#define digitalPinToInterrupt( pin )                ( pin )
+
+typedef uint8_t byte;
+
+/*!
+ * Hardware timer behind TimerGetTimerValue, counting the virtual clock
+ */
+typedef struct hw_timer_s hw_timer_t;
+
+uint64_t timerRead( hw_timer_t *timer );
+void timerWrite( hw_timer_t *timer, uint64_t value );
+
+unsigned long millis( void );
+unsigned long micros( void );
+void delay( uint32_t ms );
+void delayMicroseconds( uint32_t us );
+uint32_t getCpuFrequencyMhz( void );
+
+void pinMode( uint8_t pin, uint8_t mode );
+void digitalWrite( uint8_t pin, uint8_t value );
+int digitalRead( uint8_t pin );
+void attachInterrupt( uint8_t pin, void ( *handler )( void ), int mode );
+void detachInterrupt( uint8_t pin );
+
+uint32_t esp_random( void );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __ARDUINO_H__
@@ -0,0 +1,34 @@
+/*
+ * Host stand-in of the ESP-IDF GPIO wake-up, on the pins of the tests
+ */
+#ifndef __DRIVER_GPIO_H__
+#define __DRIVER_GPIO_H__
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+typedef int gpio_num_t;
+
+typedef enum
+{
+    GPIO_INTR_DISABLE = 0,
+    GPIO_INTR_POSEDGE = 1,
+    GPIO_INTR_NEGEDGE = 2,
+    GPIO_INTR_ANYEDGE = 3,
+    GPIO_INTR_LOW_LEVEL = 4,
+    GPIO_INTR_HIGH_LEVEL = 5
+}gpio_int_type_t;
+
+esp_err_t gpio_wakeup_enable( gpio_num_t gpio_num, gpio_int_type_t intr_type );
+esp_err_t gpio_wakeup_disable( gpio_num_t gpio_num );
+esp_err_t gpio_set_intr_type( gpio_num_t gpio_num, gpio_int_type_t intr_type );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __DRIVER_GPIO_H__
@@ -0,0 +1,12 @@
+/*
+ * Host stand-in of the ESP-IDF section attributes, the RTC memory is plain RAM
+ */
+#ifndef __ESP_ATTR_H__
+#define __ESP_ATTR_H__
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif // __ESP_ATTR_H__
@@ -0,0 +1,20 @@
+/*
+ * Host stand-in of the ESP-IDF slow clock calibration
+ */
+#ifndef __ESP_CLK_H__
+#define __ESP_CLK_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+uint32_t esp_clk_slowclk_cal_get( void );
+void esp_clk_slowclk_cal_set( uint32_t value );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __ESP_CLK_H__
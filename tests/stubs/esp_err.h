@@ -0,0 +1,14 @@
+/*
+ * Host stand-in of the ESP-IDF error codes
+ */
+#ifndef __ESP_ERR_H__
+#define __ESP_ERR_H__
+
+#include <stdint.h>
+
+typedef int32_t esp_err_t;
+
+#define ESP_OK                                      0
+#define ESP_FAIL                                    -1
+
+#endif // __ESP_ERR_H__
@@ -0,0 +1,41 @@
+/*
+ * Host stand-in of the ESP-IDF sleep modes, implemented by the tests which
+ * sleep
+ */
+#ifndef __ESP_SLEEP_H__
+#define __ESP_SLEEP_H__
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+typedef enum
+{
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+    ESP_SLEEP_WAKEUP_GPIO,
+    ESP_SLEEP_WAKEUP_UART
+}esp_sleep_wakeup_cause_t;
+
+typedef esp_sleep_wakeup_cause_t esp_sleep_source_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup( uint64_t time_in_us );
+esp_err_t esp_sleep_enable_gpio_wakeup( void );
+esp_err_t esp_sleep_disable_wakeup_source( esp_sleep_source_t source );
+esp_err_t esp_light_sleep_start( void );
+void esp_deep_sleep_start( void );
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause( void );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __ESP_SLEEP_H__
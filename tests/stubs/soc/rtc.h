@@ -0,0 +1,31 @@
+/*
+ * Host stand-in of the ESP-IDF RTC clock, a 150 kHz slow clock counting the
+ * virtual clock of the tests
+ */
+#ifndef __SOC_RTC_H__
+#define __SOC_RTC_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define RTC_CLK_CAL_FRACT                           19
+
+typedef enum
+{
+    RTC_CAL_RTC_MUX = 0,
+    RTC_CAL_8MD256 = 1,
+    RTC_CAL_32K_XTAL = 2
+}rtc_cal_sel_t;
+
+uint64_t rtc_time_get( void );
+uint64_t rtc_time_slowclk_to_us( uint64_t rtc_cycles, uint32_t period );
+uint32_t rtc_clk_cal( rtc_cal_sel_t cal_clk, uint32_t slow_clk_cycles );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __SOC_RTC_H__
@@ -0,0 +1,441 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: ADR convergence simulation of the MAC against the ADR policy of
+             the in-process network server, on the simulated radio and the
+             virtual clock, for each region and gateway count. The node first
+             converges close to the gateways, then the path loss steps up
+             until the ADR backoff gets it back in touch with the network:
+             MIB_ADR_STATUS gives the time, airtime and uplinks of the
+             recovery and MIB_ENERGY_STATUS the radio energy, reported per
+             byte the server received
+
+             test-adr [seeds]
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "LoRaMac.h"
+#include "LoRaMacTest.h"
+#include "board-config.h"
+#include "energy.h"
+#include "host-clock.h"
+#include "host-board.h"
+#include "radio-sim.h"
+#include "network-server.h"
+#include "test.h"
+
+/*!
+ * Application uplink period [us], and the uplinks of each phase at most
+ */
+#define UPLINK_PERIOD                               60000000ULL
+#define MAX_UPLINKS                                 1000
+
+/*!
+ * Application payload size, within the US915 DR0 maximum with the ADR
+ * answers
+ */
+#define PAYLOAD_SIZE                                6
+
+/*!
+ * Fading of the link [dB]
+ */
+#define SHADOWING                                   3.0f
+
+static uint8_t DevEui[] = { 0x00, 0x80, 0xE1, 0x15, 0x00, 0x0A, 0xB1, 0x37 };
+static uint8_t AppEui[] = { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x12, 0x34 };
+static uint8_t AppKey[] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                            0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+
+/*!
+ * Path loss step of a region and gateway count
+ */
+typedef struct sScenario
+{
+    LoRaMacRegion_t Region;
+    const char *Name;
+    uint8_t Gateways;
+    /*!
+     * Path loss before and after the step [dB]
+     */
+    float NearPathLoss;
+    float FarPathLoss;
+    /*!
+     * Highest ADR datarate of the region
+     */
+    int8_t MaxDatarate;
+}Scenario_t;
+
+/*!
+ * The far path loss is out of reach of the highest datarate at the maximum
+ * TX power, the US915 downlinks on 500 kHz needing the lowest ones
+ */
+static const Scenario_t Scenarios[] =
+{
+    { LORAMAC_REGION_EU868, "EU868", 1, 100.0f, 145.0f, DR_5 },
+    { LORAMAC_REGION_EU868, "EU868", 3, 100.0f, 145.0f, DR_5 },
+    { LORAMAC_REGION_US915, "US915", 1, 105.0f, 155.0f, DR_3 },
+    { LORAMAC_REGION_US915, "US915", 3, 105.0f, 155.0f, DR_3 },
+};
+
+/*!
+ * Results of a run
+ */
+typedef struct sRunResult
+{
+    bool Converged;
+    /*!
+     * Time and airtime from the first uplink to the highest datarate [ms]
+     */
+    uint64_t ConvergenceTime;
+    uint64_t ConvergenceAirTime;
+    bool Recovered;
+    LoRaMacAdrStatus_t AdrStatus;
+    int8_t Datarate;
+    /*!
+     * Uplinks from the step to the recovery, and the radio energy spent per
+     * byte the server received meanwhile [uJ/byte]
+     */
+    uint32_t Uplinks;
+    uint64_t EnergyPerByte;
+}RunResult_t;
+
+static uint32_t McpsConfirms;
+static McpsConfirm_t LastMcpsConfirm;
+static uint32_t MlmeConfirms;
+static MlmeConfirm_t LastMlmeConfirm;
+
+static void OnMacMcpsConfirm( McpsConfirm_t *mcpsConfirm )
+{
+    McpsConfirms++;
+    LastMcpsConfirm = *mcpsConfirm;
+}
+
+static void OnMacMcpsIndication( McpsIndication_t *mcpsIndication )
+{
+}
+
+static void OnMacMlmeConfirm( MlmeConfirm_t *mlmeConfirm )
+{
+    MlmeConfirms++;
+    LastMlmeConfirm = *mlmeConfirm;
+}
+
+static void OnMacMlmeIndication( MlmeIndication_t *mlmeIndication )
+{
+}
+
+static uint8_t GetBatteryLevel( void )
+{
+    return 128;
+}
+
+static float GetTemperatureLevel( void )
+{
+    return 25.0f;
+}
+
+static LoRaMacPrimitives_t Primitives =
+{
+    .MacMcpsConfirm = OnMacMcpsConfirm,
+    .MacMcpsIndication = OnMacMcpsIndication,
+    .MacMlmeConfirm = OnMacMlmeConfirm,
+    .MacMlmeIndication = OnMacMlmeIndication,
+};
+
+static LoRaMacCallback_t Callbacks =
+{
+    .GetBatteryLevel = GetBatteryLevel,
+    .GetTemperatureLevel = GetTemperatureLevel,
+};
+
+/*!
+ * \brief Runs the virtual clock, one event at a time, until a primitive
+ *
+ * \param [IN] count Primitive counter to wait on
+ * \param [IN] value Counter value before the wait
+ *
+ * \retval done false when nothing is left to run
+ */
+static bool RunUntil( const uint32_t *count, uint32_t value )
+{
+    while( *count == value )
+    {
+        if( ( HostClockRunAll( HostClockGetTime( ) + 1 ) == true ) && ( *count == value ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Starts a new node of a scenario, joined close to the gateways
+ *
+ * \retval joined false when the join failed
+ */
+static bool StartNode( const Scenario_t *scenario, uint32_t seed )
+{
+    NetworkServerParams_t params;
+    MibRequestConfirm_t mibReq;
+    MlmeReq_t mlmeReq;
+    uint32_t confirms = MlmeConfirms;
+
+    memset( &params, 0, sizeof( params ) );
+    params.Region = scenario->Region;
+    memcpy( params.DevEui, DevEui, sizeof( DevEui ) );
+    memcpy( params.AppEui, AppEui, sizeof( AppEui ) );
+    memcpy( params.AppKey, AppKey, sizeof( AppKey ) );
+    params.DevAddr = 0x26011F42;
+    params.CfList = true;
+    params.Adr = true;
+    params.AdrMargin = 10.0f;
+
+    HostClockReset( );
+    HostBoardReset( seed, false );
+    RadioSimReset( seed );
+    RadioSimSetLink( scenario->NearPathLoss, SHADOWING );
+    RadioSimSetGateways( scenario->Gateways );
+    NetworkServerReset( &params, seed );
+
+    // The MAC only starts over a session which is not joined
+    mibReq.Type = MIB_NETWORK_JOINED;
+    mibReq.Param.IsNetworkJoined = false;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    if( LoRaMacInitialization( &Primitives, &Callbacks, scenario->Region ) != LORAMAC_STATUS_OK )
+    {
+        return false;
+    }
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = true;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+
+    mlmeReq.Type = MLME_JOIN;
+    mlmeReq.Req.Join.DevEui = DevEui;
+    mlmeReq.Req.Join.AppEui = AppEui;
+    mlmeReq.Req.Join.AppKey = AppKey;
+    mlmeReq.Req.Join.NbTrials = 1;
+    if( ( LoRaMacMlmeRequest( &mlmeReq ) != LORAMAC_STATUS_OK ) ||
+        ( RunUntil( &MlmeConfirms, confirms ) == false ) )
+    {
+        return false;
+    }
+    return LastMlmeConfirm.Status == LORAMAC_EVENT_INFO_STATUS_OK;
+}
+
+/*!
+ * \brief Sends an unconfirmed uplink at the next application period
+ *
+ * \param [IN]  next    Time of the uplink, advanced by the period [us]
+ * \param [OUT] airTime Time on air added [ms]
+ *
+ * \retval sent false when the MAC did not confirm
+ */
+static bool SendPeriodic( uint64_t *next, uint64_t *airTime )
+{
+    uint8_t payload[PAYLOAD_SIZE] = { 0 };
+    uint32_t confirms = McpsConfirms;
+    McpsReq_t mcpsReq;
+
+    if( *next > HostClockGetTime( ) )
+    {
+        HostClockRun( *next - HostClockGetTime( ) );
+    }
+    *next += UPLINK_PERIOD;
+
+    mcpsReq.Type = MCPS_UNCONFIRMED;
+    mcpsReq.Req.Unconfirmed.fPort = 2;
+    mcpsReq.Req.Unconfirmed.fBuffer = payload;
+    mcpsReq.Req.Unconfirmed.fBufferSize = sizeof( payload );
+    mcpsReq.Req.Unconfirmed.Datarate = DR_0;
+    while( LoRaMacMcpsRequest( &mcpsReq ) == LORAMAC_STATUS_BUSY )
+    {
+        if( HostClockRunAll( HostClockGetTime( ) + 1 ) == true )
+        {
+            return false;
+        }
+    }
+    if( RunUntil( &McpsConfirms, confirms ) == false )
+    {
+        return false;
+    }
+    *airTime += LastMcpsConfirm.TxTimeOnAir;
+    return true;
+}
+
+/*!
+ * \brief Returns the energy drawn by the radio since the energy reset [uJ]
+ */
+static uint64_t GetRadioEnergy( void )
+{
+    MibRequestConfirm_t mibReq;
+    uint64_t charge = 0;
+
+    mibReq.Type = MIB_ENERGY_STATUS;
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    for( uint8_t state = ENERGY_STATE_RADIO_SLEEP; state < ENERGY_STATE_MAX; state++ )
+    {
+        charge += mibReq.Param.EnergyStatus->Charge[state];
+    }
+    return ( charge * BOARD_SUPPLY_VOLTAGE ) / 1000000;
+}
+
+static int8_t GetMibDatarate( void )
+{
+    MibRequestConfirm_t mibReq;
+
+    mibReq.Type = MIB_CHANNELS_DATARATE;
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    return mibReq.Param.ChannelsDatarate;
+}
+
+/*!
+ * \brief Converges a node close to the gateways, steps the path loss up and
+ *        waits for the backoff to recover
+ */
+static RunResult_t RunScenario( const Scenario_t *scenario, uint32_t seed )
+{
+    RunResult_t result;
+    MibRequestConfirm_t mibReq;
+    NetworkServerStats_t stats;
+    uint32_t delivered;
+    uint64_t next;
+    uint64_t start;
+    uint64_t airTime = 0;
+    uint32_t uplinks = 0;
+
+    memset( &result, 0, sizeof( result ) );
+    if( StartNode( scenario, seed ) == false )
+    {
+        return result;
+    }
+
+    // Up to the highest datarate from the slowest one
+    mibReq.Type = MIB_CHANNELS_DATARATE;
+    mibReq.Param.ChannelsDatarate = DR_0;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    start = HostClockGetTime( );
+    next = start;
+    while( ( GetMibDatarate( ) != scenario->MaxDatarate ) && ( uplinks++ < MAX_UPLINKS ) )
+    {
+        if( SendPeriodic( &next, &airTime ) == false )
+        {
+            return result;
+        }
+    }
+    result.Converged = GetMibDatarate( ) == scenario->MaxDatarate;
+    result.ConvergenceTime = ( HostClockGetTime( ) - start ) / 1000;
+    result.ConvergenceAirTime = airTime;
+
+    // Out of reach: the node backs off until a downlink comes through
+    mibReq.Type = MIB_ADR_STATUS;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_ENERGY_STATUS;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    RadioSimSetLink( scenario->FarPathLoss, SHADOWING );
+    NetworkServerGetStats( &stats );
+    delivered = stats.Delivered;
+    uplinks = 0;
+    do
+    {
+        if( SendPeriodic( &next, &airTime ) == false )
+        {
+            return result;
+        }
+        mibReq.Type = MIB_ADR_STATUS;
+        LoRaMacMibGetRequestConfirm( &mibReq );
+    }while( ( mibReq.Param.AdrStatus->EpisodeCount == 0 ) && ( uplinks++ < MAX_UPLINKS ) );
+    result.Recovered = mibReq.Param.AdrStatus->EpisodeCount != 0;
+    result.AdrStatus = *mibReq.Param.AdrStatus;
+    result.Datarate = GetMibDatarate( );
+    result.Uplinks = uplinks + 1;
+    NetworkServerGetStats( &stats );
+    result.EnergyPerByte = GetRadioEnergy( ) / MAX( stats.Delivered - delivered, 1 );
+    return result;
+}
+
+static uint32_t Seeds = 5;
+
+static void TestScenarios( void )
+{
+    for( uint8_t i = 0; i < ( sizeof( Scenarios ) / sizeof( Scenarios[0] ) ); i++ )
+    {
+        const Scenario_t *scenario = &Scenarios[i];
+        uint64_t convergenceTime = 0;
+        uint64_t convergenceAirTime = 0;
+        uint64_t recoveryTime = 0;
+        uint64_t recoveryAirTime = 0;
+        uint32_t recoveryUplinks = 0;
+        uint32_t backoffSteps = 0;
+        uint64_t energyPerByte = 0;
+        uint32_t recovered = 0;
+
+        for( uint32_t seed = 1; seed <= Seeds; seed++ )
+        {
+            RunResult_t result = RunScenario( scenario, seed );
+
+            CHECK( result.Converged == true );
+            CHECK( result.Recovered == true );
+            if( result.Recovered == false )
+            {
+                continue;
+            }
+            // The backoff had to step, and the recovery ended the episode
+            CHECK( result.AdrStatus.LastRecoveryBackoffSteps >= 1 );
+            CHECK( result.AdrStatus.BackoffActive == false );
+            CHECK( result.AdrStatus.LastRecoveryUplinks >= 1 );
+            CHECK( result.AdrStatus.LastRecoveryAirTime > 0 );
+            CHECK( result.AdrStatus.AdrAckCounter <= 1 );
+            CHECK( result.Uplinks > result.AdrStatus.LastRecoveryUplinks );
+            recovered++;
+            convergenceTime += result.ConvergenceTime;
+            convergenceAirTime += result.ConvergenceAirTime;
+            recoveryTime += result.AdrStatus.LastRecoveryTime;
+            recoveryAirTime += result.AdrStatus.LastRecoveryAirTime;
+            recoveryUplinks += result.AdrStatus.LastRecoveryUplinks;
+            backoffSteps += result.AdrStatus.LastRecoveryBackoffSteps;
+            energyPerByte += result.EnergyPerByte;
+        }
+        if( recovered != 0 )
+        {
+            printf( "%s %u gateway(s), %.0f dB: converged in %.0f s, %.0f ms on air\n", scenario->Name, scenario->Gateways,
+                    scenario->NearPathLoss, convergenceTime / ( recovered * 1e3 ), convergenceAirTime / ( double )recovered );
+            printf( "%s %u gateway(s), %.0f dB: recovered in %.0f s, %.0f ms on air, %.1f uplinks, %.1f steps, %llu uJ/byte\n",
+                    scenario->Name, scenario->Gateways, scenario->FarPathLoss, recoveryTime / ( recovered * 1e3 ),
+                    recoveryAirTime / ( double )recovered, recoveryUplinks / ( double )recovered,
+                    backoffSteps / ( double )recovered, ( unsigned long long )( energyPerByte / recovered ) );
+        }
+    }
+}
+
+static void TestDeterminism( void )
+{
+    RunResult_t first = RunScenario( &Scenarios[0], 7 );
+    RunResult_t second = RunScenario( &Scenarios[0], 7 );
+
+    CHECK( first.Recovered == true );
+    CHECK( first.ConvergenceTime == second.ConvergenceTime );
+    CHECK( first.AdrStatus.LastRecoveryTime == second.AdrStatus.LastRecoveryTime );
+    CHECK( first.AdrStatus.LastRecoveryAirTime == second.AdrStatus.LastRecoveryAirTime );
+    CHECK( first.EnergyPerByte == second.EnergyPerByte );
+}
+
+int main( int argc, char **argv )
+{
+    if( argc > 1 )
+    {
+        Seeds = strtoul( argv[1], NULL, 0 );
+    }
+
+    RUN( TestScenarios );
+    RUN( TestDeterminism );
+    return TEST_RESULT( );
+}
@@ -0,0 +1,518 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host test of several MAC contexts on the one simulated radio,
+             more than the 4 of the per slot timer callbacks, against the
+             in-process network server: interleaved joins and confirmed
+             uplinks with the BUSY arbitration, the radio events and the
+             timers going to their own context, a context waiting for its
+             duty cycle credits holding the radio, and the duty cycle
+             records of each slot across a new initialization
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "LoRaMac.h"
+#include "LoRaMacCtx.h"
+#include "host-clock.h"
+#include "host-board.h"
+#include "radio-sim.h"
+#include "network-server.h"
+#include "test.h"
+
+/*!
+ * Devices, the default context included, LORAMAC_MAX_CONTEXTS of the target
+ */
+#define NB_DEVICES                                  6
+
+/*!
+ * Confirmed uplinks of each device
+ */
+#define UPLINKS                                     4
+
+/*!
+ * Wait of an uplink out of duty cycle credits, at least [us]
+ */
+#define DELAYED_MIN                                 10000000ULL
+
+/*!
+ * Longest run of the virtual clock [us]
+ */
+#define WAIT_LIMIT                                  ( 3600ULL * 1000000 )
+
+static uint8_t AppEui[] = { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x12, 0x34 };
+static uint8_t AppKey[] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                            0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+
+/*!
+ * Device state seen by the application
+ */
+typedef struct sDevice
+{
+    LoRaMacCtx_t *Ctx;
+    uint8_t DevEui[8];
+    uint32_t DevAddr;
+    uint32_t McpsConfirms;
+    uint32_t MlmeConfirms;
+    McpsConfirm_t McpsConfirm;
+    MlmeConfirm_t MlmeConfirm;
+    /*!
+     * Confirms without ACK, requests refused with LORAMAC_STATUS_BUSY
+     */
+    uint32_t Unacknowledged;
+    uint32_t Busy;
+    /*!
+     * Uplinks of the device the server delivered
+     */
+    uint32_t Delivered;
+}Device_t;
+
+static LoRaMacCtx_t ExtraCtx[NB_DEVICES - 1];
+static Device_t Devices[NB_DEVICES];
+
+static void OnMcpsConfirm( Device_t *device, McpsConfirm_t *mcpsConfirm )
+{
+    device->McpsConfirms++;
+    device->McpsConfirm = *mcpsConfirm;
+    if( mcpsConfirm->AckReceived == false )
+    {
+        device->Unacknowledged++;
+    }
+}
+
+static void OnMlmeConfirm( Device_t *device, MlmeConfirm_t *mlmeConfirm )
+{
+    device->MlmeConfirms++;
+    device->MlmeConfirm = *mlmeConfirm;
+}
+
+static void OnMacMcpsIndication( McpsIndication_t *mcpsIndication )
+{
+}
+
+static void OnMacMlmeIndication( MlmeIndication_t *mlmeIndication )
+{
+}
+
+/*!
+ * The primitives take no context, each device has its own
+ */
+#define DEVICE_PRIMITIVES( n )                                                \
+    static void OnMacMcpsConfirm##n( McpsConfirm_t *mcpsConfirm )             \
+    {                                                                         \
+        OnMcpsConfirm( &Devices[n], mcpsConfirm );                            \
+    }                                                                         \
+    static void OnMacMlmeConfirm##n( MlmeConfirm_t *mlmeConfirm )             \
+    {                                                                         \
+        OnMlmeConfirm( &Devices[n], mlmeConfirm );                            \
+    }
+
+#define DEVICE_PRIMITIVES_INIT( n )                                           \
+    { OnMacMcpsConfirm##n, OnMacMcpsIndication, OnMacMlmeConfirm##n, OnMacMlmeIndication }
+
+DEVICE_PRIMITIVES( 0 )
+DEVICE_PRIMITIVES( 1 )
+DEVICE_PRIMITIVES( 2 )
+DEVICE_PRIMITIVES( 3 )
+DEVICE_PRIMITIVES( 4 )
+DEVICE_PRIMITIVES( 5 )
+
+static LoRaMacPrimitives_t Primitives[NB_DEVICES] =
+{
+    DEVICE_PRIMITIVES_INIT( 0 ),
+    DEVICE_PRIMITIVES_INIT( 1 ),
+    DEVICE_PRIMITIVES_INIT( 2 ),
+    DEVICE_PRIMITIVES_INIT( 3 ),
+    DEVICE_PRIMITIVES_INIT( 4 ),
+    DEVICE_PRIMITIVES_INIT( 5 ),
+};
+
+static LoRaMacCallback_t Callbacks;
+
+/*!
+ * \brief Application data of the server, the first byte is the device
+ */
+static void OnServerData( uint8_t port, const uint8_t *payload, uint8_t size )
+{
+    if( ( size > 0 ) && ( payload[0] < NB_DEVICES ) )
+    {
+        Devices[payload[0]].Delivered++;
+    }
+}
+
+/*!
+ * \brief Initializes the devices, not joined, on the default context and
+ *        NB_DEVICES - 1 others, and the server of all of them
+ */
+static void Setup( void )
+{
+    NetworkServerParams_t params;
+    MibRequestConfirm_t mibReq;
+
+    HostClockReset( );
+    HostBoardReset( 1, false );
+    RadioSimReset( 1 );
+    RadioSimSetLink( 110.0f, 0.0f );
+    memset( Devices, 0, sizeof( Devices ) );
+    memset( ExtraCtx, 0, sizeof( ExtraCtx ) );
+    for( uint8_t i = 0; i < NB_DEVICES; i++ )
+    {
+        Devices[i].Ctx = ( i == 0 ) ? &LoRaMacDefaultCtx : &ExtraCtx[i - 1];
+        Devices[i].DevEui[0] = 0x00;
+        Devices[i].DevEui[1] = 0x80;
+        Devices[i].DevEui[7] = i + 1;
+        Devices[i].DevAddr = 0x26011F40 + i;
+    }
+
+    memset( &params, 0, sizeof( params ) );
+    params.Region = LORAMAC_REGION_EU868;
+    memcpy( params.DevEui, Devices[0].DevEui, 8 );
+    memcpy( params.AppEui, AppEui, sizeof( AppEui ) );
+    memcpy( params.AppKey, AppKey, sizeof( AppKey ) );
+    params.DevAddr = Devices[0].DevAddr;
+    params.OnData = OnServerData;
+    NetworkServerReset( &params, 1 );
+    for( uint8_t i = 1; i < NB_DEVICES; i++ )
+    {
+        CHECK( NetworkServerAddDevice( Devices[i].DevEui, Devices[i].DevAddr ) == true );
+    }
+
+    for( uint8_t i = 0; i < NB_DEVICES; i++ )
+    {
+        // The MAC only starts over a session which is not joined
+        mibReq.Type = MIB_NETWORK_JOINED;
+        mibReq.Param.IsNetworkJoined = false;
+        LoRaMacCtxMibSetRequestConfirm( Devices[i].Ctx, &mibReq );
+        CHECK( LoRaMacCtxInitialization( Devices[i].Ctx, &Primitives[i], &Callbacks,
+                                         LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_OK );
+        mibReq.Type = MIB_ADR;
+        mibReq.Param.AdrEnable = false;
+        LoRaMacCtxMibSetRequestConfirm( Devices[i].Ctx, &mibReq );
+    }
+}
+
+/*!
+ * \brief Returns the devices without a confirm more than given
+ */
+static uint8_t GetPending( const uint32_t *confirms, bool mlme )
+{
+    uint8_t pending = 0;
+
+    for( uint8_t i = 0; i < NB_DEVICES; i++ )
+    {
+        if( ( ( mlme == true ) ? Devices[i].MlmeConfirms : Devices[i].McpsConfirms ) == confirms[i] )
+        {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+/*!
+ * \brief Runs the virtual clock one event at a time until every device has
+ *        a confirm more, each one requesting again while it gets BUSY
+ *
+ * \param [IN] request Request of a device, returns its status
+ * \param [IN] mlme    Waits on the MLME confirms instead of the MCPS ones
+ *
+ * \retval done false when a request failed or the wait went over WAIT_LIMIT
+ */
+static bool RunAll( LoRaMacStatus_t ( *request )( Device_t *device ), bool mlme )
+{
+    uint64_t limit = HostClockGetTime( ) + WAIT_LIMIT;
+    uint32_t confirms[NB_DEVICES];
+    bool requested[NB_DEVICES] = { false };
+    bool idle;
+
+    for( uint8_t i = 0; i < NB_DEVICES; i++ )
+    {
+        confirms[i] = ( mlme == true ) ? Devices[i].MlmeConfirms : Devices[i].McpsConfirms;
+    }
+    while( GetPending( confirms, mlme ) > 0 )
+    {
+        idle = true;
+        for( uint8_t i = 0; i < NB_DEVICES; i++ )
+        {
+            if( requested[i] == false )
+            {
+                LoRaMacStatus_t status = request( &Devices[i] );
+
+                if( ( status != LORAMAC_STATUS_OK ) && ( status != LORAMAC_STATUS_BUSY ) )
+                {
+                    return false;
+                }
+                requested[i] = ( status == LORAMAC_STATUS_OK );
+                Devices[i].Busy += ( status == LORAMAC_STATUS_BUSY ) ? 1 : 0;
+            }
+            idle = idle && requested[i];
+        }
+        if( ( HostClockRunAll( HostClockGetTime( ) + 1 ) == true ) && ( idle == true ) )
+        {
+            // Nothing left to run
+            return GetPending( confirms, mlme ) == 0;
+        }
+        if( HostClockGetTime( ) >= limit )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static LoRaMacStatus_t JoinRequest( Device_t *device )
+{
+    MlmeReq_t mlmeReq;
+
+    mlmeReq.Type = MLME_JOIN;
+    mlmeReq.Req.Join.DevEui = device->DevEui;
+    mlmeReq.Req.Join.AppEui = AppEui;
+    mlmeReq.Req.Join.AppKey = AppKey;
+    mlmeReq.Req.Join.NbTrials = 1;
+    return LoRaMacCtxMlmeRequest( device->Ctx, &mlmeReq );
+}
+
+static LoRaMacStatus_t ConfirmedRequest( Device_t *device )
+{
+    uint8_t payload[4] = { device - Devices, 1, 2, 3 };
+    McpsReq_t mcpsReq;
+
+    mcpsReq.Type = MCPS_CONFIRMED;
+    mcpsReq.Req.Confirmed.fPort = 2;
+    mcpsReq.Req.Confirmed.fBuffer = payload;
+    mcpsReq.Req.Confirmed.fBufferSize = sizeof( payload );
+    mcpsReq.Req.Confirmed.NbTrials = 8;
+    mcpsReq.Req.Confirmed.Datarate = DR_5;
+    return LoRaMacCtxMcpsRequest( device->Ctx, &mcpsReq );
+}
+
+/*!
+ * \brief Joins every device, each one retrying while another one has the
+ *        radio
+ */
+static bool JoinAll( void )
+{
+    if( RunAll( JoinRequest, true ) == false )
+    {
+        return false;
+    }
+    for( uint8_t i = 0; i < NB_DEVICES; i++ )
+    {
+        if( Devices[i].MlmeConfirm.Status != LORAMAC_EVENT_INFO_STATUS_OK )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Returns the band credits of a device, summed over its bands [ms]
+ */
+static int64_t GetCredits( const Device_t *device )
+{
+    int64_t credits = 0;
+
+    for( uint8_t i = 0; i < REGION_CTX_MAX_NB_BANDS; i++ )
+    {
+        credits += device->Ctx->Region.Bands[i].TimeCredits;
+    }
+    return credits;
+}
+
+static void TestSlots( void )
+{
+    LoRaMacCtx_t extra;
+
+    Setup( );
+    // Every slot is taken, a context initialized again keeps its own
+    memset( &extra, 0, sizeof( extra ) );
+    CHECK( LoRaMacCtxInitialization( &extra, &Primitives[0], &Callbacks, LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_BUSY );
+    CHECK( LoRaMacCtxInitialization( Devices[NB_DEVICES - 1].Ctx, &Primitives[NB_DEVICES - 1], &Callbacks,
+                                     LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_OK );
+}
+
+static void TestJoin( void )
+{
+    NetworkServerStats_t stats;
+    MibRequestConfirm_t mibReq;
+    uint32_t busy = 0;
+
+    Setup( );
+    CHECK( JoinAll( ) == true );
+    NetworkServerGetStats( &stats );
+    CHECK( stats.JoinAccepts == NB_DEVICES );
+    CHECK( stats.MicErrors == 0 );
+    for( uint8_t i = 0; i < NB_DEVICES; i++ )
+    {
+        // Each join accept went to the context that sent the request
+        CHECK( Devices[i].MlmeConfirms == 1 );
+        mibReq.Type = MIB_DEV_ADDR;
+        LoRaMacCtxMibGetRequestConfirm( Devices[i].Ctx, &mibReq );
+        CHECK( mibReq.Param.DevAddr == Devices[i].DevAddr );
+        mibReq.Type = MIB_NETWORK_JOINED;
+        LoRaMacCtxMibGetRequestConfirm( Devices[i].Ctx, &mibReq );
+        CHECK( mibReq.Param.IsNetworkJoined == true );
+        busy += Devices[i].Busy;
+    }
+    // The first request went through, the others waited for the radio
+    CHECK( Devices[0].Busy == 0 );
+    CHECK( busy >= ( NB_DEVICES - 1 ) );
+}
+
+static void TestUplinks( void )
+{
+    NetworkServerStats_t stats;
+    uint32_t busy = 0;
+
+    Setup( );
+    CHECK( JoinAll( ) == true );
+    for( uint8_t i = 0; i < NB_DEVICES; i++ )
+    {
+        Devices[i].Busy = 0;
+    }
+    for( uint8_t n = 0; n < UPLINKS; n++ )
+    {
+        CHECK( RunAll( ConfirmedRequest, false ) == true );
+    }
+    NetworkServerGetStats( &stats );
+    CHECK( stats.MicErrors == 0 );
+    CHECK( stats.Uplinks == ( NB_DEVICES * UPLINKS ) );
+    for( uint8_t i = 0; i < NB_DEVICES; i++ )
+    {
+        // The uplinks of the device, acknowledged in its own RX windows and
+        // with its own session keys, at the first transmission
+        CHECK( Devices[i].McpsConfirms == UPLINKS );
+        CHECK( Devices[i].Delivered == UPLINKS );
+        CHECK( Devices[i].Unacknowledged == 0 );
+        CHECK( Devices[i].McpsConfirm.NbRetries == 1 );
+        busy += Devices[i].Busy;
+    }
+    CHECK( stats.Retransmissions == 0 );
+    CHECK( busy >= ( UPLINKS * ( NB_DEVICES - 1 ) ) );
+}
+
+static LoRaMacStatus_t BurstRequest( Device_t *device )
+{
+    uint8_t payload[51] = { device - Devices };
+    McpsReq_t mcpsReq;
+
+    mcpsReq.Type = MCPS_UNCONFIRMED;
+    mcpsReq.Req.Unconfirmed.fPort = 2;
+    mcpsReq.Req.Unconfirmed.fBuffer = payload;
+    mcpsReq.Req.Unconfirmed.fBufferSize = sizeof( payload );
+    mcpsReq.Req.Unconfirmed.Datarate = DR_0;
+    return LoRaMacCtxMcpsRequest( device->Ctx, &mcpsReq );
+}
+
+static void TestDelayed( void )
+{
+    uint32_t confirms;
+    uint32_t delivered;
+    uint32_t busy = 0;
+    uint64_t start;
+    uint8_t burst = 0;
+
+    Setup( );
+    CHECK( JoinAll( ) == true );
+    // The first device spends the credits of its bands
+    do
+    {
+        start = HostClockGetTime( );
+        confirms = Devices[0].McpsConfirms;
+        CHECK( BurstRequest( &Devices[0] ) == LORAMAC_STATUS_OK );
+        HostClockRunAll( HostClockGetTime( ) + WAIT_LIMIT );
+        CHECK( Devices[0].McpsConfirms == ( confirms + 1 ) );
+    } while( ( ( HostClockGetTime( ) - start ) < DELAYED_MIN ) && ( ++burst < 100 ) );
+    CHECK( burst < 100 );
+
+    // Another device was the last one on the radio, the request of the
+    // first one waits for its credits and keeps the radio from the others
+    confirms = Devices[1].McpsConfirms;
+    CHECK( ConfirmedRequest( &Devices[1] ) == LORAMAC_STATUS_OK );
+    HostClockRunAll( HostClockGetTime( ) + WAIT_LIMIT );
+    CHECK( Devices[1].McpsConfirms == ( confirms + 1 ) );
+    start = HostClockGetTime( );
+    confirms = Devices[0].McpsConfirms;
+    delivered = Devices[0].Delivered;
+    CHECK( BurstRequest( &Devices[0] ) == LORAMAC_STATUS_OK );
+    while( ( Devices[0].McpsConfirms == confirms ) && ( ( HostClockGetTime( ) - start ) < WAIT_LIMIT ) )
+    {
+        for( uint8_t i = 1; i < NB_DEVICES; i++ )
+        {
+            CHECK( ConfirmedRequest( &Devices[i] ) == LORAMAC_STATUS_BUSY );
+            busy++;
+        }
+        HostClockRunAll( HostClockGetTime( ) + 1 );
+    }
+    CHECK( Devices[0].McpsConfirms == ( confirms + 1 ) );
+    CHECK( Devices[0].Delivered == ( delivered + 1 ) );
+    CHECK( ( HostClockGetTime( ) - start ) >= DELAYED_MIN );
+    CHECK( busy > 0 );
+
+    // The radio is free again
+    CHECK( RunAll( ConfirmedRequest, false ) == true );
+    for( uint8_t i = 1; i < NB_DEVICES; i++ )
+    {
+        CHECK( Devices[i].Unacknowledged == 0 );
+    }
+}
+
+static void TestDutyCycleRecords( void )
+{
+    MibRequestConfirm_t mibReq;
+    int64_t credits[NB_DEVICES];
+    uint32_t confirms;
+
+    Setup( );
+    CHECK( JoinAll( ) == true );
+    // Device i sends i more uplinks, its bands end up with their own credits
+    for( uint8_t n = 1; n < NB_DEVICES; n++ )
+    {
+        for( uint8_t i = n; i < NB_DEVICES; i++ )
+        {
+            confirms = Devices[i].McpsConfirms;
+            CHECK( ConfirmedRequest( &Devices[i] ) == LORAMAC_STATUS_OK );
+            HostClockRunAll( HostClockGetTime( ) + WAIT_LIMIT );
+            CHECK( Devices[i].McpsConfirms == ( confirms + 1 ) );
+        }
+    }
+    for( uint8_t i = 0; i < NB_DEVICES; i++ )
+    {
+        credits[i] = GetCredits( &Devices[i] );
+        for( uint8_t j = 0; j < i; j++ )
+        {
+            CHECK( credits[i] != credits[j] );
+        }
+    }
+
+    // Context memory lost, as across a deep sleep of a context out of the
+    // RTC memory: each slot gets its own credits back from its record
+    for( uint8_t i = 0; i < NB_DEVICES; i++ )
+    {
+        mibReq.Type = MIB_NETWORK_JOINED;
+        mibReq.Param.IsNetworkJoined = false;
+        LoRaMacCtxMibSetRequestConfirm( Devices[i].Ctx, &mibReq );
+        memset( &Devices[i].Ctx->Region, 0, sizeof( Devices[i].Ctx->Region ) );
+        CHECK( LoRaMacCtxInitialization( Devices[i].Ctx, &Primitives[i], &Callbacks,
+                                         LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_OK );
+        CHECK( GetCredits( &Devices[i] ) == credits[i] );
+    }
+}
+
+int main( int argc, char **argv )
+{
+    RUN( TestSlots );
+    RUN( TestJoin );
+    RUN( TestUplinks );
+    RUN( TestDutyCycleRecords );
+    RUN( TestDelayed );
+    return TEST_RESULT( );
+}
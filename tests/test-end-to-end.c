@@ -0,0 +1,709 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: End to end host test of the MAC against the in-process network
+             server, on the simulated radio and the virtual clock: join with
+             a CFList, confirmed uplinks, RX2, LinkADRReq, DeviceTimeAns,
+             FramePending, the downlink timing and the adaptive RX windows,
+             then seeded sessions measuring the join time, the ACK latency
+             and the airtime per delivered byte
+
+             test-end-to-end [sessions]
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "LoRaMac.h"
+#include "LoRaMacTest.h"
+#include "systime.h"
+#include "host-clock.h"
+#include "host-board.h"
+#include "radio-sim.h"
+#include "network-server.h"
+#include "test.h"
+
+/*!
+ * Longest wait of a MAC primitive [us], duty cycle back-offs included
+ */
+#define WAIT_LIMIT                                  ( 3600ULL * 1000000 )
+
+/*!
+ * Sessions run twice to check the determinism
+ */
+#define DETERMINISM_SESSIONS                        20
+
+static uint8_t DevEui[] = { 0x00, 0x80, 0xE1, 0x15, 0x00, 0x0A, 0xB1, 0x37 };
+static uint8_t AppEui[] = { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x12, 0x34 };
+static uint8_t AppKey[] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                            0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+
+/*!
+ * MAC primitives seen by the application
+ */
+typedef struct sPrimitiveCounts
+{
+    uint32_t McpsConfirms;
+    uint32_t McpsIndications;
+    uint32_t MlmeConfirms;
+    McpsConfirm_t McpsConfirm;
+    McpsIndication_t McpsIndication;
+    MlmeConfirm_t MlmeConfirm;
+    /*!
+     * Application data of the last indication carrying some
+     */
+    uint8_t Port;
+    uint8_t Payload[242];
+    uint8_t Size;
+}PrimitiveCounts_t;
+
+static PrimitiveCounts_t Counts;
+
+/*!
+ * Application data received by the server
+ */
+static uint8_t ServerPort;
+static uint8_t ServerPayload[242];
+static uint8_t ServerSize;
+
+static void OnMacMcpsConfirm( McpsConfirm_t *mcpsConfirm )
+{
+    Counts.McpsConfirms++;
+    Counts.McpsConfirm = *mcpsConfirm;
+}
+
+static void OnMacMcpsIndication( McpsIndication_t *mcpsIndication )
+{
+    Counts.McpsIndications++;
+    Counts.McpsIndication = *mcpsIndication;
+    if( ( mcpsIndication->RxData == true ) && ( mcpsIndication->Port != 0 ) )
+    {
+        Counts.Port = mcpsIndication->Port;
+        Counts.Size = mcpsIndication->BufferSize;
+        memcpy( Counts.Payload, mcpsIndication->Buffer, mcpsIndication->BufferSize );
+    }
+}
+
+static void OnMacMlmeConfirm( MlmeConfirm_t *mlmeConfirm )
+{
+    Counts.MlmeConfirms++;
+    Counts.MlmeConfirm = *mlmeConfirm;
+}
+
+static void OnMacMlmeIndication( MlmeIndication_t *mlmeIndication )
+{
+}
+
+static uint8_t GetBatteryLevel( void )
+{
+    return 128;
+}
+
+static float GetTemperatureLevel( void )
+{
+    return 25.0f;
+}
+
+static LoRaMacPrimitives_t Primitives =
+{
+    .MacMcpsConfirm = OnMacMcpsConfirm,
+    .MacMcpsIndication = OnMacMcpsIndication,
+    .MacMlmeConfirm = OnMacMlmeConfirm,
+    .MacMlmeIndication = OnMacMlmeIndication,
+};
+
+static LoRaMacCallback_t Callbacks =
+{
+    .GetBatteryLevel = GetBatteryLevel,
+    .GetTemperatureLevel = GetTemperatureLevel,
+};
+
+static void OnServerData( uint8_t port, const uint8_t *payload, uint8_t size )
+{
+    ServerPort = port;
+    ServerSize = size;
+    memcpy( ServerPayload, payload, size );
+}
+
+/*!
+ * \brief Returns the server parameters of the tests, answering in RX1
+ */
+static NetworkServerParams_t GetServerParams( void )
+{
+    NetworkServerParams_t params;
+
+    memset( &params, 0, sizeof( params ) );
+    params.Region = LORAMAC_REGION_EU868;
+    memcpy( params.DevEui, DevEui, sizeof( DevEui ) );
+    memcpy( params.AppEui, AppEui, sizeof( AppEui ) );
+    memcpy( params.AppKey, AppKey, sizeof( AppKey ) );
+    params.DevAddr = 0x26011F42;
+    params.CfList = true;
+    params.Adr = true;
+    params.AdrMargin = 10.0f;
+    params.OnData = OnServerData;
+    return params;
+}
+
+/*!
+ * \brief Starts a session of a new device, not joined
+ *
+ * \param [IN] params    Server parameters
+ * \param [IN] seed      Seed of the board, the radio and the server
+ * \param [IN] pathLoss  Path loss of the link [dB]
+ * \param [IN] dutyCycle Enforces the duty cycle
+ */
+static void StartSession( const NetworkServerParams_t *params, uint32_t seed, float pathLoss, bool dutyCycle )
+{
+    MibRequestConfirm_t mibReq;
+
+    HostClockReset( );
+    HostBoardReset( seed, false );
+    RadioSimReset( seed );
+    RadioSimSetLink( pathLoss, 0.0f );
+    NetworkServerReset( params, seed );
+    memset( &Counts, 0, sizeof( Counts ) );
+    ServerSize = 0;
+
+    // The MAC only starts over a session which is not joined
+    mibReq.Type = MIB_NETWORK_JOINED;
+    mibReq.Param.IsNetworkJoined = false;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    CHECK( LoRaMacInitialization( &Primitives, &Callbacks, LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_OK );
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = true;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    LoRaMacTestSetDutyCycleOn( dutyCycle );
+}
+
+/*!
+ * \brief Runs the virtual clock, one event at a time, until a primitive
+ *
+ * \param [IN] count Primitive counter to wait on
+ * \param [IN] value Counter value before the wait
+ *
+ * \retval done false when the wait went over WAIT_LIMIT
+ */
+static bool RunUntil( const uint32_t *count, uint32_t value )
+{
+    uint64_t limit = HostClockGetTime( ) + WAIT_LIMIT;
+
+    while( *count == value )
+    {
+        if( HostClockGetTime( ) >= limit )
+        {
+            return false;
+        }
+        if( ( HostClockRunAll( HostClockGetTime( ) + 1 ) == true ) && ( *count == value ) )
+        {
+            // Nothing left to run
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Joins, the MAC going through the join trials of the region
+ *
+ * \retval joined true once the join accept is received
+ */
+static bool Join( void )
+{
+    MlmeReq_t mlmeReq;
+    uint32_t confirms = Counts.MlmeConfirms;
+
+    mlmeReq.Type = MLME_JOIN;
+    mlmeReq.Req.Join.DevEui = DevEui;
+    mlmeReq.Req.Join.AppEui = AppEui;
+    mlmeReq.Req.Join.AppKey = AppKey;
+    // Raised to the 48 trials of EU868, as the ESP32_LoRaWAN class does
+    mlmeReq.Req.Join.NbTrials = 1;
+    if( LoRaMacMlmeRequest( &mlmeReq ) != LORAMAC_STATUS_OK )
+    {
+        return false;
+    }
+    if( RunUntil( &Counts.MlmeConfirms, confirms ) == false )
+    {
+        return false;
+    }
+    return Counts.MlmeConfirm.Status == LORAMAC_EVENT_INFO_STATUS_OK;
+}
+
+/*!
+ * \brief Sends an uplink and waits for its confirm
+ *
+ * \param [IN] confirmed Confirmed uplink
+ * \param [IN] nbTrials  Transmissions of a confirmed uplink
+ * \param [IN] port      Frame port
+ * \param [IN] payload   Payload, NULL for an empty frame
+ * \param [IN] size      Payload size
+ *
+ * \retval sent false when the MAC did not confirm
+ */
+static bool Send( bool confirmed, uint8_t nbTrials, uint8_t port, const uint8_t *payload, uint8_t size )
+{
+    McpsReq_t mcpsReq;
+    uint32_t confirms = Counts.McpsConfirms;
+
+    if( confirmed == true )
+    {
+        mcpsReq.Type = MCPS_CONFIRMED;
+        mcpsReq.Req.Confirmed.fPort = port;
+        mcpsReq.Req.Confirmed.fBuffer = ( void* )payload;
+        mcpsReq.Req.Confirmed.fBufferSize = size;
+        mcpsReq.Req.Confirmed.NbTrials = nbTrials;
+        mcpsReq.Req.Confirmed.Datarate = DR_0;
+    }
+    else
+    {
+        mcpsReq.Type = MCPS_UNCONFIRMED;
+        mcpsReq.Req.Unconfirmed.fPort = port;
+        mcpsReq.Req.Unconfirmed.fBuffer = ( void* )payload;
+        mcpsReq.Req.Unconfirmed.fBufferSize = size;
+        mcpsReq.Req.Unconfirmed.Datarate = DR_0;
+    }
+    while( LoRaMacMcpsRequest( &mcpsReq ) == LORAMAC_STATUS_BUSY )
+    {
+        if( HostClockRunAll( HostClockGetTime( ) + 1 ) == true )
+        {
+            return false;
+        }
+    }
+    return RunUntil( &Counts.McpsConfirms, confirms );
+}
+
+static int8_t GetMibDatarate( void )
+{
+    MibRequestConfirm_t mibReq;
+
+    mibReq.Type = MIB_CHANNELS_DATARATE;
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    return mibReq.Param.ChannelsDatarate;
+}
+
+static void SetMibDatarate( int8_t datarate )
+{
+    MibRequestConfirm_t mibReq;
+
+    mibReq.Type = MIB_CHANNELS_DATARATE;
+    mibReq.Param.ChannelsDatarate = datarate;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+}
+
+static int8_t GetMibTxPower( void )
+{
+    MibRequestConfirm_t mibReq;
+
+    mibReq.Type = MIB_CHANNELS_TX_POWER;
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    return mibReq.Param.ChannelsTxPower;
+}
+
+static void TestJoin( void )
+{
+    NetworkServerParams_t params = GetServerParams( );
+    NetworkServerStats_t stats;
+    MibRequestConfirm_t mibReq;
+    uint8_t hello[] = { 'h', 'e', 'l', 'l', 'o' };
+    uint64_t start;
+
+    StartSession( &params, 1, 110.0f, false );
+    start = HostClockGetTime( );
+    CHECK( Join( ) == true );
+    // Answered in the first window, 5 s after the request
+    CHECK( ( HostClockGetTime( ) - start ) >= 5000000 );
+    CHECK( ( HostClockGetTime( ) - start ) < 7000000 );
+
+    mibReq.Type = MIB_DEV_ADDR;
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    CHECK( mibReq.Param.DevAddr == params.DevAddr );
+    mibReq.Type = MIB_CHANNELS;
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    for( uint8_t i = 0; i < 5; i++ )
+    {
+        CHECK( mibReq.Param.ChannelList[3 + i].Frequency == ( 867100000 + 200000 * i ) );
+    }
+
+    // The session keys derived on both sides agree
+    CHECK( Send( false, 1, 2, hello, sizeof( hello ) ) == true );
+    CHECK( ServerPort == 2 );
+    CHECK( ServerSize == sizeof( hello ) );
+    CHECK( memcmp( ServerPayload, hello, sizeof( hello ) ) == 0 );
+    NetworkServerGetStats( &stats );
+    CHECK( stats.JoinAccepts == 1 );
+    CHECK( stats.MicErrors == 0 );
+    CHECK( stats.Delivered == sizeof( hello ) );
+
+    // A wrong key fails every trial
+    AppKey[0] ^= 0x01;
+    StartSession( &params, 2, 110.0f, false );
+    CHECK( Join( ) == false );
+    AppKey[0] ^= 0x01;
+    NetworkServerGetStats( &stats );
+    CHECK( stats.JoinAccepts == 0 );
+    CHECK( stats.MicErrors == 48 );
+}
+
+static void TestConfirmed( void )
+{
+    NetworkServerParams_t params = GetServerParams( );
+    NetworkServerStats_t stats;
+    uint8_t payload[10] = { 0 };
+    uint32_t acked = 0;
+
+    StartSession( &params, 3, 110.0f, false );
+    CHECK( Join( ) == true );
+    for( uint8_t i = 0; i < 8; i++ )
+    {
+        payload[0] = i;
+        CHECK( Send( true, 1, 2, payload, sizeof( payload ) ) == true );
+        CHECK( Counts.McpsConfirm.AckReceived == true );
+        CHECK( Counts.McpsIndication.AckReceived == true );
+        CHECK( Counts.McpsIndication.RxSlot == RX_SLOT_WIN_1 );
+    }
+    NetworkServerGetStats( &stats );
+    CHECK( stats.Acks == 8 );
+    CHECK( stats.Retransmissions == 0 );
+
+    // Lost ACKs are recovered by the retransmissions, which the server
+    // acknowledges without delivering the payload again
+    params.Loss = 0.3f;
+    StartSession( &params, 4, 110.0f, false );
+    CHECK( Join( ) == true );
+    for( uint8_t i = 0; i < 20; i++ )
+    {
+        payload[0] = i;
+        CHECK( Send( true, 8, 2, payload, sizeof( payload ) ) == true );
+        acked += ( Counts.McpsConfirm.AckReceived == true ) ? 1 : 0;
+    }
+    NetworkServerGetStats( &stats );
+    CHECK( acked == 20 );
+    CHECK( stats.DownlinksDropped > 0 );
+    CHECK( stats.Retransmissions > 0 );
+    CHECK( stats.Delivered == 20 * sizeof( payload ) );
+}
+
+static void TestRx2( void )
+{
+    NetworkServerParams_t params = GetServerParams( );
+    uint8_t payload[] = { 0x01, 0x02 };
+
+    params.Rx2 = true;
+    StartSession( &params, 5, 110.0f, false );
+    CHECK( Join( ) == true );
+    CHECK( Send( true, 1, 2, payload, sizeof( payload ) ) == true );
+    CHECK( Counts.McpsConfirm.AckReceived == true );
+    CHECK( Counts.McpsIndication.RxSlot == RX_SLOT_WIN_2 );
+}
+
+static void TestLinkAdr( void )
+{
+    NetworkServerParams_t params = GetServerParams( );
+    NetworkServerStats_t stats;
+    uint8_t payload[4] = { 0 };
+
+    StartSession( &params, 6, 120.0f, false );
+    CHECK( Join( ) == true );
+    SetMibDatarate( DR_0 );
+    for( uint8_t i = 0; i < ( NETWORK_SERVER_ADR_HISTORY + 2 ); i++ )
+    {
+        payload[0] = i;
+        CHECK( Send( false, 1, 2, payload, sizeof( payload ) ) == true );
+    }
+    NetworkServerGetStats( &stats );
+
+    // The margin of the strong link is spent on the datarate, then the power,
+    // and the device answers the request with every field accepted
+    CHECK( stats.LinkAdrReqs == 1 );
+    CHECK( stats.LinkAdrAccepted == 1 );
+    CHECK( GetMibDatarate( ) == DR_5 );
+    CHECK( stats.Datarate == DR_5 );
+    CHECK( GetMibTxPower( ) == stats.TxPower );
+    CHECK( stats.TxPower > 0 );
+}
+
+static void TestDeviceTime( void )
+{
+    NetworkServerParams_t params = GetServerParams( );
+    NetworkServerStats_t stats;
+    MlmeReq_t mlmeReq;
+    SysTimeGps_t gps;
+    uint64_t device;
+    uint64_t network;
+    uint32_t confirms;
+
+    StartSession( &params, 7, 110.0f, false );
+    CHECK( Join( ) == true );
+    CHECK( SysTimeGetGps( &gps ) == false );
+
+    confirms = Counts.MlmeConfirms;
+    mlmeReq.Type = MLME_DEVICE_TIME;
+    CHECK( LoRaMacMlmeRequest( &mlmeReq ) == LORAMAC_STATUS_OK );
+    CHECK( Send( false, 1, 2, NULL, 0 ) == true );
+    CHECK( RunUntil( &Counts.MlmeConfirms, confirms ) == true );
+    CHECK( Counts.MlmeConfirm.MlmeRequest == MLME_DEVICE_TIME );
+    CHECK( Counts.MlmeConfirm.Status == LORAMAC_EVENT_INFO_STATUS_OK );
+    CHECK( Counts.McpsIndication.DeviceTimeAnsReceived == true );
+    NetworkServerGetStats( &stats );
+    CHECK( stats.DeviceTimeAns == 1 );
+
+    // The device follows the network time, to the answer resolution
+    HostClockRun( 10000000 );
+    CHECK( SysTimeGetGps( &gps ) == true );
+    device = ( uint64_t )gps.Seconds * 1000000 + ( uint64_t )gps.SubSeconds * 1000;
+    network = NetworkServerGetGpsTime( );
+    CHECK( device <= ( network + 5000 ) );
+    CHECK( ( device + 5000 ) >= network );
+}
+
+static void TestFramePending( void )
+{
+    NetworkServerParams_t params = GetServerParams( );
+    NetworkServerStats_t stats;
+    uint8_t received[3];
+    uint8_t count = 0;
+
+    StartSession( &params, 8, 110.0f, false );
+    CHECK( Join( ) == true );
+    CHECK( NetworkServerQueueDownlink( 3, ( const uint8_t* )"A", 1 ) == true );
+    CHECK( NetworkServerQueueDownlink( 3, ( const uint8_t* )"B", 1 ) == true );
+    CHECK( NetworkServerQueueDownlink( 3, ( const uint8_t* )"C", 1 ) == true );
+
+    // The application empties the queue with empty uplinks while pending
+    CHECK( Send( false, 1, 2, ( const uint8_t* )"?", 1 ) == true );
+    while( ( count < 3 ) && ( Counts.Size == 1 ) )
+    {
+        received[count] = Counts.Payload[0];
+        Counts.Size = 0;
+        CHECK( Counts.Port == 3 );
+        CHECK( Counts.McpsIndication.FramePending == ( ( count < 2 ) ? 1 : 0 ) );
+        count++;
+        if( Counts.McpsIndication.FramePending == 1 )
+        {
+            CHECK( Send( false, 1, 2, NULL, 0 ) == true );
+        }
+    }
+    CHECK( count == 3 );
+    CHECK( memcmp( received, "ABC", 3 ) == 0 );
+    NetworkServerGetStats( &stats );
+    CHECK( stats.DataDownlinks == 3 );
+    CHECK( stats.Uplinks == 3 );
+}
+
+static void TestOffset( void )
+{
+    NetworkServerParams_t params = GetServerParams( );
+    NetworkServerStats_t stats;
+    RadioSimStats_t radio;
+    uint8_t payload[] = { 0x55 };
+
+    // A late downlink within the symbols of the window is received
+    params.Offset = 2000;
+    StartSession( &params, 9, 110.0f, false );
+    CHECK( Join( ) == true );
+    CHECK( Send( true, 1, 2, payload, sizeof( payload ) ) == true );
+    CHECK( Counts.McpsConfirm.AckReceived == true );
+
+    // Far after the window, every join accept is missed
+    params.Offset = 500000;
+    StartSession( &params, 10, 110.0f, false );
+    CHECK( Join( ) == false );
+    RadioSimGetStats( &radio );
+    NetworkServerGetStats( &stats );
+    CHECK( stats.JoinAccepts == 48 );
+    CHECK( radio.DownlinksMissed == stats.JoinAccepts );
+    CHECK( radio.Downlinks == 0 );
+}
+
+/*!
+ * \brief Returns the RX window timing learned by the MAC
+ */
+static LoRaMacRxTimingStatus_t GetRxTiming( void )
+{
+    MibRequestConfirm_t mibReq;
+
+    mibReq.Type = MIB_RX_TIMING_STATUS;
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    return *mibReq.Param.RxTimingStatus;
+}
+
+static void TestRxTiming( void )
+{
+    NetworkServerParams_t params = GetServerParams( );
+    LoRaMacRxTimingStatus_t timing;
+    MibRequestConfirm_t mibReq;
+    uint8_t payload[] = { 0x55 };
+
+    StartSession( &params, 11, 110.0f, false );
+    CHECK( Join( ) == true );
+    mibReq.Type = MIB_RX_TIMING_ADAPTIVE;
+    mibReq.Param.RxTimingAdaptive = true;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+
+    // The simulated downlinks are always on time, the learned spread is 0
+    for( uint8_t i = 0; i < RX_TIMING_MIN_SAMPLES; i++ )
+    {
+        CHECK( Send( true, 1, 2, payload, sizeof( payload ) ) == true );
+        CHECK( Counts.McpsConfirm.AckReceived == true );
+    }
+    timing = GetRxTiming( );
+    CHECK( timing.Samples[0] == RX_TIMING_MIN_SAMPLES );
+    CHECK( timing.OffsetVariance[0] == 0.0f );
+    CHECK( timing.RxError[0] < 10 );
+
+    // Moved out of the narrow window, the first miss widens it again, before
+    // the retransmissions step the datarate down
+    NetworkServerSetOffset( 7000 );
+    CHECK( Send( true, 8, 2, payload, sizeof( payload ) ) == true );
+    CHECK( Counts.McpsConfirm.AckReceived == true );
+    CHECK( Counts.McpsConfirm.NbRetries == 2 );
+    timing = GetRxTiming( );
+    CHECK( timing.Misses == 0 );
+    CHECK( timing.Samples[0] == ( RX_TIMING_MIN_SAMPLES + 1 ) );
+}
+
+/*!
+ * Results of a session
+ */
+typedef struct sSessionResult
+{
+    bool Joined;
+    uint64_t JoinTime;
+    uint32_t Acks;
+    uint64_t AckLatency;
+    uint64_t AirTime;
+    uint32_t Delivered;
+    uint64_t EndTime;
+}SessionResult_t;
+
+/*!
+ * \brief Runs a session: join, confirmed uplinks and a device time request,
+ *        on a seeded link with the duty cycle enforced
+ */
+static SessionResult_t RunSession( uint32_t seed )
+{
+    NetworkServerParams_t params = GetServerParams( );
+    NetworkServerStats_t stats;
+    SessionResult_t result;
+    MlmeReq_t mlmeReq;
+    uint8_t payload[12] = { 0 };
+    uint64_t start;
+
+    memset( &result, 0, sizeof( result ) );
+    params.Loss = 0.1f;
+    // Path loss from the seed, over the SF7 to SF12 range, and shadowing
+    StartSession( &params, seed, 0.0f, true );
+    RadioSimSetLink( 100.0f + ( float )( ( seed * 2654435761u ) % 40 ), 3.0f );
+
+    start = HostClockGetTime( );
+    result.Joined = Join( );
+    result.JoinTime = HostClockGetTime( ) - start;
+    if( result.Joined == true )
+    {
+        for( uint8_t i = 0; i < 4; i++ )
+        {
+            if( i == 3 )
+            {
+                mlmeReq.Type = MLME_DEVICE_TIME;
+                LoRaMacMlmeRequest( &mlmeReq );
+            }
+            payload[0] = i;
+            start = HostClockGetTime( );
+            if( ( Send( true, 4, 2, payload, sizeof( payload ) ) == true ) &&
+                ( Counts.McpsConfirm.AckReceived == true ) )
+            {
+                result.Acks++;
+                result.AckLatency += HostClockGetTime( ) - start;
+            }
+        }
+    }
+    NetworkServerGetStats( &stats );
+    result.AirTime = stats.UplinkAirTime;
+    result.Delivered = stats.Delivered;
+    result.EndTime = HostClockGetTime( );
+    return result;
+}
+
+static uint32_t Sessions = 1000;
+
+static void TestSessions( void )
+{
+    SessionResult_t results[DETERMINISM_SESSIONS];
+    uint32_t joined = 0;
+    uint32_t acks = 0;
+    uint64_t joinTime = 0;
+    uint64_t joinTimeMax = 0;
+    uint64_t ackLatency = 0;
+    uint64_t airTime = 0;
+    uint64_t delivered = 0;
+
+    for( uint32_t i = 0; i < Sessions; i++ )
+    {
+        SessionResult_t result = RunSession( 100 + i );
+
+        if( i < DETERMINISM_SESSIONS )
+        {
+            results[i] = result;
+        }
+        if( result.Joined == true )
+        {
+            joined++;
+            joinTime += result.JoinTime;
+            joinTimeMax = MAX( joinTimeMax, result.JoinTime );
+        }
+        acks += result.Acks;
+        ackLatency += result.AckLatency;
+        airTime += result.AirTime;
+        delivered += result.Delivered;
+    }
+
+    // A seed always plays the same session
+    for( uint32_t i = 0; i < MIN( Sessions, DETERMINISM_SESSIONS ); i++ )
+    {
+        SessionResult_t result = RunSession( 100 + i );
+
+        CHECK( result.Joined == results[i].Joined );
+        CHECK( result.JoinTime == results[i].JoinTime );
+        CHECK( result.Acks == results[i].Acks );
+        CHECK( result.AckLatency == results[i].AckLatency );
+        CHECK( result.AirTime == results[i].AirTime );
+        CHECK( result.EndTime == results[i].EndTime );
+    }
+
+    CHECK( joined >= ( Sessions * 9 / 10 ) );
+    CHECK( acks >= ( joined * 4 * 9 / 10 ) );
+    if( ( joined != 0 ) && ( acks != 0 ) && ( delivered != 0 ) )
+    {
+        printf( "%u sessions, %u joined, join time %.1f s mean %.1f s max\n", Sessions, joined,
+                joinTime / ( joined * 1e6 ), joinTimeMax / 1e6 );
+        printf( "%u acks, ack latency %.2f s mean, airtime %.2f ms per delivered byte\n", acks,
+                ackLatency / ( acks * 1e6 ), airTime / ( delivered * 1e3 ) );
+    }
+}
+
+int main( int argc, char **argv )
+{
+    if( argc > 1 )
+    {
+        Sessions = strtoul( argv[1], NULL, 0 );
+    }
+
+    RUN( TestJoin );
+    RUN( TestConfirmed );
+    RUN( TestRx2 );
+    RUN( TestLinkAdr );
+    RUN( TestDeviceTime );
+    RUN( TestFramePending );
+    RUN( TestOffset );
+    RUN( TestRxTiming );
+    RUN( TestSessions );
+    return TEST_RESULT( );
+}
@@ -0,0 +1,346 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: One node of tools/fleet_sim.py on the real MAC. A joined EU868
+             device with the 8 channels of the fleet sends the fleet payload
+             at every datarate, confirmed uplinks nobody acknowledges, then
+             back to back uplinks which run out of duty cycle credits, on the
+             simulated radio and the virtual clock. With --trace it prints
+             the requests, the uplinks put on the air and the radio time and
+             charge of every message, which fleet_sim.py --check-stack
+             replays through its node model
+
+             test-fleet-node [--trace]
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "LoRaMac.h"
+#include "energy.h"
+#include "rtc-drift.h"
+#include "host-clock.h"
+#include "host-board.h"
+#include "radio-sim.h"
+#include "test.h"
+
+/*!
+ * Application payload of the fleet, fleet_sim.py --payload
+ */
+#define PAYLOAD_SIZE                                12
+
+/*!
+ * Transmissions of the confirmed uplinks, fleet_sim.py --trials
+ */
+#define CONFIRMED_TRIALS                            8
+
+/*!
+ * Confirmed uplinks at each starting datarate
+ */
+#define CONFIRMED_UPLINKS                           3
+
+/*!
+ * Back to back uplinks at DR0, more than the one hour credits of the two
+ * bands of the channels allow
+ */
+#define BURST_UPLINKS                               60
+
+/*!
+ * Quiet time between the phases [us]
+ */
+#define PHASE_GAP                                   600000000ULL
+
+/*!
+ * The 5 channels of the join accept CFList, band 0
+ */
+static const uint32_t CfListFrequencies[] = { 867100000, 867300000, 867500000, 867700000, 867900000 };
+
+static bool Trace = false;
+static uint32_t McpsConfirms;
+static McpsConfirm_t LastMcpsConfirm;
+static uint32_t Uplinks;
+
+/*!
+ * Time of the last request and start of its first uplink [us]
+ */
+static uint64_t RequestTime;
+static uint32_t RequestUplinks;
+static uint64_t FirstUplinkStart;
+
+static void OnMacMcpsConfirm( McpsConfirm_t *mcpsConfirm )
+{
+    McpsConfirms++;
+    LastMcpsConfirm = *mcpsConfirm;
+}
+
+static void OnMacMcpsIndication( McpsIndication_t *mcpsIndication )
+{
+}
+
+static void OnMacMlmeConfirm( MlmeConfirm_t *mlmeConfirm )
+{
+}
+
+static void OnMacMlmeIndication( MlmeIndication_t *mlmeIndication )
+{
+}
+
+static uint8_t GetBatteryLevel( void )
+{
+    return 128;
+}
+
+static float GetTemperatureLevel( void )
+{
+    return 25.0f;
+}
+
+static LoRaMacPrimitives_t Primitives =
+{
+    .MacMcpsConfirm = OnMacMcpsConfirm,
+    .MacMcpsIndication = OnMacMcpsIndication,
+    .MacMlmeConfirm = OnMacMlmeConfirm,
+    .MacMlmeIndication = OnMacMlmeIndication,
+};
+
+static LoRaMacCallback_t Callbacks =
+{
+    .GetBatteryLevel = GetBatteryLevel,
+    .GetTemperatureLevel = GetTemperatureLevel,
+};
+
+/*!
+ * \brief Gateway of the node, which hears everything and answers nothing
+ *
+ * \param [IN] packet Uplink, at its end
+ */
+static void OnUplink( const RadioSimPacket_t *packet )
+{
+    if( Uplinks++ == RequestUplinks )
+    {
+        FirstUplinkStart = packet->Start;
+    }
+    if( Trace == true )
+    {
+        printf( "uplink %llu %lu %lu %lu %u\n", ( unsigned long long )packet->Start,
+                ( unsigned long )RadioSimGetLoRaTimeOnAir( packet->Datarate, packet->Bandwidth, true, packet->Size ),
+                ( unsigned long )packet->Frequency, ( unsigned long )packet->Datarate, packet->Size );
+    }
+}
+
+/*!
+ * \brief Runs the virtual clock, one event at a time, until a primitive
+ *
+ * \param [IN] count Primitive counter to wait on
+ * \param [IN] value Counter value before the wait
+ *
+ * \retval done false when nothing is left to run
+ */
+static bool RunUntil( const uint32_t *count, uint32_t value )
+{
+    while( *count == value )
+    {
+        if( ( HostClockRunAll( HostClockGetTime( ) + 1 ) == true ) && ( *count == value ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Initializes a joined EU868 device with the 3 default and the 5
+ *        CFList channels, ADR off and the duty cycle on
+ *
+ * \retval initialized false when the MAC refused a parameter
+ */
+static bool Setup( void )
+{
+    MibRequestConfirm_t mibReq;
+    ChannelParams_t channel;
+
+    HostClockReset( );
+    HostBoardReset( 1, false );
+    RadioSimReset( 1 );
+    RadioSimSetUplinkHandler( OnUplink );
+    if( LoRaMacInitialization( &Primitives, &Callbacks, LORAMAC_REGION_EU868 ) != LORAMAC_STATUS_OK )
+    {
+        return false;
+    }
+    mibReq.Type = MIB_NETWORK_JOINED;
+    mibReq.Param.IsNetworkJoined = true;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = false;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+
+    memset( &channel, 0, sizeof( channel ) );
+    channel.DrRange.Fields.Min = DR_0;
+    channel.DrRange.Fields.Max = DR_5;
+    for( uint8_t i = 0; i < sizeof( CfListFrequencies ) / sizeof( CfListFrequencies[0] ); i++ )
+    {
+        channel.Frequency = CfListFrequencies[i];
+        if( LoRaMacChannelAdd( 3 + i, channel ) != LORAMAC_STATUS_OK )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Sends one message and waits for its confirm, printing the radio
+ *        time and charge it took
+ *
+ * \param [IN] confirmed Confirmed uplink, of CONFIRMED_TRIALS transmissions
+ * \param [IN] datarate  Datarate of the first transmission
+ *
+ * \retval sent false when the MAC did not confirm
+ */
+static bool Send( bool confirmed, int8_t datarate )
+{
+    uint8_t payload[PAYLOAD_SIZE] = { 0 };
+    uint32_t confirms = McpsConfirms;
+    EnergyStatus_t before;
+    EnergyStatus_t *after;
+    MibRequestConfirm_t mibReq;
+    McpsReq_t mcpsReq;
+
+    if( confirmed == true )
+    {
+        mcpsReq.Type = MCPS_CONFIRMED;
+        mcpsReq.Req.Confirmed.fPort = 2;
+        mcpsReq.Req.Confirmed.fBuffer = payload;
+        mcpsReq.Req.Confirmed.fBufferSize = sizeof( payload );
+        mcpsReq.Req.Confirmed.NbTrials = CONFIRMED_TRIALS;
+        mcpsReq.Req.Confirmed.Datarate = datarate;
+    }
+    else
+    {
+        mcpsReq.Type = MCPS_UNCONFIRMED;
+        mcpsReq.Req.Unconfirmed.fPort = 2;
+        mcpsReq.Req.Unconfirmed.fBuffer = payload;
+        mcpsReq.Req.Unconfirmed.fBufferSize = sizeof( payload );
+        mcpsReq.Req.Unconfirmed.Datarate = datarate;
+    }
+
+    mibReq.Type = MIB_ENERGY_STATUS;
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    before = *mibReq.Param.EnergyStatus;
+    RequestUplinks = Uplinks;
+    RequestTime = HostClockGetTime( );
+    while( LoRaMacMcpsRequest( &mcpsReq ) == LORAMAC_STATUS_BUSY )
+    {
+        if( HostClockRunAll( HostClockGetTime( ) + 1 ) == true )
+        {
+            return false;
+        }
+        RequestTime = HostClockGetTime( );
+    }
+    if( Trace == true )
+    {
+        printf( "request %llu %u %d\n", ( unsigned long long )RequestTime, confirmed, datarate );
+    }
+    if( RunUntil( &McpsConfirms, confirms ) == false )
+    {
+        return false;
+    }
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    after = mibReq.Param.EnergyStatus;
+    if( Trace == true )
+    {
+        printf( "confirm %llu %u %u %lu %lu %llu %llu\n", ( unsigned long long )HostClockGetTime( ),
+                LastMcpsConfirm.NbRetries, LastMcpsConfirm.AckReceived,
+                ( unsigned long )( after->Time[ENERGY_STATE_RADIO_TX] - before.Time[ENERGY_STATE_RADIO_TX] ),
+                ( unsigned long )( after->Time[ENERGY_STATE_RADIO_RX] - before.Time[ENERGY_STATE_RADIO_RX] ),
+                ( unsigned long long )( after->Charge[ENERGY_STATE_RADIO_TX] - before.Charge[ENERGY_STATE_RADIO_TX] ),
+                ( unsigned long long )( after->Charge[ENERGY_STATE_RADIO_RX] - before.Charge[ENERGY_STATE_RADIO_RX] ) );
+    }
+    return true;
+}
+
+/*!
+ * \brief Returns the slow clock drift measurements
+ */
+static uint32_t GetDriftSamples( void )
+{
+    RtcDriftStatus_t status;
+    uint32_t samples = 0;
+
+    RtcDriftGetStatus( &status );
+    for( uint8_t i = 0; i < RTC_DRIFT_TEMPERATURE_BINS; i++ )
+    {
+        samples += status.Samples[i];
+    }
+    return samples;
+}
+
+/*!
+ * \brief Runs the phases the node model is checked on
+ */
+static void TestFleetNode( void )
+{
+    uint32_t uplinks;
+    uint32_t samples;
+    uint64_t start;
+
+    CHECK( Setup( ) == true );
+
+    // Time on air, RX windows and energy at every datarate. The slow clock
+    // drift is measured once per uplink, after it rather than between the
+    // request and the transmission.
+    for( int8_t datarate = DR_5; datarate >= DR_0; datarate-- )
+    {
+        uplinks = Uplinks;
+        samples = GetDriftSamples( );
+        CHECK( Send( false, datarate ) == true );
+        CHECK( LastMcpsConfirm.Datarate == datarate );
+        CHECK( Uplinks == uplinks + 1 );
+        CHECK( FirstUplinkStart == RequestTime );
+        CHECK( GetDriftSamples( ) == samples + 1 );
+        HostClockRun( PHASE_GAP );
+    }
+
+    // Retransmission spacing and datarates, nothing acknowledged
+    for( int8_t datarate = DR_5; datarate >= DR_2; datarate -= 3 )
+    {
+        for( uint8_t i = 0; i < CONFIRMED_UPLINKS; i++ )
+        {
+            uplinks = Uplinks;
+            samples = GetDriftSamples( );
+            CHECK( Send( true, datarate ) == true );
+            CHECK( GetDriftSamples( ) == samples + 1 );
+            CHECK( LastMcpsConfirm.AckReceived == false );
+            CHECK( LastMcpsConfirm.NbRetries == CONFIRMED_TRIALS );
+            CHECK( Uplinks == uplinks + CONFIRMED_TRIALS );
+        }
+        HostClockRun( PHASE_GAP );
+    }
+
+    // Band duty cycle credits, the burst must end up waiting for them
+    start = HostClockGetTime( );
+    for( uint8_t i = 0; i < BURST_UPLINKS; i++ )
+    {
+        CHECK( Send( false, DR_0 ) == true );
+    }
+    CHECK( ( HostClockGetTime( ) - start ) > ( BURST_UPLINKS * 4000000ULL ) );
+}
+
+int main( int argc, char **argv )
+{
+    if( ( argc > 1 ) && ( strcmp( argv[1], "--trace" ) == 0 ) )
+    {
+        Trace = true;
+        TestFleetNode( );
+        return TEST_RESULT( );
+    }
+    RUN( TestFleetNode );
+    return TEST_RESULT( );
+}
@@ -0,0 +1,271 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host test of the US915 join subband rotation: the channels
+             RegionNextChannel gives unjoined, subband after subband with one
+             500 kHz and one 125 kHz request each, masked subbands skipped and
+             the restart on the accepted subband, then the MAC joining a
+             gateway of the network server listening on one subband, first
+             join and rejoin
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "LoRaMac.h"
+#include "LoRaMacTest.h"
+#include "Region.h"
+#include "host-clock.h"
+#include "host-board.h"
+#include "radio-sim.h"
+#include "network-server.h"
+#include "test.h"
+
+/*!
+ * Subband of the gateway of the join test, 1 to 8
+ */
+#define GATEWAY_SUBBAND                             2
+
+static uint8_t DevEui[] = { 0x00, 0x80, 0xE1, 0x15, 0x00, 0x0A, 0xB1, 0x37 };
+static uint8_t AppEui[] = { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x12, 0x34 };
+static uint8_t AppKey[] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                            0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+
+static uint32_t MlmeConfirms;
+static MlmeConfirm_t LastMlmeConfirm;
+
+static void OnMacMcpsConfirm( McpsConfirm_t *mcpsConfirm )
+{
+}
+
+static void OnMacMcpsIndication( McpsIndication_t *mcpsIndication )
+{
+}
+
+static void OnMacMlmeConfirm( MlmeConfirm_t *mlmeConfirm )
+{
+    MlmeConfirms++;
+    LastMlmeConfirm = *mlmeConfirm;
+}
+
+static void OnMacMlmeIndication( MlmeIndication_t *mlmeIndication )
+{
+}
+
+static LoRaMacPrimitives_t Primitives =
+{
+    .MacMcpsConfirm = OnMacMcpsConfirm,
+    .MacMcpsIndication = OnMacMcpsIndication,
+    .MacMlmeConfirm = OnMacMlmeConfirm,
+    .MacMlmeIndication = OnMacMlmeIndication,
+};
+
+static LoRaMacCallback_t Callbacks;
+
+/*!
+ * \brief Returns the subband of a US915 channel, 0 to 7
+ */
+static uint8_t SubBandOf( uint8_t channel )
+{
+    return ( channel < 64 ) ? ( channel / 8 ) : ( channel - 64 );
+}
+
+/*!
+ * \brief Starts the MAC over in US915, not joined, the channels of the
+ *        default mask
+ */
+static void Setup( void )
+{
+    MibRequestConfirm_t mibReq;
+
+    HostClockReset( );
+    HostBoardReset( 1, false );
+    RadioSimReset( 1 );
+    mibReq.Type = MIB_NETWORK_JOINED;
+    mibReq.Param.IsNetworkJoined = false;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    CHECK( LoRaMacInitialization( &Primitives, &Callbacks, LORAMAC_REGION_US915 ) == LORAMAC_STATUS_OK );
+}
+
+/*!
+ * \brief Returns the channel of the next join request
+ *
+ * \param [IN] datarate DR_4 for a 500 kHz request, DR_0 for a 125 kHz one
+ */
+static uint8_t NextJoinChannel( int8_t datarate )
+{
+    NextChanParams_t nextChan;
+    TimerTime_t time = 0;
+    TimerTime_t aggregatedTimeOff = 0;
+    uint8_t channel = 0xFF;
+
+    memset( &nextChan, 0, sizeof( nextChan ) );
+    nextChan.Datarate = datarate;
+    nextChan.Joined = false;
+    CHECK( RegionNextChannel( LORAMAC_REGION_US915, &nextChan, &channel, &time, &aggregatedTimeOff ) == true );
+    CHECK( time == 0 );
+    return channel;
+}
+
+/*!
+ * \brief Checks the two join requests of a subband: the 500 kHz channel of
+ *        the subband, then one of its 125 kHz channels
+ */
+static void CheckSubBand( uint8_t subBand )
+{
+    uint8_t channel = NextJoinChannel( DR_4 );
+
+    CHECK( channel == ( 64 + subBand ) );
+    channel = NextJoinChannel( DR_0 );
+    CHECK( channel < 64 );
+    CHECK( SubBandOf( channel ) == subBand );
+}
+
+static void TestRotation( void )
+{
+    Setup( );
+    // Starts on the first subband
+    RegionJoinAccepted( LORAMAC_REGION_US915, 0 );
+    for( uint8_t round = 0; round < 2; round++ )
+    {
+        for( uint8_t subBand = 0; subBand < 8; subBand++ )
+        {
+            CheckSubBand( subBand );
+        }
+    }
+}
+
+static void TestMasked( void )
+{
+    uint16_t mask[6] = { 0 };
+    MibRequestConfirm_t mibReq;
+
+    Setup( );
+    RegionJoinAccepted( LORAMAC_REGION_US915, 0 );
+    // Subbands 2 and 7 only, the 125 kHz channels 8 to 15 and 48 to 55 and
+    // the 500 kHz channels 65 and 70
+    mask[0] = 0xFF00;
+    mask[3] = 0x00FF;
+    mask[4] = ( 1 << 1 ) | ( 1 << 6 );
+    mibReq.Type = MIB_CHANNELS_MASK;
+    mibReq.Param.ChannelsMask = mask;
+    CHECK( LoRaMacMibSetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK );
+    for( uint8_t round = 0; round < 3; round++ )
+    {
+        CheckSubBand( 1 );
+        CheckSubBand( 6 );
+    }
+
+    // Without its 125 kHz channels, a subband only gets its 500 kHz request
+    mask[0] = 0x0000;
+    mask[1] = 0x00FF;
+    mask[3] = 0x0000;
+    mask[4] = ( 1 << 1 ) | ( 1 << 2 );
+    CHECK( LoRaMacMibSetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK );
+    RegionJoinAccepted( LORAMAC_REGION_US915, 64 + 1 );
+    CHECK( NextJoinChannel( DR_4 ) == 65 );
+    CHECK( SubBandOf( NextJoinChannel( DR_0 ) ) == 2 );
+    CHECK( NextJoinChannel( DR_4 ) == 66 );
+    CHECK( NextJoinChannel( DR_4 ) == 65 );
+}
+
+static void TestAccepted( void )
+{
+    Setup( );
+    RegionJoinAccepted( LORAMAC_REGION_US915, 0 );
+    CheckSubBand( 0 );
+    CHECK( NextJoinChannel( DR_4 ) == 65 );
+
+    // Accepted on a 125 kHz channel of the third subband, the rotation
+    // starts over there
+    RegionJoinAccepted( LORAMAC_REGION_US915, 21 );
+    CheckSubBand( 2 );
+    CheckSubBand( 3 );
+
+    // Or on a 500 kHz channel, and the subband is kept by a new
+    // initialization of the MAC
+    RegionJoinAccepted( LORAMAC_REGION_US915, 64 + 5 );
+    Setup( );
+    CheckSubBand( 5 );
+    CheckSubBand( 6 );
+}
+
+/*!
+ * \brief Joins the gateway of the server listening on GATEWAY_SUBBAND
+ *
+ * \param [OUT] requests Join requests sent
+ * \param [OUT] airTime  Time on air of the join requests [ms]
+ *
+ * \retval joined true once the join accept is received
+ */
+static bool Join( uint32_t *requests, uint32_t *airTime )
+{
+    NetworkServerParams_t params;
+    RadioSimStats_t stats;
+    MlmeReq_t mlmeReq;
+    uint32_t confirms = MlmeConfirms;
+
+    Setup( );
+    memset( &params, 0, sizeof( params ) );
+    params.Region = LORAMAC_REGION_US915;
+    memcpy( params.DevEui, DevEui, sizeof( DevEui ) );
+    memcpy( params.AppEui, AppEui, sizeof( AppEui ) );
+    memcpy( params.AppKey, AppKey, sizeof( AppKey ) );
+    params.DevAddr = 0x26011F42;
+    params.SubBand = GATEWAY_SUBBAND;
+    RadioSimSetLink( 110.0f, 0.0f );
+    NetworkServerReset( &params, 1 );
+
+    mlmeReq.Type = MLME_JOIN;
+    mlmeReq.Req.Join.DevEui = DevEui;
+    mlmeReq.Req.Join.AppEui = AppEui;
+    mlmeReq.Req.Join.AppKey = AppKey;
+    mlmeReq.Req.Join.NbTrials = 16;
+    CHECK( LoRaMacMlmeRequest( &mlmeReq ) == LORAMAC_STATUS_OK );
+    while( MlmeConfirms == confirms )
+    {
+        if( ( HostClockRunAll( HostClockGetTime( ) + 1 ) == true ) && ( MlmeConfirms == confirms ) )
+        {
+            break;
+        }
+    }
+    RadioSimGetStats( &stats );
+    *requests = stats.Uplinks;
+    *airTime = stats.UplinkAirTime;
+    return ( MlmeConfirms != confirms ) && ( LastMlmeConfirm.Status == LORAMAC_EVENT_INFO_STATUS_OK );
+}
+
+static void TestJoin( void )
+{
+    uint32_t requests;
+    uint32_t airTime;
+
+    // The first join goes through the subbands up to the one of the gateway,
+    // answered on the 500 kHz request of the second one
+    Setup( );
+    RegionJoinAccepted( LORAMAC_REGION_US915, 0 );
+    CHECK( Join( &requests, &airTime ) == true );
+    CHECK( requests == ( 2 * ( GATEWAY_SUBBAND - 1 ) + 1 ) );
+    printf( "first join: %u requests, %u ms airtime\n", requests, airTime );
+
+    // The rejoin starts there
+    CHECK( Join( &requests, &airTime ) == true );
+    CHECK( requests == 1 );
+    printf( "rejoin: %u requests, %u ms airtime\n", requests, airTime );
+}
+
+int main( int argc, char **argv )
+{
+    RUN( TestRotation );
+    RUN( TestMasked );
+    RUN( TestAccepted );
+    RUN( TestJoin );
+    return TEST_RESULT( );
+}
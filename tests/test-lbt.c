@@ -0,0 +1,316 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host test of the listen before talk channel scan of the MAC, in
+             AS923, against interferers of the simulated radio: free,
+             partially busy and all busy channels with the backoff, then the
+             CAD, followed by the carrier sense in AS923 and alone in EU868
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "LoRaMac.h"
+#include "LoRaMacTest.h"
+#include "host-clock.h"
+#include "host-board.h"
+#include "radio-sim.h"
+#include "test.h"
+
+/*!
+ * The 2 default channels of AS923 and the 2 added by the test
+ */
+static const uint32_t Frequencies[] = { 923200000, 923400000, 923600000, 923800000 };
+
+#define NB_CHANNELS                                 ( sizeof( Frequencies ) / sizeof( Frequencies[0] ) )
+
+/*!
+ * RSSI of the interferers, above the -85 dBm threshold of AS923 [dBm]
+ */
+#define INTERFERER_RSSI                             -60
+
+/*!
+ * Quiet time between the uplinks [us]
+ */
+#define UPLINK_GAP                                  10000000ULL
+
+static uint32_t McpsConfirms;
+static McpsConfirm_t LastMcpsConfirm;
+static uint32_t Uplinks;
+static RadioSimPacket_t LastUplink;
+
+static void OnMacMcpsConfirm( McpsConfirm_t *mcpsConfirm )
+{
+    McpsConfirms++;
+    LastMcpsConfirm = *mcpsConfirm;
+}
+
+static void OnMacMcpsIndication( McpsIndication_t *mcpsIndication )
+{
+}
+
+static void OnMacMlmeConfirm( MlmeConfirm_t *mlmeConfirm )
+{
+}
+
+static void OnMacMlmeIndication( MlmeIndication_t *mlmeIndication )
+{
+}
+
+static LoRaMacPrimitives_t Primitives =
+{
+    .MacMcpsConfirm = OnMacMcpsConfirm,
+    .MacMcpsIndication = OnMacMcpsIndication,
+    .MacMlmeConfirm = OnMacMlmeConfirm,
+    .MacMlmeIndication = OnMacMlmeIndication,
+};
+
+static LoRaMacCallback_t Callbacks;
+
+static void OnUplink( const RadioSimPacket_t *packet )
+{
+    Uplinks++;
+    LastUplink = *packet;
+}
+
+/*!
+ * \brief Initializes a joined device, ADR and duty cycle off, with the
+ *        channels of Frequencies in AS923
+ *
+ * \param [IN] region LORAMAC_REGION_AS923 or LORAMAC_REGION_EU868
+ * \param [IN] mode   Probing method
+ */
+static void Setup( LoRaMacRegion_t region, LoRaMacLbtMode_t mode )
+{
+    MibRequestConfirm_t mibReq;
+    ChannelParams_t channel;
+
+    HostClockReset( );
+    HostBoardReset( 1, false );
+    RadioSimReset( 1 );
+    RadioSimSetUplinkHandler( OnUplink );
+    Uplinks = 0;
+
+    mibReq.Type = MIB_NETWORK_JOINED;
+    mibReq.Param.IsNetworkJoined = false;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    CHECK( LoRaMacInitialization( &Primitives, &Callbacks, region ) == LORAMAC_STATUS_OK );
+    mibReq.Param.IsNetworkJoined = true;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = false;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    LoRaMacTestSetDutyCycleOn( false );
+
+    mibReq.Type = MIB_LBT_ENABLE;
+    mibReq.Param.LbtEnable = ( region != LORAMAC_REGION_AS923 );
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_LBT_MODE;
+    mibReq.Param.LbtMode = mode;
+    CHECK( LoRaMacMibSetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK );
+    mibReq.Type = MIB_LBT_STATUS;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+
+    if( region == LORAMAC_REGION_AS923 )
+    {
+        memset( &channel, 0, sizeof( channel ) );
+        channel.DrRange.Fields.Min = DR_0;
+        channel.DrRange.Fields.Max = DR_5;
+        for( uint8_t i = 2; i < NB_CHANNELS; i++ )
+        {
+            channel.Frequency = Frequencies[i];
+            CHECK( LoRaMacChannelAdd( i, channel ) == LORAMAC_STATUS_OK );
+        }
+    }
+}
+
+static LoRaMacLbtStatus_t GetLbtStatus( void )
+{
+    MibRequestConfirm_t mibReq;
+
+    mibReq.Type = MIB_LBT_STATUS;
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    return *mibReq.Param.LbtStatus;
+}
+
+/*!
+ * \brief Sends an unconfirmed uplink at DR5 and waits for its confirm
+ *
+ * \retval delay Time from the request to the start of the uplink [us]
+ */
+static uint64_t Send( void )
+{
+    uint8_t payload[4] = { 0 };
+    uint32_t confirms = McpsConfirms;
+    uint32_t uplinks = Uplinks;
+    uint64_t start;
+    McpsReq_t mcpsReq;
+
+    mcpsReq.Type = MCPS_UNCONFIRMED;
+    mcpsReq.Req.Unconfirmed.fPort = 2;
+    mcpsReq.Req.Unconfirmed.fBuffer = payload;
+    mcpsReq.Req.Unconfirmed.fBufferSize = sizeof( payload );
+    mcpsReq.Req.Unconfirmed.Datarate = DR_5;
+    start = HostClockGetTime( );
+    CHECK( LoRaMacMcpsRequest( &mcpsReq ) == LORAMAC_STATUS_OK );
+    while( McpsConfirms == confirms )
+    {
+        if( HostClockRunAll( HostClockGetTime( ) + 1 ) == true )
+        {
+            break;
+        }
+    }
+    CHECK( McpsConfirms == ( confirms + 1 ) );
+    CHECK( Uplinks == ( uplinks + 1 ) );
+    HostClockRun( UPLINK_GAP );
+    return LastUplink.Start - start;
+}
+
+static void TestFree( void )
+{
+    LoRaMacLbtStatus_t status;
+    RadioSimStats_t radio;
+    uint64_t delay;
+
+    Setup( LORAMAC_REGION_AS923, LBT_MODE_RSSI );
+    delay = Send( );
+    status = GetLbtStatus( );
+    RadioSimGetStats( &radio );
+    // One channel measured for the carrier sense time of AS923, 6 ms
+    CHECK( status.Scans == 1 );
+    CHECK( status.ScansBusy == 0 );
+    CHECK( radio.RssiReads == 6 );
+    CHECK( radio.Cads == 0 );
+    CHECK( delay >= 6000 );
+    CHECK( delay < 10000 );
+}
+
+static void TestPartiallyBusy( void )
+{
+    LoRaMacLbtStatus_t status;
+    uint32_t counts[NB_CHANNELS] = { 0 };
+
+    Setup( LORAMAC_REGION_AS923, LBT_MODE_RSSI );
+    // Two channels always busy, one busy 2 ms out of every 20 ms
+    RadioSimSetInterferer( Frequencies[0], INTERFERER_RSSI, 1, 1, false );
+    RadioSimSetInterferer( Frequencies[1], INTERFERER_RSSI, 1, 1, false );
+    RadioSimSetInterferer( Frequencies[2], INTERFERER_RSSI, 2000, 20000, false );
+    for( uint8_t i = 0; i < 40; i++ )
+    {
+        Send( );
+        for( uint8_t j = 0; j < NB_CHANNELS; j++ )
+        {
+            if( LastUplink.Frequency == Frequencies[j] )
+            {
+                counts[j]++;
+            }
+        }
+    }
+    status = GetLbtStatus( );
+    CHECK( counts[0] == 0 );
+    CHECK( counts[1] == 0 );
+    CHECK( counts[2] > 0 );
+    CHECK( counts[3] > 0 );
+    CHECK( status.Scans == 40 );
+    CHECK( status.ScansBusy == 0 );
+    CHECK( status.Channels[0].Busy == status.Channels[0].Probes );
+    CHECK( status.Channels[1].Busy == status.Channels[1].Probes );
+    CHECK( status.Channels[2].Busy > 0 );
+    CHECK( status.Channels[2].Busy < status.Channels[2].Probes );
+    CHECK( status.Channels[3].Busy == 0 );
+    CHECK( status.Channels[0].LastRssi == INTERFERER_RSSI );
+}
+
+static void TestAllBusy( void )
+{
+    LoRaMacLbtStatus_t status;
+    uint64_t delay;
+
+    Setup( LORAMAC_REGION_AS923, LBT_MODE_RSSI );
+    // Every channel busy for the first 500 ms
+    for( uint8_t i = 0; i < NB_CHANNELS; i++ )
+    {
+        RadioSimSetInterferer( Frequencies[i], INTERFERER_RSSI, 500000, UINT64_MAX, false );
+    }
+    delay = Send( );
+    status = GetLbtStatus( );
+    CHECK( delay >= 500000 );
+    CHECK( status.Scans == 1 );
+    CHECK( status.ScansBusy >= 2 );
+    CHECK( status.Backoffs == status.ScansBusy );
+    // The scans and the backoffs make up the wait
+    CHECK( ( status.BackoffTime + status.ScanTime ) * 1000 >= delay );
+    CHECK( ( status.BackoffTime + status.ScanTime ) * 1000 <= ( delay + 2000 * status.Backoffs ) );
+    // The backoff window doubled after each busy scan
+    CHECK( status.BackoffTime > ( 20 * status.Backoffs ) );
+
+    // The backoff starts over after a free scan
+    delay = Send( );
+    CHECK( delay < 10000 );
+    CHECK( GetLbtStatus( ).Backoffs == status.Backoffs );
+}
+
+static void TestCad( void )
+{
+    LoRaMacLbtStatus_t status;
+    RadioSimStats_t radio;
+    uint32_t counts[NB_CHANNELS] = { 0 };
+
+    // A LoRa interferer is caught by the CAD, the other one by the carrier
+    // sense AS923 still requires after it
+    Setup( LORAMAC_REGION_AS923, LBT_MODE_CAD );
+    RadioSimSetInterferer( Frequencies[0], INTERFERER_RSSI, 1, 1, true );
+    RadioSimSetInterferer( Frequencies[1], INTERFERER_RSSI, 1, 1, false );
+    for( uint8_t i = 0; i < 20; i++ )
+    {
+        Send( );
+        for( uint8_t j = 0; j < NB_CHANNELS; j++ )
+        {
+            if( LastUplink.Frequency == Frequencies[j] )
+            {
+                counts[j]++;
+            }
+        }
+    }
+    status = GetLbtStatus( );
+    RadioSimGetStats( &radio );
+    CHECK( counts[0] == 0 );
+    CHECK( counts[1] == 0 );
+    CHECK( status.Channels[0].Busy == status.Channels[0].Probes );
+    CHECK( status.Channels[1].Busy == status.Channels[1].Probes );
+    CHECK( status.CadTimeouts == 0 );
+    CHECK( radio.Cads == ( status.Channels[0].Probes + status.Channels[1].Probes +
+                           status.Channels[2].Probes + status.Channels[3].Probes ) );
+    // Only the channels without LoRa activity are measured
+    CHECK( radio.RssiReads >= ( 6 * 20 ) );
+    CHECK( status.Channels[0].LastRssi == 0 );
+    CHECK( status.Channels[1].LastRssi == INTERFERER_RSSI );
+
+    // Without a carrier sense required, the CAD alone misses the other one
+    Setup( LORAMAC_REGION_EU868, LBT_MODE_CAD );
+    for( uint8_t i = 0; i < 3; i++ )
+    {
+        RadioSimSetInterferer( 868100000 + 200000 * i, INTERFERER_RSSI, 1, 1, false );
+    }
+    Send( );
+    RadioSimGetStats( &radio );
+    CHECK( GetLbtStatus( ).Scans == 1 );
+    CHECK( radio.Cads == 1 );
+    CHECK( radio.RssiReads == 0 );
+}
+
+int main( int argc, char **argv )
+{
+    RUN( TestFree );
+    RUN( TestPartiallyBusy );
+    RUN( TestAllBusy );
+    RUN( TestCad );
+    return TEST_RESULT( );
+}
@@ -0,0 +1,403 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host test of the low power modes on the virtual clock: mode
+             selection, light sleep timer catch-up, wake-up latency
+             compensation, DIO wake-up and deep sleep latency
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <setjmp.h>
+#include "Arduino.h"
+#include "esp_sleep.h"
+#include "board-config.h"
+#include "rtc-board.h"
+#include "radio.h"
+#include "lpm-board.h"
+#include "host-clock.h"
+#include "host-gpio.h"
+#include "test.h"
+
+/*!
+ * Virtual time of a timer read [us], the resolution of the busy waits
+ */
+#define POLL_COST                                   10
+
+/*!
+ * Slow clock period, the resolution of the timer catch-up [us]
+ */
+#define RTC_RESOLUTION                              7
+
+/*!
+ * Boot time after a deep sleep timer wake-up [us]
+ */
+#define DEEP_SLEEP_BOOT_TIME                        150000
+
+bool Irq0Fired = false;
+bool Irq1Fired = false;
+
+/*!
+ * Radio status returned to the low power modes
+ */
+static RadioState_t RadioStatus = RF_IDLE;
+
+static RadioState_t RadioGetStatus( void )
+{
+    return RadioStatus;
+}
+
+const struct Radio_s Radio =
+{
+    .GetStatus = RadioGetStatus,
+};
+
+/*!
+ * Light sleep wake-up latency [us], alternately added and removed jitter [us]
+ * and the time into the sleep the DIO 1 rises at [us], UINT64_MAX if never
+ */
+static uint32_t SleepLatency = 0;
+static uint32_t SleepJitter = 0;
+static uint64_t DioRiseTime = UINT64_MAX;
+
+/*!
+ * Timer wake-up time set, last wake-up cause, light sleeps and whether the
+ * DIO 1 was a wake-up source during the last one
+ */
+static uint64_t WakeupTime = 0;
+static esp_sleep_wakeup_cause_t WakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+static uint32_t LightSleeps = 0;
+static bool DioWakeup = false;
+
+/*!
+ * Return point of the deep sleep, and its requested duration [us]
+ */
+static jmp_buf DeepSleepReturn;
+static uint64_t DeepSleepTime = 0;
+
+esp_err_t esp_sleep_enable_timer_wakeup( uint64_t time_in_us )
+{
+    WakeupTime = time_in_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup( void )
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source( esp_sleep_source_t source )
+{
+    return ESP_OK;
+}
+
+/*!
+ * \brief Light sleep with the hardware timer stopped, ended by the timer or
+ *        the DIO 1 after the wake-up latency
+ */
+esp_err_t esp_light_sleep_start( void )
+{
+    uint32_t latency = SleepLatency;
+
+    if( SleepJitter != 0 )
+    {
+        latency = ( ( LightSleeps & 1 ) == 0 ) ? SleepLatency + SleepJitter : SleepLatency - SleepJitter;
+    }
+    LightSleeps++;
+    DioWakeup = HostGpioGetWakeup( RADIO_DIO_1 );
+    if( ( DioWakeup == true ) && ( DioRiseTime < WakeupTime ) )
+    {
+        HostClockGate( DioRiseTime + latency );
+        HostGpioSet( RADIO_DIO_1, HIGH );
+        WakeupCause = ESP_SLEEP_WAKEUP_GPIO;
+    }
+    else
+    {
+        HostClockGate( WakeupTime + latency );
+        WakeupCause = ESP_SLEEP_WAKEUP_TIMER;
+    }
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start( void )
+{
+    DeepSleepTime = WakeupTime;
+    longjmp( DeepSleepReturn, 1 );
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause( void )
+{
+    return WakeupCause;
+}
+
+/*!
+ * Test timer, the virtual time it fired at [us] and its firings
+ */
+static TimerEvent_t TestTimer;
+static uint64_t FireTime = 0;
+static uint32_t Fired = 0;
+
+static void OnTestTimer( void )
+{
+    FireTime = HostClockGetTime( );
+    Fired++;
+}
+
+/*!
+ * \brief Starts the test timer
+ *
+ * \param [IN] timeout Timeout [ms]
+ *
+ * \retval due Virtual time the timer is due at [us]
+ */
+static uint64_t StartTestTimer( uint32_t timeout )
+{
+    TimerSetValue( &TestTimer, timeout );
+    TimerStart( &TestTimer );
+    return HostClockGetTime( ) + ( uint64_t )TestTimer.Timestamp * 1000 - timerRead( timer );
+}
+
+/*!
+ * \brief Returns the gap between the hardware timer and the virtual time
+ *
+ * \retval gap Virtual time minus timer time [ms]
+ */
+static int64_t GetTimerGap( void )
+{
+    return ( int64_t )( HostClockGetTime( ) / 1000 ) - ( int64_t )TimerGetTimerValue( );
+}
+
+/*!
+ * \brief Enters the low power mode until the test timer fires
+ *
+ * \param [IN] limit Maximum calls
+ *
+ * \retval calls Calls to LpmEnterLowPower
+ */
+static uint32_t RunLowPower( uint32_t limit )
+{
+    uint32_t fired = Fired;
+    uint32_t calls = 0;
+
+    while( ( Fired == fired ) && ( calls < limit ) )
+    {
+        LpmEnterLowPower( );
+        calls++;
+    }
+    return calls;
+}
+
+static void TestSelectMode( void )
+{
+    // Light sleep is opt-in for the application, deep sleep for the library
+    CHECK( LpmGetMode( ) == LPM_IDLE_MODE );
+    LpmSetLightSleepMode( LPM_APPLI_ID, LPM_ENABLE );
+    CHECK( LpmGetMode( ) == LPM_LIGHT_SLEEP_MODE );
+    LpmSetLightSleepMode( LPM_LIB_ID, LPM_DISABLE );
+    CHECK( LpmGetMode( ) == LPM_IDLE_MODE );
+    LpmSetLightSleepMode( LPM_LIB_ID, LPM_ENABLE );
+
+    // The default wake-up time is 1 ms, the event may be 1 ms closer and the
+    // light sleep lasts 2 ms at least
+    CHECK( LpmGetWakeupTime( ) == LPM_LIGHT_SLEEP_DEFAULT_LATENCY );
+    StartTestTimer( 3 );
+    CHECK( LpmGetMode( ) == LPM_IDLE_MODE );
+    StartTestTimer( 4 );
+    CHECK( LpmGetMode( ) == LPM_LIGHT_SLEEP_MODE );
+    RadioStatus = RF_RX_RUNNING;
+    CHECK( LpmGetMode( ) == LPM_LIGHT_SLEEP_MODE );
+    RadioStatus = RF_IDLE;
+
+    // Deep sleep needs consecutive requests, an idle radio and a timer event
+    // far enough
+    LpmSetDeepSleepMode( LPM_LIB_ID, LPM_ENABLE );
+    StartTestTimer( 2000 );
+    for( uint8_t i = 0; i < LPM_DEEP_SLEEP_REQUESTS; i++ )
+    {
+        CHECK( LpmGetMode( ) == LPM_IDLE_MODE );
+        LpmEnterLowPower( );
+    }
+    CHECK( LpmGetMode( ) == LPM_DEEP_SLEEP_MODE );
+    RadioStatus = RF_TX_RUNNING;
+    CHECK( LpmGetMode( ) == LPM_LIGHT_SLEEP_MODE );
+    RadioStatus = RF_IDLE;
+    StartTestTimer( LPM_DEEP_SLEEP_MIN_TIME - 1 );
+    CHECK( LpmGetMode( ) == LPM_LIGHT_SLEEP_MODE );
+    StartTestTimer( LPM_DEEP_SLEEP_MIN_TIME );
+    CHECK( LpmGetMode( ) == LPM_DEEP_SLEEP_MODE );
+    TimerStop( &TestTimer );
+    CHECK( LpmGetMode( ) == LPM_LIGHT_SLEEP_MODE );
+
+    // Any user disabling it restarts the requests count
+    StartTestTimer( 2000 );
+    LpmSetDeepSleepMode( LPM_APPLI_ID, LPM_DISABLE );
+    CHECK( LpmGetMode( ) == LPM_LIGHT_SLEEP_MODE );
+    LpmSetDeepSleepMode( LPM_APPLI_ID, LPM_ENABLE );
+    CHECK( LpmGetMode( ) == LPM_IDLE_MODE );
+    LpmSetDeepSleepMode( LPM_LIB_ID, LPM_DISABLE );
+    TimerStop( &TestTimer );
+}
+
+static void TestLightSleepCatchUp( void )
+{
+    LpmStatus_t before;
+    LpmStatus_t after;
+    uint64_t due;
+
+    SleepLatency = 400;
+    LpmGetStatus( &before );
+    due = StartTestTimer( 500 );
+    RunLowPower( 1000 );
+    LpmGetStatus( &after );
+
+    // The timer stopped during the sleep, it must have caught up with the RTC
+    CHECK( after.LightSleeps == before.LightSleeps + 1 );
+    CHECK( ( after.LightSleepTime - before.LightSleepTime ) >= 497 );
+    CHECK( GetTimerGap( ) <= 1 );
+    CHECK( GetTimerGap( ) >= -1 );
+    CHECK( ( FireTime + RTC_RESOLUTION ) >= due );
+    CHECK( FireTime < ( due + 1000 ) );
+}
+
+static void TestWakeupLatencyCompensation( void )
+{
+    LpmStatus_t status;
+    uint64_t lateness[40];
+
+    SleepLatency = 3000;
+    SleepJitter = 300;
+    for( uint8_t i = 0; i < 40; i++ )
+    {
+        uint64_t due = StartTestTimer( 100 );
+
+        RunLowPower( 100000 );
+        lateness[i] = ( FireTime > due ) ? FireTime - due : 0;
+        CHECK( ( FireTime + RTC_RESOLUTION ) >= due );
+    }
+    LpmGetStatus( &status );
+
+    // Before the latency is learned, the MCU wakes up after the event
+    CHECK( lateness[0] > 1000 );
+    // Once learned, the mean plus twice the jitter is compensated and the
+    // events run on time, to the busy wait resolution
+    for( uint8_t i = 30; i < 40; i++ )
+    {
+        CHECK( lateness[i] <= 2 * POLL_COST );
+    }
+    CHECK( status.LightSleepLatency >= 2900 );
+    CHECK( status.LightSleepLatency <= 3100 );
+    CHECK( status.LightSleepJitter >= 200 );
+    CHECK( status.LightSleepJitter <= 500 );
+    CHECK( LpmGetWakeupTime( ) >= ( SleepLatency + SleepJitter ) );
+    CHECK( GetTimerGap( ) <= 1 );
+    CHECK( GetTimerGap( ) >= -1 );
+    SleepJitter = 0;
+}
+
+static void TestDioWakeup( void )
+{
+    LpmStatus_t before;
+    LpmStatus_t after;
+
+    // A reception waiting for its DIO, with its timeout far
+    RadioStatus = RF_RX_RUNNING;
+    DioRiseTime = 200000;
+    Irq1Fired = false;
+    StartTestTimer( 900 );
+    LpmGetStatus( &before );
+    LpmEnterLowPower( );
+    LpmGetStatus( &after );
+
+    CHECK( DioWakeup == true );
+    CHECK( HostGpioGetWakeup( RADIO_DIO_1 ) == false );
+    CHECK( Irq1Fired == true );
+    CHECK( TestTimer.IsRunning == true );
+    CHECK( after.DioWakeups == before.DioWakeups + 1 );
+    // Only the timer wake-ups measure the latency
+    CHECK( after.LightSleepLatency == before.LightSleepLatency );
+    CHECK( GetTimerGap( ) <= 1 );
+    CHECK( GetTimerGap( ) >= -1 );
+
+    TimerStop( &TestTimer );
+    HostGpioSet( RADIO_DIO_1, LOW );
+    DioRiseTime = UINT64_MAX;
+    RadioStatus = RF_IDLE;
+}
+
+/*!
+ * \brief Runs the low power mode until the deep sleep, then boots from it
+ *
+ * \param [IN] timeout Timeout of the timer waking up from the deep sleep [ms]
+ */
+static void DeepSleepCycle( uint32_t timeout )
+{
+    volatile uint32_t calls = 0;
+
+    // The deep sleep mode is reset at boot, the requests count with it
+    LpmSetDeepSleepMode( LPM_LIB_ID, LPM_DISABLE );
+    LpmSetDeepSleepMode( LPM_LIB_ID, LPM_ENABLE );
+    StartTestTimer( timeout );
+    DeepSleepTime = 0;
+    if( setjmp( DeepSleepReturn ) == 0 )
+    {
+        while( calls < 100 )
+        {
+            LpmEnterLowPower( );
+            calls++;
+        }
+    }
+    CHECK( calls == LPM_DEEP_SLEEP_REQUESTS );
+    CHECK( DeepSleepTime != 0 );
+
+    // Reset: the RTC keeps running, the timers restart
+    HostClockAdvance( DeepSleepTime + DEEP_SLEEP_BOOT_TIME );
+    TimerListHead = NULL;
+    nextAlarm = 0;
+    timerWrite( timer, 0 );
+    WakeupCause = ESP_SLEEP_WAKEUP_TIMER;
+    LpmInit( );
+}
+
+static void TestDeepSleepLatency( void )
+{
+    LpmStatus_t before;
+    LpmStatus_t after;
+
+    LpmGetStatus( &before );
+    CHECK( before.DeepSleepLatency == 0 );
+    DeepSleepCycle( 5000 );
+    LpmGetStatus( &after );
+    CHECK( after.DeepSleeps == before.DeepSleeps + 1 );
+    CHECK( after.DeepSleepLatency >= ( DEEP_SLEEP_BOOT_TIME / 1000 ) - 1 );
+    CHECK( after.DeepSleepLatency <= ( DEEP_SLEEP_BOOT_TIME / 1000 ) + 1 );
+
+    // The next deep sleep ends earlier by the boot time
+    DeepSleepCycle( 5000 );
+    CHECK( DeepSleepTime <= ( 5000 - after.DeepSleepLatency ) * 1000ULL );
+    CHECK( DeepSleepTime >= ( 4999 - after.DeepSleepLatency ) * 1000ULL );
+    LpmGetStatus( &after );
+    CHECK( after.DeepSleeps == before.DeepSleeps + 2 );
+    CHECK( ( after.DeepSleepTime - before.DeepSleepTime ) >= 9000 );
+    LpmSetDeepSleepMode( LPM_LIB_ID, LPM_DISABLE );
+}
+
+int main( void )
+{
+    HostClockReset( );
+    HostGpioReset( );
+    HostClockSetPollCost( POLL_COST );
+    TimerInit( &TestTimer, OnTestTimer );
+
+    RUN( TestSelectMode );
+    RUN( TestLightSleepCatchUp );
+    RUN( TestWakeupLatencyCompensation );
+    RUN( TestDioWakeup );
+    RUN( TestDeepSleepLatency );
+    return TEST_RESULT( );
+}
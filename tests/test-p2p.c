@@ -0,0 +1,669 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host test of the point to point link layer on the simulated
+             radio, the other end of the link played by the test: windows,
+             selective ACKs, retries, implicit header, rate selection and
+             fallback, then the goodput and packets/s at each rate
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <string.h>
+#include "Arduino.h"
+#include "utilities.h"
+#include "p2p.h"
+#include "radio-sim.h"
+#include "host-clock.h"
+#include "test.h"
+
+/*!
+ * Frame header, as p2p.c writes it
+ */
+#define FRAME_ACK                                   0x80
+#define FRAME_ACK_REQ                               0x40
+#define FRAME_RATE_SHIFT                            3
+#define FRAME_RATE_MASK                             0x38
+#define FRAME_COUNT_MASK                            0x07
+
+/*!
+ * Delay of the ACKs after an ACK request, as the receiver of p2p.c [ms]
+ */
+#define PEER_ACK_DELAY                              5
+
+/*!
+ * Frames logged by the peer
+ */
+#define PEER_LOG_SIZE                               64
+
+/*!
+ * Output power of the peer [dBm]
+ */
+#define PEER_TX_POWER                               14
+
+/*!
+ * Other end of the link, on the network side of the simulated radio
+ */
+typedef struct sPeer
+{
+    /*!
+     * Rate the peer listens and answers on, frames at other rates are not
+     * heard
+     */
+    uint8_t Rate;
+    /*!
+     * Implicit header payload size of the link, 0 for the explicit header
+     */
+    uint8_t FixedPayload;
+    /*!
+     * Answers no ACK request
+     */
+    bool Silent;
+    /*!
+     * Frames of the window missed once, by index in the window
+     */
+    uint8_t Lost;
+    /*!
+     * Receiver window
+     */
+    bool WindowValid;
+    uint8_t Base;
+    uint8_t Bitmap;
+    int8_t MinSnr;
+    uint32_t Acks;
+    /*!
+     * Frames sent by the node, ACKs included
+     */
+    uint32_t Count;
+    RadioSimPacket_t Log[PEER_LOG_SIZE];
+}Peer_t;
+
+/*!
+ * Link events seen by the application of the node
+ */
+typedef struct sNodeEvents
+{
+    uint32_t WindowsDone;
+    uint32_t WindowsSucceeded;
+    uint64_t DoneTime;
+    uint32_t RxData;
+    uint8_t LastSeq;
+    uint8_t LastSize;
+    uint8_t LastPayload[P2P_MAX_PAYLOAD];
+    uint32_t RateChanges;
+    uint8_t Rates[16];
+}NodeEvents_t;
+
+static Peer_t Peer;
+static NodeEvents_t Node;
+static P2pParams_t Params;
+
+static void OnWindowDone( bool success )
+{
+    Node.WindowsDone++;
+    Node.WindowsSucceeded += ( success == true ) ? 1 : 0;
+    Node.DoneTime = HostClockGetTime( );
+}
+
+static void OnRxData( uint8_t seq, uint8_t *payload, uint8_t size, int16_t rssi, int8_t snr )
+{
+    Node.RxData++;
+    Node.LastSeq = seq;
+    Node.LastSize = size;
+    memcpy( Node.LastPayload, payload, size );
+}
+
+static void OnRateChanged( uint8_t rate )
+{
+    if( Node.RateChanges < sizeof( Node.Rates ) )
+    {
+        Node.Rates[Node.RateChanges] = rate;
+    }
+    Node.RateChanges++;
+}
+
+static P2pEvents_t Events =
+{
+    .WindowDone = OnWindowDone,
+    .RxData = OnRxData,
+    .RateChanged = OnRateChanged,
+};
+
+/*!
+ * \brief Returns the on air size of a frame of the link
+ */
+static uint8_t FrameLength( uint8_t size )
+{
+    return P2P_HEADER_SIZE + ( ( Peer.FixedPayload != 0 ) ? Peer.FixedPayload : size );
+}
+
+/*!
+ * \brief Returns the time on air of a frame at a rate [us]
+ */
+static uint32_t FrameTime( uint8_t rate, uint8_t size )
+{
+    const P2pRate_t *entry = P2pGetRate( rate );
+
+    return RadioSimGetLoRaTimeOnAir( entry->SpreadingFactor, entry->Bandwidth, true, FrameLength( size ) );
+}
+
+/*!
+ * \brief Puts a frame of the peer on the air at a rate
+ */
+static void PeerSend( uint64_t start, uint8_t rate, const uint8_t *frame, uint8_t size )
+{
+    RadioSimPacket_t packet;
+    const P2pRate_t *entry = P2pGetRate( rate );
+
+    memset( &packet, 0, sizeof( packet ) );
+    packet.Start = start;
+    packet.Frequency = Params.Frequency;
+    packet.Modem = MODEM_LORA;
+    packet.Datarate = entry->SpreadingFactor;
+    packet.Bandwidth = entry->Bandwidth;
+    packet.Power = PEER_TX_POWER;
+    packet.IqInverted = false;
+    packet.Size = ( Peer.FixedPayload != 0 ) ? P2P_HEADER_SIZE + Peer.FixedPayload : size;
+    memcpy( packet.Payload, frame, size );
+    RadioSimQueueDownlink( &packet );
+}
+
+/*!
+ * \brief Receiver of the peer, answers the ACK requests as p2p.c does
+ */
+static void PeerOnUplink( const RadioSimPacket_t *packet )
+{
+    const P2pRate_t *entry = P2pGetRate( Peer.Rate );
+    const uint8_t *frame = packet->Payload;
+    uint8_t count = ( frame[0] & FRAME_COUNT_MASK ) + 1;
+    uint8_t index = frame[1] - frame[2];
+    uint8_t ack[P2P_HEADER_SIZE];
+    uint8_t ackRate = Peer.Rate;
+
+    if( Peer.Count < PEER_LOG_SIZE )
+    {
+        Peer.Log[Peer.Count] = *packet;
+    }
+    Peer.Count++;
+
+    if( ( ( frame[0] & FRAME_ACK ) != 0 ) ||
+        ( packet->Datarate != entry->SpreadingFactor ) || ( packet->Bandwidth != entry->Bandwidth ) )
+    {
+        return;
+    }
+    if( ( Peer.Lost & ( 1 << index ) ) != 0 )
+    {
+        Peer.Lost &= ~( 1 << index );
+        return;
+    }
+    if( ( Peer.WindowValid == false ) || ( frame[2] != Peer.Base ) )
+    {
+        Peer.WindowValid = true;
+        Peer.Base = frame[2];
+        Peer.Bitmap = 0;
+        Peer.MinSnr = INT8_MAX;
+    }
+    Peer.Bitmap |= 1 << index;
+    Peer.MinSnr = MIN( Peer.MinSnr, packet->Snr );
+
+    if( ( ( frame[0] & FRAME_ACK_REQ ) == 0 ) || ( Peer.Silent == true ) )
+    {
+        return;
+    }
+    if( Peer.Bitmap == ( ( 1 << count ) - 1 ) )
+    {
+        ackRate = ( frame[0] & FRAME_RATE_MASK ) >> FRAME_RATE_SHIFT;
+    }
+    ack[0] = FRAME_ACK | ( ackRate << FRAME_RATE_SHIFT );
+    ack[1] = Peer.Base;
+    ack[2] = Peer.Bitmap;
+    ack[3] = ( uint8_t )Peer.MinSnr;
+    PeerSend( HostClockGetTime( ) + PEER_ACK_DELAY * 1000, Peer.Rate, ack, sizeof( ack ) );
+    Peer.Acks++;
+    Peer.Rate = ackRate;
+}
+
+/*!
+ * \brief Starts a test on a fresh clock, radio and link
+ *
+ * \param [IN] baseRate  Base rate
+ * \param [IN] autoRate  Automatic rate selection
+ * \param [IN] fixed     Implicit header payload size
+ * \param [IN] window    Window size
+ */
+static void Setup( uint8_t baseRate, bool autoRate, uint8_t fixed, uint8_t window )
+{
+    HostClockReset( );
+    RadioSimReset( 1 );
+    RadioSimSetUplinkHandler( PeerOnUplink );
+    memset( &Peer, 0, sizeof( Peer ) );
+    memset( &Node, 0, sizeof( Node ) );
+    Peer.Rate = baseRate;
+    Peer.FixedPayload = fixed;
+
+    Params.Frequency = 868100000;
+    Params.TxPower = 14;
+    Params.Coderate = 1;
+    Params.PreambleLen = 8;
+    Params.BaseRate = baseRate;
+    Params.MaxRate = P2P_RATE_COUNT - 1;
+    Params.AutoRate = autoRate;
+    Params.SnrMargin = 5;
+    Params.FixedPayload = fixed;
+    Params.WindowSize = window;
+    Params.MaxRetries = 4;
+    Params.LinkTimeout = 30000;
+    CHECK( P2pInit( &Params, &Events ) == true );
+    P2pResetStatistics( );
+}
+
+/*!
+ * \brief Runs the virtual clock until the node is done with a number of
+ *        windows
+ *
+ * \param [IN] windows Windows done since the setup
+ * \param [IN] limit   Time limit [ms]
+ *
+ * \retval done false on the time limit
+ */
+static bool RunWindows( uint32_t windows, uint32_t limit )
+{
+    uint64_t end = HostClockGetTime( ) + ( uint64_t )limit * 1000;
+
+    while( ( Node.WindowsDone < windows ) && ( HostClockGetTime( ) < end ) )
+    {
+        HostClockRun( 1000 );
+    }
+    return Node.WindowsDone >= windows;
+}
+
+/*!
+ * \brief Queues a window of frames whose first byte is the index in the window
+ */
+static void QueueWindow( uint8_t count, uint8_t size )
+{
+    uint8_t payload[P2P_MAX_PAYLOAD];
+
+    memset( payload, 0xA5, size );
+    for( uint8_t i = 0; i < count; i++ )
+    {
+        payload[0] = i;
+        CHECK( P2pSend( payload, size ) == true );
+    }
+}
+
+static void TestInit( void )
+{
+    P2pParams_t params;
+
+    Setup( 0, false, 0, 8 );
+    params = Params;
+    params.WindowSize = 0;
+    CHECK( P2pInit( &params, &Events ) == false );
+    params.WindowSize = P2P_WINDOW_SIZE + 1;
+    CHECK( P2pInit( &params, &Events ) == false );
+    params = Params;
+    params.MaxRate = P2P_RATE_COUNT;
+    CHECK( P2pInit( &params, &Events ) == false );
+    params = Params;
+    params.BaseRate = 3;
+    params.MaxRate = 2;
+    CHECK( P2pInit( &params, &Events ) == false );
+    params = Params;
+    params.MaxRetries = 0;
+    CHECK( P2pInit( &params, &Events ) == false );
+    params = Params;
+    params.FixedPayload = P2P_MAX_PAYLOAD + 1;
+    CHECK( P2pInit( &params, &Events ) == false );
+    CHECK( P2pInit( NULL, &Events ) == false );
+    CHECK( P2pInit( &Params, &Events ) == true );
+    CHECK( P2pGetRate( P2P_RATE_COUNT ) == NULL );
+    CHECK( P2pIsBusy( ) == false );
+    CHECK( P2pFlush( ) == false );
+}
+
+static void TestWindow( void )
+{
+    uint8_t sizes[] = { 10, 20, 30, 40 };
+    uint8_t payload[P2P_MAX_PAYLOAD];
+    P2pStatistics_t *stats;
+    uint8_t base;
+
+    Setup( 5, false, 0, 4 );
+    for( uint8_t i = 0; i < sizeof( sizes ); i++ )
+    {
+        memset( payload, i + 1, sizes[i] );
+        CHECK( P2pSend( payload, sizes[i] ) == true );
+    }
+    // The full window went out by itself
+    CHECK( P2pIsBusy( ) == true );
+    CHECK( P2pSend( payload, 1 ) == false );
+    CHECK( P2pFlush( ) == false );
+    CHECK( RunWindows( 1, 5000 ) == true );
+    CHECK( Node.WindowsSucceeded == 1 );
+    CHECK( P2pIsBusy( ) == false );
+
+    // Four data frames sent back to back, then the ACK
+    CHECK( Peer.Count == 4 );
+    CHECK( Peer.Acks == 1 );
+    base = Peer.Log[0].Payload[2];
+    for( uint8_t i = 0; i < 4; i++ )
+    {
+        const uint8_t *frame = Peer.Log[i].Payload;
+
+        CHECK( Peer.Log[i].Size == P2P_HEADER_SIZE + sizes[i] );
+        CHECK( frame[1] == ( uint8_t )( base + i ) );
+        CHECK( frame[2] == base );
+        CHECK( ( frame[0] & FRAME_COUNT_MASK ) == 3 );
+        CHECK( ( ( frame[0] & FRAME_RATE_MASK ) >> FRAME_RATE_SHIFT ) == 5 );
+        CHECK( ( ( frame[0] & FRAME_ACK_REQ ) != 0 ) == ( i == 3 ) );
+        CHECK( frame[3] == sizes[i] );
+        CHECK( frame[P2P_HEADER_SIZE] == i + 1 );
+        CHECK( frame[P2P_HEADER_SIZE + sizes[i] - 1] == i + 1 );
+        if( i > 0 )
+        {
+            // Only the rounding of the radio timer to the ms between frames
+            CHECK( ( Peer.Log[i].Start - Peer.Log[i - 1].Start - FrameTime( 5, sizes[i - 1] ) ) < 1000 );
+        }
+    }
+    stats = P2pGetStatistics( );
+    CHECK( stats->FramesSent == 4 );
+    CHECK( stats->Retransmissions == 0 );
+    CHECK( stats->AcksReceived == 1 );
+    CHECK( stats->WindowsDone == 1 );
+    CHECK( stats->BytesAcked == 100 );
+
+    // A partial window on flush, the next sequence numbers
+    QueueWindow( 2, 16 );
+    CHECK( P2pIsBusy( ) == false );
+    CHECK( P2pFlush( ) == true );
+    CHECK( RunWindows( 2, 5000 ) == true );
+    CHECK( Node.WindowsSucceeded == 2 );
+    CHECK( Peer.Count == 6 );
+    CHECK( Peer.Log[4].Payload[2] == ( uint8_t )( base + 4 ) );
+    CHECK( ( Peer.Log[4].Payload[0] & FRAME_COUNT_MASK ) == 1 );
+    CHECK( ( Peer.Log[5].Payload[0] & FRAME_ACK_REQ ) != 0 );
+    CHECK( stats->BytesAcked == 132 );
+}
+
+static void TestSelectiveAck( void )
+{
+    P2pStatistics_t *stats;
+    uint8_t base;
+
+    Setup( 5, false, 0, 4 );
+    // The peer misses the frames 1 and 2 of the first pass
+    Peer.Lost = 0x06;
+    QueueWindow( 4, 50 );
+    CHECK( RunWindows( 1, 5000 ) == true );
+    CHECK( Node.WindowsSucceeded == 1 );
+
+    // Only the two missing frames are sent again, the last one with the
+    // ACK request
+    CHECK( Peer.Count == 6 );
+    CHECK( Peer.Acks == 2 );
+    base = Peer.Log[0].Payload[2];
+    CHECK( ( Peer.Log[3].Payload[0] & FRAME_ACK_REQ ) != 0 );
+    CHECK( Peer.Log[4].Payload[1] == ( uint8_t )( base + 1 ) );
+    CHECK( ( Peer.Log[4].Payload[0] & FRAME_ACK_REQ ) == 0 );
+    CHECK( Peer.Log[5].Payload[1] == ( uint8_t )( base + 2 ) );
+    CHECK( ( Peer.Log[5].Payload[0] & FRAME_ACK_REQ ) != 0 );
+    CHECK( Peer.Bitmap == 0x0F );
+
+    stats = P2pGetStatistics( );
+    CHECK( stats->FramesSent == 6 );
+    CHECK( stats->Retransmissions == 2 );
+    CHECK( stats->AcksReceived == 2 );
+    CHECK( stats->BytesAcked == 200 );
+}
+
+static void TestAckTimeout( void )
+{
+    P2pStatistics_t *stats;
+    uint64_t start;
+
+    Setup( 5, false, 0, 2 );
+    Peer.Silent = true;
+    start = HostClockGetTime( );
+    QueueWindow( 2, 20 );
+    CHECK( RunWindows( 1, 10000 ) == true );
+    CHECK( Node.WindowsSucceeded == 0 );
+
+    // Every pass waited for its ACK before the next one
+    stats = P2pGetStatistics( );
+    CHECK( stats->AckTimeouts == Params.MaxRetries );
+    CHECK( stats->WindowsFailed == 1 );
+    CHECK( stats->FramesSent == 2 * Params.MaxRetries );
+    CHECK( stats->BytesAcked == 0 );
+    CHECK( ( Node.DoneTime - start ) >= ( uint64_t )Params.MaxRetries * 2 * FrameTime( 5, 0 ) );
+    // Already at the base rate, nothing to fall back to
+    CHECK( stats->RateFallbacks == 0 );
+
+    // The link comes back with the next window
+    Peer.Silent = false;
+    QueueWindow( 2, 20 );
+    CHECK( RunWindows( 2, 5000 ) == true );
+    CHECK( Node.WindowsSucceeded == 1 );
+    CHECK( stats->BytesAcked == 40 );
+}
+
+static void TestImplicitHeader( void )
+{
+    uint8_t payload[40];
+
+    Setup( 5, false, 32, 3 );
+    memset( payload, 0x5A, sizeof( payload ) );
+    CHECK( P2pSend( payload, 33 ) == false );
+    CHECK( P2pSend( payload, 5 ) == true );
+    CHECK( P2pSend( payload, 32 ) == true );
+    CHECK( P2pSend( payload, 0 ) == true );
+    CHECK( RunWindows( 1, 5000 ) == true );
+    CHECK( Node.WindowsSucceeded == 1 );
+
+    // Every frame, ACK aside, is padded to the fixed size, the header
+    // carries the payload size
+    CHECK( Peer.Count == 3 );
+    for( uint8_t i = 0; i < 3; i++ )
+    {
+        CHECK( Peer.Log[i].Size == P2P_HEADER_SIZE + 32 );
+    }
+    CHECK( Peer.Log[0].Payload[3] == 5 );
+    CHECK( Peer.Log[0].Payload[P2P_HEADER_SIZE + 4] == 0x5A );
+    CHECK( Peer.Log[0].Payload[P2P_HEADER_SIZE + 5] == 0 );
+    CHECK( Peer.Log[0].Payload[P2P_HEADER_SIZE + 31] == 0 );
+    CHECK( Peer.Log[1].Payload[3] == 32 );
+    CHECK( Peer.Log[2].Payload[3] == 0 );
+    CHECK( P2pGetStatistics( )->BytesAcked == 37 );
+}
+
+static void TestAutoRate( void )
+{
+    P2pStatistics_t *stats;
+    uint32_t windows = 0;
+
+    // SNR of -4 dB at 125 kHz: SF8 keeps the 5 dB margin above its floor
+    Setup( 0, true, 0, 4 );
+    RadioSimSetLink( 135, 0 );
+    for( uint8_t i = 0; i < 12; i++ )
+    {
+        QueueWindow( 4, 20 );
+        CHECK( RunWindows( ++windows, 60000 ) == true );
+    }
+    CHECK( Node.WindowsSucceeded == windows );
+    CHECK( P2pGetCurrentRate( ) == 4 );
+    CHECK( Peer.Rate == 4 );
+    // One rate up at a time, never above the one the SNR supports
+    CHECK( Node.RateChanges == 4 );
+    for( uint8_t i = 0; i < 4; i++ )
+    {
+        CHECK( Node.Rates[i] == i + 1 );
+    }
+
+    // The peer goes away: two missed ACKs and the node is back at the base
+    // rate
+    stats = P2pGetStatistics( );
+    Peer.Silent = true;
+    QueueWindow( 4, 20 );
+    CHECK( RunWindows( ++windows, 60000 ) == true );
+    CHECK( Node.WindowsSucceeded == windows - 1 );
+    CHECK( stats->RateFallbacks == 1 );
+    CHECK( P2pGetCurrentRate( ) == 0 );
+    CHECK( Node.Rates[4] == 0 );
+
+    // Once the peer fell back as well on its link timer, the link resumes
+    Peer.Silent = false;
+    Peer.Rate = 0;
+    QueueWindow( 4, 20 );
+    CHECK( RunWindows( ++windows, 60000 ) == true );
+    CHECK( Node.WindowsSucceeded == windows - 1 );
+}
+
+/*!
+ * \brief Puts a data frame on the air to the listening node and runs the
+ *        clock to its end
+ */
+static void SendData( uint8_t rate, uint8_t targetRate, uint8_t base, uint8_t index, uint8_t count, bool ackReq )
+{
+    uint8_t frame[P2P_HEADER_SIZE + 8];
+
+    frame[0] = ( targetRate << FRAME_RATE_SHIFT ) | ( count - 1 ) | ( ( ackReq == true ) ? FRAME_ACK_REQ : 0 );
+    frame[1] = base + index;
+    frame[2] = base;
+    frame[3] = 8;
+    memset( frame + P2P_HEADER_SIZE, index, 8 );
+    PeerSend( HostClockGetTime( ), rate, frame, sizeof( frame ) );
+    HostClockRun( FrameTime( rate, 8 ) + 1000 );
+}
+
+static void TestReceiver( void )
+{
+    P2pStatistics_t *stats;
+    const uint8_t *ack;
+
+    Setup( 5, false, 0, 8 );
+    RadioSimSetLink( 120, 0 );
+    P2pListen( );
+    stats = P2pGetStatistics( );
+
+    // A window of three with the second frame missing and the first one
+    // twice. The ACK keeps the current rate.
+    SendData( 5, 6, 16, 0, 3, false );
+    SendData( 5, 6, 16, 0, 3, false );
+    SendData( 5, 6, 16, 2, 3, true );
+    CHECK( Node.RxData == 2 );
+    CHECK( Node.LastSeq == 18 );
+    CHECK( Node.LastSize == 8 );
+    CHECK( Node.LastPayload[7] == 2 );
+    CHECK( stats->FramesReceived == 2 );
+    CHECK( stats->Duplicates == 1 );
+    CHECK( stats->BytesReceived == 16 );
+    HostClockRun( ( PEER_ACK_DELAY + 1 ) * 1000 + FrameTime( 5, 0 ) );
+    CHECK( Peer.Count == 1 );
+    ack = Peer.Log[0].Payload;
+    CHECK( Peer.Log[0].Size == P2P_HEADER_SIZE );
+    CHECK( ( ack[0] & FRAME_ACK ) != 0 );
+    CHECK( ( ( ack[0] & FRAME_RATE_MASK ) >> FRAME_RATE_SHIFT ) == 5 );
+    CHECK( ack[1] == 16 );
+    CHECK( ack[2] == 0x05 );
+    CHECK( ( int8_t )ack[3] == 11 );
+    CHECK( P2pGetCurrentRate( ) == 5 );
+
+    // The missing frame completes the window, the node moves to the
+    // requested rate after its ACK
+    SendData( 5, 6, 16, 1, 3, true );
+    HostClockRun( ( PEER_ACK_DELAY + 1 ) * 1000 + FrameTime( 5, 0 ) );
+    CHECK( Peer.Count == 2 );
+    ack = Peer.Log[1].Payload;
+    CHECK( ack[2] == 0x07 );
+    CHECK( ( ( ack[0] & FRAME_RATE_MASK ) >> FRAME_RATE_SHIFT ) == 6 );
+    CHECK( P2pGetCurrentRate( ) == 6 );
+    CHECK( Node.RateChanges == 1 );
+
+    // The node listens on the new rate
+    SendData( 6, 6, 24, 0, 1, false );
+    CHECK( Node.RxData == 4 );
+    CHECK( Node.LastSeq == 24 );
+
+    // A silent link brings it back to the base rate
+    HostClockRun( ( uint64_t )Params.LinkTimeout * 1000 );
+    CHECK( P2pGetCurrentRate( ) == 5 );
+    CHECK( stats->RateFallbacks == 1 );
+    SendData( 5, 5, 32, 0, 1, false );
+    CHECK( Node.RxData == 5 );
+    P2pStop( );
+}
+
+/*!
+ * \brief Goodput and packets/s at each rate of the table, with the frames
+ *        of the examples/P2P_Benchmark sketch. The time is the virtual one
+ *        of the simulated radio.
+ */
+static void TestBenchmark( void )
+{
+    uint32_t previous = 0;
+
+    Setup( 0, false, 0, 8 );
+    for( uint8_t rate = 0; rate < P2P_RATE_COUNT; rate++ )
+    {
+        const P2pRate_t *entry = P2pGetRate( rate );
+        P2pStatistics_t *stats = P2pGetStatistics( );
+        uint32_t windows = Node.WindowsDone;
+        uint32_t bytes;
+        uint32_t frames;
+        uint64_t start;
+        uint64_t elapsed;
+        uint64_t ideal;
+        uint32_t goodput;
+
+        // The warm-up window moves both ends to the rate
+        P2pSetRate( rate );
+        QueueWindow( 8, 64 );
+        CHECK( RunWindows( ++windows, 300000 ) == true );
+        CHECK( P2pGetCurrentRate( ) == rate );
+
+        start = HostClockGetTime( );
+        bytes = stats->BytesAcked;
+        frames = stats->FramesSent;
+        for( uint8_t i = 0; i < 4; i++ )
+        {
+            QueueWindow( 8, 64 );
+            CHECK( RunWindows( ++windows, 300000 ) == true );
+        }
+        elapsed = Node.DoneTime - start;
+        bytes = stats->BytesAcked - bytes;
+        frames = stats->FramesSent - frames;
+        goodput = ( uint32_t )( bytes * 1000000ULL / elapsed );
+        printf( "SF%u BW%u: %u bytes in %u ms, goodput %u B/s, %.2f packets/s\n", entry->SpreadingFactor,
+                125 << entry->Bandwidth, ( unsigned )bytes, ( unsigned )( elapsed / 1000 ), ( unsigned )goodput,
+                frames * 1e6 / elapsed );
+
+        // No retransmission and no idle time but the ACK turnaround and
+        // the rounding of the radio timer to the ms
+        CHECK( frames == 32 );
+        ideal = 4 * ( 8 * ( uint64_t )FrameTime( rate, 64 ) + PEER_ACK_DELAY * 1000 + FrameTime( rate, 0 ) );
+        CHECK( elapsed >= ideal );
+        CHECK( elapsed <= ( ideal + 4 * 10 * 1000 ) );
+        CHECK( goodput > previous );
+        previous = goodput;
+    }
+    CHECK( Node.WindowsSucceeded == Node.WindowsDone );
+}
+
+int main( void )
+{
+    RUN( TestInit );
+    RUN( TestWindow );
+    RUN( TestSelectiveAck );
+    RUN( TestAckTimeout );
+    RUN( TestImplicitHeader );
+    RUN( TestAutoRate );
+    RUN( TestReceiver );
+    RUN( TestBenchmark );
+    return TEST_RESULT( );
+}
@@ -0,0 +1,230 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host test of the uplink payload codec: round trip of a random
+             walk, lost frames and acknowledges, and more frames than sample
+             identifiers without acknowledge. With --frames it prints the
+             schema and every delivered frame with its decoded sample, which
+             tools/payload_codec.py --check decodes again
+
+             test-payload-codec [--frames]
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "test.h"
+#include "payload-codec.h"
+
+/*!
+ * Schema of the LoRaWAN_HDC1080 example
+ */
+#define HDC1080_FIELDS( FIELD )                     \
+    FIELD( Temperature, -40.0f, 125.0f, 0.01f )     \
+    FIELD( Humidity, 0.0f, 100.0f, 0.1f )           \
+    FIELD( Battery, 0.0f, 12500.0f, 10.0f )
+
+PAYLOAD_CODEC_DEFINE( Hdc1080, HDC1080_FIELDS )
+
+#define HDC1080_SCHEMA "Temperature:-40:125:0.01,Humidity:0:100:0.1,Battery:0:12500:10"
+
+/*!
+ * Size of an absolute frame: header and 15, 10 and 11 field bits
+ */
+#define ABSOLUTE_SIZE                               6
+
+static bool Frames = false;
+static uint32_t Seed;
+
+static PayloadCodec_t Codec;
+static PayloadCodecDecoder_t Decoder;
+static Hdc1080Sample_t Sample;
+
+/*!
+ * \brief Returns a uniform random number in [0, 1)
+ */
+static float Random( void )
+{
+    Seed = Seed * 1664525 + 1013904223;
+    return ( Seed >> 8 ) / 16777216.0f;
+}
+
+/*!
+ * \brief Starts a scenario: new encoder, decoder and sample
+ */
+static void Start( uint32_t seed )
+{
+    memset( &Codec, 0, sizeof( Codec ) );
+    Hdc1080Init( &Codec );
+    Hdc1080DecoderInit( &Decoder );
+    Sample.Temperature = 21.5f;
+    Sample.Humidity = 45.0f;
+    Sample.Battery = 4100.0f;
+    Seed = seed;
+    if( Frames == true )
+    {
+        printf( "schema %s\n", HDC1080_SCHEMA );
+    }
+}
+
+/*!
+ * \brief Moves the sample by a random walk, at times out of the field range
+ */
+static void Walk( void )
+{
+    Sample.Temperature += ( Random( ) - 0.5f ) * 0.4f;
+    Sample.Humidity += ( Random( ) - 0.5f ) * 2.0f;
+    Sample.Battery -= Random( ) * 5.0f;
+    if( Random( ) < 0.05f )
+    {
+        Sample.Temperature = ( Random( ) < 0.5f ) ? -60.0f : 150.0f;
+    }
+}
+
+/*!
+ * \brief Checks a decoded field against the encoded value, clamped
+ */
+static bool IsClose( const PayloadCodecField_t *field, float decoded, float value )
+{
+    value = fminf( fmaxf( value, field->Min ), field->Max );
+    return fabsf( decoded - value ) <= ( field->Step * 0.51f );
+}
+
+/*!
+ * \brief Encodes the sample and decodes the frame when it is delivered
+ *
+ * \param [IN]  delivered The frame reaches the decoder
+ * \param [OUT] size      Frame size
+ *
+ * \retval header First frame byte, identifier and distance to the reference
+ */
+static uint8_t Send( bool delivered, uint8_t *size )
+{
+    uint8_t frame[16];
+    Hdc1080Sample_t decoded = { 0 };
+
+    *size = Hdc1080Encode( &Codec, &Sample, frame, sizeof( frame ) );
+    CHECK( *size > 0 );
+    if( delivered == false )
+    {
+        return frame[0];
+    }
+    CHECK( Hdc1080Decode( &Decoder, frame, *size, &decoded ) == true );
+    CHECK( IsClose( &Hdc1080Fields[0], decoded.Temperature, Sample.Temperature ) );
+    CHECK( IsClose( &Hdc1080Fields[1], decoded.Humidity, Sample.Humidity ) );
+    CHECK( IsClose( &Hdc1080Fields[2], decoded.Battery, Sample.Battery ) );
+    if( Frames == true )
+    {
+        printf( "frame " );
+        for( uint8_t i = 0; i < *size; i++ )
+        {
+            printf( "%02x", frame[i] );
+        }
+        printf( " %u %.4f %.4f %.4f\n", frame[0] >> 4, decoded.Temperature, decoded.Humidity, decoded.Battery );
+    }
+    return frame[0];
+}
+
+static void TestRoundTrip( void )
+{
+    uint32_t deltaSize = 0;
+    uint8_t size;
+
+    Start( 1 );
+    // Nothing is acknowledged yet
+    CHECK( ( Send( true, &size ) & 0x0F ) == 0 );
+    CHECK( size == ABSOLUTE_SIZE );
+    PayloadCodecAck( &Codec );
+
+    for( uint32_t i = 0; i < 200; i++ )
+    {
+        Walk( );
+        Send( true, &size );
+        PayloadCodecAck( &Codec );
+        deltaSize += size;
+    }
+    CHECK( deltaSize < ( 200 * ABSOLUTE_SIZE * 3 / 4 ) );
+
+    // The reference is kept across a new init with the same schema, as in
+    // RTC memory across deep sleep
+    Hdc1080Init( &Codec );
+    CHECK( ( Send( true, &size ) & 0x0F ) == 1 );
+}
+
+static void TestLostAcks( void )
+{
+    uint8_t size;
+
+    Start( 2 );
+    for( uint32_t i = 0; i < 500; i++ )
+    {
+        bool delivered = Random( ) < 0.7f;
+
+        Walk( );
+        Send( delivered, &size );
+        // Only a delivered frame is acknowledged, and the ACK may be lost
+        if( ( delivered == true ) && ( Random( ) < 0.5f ) )
+        {
+            PayloadCodecAck( &Codec );
+        }
+    }
+}
+
+static void TestIdWrap( void )
+{
+    uint8_t header;
+    uint8_t size;
+
+    Start( 3 );
+    Send( true, &size );
+    PayloadCodecAck( &Codec );
+
+    // The reference identifier is reused by the 16th frame after it, which
+    // replaces it in the decoder
+    for( uint32_t i = 1; i <= 40; i++ )
+    {
+        Walk( );
+        header = Send( true, &size );
+        if( i < PAYLOAD_CODEC_IDS )
+        {
+            CHECK( ( header & 0x0F ) == ( i & 0x0F ) );
+        }
+        else
+        {
+            CHECK( ( header & 0x0F ) == 0 );
+        }
+    }
+
+    // Coded against the reference again once acknowledged
+    PayloadCodecAck( &Codec );
+    Walk( );
+    CHECK( ( Send( true, &size ) & 0x0F ) == 1 );
+
+    // Same without delivering most of the frames
+    for( uint32_t i = 1; i <= 40; i++ )
+    {
+        Walk( );
+        Send( ( i % 7 ) == 0, &size );
+    }
+}
+
+int main( int argc, char **argv )
+{
+    if( ( argc > 1 ) && ( strcmp( argv[1], "--frames" ) == 0 ) )
+    {
+        Frames = true;
+    }
+    RUN( TestRoundTrip );
+    RUN( TestLostAcks );
+    RUN( TestIdWrap );
+    return TEST_RESULT( );
+}
@@ -0,0 +1,496 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host test of the confirmed uplink retransmissions against the
+             in-process network server, on the simulated radio and the
+             virtual clock: the datarates MIB_RETRY_ADAPTIVE picks within the
+             payload limits of EU868 and US915, the redraw away from a jammed
+             channel, the MIB_RETRY_DEADLINE confirm, then seeded nodes on a
+             fading link comparing the confirmed uplinks delivered per
+             second of airtime of the fixed and adaptive policies
+
+             test-retry [nodes]
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "LoRaMac.h"
+#include "LoRaMacTest.h"
+#include "host-clock.h"
+#include "host-board.h"
+#include "radio-sim.h"
+#include "network-server.h"
+#include "test.h"
+
+/*!
+ * Transmissions of a confirmed uplink at most
+ */
+#define NB_TRIALS                                   8
+
+/*!
+ * Confirmed uplinks of a node of the comparison
+ */
+#define NODE_UPLINKS                                100
+
+/*!
+ * Application uplink period of the comparison [us]
+ */
+#define UPLINK_PERIOD                               300000000ULL
+
+/*!
+ * Jammed channels of the redraw test, half of the EU868 channels with the
+ * CFList
+ */
+static const uint32_t JammedFrequencies[] = { 868100000, 868500000, 867300000, 867700000 };
+
+static uint8_t DevEui[] = { 0x00, 0x80, 0xE1, 0x15, 0x00, 0x0A, 0xB1, 0x37 };
+static uint8_t AppEui[] = { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x12, 0x34 };
+static uint8_t AppKey[] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                            0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+
+/*!
+ * Results of a policy over the nodes of the comparison
+ */
+typedef struct sPolicyResult
+{
+    uint32_t Uplinks;
+    uint32_t Delivered;
+    /*!
+     * Time on air of the data uplinks, repetitions included [us]
+     */
+    uint64_t AirTime;
+}PolicyResult_t;
+
+static uint32_t McpsConfirms;
+static McpsConfirm_t LastMcpsConfirm;
+static uint32_t MlmeConfirms;
+static MlmeConfirm_t LastMlmeConfirm;
+
+static void OnMacMcpsConfirm( McpsConfirm_t *mcpsConfirm )
+{
+    McpsConfirms++;
+    LastMcpsConfirm = *mcpsConfirm;
+}
+
+static void OnMacMcpsIndication( McpsIndication_t *mcpsIndication )
+{
+}
+
+static void OnMacMlmeConfirm( MlmeConfirm_t *mlmeConfirm )
+{
+    MlmeConfirms++;
+    LastMlmeConfirm = *mlmeConfirm;
+}
+
+static void OnMacMlmeIndication( MlmeIndication_t *mlmeIndication )
+{
+}
+
+static uint8_t GetBatteryLevel( void )
+{
+    return 128;
+}
+
+static float GetTemperatureLevel( void )
+{
+    return 25.0f;
+}
+
+static LoRaMacPrimitives_t Primitives =
+{
+    .MacMcpsConfirm = OnMacMcpsConfirm,
+    .MacMcpsIndication = OnMacMcpsIndication,
+    .MacMlmeConfirm = OnMacMlmeConfirm,
+    .MacMlmeIndication = OnMacMlmeIndication,
+};
+
+static LoRaMacCallback_t Callbacks =
+{
+    .GetBatteryLevel = GetBatteryLevel,
+    .GetTemperatureLevel = GetTemperatureLevel,
+};
+
+/*!
+ * \brief Returns the server parameters of the tests, answering in RX1
+ */
+static NetworkServerParams_t GetServerParams( LoRaMacRegion_t region )
+{
+    NetworkServerParams_t params;
+
+    memset( &params, 0, sizeof( params ) );
+    params.Region = region;
+    memcpy( params.DevEui, DevEui, sizeof( DevEui ) );
+    memcpy( params.AppEui, AppEui, sizeof( AppEui ) );
+    memcpy( params.AppKey, AppKey, sizeof( AppKey ) );
+    params.DevAddr = 0x26011F42;
+    params.CfList = true;
+    params.AdrMargin = 10.0f;
+    return params;
+}
+
+/*!
+ * \brief Runs the virtual clock, one event at a time, until a primitive
+ *
+ * \param [IN] count Primitive counter to wait on
+ * \param [IN] value Counter value before the wait
+ *
+ * \retval done false when nothing is left to run
+ */
+static bool RunUntil( const uint32_t *count, uint32_t value )
+{
+    while( *count == value )
+    {
+        if( ( HostClockRunAll( HostClockGetTime( ) + 1 ) == true ) && ( *count == value ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Starts a new node and joins it, the link set by the caller after
+ *
+ * \param [IN] params    Server parameters
+ * \param [IN] seed      Seed of the board, the radio and the server
+ * \param [IN] adaptive  Value of MIB_RETRY_ADAPTIVE
+ * \param [IN] dutyCycle Enforces the duty cycle
+ *
+ * \retval joined false when the join failed
+ */
+static bool StartNode( const NetworkServerParams_t *params, uint32_t seed, bool adaptive, bool dutyCycle )
+{
+    MibRequestConfirm_t mibReq;
+    MlmeReq_t mlmeReq;
+    uint32_t confirms = MlmeConfirms;
+
+    HostClockReset( );
+    HostBoardReset( seed, false );
+    RadioSimReset( seed );
+    RadioSimSetLink( 100.0f, 0.0f );
+    NetworkServerReset( params, seed );
+
+    // The MAC only starts over a session which is not joined
+    mibReq.Type = MIB_NETWORK_JOINED;
+    mibReq.Param.IsNetworkJoined = false;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    CHECK( LoRaMacInitialization( &Primitives, &Callbacks, params->Region ) == LORAMAC_STATUS_OK );
+    mibReq.Type = MIB_ADR;
+    mibReq.Param.AdrEnable = params->Adr;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    LoRaMacTestSetDutyCycleOn( dutyCycle );
+
+    mlmeReq.Type = MLME_JOIN;
+    mlmeReq.Req.Join.DevEui = DevEui;
+    mlmeReq.Req.Join.AppEui = AppEui;
+    mlmeReq.Req.Join.AppKey = AppKey;
+    mlmeReq.Req.Join.NbTrials = 1;
+    if( ( LoRaMacMlmeRequest( &mlmeReq ) != LORAMAC_STATUS_OK ) ||
+        ( RunUntil( &MlmeConfirms, confirms ) == false ) ||
+        ( LastMlmeConfirm.Status != LORAMAC_EVENT_INFO_STATUS_OK ) )
+    {
+        return false;
+    }
+
+    // The history starts with the data uplinks, the policy is kept with the
+    // context across the initializations
+    mibReq.Type = MIB_RETRY_ADAPTIVE;
+    mibReq.Param.RetryAdaptive = adaptive;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_RETRY_DEADLINE;
+    mibReq.Param.RetryDeadline = 0;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    mibReq.Type = MIB_RETRY_STATUS;
+    LoRaMacMibSetRequestConfirm( &mibReq );
+    return true;
+}
+
+static void SetDeadline( uint32_t deadline )
+{
+    MibRequestConfirm_t mibReq;
+
+    mibReq.Type = MIB_RETRY_DEADLINE;
+    mibReq.Param.RetryDeadline = deadline;
+    CHECK( LoRaMacMibSetRequestConfirm( &mibReq ) == LORAMAC_STATUS_OK );
+}
+
+static LoRaMacRetryStatus_t GetRetryStatus( void )
+{
+    MibRequestConfirm_t mibReq;
+
+    mibReq.Type = MIB_RETRY_STATUS;
+    LoRaMacMibGetRequestConfirm( &mibReq );
+    return *mibReq.Param.RetryStatus;
+}
+
+/*!
+ * \brief Sends a confirmed uplink and waits for its confirm
+ *
+ * \param [IN] datarate Datarate of the first transmission, without ADR
+ * \param [IN] size     Payload size
+ *
+ * \retval sent false when the MAC did not confirm
+ */
+static bool Send( int8_t datarate, uint8_t size )
+{
+    uint8_t payload[242] = { 0 };
+    uint32_t confirms = McpsConfirms;
+    McpsReq_t mcpsReq;
+
+    mcpsReq.Type = MCPS_CONFIRMED;
+    mcpsReq.Req.Confirmed.fPort = 2;
+    mcpsReq.Req.Confirmed.fBuffer = payload;
+    mcpsReq.Req.Confirmed.fBufferSize = size;
+    mcpsReq.Req.Confirmed.NbTrials = NB_TRIALS;
+    mcpsReq.Req.Confirmed.Datarate = datarate;
+    while( LoRaMacMcpsRequest( &mcpsReq ) == LORAMAC_STATUS_BUSY )
+    {
+        if( HostClockRunAll( HostClockGetTime( ) + 1 ) == true )
+        {
+            return false;
+        }
+    }
+    return RunUntil( &McpsConfirms, confirms );
+}
+
+/*!
+ * \brief Sends lossy confirmed uplinks with the adaptive policy and checks
+ *        the datarates tried stay between the first one and the lowest one
+ *        carrying the payload
+ *
+ * \param [IN] region   Channel plan
+ * \param [IN] pathLoss Path loss, beyond the first datarate [dB]
+ * \param [IN] datarate Datarate of the first transmissions
+ * \param [IN] size     Payload size
+ * \param [IN] lowest   Lowest datarate carrying the payload
+ */
+static void CheckDatarates( LoRaMacRegion_t region, float pathLoss, int8_t datarate, uint8_t size, int8_t lowest )
+{
+    NetworkServerParams_t params = GetServerParams( region );
+    LoRaMacRetryStatus_t status;
+    uint32_t acked = 0;
+
+    CHECK( StartNode( &params, 1, true, false ) == true );
+    RadioSimSetLink( pathLoss, 3.0f );
+    for( uint8_t i = 0; i < 40; i++ )
+    {
+        CHECK( Send( datarate, size ) == true );
+        // Never a retransmission the datarate cannot carry
+        CHECK( LastMcpsConfirm.Status != LORAMAC_EVENT_INFO_STATUS_TX_DR_PAYLOAD_SIZE_ERROR );
+        acked += ( LastMcpsConfirm.AckReceived == true ) ? 1 : 0;
+    }
+    status = GetRetryStatus( );
+    for( int8_t dr = 0; dr < 16; dr++ )
+    {
+        if( ( dr < lowest ) || ( dr > datarate ) )
+        {
+            CHECK( status.Attempts[dr] == 0 );
+        }
+    }
+    // The first datarate barely gets through, the retransmissions went down
+    // to the lowest one
+    CHECK( status.Attempts[datarate] > 0 );
+    CHECK( status.Attempts[lowest] > 0 );
+    CHECK( acked > 0 );
+    CHECK( status.Delivered == acked );
+}
+
+static void TestDatarates( void )
+{
+    // 60 bytes are over the 51 bytes of DR0 to DR2
+    CheckDatarates( LORAMAC_REGION_EU868, 143.0f, DR_5, 60, DR_3 );
+    // The lowest datarate of the region is the floor
+    CheckDatarates( LORAMAC_REGION_EU868, 148.0f, DR_2, 10, DR_0 );
+    // 20 bytes are over the 11 bytes of DR0, DR4 is above the first one
+    CheckDatarates( LORAMAC_REGION_US915, 151.0f, DR_3, 20, DR_1 );
+}
+
+/*!
+ * \brief Sends confirmed uplinks with half of the channels jammed at the
+ *        node, which loses the acknowledges sent on them
+ *
+ * \param [IN]  adaptive Value of MIB_RETRY_ADAPTIVE
+ * \param [OUT] status   Retransmission status after the uplinks
+ *
+ * \retval repeats Uplinks jammed again after their first retransmission
+ */
+static uint32_t SendJammed( bool adaptive, LoRaMacRetryStatus_t *status )
+{
+    NetworkServerParams_t params = GetServerParams( LORAMAC_REGION_EU868 );
+    uint32_t repeats = 0;
+
+    CHECK( StartNode( &params, 2, adaptive, false ) == true );
+    RadioSimSetLink( 110.0f, 0.0f );
+    for( uint8_t i = 0; i < ( sizeof( JammedFrequencies ) / sizeof( JammedFrequencies[0] ) ); i++ )
+    {
+        RadioSimSetInterferer( JammedFrequencies[i], -60, 1, 1, false );
+    }
+    for( uint16_t i = 0; i < 400; i++ )
+    {
+        CHECK( Send( DR_5, 10 ) == true );
+        // Nothing but the jammed channels loses the acknowledges
+        if( ( LastMcpsConfirm.AckReceived == false ) || ( LastMcpsConfirm.NbRetries > 2 ) )
+        {
+            repeats++;
+        }
+    }
+    *status = GetRetryStatus( );
+    return repeats;
+}
+
+static void TestChannelRedraw( void )
+{
+    LoRaMacRetryStatus_t status;
+    uint32_t fixedRepeats;
+    uint32_t repeats;
+
+    // The fixed policy draws a jammed channel again one time in two
+    fixedRepeats = SendJammed( false, &status );
+    CHECK( fixedRepeats > 50 );
+
+    // The adaptive one redraws away from the channels 0, 2, 4 and 6 once
+    // their acknowledges are lost, landing on one of them after all its
+    // draws only
+    repeats = SendJammed( true, &status );
+    CHECK( ( repeats * 4 ) < fixedRepeats );
+    CHECK( status.Delivered == 400 );
+    CHECK( status.Failed == 0 );
+    CHECK( status.FailedChannels[0] == 0x55 );
+    CHECK( status.FailedChannels[1] == 0 );
+}
+
+/*!
+ * \brief Sends a confirmed uplink never acknowledged under a deadline
+ *
+ * \param [IN] adaptive Value of MIB_RETRY_ADAPTIVE
+ * \param [IN] deadline Value of MIB_RETRY_DEADLINE [ms]
+ */
+static void SendUnacknowledged( bool adaptive, uint32_t deadline )
+{
+    NetworkServerParams_t params = GetServerParams( LORAMAC_REGION_EU868 );
+    NetworkServerStats_t stats;
+    LoRaMacRetryStatus_t status;
+    uint64_t start;
+
+    CHECK( StartNode( &params, 3, adaptive, false ) == true );
+    RadioSimSetLink( 110.0f, 0.0f );
+    // Every acknowledge lost
+    NetworkServerSetLoss( 1.0f );
+    SetDeadline( deadline );
+
+    start = HostClockGetTime( );
+    CHECK( Send( DR_5, 10 ) == true );
+    NetworkServerGetStats( &stats );
+    status = GetRetryStatus( );
+    CHECK( LastMcpsConfirm.AckReceived == false );
+    CHECK( status.Failed == 1 );
+    if( deadline == 0 )
+    {
+        CHECK( LastMcpsConfirm.Status != LORAMAC_EVENT_INFO_STATUS_TX_DEADLINE );
+        CHECK( LastMcpsConfirm.NbRetries == NB_TRIALS );
+        CHECK( status.DeadlineMisses == 0 );
+        return;
+    }
+    CHECK( LastMcpsConfirm.Status == LORAMAC_EVENT_INFO_STATUS_TX_DEADLINE );
+    CHECK( LastMcpsConfirm.NbRetries < NB_TRIALS );
+    CHECK( LastMcpsConfirm.NbRetries == ( stats.Retransmissions + 1 ) );
+    CHECK( status.DeadlineMisses == 1 );
+    // The last transmission could still have been acknowledged in time, the
+    // confirm comes after its ACK timeout
+    CHECK( ( HostClockGetTime( ) - start ) <= ( deadline + 3000 ) * 1000ULL );
+}
+
+static void TestDeadline( void )
+{
+    SendUnacknowledged( false, 0 );
+    SendUnacknowledged( false, 10000 );
+    SendUnacknowledged( true, 10000 );
+    // Not even a retransmission fits
+    SendUnacknowledged( true, 2000 );
+    CHECK( LastMcpsConfirm.NbRetries == 1 );
+}
+
+/*!
+ * \brief Runs a node of the comparison: ADR with a small margin, confirmed
+ *        uplinks on a fading link, the duty cycle enforced
+ */
+static void RunNode( uint32_t seed, bool adaptive, PolicyResult_t *result )
+{
+    NetworkServerParams_t params = GetServerParams( LORAMAC_REGION_EU868 );
+    NetworkServerStats_t stats;
+    uint64_t next;
+
+    params.Adr = true;
+    params.AdrMargin = 2.0f;
+    if( StartNode( &params, seed, adaptive, true ) == false )
+    {
+        return;
+    }
+    // Path loss from the seed, over the SF7 to SF12 range, and fading
+    RadioSimSetLink( 115.0f + ( float )( ( seed * 2654435761u ) % 30 ), 6.0f );
+    next = HostClockGetTime( );
+    for( uint8_t i = 0; i < NODE_UPLINKS; i++ )
+    {
+        if( next > HostClockGetTime( ) )
+        {
+            HostClockRun( next - HostClockGetTime( ) );
+        }
+        next += UPLINK_PERIOD;
+        CHECK( Send( DR_0, 10 ) == true );
+        result->Uplinks++;
+        result->Delivered += ( LastMcpsConfirm.AckReceived == true ) ? 1 : 0;
+    }
+    NetworkServerGetStats( &stats );
+    result->AirTime += stats.UplinkAirTime;
+}
+
+static uint32_t Nodes = 40;
+
+static void TestCompare( void )
+{
+    PolicyResult_t results[2];
+    const char *names[2] = { "fixed", "adaptive" };
+
+    memset( results, 0, sizeof( results ) );
+    for( uint32_t i = 0; i < Nodes; i++ )
+    {
+        // Both policies see the same seeds
+        RunNode( 200 + i, false, &results[0] );
+        RunNode( 200 + i, true, &results[1] );
+    }
+    for( uint8_t i = 0; i < 2; i++ )
+    {
+        CHECK( results[i].Uplinks == ( Nodes * NODE_UPLINKS ) );
+        CHECK( results[i].AirTime > 0 );
+        if( results[i].AirTime > 0 )
+        {
+            printf( "%s: %u nodes, %u of %u confirmed uplinks delivered, %.3f per second of airtime\n", names[i],
+                    Nodes, results[i].Delivered, results[i].Uplinks, results[i].Delivered * 1e6 / results[i].AirTime );
+        }
+    }
+    // The adaptive policy trades a few deliveries for a much smaller airtime
+    CHECK( ( results[1].Delivered * results[0].AirTime ) > ( results[0].Delivered * results[1].AirTime ) );
+    CHECK( results[1].Delivered >= ( results[1].Uplinks * 9 / 10 ) );
+}
+
+int main( int argc, char **argv )
+{
+    if( argc > 1 )
+    {
+        Nodes = strtoul( argv[1], NULL, 0 );
+    }
+
+    RUN( TestDatarates );
+    RUN( TestChannelRedraw );
+    RUN( TestDeadline );
+    RUN( TestCompare );
+    return TEST_RESULT( );
+}
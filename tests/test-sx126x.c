@@ -0,0 +1,327 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host test of the SX126x driver on the command level emulator:
+             BUSY handshake of every transaction, wake-ups, radio timeouts,
+             reception duty cycle, CAD to reception and continuous wave
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <string.h>
+#include "Arduino.h"
+#include "board-config.h"
+#include "radio.h"
+#include "sx126x-emu.h"
+#include "host-clock.h"
+#include "host-gpio.h"
+#include "host-board.h"
+#include "test.h"
+
+bool Irq0Fired = false;
+bool Irq1Fired = false;
+
+/*!
+ * Radio events seen by the application
+ */
+typedef struct sEventCounts
+{
+    uint32_t TxDone;
+    uint32_t TxTimeout;
+    uint32_t RxDone;
+    uint32_t RxTimeout;
+    uint32_t RxError;
+    uint32_t CadDone;
+    bool CadActivity;
+    uint8_t Payload[255];
+    uint16_t Size;
+    int16_t Rssi;
+    int8_t Snr;
+}EventCounts_t;
+
+static EventCounts_t Counts;
+
+static void OnTxDone( void )
+{
+    Counts.TxDone++;
+}
+
+static void OnTxTimeout( void )
+{
+    Counts.TxTimeout++;
+}
+
+static void OnRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
+{
+    Counts.RxDone++;
+    Counts.Size = size;
+    Counts.Rssi = rssi;
+    Counts.Snr = snr;
+    memcpy( Counts.Payload, payload, size );
+}
+
+static void OnRxTimeout( void )
+{
+    Counts.RxTimeout++;
+}
+
+static void OnRxError( void )
+{
+    Counts.RxError++;
+}
+
+static void OnCadDone( bool channelActivityDetected )
+{
+    Counts.CadDone++;
+    Counts.CadActivity = channelActivityDetected;
+}
+
+static RadioEvents_t Events =
+{
+    .TxDone = OnTxDone,
+    .TxTimeout = OnTxTimeout,
+    .RxDone = OnRxDone,
+    .RxTimeout = OnRxTimeout,
+    .RxError = OnRxError,
+    .CadDone = OnCadDone,
+};
+
+/*!
+ * \brief Runs the virtual clock, then the radio events as the main loop does
+ */
+static void Run( uint32_t time )
+{
+    HostClockRun( ( uint64_t )time * 1000 );
+    Radio.IrqProcess( );
+}
+
+/*!
+ * \brief Checks that no transaction broke the BUSY handshake
+ */
+static void CheckHandshake( void )
+{
+    SX126xEmuStats_t stats;
+
+    SX126xEmuGetStats( &stats );
+    CHECK( stats.BusyViolations == 0 );
+    CHECK( stats.NssViolations == 0 );
+    CHECK( stats.UnknownCommands == 0 );
+    if( ( stats.BusyViolations + stats.NssViolations + stats.UnknownCommands ) != 0 )
+    {
+        printf( "Last violation 0x%02X\n", stats.LastViolation );
+    }
+}
+
+static void ConfigureLoRa( uint32_t txTimeout, bool rxContinuous )
+{
+    Radio.SetChannel( 868100000 );
+    Radio.SetTxConfig( MODEM_LORA, 14, 0, 0, 7, 1, 8, false, true, false, 0, false, txTimeout );
+    Radio.SetRxConfig( MODEM_LORA, 0, 7, 1, 0, 8, 5, false, 0, false, false, 0, true, rxContinuous );
+}
+
+static void TestInit( void )
+{
+    uint64_t start = HostClockGetTime( );
+    uint32_t capabilities = Radio.GetCapabilities( );
+
+    Radio.Init( &Events );
+    CheckHandshake( );
+    // The driver waited for the startup and for the calibration
+    CHECK( ( HostClockGetTime( ) - start ) >= ( SX126X_EMU_RESET_TIME + 3500 ) );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_STDBY_RC );
+    CHECK( Radio.GetStatus( ) == RF_IDLE );
+    CHECK( ( capabilities & RADIO_CAP_BUSY_PIN ) != 0 );
+    CHECK( ( capabilities & RADIO_CAP_HW_TIMEOUT ) != 0 );
+    CHECK( ( capabilities & RADIO_CAP_FSK_FIFO ) == 0 );
+}
+
+static void TestTxRx( void )
+{
+    uint8_t payload[] = { 0x40, 0x01, 0x02, 0x03, 0x04 };
+    uint8_t downlink[] = { 0x60, 0x0A, 0x0B, 0x0C };
+    const uint8_t *sent;
+    uint8_t size;
+
+    memset( &Counts, 0, sizeof( Counts ) );
+    ConfigureLoRa( 3000, false );
+    CHECK( SX126xEmuGetFrequency( ) >= 868099999 );
+    CHECK( SX126xEmuGetFrequency( ) <= 868100000 );
+
+    SX126xEmuSetAirTime( 40 );
+    Radio.Send( payload, sizeof( payload ) );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_TX );
+    CHECK( Radio.GetStatus( ) == RF_TX_RUNNING );
+    Run( 39 );
+    CHECK( Counts.TxDone == 0 );
+    Run( 2 );
+    CHECK( Counts.TxDone == 1 );
+    CHECK( digitalRead( RADIO_DIO_1 ) == LOW );
+    CHECK( Radio.GetStatus( ) == RF_IDLE );
+    sent = SX126xEmuGetSent( &size );
+    CHECK( size == sizeof( payload ) );
+    CHECK( memcmp( sent, payload, sizeof( payload ) ) == 0 );
+
+    // Reception timeout by the radio timer
+    Radio.Rx( 100 );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_RX );
+    Run( 99 );
+    CHECK( Counts.RxTimeout == 0 );
+    Run( 2 );
+    CHECK( Counts.RxTimeout == 1 );
+    CHECK( Radio.GetStatus( ) == RF_IDLE );
+
+    Radio.Rx( 1000 );
+    Run( 10 );
+    CHECK( SX126xEmuReceive( downlink, sizeof( downlink ), -80, 7 ) == true );
+    Run( 0 );
+    CHECK( Counts.RxDone == 1 );
+    CHECK( Counts.Size == sizeof( downlink ) );
+    CHECK( memcmp( Counts.Payload, downlink, sizeof( downlink ) ) == 0 );
+    CHECK( Counts.Rssi == -80 );
+    CHECK( Counts.Snr == 7 );
+    // The radio timer stopped with the reception
+    Run( 2000 );
+    CHECK( Counts.RxTimeout == 1 );
+    CheckHandshake( );
+}
+
+static void TestTxTimeout( void )
+{
+    memset( &Counts, 0, sizeof( Counts ) );
+    ConfigureLoRa( 10, false );
+    SX126xEmuSetAirTime( 50 );
+    Radio.Send( ( uint8_t* )"timeout", 7 );
+    Run( 11 );
+    CHECK( Counts.TxTimeout == 1 );
+    CHECK( Counts.TxDone == 0 );
+    CHECK( Radio.GetStatus( ) == RF_IDLE );
+    CheckHandshake( );
+}
+
+static void TestSleepWakeup( void )
+{
+    SX126xEmuStats_t before;
+    SX126xEmuStats_t after;
+    uint64_t start;
+
+    memset( &Counts, 0, sizeof( Counts ) );
+    ConfigureLoRa( 3000, false );
+    SX126xEmuGetStats( &before );
+    Radio.Sleep( );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_SLEEP );
+    Run( 1000 );
+
+    // The first command after the sleep wakes the chip up and waits for it
+    start = HostClockGetTime( );
+    Radio.Send( ( uint8_t* )"wake", 4 );
+    CHECK( ( HostClockGetTime( ) - start ) >= SX126X_EMU_WARM_START_TIME );
+    SX126xEmuGetStats( &after );
+    CHECK( after.Wakeups == before.Wakeups + 1 );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_TX );
+    Run( 100 );
+    CHECK( Counts.TxDone == 1 );
+
+    // The warm start kept the configuration
+    CHECK( SX126xEmuGetFrequency( ) >= 868099999 );
+    CheckHandshake( );
+}
+
+static void TestRxDutyCycle( void )
+{
+    SX126xEmuStats_t before;
+    SX126xEmuStats_t after;
+    uint8_t downlink[] = { 0xA0, 0x01 };
+
+    memset( &Counts, 0, sizeof( Counts ) );
+    ConfigureLoRa( 3000, false );
+    Radio.SetRxDutyCycle( 64 * 10, 64 * 90 );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_RX_DC );
+    CHECK( Radio.GetStatus( ) == RF_RX_RUNNING );
+    Run( 500 );
+    CHECK( SX126xEmuReceive( downlink, sizeof( downlink ), -100, -3 ) == true );
+    Run( 0 );
+    CHECK( Counts.RxDone == 1 );
+    CHECK( Counts.Size == sizeof( downlink ) );
+
+    // Leaving the duty cycle wakes the chip up from its sleep phases
+    Radio.SetRxDutyCycle( 64 * 10, 64 * 90 );
+    SX126xEmuGetStats( &before );
+    Radio.Standby( );
+    SX126xEmuGetStats( &after );
+    CHECK( after.Wakeups == before.Wakeups + 1 );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_STDBY_RC );
+    CheckHandshake( );
+}
+
+static void TestCadToRx( void )
+{
+    uint8_t downlink[] = { 0x60, 0x11, 0x22 };
+
+    memset( &Counts, 0, sizeof( Counts ) );
+    ConfigureLoRa( 3000, false );
+
+    SX126xEmuSetCadActivity( false );
+    Radio.StartCadRx( 100 );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_CAD );
+    Run( 2 );
+    CHECK( Counts.CadDone == 1 );
+    CHECK( Counts.CadActivity == false );
+    CHECK( Radio.GetStatus( ) == RF_IDLE );
+
+    // On activity the radio receives by itself, with the timeout given
+    SX126xEmuSetCadActivity( true );
+    Radio.StartCadRx( 100 );
+    Run( 2 );
+    CHECK( Counts.CadDone == 2 );
+    CHECK( Counts.CadActivity == true );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_RX );
+    CHECK( Radio.GetStatus( ) == RF_RX_RUNNING );
+    CHECK( SX126xEmuReceive( downlink, sizeof( downlink ), -90, 2 ) == true );
+    Run( 0 );
+    CHECK( Counts.RxDone == 1 );
+
+    Radio.StartCadRx( 100 );
+    Run( 2 );
+    Run( 101 );
+    CHECK( Counts.RxTimeout == 1 );
+    CHECK( Radio.GetStatus( ) == RF_IDLE );
+    CheckHandshake( );
+}
+
+static void TestContinuousWave( void )
+{
+    memset( &Counts, 0, sizeof( Counts ) );
+    Radio.SetTxContinuousWave( 869525000, 14, 2 );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_TX );
+    CHECK( SX126xEmuGetFrequency( ) >= 869524999 );
+    Run( 1000 );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_TX );
+    CHECK( Counts.TxTimeout == 0 );
+    Run( 1001 );
+    CHECK( Counts.TxTimeout == 1 );
+    CHECK( SX126xEmuGetMode( ) == SX126X_EMU_MODE_SLEEP );
+    CheckHandshake( );
+}
+
+int main( void )
+{
+    HostClockReset( );
+    HostGpioReset( );
+    HostBoardReset( 1, false );
+    SX126xEmuReset( );
+
+    RUN( TestInit );
+    RUN( TestTxRx );
+    RUN( TestTxTimeout );
+    RUN( TestSleepWakeup );
+    RUN( TestRxDutyCycle );
+    RUN( TestCadToRx );
+    RUN( TestContinuousWave );
+    return TEST_RESULT( );
+}
@@ -0,0 +1,465 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host test of two SX1276 radios on register file buses: bus
+             isolation, per instance DIO flags and per slot timeout timers
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <string.h>
+#include "Arduino.h"
+#include "sx1276-board.h"
+#include "sx1276Regs-LoRa.h"
+#include "sx1276Regs-Fsk.h"
+#include "host-clock.h"
+#include "host-gpio.h"
+#include "host-board.h"
+#include "test.h"
+
+/*!
+ * Pins of the radios, the default board wiring for the first one
+ */
+#define RADIO_A_RESET                               14
+#define RADIO_A_DIO_0                               26
+#define RADIO_A_DIO_1                               35
+#define RADIO_B_RESET                               12
+#define RADIO_B_DIO_0                               32
+#define RADIO_B_DIO_1                               33
+
+bool Irq0Fired = false;
+bool Irq1Fired = false;
+
+/*!
+ * Accesses through the bus set up by Mcu.init, none once the default radio
+ * has a bus of its own
+ */
+static uint32_t McuBusAccesses = 0;
+
+void write0( uint16_t address, uint8_t value )
+{
+    McuBusAccesses++;
+}
+
+uint8_t read0( uint16_t address )
+{
+    McuBusAccesses++;
+    return 0;
+}
+
+void writefifo( uint16_t address, uint8_t *buffer, uint8_t size )
+{
+    McuBusAccesses++;
+}
+
+void readfifo( uint16_t address, uint8_t *buffer, uint8_t size )
+{
+    McuBusAccesses++;
+}
+
+/*!
+ * Register file of a radio, its bus is the first member so that the driver
+ * callbacks find it from obj->Bus
+ */
+typedef struct sRegisterFile
+{
+    SX1276Bus_t Bus;
+    uint8_t ResetPin;
+    uint8_t Regs[0x80];
+    uint8_t Fifo[256];
+    uint32_t Accesses;
+    uint32_t Resets;
+    uint32_t Transmits;
+}RegisterFile_t;
+
+/*!
+ * Radio events seen by the application of a radio
+ */
+typedef struct sEventCounts
+{
+    uint32_t TxDone;
+    uint32_t TxTimeout;
+    uint32_t RxDone;
+    uint32_t RxTimeout;
+    uint32_t RxError;
+    uint8_t Payload[RX_BUFFER_SIZE];
+    uint16_t Size;
+}EventCounts_t;
+
+static void RegisterWrite( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size );
+static void RegisterRead( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size );
+
+static RegisterFile_t FileA = { .Bus = { RegisterWrite, RegisterRead }, .ResetPin = RADIO_A_RESET };
+static RegisterFile_t FileB = { .Bus = { RegisterWrite, RegisterRead }, .ResetPin = RADIO_B_RESET };
+
+static SX1276_t RadioB;
+static SX1276_t RadioC;
+
+static EventCounts_t CountsA;
+static EventCounts_t CountsB;
+
+/*!
+ * \brief Sets the registers the driver polls to their value after a reset
+ */
+static void ResetRegisters( RegisterFile_t *file )
+{
+    memset( file->Regs, 0, sizeof( file->Regs ) );
+    file->Regs[REG_OPMODE] = RF_OPMODE_STANDBY;
+    file->Regs[REG_VERSION] = 0x12;
+}
+
+static void WriteRegister( RegisterFile_t *file, uint8_t addr, uint8_t value )
+{
+    bool loRa = ( file->Regs[REG_OPMODE] & RFLR_OPMODE_LONGRANGEMODE_ON ) != 0;
+
+    if( ( loRa == true ) && ( addr == REG_LR_IRQFLAGS ) )
+    {
+        // Write one to clear
+        file->Regs[addr] &= ~value;
+        return;
+    }
+    if( addr == REG_IMAGECAL )
+    {
+        // The calibration completes at once
+        value &= ~RF_IMAGECAL_IMAGECAL_RUNNING;
+    }
+    if( ( addr == REG_OPMODE ) && ( ( value & ~RF_OPMODE_MASK ) == RF_OPMODE_TRANSMITTER ) )
+    {
+        file->Transmits++;
+    }
+    file->Regs[addr] = value;
+}
+
+static void RegisterWrite( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+    RegisterFile_t *file = ( RegisterFile_t* )obj->Bus;
+
+    file->Accesses++;
+    for( uint8_t i = 0; i < size; i++ )
+    {
+        if( addr == REG_FIFO )
+        {
+            file->Fifo[file->Regs[REG_LR_FIFOADDRPTR]++] = buffer[i];
+        }
+        else
+        {
+            WriteRegister( file, ( addr + i ) & 0x7F, buffer[i] );
+        }
+    }
+}
+
+static void RegisterRead( SX1276_t *obj, uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+    RegisterFile_t *file = ( RegisterFile_t* )obj->Bus;
+
+    file->Accesses++;
+    for( uint8_t i = 0; i < size; i++ )
+    {
+        if( addr == REG_FIFO )
+        {
+            buffer[i] = file->Fifo[file->Regs[REG_LR_FIFOADDRPTR]++];
+        }
+        else
+        {
+            buffer[i] = file->Regs[( addr + i ) & 0x7F];
+        }
+    }
+}
+
+/*!
+ * \brief Resets the register file whose reset pin is pulled low
+ */
+static void OnPinWrite( uint8_t pin, uint8_t level )
+{
+    RegisterFile_t *files[] = { &FileA, &FileB };
+
+    for( uint8_t i = 0; i < 2; i++ )
+    {
+        if( ( files[i]->ResetPin == pin ) && ( level == LOW ) )
+        {
+            files[i]->Resets++;
+            ResetRegisters( files[i] );
+        }
+    }
+}
+
+static void OnTxDoneA( void )
+{
+    CountsA.TxDone++;
+}
+
+static void OnTxTimeoutA( void )
+{
+    CountsA.TxTimeout++;
+}
+
+static void OnRxDoneA( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
+{
+    CountsA.RxDone++;
+    CountsA.Size = size;
+    memcpy( CountsA.Payload, payload, size );
+}
+
+static void OnRxTimeoutA( void )
+{
+    CountsA.RxTimeout++;
+}
+
+static void OnRxErrorA( void )
+{
+    CountsA.RxError++;
+}
+
+static void OnTxDoneB( void )
+{
+    CountsB.TxDone++;
+}
+
+static void OnTxTimeoutB( void )
+{
+    CountsB.TxTimeout++;
+}
+
+static void OnRxDoneB( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
+{
+    CountsB.RxDone++;
+    CountsB.Size = size;
+    memcpy( CountsB.Payload, payload, size );
+}
+
+static void OnRxTimeoutB( void )
+{
+    CountsB.RxTimeout++;
+}
+
+static void OnRxErrorB( void )
+{
+    CountsB.RxError++;
+}
+
+static RadioEvents_t EventsA =
+{
+    .TxDone = OnTxDoneA,
+    .TxTimeout = OnTxTimeoutA,
+    .RxDone = OnRxDoneA,
+    .RxTimeout = OnRxTimeoutA,
+    .RxError = OnRxErrorA,
+};
+
+static RadioEvents_t EventsB =
+{
+    .TxDone = OnTxDoneB,
+    .TxTimeout = OnTxTimeoutB,
+    .RxDone = OnRxDoneB,
+    .RxTimeout = OnRxTimeoutB,
+    .RxError = OnRxErrorB,
+};
+
+/*!
+ * \brief Pulses a DIO pin, as the radio does on an interrupt
+ */
+static void PulseDio( uint8_t pin )
+{
+    HostGpioSet( pin, HIGH );
+    HostGpioSet( pin, LOW );
+}
+
+/*!
+ * \brief Sets a radio up for LoRa SF7 125 kHz single receptions
+ */
+static void Configure( SX1276_t *obj, uint32_t freq, uint32_t txTimeout )
+{
+    SX1276SetChannel( obj, freq );
+    SX1276SetTxConfig( obj, MODEM_LORA, 14, 0, 0, 7, 1, 8, false, true, false, 0, false, txTimeout );
+    SX1276SetRxConfig( obj, MODEM_LORA, 0, 7, 1, 0, 8, 5, false, 0, false, false, 0, true, false );
+}
+
+/*!
+ * \brief Returns the frequency register of a radio, in FREQ_STEP units
+ */
+static uint32_t GetFrf( RegisterFile_t *file )
+{
+    return ( ( uint32_t )file->Regs[REG_FRFMSB] << 16 ) |
+           ( ( uint32_t )file->Regs[REG_FRFMID] << 8 ) |
+           file->Regs[REG_FRFLSB];
+}
+
+static void TestSetup( void )
+{
+    // The default radio moves to a bus of its own, the second takes the
+    // last slot
+    CHECK( SX1276AddInstance( &SX1276, &FileA.Bus, RADIO_A_RESET, RADIO_A_DIO_0, RADIO_A_DIO_1 ) == true );
+    CHECK( SX1276AddInstance( &RadioB, &FileB.Bus, RADIO_B_RESET, RADIO_B_DIO_0, RADIO_B_DIO_1 ) == true );
+    CHECK( SX1276AddInstance( &RadioC, &FileB.Bus, RADIO_B_RESET, RADIO_B_DIO_0, RADIO_B_DIO_1 ) == false );
+    CHECK( FileA.Resets == 1 );
+    CHECK( FileB.Resets == 1 );
+
+    SX1276Init( &SX1276, &EventsA );
+    SX1276Init( &RadioB, &EventsB );
+    CHECK( FileA.Regs[REG_SYNCVALUE1] == 0xC1 );
+    CHECK( FileB.Regs[REG_SYNCVALUE1] == 0xC1 );
+    CHECK( FileA.Regs[REG_LR_PAYLOADMAXLENGTH] == 0xFF );
+    CHECK( FileB.Regs[REG_LR_PAYLOADMAXLENGTH] == 0xFF );
+    CHECK( SX1276GetStatus( &SX1276 ) == RF_IDLE );
+    CHECK( SX1276GetStatus( &RadioB ) == RF_IDLE );
+
+    // Not set up by SX1276AddInstance, no timers nor interrupts
+    SX1276Init( &RadioC, &EventsB );
+    CHECK( RadioC.Events == NULL );
+}
+
+static void TestBusIsolation( void )
+{
+    uint32_t accessesB = FileB.Accesses;
+
+    Configure( &SX1276, 868100000, 3000 );
+    CHECK( FileB.Accesses == accessesB );
+    Configure( &RadioB, 869525000, 3000 );
+    CHECK( GetFrf( &FileA ) == ( uint32_t )( 868100000 / FREQ_STEP ) );
+    CHECK( GetFrf( &FileB ) == ( uint32_t )( 869525000 / FREQ_STEP ) );
+}
+
+static void TestDioFlags( void )
+{
+    uint8_t payload[] = { 0x40, 0x01, 0x02, 0x03 };
+    uint8_t downlink[] = { 0x60, 0x0A, 0x0B };
+    uint32_t rxEnd;
+
+    memset( &CountsA, 0, sizeof( CountsA ) );
+    memset( &CountsB, 0, sizeof( CountsB ) );
+
+    // A sends while B listens
+    SX1276Send( &SX1276, payload, sizeof( payload ) );
+    SX1276SetRx( &RadioB, 0 );
+    CHECK( FileA.Transmits == 1 );
+    CHECK( FileB.Transmits == 0 );
+    CHECK( memcmp( FileA.Fifo, payload, sizeof( payload ) ) == 0 );
+    CHECK( SX1276GetStatus( &SX1276 ) == RF_TX_RUNNING );
+    CHECK( SX1276GetStatus( &RadioB ) == RF_RX_RUNNING );
+
+    // TxDone of A only flags A
+    FileA.Regs[REG_LR_IRQFLAGS] = RFLR_IRQFLAGS_TXDONE;
+    PulseDio( RADIO_A_DIO_0 );
+    CHECK( SX1276.Dio0Fired == true );
+    CHECK( SX1276.Dio1Fired == false );
+    CHECK( RadioB.Dio0Fired == false );
+    CHECK( RadioB.Dio1Fired == false );
+    SX1276IrqProcess( &RadioB );
+    CHECK( CountsB.TxDone + CountsB.RxDone + CountsB.RxTimeout == 0 );
+    CHECK( SX1276.Dio0Fired == true );
+    SX1276IrqProcess( &SX1276 );
+    CHECK( SX1276.Dio0Fired == false );
+    CHECK( CountsA.TxDone == 1 );
+    CHECK( FileA.Regs[REG_LR_IRQFLAGS] == 0 );
+    CHECK( SX1276GetStatus( &SX1276 ) == RF_IDLE );
+    CHECK( SX1276GetStatus( &RadioB ) == RF_RX_RUNNING );
+
+    // RxDone of B reads B's FIFO and reaches B's events
+    memcpy( FileB.Fifo + 0x10, downlink, sizeof( downlink ) );
+    FileB.Regs[REG_LR_FIFORXCURRENTADDR] = 0x10;
+    FileB.Regs[REG_LR_RXNBBYTES] = sizeof( downlink );
+    FileB.Regs[REG_LR_IRQFLAGS] = RFLR_IRQFLAGS_RXDONE;
+    HostClockAdvance( 1000 );
+    rxEnd = micros( );
+    PulseDio( RADIO_B_DIO_0 );
+    CHECK( RadioB.Dio0Fired == true );
+    CHECK( SX1276.Dio0Fired == false );
+    // Processed later, the end of the packet is the time of the IRQ
+    HostClockAdvance( 5000 );
+    SX1276IrqProcess( &SX1276 );
+    SX1276IrqProcess( &RadioB );
+    CHECK( SX1276GetDio0Time( &RadioB ) == rxEnd );
+    CHECK( CountsA.RxDone == 0 );
+    CHECK( CountsB.RxDone == 1 );
+    CHECK( CountsB.Size == sizeof( downlink ) );
+    CHECK( memcmp( CountsB.Payload, downlink, sizeof( downlink ) ) == 0 );
+
+    // Symbol timeout of A on its DIO1
+    SX1276SetRx( &SX1276, 0 );
+    FileA.Regs[REG_LR_IRQFLAGS] = RFLR_IRQFLAGS_RXTIMEOUT;
+    PulseDio( RADIO_A_DIO_1 );
+    CHECK( SX1276.Dio1Fired == true );
+    CHECK( RadioB.Dio1Fired == false );
+    SX1276IrqProcess( &SX1276 );
+    CHECK( CountsA.RxTimeout == 1 );
+    CHECK( CountsB.RxTimeout == 0 );
+
+    // Both at once, each processed on its own
+    SX1276Send( &SX1276, payload, sizeof( payload ) );
+    SX1276Send( &RadioB, payload, sizeof( payload ) );
+    PulseDio( RADIO_B_DIO_0 );
+    PulseDio( RADIO_A_DIO_0 );
+    SX1276IrqProcess( &RadioB );
+    CHECK( CountsB.TxDone == 1 );
+    CHECK( CountsA.TxDone == 1 );
+    SX1276IrqProcess( &SX1276 );
+    CHECK( CountsA.TxDone == 2 );
+}
+
+static void TestTimeoutTimers( void )
+{
+    uint32_t resetsA = FileA.Resets;
+    uint32_t resetsB = FileB.Resets;
+
+    memset( &CountsA, 0, sizeof( CountsA ) );
+    memset( &CountsB, 0, sizeof( CountsB ) );
+
+    // Each slot's timers call back their own radio
+    SX1276SetRx( &SX1276, 100 );
+    SX1276SetRx( &RadioB, 30 );
+    HostClockRun( 50000 );
+    CHECK( CountsB.RxTimeout == 1 );
+    CHECK( CountsA.RxTimeout == 0 );
+    CHECK( SX1276GetStatus( &SX1276 ) == RF_RX_RUNNING );
+    HostClockRun( 100000 );
+    CHECK( CountsA.RxTimeout == 1 );
+    CHECK( CountsB.RxTimeout == 1 );
+
+    // A Tx timeout of B resets B's radio only
+    Configure( &RadioB, 869525000, 20 );
+    SX1276Send( &SX1276, ( uint8_t* )"A", 1 );
+    SX1276Send( &RadioB, ( uint8_t* )"B", 1 );
+    HostClockRun( 30000 );
+    CHECK( CountsB.TxTimeout == 1 );
+    CHECK( CountsA.TxTimeout == 0 );
+    CHECK( FileB.Resets == resetsB + 1 );
+    CHECK( FileA.Resets == resetsA );
+    CHECK( SX1276GetStatus( &RadioB ) == RF_IDLE );
+    CHECK( SX1276GetStatus( &SX1276 ) == RF_TX_RUNNING );
+    // The workaround initialized B's registers again
+    CHECK( FileB.Regs[REG_SYNCVALUE1] == 0xC1 );
+    CHECK( FileB.Regs[REG_LR_SYNCWORD] == LORA_MAC_PRIVATE_SYNCWORD );
+
+    // A's Tx done stops its own timer, not B's
+    SX1276Send( &RadioB, ( uint8_t* )"B", 1 );
+    PulseDio( RADIO_A_DIO_0 );
+    SX1276IrqProcess( &SX1276 );
+    CHECK( CountsA.TxDone == 1 );
+    HostClockRun( 30000 );
+    CHECK( CountsB.TxTimeout == 2 );
+    HostClockRun( 3000000 );
+    CHECK( CountsA.TxTimeout == 0 );
+}
+
+int main( void )
+{
+    HostClockReset( );
+    HostGpioReset( );
+    HostBoardReset( 1, false );
+    HostGpioSetWriteHook( OnPinWrite );
+    ResetRegisters( &FileA );
+    ResetRegisters( &FileB );
+
+    RUN( TestSetup );
+    RUN( TestBusIsolation );
+    RUN( TestDioFlags );
+    RUN( TestTimeoutTimers );
+    CHECK( McuBusAccesses == 0 );
+    return TEST_RESULT( );
+}
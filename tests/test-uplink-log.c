@@ -0,0 +1,385 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+
+Description: Host test of the uplink log on a file backed flash
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis and Gregory Cristian
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "test.h"
+#include "uplink-log.h"
+
+#define FLASH_SECTOR_SIZE                           512
+#define FLASH_NB_SECTORS                            4
+
+/*!
+ * Header sizes of uplink-log.c: sector header and record header
+ */
+#define SECTOR_HEADER_SIZE                          16
+#define RECORD_HEADER_SIZE                          8
+
+/*!
+ * Frame time of the packs [s]
+ */
+#define FRAME_TIME                                  1000
+
+/*!
+ * Flash file, the erases of each sector, and the bytes written before the
+ * power is cut, UINT32_MAX when it is not
+ */
+static FILE *FlashFile;
+static uint32_t EraseCounts[FLASH_NB_SECTORS];
+static uint32_t CutAfter = UINT32_MAX;
+
+static bool FlashRead( uint32_t address, void *buffer, uint32_t size )
+{
+    return ( fseek( FlashFile, address, SEEK_SET ) == 0 ) && ( fread( buffer, 1, size, FlashFile ) == size );
+}
+
+/*!
+ * \brief NOR write, only clearing bits. A cut write stores the bytes before
+ *        the cut and fails, as every write after it.
+ */
+static bool FlashWrite( uint32_t address, const void *buffer, uint32_t size )
+{
+    uint8_t data[FLASH_SECTOR_SIZE];
+    uint32_t written = ( size < CutAfter ) ? size : CutAfter;
+
+    if( FlashRead( address, data, written ) == false )
+    {
+        return false;
+    }
+    for( uint32_t i = 0; i < written; i++ )
+    {
+        data[i] &= ( ( const uint8_t * )buffer )[i];
+    }
+    if( ( fseek( FlashFile, address, SEEK_SET ) != 0 ) || ( fwrite( data, 1, written, FlashFile ) != written ) )
+    {
+        return false;
+    }
+    if( CutAfter != UINT32_MAX )
+    {
+        CutAfter -= written;
+        return written == size;
+    }
+    return true;
+}
+
+static bool FlashErase( uint32_t address )
+{
+    uint8_t data[FLASH_SECTOR_SIZE];
+
+    if( ( address % FLASH_SECTOR_SIZE ) != 0 )
+    {
+        return false;
+    }
+    memset( data, 0xFF, sizeof( data ) );
+    EraseCounts[address / FLASH_SECTOR_SIZE]++;
+    return ( fseek( FlashFile, address, SEEK_SET ) == 0 ) && ( fwrite( data, 1, sizeof( data ), FlashFile ) == sizeof( data ) );
+}
+
+/*!
+ * Two copies of the driver table: the log keeps its state while mounted on
+ * the same table, mounting the other one rescans the flash as after a reset.
+ */
+static const UplinkLogFlash_t Flashes[2] =
+{
+    { FLASH_SECTOR_SIZE, FLASH_NB_SECTORS, FlashRead, FlashWrite, FlashErase },
+    { FLASH_SECTOR_SIZE, FLASH_NB_SECTORS, FlashRead, FlashWrite, FlashErase },
+};
+static uint8_t FlashIndex = 0;
+
+static bool Remount( void )
+{
+    FlashIndex ^= 1;
+    return UplinkLogInit( &Flashes[FlashIndex] );
+}
+
+/*!
+ * \brief Starts a test on a new flash, zeroed as never formatted
+ */
+static void NewFlash( void )
+{
+    uint8_t data[FLASH_SECTOR_SIZE];
+
+    if( FlashFile != NULL )
+    {
+        fclose( FlashFile );
+    }
+    FlashFile = tmpfile( );
+    memset( data, 0, sizeof( data ) );
+    for( uint8_t i = 0; i < FLASH_NB_SECTORS; i++ )
+    {
+        fwrite( data, 1, sizeof( data ), FlashFile );
+    }
+    memset( EraseCounts, 0, sizeof( EraseCounts ) );
+    CutAfter = UINT32_MAX;
+    CHECK( Remount( ) == true );
+}
+
+/*!
+ * \brief Appends a record of the given size identified by its time, which
+ *        also fills its data
+ */
+static bool Append( uint32_t time, uint8_t size )
+{
+    uint8_t data[UPLINK_LOG_MAX_DATA_SIZE];
+
+    for( uint8_t i = 0; i < size; i++ )
+    {
+        data[i] = ( uint8_t )( time + i );
+    }
+    return UplinkLogAppend( 2, time, data, size );
+}
+
+/*!
+ * \brief Packs a frame and returns the times of its records, checking their
+ *        port, age and data
+ *
+ * \retval count Records in the frame
+ */
+static uint8_t Pack( uint8_t maxSize, uint32_t *times )
+{
+    uint8_t frame[242];
+    uint8_t size = UplinkLogPack( FRAME_TIME, frame, maxSize );
+    uint8_t count = 0;
+    uint8_t i = 0;
+
+    CHECK( size <= maxSize );
+    while( i < size )
+    {
+        uint8_t *entry = frame + i;
+        uint32_t age = entry[2] | ( entry[3] << 8 ) | ( entry[4] << 16 );
+        uint32_t time = FRAME_TIME - age;
+
+        CHECK( entry[0] == 2 );
+        for( uint8_t j = 0; j < entry[1]; j++ )
+        {
+            CHECK( entry[UPLINK_LOG_ENTRY_HEADER_SIZE + j] == ( uint8_t )( time + j ) );
+        }
+        times[count++] = time;
+        i += UPLINK_LOG_ENTRY_HEADER_SIZE + entry[1];
+    }
+    CHECK( i == size );
+    return count;
+}
+
+/*!
+ * \brief Returns the Ack byte of the record at an address of the flash
+ */
+static uint8_t AckByte( uint32_t address )
+{
+    uint8_t ack = 0;
+
+    FlashRead( address + 1, &ack, 1 );
+    return ack;
+}
+
+static UplinkLogStatus_t Status( void )
+{
+    UplinkLogStatus_t status;
+
+    UplinkLogGetStatus( &status );
+    return status;
+}
+
+/*!
+ * The log fills its sectors in turn and drops the oldest one when full, the
+ * sectors wearing evenly
+ */
+static void TestWrapDropsOldest( void )
+{
+    uint32_t times[8];
+    uint32_t minErases = UINT32_MAX;
+    uint32_t maxErases = 0;
+    uint32_t pending;
+
+    NewFlash( );
+
+    // 4 records of 100 bytes per sector
+    for( uint32_t t = 0; t < 30; t++ )
+    {
+        CHECK( Append( t, 100 ) == true );
+    }
+    pending = UplinkLogPending( );
+    CHECK( ( pending >= 12 ) && ( pending <= 16 ) );
+    CHECK( Status( ).Stored == 30 );
+    CHECK( ( Status( ).Dropped + pending ) == 30 );
+
+    for( uint8_t i = 0; i < FLASH_NB_SECTORS; i++ )
+    {
+        minErases = ( EraseCounts[i] < minErases ) ? EraseCounts[i] : minErases;
+        maxErases = ( EraseCounts[i] > maxErases ) ? EraseCounts[i] : maxErases;
+    }
+    CHECK( ( maxErases - minErases ) <= 1 );
+    CHECK( Status( ).EraseCount == maxErases );
+
+    // The oldest kept record goes first, also after a reset
+    CHECK( Pack( 242, times ) == 2 );
+    CHECK( ( times[0] == ( 30 - pending ) ) && ( times[1] == ( 31 - pending ) ) );
+    UplinkLogAck( false );
+    CHECK( Remount( ) == true );
+    CHECK( UplinkLogPending( ) == pending );
+    CHECK( Pack( 242, times ) == 2 );
+    CHECK( times[0] == ( 30 - pending ) );
+
+    // The sector of the frame in flight is dropped, its ACK comes too late
+    for( uint32_t t = 30; t < 35; t++ )
+    {
+        CHECK( Append( t, 100 ) == true );
+    }
+    UplinkLogAck( true );
+    CHECK( Status( ).Delivered == 0 );
+    CHECK( Pack( 242, times ) == 2 );
+    CHECK( times[0] > ( 31 - pending ) );
+}
+
+/*!
+ * A record write cut by a reset leaves a corrupted record: it is dropped once
+ * it is the oldest one, and the log goes on after it
+ */
+static void TestCutWriteRescan( void )
+{
+    uint32_t times[8];
+    uint8_t record[RECORD_HEADER_SIZE];
+
+    NewFlash( );
+
+    // Records 0 to 3 in sector 0, 4 in sector 1
+    for( uint32_t t = 0; t < 5; t++ )
+    {
+        CHECK( Append( t, 100 ) == true );
+    }
+
+    // Record 5 is cut in its data
+    CutAfter = 50;
+    CHECK( Append( 5, 100 ) == false );
+    CutAfter = UINT32_MAX;
+    CHECK( UplinkLogPending( ) == 5 );
+
+    // Without reset, the log leaves the sector of the cut write
+    CHECK( Append( 7, 100 ) == true );
+    CHECK( FlashRead( 2 * FLASH_SECTOR_SIZE + SECTOR_HEADER_SIZE, record, sizeof( record ) ) == true );
+    CHECK( ( record[0] == 100 ) && ( record[4] == 7 ) );
+
+    // After a reset the rescan finds the cut record, with a bad CRC
+    CHECK( Remount( ) == true );
+    CHECK( UplinkLogPending( ) == 7 );
+
+    CHECK( Pack( 242, times ) == 2 );
+    CHECK( ( times[0] == 0 ) && ( times[1] == 1 ) );
+    UplinkLogAck( true );
+    CHECK( Pack( 242, times ) == 2 );
+    CHECK( ( times[0] == 2 ) && ( times[1] == 3 ) );
+    UplinkLogAck( true );
+
+    // The corrupted record ends the frame before it
+    CHECK( Pack( 242, times ) == 1 );
+    CHECK( times[0] == 4 );
+    UplinkLogAck( true );
+
+    // Then it is dropped as the oldest one
+    CHECK( Pack( 242, times ) == 1 );
+    CHECK( times[0] == 7 );
+    CHECK( Status( ).Dropped == 1 );
+    UplinkLogAck( true );
+    CHECK( UplinkLogPending( ) == 0 );
+
+    CHECK( Append( 8, 100 ) == true );
+    CHECK( Pack( 242, times ) == 1 );
+    CHECK( times[0] == 8 );
+}
+
+/*!
+ * The acknowledgement clears the Ack byte of the records in place, a lost
+ * frame leaves them pending
+ */
+static void TestAckByte( void )
+{
+    uint32_t first = SECTOR_HEADER_SIZE;
+    uint32_t times[8];
+
+    NewFlash( );
+    for( uint32_t t = 0; t < 3; t++ )
+    {
+        CHECK( Append( t, 100 ) == true );
+    }
+
+    CHECK( Pack( 242, times ) == 2 );
+    UplinkLogAck( false );
+    CHECK( AckByte( first ) == 0xFF );
+    CHECK( AckByte( first + RECORD_HEADER_SIZE + 100 ) == 0xFF );
+    CHECK( UplinkLogPending( ) == 3 );
+
+    CHECK( Pack( 242, times ) == 2 );
+    CHECK( times[0] == 0 );
+    UplinkLogAck( true );
+    CHECK( AckByte( first ) == 0x00 );
+    CHECK( AckByte( first + RECORD_HEADER_SIZE + 100 ) == 0x00 );
+    CHECK( AckByte( first + 2 * ( RECORD_HEADER_SIZE + 100 ) ) == 0xFF );
+    CHECK( Status( ).Delivered == 2 );
+
+    // Delivered records stay delivered after a reset
+    CHECK( Remount( ) == true );
+    CHECK( UplinkLogPending( ) == 1 );
+    CHECK( Pack( 242, times ) == 1 );
+    CHECK( times[0] == 2 );
+}
+
+/*!
+ * A frame packs records of two sectors, in order, and its acknowledgement
+ * marks them in both
+ */
+static void TestPackAcrossSectors( void )
+{
+    uint32_t record = RECORD_HEADER_SIZE + 40;
+    uint32_t entry = UPLINK_LOG_ENTRY_HEADER_SIZE + 40;
+    uint32_t times[8];
+
+    NewFlash( );
+
+    // 10 records of 40 bytes per sector: 0 to 9 in sector 0, 10 and 11 in sector 1
+    for( uint32_t t = 0; t < 12; t++ )
+    {
+        CHECK( Append( t, 40 ) == true );
+    }
+    CHECK( Pack( 3 * entry, times ) == 3 );
+    UplinkLogAck( true );
+    CHECK( Pack( 242, times ) == 5 );
+    CHECK( ( times[0] == 3 ) && ( times[4] == 7 ) );
+    UplinkLogAck( true );
+
+    CHECK( Pack( 242, times ) == 4 );
+    CHECK( ( times[0] == 8 ) && ( times[1] == 9 ) && ( times[2] == 10 ) && ( times[3] == 11 ) );
+    UplinkLogAck( false );
+    CHECK( Remount( ) == true );
+    CHECK( UplinkLogPending( ) == 4 );
+
+    CHECK( Pack( 242, times ) == 4 );
+    CHECK( ( times[0] == 8 ) && ( times[3] == 11 ) );
+    UplinkLogAck( true );
+    CHECK( AckByte( SECTOR_HEADER_SIZE + 9 * record ) == 0x00 );
+    CHECK( AckByte( FLASH_SECTOR_SIZE + SECTOR_HEADER_SIZE + record ) == 0x00 );
+    CHECK( UplinkLogPending( ) == 0 );
+    CHECK( Remount( ) == true );
+    CHECK( UplinkLogPending( ) == 0 );
+    CHECK( Pack( 242, times ) == 0 );
+}
+
+int main( void )
+{
+    RUN( TestWrapDropsOldest );
+    RUN( TestCutWriteRescan );
+    RUN( TestAckByte );
+    RUN( TestPackAcrossSectors );
+    return TEST_RESULT( );
+}
@@ -0,0 +1,801 @@
+#!/usr/bin/env python3
+"""Fleet simulator, how many nodes one EU868 gateway carries.
+
+Usage: fleet_sim.py [--nodes 100,500,1000,2000] [--duration S] [options]
+
+Runs a discrete event simulation, in virtual time, of N class A nodes
+sending to one 8 channel gateway, for every node count of --nodes, and
+prints the packet error rate, the throughput and the node energy.
+
+The nodes follow what LoRaMac.c, RegionEU868.c and the sketches do:
+
+  - an uplink every --period seconds plus up to --jitter seconds, counted
+    from the end of the previous one (APP_TX_DUTYCYCLE_RND), or with
+    --slots in the DevEUI transmit slot of LoRaWanClass::slotDutyCycle,
+    the time known within --slot-accuracy seconds
+  - a random channel among the 3 default and 5 CFList ones whose band has
+    duty cycle credits left, waiting for the band otherwise: each band
+    holds up to an hour of credits, refilled with the time and charged
+    with the time on air times the 1 % duty cycle at every uplink
+  - the spreading factor ADR settles on for the node link budget, with
+    --adr-margin dB of margin
+  - a --confirmed fraction of confirmed uplinks, retried up to --trials
+    times ACK_TIMEOUT +- ACK_TIMEOUT_RND after the RX2 delay, one data
+    rate lower every second retry, on the next 1 s MAC state check
+  - time on air computed as SX1276GetTimeOnAir, RX windows as
+    RegionCommonComputeRxWindowParameters, and the radio energy drawn with
+    the current profile of src/board-config.h, at the output power of the
+    EU868 maximum EIRP less the antenna gain
+
+The gateway receives a packet when it is above the sensitivity of its
+spreading factor and:
+
+  - a demodulator is free when its preamble starts, --demodulators of
+    them shared by all the channels, as the SX1301 has 8
+  - every packet overlapping it on its channel after its preamble lock
+    (the last 5 preamble symbols) is weaker by the capture threshold:
+    6 dB on the same spreading factor, the imperfect orthogonality
+    thresholds of Croce et al. across spreading factors
+  - the gateway is not transmitting, it is half duplex
+
+Acknowledgements go in RX1 on the uplink channel and data rate, or in RX2
+when the gateway duty cycle does not allow RX1. They are not lost.
+
+--retry selects the confirmed uplink retransmission policy: "fixed" is the
+LoRaWAN table, "adaptive" the history based choice of MIB_RETRY_ADAPTIVE
+(datarate with the most acknowledges per time on air, spacing shrinking
+with the acknowledge rate, unacknowledged channels avoided) and "both"
+runs the two on the same fleets. --deadline gives up a confirmed uplink
+whose next attempt cannot be acknowledged in time, as MIB_RETRY_DEADLINE.
+
+With --join REGION the fleet is not simulated. One device joins a US915,
+AU915 or US915 Hybrid network whose gateway listens on --network-subband
+only, --runs times, with the random channel choice of the regions before
+the subband join scheduler and with the scheduler, first join and rejoin.
+The average join attempts, airtime and time to join are printed, with the
+RegionCommonGetJoinDc back-off between the attempts.
+
+Node counts and --runs replications are independent simulations spread
+over --jobs processes. The idle workers take the next one from a shared
+queue, largest first, so that all the cores stay busy until the end.
+
+--check-stack BINARY checks the node model against the real MAC instead:
+BINARY is tests/test-fleet-node of the host build, which runs one node on
+the simulated radio and prints its requests, uplinks and radio time and
+charge. The trace is replayed through the functions above, time on air,
+RX windows, retry datarates and spacing, duty cycle credits and energy,
+and any mismatch fails. The fleet itself stays a model: the MAC contexts
+of a process share the one radio driver, one request at a time, and
+cannot collide the way a fleet does.
+"""
+
+import argparse
+import heapq
+import math
+import multiprocessing
+import os
+import random
+import re
+import subprocess
+import sys
+
+# EU868 channels after the join CFList [MHz] and their RegionEU868 band
+CHANNELS = [(868.1, 1), (868.3, 1), (868.5, 1),
+            (867.1, 0), (867.3, 0), (867.5, 0), (867.7, 0), (867.9, 0)]
+# Band duty cycle, as the DCycle of EU868_BANDx: time off = airtime * DCycle
+BAND_DCYCLE = {0: 100, 1: 100, 3: 10}
+RX2_BAND = 3
+RX2_SF = 12
+
+RECEIVE_DELAY1 = 1.0
+RECEIVE_DELAY2 = 2.0
+ACK_TIMEOUT = 2.0
+ACK_TIMEOUT_RND = 1.0
+PREAMBLE = 8
+PREAMBLE_LOCK = 5
+MIN_RX_SYMBOLS = 6
+SYSTEM_MAX_RX_ERROR = 0.010
+# LoRaMac.h MAC_STATE_CHECK_TIMEOUT, RegionCommon.h REGION_COMMON_DC_PERIOD [s]
+MAC_STATE_CHECK = 1.0
+DC_PERIOD = 3600.0
+# LoRaMac.c RETRY_ACK_TIMEOUT_MIN, RETRY_MAX_DR_STEPS, RETRY_CHANNEL_DRAWS,
+# LoRaMac.h RETRY_HISTORY_LENGTH
+RETRY_ACK_TIMEOUT_MIN = 1.0
+RETRY_MAX_DR_STEPS = 4
+RETRY_CHANNEL_DRAWS = 3
+RETRY_HISTORY_LENGTH = 32
+# ESP32_LoRaWAN.h APP_TX_SLOT_MIN_WIDTH [ms]
+SLOT_MIN_WIDTH = 128
+# MHDR, FHDR without FOpts, FPort and MIC
+FRAME_OVERHEAD = 13
+# Empty downlink with the ACK bit set
+ACK_SIZE = 12
+
+# SX1276 sensitivity, 125 kHz [dBm]
+SENSITIVITY = {7: -123.0, 8: -126.0, 9: -129.0, 10: -132.0, 11: -134.5, 12: -137.0}
+# Capture threshold [dB], wanted spreading factor (row) against the
+# interferer one (column), 7 to 12
+CAPTURE = [[6, -8, -9, -9, -9, -9],
+           [-11, 6, -11, -12, -13, -13],
+           [-15, -13, 6, -13, -14, -15],
+           [-19, -18, -17, 6, -17, -18],
+           [-22, -22, -21, -20, 6, -20],
+           [-25, -25, -25, -24, -23, 6]]
+
+BOARD_CONFIG = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src", "board-config.h")
+
+
+def airtime(sf, size, bw=125000):
+    """Time on air of a LoRa frame [s], CR 4/5, explicit header, CRC on."""
+    tsym = (1 << sf) / float(bw)
+    de = 1 if tsym > 0.016 else 0
+    n = 8 * size - 4 * sf + 28 + 16
+    n = max(math.ceil(n / (4.0 * (sf - 2 * de))) * 5, 0)
+    return (PREAMBLE + 4.25 + 8 + n) * tsym
+
+
+def rx_symbols(sf):
+    """Symbols of an RX window, RegionCommonComputeRxWindowParameters."""
+    tsym = (1 << sf) / 125000.0
+    return max(math.ceil(((2 * MIN_RX_SYMBOLS - 8) * tsym + 2 * SYSTEM_MAX_RX_ERROR) / tsym), MIN_RX_SYMBOLS)
+
+
+def rx_window(sf):
+    """Time an RX window stays open when nothing is received [s]."""
+    return rx_symbols(sf) * (1 << sf) / 125000.0
+
+
+def rx_delay(delay, sf):
+    """Opening of an RX window after the end of the uplink [s], its offset rounded up to the ms."""
+    tsym = (1 << sf) / 125000.0
+    return delay + math.ceil(1000.0 * (4.0 * tsym - rx_symbols(sf) * tsym / 2.0)) / 1000.0
+
+
+def state_check(start, time):
+    """First MAC state check at or after time [s], its timer restarted at the uplink start."""
+    return start + MAC_STATE_CHECK * math.ceil((time - start) / MAC_STATE_CHECK - 1e-9)
+
+
+def path_loss(distance):
+    """Urban macro cell path loss [dB], distance in metres."""
+    return 128.1 + 37.6 * math.log10(max(distance, 10.0) / 1000.0)
+
+
+def board_profile(path, sx126x):
+    """Current profile [uA] and supply [mV] of the board-config.h radio branch."""
+    with open(path) as f:
+        text = f.read()
+    branches = text.split("#if defined( RADIO_SX126X )", 1)[1].split("#else", 1)
+    body = branches[0] if sx126x else branches[1]
+    values = {k: int(v) for k, v in re.findall(r"#define\s+(BOARD_\w+)\s+(-?\d+)", body)}
+    tx = re.search(r"BOARD_RADIO_TX_CURRENT\s+\{([^}]*)\}", body).group(1)
+    values["TX"] = [int(v) for v in re.findall(r"\d+", tx)]
+    return values
+
+
+def tx_current(board, power):
+    """Radio current at an output power [uA], BOARD_RADIO_TX_CURRENT."""
+    return board["TX"][min(max(power - board["BOARD_RADIO_TX_POWER_MIN"], 0), len(board["TX"]) - 1)]
+
+
+class Packet:
+    __slots__ = ("node", "channel", "sf", "start", "end", "rssi", "lock", "interferers", "demod")
+
+    def __init__(self, node, channel, sf, start, end, rssi):
+        self.node = node
+        self.channel = channel
+        self.sf = sf
+        self.start = start
+        self.end = end
+        self.rssi = rssi
+        self.lock = start + (PREAMBLE - PREAMBLE_LOCK) * (1 << sf) / 125000.0
+        self.interferers = []
+        self.demod = False
+
+
+class Node:
+    __slots__ = ("rssi", "adr_sf", "sf", "confirmed", "counter", "band_credits", "band_update", "tx_time",
+                 "rx_time", "start", "attempts", "acks", "acks_rx", "failed", "slot")
+
+    def __init__(self, rssi, adr_sf, slot):
+        self.rssi = rssi
+        self.adr_sf = adr_sf
+        self.slot = slot
+        self.sf = adr_sf
+        self.confirmed = False
+        self.counter = 1
+        self.band_credits = {0: DC_PERIOD, 1: DC_PERIOD}
+        self.band_update = {0: 0.0, 1: 0.0}
+        self.tx_time = 0.0
+        self.rx_time = 0.0
+        self.start = 0.0
+        self.attempts = {}
+        self.acks = {}
+        self.acks_rx = [0, 0]
+        self.failed = set()
+
+    def credits(self, band, now):
+        """RegionCommonUpdateBandCredits, duty cycle credits of a band at now [s]."""
+        credits = min(self.band_credits[band] + now - self.band_update[band], DC_PERIOD)
+        self.band_credits[band], self.band_update[band] = credits, now
+        return credits
+
+    def band_delay(self, now):
+        """RegionCommonUpdateBandTimeOff, time to the first band with credits [s], 0 when one has."""
+        return max(min(-self.credits(band, now) for band in self.band_credits), 0.0)
+
+    def charge(self, band, end, toa):
+        """RegionCommonSetBandTxDone, time on air times the duty cycle charged at the TX done.
+
+        The MAC takes the time on air of the radio driver, rounded up to the ms.
+        """
+        self.band_credits[band] = self.credits(band, end) - math.ceil(1000.0 * toa) / 1000.0 * BAND_DCYCLE[band]
+
+    def ack_rate(self, sf):
+        """RetryAckRate, an unused spreading factor counts as one half."""
+        return (self.acks.get(sf, 0) + 0.5) / (self.attempts.get(sf, 0) + 1)
+
+    def ack_delay(self):
+        """Delay to the window that brought most acknowledges, RetryFitsDeadline."""
+        rx1, rx2 = self.acks_rx
+        return RECEIVE_DELAY1 if rx1 > 0 and rx1 >= rx2 else RECEIVE_DELAY2
+
+
+def retry_sf(node, size, now, deadline):
+    """RetryBestDatarate, None when no spreading factor meets the deadline."""
+    best, best_score = None, 0.0
+    for sf in range(node.sf, min(node.sf + RETRY_MAX_DR_STEPS, 13)):
+        toa = airtime(sf, size)
+        if deadline and now - node.start + toa + node.ack_delay() > deadline:
+            continue
+        score = node.ack_rate(sf) / toa
+        if best is None or score > best_score:
+            best, best_score = sf, score
+    return best
+
+
+def slot_time(node, now, toa, opts, rng):
+    """Start of the next uplink of LoRaWanClass::slotDutyCycle called at now [s]."""
+    accuracy = opts["slot_accuracy"]
+    width = SLOT_MIN_WIDTH
+    while width < 1000.0 * (toa + 2 * accuracy):
+        width *= 2
+    slots = int(1000.0 * opts["period"]) // width
+    if slots < 2:
+        return now + opts["period"] + rng.uniform(0.0, opts["jitter"])
+    slot = int(1000.0 * now) // width + slots // 2 + 1
+    slot += (node.slot % slots + slots - slot % slots) % slots
+    return (slot * width + (width - 1000.0 * toa) / 2) / 1000.0 + rng.uniform(-accuracy, accuracy)
+
+
+def simulate(task):
+    nodes_count, run, policy, opts = task
+    adaptive = policy == "adaptive"
+    deadline = opts["deadline"]
+    rng = random.Random(opts["seed"] * 1000003 + nodes_count * 101 + run)
+    size = opts["payload"] + FRAME_OVERHEAD
+    tx_power = opts["tx_power"]
+
+    nodes = []
+    for _ in range(nodes_count):
+        distance = opts["radius"] * math.sqrt(rng.random())
+        rssi = tx_power - path_loss(distance) + rng.gauss(0.0, opts["shadowing"])
+        adr_sf = 12
+        for sf in range(7, 13):
+            if rssi >= SENSITIVITY[sf] + opts["adr_margin"]:
+                adr_sf = sf
+                break
+        nodes.append(Node(rssi, adr_sf, rng.getrandbits(32)))
+
+    stats = dict(messages=0, delivered=0, bytes=0, sent=0, received=0, sensitivity=0,
+                 collision=0, demodulator=0, gateway_tx=0, acks=0, acks_rx2=0, no_ack_dc=0,
+                 airtime=0.0, confirmed=0, confirmed_delivered=0, confirmed_airtime=0.0,
+                 deadline_misses=0)
+    events = []
+    seq = 0
+    active = []
+    demods = 0
+    gw_band_free = {0: 0.0, 1: 0.0, 3: 0.0}
+    gw_tx = []
+
+    def push(time, kind, data):
+        nonlocal seq
+        heapq.heappush(events, (time, seq, kind, data))
+        seq += 1
+
+    def gateway_send(start, sf, band):
+        end = start + airtime(sf, ACK_SIZE)
+        if gw_band_free[band] > start:
+            return False
+        for s, e in gw_tx:
+            if s < end and start < e:
+                return False
+        gw_band_free[band] = start + (end - start) * BAND_DCYCLE[band]
+        gw_tx.append((start, end))
+        return True
+
+    for i in range(nodes_count):
+        push(rng.uniform(0.0, opts["period"]), "app", i)
+
+    while events:
+        now, _, kind, data = heapq.heappop(events)
+
+        if kind == "app":
+            if now >= opts["duration"]:
+                continue
+            node = nodes[data]
+            stats["messages"] += 1
+            node.confirmed = rng.random() < opts["confirmed"]
+            node.counter = 1
+            node.sf = node.adr_sf
+            node.start = now
+            if node.confirmed:
+                stats["confirmed"] += 1
+            push(now, "tx", data)
+
+        elif kind == "tx":
+            node = nodes[data]
+            delay = node.band_delay(now)
+            if delay > 0.0:
+                push(now + delay, "tx", data)
+                continue
+            free = [c for c, (_, band) in enumerate(CHANNELS) if node.band_credits[band] >= 0.0]
+            channel = rng.choice(free)
+            if adaptive and node.confirmed and node.counter > 1:
+                for _ in range(RETRY_CHANNEL_DRAWS):
+                    if channel not in node.failed:
+                        break
+                    channel = rng.choice(free)
+            toa = airtime(node.sf, size)
+            band = CHANNELS[channel][1]
+            node.charge(band, now + toa, toa)
+            node.tx_time += toa
+            stats["sent"] += 1
+            stats["airtime"] += toa
+            if node.confirmed:
+                stats["confirmed_airtime"] += toa
+                if node.attempts.get(node.sf, 0) >= RETRY_HISTORY_LENGTH:
+                    node.attempts[node.sf] //= 2
+                    node.acks[node.sf] = node.acks.get(node.sf, 0) // 2
+                node.attempts[node.sf] = node.attempts.get(node.sf, 0) + 1
+
+            packet = Packet(data, channel, node.sf, now, now + toa, node.rssi + rng.gauss(0.0, opts["fading"]))
+            active[:] = [p for p in active if p.end > now]
+            for other in active:
+                if other.channel == channel:
+                    other.interferers.append(packet)
+                    packet.interferers.append(other)
+            active.append(packet)
+            if packet.rssi >= SENSITIVITY[packet.sf] and demods < opts["demodulators"]:
+                demods += 1
+                packet.demod = True
+            push(packet.end, "end", packet)
+
+        elif kind == "end":
+            packet = data
+            node = nodes[packet.node]
+            if packet.demod:
+                demods -= 1
+            gw_tx[:] = [(s, e) for s, e in gw_tx if e > packet.start - RECEIVE_DELAY2]
+
+            if packet.rssi < SENSITIVITY[packet.sf]:
+                stats["sensitivity"] += 1
+                received = False
+            elif not packet.demod:
+                stats["demodulator"] += 1
+                received = False
+            elif any(s < packet.end and packet.start < e for s, e in gw_tx):
+                stats["gateway_tx"] += 1
+                received = False
+            elif any(o.end > packet.lock and
+                     packet.rssi - o.rssi < CAPTURE[packet.sf - 7][o.sf - 7] for o in packet.interferers):
+                stats["collision"] += 1
+                received = False
+            else:
+                stats["received"] += 1
+                received = True
+
+            acked = None
+            if received and node.confirmed:
+                band = CHANNELS[packet.channel][1]
+                if gateway_send(packet.end + RECEIVE_DELAY1, packet.sf, band):
+                    acked = 1
+                elif gateway_send(packet.end + RECEIVE_DELAY2, RX2_SF, RX2_BAND):
+                    acked = 2
+                    stats["acks_rx2"] += 1
+                else:
+                    stats["no_ack_dc"] += 1
+                if acked:
+                    stats["acks"] += 1
+
+            if acked == 1:
+                node.rx_time += airtime(packet.sf, ACK_SIZE)
+            elif acked == 2:
+                node.rx_time += rx_window(packet.sf) + airtime(RX2_SF, ACK_SIZE)
+            else:
+                node.rx_time += rx_window(packet.sf) + rx_window(RX2_SF)
+            # The MAC is done at the state check after the last RX window, or
+            # after the acknowledge timeout counted from the RX2 delay
+            window = packet.end + rx_delay(RECEIVE_DELAY2, RX2_SF)
+            if acked == 1:
+                done = packet.end + rx_delay(RECEIVE_DELAY1, packet.sf) + airtime(packet.sf, ACK_SIZE)
+            elif acked == 2:
+                done = window + airtime(RX2_SF, ACK_SIZE)
+            else:
+                done = window + rx_window(RX2_SF)
+
+            if node.confirmed:
+                if acked:
+                    node.acks[packet.sf] = node.acks.get(packet.sf, 0) + 1
+                    if sum(node.acks_rx) >= RETRY_HISTORY_LENGTH:
+                        node.acks_rx = [node.acks_rx[0] // 2, node.acks_rx[1] // 2]
+                    node.acks_rx[acked - 1] += 1
+                    node.failed.discard(packet.channel)
+                else:
+                    node.failed.add(packet.channel)
+
+            if node.confirmed and not acked:
+                spacing = ACK_TIMEOUT + rng.uniform(-ACK_TIMEOUT_RND, ACK_TIMEOUT_RND)
+                if adaptive:
+                    rate = node.ack_rate(node.sf)
+                    spacing = RETRY_ACK_TIMEOUT_MIN + (spacing - RETRY_ACK_TIMEOUT_MIN) * (1.0 - rate)
+                done = state_check(packet.start, window + spacing)
+            if node.confirmed and not acked and node.counter < opts["trials"]:
+                if adaptive:
+                    if deadline and done - node.start + airtime(node.sf, size) + node.ack_delay() > deadline:
+                        done = state_check(packet.start, window + RETRY_ACK_TIMEOUT_MIN)
+                    sf = retry_sf(node, size, done, deadline)
+                else:
+                    sf = min(node.sf + 1, 12) if (node.counter + 1) % 2 == 1 else node.sf
+                    if deadline and done - node.start + airtime(sf, size) + node.ack_delay() > deadline:
+                        sf = None
+                if sf is not None:
+                    node.counter += 1
+                    node.sf = sf
+                    push(done, "tx", packet.node)
+                    continue
+                stats["deadline_misses"] += 1
+            done = state_check(packet.start, done)
+
+            if (acked if node.confirmed else received):
+                stats["delivered"] += 1
+                stats["bytes"] += opts["payload"]
+                if node.confirmed:
+                    stats["confirmed_delivered"] += 1
+            if opts["slots"]:
+                # Scheduled when the uplink is sent, one more cycle when the
+                # retries ran past the slot
+                start = slot_time(node, node.start, airtime(node.adr_sf, size), opts, rng)
+                while start < done:
+                    start += opts["period"]
+                push(start, "app", packet.node)
+            else:
+                push(done + opts["period"] + rng.uniform(0.0, opts["jitter"]), "app", packet.node)
+
+    board = opts["board"]
+    volts = board["BOARD_SUPPLY_VOLTAGE"] / 1000.0
+    current = tx_current(board, tx_power)
+    sleep_current = board["BOARD_MCU_SLEEP_CURRENT"] + board["BOARD_RADIO_SLEEP_CURRENT"]
+    active_current = board["BOARD_MCU_ACTIVE_CURRENT"]
+    charge = 0.0
+    for node in nodes:
+        sleep = max(opts["duration"] - node.tx_time - node.rx_time, 0.0)
+        charge += node.tx_time * (current + active_current)
+        charge += node.rx_time * (board["BOARD_RADIO_RX_CURRENT"] + active_current)
+        charge += sleep * sleep_current
+    stats["energy"] = charge * 1e-6 * volts
+    return nodes_count, policy, stats
+
+
+# Scheduling slack of the MAC on the host clock [s]
+STACK_TOLERANCE = 0.020
+
+
+def read_stack_trace(binary):
+    """Messages of a test-fleet-node --trace run: request, uplinks and confirm."""
+    output = subprocess.run([binary, "--trace"], stdout=subprocess.PIPE, universal_newlines=True).stdout
+    messages = []
+    for line in output.splitlines():
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == "request":
+            messages.append(dict(request=int(fields[1]) / 1e6, confirmed=fields[2] == "1", uplinks=[], confirm=None))
+        elif fields[0] == "uplink" and messages:
+            start, toa, frequency, sf, size = (int(v) for v in fields[1:6])
+            messages[-1]["uplinks"].append((start / 1e6, toa / 1e6, frequency / 1e6, sf, size))
+        elif fields[0] == "confirm" and messages:
+            time, trials, ack, tx, rx, tx_charge, rx_charge = (int(v) for v in fields[1:8])
+            messages[-1]["confirm"] = (time / 1e6, trials, ack, tx / 1000.0, rx / 1000.0, tx_charge / 1000.0,
+                                       rx_charge / 1000.0)
+        else:
+            # The checks of the test itself
+            print(line)
+    return messages
+
+
+def check_stack(opts):
+    """Replays the real MAC of tests/test-fleet-node through the node model, returns the mismatches."""
+    messages = read_stack_trace(opts["check_stack"])
+    board = opts["board"]
+    current = tx_current(board, opts["tx_power"])
+    size = opts["payload"] + FRAME_OVERHEAD
+    bands = {frequency: band for frequency, band in CHANNELS}
+    node = Node(0.0, 12, 0)
+    errors = []
+    worst = dict(toa=0.0, rx=0.0, charge=0.0, start=0.0, done=0.0)
+    uplinks = retries = waits = 0
+    spacing = model_spacing = 0.0
+
+    def expect(name, error, limit, text):
+        worst[name] = max(worst[name], abs(error))
+        if abs(error) > limit:
+            errors.append(text)
+
+    if not messages:
+        errors.append("no trace from %s" % opts["check_stack"])
+    for m in messages:
+        if m["confirm"] is None or not m["uplinks"]:
+            errors.append("request at %.3f s not sent or not confirmed" % m["request"])
+            continue
+        time, trials, ack, tx, rx, tx_charge, rx_charge = m["confirm"]
+        expected = opts["trials"] if m["confirmed"] else 1
+        if len(m["uplinks"]) != expected or (m["confirmed"] and trials != expected):
+            errors.append("request at %.3f s: %d uplinks, %d expected" % (m["request"], len(m["uplinks"]), expected))
+        sf = m["uplinks"][0][3]
+        model_tx = model_rx = 0.0
+        prev = None
+        for counter, (start, toa, frequency, uplink_sf, uplink_size) in enumerate(m["uplinks"], 1):
+            uplinks += 1
+            if uplink_size != size:
+                errors.append("uplink at %.3f s: %d bytes, the model sends %d" % (start, uplink_size, size))
+            expect("toa", toa - airtime(uplink_sf, uplink_size), 1e-6,
+                   "uplink at %.3f s: %.6f s on air, the model %.6f s" % (start, toa, airtime(uplink_sf, uplink_size)))
+            if prev is None:
+                delay = node.band_delay(m["request"])
+                waits += delay > 0.0
+                expect("start", start - m["request"] - delay, STACK_TOLERANCE,
+                       "uplink at %.3f s, the model sends at %.3f s" % (start, m["request"] + delay))
+            else:
+                retries += 1
+                if counter % 2 == 1:
+                    sf = min(sf + 1, 12)
+                if uplink_sf != sf:
+                    errors.append("retry at %.3f s on SF%d, the model on SF%d" % (start, uplink_sf, sf))
+                window = prev[0] + prev[1] + rx_delay(RECEIVE_DELAY2, RX2_SF)
+                low = state_check(prev[0], window + ACK_TIMEOUT - ACK_TIMEOUT_RND)
+                high = state_check(prev[0], window + ACK_TIMEOUT + ACK_TIMEOUT_RND)
+                if not low - STACK_TOLERANCE <= start <= high + STACK_TOLERANCE:
+                    errors.append("retry at %.3f s, the model between %.3f and %.3f s" % (start, low, high))
+                spacing += start - prev[0] - prev[1]
+                model_spacing += sum(state_check(prev[0], window + ACK_TIMEOUT + ACK_TIMEOUT_RND * ((i + 0.5) / 32 - 1))
+                                     for i in range(64)) / 64 - prev[0] - prev[1]
+            band = bands.get(frequency)
+            if band is None:
+                errors.append("uplink at %.3f s on %.1f MHz, not a channel of the model" % (start, frequency))
+                continue
+            if node.credits(band, start) < -STACK_TOLERANCE:
+                errors.append("uplink at %.3f s on band %d, %.3f s of credits short" % (start, band, -node.credits(band, start)))
+            node.charge(band, start + toa, toa)
+            model_tx += toa
+            model_rx += rx_window(uplink_sf) + rx_window(RX2_SF)
+            prev = (start, toa)
+
+        # Radio time in ms, rounded at every state change
+        expect("rx", rx - model_rx, 0.001 * (2 * len(m["uplinks"]) + 1),
+               "request at %.3f s: %.3f s of RX, the model %.3f s" % (m["request"], rx, model_rx))
+        expect("charge", tx_charge / (model_tx * current) - 1.0, 0.02,
+               "request at %.3f s: %.0f uC of TX, the model %.0f uC" % (m["request"], tx_charge, model_tx * current))
+        expect("charge", rx_charge / (model_rx * board["BOARD_RADIO_RX_CURRENT"]) - 1.0, 0.02,
+               "request at %.3f s: %.0f uC of RX, the model %.0f uC" %
+               (m["request"], rx_charge, model_rx * board["BOARD_RADIO_RX_CURRENT"]))
+        window = prev[0] + prev[1] + rx_delay(RECEIVE_DELAY2, RX2_SF)
+        if m["confirmed"]:
+            low = state_check(prev[0], window + ACK_TIMEOUT - ACK_TIMEOUT_RND)
+            high = state_check(prev[0], window + ACK_TIMEOUT + ACK_TIMEOUT_RND)
+            if not low - STACK_TOLERANCE <= time <= high + STACK_TOLERANCE:
+                errors.append("confirm at %.3f s, the model between %.3f and %.3f s" % (time, low, high))
+        else:
+            done = state_check(prev[0], window + rx_window(RX2_SF))
+            expect("done", time - done, STACK_TOLERANCE, "confirm at %.3f s, the model at %.3f s" % (time, done))
+
+    print("node model against %s: %d messages, %d uplinks, %d retries, %d duty cycle waits" %
+          (opts["check_stack"], len(messages), uplinks, retries, waits))
+    print("  time on air %.3f ms, RX time %.1f ms, radio charge %.2f %%, uplink start %.1f ms, "
+          "confirm %.1f ms worst error" % (1000.0 * worst["toa"], 1000.0 * worst["rx"], 100.0 * worst["charge"],
+                                           1000.0 * worst["start"], 1000.0 * worst["done"]))
+    if retries:
+        print("  retry spacing %.2f s mean, the model %.2f s" % (spacing / retries, model_spacing / retries))
+        if abs(spacing - model_spacing) / retries > 0.3:
+            errors.append("retry spacing %.2f s mean, the model %.2f s" % (spacing / retries, model_spacing / retries))
+    for error in errors[:20]:
+        print("  " + error)
+    if len(errors) > 20:
+        print("  %d more" % (len(errors) - 20))
+    return len(errors)
+
+
+# Join request size and the delay to the end of RX2 [s]
+JOIN_REQUEST_SIZE = 23
+JOIN_ACCEPT_DELAY2 = 6.0
+# Join data rates, 125 kHz and 500 kHz: RegionXXAlternateDr
+JOIN_DATARATES = {"us915": ((10, 125000), (8, 500000)),
+                  "us915-hybrid": ((10, 125000), (8, 500000)),
+                  "au915": ((10, 125000), (8, 500000))}
+
+
+def join_dc(elapsed):
+    """RegionCommonGetJoinDc, elapsed time since the first join request [s]."""
+    if elapsed < 3600.0:
+        return 100
+    if elapsed < 3600.0 + 36000.0:
+        return 1000
+    return 10000
+
+
+def join_filter(state, enabled):
+    """RegionCommonJoinSubBandFilter, state is [subband, trials]."""
+    def sub_band(channel):
+        return channel // 8 if channel < 64 else channel - 64
+    for n in range(8):
+        band = (state[0] + n) % 8
+        kept = [c for c in enabled if sub_band(c) == band]
+        if not kept:
+            continue
+        if n != 0:
+            state[0], state[1] = band, 0
+        state[1] += 1
+        if state[1] >= 2:
+            state[0], state[1] = (band + 1) % 8, 0
+        return kept
+    return enabled
+
+
+def join_once(rng, opts, scheduler, state):
+    """Joins once, returns attempts, airtime [s] and time to join [s]."""
+    narrow, wide = JOIN_DATARATES[opts["join"]]
+    network = opts["network_subband"]
+    remaining = set(range(64))
+    t = 0.0
+    band_free = 0.0
+    total_airtime = 0.0
+    for trial in range(1, opts["join_trials"] + 1):
+        t = max(t, band_free)
+        # RegionXXAlternateDr: 500 kHz on odd trials, the 500 kHz mask is re-enabled
+        if trial & 1:
+            sf, bw = wide
+            enabled = list(range(64, 72))
+        else:
+            sf, bw = narrow
+            if scheduler:
+                enabled = list(range(64))
+            else:
+                if not remaining:
+                    remaining = set(range(64))
+                enabled = sorted(remaining)
+        if scheduler:
+            enabled = join_filter(state, enabled)
+        channel = rng.choice(enabled)
+        remaining.discard(channel)
+        toa = airtime(sf, JOIN_REQUEST_SIZE, bw)
+        total_airtime += toa
+        band_free = t + toa * join_dc(t)
+        heard = channel - 64 == network if channel >= 64 else channel // 8 == network
+        if heard and rng.random() >= opts["join_loss"]:
+            if scheduler:
+                # RegionCommonJoinSubBandAccepted
+                state[0], state[1] = (channel // 8 if channel < 64 else channel - 64), 0
+            return trial, total_airtime, t + toa
+        t += toa + JOIN_ACCEPT_DELAY2
+    return opts["join_trials"], total_airtime, None
+
+
+def join_study(opts):
+    rng = random.Random(opts["seed"])
+    print("%-31s %9s %11s %12s %7s" % ("", "attempts", "airtime[s]", "time[s]", "failed"))
+    for label, scheduler in (("random channels", False), ("subband scheduler", True)):
+        for phase in ("first join", "rejoin"):
+            attempts = airtime_sum = time_sum = 0.0
+            joined = failed = 0
+            for _ in range(opts["runs"]):
+                state = [0, 0]
+                if phase == "rejoin":
+                    join_once(rng, opts, scheduler, state)
+                n, toa, t = join_once(rng, opts, scheduler, state)
+                attempts += n
+                airtime_sum += toa
+                if t is None:
+                    failed += 1
+                else:
+                    joined += 1
+                    time_sum += t
+            print("%-31s %9.2f %11.3f %12.1f %7d" %
+                  ("%s, %s" % (label, phase), attempts / opts["runs"], airtime_sum / opts["runs"],
+                   time_sum / max(joined, 1), failed))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--nodes", default="100,250,500,1000,2000,4000",
+                        help="comma separated node counts")
+    parser.add_argument("--duration", type=float, default=3600.0, help="simulated time [s]")
+    parser.add_argument("--period", type=float, default=600.0, help="uplink period [s]")
+    parser.add_argument("--jitter", type=float, default=1.0, help="random extra period [s]")
+    parser.add_argument("--slots", action="store_true", help="DevEUI transmit slots instead of the jitter")
+    parser.add_argument("--slot-accuracy", type=float, default=0.02, help="network time accuracy [s]")
+    parser.add_argument("--payload", type=int, default=12, help="application payload [bytes]")
+    parser.add_argument("--confirmed", type=float, default=0.0, help="fraction of confirmed uplinks")
+    parser.add_argument("--trials", type=int, default=8, help="confirmed uplink transmissions")
+    parser.add_argument("--retry", choices=("fixed", "adaptive", "both"), default="fixed",
+                        help="confirmed uplink retransmission policy")
+    parser.add_argument("--deadline", type=float, default=0.0, help="confirmed uplink deadline [s], 0 for none")
+    parser.add_argument("--tx-power", type=int, default=13,
+                        help="node output power [dBm], EU868 TX_POWER_0: 16 dBm EIRP less 2.15 dBi")
+    parser.add_argument("--radius", type=float, default=3000.0, help="cell radius [m]")
+    parser.add_argument("--shadowing", type=float, default=6.0, help="per node shadowing [dB]")
+    parser.add_argument("--fading", type=float, default=2.0, help="per packet fading [dB]")
+    parser.add_argument("--adr-margin", type=float, default=10.0, help="ADR installation margin [dB]")
+    parser.add_argument("--demodulators", type=int, default=8, help="gateway demodulators")
+    parser.add_argument("--sx126x", action="store_true", help="SX126x current profile")
+    parser.add_argument("--board-config", default=BOARD_CONFIG, help="board-config.h to read")
+    parser.add_argument("--runs", type=int, default=4, help="replications per node count")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1)
+    parser.add_argument("--join", choices=sorted(JOIN_DATARATES), help="join study instead of the fleet")
+    parser.add_argument("--network-subband", type=int, default=1, help="subband of the gateway, 0 to 7")
+    parser.add_argument("--join-trials", type=int, default=48, help="join requests before giving up")
+    parser.add_argument("--join-loss", type=float, default=0.0, help="join requests lost on the heard subband")
+    parser.add_argument("--check-stack", metavar="BINARY", help="check the node model against tests/test-fleet-node")
+    args = parser.parse_args()
+
+    opts = dict(vars(args))
+    if args.check_stack:
+        opts["board"] = board_profile(args.board_config, args.sx126x)
+        sys.exit(1 if check_stack(opts) else 0)
+    if args.join:
+        if args.runs < 100:
+            opts["runs"] = 1000
+        join_study(opts)
+        return
+    opts["board"] = board_profile(args.board_config, args.sx126x)
+    counts = sorted({int(n) for n in args.nodes.split(",")}, reverse=True)
+    policies = ("fixed", "adaptive") if args.retry == "both" else (args.retry,)
+    tasks = [(n, run, policy, opts) for n in counts for run in range(args.runs) for policy in policies]
+
+    totals = {(policy, n): {} for n in counts for policy in policies}
+    with multiprocessing.Pool(args.jobs) as pool:
+        for n, policy, stats in pool.imap_unordered(simulate, tasks, chunksize=1):
+            for key, value in stats.items():
+                totals[policy, n][key] = totals[policy, n].get(key, 0) + value
+
+    for policy in policies:
+        if len(policies) > 1:
+            print("%s retransmissions" % policy)
+        report(args, opts, counts, {n: totals[policy, n] for n in counts})
+
+
+def report(args, opts, counts, totals):
+    duration = args.duration * args.runs
+    print("%6s %6s %7s %6s %6s %6s %6s %6s %7s %8s %9s %8s" %
+          ("nodes", "load", "uplinks", "PER", "coll", "demod", "gw_tx", "range", "deliv",
+           "thr[bps]", "E/msg[mJ]", "I[uA]"))
+    for n in sorted(counts):
+        t = totals[n]
+        sent = max(t["sent"], 1)
+        print("%6d %6.3f %7d %6.3f %6.3f %6.3f %6.3f %6.3f %7.3f %8.2f %9.2f %8.1f" %
+              (n, t["airtime"] / duration / len(CHANNELS), t["sent"] // args.runs,
+               1.0 - t["received"] / sent, t["collision"] / sent, t["demodulator"] / sent,
+               t["gateway_tx"] / sent, t["sensitivity"] / sent,
+               t["delivered"] / max(t["messages"], 1), 8.0 * t["bytes"] / duration,
+               1000.0 * t["energy"] / max(t["delivered"], 1),
+               1e6 * t["energy"] / (opts["board"]["BOARD_SUPPLY_VOLTAGE"] / 1000.0) / duration / n))
+        if args.confirmed > 0.0:
+            print("%6s acks %d, in RX2 %d, not sent for the gateway duty cycle %d" %
+                  ("", t["acks"] // args.runs, t["acks_rx2"] // args.runs, t["no_ack_dc"] // args.runs))
+            print("%6s confirmed delivered %.3f, %.3f per airtime second, deadline misses %d" %
+                  ("", t["confirmed_delivered"] / max(t["confirmed"], 1),
+                   t["confirmed_delivered"] / max(t["confirmed_airtime"], 1e-9), t["deadline_misses"] // args.runs))
+
+
+if __name__ == "__main__":
+    main()
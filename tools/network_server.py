@@ -0,0 +1,574 @@
+#!/usr/bin/env python3
+"""Stand-in LoRaWAN 1.0 network server for end-to-end tests of a node.
+
+Usage: network_server.py --deveui EUI --appeui EUI --appkey KEY [options]
+
+Speaks the gateway side of the Semtech UDP protocol v2, like
+pktfwd_server.py, so that a node can be tested against the Packet_Forwarder
+example without a real LNS. It handles one EU868 end-device:
+
+  - accepts the join requests, with a CFList adding the 867.1 - 867.9 MHz
+    channels unless --no-cflist is given, and derives the session keys
+  - checks the MIC and the frame counter of every uplink, acknowledges the
+    confirmed ones and answers LinkCheckReq and DeviceTimeReq
+  - runs an ADR policy over the last 20 uplinks and sends LinkAdrReq
+  - sends the --downlink payloads, with FPending set while more are queued
+  - unpacks the frames of the uplink log (src/uplink-log.h) sent on
+    --log-fport, printing each record with its port and age
+  - with --schema, decodes the application payloads and log records coded
+    by src/payload-codec.h, see payload_codec.py
+  - schedules every answer in RX1 or, with --rx2, in RX2, shifted by
+    --offset microseconds, and drops a --loss fraction of them, drawn from
+    --seed so that a session can be replayed
+
+The single channel forwarder only hears its own channel and data rate:
+build the node with the other channels masked, or give --no-cflist, and
+disable ADR unless the forwarder follows the requested data rate.
+
+On exit (Ctrl-C) the session figures are printed: join time, ACK latency
+and uplink airtime per delivered application byte.
+"""
+
+import argparse
+import base64
+import json
+import random
+import socket
+import struct
+import time
+
+import payload_codec
+
+PUSH_DATA = 0x00
+PUSH_ACK = 0x01
+PULL_DATA = 0x02
+PULL_RESP = 0x03
+PULL_ACK = 0x04
+TX_ACK = 0x05
+
+MTYPE_JOIN_REQUEST = 0
+MTYPE_JOIN_ACCEPT = 1
+MTYPE_UNCONFIRMED_UP = 2
+MTYPE_UNCONFIRMED_DOWN = 3
+MTYPE_CONFIRMED_UP = 4
+MTYPE_CONFIRMED_DOWN = 5
+
+JOIN_ACCEPT_DELAY1 = 5000000
+RECEIVE_DELAY1 = 1000000
+RX2_EXTRA_DELAY = 1000000
+
+RX2_FREQUENCY = 869.525
+RX2_DATARATE = 0
+DATARATES = ["SF12BW125", "SF11BW125", "SF10BW125", "SF9BW125", "SF8BW125", "SF7BW125"]
+CFLIST_FREQUENCIES = [867100000, 867300000, 867500000, 867700000, 867900000]
+MAX_TX_POWER_INDEX = 7
+
+# Demodulation floor per spreading factor [dB]
+REQUIRED_SNR = {7: -7.5, 8: -10.0, 9: -12.5, 10: -15.0, 11: -17.5, 12: -20.0}
+ADR_HISTORY = 20
+
+GPS_EPOCH_OFFSET = 315964800
+GPS_LEAP_SECONDS = 18
+
+# ---------------------------------------------------------------------------
+# AES-128 and CMAC, as used by LoRaWAN 1.0. Slow, but keeps the tool free of
+# dependencies.
+
+SBOX = [0] * 256
+INV_SBOX = [0] * 256
+
+
+def _init_sbox():
+    p = q = 1
+    while True:
+        p = p ^ ((p << 1) & 0xFF) ^ (0x1B if p & 0x80 else 0)
+        q ^= q << 1
+        q ^= q << 2
+        q ^= q << 4
+        q &= 0xFF
+        if q & 0x80:
+            q ^= 0x09
+        x = q ^ ((q << 1) | (q >> 7)) ^ ((q << 2) | (q >> 6)) ^ \
+            ((q << 3) | (q >> 5)) ^ ((q << 4) | (q >> 4))
+        x = (x ^ 0x63) & 0xFF
+        SBOX[p] = x
+        INV_SBOX[x] = p
+        if p == 1:
+            break
+    SBOX[0] = 0x63
+    INV_SBOX[0x63] = 0
+
+
+_init_sbox()
+
+
+def _xtime(a):
+    return ((a << 1) ^ 0x1B) & 0xFF if a & 0x80 else a << 1
+
+
+def _mul(a, b):
+    r = 0
+    while b:
+        if b & 1:
+            r ^= a
+        a = _xtime(a)
+        b >>= 1
+    return r
+
+
+def _expand_key(key):
+    w = [list(key[i:i + 4]) for i in range(0, 16, 4)]
+    rcon = 1
+    for i in range(4, 44):
+        t = list(w[i - 1])
+        if i % 4 == 0:
+            t = [SBOX[b] for b in t[1:] + t[:1]]
+            t[0] ^= rcon
+            rcon = _xtime(rcon)
+        w.append([a ^ b for a, b in zip(w[i - 4], t)])
+    return [sum(w[r * 4:r * 4 + 4], []) for r in range(11)]
+
+
+def _shift_rows(s, inverse=False):
+    out = [0] * 16
+    for c in range(4):
+        for r in range(4):
+            src = (c + r) % 4 if not inverse else (c - r) % 4
+            out[c * 4 + r] = s[src * 4 + r]
+    return out
+
+
+def _mix_columns(s, matrix):
+    out = []
+    for c in range(4):
+        col = s[c * 4:c * 4 + 4]
+        for r in range(4):
+            out.append(_mul(col[0], matrix[r][0]) ^ _mul(col[1], matrix[r][1]) ^
+                       _mul(col[2], matrix[r][2]) ^ _mul(col[3], matrix[r][3]))
+    return out
+
+
+MIX = [[2, 3, 1, 1], [1, 2, 3, 1], [1, 1, 2, 3], [3, 1, 1, 2]]
+INV_MIX = [[14, 11, 13, 9], [9, 14, 11, 13], [13, 9, 14, 11], [11, 13, 9, 14]]
+
+
+def aes_encrypt(key, block):
+    rk = _expand_key(key)
+    s = [a ^ b for a, b in zip(block, rk[0])]
+    for rnd in range(1, 11):
+        s = _shift_rows([SBOX[b] for b in s])
+        if rnd != 10:
+            s = _mix_columns(s, MIX)
+        s = [a ^ b for a, b in zip(s, rk[rnd])]
+    return bytes(s)
+
+
+def aes_decrypt(key, block):
+    rk = _expand_key(key)
+    s = [a ^ b for a, b in zip(block, rk[10])]
+    for rnd in range(9, -1, -1):
+        s = [INV_SBOX[b] for b in _shift_rows(s, inverse=True)]
+        s = [a ^ b for a, b in zip(s, rk[rnd])]
+        if rnd != 0:
+            s = _mix_columns(s, INV_MIX)
+    return bytes(s)
+
+
+def _shift_left(b):
+    n = int.from_bytes(b, "big") << 1
+    return (n & ((1 << 128) - 1)).to_bytes(16, "big"), n >> 128
+
+
+def aes_cmac(key, data):
+    k1, carry = _shift_left(aes_encrypt(key, bytes(16)))
+    if carry:
+        k1 = k1[:15] + bytes([k1[15] ^ 0x87])
+    k2, carry = _shift_left(k1)
+    if carry:
+        k2 = k2[:15] + bytes([k2[15] ^ 0x87])
+    if data and len(data) % 16 == 0:
+        last = bytes(a ^ b for a, b in zip(data[-16:], k1))
+        data = data[:-16]
+    else:
+        tail = data[len(data) - len(data) % 16:] + b"\x80"
+        tail += bytes(16 - len(tail))
+        last = bytes(a ^ b for a, b in zip(tail, k2))
+        data = data[:len(data) - len(data) % 16]
+    x = bytes(16)
+    for i in range(0, len(data), 16):
+        x = aes_encrypt(key, bytes(a ^ b for a, b in zip(x, data[i:i + 16])))
+    return aes_encrypt(key, bytes(a ^ b for a, b in zip(x, last)))
+
+
+# ---------------------------------------------------------------------------
+# LoRaWAN 1.0 frames
+
+def frame_mic(key, data, devaddr, fcnt, downlink):
+    b0 = struct.pack("<BIBII", 0x49, 0, 1 if downlink else 0, devaddr, fcnt)
+    b0 += bytes([0, len(data)])
+    return aes_cmac(key, b0 + data)[:4]
+
+
+def frame_crypt(key, data, devaddr, fcnt, downlink):
+    out = bytearray()
+    for i in range(0, len(data), 16):
+        a = struct.pack("<BIBII", 0x01, 0, 1 if downlink else 0, devaddr, fcnt)
+        s = aes_encrypt(key, a + bytes([0, i // 16 + 1]))
+        out += bytes(x ^ y for x, y in zip(data[i:i + 16], s))
+    return bytes(out)
+
+
+def airtime(datr, size, preamble=8):
+    """Time on air of a LoRa frame [s], CR 4/5, explicit header, CRC on."""
+    sf = int(datr[2:datr.index("BW")])
+    bw = int(datr[datr.index("BW") + 2:]) * 1000
+    tsym = (1 << sf) / bw
+    de = 1 if tsym > 0.016 else 0
+    n = 8 * size - 4 * sf + 28 + 16
+    n = max(-(-n // (4 * (sf - 2 * de))) * 5, 0)
+    return (preamble + 4.25 + 8 + n) * tsym
+
+
+class Session:
+    def __init__(self, args):
+        self.args = args
+        self.appkey = bytes.fromhex(args.appkey)
+        self.deveui = bytes.fromhex(args.deveui)[::-1]
+        self.appeui = bytes.fromhex(args.appeui)[::-1]
+        self.devaddr = int(args.devaddr, 16)
+        self.rng = random.Random(args.seed)
+        self.downlinks = [bytes.fromhex(d) for d in args.downlink]
+        self.codec = payload_codec.Decoder(args.schema) if args.schema else None
+        self.joined = False
+        self.first_join = None
+        self.join_attempts = 0
+        self.reset_session()
+        self.join_time = None
+        self.ack_latency = []
+        self.first_tmst = {}
+        self.uplinks = 0
+        self.uplink_airtime = 0.0
+        self.delivered = 0
+        self.lost = 0
+
+    def reset_session(self):
+        self.fcnt_up = None
+        self.fcnt_down = 0
+        self.snr_history = []
+        self.datarate = None
+        self.tx_power = 0
+        self.mac_answers = b""
+
+    def join_request(self, frame, rxpk):
+        if len(frame) != 23 or frame[1:9] != self.appeui or frame[9:17] != self.deveui:
+            return None
+        if aes_cmac(self.appkey, frame[:19])[:4] != frame[19:]:
+            print("join request MIC mismatch")
+            return None
+        self.join_attempts += 1
+        if self.first_join is None:
+            self.first_join = time.monotonic()
+        devnonce = frame[17:19]
+        appnonce = self.rng.getrandbits(24).to_bytes(3, "little")
+        netid = bytes(3)
+        dlsettings = 0
+        body = appnonce + netid + struct.pack("<I", self.devaddr) + bytes([dlsettings, 1])
+        if not self.args.no_cflist:
+            body += b"".join(struct.pack("<I", f // 100)[:3] for f in CFLIST_FREQUENCIES)
+            body += b"\x00"
+        mhdr = bytes([MTYPE_JOIN_ACCEPT << 5])
+        mic = aes_cmac(self.appkey, mhdr + body)[:4]
+        plain = body + mic
+        enc = b"".join(aes_decrypt(self.appkey, plain[i:i + 16]) for i in range(0, len(plain), 16))
+
+        nonce = appnonce + netid + devnonce
+        self.nwkskey = aes_encrypt(self.appkey, b"\x01" + nonce + bytes(7))
+        self.appskey = aes_encrypt(self.appkey, b"\x02" + nonce + bytes(7))
+        self.reset_session()
+        self.joined = True
+        print("join request devnonce %s, devaddr %08X" % (devnonce.hex(), self.devaddr))
+        return mhdr + enc, JOIN_ACCEPT_DELAY1
+
+    def data_uplink(self, frame, rxpk):
+        if not self.joined or len(frame) < 12:
+            return None
+        mhdr = frame[0]
+        devaddr, fctrl, fcnt16 = struct.unpack("<IBH", frame[1:8])
+        if devaddr != self.devaddr:
+            return None
+        fcnt = fcnt16
+        if self.fcnt_up is not None:
+            fcnt = (self.fcnt_up & 0xFFFF0000) | fcnt16
+            if fcnt < self.fcnt_up:
+                fcnt += 0x10000
+        if frame_mic(self.nwkskey, frame[:-4], devaddr, fcnt, False) != frame[-4:]:
+            print("uplink MIC mismatch, fcnt %d" % fcnt)
+            return None
+        confirmed = (mhdr >> 5) == MTYPE_CONFIRMED_UP
+        if self.fcnt_up is not None and fcnt == self.fcnt_up:
+            if not confirmed:
+                return None
+            print("retransmission fcnt %d" % fcnt)
+        else:
+            self.uplinks += 1
+        self.fcnt_up = fcnt
+        self.uplink_airtime += airtime(rxpk["datr"], len(frame))
+        if self.first_join is not None:
+            self.join_time = time.monotonic() - self.first_join
+            self.first_join = None
+            print("joined after %d attempts, %.1f s" % (self.join_attempts, self.join_time))
+
+        foptslen = fctrl & 0x0F
+        fopts = frame[8:8 + foptslen]
+        payload = frame[8 + foptslen:-4]
+        port = None
+        data = b""
+        if payload:
+            port = payload[0]
+            data = payload[1:]
+            key = self.nwkskey if port == 0 else self.appskey
+            data = frame_crypt(key, data, devaddr, fcnt, False)
+            if port == 0:
+                fopts = data
+            else:
+                self.delivered += len(data)
+        print("uplink fcnt %d%s port %s %s snr %s" %
+              (fcnt, " confirmed" if confirmed else "", port,
+               data.hex(), rxpk["lsnr"]))
+        if port == self.args.log_fport:
+            self.log_records(data)
+        elif port:
+            self.decode_sample(data)
+
+        answers = self.mac_commands(fopts, rxpk)
+        if fctrl & 0x80:
+            answers += self.adr(rxpk)
+        if confirmed:
+            self.first_tmst.setdefault(fcnt, rxpk["tmst"])
+
+        if not confirmed and not answers and not self.downlinks:
+            return None
+        return self.data_downlink(confirmed, answers), RECEIVE_DELAY1
+
+    def log_records(self, data):
+        # Port, size, age [s] on 24 bits LSB first, then the data
+        i = 0
+        while i + 5 <= len(data):
+            port, size = data[i], data[i + 1]
+            age = data[i + 2] | data[i + 3] << 8 | data[i + 4] << 16
+            record = data[i + 5:i + 5 + size]
+            print("  log record port %d age %s %s" %
+                  (port, "unknown" if age == 0xFFFFFF else "%d s" % age, record.hex()))
+            self.decode_sample(record)
+            i += 5 + size
+
+    def decode_sample(self, data):
+        if self.codec is None:
+            return
+        try:
+            sample_id, values = self.codec.decode(data)
+        except ValueError as error:
+            print("  sample not decoded: %s" % error)
+            return
+        print("  sample id %d %s" % (sample_id, " ".join("%s=%g" % item for item in values.items())))
+
+    def mac_commands(self, fopts, rxpk):
+        answers = b""
+        i = 0
+        while i < len(fopts):
+            cid = fopts[i]
+            i += 1
+            if cid == 0x02:
+                # LinkCheckReq: margin above the demodulation floor, one gateway
+                sf = int(rxpk["datr"][2:rxpk["datr"].index("BW")])
+                margin = max(int(rxpk["lsnr"] - REQUIRED_SNR[sf]), 0)
+                answers += bytes([0x02, margin, 1])
+            elif cid == 0x0D:
+                # DeviceTimeReq: GPS time at the end of the uplink
+                gps = time.time() - GPS_EPOCH_OFFSET + GPS_LEAP_SECONDS
+                answers += bytes([0x0D]) + struct.pack("<IB", int(gps) & 0xFFFFFFFF,
+                                                       int((gps % 1) * 256))
+            elif cid == 0x03:
+                print("LinkAdrAns status %02X" % fopts[i])
+                i += 1
+            elif cid in (0x05, 0x07, 0x0A, 0x10, 0x11, 0x13):
+                i += 1
+            elif cid == 0x06:
+                print("DevStatusAns battery %d margin %d" % (fopts[i], fopts[i + 1]))
+                i += 2
+            elif cid in (0x04, 0x08, 0x09, 0x12):
+                pass
+            else:
+                print("unknown MAC command %02X" % cid)
+                break
+        return answers
+
+    def adr(self, rxpk):
+        self.snr_history = (self.snr_history + [rxpk["lsnr"]])[-ADR_HISTORY:]
+        datarate = DATARATES.index(rxpk["datr"]) if rxpk["datr"] in DATARATES else 0
+        if len(self.snr_history) < ADR_HISTORY:
+            return b""
+        margin = max(self.snr_history) - REQUIRED_SNR[12 - datarate] - self.args.adr_margin
+        steps = int(margin // 3)
+        power = self.tx_power
+        while steps > 0 and datarate < len(DATARATES) - 1:
+            datarate += 1
+            steps -= 1
+        while steps > 0 and power < MAX_TX_POWER_INDEX:
+            power += 1
+            steps -= 1
+        while steps < 0 and power > 0:
+            power -= 1
+            steps += 1
+        if datarate == DATARATES.index(rxpk["datr"]) and power == self.tx_power:
+            return b""
+        self.tx_power = power
+        self.snr_history = []
+        chmask = 0x0007 if self.args.no_cflist else 0x00FF
+        print("LinkAdrReq DR%d power %d" % (datarate, power))
+        return bytes([0x03, (datarate << 4) | power]) + struct.pack("<HB", chmask, 0x01)
+
+    def data_downlink(self, ack, answers):
+        fopts = b""
+        port = None
+        payload = b""
+        if len(answers) > 15:
+            # Too long for FOpts: sent on port 0, the application payload waits
+            port = 0
+            payload = answers
+        else:
+            fopts = answers
+            if self.downlinks:
+                port = self.args.fport
+                payload = self.downlinks.pop(0)
+        fctrl = 0x80 | len(fopts)
+        if ack:
+            fctrl |= 0x20
+        if self.downlinks:
+            fctrl |= 0x10
+        frame = struct.pack("<BIBH", MTYPE_UNCONFIRMED_DOWN << 5, self.devaddr, fctrl,
+                            self.fcnt_down & 0xFFFF)
+        frame += fopts
+        if port is not None:
+            key = self.nwkskey if port == 0 else self.appskey
+            frame += bytes([port]) + frame_crypt(key, payload, self.devaddr, self.fcnt_down, True)
+        frame += frame_mic(self.nwkskey, frame, self.devaddr, self.fcnt_down, True)
+        self.fcnt_down += 1
+        return frame
+
+    def acked(self, fcnt_up, tmst_end):
+        """Records the delivery of an ACK ending at tmst_end [us]."""
+        if fcnt_up in self.first_tmst:
+            latency = (tmst_end - self.first_tmst.pop(fcnt_up)) & 0xFFFFFFFF
+            self.ack_latency.append(latency / 1e6)
+
+    def summary(self):
+        print("---")
+        if self.join_time is not None:
+            print("join time %.1f s, %d attempts" % (self.join_time, self.join_attempts))
+        if self.ack_latency:
+            print("ack latency mean %.3f s, max %.3f s over %d acks" %
+                  (sum(self.ack_latency) / len(self.ack_latency), max(self.ack_latency),
+                   len(self.ack_latency)))
+        print("uplinks %d, airtime %.3f s, downlinks dropped %d" %
+              (self.uplinks, self.uplink_airtime, self.lost))
+        if self.delivered:
+            print("airtime per delivered byte %.2f ms" %
+                  (1000.0 * self.uplink_airtime / self.delivered))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=1700)
+    parser.add_argument("--deveui", required=True, help="DevEUI, MSB first")
+    parser.add_argument("--appeui", required=True, help="AppEUI, MSB first")
+    parser.add_argument("--appkey", required=True, help="AppKey")
+    parser.add_argument("--devaddr", default="26011F00", help="address given at join")
+    parser.add_argument("--no-cflist", action="store_true", help="join accept without CFList")
+    parser.add_argument("--rx2", action="store_true", help="answer in RX2 instead of RX1")
+    parser.add_argument("--offset", type=int, default=0,
+                        help="shift the downlinks by this many microseconds")
+    parser.add_argument("--loss", type=float, default=0.0, help="fraction of downlinks dropped")
+    parser.add_argument("--seed", type=int, default=1, help="random seed, loss and nonces")
+    parser.add_argument("--adr-margin", type=float, default=10.0, help="ADR installation margin [dB]")
+    parser.add_argument("--downlink", action="append", default=[],
+                        help="application payload to send, hex, may be repeated")
+    parser.add_argument("--fport", type=int, default=2, help="downlink application port")
+    parser.add_argument("--log-fport", type=int, default=10, help="port of the uplink log frames")
+    parser.add_argument("--schema", help="payload codec schema, name:min:max:step,...")
+    args = parser.parse_args()
+
+    session = Session(args)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", args.port))
+    print("listening on UDP port %d" % args.port)
+
+    pull_addr = None
+    token = 0
+    tokens = {}
+
+    try:
+        while True:
+            data, addr = sock.recvfrom(2048)
+            if len(data) < 4 or data[0] != 2:
+                continue
+            ident = data[3]
+            if ident == PUSH_DATA:
+                sock.sendto(data[:3] + bytes([PUSH_ACK]), addr)
+                body = json.loads(data[12:].decode())
+                for rxpk in body.get("rxpk", []):
+                    if rxpk.get("stat", 1) != 1:
+                        continue
+                    frame = base64.b64decode(rxpk["data"])
+                    mtype = frame[0] >> 5
+                    if mtype == MTYPE_JOIN_REQUEST:
+                        answer = session.join_request(frame, rxpk)
+                    elif mtype in (MTYPE_UNCONFIRMED_UP, MTYPE_CONFIRMED_UP):
+                        answer = session.data_uplink(frame, rxpk)
+                    else:
+                        answer = None
+                    if answer is None or pull_addr is None:
+                        continue
+                    frame_down, delay = answer
+                    if session.rng.random() < args.loss:
+                        session.lost += 1
+                        print("downlink dropped")
+                        continue
+                    if args.rx2:
+                        delay += RX2_EXTRA_DELAY
+                    tmst = (rxpk["tmst"] + delay + args.offset) & 0xFFFFFFFF
+                    txpk = {
+                        "imme": False,
+                        "tmst": tmst,
+                        "freq": RX2_FREQUENCY if args.rx2 else rxpk["freq"],
+                        "rfch": 0,
+                        "powe": 14,
+                        "modu": "LORA",
+                        "datr": DATARATES[RX2_DATARATE] if args.rx2 else rxpk["datr"],
+                        "codr": "4/5",
+                        "ipol": True,
+                        "size": len(frame_down),
+                        "data": base64.b64encode(frame_down).decode(),
+                    }
+                    token = (token + 1) & 0xFFFF
+                    tokens[token] = (session.fcnt_up, tmst + int(1e6 * airtime(txpk["datr"], len(frame_down))))
+                    header = struct.pack(">BHB", 2, token, PULL_RESP)
+                    sock.sendto(header + json.dumps({"txpk": txpk}).encode(), pull_addr)
+            elif ident == PULL_DATA:
+                pull_addr = addr
+                sock.sendto(data[:3] + bytes([PULL_ACK]), addr)
+            elif ident == TX_ACK:
+                ack = struct.unpack(">H", data[1:3])[0]
+                body = json.loads(data[12:].decode() or "{}")
+                error = body.get("txpk_ack", {}).get("error", "NONE")
+                if error != "NONE":
+                    print("downlink rejected by the gateway: %s" % error)
+                elif ack in tokens:
+                    session.acked(*tokens[ack])
+                tokens.pop(ack, None)
+    except KeyboardInterrupt:
+        session.summary()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""Network server side decoder of the payload codec (src/payload-codec.h).
+
+Usage: payload_codec.py --schema SCHEMA FRAME [FRAME ...]
+       payload_codec.py --check BINARY
+
+The schema lists the fields in the order of the node schema, as
+name:min:max:step separated by commas, e.g. for LoRaWAN_HDC1080:
+
+  Temperature:-40:125:0.01,Humidity:0:100:0.1,Battery:0:12500:10
+
+The frames are hex strings, decoded in order: a frame coded against a
+reference needs the frame of that sample to be decoded first. Prints one
+line per frame, with the sample identifier and the field values.
+
+network_server.py decodes the application payloads with it when given
+--schema.
+
+--check BINARY runs tests/test-payload-codec --frames and decodes again
+every frame the node codec sent, checking the identifiers and values
+agree with the C decoder.
+"""
+
+import argparse
+import subprocess
+import sys
+
+ID_BITS = 4
+IDS = 1 << ID_BITS
+VARINT_BITS = 3
+
+
+class Bits:
+    def __init__(self, data):
+        self.data = data
+        self.position = 0
+
+    def read(self, count):
+        if self.position + count > len(self.data) * 8:
+            raise ValueError("frame too short")
+        value = 0
+        for _ in range(count):
+            byte = self.data[self.position >> 3]
+            value = (value << 1) | ((byte >> (7 - (self.position & 7))) & 1)
+            self.position += 1
+        return value
+
+    def read_varint(self):
+        value = 0
+        shift = 0
+        more = 1
+        while more:
+            if shift >= 32:
+                raise ValueError("varint too long")
+            value |= self.read(VARINT_BITS) << shift
+            more = self.read(1)
+            shift += VARINT_BITS
+        return value
+
+
+class Field:
+    def __init__(self, text):
+        name, low, high, step = text.split(":")
+        self.name = name
+        self.min = float(low)
+        self.max = float(high)
+        self.step = float(step)
+        self.bits = round((self.max - self.min) / self.step).bit_length()
+
+
+class Decoder:
+    def __init__(self, schema):
+        self.fields = [Field(text) for text in schema.split(",")]
+        self.samples = {}
+
+    def decode(self, frame):
+        """Returns the sample identifier and the field values by name."""
+        bits = Bits(frame)
+        sample_id = bits.read(ID_BITS)
+        distance = bits.read(ID_BITS)
+        reference = self.samples.get((sample_id - distance) % IDS) if distance else None
+        if distance and reference is None:
+            raise ValueError("reference %d unknown" % ((sample_id - distance) % IDS))
+        sample = []
+        for i, field in enumerate(self.fields):
+            if distance and bits.read(1) == 0:
+                zigzag = bits.read_varint()
+                sample.append(reference[i] + ((zigzag >> 1) ^ -(zigzag & 1)))
+            else:
+                sample.append(bits.read(field.bits))
+        self.samples[sample_id] = sample
+        return sample_id, {field.name: field.min + q * field.step
+                           for field, q in zip(self.fields, sample)}
+
+
+def check(binary):
+    """Decodes the frames of a test-payload-codec --frames run, returns the mismatches."""
+    output = subprocess.run([binary, "--frames"], stdout=subprocess.PIPE, universal_newlines=True).stdout
+    decoder = None
+    frames = 0
+    errors = []
+    for line in output.splitlines():
+        fields = line.split()
+        if fields and fields[0] == "schema":
+            decoder = Decoder(fields[1])
+        elif fields and fields[0] == "frame" and decoder:
+            frames += 1
+            try:
+                sample_id, values = decoder.decode(bytes.fromhex(fields[1]))
+            except ValueError as error:
+                errors.append("%s: %s" % (fields[1], error))
+                continue
+            expected = [float(value) for value in fields[3:]]
+            if sample_id != int(fields[2]) or len(expected) != len(decoder.fields) or any(
+                    abs(values[field.name] - value) > field.step / 100
+                    for field, value in zip(decoder.fields, expected)):
+                errors.append("%s: id %d %s, node decoded %s" % (
+                    fields[1], sample_id, " ".join("%g" % value for value in values.values()),
+                    " ".join(fields[2:])))
+        else:
+            # The checks of the test itself
+            print(line)
+    if frames == 0:
+        errors.append("no frames from %s" % binary)
+    for error in errors:
+        print(error)
+    print("%s: %d frames, %d mismatches" % (binary, frames, len(errors)))
+    return errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--schema", help="name:min:max:step,...")
+    parser.add_argument("--check", metavar="BINARY", help="check the frames of tests/test-payload-codec")
+    parser.add_argument("frames", nargs="*", help="frames, hex")
+    args = parser.parse_args()
+
+    if args.check:
+        sys.exit(1 if check(args.check) else 0)
+    if not args.schema or not args.frames:
+        parser.error("--schema and frames are required")
+
+    decoder = Decoder(args.schema)
+    for frame in args.frames:
+        try:
+            sample_id, values = decoder.decode(bytes.fromhex(frame))
+        except ValueError as error:
+            print("%s: %s" % (frame, error))
+            continue
+        print("%s: id %d %s" % (frame, sample_id,
+                                " ".join("%s=%g" % item for item in values.items())))
+
+
+if __name__ == "__main__":
+    main()
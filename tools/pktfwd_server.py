@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Stand-in network server for the Packet_Forwarder example.
+
+Usage: pktfwd_server.py [--port 1700] [--echo-delay US] [--ipol]
+
+Speaks the gateway side of the Semtech UDP protocol v2: acknowledges
+PUSH_DATA and PULL_DATA and prints every rxpk, stat and TX_ACK. With
+--echo-delay each received packet is sent back as a downlink, scheduled
+US microseconds after its tmst (1000000 for a LoRaWAN RX1 window), on the
+same frequency and data rate.
+"""
+
+import argparse
+import json
+import socket
+import struct
+
+PUSH_DATA = 0x00
+PUSH_ACK = 0x01
+PULL_DATA = 0x02
+PULL_RESP = 0x03
+PULL_ACK = 0x04
+TX_ACK = 0x05
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=1700)
+    parser.add_argument("--echo-delay", type=int, default=0,
+                        help="echo uplinks as downlinks, tmst + delay [us]")
+    parser.add_argument("--ipol", action="store_true",
+                        help="invert the downlink IQ, as LoRaWAN downlinks")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", args.port))
+    print("listening on UDP port %d" % args.port)
+
+    pull_addr = None
+    token = 0
+
+    while True:
+        data, addr = sock.recvfrom(2048)
+        if len(data) < 4 or data[0] != 2:
+            continue
+        ident = data[3]
+        eui = data[4:12].hex().upper()
+
+        if ident == PUSH_DATA:
+            sock.sendto(data[:3] + bytes([PUSH_ACK]), addr)
+            body = json.loads(data[12:].decode())
+            if "stat" in body:
+                print("%s stat %s" % (eui, json.dumps(body["stat"])))
+            for rxpk in body.get("rxpk", []):
+                print("%s rxpk tmst %d %s %s rssi %d snr %s size %d" %
+                      (eui, rxpk["tmst"], rxpk["freq"], rxpk["datr"], rxpk["rssi"],
+                       rxpk["lsnr"], rxpk["size"]))
+                if args.echo_delay and pull_addr is not None:
+                    txpk = {
+                        "imme": False,
+                        "tmst": (rxpk["tmst"] + args.echo_delay) & 0xFFFFFFFF,
+                        "freq": rxpk["freq"],
+                        "rfch": 0,
+                        "powe": 14,
+                        "modu": "LORA",
+                        "datr": rxpk["datr"],
+                        "codr": rxpk["codr"],
+                        "ipol": args.ipol,
+                        "size": rxpk["size"],
+                        "data": rxpk["data"],
+                    }
+                    token = (token + 1) & 0xFFFF
+                    header = struct.pack(">BHB", 2, token, PULL_RESP)
+                    sock.sendto(header + json.dumps({"txpk": txpk}).encode(), pull_addr)
+                    print("%s txpk tmst %d" % (eui, txpk["tmst"]))
+        elif ident == PULL_DATA:
+            pull_addr = addr
+            sock.sendto(data[:3] + bytes([PULL_ACK]), addr)
+        elif ident == TX_ACK:
+            body = data[12:].decode() or "{}"
+            print("%s tx_ack token %d %s" % (eui, struct.unpack(">H", data[1:3])[0], body))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Decode the output of TraceDump() into a readable timeline.
+
+Usage: trace_decode.py [serial-log]
+
+Reads the serial log (or stdin), finds every block between "TRACE BEGIN" and
+"TRACE END" and prints one line per record with the time relative to the
+first record in milliseconds.
+"""
+
+import sys
+
+EVENTS = {
+    1: "TIMER_START",
+    2: "TIMER_FIRE",
+    3: "OPMODE",
+    4: "IRQ",
+    5: "MAC",
+    6: "MAC_CMD",
+    7: "CRYPTO_START",
+    8: "CRYPTO_END",
+    9: "SLEEP",
+    10: "WAKEUP",
+}
+
+TIMERS = ["MacStateCheck", "TxDelayed", "RxWindow1", "RxWindow2", "AckTimeout",
+          "RadioTxTimeout", "RadioRxTimeout"]
+
+MAC_EVENTS = ["Send", "TxDone", "RxDone", "TxTimeout", "RxError", "RxTimeout", "Idle"]
+
+CRYPTO = ["Mic", "Payload", "JoinMic", "JoinDecrypt", "SessionKeys"]
+
+OPMODES = {0: "Sleep", 1: "Standby", 2: "SynthTx", 3: "Tx", 4: "SynthRx", 5: "RxContinuous",
+           6: "RxSingle", 7: "Cad"}
+
+MAC_COMMANDS = {2: "LinkCheckAns", 3: "LinkAdrReq", 4: "DutyCycleReq", 5: "RxParamSetupReq",
+                6: "DevStatusReq", 7: "NewChannelReq", 8: "RxTimingSetupReq", 9: "TxParamSetupReq",
+                10: "DlChannelReq", 13: "DeviceTimeAns"}
+
+RADIO_STATES = ["Idle", "RxRunning", "TxRunning", "Cad"]
+
+
+def name(table, index):
+    if isinstance(table, dict):
+        return table.get(index, "0x%02x" % index)
+    return table[index] if index < len(table) else "0x%02x" % index
+
+
+def describe(event, arg0, arg1):
+    if event == 1:
+        return "%s %u ms" % (name(TIMERS, arg0), arg1)
+    if event == 2:
+        return name(TIMERS, arg0)
+    if event == 3:
+        return name(OPMODES, arg0)
+    if event == 4:
+        return "DIO%u state %s" % (arg0, name(RADIO_STATES, arg1))
+    if event == 5:
+        return "%s state 0x%02x" % (name(MAC_EVENTS, arg0), arg1)
+    if event == 6:
+        return "%s at %u" % (name(MAC_COMMANDS, arg0), arg1)
+    if event in (7, 8):
+        return "%s %s" % (name(CRYPTO, arg0), "%u bytes" % arg1 if event == 7 else "")
+    if event in (9, 10):
+        return "system time %u ms" % arg1
+    return "arg0 0x%02x arg1 0x%08x" % (arg0, arg1)
+
+
+def decode(block, mhz):
+    """Yields ( time in ms, event, arg0, arg1 ). The cycle counter wraps and
+    stops while sleeping, the SLEEP/WAKEUP records carry the system time
+    used to realign it."""
+    time_us = 0.0
+    last_cycles = None
+    sleep_ms = None
+    for cycles, event, arg0, arg1 in block:
+        if event == 10 and sleep_ms is not None:
+            # The cycle count across sleep is meaningless, use the system time
+            time_us += (arg1 - sleep_ms) * 1000.0
+            sleep_ms = None
+        elif last_cycles is not None:
+            time_us += ((cycles - last_cycles) & 0xFFFFFFFF) / mhz
+        last_cycles = cycles
+        if event == 9:
+            sleep_ms = arg1
+        yield time_us / 1000.0, event, arg0, arg1
+
+
+def main():
+    stream = open(sys.argv[1], errors="replace") if len(sys.argv) > 1 else sys.stdin
+    block = None
+    mhz = 1
+    for line in stream:
+        fields = line.split()
+        if len(fields) >= 4 and fields[0] == "TRACE" and fields[1] == "BEGIN":
+            block = []
+            mhz = max(int(fields[2]), 1)
+        elif len(fields) == 5 and fields[0] == "T" and block is not None:
+            block.append((int(fields[1], 16), int(fields[2], 16), int(fields[3], 16), int(fields[4], 16)))
+        elif len(fields) >= 2 and fields[0] == "TRACE" and fields[1] == "END" and block is not None:
+            print("--- %u records ---" % len(block))
+            for time_ms, event, arg0, arg1 in decode(block, mhz):
+                print("%12.3f  %-12s  %s" % (time_ms, name(EVENTS, event), describe(event, arg0, arg1)))
+            block = None
+
+
+if __name__ == "__main__":
+    main()